@@ -284,11 +284,11 @@ ImguiProfiler::Render(Timing::Time frameTime, IndexT frameIndex)
             {
                 ImGui::PushFont(Dynui::ImguiContext::state.smallFont);
 
-                Util::Dictionary<const char*, uint64> counters = Profiling::ProfilingGetCounters();
-                for (IndexT i = 0; i < counters.Size(); i++)
+                Util::FlatHashMap<const char*, uint64> counters = Profiling::ProfilingGetCounters();
+                for (const Util::KeyValuePair<const char*, uint64>& counter : counters)
                 {
-                    const char* name = counters.KeyAtIndex(i);
-                    uint64 val = counters.ValueAtIndex(i);
+                    const char* name = counter.Key();
+                    uint64 val = counter.Value();
                     if (val >= 1_GB)
                         ImGui::LabelText(name, "%.2f GB allocated", val / float(1_GB));
                     else if (val >= 1_MB)
@@ -299,11 +299,11 @@ ImguiProfiler::Render(Timing::Time frameTime, IndexT frameIndex)
                         ImGui::LabelText(name, "%lu B allocated", val);
                 }
 
-                const Util::Dictionary<const char*, Util::Pair<uint64, uint64>>& budgetCounters = Profiling::ProfilingGetBudgetCounters();
-                for (IndexT i = 0; i < budgetCounters.Size(); i++)
+                const Util::FlatHashMap<const char*, Util::Pair<uint64, uint64>>& budgetCounters = Profiling::ProfilingGetBudgetCounters();
+                for (const Util::KeyValuePair<const char*, Util::Pair<uint64, uint64>>& budgetCounter : budgetCounters)
                 {
-                    const char* name = budgetCounters.KeyAtIndex(i);
-                    const Util::Pair<uint64, uint64>& val = budgetCounters.ValueAtIndex(i);
+                    const char* name = budgetCounter.Key();
+                    const Util::Pair<uint64, uint64>& val = budgetCounter.Value();
                     if (val.first >= 1_GB)
                         ImGui::LabelText(name, "%.2f GB allocated, %.2f GB left", val.first / float(1_GB), (val.first - val.second) / float(1_GB));
                     else if (val.first >= 1_MB)
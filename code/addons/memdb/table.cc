@@ -126,7 +126,7 @@ Table::GetAttributeIndex(AttributeId attribute) const
     n_assert(attribute != AttributeId::Invalid());
     IndexT index = this->columnRegistry.FindIndex(attribute);
     if (index != InvalidIndex)
-        return this->columnRegistry.ValueAtIndex(attribute, index);
+        return this->columnRegistry.ValueAtIndex(index);
     return ColumnIndex::Invalid();
 }
 
@@ -512,7 +512,7 @@ Table::DeserializeInstance(Util::Blob const& data, RowId row)
         IndexT const bucket = this->columnRegistry.FindIndex(attribute);
         if (bucket != InvalidIndex)
         {
-            byte* valuePtr = (byte*)part->columns[this->columnRegistry.ValueAtIndex(attribute, bucket)] +
+            byte* valuePtr = (byte*)part->columns[this->columnRegistry.ValueAtIndex(bucket)] +
                              (row.index * (size_t)typeSize);
             Memory::Copy(ptr, valuePtr, typeSize);
         }
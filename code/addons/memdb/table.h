@@ -14,7 +14,7 @@
 #include "util/fixedarray.h"
 #include "util/string.h"
 #include "util/stringatom.h"
-#include "util/hashtable.h"
+#include "util/flathashmap.h"
 #include "attributeid.h"
 #include "tablesignature.h"
 #include "util/bitfield.h"
@@ -155,7 +155,7 @@ private:
     /// all attributes that this table has
     Util::Array<AttributeId> attributes;
     /// maps attr id -> index in columns array
-    Util::HashTable<AttributeId, IndexT, 32, 1> columnRegistry;
+    Util::FlatHashMap<AttributeId, IndexT> columnRegistry;
 
     uint64_t partitionCleanerCounter = 0;
 };
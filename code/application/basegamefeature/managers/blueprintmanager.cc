@@ -6,6 +6,10 @@
 #include "blueprintmanager.h"
 #include "io/jsonreader.h"
 #include "io/ioserver.h"
+#include "io/memorystream.h"
+#include "io/binaryreader.h"
+#include "io/binarywriter.h"
+#include "core/coreserver.h"
 #include "game/componentserialization.h"
 #include "util/arraystack.h"
 #include "game/gameserver.h"
@@ -13,6 +17,7 @@
 #include "basegamefeature/components/position.h"
 #include "basegamefeature/components/orientation.h"
 #include "basegamefeature/components/scale.h"
+#include "flat/game/blueprintcache.h"
 
 namespace Game
 {
@@ -21,6 +26,11 @@ __ImplementSingleton(BlueprintManager)
 
 Util::String BlueprintManager::blueprintFolder("data:tables/");
 Util::String BlueprintManager::templatesFolder("data:tables/templates");
+Util::String BlueprintManager::cacheFilename;
+bool BlueprintManager::cacheFilenameSet = false;
+
+/// bump when the cache layout or the binary component serialization changes
+static const uint BlueprintCacheVersion = 2;
 
 //------------------------------------------------------------------------------
 /**
@@ -49,17 +59,36 @@ BlueprintManager::Destroy()
 //------------------------------------------------------------------------------
 /**
 */
-BlueprintManager::BlueprintManager()
+BlueprintManager::BlueprintManager() :
+    numFileBlueprints(0),
+    cache(nullptr)
 {
-    Util::Array<Util::String> files = IO::IoServer::Instance()->ListFiles(this->blueprintFolder, "*.json", true);
-    for (int i = 0; i < files.Size(); i++)
+    // the data folder is read-only in shipped builds, so the cache goes into the temp folder of the application
+    if (!this->cacheFilenameSet)
+        this->cacheFilename = Util::String::Sprintf("temp:%s/blueprints.bpca", Core::CoreServer::Instance()->GetAppName().Value());
+
+    IO::IoServer* ioServer = IO::IoServer::Instance();
+    this->blueprintFiles = ioServer->ListFiles(this->blueprintFolder, "*.json", true);
+    if (ioServer->DirectoryExists(this->templatesFolder))
+    {
+        this->ListTemplateFiles(this->templatesFolder, this->templateFiles);
+    }
+
+    if (this->OpenCache())
     {
-        if (!this->ParseBlueprint(files[i]))
+        this->LoadCachedBlueprints();
+    }
+    else
+    {
+        for (int i = 0; i < this->blueprintFiles.Size(); i++)
         {
-            n_warning("Warning: Managers::BlueprintManager: Error parsing %s!\n", files[i].AsCharPtr());
+            if (!this->ParseBlueprint(this->blueprintFiles[i]))
+            {
+                n_warning("Warning: Managers::BlueprintManager: Error parsing %s!\n", this->blueprintFiles[i].AsCharPtr());
+            }
         }
     }
-
+    this->numFileBlueprints = this->blueprints.Size();
 }
 
 //------------------------------------------------------------------------------
@@ -67,7 +96,7 @@ BlueprintManager::BlueprintManager()
 */
 BlueprintManager::~BlueprintManager()
 {
-    // empty
+    this->CloseCache();
 }
 
 //------------------------------------------------------------------------------
@@ -85,10 +114,23 @@ BlueprintManager::OnActivate()
     // Setup all blueprint tables
     Singleton->SetupBlueprints();
     
-    // parse all templates from folders.
-    if (IO::IoServer::Instance()->DirectoryExists(Singleton->templatesFolder))
+    // instantiate the templates from the cache if it's up to date, otherwise parse all template files
+    bool cached = false;
+    if (Singleton->cache != nullptr)
+    {
+        cached = Singleton->LoadCachedTemplates();
+        Singleton->CloseCache();
+    }
+    if (!cached)
     {
-        Singleton->LoadTemplateFolder(Singleton->templatesFolder);
+        for (int i = 0; i < Singleton->templateFiles.Size(); i++)
+        {
+            if (!Singleton->ParseTemplate(Singleton->templateFiles[i]))
+            {
+                n_warning("Managers::BlueprintManager: Error parsing %s!\n", Singleton->templateFiles[i].AsCharPtr());
+            }
+        }
+        Singleton->WriteCache();
     }
 }
 
@@ -150,26 +192,15 @@ BlueprintManager::ParseBlueprint(Util::String const& blueprintsPath)
 //------------------------------------------------------------------------------
 /**
 */
-bool
-BlueprintManager::LoadTemplateFolder(Util::String const& path)
+void
+BlueprintManager::ListTemplateFiles(Util::String const& path, Util::Array<Util::String>& files)
 {
-    Util::Array<Util::String> files = IO::IoServer::Instance()->ListFiles(path, "*.json", true);
-
-    // Parse files
-    for (int i = 0; i < files.Size(); i++)
-    {
-        if (!this->ParseTemplate(files[i]))
-        {
-            n_warning("Managers::BlueprintManager: Error parsing %s!\n", files[i].AsCharPtr());
-        }
-    }
+    files.AppendArray(IO::IoServer::Instance()->ListFiles(path, "*.json", true));
 
     // Recurse all folders
     Util::Array<Util::String> dirs = IO::IoServer::Instance()->ListDirectories(path, "*", true);
     for (auto const& dir : dirs)
-        this->LoadTemplateFolder(dir);
-
-    return true;
+        this->ListTemplateFiles(dir, files);
 }
 
 //------------------------------------------------------------------------------
@@ -193,13 +224,6 @@ BlueprintManager::ParseTemplate(Util::String const& templatePath)
             Util::StringAtom blueprintName = jsonReader->GetString("blueprint");
             if (this->blueprintMap.Contains(blueprintName))
             {
-                // Instantiate template
-                Ptr<MemDb::Database> templateDatabase = GameServer::Instance()->state.templateDatabase;
-                BlueprintId blueprint = this->blueprintMap[blueprintName];
-                MemDb::TableId templateTid = this->blueprints[blueprint.id].tableId;
-                MemDb::RowId instance = templateDatabase->GetTable(templateTid).AddRow();
-                n_assert2(instance.index < 0xFFFF, "Maximum number of templates per blueprint reached! You win!");
-
                 // Create template name
                 Util::String fileName = templatePath.ExtractFileName();
                 fileName.StripFileExtension();
@@ -207,22 +231,11 @@ BlueprintManager::ParseTemplate(Util::String const& templatePath)
                 templateName.Append(blueprintName.Value());
                 templateName += "/" + fileName;
 
-                Util::StringAtom const nameAtom = Util::StringAtom(templateName);
-
-                TemplateId templateId;
-                if (this->templateIdPool.Allocate(templateId.id))
-                {
-                    this->templates.Append({});
-                }
-
-                Template& tmpl = this->templates[Ids::Index(templateId.id)];
-                tmpl = Template();
-                tmpl.bid = blueprint;
-                tmpl.name = nameAtom;
-                tmpl.row = instance;
-                
-                // Add to map
-                this->templateMap.Add(nameAtom, templateId);
+                // Instantiate template
+                Ptr<MemDb::Database> templateDatabase = GameServer::Instance()->state.templateDatabase;
+                BlueprintId blueprint = this->blueprintMap[blueprintName];
+                MemDb::TableId templateTid = this->blueprints[blueprint.id].tableId;
+                MemDb::RowId instance = this->AddTemplate(blueprint, Util::StringAtom(templateName));
 
                 // Override components if necessary
                 if (jsonReader->SetToFirstChild("components"))
@@ -273,6 +286,289 @@ BlueprintManager::ParseTemplate(Util::String const& templatePath)
     return false;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+MemDb::RowId
+BlueprintManager::AddTemplate(BlueprintId blueprint, Util::StringAtom name)
+{
+    Ptr<MemDb::Database> templateDatabase = GameServer::Instance()->state.templateDatabase;
+    MemDb::TableId templateTid = this->blueprints[blueprint.id].tableId;
+    MemDb::RowId instance = templateDatabase->GetTable(templateTid).AddRow();
+    n_assert2(instance.index < 0xFFFF, "Maximum number of templates per blueprint reached! You win!");
+
+    TemplateId templateId;
+    if (this->templateIdPool.Allocate(templateId.id))
+    {
+        this->templates.Append({});
+    }
+
+    Template& tmpl = this->templates[Ids::Index(templateId.id)];
+    tmpl = Template();
+    tmpl.bid = blueprint;
+    tmpl.name = name;
+    tmpl.row = instance;
+
+    // Add to map
+    this->templateMap.Add(name, templateId);
+    this->fileTemplates.Append(templateId);
+    return instance;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The cache is out of date if any of the json files is newer, or if files
+    were added or removed since it was written.
+*/
+bool
+BlueprintManager::OpenCache()
+{
+    if (!this->cacheFilename.IsValid())
+        return false;
+
+    IO::IoServer* ioServer = IO::IoServer::Instance();
+    if (!ioServer->FileExists(this->cacheFilename))
+        return false;
+
+    IO::FileTime const cacheTime = ioServer->GetFileWriteTime(this->cacheFilename);
+    IndexT i;
+    for (i = 0; i < this->blueprintFiles.Size(); i++)
+    {
+        if (ioServer->GetFileWriteTime(this->blueprintFiles[i]) > cacheTime)
+            return false;
+    }
+    for (i = 0; i < this->templateFiles.Size(); i++)
+    {
+        if (ioServer->GetFileWriteTime(this->templateFiles[i]) > cacheTime)
+            return false;
+    }
+
+    this->cacheStream = ioServer->CreateStream(this->cacheFilename);
+    this->cacheStream->SetAccessMode(IO::Stream::ReadAccess);
+    if (!this->cacheStream->Open())
+    {
+        this->cacheStream = nullptr;
+        return false;
+    }
+
+    const uint8_t* data = (const uint8_t*)this->cacheStream->MemoryMap();
+    flatbuffers::Verifier verifier(data, (size_t)this->cacheStream->GetSize());
+    if (VerifyBlueprintCacheBuffer(verifier))
+    {
+        const BlueprintCache* blueprintCache = GetBlueprintCache(data);
+        if (blueprintCache->version() == BlueprintCacheVersion
+            && blueprintCache->num_sources() == (uint)(this->blueprintFiles.Size() + this->templateFiles.Size()))
+        {
+            this->cache = blueprintCache;
+            return true;
+        }
+    }
+    else
+    {
+        n_warning("Warning: Managers::BlueprintManager: '%s' is not a valid blueprint cache!\n", this->cacheFilename.AsCharPtr());
+    }
+
+    this->CloseCache();
+    return false;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BlueprintManager::CloseCache()
+{
+    if (this->cacheStream.isvalid())
+    {
+        this->cacheStream->Close();
+        this->cacheStream = nullptr;
+    }
+    this->cache = nullptr;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BlueprintManager::LoadCachedBlueprints()
+{
+    n_assert(this->cache != nullptr);
+    auto const* cachedBlueprints = this->cache->blueprints();
+    if (cachedBlueprints == nullptr)
+        return;
+
+    for (auto const* cachedBlueprint : *cachedBlueprints)
+    {
+        Blueprint bluePrint;
+        bluePrint.name = cachedBlueprint->name()->c_str();
+        if (cachedBlueprint->components() != nullptr)
+        {
+            for (auto const* component : *cachedBlueprint->components())
+            {
+                bluePrint.components.Append({ component->c_str() });
+            }
+        }
+        this->blueprints.Append(bluePrint);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Everything is validated before the first template is added, such that
+    the json files can be parsed instead if the cache doesn't match the
+    registered components anymore.
+*/
+bool
+BlueprintManager::LoadCachedTemplates()
+{
+    n_assert(this->cache != nullptr);
+    auto const* componentTypes = this->cache->component_types();
+    auto const* cachedTemplates = this->cache->templates();
+    auto const* values = this->cache->values();
+    if (componentTypes == nullptr || cachedTemplates == nullptr || values == nullptr || values->size() == 0)
+        return true;
+
+    Util::FixedArray<ComponentId> componentIds(componentTypes->size());
+    IndexT i;
+    for (i = 0; i < componentIds.Size(); i++)
+    {
+        auto const* componentType = componentTypes->Get(i);
+        componentIds[i] = MemDb::AttributeRegistry::GetAttributeId(componentType->name()->c_str());
+        if (componentIds[i] == ComponentId::Invalid()
+            || MemDb::AttributeRegistry::TypeSize(componentIds[i]) != componentType->type_size()
+            || ComponentSerialization::FieldLayoutHash(componentIds[i]) != componentType->field_layout_hash())
+            return false;
+    }
+    for (auto const* cachedTemplate : *cachedTemplates)
+    {
+        if (!this->blueprintMap.Contains(cachedTemplate->blueprint()->c_str()))
+            return false;
+    }
+
+    // component values are read through a single reader, in the order they were written
+    Ptr<IO::MemoryStream> valueStream = IO::MemoryStream::Create();
+    valueStream->SetAccessMode(IO::Stream::WriteAccess);
+    valueStream->Open();
+    valueStream->Write(values->data(), values->size());
+    valueStream->Close();
+    Ptr<IO::BinaryReader> reader = IO::BinaryReader::Create();
+    reader->SetStream(valueStream);
+    reader->SetMemoryMappingEnabled(true);
+    reader->Open();
+
+    Ptr<MemDb::Database> templateDatabase = GameServer::Instance()->state.templateDatabase;
+    for (auto const* cachedTemplate : *cachedTemplates)
+    {
+        BlueprintId blueprint = this->blueprintMap[cachedTemplate->blueprint()->c_str()];
+        MemDb::RowId instance = this->AddTemplate(blueprint, cachedTemplate->name()->c_str());
+        MemDb::Table& table = templateDatabase->GetTable(this->blueprints[blueprint.id].tableId);
+        if (cachedTemplate->components() == nullptr)
+            continue;
+
+        for (ushort componentIndex : *cachedTemplate->components())
+        {
+            ComponentId id = componentIds[componentIndex];
+            MemDb::ColumnIndex column = table.GetAttributeIndex(id);
+            n_assert(column != MemDb::ColumnIndex::Invalid());
+            ComponentSerialization::Deserialize(reader, id, table.GetValuePointer(column, instance));
+        }
+    }
+    reader->Close();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BlueprintManager::WriteCache()
+{
+    if (!this->cacheFilename.IsValid())
+        return;
+
+    flatbuffers::FlatBufferBuilder builder(65536);
+    Ptr<MemDb::Database> templateDatabase = GameServer::Instance()->state.templateDatabase;
+
+    Util::Array<flatbuffers::Offset<CachedBlueprint>> cachedBlueprints;
+    IndexT i;
+    for (i = 0; i < this->numFileBlueprints; i++)
+    {
+        Blueprint const& blueprint = this->blueprints[i];
+        Util::Array<flatbuffers::Offset<flatbuffers::String>> components;
+        for (ComponentEntry const& component : blueprint.components)
+        {
+            components.Append(builder.CreateString(component.name.Value()));
+        }
+        auto name = builder.CreateString(blueprint.name.Value());
+        cachedBlueprints.Append(CreateCachedBlueprint(builder, name, builder.CreateVector(components.Begin(), components.Size())));
+    }
+
+    // serialize all values of the template rows, such that loading them doesn't depend on the component defaults
+    Util::Array<ComponentId> componentIds;
+    Util::Array<flatbuffers::Offset<CachedTemplate>> cachedTemplates;
+    Ptr<IO::MemoryStream> valueStream = IO::MemoryStream::Create();
+    valueStream->SetAccessMode(IO::Stream::WriteAccess);
+    Ptr<IO::BinaryWriter> writer = IO::BinaryWriter::Create();
+    writer->SetStream(valueStream);
+    writer->Open();
+    for (TemplateId templateId : this->fileTemplates)
+    {
+        Template const& tmpl = this->templates[Ids::Index(templateId.id)];
+        MemDb::Table& table = templateDatabase->GetTable(this->blueprints[tmpl.bid.id].tableId);
+        Util::Array<ushort> componentIndices;
+        for (ComponentId id : table.GetAttributes())
+        {
+            IndexT componentIndex = componentIds.FindIndex(id);
+            if (componentIndex == InvalidIndex)
+            {
+                componentIndex = componentIds.Size();
+                componentIds.Append(id);
+            }
+            componentIndices.Append((ushort)componentIndex);
+            ComponentSerialization::Serialize(writer, id, table.GetValuePointer(table.GetAttributeIndex(id), tmpl.row));
+        }
+        auto name = builder.CreateString(tmpl.name.Value());
+        auto blueprint = builder.CreateString(this->blueprints[tmpl.bid.id].name.Value());
+        cachedTemplates.Append(CreateCachedTemplate(builder, name, blueprint, builder.CreateVector(componentIndices.Begin(), componentIndices.Size())));
+    }
+    writer->Close();
+
+    Util::Array<flatbuffers::Offset<CachedComponentType>> componentTypes;
+    for (ComponentId id : componentIds)
+    {
+        auto name = builder.CreateString(MemDb::AttributeRegistry::GetAttribute(id)->name.Value());
+        componentTypes.Append(CreateCachedComponentType(builder, name, (uint)MemDb::AttributeRegistry::TypeSize(id), ComponentSerialization::FieldLayoutHash(id)));
+    }
+
+    auto values = builder.CreateVector((const uint8_t*)valueStream->GetRawPointer(), (size_t)valueStream->GetSize());
+
+    auto root = CreateBlueprintCache(
+        builder,
+        BlueprintCacheVersion,
+        (uint)(this->blueprintFiles.Size() + this->templateFiles.Size()),
+        builder.CreateVector(componentTypes.Begin(), componentTypes.Size()),
+        builder.CreateVector(cachedBlueprints.Begin(), cachedBlueprints.Size()),
+        builder.CreateVector(cachedTemplates.Begin(), cachedTemplates.Size()),
+        values
+    );
+    FinishBlueprintCacheBuffer(builder, root);
+
+    Util::String const cacheFolder = this->cacheFilename.ExtractToLastSlash();
+    if (cacheFolder.IsValid())
+        IO::IoServer::Instance()->CreateDirectory(cacheFolder);
+    Ptr<IO::Stream> stream = IO::IoServer::Instance()->CreateStream(this->cacheFilename);
+    stream->SetAccessMode(IO::Stream::WriteAccess);
+    if (stream->Open())
+    {
+        stream->Write(builder.GetBufferPointer(), builder.GetSize());
+        stream->Close();
+    }
+    else
+    {
+        n_warning("Warning: Managers::BlueprintManager: could not write blueprint cache '%s'!\n", this->cacheFilename.AsCharPtr());
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -283,6 +579,16 @@ BlueprintManager::SetBlueprintsFilename(const Util::String& name, const Util::St
     blueprintFolder = folder;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BlueprintManager::SetBlueprintCacheFilename(const Util::String& name)
+{
+    cacheFilename = name;
+    cacheFilenameSet = true;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
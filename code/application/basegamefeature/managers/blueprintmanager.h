@@ -8,6 +8,13 @@
 
     You can instantiate entities from blueprints via the entity interface.
 
+    Parsing the json files is slow with many templates, so once they are
+    loaded the blueprints and template values are compiled into a binary
+    flatbuffer cache. On the next start the cache is memory mapped and the
+    templates are instantiated directly from it, the json files are only
+    parsed again if any of them is newer than the cache, or files were added
+    or removed, or the layout of a component has changed.
+
     @see api.h
     @see Game::EntityManager
 
@@ -21,11 +28,13 @@
 #include "util/stringatom.h"
 #include "game/api.h"
 #include "ids/idgenerationpool.h"
+#include "io/stream.h"
 
 namespace Game
 {
 
 class World;
+struct BlueprintCache;
 
 class BlueprintManager
 {
@@ -44,6 +53,8 @@ public:
     static void Destroy();
     /// set a optional blueprints.xml, which is used instead of standard blueprint.xml
     static void SetBlueprintsFilename(const Util::String& name, const Util::String& folder);
+    /// set the compiled blueprint cache file, an empty name disables the cache, defaults to temp:<app name>/blueprints.bpca
+    static void SetBlueprintCacheFilename(const Util::String& name);
     /// get a blueprint id
     static BlueprintId const GetBlueprintId(Util::StringAtom name);
     /// get a template id
@@ -69,10 +80,22 @@ private:
 
     /// parse entity blueprints file
     bool ParseBlueprint(Util::String const& blueprintsPath);
-    /// load a template folder
-    bool LoadTemplateFolder(Util::String const& path);
+    /// list all template files in a folder and its subfolders
+    void ListTemplateFiles(Util::String const& path, Util::Array<Util::String>& files);
     /// parse blueprint template file
     bool ParseTemplate(Util::String const& templatePath);
+    /// add a template row to a blueprint table
+    MemDb::RowId AddTemplate(BlueprintId blueprint, Util::StringAtom name);
+    /// map the blueprint cache, returns false if it's missing or out of date
+    bool OpenCache();
+    /// unmap the blueprint cache
+    void CloseCache();
+    /// read the blueprints from the cache
+    void LoadCachedBlueprints();
+    /// instantiate the templates from the cache, returns false without adding any if the components have changed
+    bool LoadCachedTemplates();
+    /// compile the parsed blueprints and templates into the cache
+    void WriteCache();
     /// setup blueprint database
     void SetupBlueprints();
     /// create a table in the world db
@@ -108,8 +131,20 @@ private:
     /// maps from blueprint name to blueprint id, which is the index in the blueprints array.
     Util::HashTable<Util::StringAtom, BlueprintId> blueprintMap;
 
+    /// templates parsed from files, in the order they are written to the cache
+    Util::Array<TemplateId> fileTemplates;
+    /// the blueprints read from files, the blueprints after these are created at runtime
+    SizeT numFileBlueprints;
+
+    Util::Array<Util::String> blueprintFiles;
+    Util::Array<Util::String> templateFiles;
+    Ptr<IO::Stream> cacheStream;
+    const BlueprintCache* cache;
+
     static Util::String blueprintFolder;
     static Util::String templatesFolder;
+    static Util::String cacheFilename;
+    static bool cacheFilenameSet;
 };
 
 } // namespace Game
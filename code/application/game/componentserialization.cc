@@ -67,6 +67,36 @@ ComponentSerialization::Serialize(Ptr<IO::JsonWriter> const& writer, ComponentId
     Singleton->serializers[component.id].serializeJson(writer, name, ptr);
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ComponentSerialization::Deserialize(Ptr<IO::BinaryReader> const& reader, ComponentId component, void* ptr)
+{
+    n_assert(Singleton != nullptr);
+    Singleton->serializers[component.id].deserializeBinary(reader, ptr);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ComponentSerialization::Serialize(Ptr<IO::BinaryWriter> const& writer, ComponentId component, void* ptr)
+{
+    n_assert(Singleton != nullptr);
+    Singleton->serializers[component.id].serializeBinary(writer, ptr);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+uint32_t
+ComponentSerialization::FieldLayoutHash(ComponentId component)
+{
+    n_assert(Singleton != nullptr);
+    return Singleton->serializers[component.id].fieldLayoutHash;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -32,6 +32,8 @@ class ComponentSerialization
 public:
     using DeserializeJsonFunc = Util::Delegate<void(Ptr<IO::JsonReader> const&, const char* name, void*)>;
     using SerializeJsonFunc   = Util::Delegate<void(Ptr<IO::JsonWriter> const&, const char* name, void*)>;
+    using DeserializeBinaryFunc = Util::Delegate<void(Ptr<IO::BinaryReader> const&, void*)>;
+    using SerializeBinaryFunc   = Util::Delegate<void(Ptr<IO::BinaryWriter> const&, void*)>;
     
     static ComponentSerialization* Instance();
     static void Destroy();
@@ -43,6 +45,12 @@ public:
     static void Deserialize(Ptr<IO::JsonReader> const& reader, ComponentId component, void* ptr);
     /// ptr points to the value that should be stored
     static void Serialize(Ptr<IO::JsonWriter> const& writer, ComponentId component, void* ptr);
+    /// ptr points to the location where the value should be stored. Make sure you have room for it!
+    static void Deserialize(Ptr<IO::BinaryReader> const& reader, ComponentId component, void* ptr);
+    /// ptr points to the value that should be stored
+    static void Serialize(Ptr<IO::BinaryWriter> const& writer, ComponentId component, void* ptr);
+    /// get the hash of the field types and names of an IDL component, 0 for other types
+    static uint32_t FieldLayoutHash(ComponentId component);
 
 private:
     ComponentSerialization();
@@ -57,6 +65,9 @@ private:
     {
         DeserializeJsonFunc deserializeJson;
         SerializeJsonFunc serializeJson;
+        DeserializeBinaryFunc deserializeBinary;
+        SerializeBinaryFunc serializeBinary;
+        uint32_t fieldLayoutHash;
     };
 
     Util::Array<Serializer> serializers;
@@ -83,7 +94,19 @@ ComponentSerialization::Register(ComponentId component)
         writer->Add(value, name);
     };
 
-    // TODO: Serialization
+    // Setup a type-specific binary read function
+    const auto readBinary = [](Ptr<IO::BinaryReader> const& reader, void* ptr)
+    {
+        TYPE& value = *(static_cast<TYPE*>(ptr));
+        reader->Get(value);
+    };
+
+    // Setup a type-specific binary write function
+    const auto writeBinary = [](Ptr<IO::BinaryWriter> const& writer, void* ptr)
+    {
+        TYPE& value = *(static_cast<TYPE*>(ptr));
+        writer->Add(value);
+    };
 
     auto* reg = Instance();
     if (!reg->ValidateTypeSize(component, sizeof(TYPE)))
@@ -95,6 +118,12 @@ ComponentSerialization::Register(ComponentId component)
     Serializer s;
     s.deserializeJson = read;
     s.serializeJson = write;
+    s.deserializeBinary = readBinary;
+    s.serializeBinary = writeBinary;
+    if constexpr (requires { TYPE::Traits::field_layout_hash; })
+        s.fieldLayoutHash = TYPE::Traits::field_layout_hash;
+    else
+        s.fieldLayoutHash = 0;
     while (reg->serializers.Size() <= component.id)
     {
         reg->serializers.Grow();
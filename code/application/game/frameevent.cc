@@ -233,7 +233,8 @@ FrameEvent::Batch::CacheTable(MemDb::TableId tid, MemDb::TableSignature const& s
 void
 FrameEvent::Batch::ExecuteAsync(World* world)
 {
-    Util::FixedArray<Dataset> datasets(this->processors.Size());
+    // the datasets and job inputs only live until the batch is done, so they come from the job scratch memory
+    Util::FixedArray<Dataset, Jobs2::JobScratchAllocator> datasets(this->processors.Size());
 
     uint32_t numJobs = 0;
 
@@ -249,7 +250,7 @@ FrameEvent::Batch::ExecuteAsync(World* world)
 
     ProcessorJobContext context;
     context.world = world;
-    context.inputs = new ProcessorJobInput[numJobs];
+    context.inputs = Jobs2::JobAlloc<ProcessorJobInput>(numJobs);
 
     IndexT inputIndex = 0;
     for (IndexT i = 0; i < datasets.Size(); i++)
@@ -265,8 +266,6 @@ FrameEvent::Batch::ExecuteAsync(World* world)
     Jobs2::JobDispatch(FrameBatchJob, numJobs, 1, context, nullptr, nullptr, &event);
     event.Wait();
 
-    delete[] context.inputs;
-
     Jobs2::JobNewFrame();
 }
 
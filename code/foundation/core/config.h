@@ -60,12 +60,9 @@ static const int JobMaxSliceSize = 0xFFFF;
 #define NEBULA_MEMORY_ADVANCED_DEBUGGING (0)
 #endif
 
-// enable/disable thread-local StringAtom tables
-#if (__LINUX__)
+// enable/disable thread-local StringAtom tables, since lookups in the
+// global table don't lock, the thread-local caches are disabled by default
 #define NEBULA_ENABLE_THREADLOCAL_STRINGATOM_TABLES (0)
-#else
-#define NEBULA_ENABLE_THREADLOCAL_STRINGATOM_TABLES (1)
-#endif
 
 // enable/disable growth of StringAtom buffer
 #define NEBULA_ENABLE_GLOBAL_STRINGBUFFER_GROWTH (1)
@@ -157,6 +154,23 @@ static const int JobMaxSliceSize = 0xFFFF;
 #define  __attribute__(x)  /**/
 #endif
 
+// enable instruction sets for single functions, for kernels which are selected at runtime (see System::Cpu),
+// msvc allows all intrinsics in any function
+#if defined __GNUC__
+#define N_TARGET_AVX2 __attribute__((target("avx2,fma,bmi2")))
+#define N_TARGET_AVX512 __attribute__((target("avx512f,avx512dq,avx512bw,avx512vl,avx2,fma,bmi2")))
+#else
+#define N_TARGET_AVX2
+#define N_TARGET_AVX512
+#endif
+
+// keep a function out of line, for instance so a thread local is looked up again after a fiber may have moved threads
+#if defined __GNUC__
+#define N_NOINLINE __attribute__((noinline))
+#else
+#define N_NOINLINE __declspec(noinline)
+#endif
+
 // define max texture space for resource streaming
 #if __WIN32__
 // 512 MB
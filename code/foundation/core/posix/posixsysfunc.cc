@@ -15,6 +15,7 @@
 #include "util/globalstringatomtable.h"
 #include "util/localstringatomtable.h"  
 #include "system/systeminfo.h"
+#include "system/cpu.h"
 #include <errno.h>
 
 namespace Posix
@@ -49,6 +50,7 @@ SysFunc::Setup()
         Memory::SetupHeaps();
         Memory::Heap::Setup();
         Blob::Setup();
+        System::Cpu::Setup();
         #if !__MAYA__
         Net::Socket::InitNetwork();
         #endif   
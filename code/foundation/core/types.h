@@ -179,4 +179,7 @@ typedef unsigned char byte;
 #define lengthof(x) (sizeof(x) / sizeof(*x))
 
 #define NEBULA_ALIGN16 alignas(16)
+// data written by different threads should be at least this far apart
+#define NEBULA_CACHELINE_SIZE 64
+#define NEBULA_ALIGN_CACHELINE alignas(NEBULA_CACHELINE_SIZE)
 //------------------------------------------------------------------------------
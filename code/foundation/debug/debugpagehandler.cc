@@ -29,6 +29,7 @@ DebugPageHandler::DebugPageHandler()
     this->SetName("Profiling");
     this->SetDesc("show profiling (debug) subsystem information");
     this->SetRootLocation("profiling");
+    this->SetThreadSafe(true);
 }
 
 //------------------------------------------------------------------------------
@@ -76,6 +77,8 @@ DebugPageHandler::HandleRequest(const Ptr<HttpRequest>& request)
     htmlWriter->SetTitle("Nebula Debug Subsystem Info");
     if (htmlWriter->Open())
     {
+        // set the status before writing, so the page can be streamed while it is generated
+        request->SetStatus(HttpStatus::OK);
         htmlWriter->Element(HtmlElement::Heading1, "Profiling Subsystem");
         htmlWriter->AddAttr("href", "/index.html");
         htmlWriter->Element(HtmlElement::Anchor, "Home");
@@ -136,8 +139,10 @@ DebugPageHandler::HandleRequest(const Ptr<HttpRequest>& request)
 
             // get sorting flag
             Util::String sortColumn;
+            this->sortCritSect.Enter();
             if (this->timerSortColumns.Contains(webfriendlyGroup))      sortColumn = this->timerSortColumns[webfriendlyGroup];
             else                                                        sortColumn = "Name";
+            this->sortCritSect.Leave();
 
             // copy to dictionary for sort
             Dictionary<Variant, Ptr<DebugTimer>> sortedTimer;
@@ -248,8 +253,10 @@ DebugPageHandler::HandleRequest(const Ptr<HttpRequest>& request)
 
             // get sorting flag
             Util::String sortColumn;
+            this->sortCritSect.Enter();
             if (this->counterSortColumns.Contains(webfriendlyGroup))    sortColumn = this->counterSortColumns[webfriendlyGroup];
             else                                                        sortColumn = "Name";
+            this->sortCritSect.Leave();
 
             // copy to dictionary for sort
             Dictionary<Variant, Ptr<DebugCounter>> sortedCounters;
@@ -307,7 +314,6 @@ DebugPageHandler::HandleRequest(const Ptr<HttpRequest>& request)
         }      
 
         htmlWriter->Close();
-        request->SetStatus(HttpStatus::OK);
     }
     else
     {
@@ -535,8 +541,10 @@ DebugPageHandler::HandleCounterChartRequest(const String& counterName, const Ptr
 void 
 DebugPageHandler::HandleTimerTableSortRequest(const Util::String& columnName, const Util::String& tableName, const Ptr<Http::HttpRequest>& request)
 {
+    this->sortCritSect.Enter();
     if (this->timerSortColumns.Contains(tableName))     this->timerSortColumns[tableName] = columnName;
     else                                                this->timerSortColumns.Add(tableName, columnName);
+    this->sortCritSect.Leave();
     request->SetStatus(HttpStatus::OK);
 }
 
@@ -546,8 +554,10 @@ DebugPageHandler::HandleTimerTableSortRequest(const Util::String& columnName, co
 void
 DebugPageHandler::HandleCounterTableSortRequest(const Util::String& columnName, const Util::String& tableName, const Ptr<Http::HttpRequest>& request)
 {
+    this->sortCritSect.Enter();
     if (this->counterSortColumns.Contains(tableName))   this->counterSortColumns[tableName] = columnName;
     else                                                this->counterSortColumns.Add(tableName, columnName);
+    this->sortCritSect.Leave();
     request->SetStatus(HttpStatus::OK);
 }
 
@@ -5,7 +5,9 @@
     
     Http request handler for the Debug subsystem.
 
-    Renders profiling counters and timers.
+    Renders profiling counters and timers. The debug server and its timers
+    and counters are thread-safe, so requests are handled on the http
+    server's worker threads.
     
     @copyright
     (C) 2008 Radon Labs GmbH
@@ -13,6 +15,7 @@
 */
 #include "http/httprequesthandler.h"
 #include "timing/time.h"
+#include "threading/criticalsection.h"
 
 //------------------------------------------------------------------------------
 namespace Debug
@@ -46,6 +49,7 @@ private:
     /// handle HTTP request to sort table
     void HandleCounterTableSortRequest(const Util::String& columnName, const Util::String& tableName, const Ptr<Http::HttpRequest>& request);
 
+    Threading::CriticalSection sortCritSect;
     Util::Dictionary<Util::String, Util::String> timerSortColumns;
     Util::Dictionary<Util::String, Util::String> counterSortColumns;
 };
@@ -7,6 +7,8 @@
     (C) 2020 Individual contributors, see AUTHORS file
 */
 //------------------------------------------------------------------------------
+#include "core/types.h"
+
 namespace Fibers
 {
 
@@ -19,13 +21,17 @@ public:
     /// construct from nullpointer
     Fiber(std::nullptr_t);
     /// constructor
-    Fiber(void(*Function)(void*), void* context);
+    Fiber(void(*Function)(void*), void* context, SizeT stackSize = 64 * 1024);
     /// copy constructor
     Fiber(const Fiber& rhs);
+    /// move constructor
+    Fiber(Fiber&& rhs);
     /// destructor
     ~Fiber();
     /// assignment operator
     void operator=(const Fiber& rhs);
+    /// move assignment operator
+    void operator=(Fiber&& rhs);
 
     /// convert thread to fiber
     static void ThreadToFiber(Fiber& fiber);
@@ -110,8 +110,11 @@ FiberThread::SwitchFiber()
     this->threadFiber.SwitchToFiber(*this->currentFiber.fiber);
 }
 
-Threading::LockFreeQueue<FiberQueue::Job> FiberQueue::PendingJobsQueue;
-Threading::LockFreeQueue<uint> FiberQueue::FiberIdQueue;
+Threading::MpmcQueue<FiberQueue::Job> FiberQueue::PendingJobsQueue;
+Threading::MpmcQueue<uint> FiberQueue::FiberIdQueue;
+Threading::CriticalSection FiberQueue::OverflowLock;
+Util::Array<FiberQueue::Job> FiberQueue::OverflowJobs;
+Threading::AtomicCounter FiberQueue::NumOverflowJobs = 0;
 Util::FixedArray<Fibers::Fiber> FiberQueue::Fibers;
 Util::FixedArray<FiberQueue::Job> FiberQueue::FiberContexts;
 
@@ -152,7 +155,7 @@ FiberQueue::Setup(const FiberQueueCreateInfo& info)
     FiberQueue::PendingJobsQueue.Resize(65535);
     FiberQueue::FiberIdQueue.Resize(info.numFibers);
     for (int i = info.numFibers - 1; i >= 0; i--)
-        FiberQueue::FiberIdQueue.Enqueue(i);
+        FiberQueue::Free(i);
 }
 
 //------------------------------------------------------------------------------
@@ -174,7 +177,39 @@ FiberQueue::Discard()
 void
 FiberQueue::Free(uint id)
 {
-    FiberQueue::FiberIdQueue.Enqueue(id);
+    // there are never more ids than fibers, so the queue always has room
+    const bool freed = FiberQueue::FiberIdQueue.TryEnqueue(id);
+    n_assert(freed);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+FiberQueue::Overflow(const Job& job)
+{
+    Threading::CriticalScope lock(&FiberQueue::OverflowLock);
+    FiberQueue::OverflowJobs.Append(job);
+    Threading::Interlocked::Increment(&FiberQueue::NumOverflowJobs);
+}
+
+//------------------------------------------------------------------------------
+/**
+    The count lets the fiber threads skip the lock while nothing overflowed
+*/
+bool
+FiberQueue::DequeueOverflow(Job& job)
+{
+    if (FiberQueue::NumOverflowJobs == 0)
+        return false;
+
+    Threading::CriticalScope lock(&FiberQueue::OverflowLock);
+    if (FiberQueue::OverflowJobs.IsEmpty())
+        return false;
+    job = FiberQueue::OverflowJobs.Front();
+    FiberQueue::OverflowJobs.EraseFront();
+    Threading::Interlocked::Decrement(&FiberQueue::NumOverflowJobs);
+    return true;
 }
 
 //------------------------------------------------------------------------------
@@ -243,28 +278,25 @@ FiberQueue::Dequeue(Fibers::FiberContext& fiber)
     Job job;
     uint id;
 
+    // take a fiber first, so a job never has to be put back into a queue which may be full by now
+    if (!FiberQueue::FiberIdQueue.Dequeue(id))
+        return false;
+
     // if there are free jobs to pick up, do it
-    if (FiberQueue::PendingJobsQueue.Dequeue(job))
+    if (FiberQueue::PendingJobsQueue.Dequeue(job) || FiberQueue::DequeueOverflow(job))
     {
-        if (FiberQueue::FiberIdQueue.Dequeue(id))
-        {
-            job.id = id;
+        job.id = id;
 
-            // update context and run the constructor on the fiber
-            FiberQueue::FiberContexts[id] = job;
-            new (&FiberQueue::Fibers[id]) Fibers::Fiber{ Fibers::FiberFunction, &FiberQueue::FiberContexts[id] };
+        // update context and run the constructor on the fiber
+        FiberQueue::FiberContexts[id] = job;
+        new (&FiberQueue::Fibers[id]) Fibers::Fiber{ Fibers::FiberFunction, &FiberQueue::FiberContexts[id] };
 
-            fiber.counter = job.counter;
-            fiber.fiber = &FiberQueue::Fibers[id];
-            return true;
-        }
-        else
-        {
-            // if fiber pool fails, enqueue job again
-            FiberQueue::PendingJobsQueue.Enqueue(job);
-        }
+        fiber.counter = job.counter;
+        fiber.fiber = &FiberQueue::Fibers[id];
+        return true;
     }
 
+    FiberQueue::Free(id);
     return false;
 }
 
@@ -13,7 +13,7 @@
 #include "ids/idallocator.h"
 #include "threading/thread.h"
 #include "threading/safequeue.h"
-#include "threading/lockfreequeue.h"
+#include "threading/mpmcqueue.h"
 
 namespace Fibers
 {
@@ -104,9 +104,19 @@ public:
     static bool Dequeue(Fibers::FiberContext& fiber);
 
 private:
+    /// put a job which didn't fit in the pending queue aside
+    static void Overflow(const Job& job);
+    /// take a job which didn't fit in the pending queue
+    static bool DequeueOverflow(Job& job);
+
     /// async queues
-    static Threading::LockFreeQueue<Job> PendingJobsQueue;
-    static Threading::LockFreeQueue<uint> FiberIdQueue;
+    static Threading::MpmcQueue<Job> PendingJobsQueue;
+    static Threading::MpmcQueue<uint> FiberIdQueue;
+
+    /// jobs which didn't fit in the pending queue, jobs enqueue jobs so the fiber threads must never wait for room
+    static Threading::CriticalSection OverflowLock;
+    static Util::Array<Job> OverflowJobs;
+    static Threading::AtomicCounter NumOverflowJobs;
 
     /// storage
     static Util::FixedArray<Fibers::Fiber> Fibers;
@@ -133,7 +143,8 @@ FiberQueue::Enqueue(JobFunction function, const Util::FixedArray<T*>& contexts,
         job.function = function;
         job.context = contexts[i];
         job.counter = counter;
-        FiberQueue::PendingJobsQueue.Enqueue(job);
+        if (!FiberQueue::PendingJobsQueue.TryEnqueue(job))
+            FiberQueue::Overflow(job);
     }
 }
 
@@ -6,40 +6,117 @@
 #include "fibers/fiber.h"
 #include "memory/memory.h"
 #include "core/debug.h"
-#include <ucontext.h>
-#include <setjmp.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if !defined(__x86_64__)
+#error "Fibers::Fiber context switch not implemented for this architecture!"
+#endif
+
+//------------------------------------------------------------------------------
+/**
+    The context switch only has to save what the calling convention says
+    survives a call, everything else the compiler already assumes lost
+    when it calls NebulaFiberSwitch(). So the callee-saved registers and
+    the floating point control words are pushed on the old stack, the
+    stack pointers are swapped, and the same is popped from the new one.
+    Compared to swapcontext() this saves the signal mask system call, and
+    compared to setjmp/longjmp it saves the pointer mangling and shadow
+    stack checks, leaving a couple of nanoseconds per switch.
+
+    void NebulaFiberSwitch(void** saveStack, void* loadStack)
+
+    A fresh fiber starts in NebulaFiberStart, which calls the fiber
+    function in r12 with the parameter in r13. Fiber functions never
+    return, they switch to another fiber when they are done.
+*/
+#if __APPLE__
+#define FIBER_SYMBOL(name) "_" #name
+#define FIBER_FUNCTION(name) ".globl " FIBER_SYMBOL(name) "\n" FIBER_SYMBOL(name) ":\n"
+#define FIBER_FUNCTION_END(name)
+#else
+#define FIBER_SYMBOL(name) #name
+#define FIBER_FUNCTION(name) ".globl " #name "\n.hidden " #name "\n.type " #name ", @function\n" #name ":\n"
+#define FIBER_FUNCTION_END(name) ".size " #name ", .-" #name "\n"
+#endif
+
+__asm__(
+    ".text\n"
+    ".p2align 4\n"
+    FIBER_FUNCTION(NebulaFiberSwitch)
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    FIBER_FUNCTION_END(NebulaFiberSwitch)
+    ".p2align 4\n"
+    FIBER_FUNCTION(NebulaFiberStart)
+    "    movq %r13, %rdi\n"
+    "    callq *%r12\n"
+    "    ud2\n"
+    FIBER_FUNCTION_END(NebulaFiberStart)
+);
+
+extern "C" void NebulaFiberSwitch(void** saveStack, void* loadStack);
+extern "C" void NebulaFiberStart();
 
 namespace Fibers
 {
 
-
 struct fiber_t
 {
-    ucontext_t  fib;
-    jmp_buf     jmp;
+    void* stackPointer;
+    char* stack;
+    size_t stackSize;
 };
 
-struct fiber_ctx_t
+/// the registers NebulaFiberSwitch() pops from a stack, in memory order
+struct fiber_frame_t
 {
-    void(*fnc)(void*);
-    void* ctx;
-    jmp_buf* cur;
-    ucontext_t* prv;
+    uint mxcsr;
+    ushort fpuControl;
+    ushort pad;
+    void* r15;
+    void* r14;
+    void* r13;
+    void* r12;
+    void* rbx;
+    void* rbp;
+    void* returnAddress;
 };
 
 //------------------------------------------------------------------------------
 /**
 */
-Fiber::Fiber()
-    : handle(nullptr)
-    , context(nullptr)
+static void
+FreeFiber(fiber_t* fiber)
 {
+    if (fiber->stack != nullptr)
+        munmap(fiber->stack, fiber->stackSize);
+    delete fiber;
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-Fiber::Fiber(std::nullptr_t)
+Fiber::Fiber()
     : handle(nullptr)
     , context(nullptr)
 {
@@ -48,39 +125,49 @@ Fiber::Fiber(std::nullptr_t)
 //------------------------------------------------------------------------------
 /**
 */
-static void FiberStartFunction(void* p)
+Fiber::Fiber(std::nullptr_t)
+    : handle(nullptr)
+    , context(nullptr)
 {
-    fiber_ctx_t* ctx = (fiber_ctx_t*)p;
-    void (*ufnc)(void*) = ctx->fnc;
-    void* uctx = ctx->ctx;
-    if (_setjmp(*ctx->cur) == 0)
-    {
-        ucontext_t tmp;
-        swapcontext(&tmp, ctx->prv);
-    }
-    ufnc(uctx);
 }
 
 //------------------------------------------------------------------------------
 /**
+    The lowest page of the stack is a guard page, so a fiber which runs
+    out of stack crashes right away instead of corrupting its neighbour.
+    The first switch to the fiber pops an initial frame which returns
+    into NebulaFiberStart, with the stack aligned like after a call.
 */
-Fiber::Fiber(void(*function)(void*), void* context)
+Fiber::Fiber(void(*function)(void*), void* context, SizeT stackSize)
     : handle(nullptr)
     , context(nullptr)
 {
-    this->handle = new fiber_t;
-    fiber_t* implHandle = (fiber_t*)this->handle;
-    getcontext(&implHandle->fib);
+    const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t size = ((stackSize + pageSize - 1) & ~(pageSize - 1)) + pageSize;
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    n_assert(mem != MAP_FAILED);
+    mprotect(mem, pageSize, PROT_NONE);
+
+    fiber_t* implHandle = new fiber_t;
+    implHandle->stack = (char*)mem;
+    implHandle->stackSize = size;
 
-    const size_t stackSize = 64 * 1024;
-    implHandle->fib.uc_stack.ss_sp = new char[stackSize];
-    implHandle->fib.uc_stack.ss_size = stackSize;
-    implHandle->fib.uc_link = nullptr;
+    // returnAddress + 8 has to be 16 byte aligned, and keep 16 bytes free above it
+    const uintptr_t top = ((uintptr_t)mem + size) & ~(uintptr_t)15;
+    fiber_frame_t* frame = (fiber_frame_t*)(top - 16 - sizeof(fiber_frame_t));
+    memset(frame, 0, sizeof(fiber_frame_t));
+    uint mxcsr;
+    ushort fpuControl;
+    __asm__ volatile("stmxcsr %0" : "=m"(mxcsr));
+    __asm__ volatile("fnstcw %0" : "=m"(fpuControl));
+    frame->mxcsr = mxcsr;
+    frame->fpuControl = fpuControl;
+    frame->r12 = (void*)function;
+    frame->r13 = context;
+    frame->returnAddress = (void*)NebulaFiberStart;
+    implHandle->stackPointer = frame;
 
-    ucontext_t temp;
-    fiber_ctx_t ctx = { function, context, &implHandle->jmp, &temp };
-    makecontext(&implHandle->fib, (void(*)())FiberStartFunction, 1, &ctx);
-    swapcontext(&temp, &implHandle->fib);
+    this->handle = implHandle;
     this->context = context;
 }
 
@@ -88,14 +175,20 @@ Fiber::Fiber(void(*function)(void*), void* context)
 /**
 */
 Fiber::Fiber(const Fiber& rhs)
+    : handle(rhs.handle)
+    , context(rhs.context)
 {
-    if (this->handle != nullptr)
-    {
-        fiber_t* implHandle = (fiber_t*)this->handle;
-        delete[] (char*)implHandle->fib.uc_stack.ss_sp;
-    }
-    this->handle = rhs.handle;
-    this->context = rhs.context;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Fiber::Fiber(Fiber&& rhs)
+    : handle(rhs.handle)
+    , context(rhs.context)
+{
+    rhs.handle = nullptr;
+    rhs.context = nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -104,10 +197,7 @@ Fiber::Fiber(const Fiber& rhs)
 Fiber::~Fiber()
 {
     if (this->handle != nullptr)
-    {
-        fiber_t* implHandle = (fiber_t*)this->handle;
-        delete[] (char*)implHandle->fib.uc_stack.ss_sp;
-    }
+        FreeFiber((fiber_t*)this->handle);
     this->handle = nullptr;
     this->context = nullptr;
 }
@@ -119,22 +209,39 @@ void
 Fiber::operator=(const Fiber& rhs)
 {
     if (this->handle != nullptr)
-    {
-        fiber_t* implHandle = (fiber_t*)this->handle;
-        delete[] (char*)implHandle->fib.uc_stack.ss_sp;
-    }
+        FreeFiber((fiber_t*)this->handle);
+    this->handle = rhs.handle;
+    this->context = rhs.context;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Fiber::operator=(Fiber&& rhs)
+{
+    if (this->handle != nullptr)
+        FreeFiber((fiber_t*)this->handle);
     this->handle = rhs.handle;
     this->context = rhs.context;
+    rhs.handle = nullptr;
+    rhs.context = nullptr;
 }
 
 //------------------------------------------------------------------------------
 /**
+    The thread keeps running on its own stack, the fiber only needs a
+    place to save the stack pointer when switching away from it.
 */
 void
 Fiber::ThreadToFiber(Fiber& fiber)
 {
-    fiber.handle = Memory::Alloc(Memory::AppHeap, sizeof(fiber_t));
-    Memory::Clear(fiber.handle, sizeof(fiber_t));
+    fiber_t* implHandle = new fiber_t;
+    implHandle->stackPointer = nullptr;
+    implHandle->stack = nullptr;
+    implHandle->stackSize = 0;
+    fiber.handle = implHandle;
+    fiber.context = nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -143,7 +250,7 @@ Fiber::ThreadToFiber(Fiber& fiber)
 void
 Fiber::FiberToThread(Fiber& fiber)
 {
-    Memory::Free(Memory::AppHeap, fiber.handle);
+    FreeFiber((fiber_t*)fiber.handle);
     fiber.handle = nullptr;
     fiber.context = nullptr;
 }
@@ -157,10 +264,7 @@ Fiber::SwitchToFiber(Fiber& CurrentFiber)
     n_assert(this->handle != nullptr);
     fiber_t* implHandle = (fiber_t*)this->handle;
     fiber_t* currHandle = (fiber_t*)CurrentFiber.handle;
-    if (_setjmp(currHandle->jmp) == 0)
-    {
-        _longjmp(implHandle->jmp, 1);
-    }
+    NebulaFiberSwitch(&currHandle->stackPointer, implHandle->stackPointer);
 }
 
 }
@@ -30,11 +30,11 @@ Fiber::Fiber(std::nullptr_t)
 //------------------------------------------------------------------------------
 /**
 */
-Fiber::Fiber(void(*function)(void*), void* context)
+Fiber::Fiber(void(*function)(void*), void* context, SizeT stackSize)
     : handle(nullptr)
     , context(nullptr)
 {
-    this->handle = CreateFiber(0, { function }, context);
+    this->handle = CreateFiber(stackSize, { function }, context);
     this->context = context;
 }
 
@@ -49,6 +49,17 @@ Fiber::Fiber(const Fiber& rhs)
     this->context = rhs.context;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+Fiber::Fiber(Fiber&& rhs)
+    : handle(rhs.handle)
+    , context(rhs.context)
+{
+    rhs.handle = nullptr;
+    rhs.context = nullptr;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -72,6 +83,20 @@ Fiber::operator=(const Fiber& rhs)
     this->context = rhs.context;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Fiber::operator=(Fiber&& rhs)
+{
+    if (this->handle != nullptr)
+        DeleteFiber(this->handle);
+    this->handle = rhs.handle;
+    this->context = rhs.context;
+    rhs.handle = nullptr;
+    rhs.context = nullptr;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
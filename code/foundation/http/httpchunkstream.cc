@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+//  httpchunkstream.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "http/httpchunkstream.h"
+#include "threading/interlocked.h"
+
+namespace Http
+{
+__ImplementClass(Http::HttpChunkStream, 'HTCK', IO::MemoryStream);
+
+using namespace IO;
+using namespace Threading;
+
+//------------------------------------------------------------------------------
+/**
+*/
+HttpChunkStream::HttpChunkStream() :
+    chunkSize(0),
+    numFlushedBytes(0),
+    chunks(nullptr)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+HttpChunkStream::~HttpChunkStream()
+{
+    FreeChunks(this->DequeueChunks());
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpChunkStream::Write(const void* ptr, Size numBytes)
+{
+    MemoryStream::Write(ptr, numBytes);
+    if ((this->chunkSize > 0) && (this->size >= this->chunkSize) && (this->position == this->size))
+    {
+        this->FlushChunk();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpChunkStream::Seek(Offset offset, SeekOrigin origin)
+{
+    MemoryStream::Seek(offset, origin);
+    if (this->position != this->size)
+    {
+        // content may be patched, so it can't be handed off before the handler is done
+        n_assert2(0 == this->numFlushedBytes, "HttpChunkStream: can't seek after content was streamed!");
+        this->chunkSize = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Called on the handler thread. The chunk is pushed to the front of the
+    list, DequeueChunks() restores the write order.
+*/
+void
+HttpChunkStream::FlushChunk()
+{
+    Chunk* chunk = (Chunk*)Memory::Alloc(Memory::NetworkHeap, sizeof(Chunk) + (size_t)this->size);
+    chunk->size = (SizeT)this->size;
+    Memory::Copy(this->buffer, chunk + 1, (size_t)this->size);
+    this->numFlushedBytes += chunk->size;
+    this->size = 0;
+    this->position = 0;
+
+    Chunk* head;
+    do
+    {
+        head = this->chunks;
+        chunk->next = head;
+    }
+    while (Interlocked::CompareExchangePointer((void* volatile*)&this->chunks, chunk, head) != head);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Called on the server thread, takes the whole list at once so there is
+    no contention with the handler thread beyond a single exchange.
+*/
+HttpChunkStream::Chunk*
+HttpChunkStream::DequeueChunks()
+{
+    Chunk* list = (Chunk*)Interlocked::ExchangePointer((void* volatile*)&this->chunks, nullptr);
+    Chunk* ordered = nullptr;
+    while (nullptr != list)
+    {
+        Chunk* next = list->next;
+        list->next = ordered;
+        ordered = list;
+        list = next;
+    }
+    return ordered;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpChunkStream::FreeChunks(Chunk* chunks)
+{
+    while (nullptr != chunks)
+    {
+        Chunk* next = chunks->next;
+        Memory::Free(Memory::NetworkHeap, chunks);
+        chunks = next;
+    }
+}
+
+} // namespace Http
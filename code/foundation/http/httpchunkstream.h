@@ -0,0 +1,108 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Http::HttpChunkStream
+
+    The response content stream the HttpServer hands to request handlers.
+
+    It behaves like a MemoryStream, but once the server enabled chunking and
+    the content written by the handler exceeds the chunk size, the content is
+    handed off to the server as a chunk and the stream starts over empty.
+    This lets the server send large pages with chunked transfer encoding
+    while the handler is still writing them, instead of holding the complete
+    page in memory.
+
+    Handing off chunks is lock-free: the handler thread pushes chunks onto an
+    atomic list, which the server thread takes as a whole. Seeking in the stream
+    disables chunking, and is not allowed anymore once a chunk has been handed off.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "io/memorystream.h"
+
+//------------------------------------------------------------------------------
+namespace Http
+{
+class HttpChunkStream : public IO::MemoryStream
+{
+    __DeclareClass(HttpChunkStream);
+public:
+    /// a chunk of content handed off to the server
+    struct Chunk
+    {
+        Chunk* next;
+        SizeT size;
+
+        /// get pointer to the chunk data
+        const uchar* Data() const;
+    };
+
+    /// constructor
+    HttpChunkStream();
+    /// destructor
+    virtual ~HttpChunkStream();
+
+    /// set the size at which content is handed off as a chunk, 0 disables chunking
+    void SetChunkSize(SizeT size);
+    /// get the chunk size
+    SizeT GetChunkSize() const;
+    /// return true if chunks are waiting to be taken by the server
+    bool HasChunks() const;
+    /// take all handed off chunks in write order, release them with FreeChunks()
+    Chunk* DequeueChunks();
+    /// free a list of chunks returned by DequeueChunks()
+    static void FreeChunks(Chunk* chunks);
+
+    /// write to the stream, hands off a chunk when the chunk size is exceeded
+    virtual void Write(const void* ptr, Size numBytes);
+    /// seek in stream, disables chunking
+    virtual void Seek(Offset offset, SeekOrigin origin);
+
+private:
+    /// hand the current content off as a chunk
+    void FlushChunk();
+
+    SizeT chunkSize;
+    SizeT numFlushedBytes;
+    Chunk* volatile chunks;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const uchar*
+HttpChunkStream::Chunk::Data() const
+{
+    return (const uchar*)(this + 1);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+HttpChunkStream::SetChunkSize(SizeT size)
+{
+    this->chunkSize = size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+HttpChunkStream::GetChunkSize() const
+{
+    return this->chunkSize;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+HttpChunkStream::HasChunks() const
+{
+    return nullptr != this->chunks;
+}
+
+} // namespace Http
+//------------------------------------------------------------------------------
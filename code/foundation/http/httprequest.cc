@@ -15,6 +15,7 @@ __ImplementMsgId(HttpRequest);
 /**
 */
 HttpRequest::HttpRequest() :
+    nextPending(nullptr),
     method(HttpMethod::InvalidHttpMethod),
     status(HttpStatus::InvalidHttpStatus)
 {
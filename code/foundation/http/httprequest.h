@@ -15,6 +15,7 @@
 #include "http/httpmethod.h"
 #include "http/httpstatus.h"
 #include "io/uri.h"
+#include <atomic>
 
 //------------------------------------------------------------------------------
 namespace Http
@@ -47,10 +48,13 @@ public:
     HttpStatus::Code GetStatus() const;
 
 private:
+    friend class HttpRequestHandler;
+
+    HttpRequest* nextPending;
     HttpMethod::Code method;
     IO::URI uri;
     Ptr<IO::Stream> responseContentStream;
-    HttpStatus::Code status;
+    std::atomic<HttpStatus::Code> status;
 };
 
 //------------------------------------------------------------------------------
@@ -109,11 +113,13 @@ HttpRequest::GetResponseContentStream() const
 
 //------------------------------------------------------------------------------
 /**
+    The HttpServer reads the status while a handler on another thread may
+    still be writing the content, to decide if the response can be streamed.
 */
 inline void
 HttpRequest::SetStatus(HttpStatus::Code s)
 {
-    this->status = s;
+    this->status.store(s, std::memory_order_release);
 }
 
 //------------------------------------------------------------------------------
@@ -122,7 +128,7 @@ HttpRequest::SetStatus(HttpStatus::Code s)
 inline HttpStatus::Code
 HttpRequest::GetStatus() const
 {
-    return this->status;
+    return this->status.load(std::memory_order_acquire);
 }
 
 } // namespace Http
@@ -5,6 +5,7 @@
 //------------------------------------------------------------------------------
 
 #include "http/httprequesthandler.h"
+#include "threading/interlocked.h"
 
 namespace Http
 {
@@ -12,11 +13,14 @@ __ImplementClass(Http::HttpRequestHandler, 'HRHD', Core::RefCounted);
 
 using namespace IO;
 using namespace Util;
+using namespace Threading;
 
 //------------------------------------------------------------------------------
 /**
 */
-HttpRequestHandler::HttpRequestHandler()
+HttpRequestHandler::HttpRequestHandler() :
+    pendingRequests(nullptr),
+    isThreadSafe(false)
 {
     // empty
 }
@@ -26,37 +30,66 @@ HttpRequestHandler::HttpRequestHandler()
 */
 HttpRequestHandler::~HttpRequestHandler()
 {
-    this->pendingRequests.SetSignalOnEnqueueEnabled(false);
-    // empty
+    // release requests which were never handled
+    HttpRequest* request = (HttpRequest*)Interlocked::ExchangePointer((void* volatile*)&this->pendingRequests, nullptr);
+    while (nullptr != request)
+    {
+        HttpRequest* next = request->nextPending;
+        request->nextPending = nullptr;
+        request->Release();
+        request = next;
+    }
 }
 
 //------------------------------------------------------------------------------
 /**
-    Put a http request into the request handlers message queue. This method
-    is meant to be called from another thread.
+    Put a http request into the request handlers pending list. This method
+    is meant to be called from another thread. The list holds a reference
+    to the request until it has been handled.
 */
 void
 HttpRequestHandler::PutRequest(const Ptr<HttpRequest>& httpRequest)
 {
-    this->pendingRequests.Enqueue(httpRequest);
+    HttpRequest* request = httpRequest.get();
+    request->AddRef();
+    HttpRequest* head;
+    do
+    {
+        head = this->pendingRequests;
+        request->nextPending = head;
+    }
+    while (Interlocked::CompareExchangePointer((void* volatile*)&this->pendingRequests, request, head) != head);
 }
 
 //------------------------------------------------------------------------------
 /**
-    Handle all pending http requests in the pending queue. This method
+    Handle all pending http requests in the pending list. This method
     must be called frequently from the thread which created this
-    request handler.
+    request handler. The whole list is taken with a single exchange, so
+    the http server thread never waits for this thread.
 */
 void
 HttpRequestHandler::HandlePendingRequests()
 {
-    this->curWorkRequests.Reserve(this->pendingRequests.Size());
-    this->pendingRequests.DequeueAll(this->curWorkRequests);
-    IndexT i;
-    for (i = 0; i < this->curWorkRequests.Size(); i++)
+    HttpRequest* list = (HttpRequest*)Interlocked::ExchangePointer((void* volatile*)&this->pendingRequests, nullptr);
+
+    // requests are pushed to the front, reverse to handle them in arrival order
+    HttpRequest* request = nullptr;
+    while (nullptr != list)
+    {
+        HttpRequest* next = list->nextPending;
+        list->nextPending = request;
+        request = list;
+        list = next;
+    }
+    while (nullptr != request)
     {
-        this->HandleRequest(this->curWorkRequests[i]);
-        this->curWorkRequests[i]->SetHandled(true);
+        HttpRequest* next = request->nextPending;
+        request->nextPending = nullptr;
+        this->HandleRequest(request);
+        request->SetHandled(true);
+        request->Release();
+        request = next;
     }
 }
 
@@ -12,7 +12,14 @@
     its HandleRequest() method will be called with a pointer to a content
     stream. The request handler is expected to write the response to the
     content stream (IMPORTANT: don't forget to set the MediaType on the stream!)
-    and return with a HttpStatus code.
+    and return with a HttpStatus code. Large responses are only streamed
+    to the client while they are written if the status is set first.
+
+    By default requests are handed off to the thread which created the
+    handler through a lock-free list, and processed when that thread calls
+    HandlePendingRequests(). Handlers which only touch thread-safe state can
+    call SetThreadSafe(true), their requests are then processed by the
+    worker threads of the HttpServer without involving the owning thread.
 
     @copyright
     (C) 2007 Radon Labs GmbH
@@ -22,7 +29,6 @@
 #include "http/httprequest.h"
 
 #include "util/string.h"
-#include "threading/safequeue.h"
 
 //------------------------------------------------------------------------------
 namespace Http
@@ -42,6 +48,8 @@ public:
     const Util::String& GetDesc() const;
     /// get a resource location path which is accepted by the handler (e.g. "/display")
     const Util::String& GetRootLocation() const;
+    /// return true if requests may be handled on the http server's worker threads
+    bool IsThreadSafe() const;
 
 protected:
     friend class HttpServer;
@@ -59,12 +67,14 @@ protected:
     void SetDesc(const Util::String& d);
     /// set the root location of the request handler
     void SetRootLocation(const Util::String& l);
+    /// allow requests to be handled on the http server's worker threads
+    void SetThreadSafe(bool b);
 
     Util::String name;
     Util::String desc;
     Util::String rootLocation;
-    Threading::SafeQueue<Ptr<HttpRequest> > pendingRequests;
-    Util::Array<Ptr<HttpRequest> > curWorkRequests;
+    HttpRequest* volatile pendingRequests;
+    bool isThreadSafe;
 };
 
 //------------------------------------------------------------------------------
@@ -121,6 +131,24 @@ HttpRequestHandler::GetRootLocation() const
     return this->rootLocation;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+HttpRequestHandler::SetThreadSafe(bool b)
+{
+    this->isThreadSafe = b;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+HttpRequestHandler::IsThreadSafe() const
+{
+    return this->isThreadSafe;
+}
+
 } // namespace Http
 //------------------------------------------------------------------------------
 #endif
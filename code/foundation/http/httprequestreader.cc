@@ -19,6 +19,9 @@ using namespace IO;
 */
 HttpRequestReader::HttpRequestReader() :
     isValidHttpRequest(false),
+    isIncomplete(false),
+    isHttp11(false),
+    isKeepAlive(false),
     httpMethod(HttpMethod::InvalidHttpMethod)
 {
     // empty
@@ -26,11 +29,37 @@ HttpRequestReader::HttpRequestReader() :
 
 //------------------------------------------------------------------------------
 /**
+    Reads one line of the request header, returns false if the received
+    data ends before the line does.
+*/
+static bool
+ReadHeaderLine(const Ptr<TextReader>& textReader, const Ptr<Stream>& stream, String& outLine)
+{
+    const Stream::Position start = stream->GetPosition();
+    outLine = textReader->ReadLine();
+
+    // ReadLine() drops the newline, so a complete line moved the stream one byte further
+    if ((stream->GetPosition() - start) <= outLine.Length())
+    {
+        return false;
+    }
+    outLine.TrimRight("\r");
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Requests may arrive in several pieces. If the stream ends before the
+    header or the content announced by it is complete, the stream is put
+    back to where the request starts and IsIncomplete() returns true, so
+    the caller can try again once more data has been received.
 */
 bool
 HttpRequestReader::ReadRequest()
 {
     this->isValidHttpRequest = false;
+    this->isIncomplete = false;
+    const Stream::Position requestStart = this->stream->GetPosition();
         
     // attach a text reader to our stream and parse the request header
     Ptr<TextReader> textReader = TextReader::Create();
@@ -39,7 +68,14 @@ HttpRequestReader::ReadRequest()
     {
         // read the first line of the request
         // should be "METHOD PATH HTTP/1.1[CRLF]
-        String headLine =  textReader->ReadLine();
+        String headLine;
+        if (!ReadHeaderLine(textReader, this->stream, headLine))
+        {
+            this->isIncomplete = true;
+            this->stream->Seek(requestStart, Stream::Begin);
+            textReader->Close();
+            return false;
+        }
         Array<String> headTokens = headLine.Tokenize(" ");
         if (headTokens.Size() != 3)
         {
@@ -56,27 +92,89 @@ HttpRequestReader::ReadRequest()
             return false;
         }
 
+        // HTTP/1.1 connections stay open unless the client asks otherwise, HTTP/1.0 the other way around
+        this->isHttp11 = (headTokens[2] == "HTTP/1.1");
+        this->isKeepAlive = this->isHttp11;
+
         // decode the HTTP method
         this->httpMethod = HttpMethod::FromString(headTokens[0]);
 
-        // decode the remaining request header lines
+        // decode the remaining request header lines, the header ends with an empty line, further requests may follow it
         String host;
+        SizeT contentLength = 0;
         bool endOfHeader = false;
-        while (!textReader->Eof() && !endOfHeader)
+        while (!endOfHeader)
         {
-            String curLine = textReader->ReadLine();
-            if (curLine.IsValid())
+            String curLine;
+            if (!ReadHeaderLine(textReader, this->stream, curLine))
+            {
+                this->isIncomplete = true;
+                this->stream->Seek(requestStart, Stream::Begin);
+                textReader->Close();
+                return false;
+            }
+            if (curLine.IsEmpty())
             {
-                if (String::MatchPattern(curLine, "Host: *"))
+                endOfHeader = true;
+                continue;
+            }
+
+            // header names are case-insensitive, lines without a colon are ignored
+            IndexT colonIndex = curLine.FindCharIndex(':');
+            if (InvalidIndex == colonIndex)
+            {
+                continue;
+            }
+            String name = curLine.ExtractRange(0, colonIndex);
+            name.Trim(" \t");
+            name.ToLower();
+            String value = curLine.ExtractToEnd(colonIndex + 1);
+            value.Trim(" \t");
+            if (name == "host")
+            {
+                host = value;
+            }
+            else if (name == "connection")
+            {
+                // may be a list of options
+                value.ToLower();
+                Array<String> options = value.Tokenize(", \t");
+                IndexT i;
+                for (i = 0; i < options.Size(); i++)
                 {
-                    host = curLine;
-                    host.SubstituteString("Host: ", "");
+                    if (options[i] == "close")
+                    {
+                        this->isKeepAlive = false;
+                    }
+                    else if (options[i] == "keep-alive")
+                    {
+                        this->isKeepAlive = true;
+                    }
                 }
             }
-            else
+            else if (name == "content-length")
             {
-                endOfHeader = true;
+                contentLength = value.AsInt();
+                if (contentLength < 0)
+                {
+                    // malformed request header
+                    textReader->Close();
+                    return false;
+                }
+            }
+        }
+
+        // the content isn't used, skip it to get to the next request once all of it has arrived
+        if (contentLength > 0)
+        {
+            if (this->stream->GetPosition() + contentLength > this->stream->GetSize())
+            {
+                this->isIncomplete = true;
+                this->stream->Seek(requestStart, Stream::Begin);
+                textReader->Close();
+                return false;
             }
+            this->stream->Seek(contentLength, Stream::Current);
         }
 
         // build URI
@@ -28,13 +28,22 @@ public:
     bool ReadRequest();
     /// return true if the stream contains a valid HTTP request 
     bool IsValidHttpRequest() const;
+    /// return true if the stream ended before the request did, the stream is left at the start of the request
+    bool IsIncomplete() const;
     /// get HTTP request method
     HttpMethod::Code GetHttpMethod() const;
     /// get request URI
     const IO::URI& GetRequestURI() const;
+    /// return true if the request was made with HTTP/1.1 (which allows chunked responses)
+    bool IsHttp11() const;
+    /// return true if the client wants the connection to stay open after the response
+    bool IsKeepAlive() const;
 
 private:
     bool isValidHttpRequest;
+    bool isIncomplete;
+    bool isHttp11;
+    bool isKeepAlive;
     HttpMethod::Code httpMethod;
     IO::URI requestURI;
 };
@@ -48,6 +57,15 @@ HttpRequestReader::IsValidHttpRequest() const
     return this->isValidHttpRequest;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+HttpRequestReader::IsIncomplete() const
+{
+    return this->isIncomplete;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -66,6 +84,24 @@ HttpRequestReader::GetRequestURI() const
     return this->requestURI;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+HttpRequestReader::IsHttp11() const
+{
+    return this->isHttp11;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+HttpRequestReader::IsKeepAlive() const
+{
+    return this->isKeepAlive;
+}
+
 } // namespace Http
 //------------------------------------------------------------------------------
 #endif
@@ -13,6 +13,16 @@ __ImplementClass(Http::HttpResponseWriter, 'HRSW', IO::StreamWriter);
 
 using namespace IO;
 
+//------------------------------------------------------------------------------
+/**
+*/
+HttpResponseWriter::HttpResponseWriter() :
+    statusCode(HttpStatus::InvalidHttpStatus),
+    keepAlive(true)
+{
+    // empty
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -40,6 +50,7 @@ HttpResponseWriter::WriteResponse()
         {
             textWriter->WriteString("Content-Length: 0\r\n");
         }
+        textWriter->WriteString(this->keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
         textWriter->WriteString("\r\n");
         textWriter->Close();
     }
@@ -59,4 +70,54 @@ HttpResponseWriter::WriteResponse()
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpResponseWriter::WriteChunkedResponseHeader()
+{
+    Ptr<TextWriter> textWriter = TextWriter::Create();
+    textWriter->SetStream(this->stream);
+    if (textWriter->Open())
+    {
+        textWriter->WriteFormatted("HTTP/1.1 %s %s\r\n",
+            HttpStatus::ToString(this->statusCode).AsCharPtr(),
+            HttpStatus::ToHumanReadableString(this->statusCode).AsCharPtr());
+        textWriter->WriteString("Transfer-Encoding: chunked\r\n");
+        if (this->contentStream.isvalid() && this->contentStream->GetMediaType().AsString().IsValid())
+        {
+            textWriter->WriteFormatted("Content-Type: %s\r\n",
+                this->contentStream->GetMediaType().AsString().AsCharPtr());
+        }
+        textWriter->WriteString(this->keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+        textWriter->WriteString("\r\n");
+        textWriter->Close();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpResponseWriter::WriteChunk(const void* ptr, SizeT size)
+{
+    if (size > 0)
+    {
+        char sizeLine[16];
+        int len = snprintf(sizeLine, sizeof(sizeLine), "%x\r\n", size);
+        this->stream->Write(sizeLine, len);
+        this->stream->Write(ptr, size);
+        this->stream->Write("\r\n", 2);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpResponseWriter::WriteLastChunk()
+{
+    this->stream->Write("0\r\n\r\n", 5);
+}
+
 } // namespace Http
\ No newline at end of file
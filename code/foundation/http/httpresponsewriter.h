@@ -21,16 +21,27 @@ class HttpResponseWriter : public IO::StreamWriter
 {
     __DeclareClass(HttpResponseWriter);
 public:
+    /// constructor
+    HttpResponseWriter();
     /// set status code
     void SetStatusCode(HttpStatus::Code statusCode);
     /// set optional content stream (needs valid media type!)
     void SetContent(const Ptr<IO::Stream>& contentStream);
+    /// set whether the connection stays open after the response, default is true
+    void SetKeepAlive(bool b);
     /// write http response to the stream
     void WriteResponse();
+    /// write the header of a chunked response, the media type is taken from the content stream
+    void WriteChunkedResponseHeader();
+    /// write a chunk of a chunked response
+    void WriteChunk(const void* ptr, SizeT size);
+    /// write the terminating chunk of a chunked response
+    void WriteLastChunk();
 
 private:
     HttpStatus::Code statusCode;
     Ptr<IO::Stream> contentStream;
+    bool keepAlive;
 };
 
 //------------------------------------------------------------------------------
@@ -51,6 +62,15 @@ HttpResponseWriter::SetContent(const Ptr<IO::Stream>& s)
     this->contentStream = s;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+HttpResponseWriter::SetKeepAlive(bool b)
+{
+    this->keepAlive = b;
+}
+
 }
 //------------------------------------------------------------------------------
 #endif
@@ -5,22 +5,25 @@
 //------------------------------------------------------------------------------
 
 #include "http/httpserver.h"
-#include "http/httprequestreader.h"
 #include "io/memorystream.h"
 
 namespace Http
 {
 __ImplementClass(Http::HttpServer, 'HTPS', Core::RefCounted);
 __ImplementSingleton(Http::HttpServer);
+__ImplementClass(Http::HttpServer::WorkerThread, 'HSWT', Threading::Thread);
 
 using namespace Util;
 using namespace Net;
 using namespace IO;
+using namespace Threading;
 
 //------------------------------------------------------------------------------
 /**
 */
 HttpServer::HttpServer() :
+    numWorkerThreads(2),
+    chunkSize(64 * 1024),
     isOpen(false),
     isSingleThreadMode(false)
 {
@@ -52,6 +55,19 @@ HttpServer::Open()
     this->tcpServer->SetAddress(this->ipAddress);
     bool success = this->tcpServer->Open();
 
+    // start the workers for thread-safe request handlers
+    if (!this->isSingleThreadMode)
+    {
+        this->workerThreads.Resize(this->numWorkerThreads);
+        IndexT i;
+        for (i = 0; i < this->workerThreads.Size(); i++)
+        {
+            this->workerThreads[i] = WorkerThread::Create();
+            this->workerThreads[i]->SetName(String::Sprintf("HttpServer::WorkerThread%d", i));
+            this->workerThreads[i]->Start();
+        }
+    }
+
     // create the default http request handler
     this->defaultRequestHandler = DefaultHttpRequestHandler::Create();
     return success;
@@ -65,6 +81,14 @@ HttpServer::Close()
 {
     n_assert(this->isOpen);
 
+    // stop the worker threads, requests they didn't handle yet are dropped
+    IndexT i;
+    for (i = 0; i < this->workerThreads.Size(); i++)
+    {
+        this->workerThreads[i]->Stop();
+    }
+    this->workerThreads.Clear();
+
     // clear pending requests
     this->pendingRequests.Clear();
 
@@ -75,7 +99,10 @@ HttpServer::Close()
     this->requestHandlers.Clear();
 
     // shutdown TcpServer
-    this->tcpServer->Close();
+    if (this->tcpServer->IsOpen())
+    {
+        this->tcpServer->Close();
+    }
     this->tcpServer = nullptr;
     this->isOpen = false;
 }
@@ -111,28 +138,24 @@ HttpServer::OnFrame()
 {
     n_assert(this->isOpen);
 
-    // handle pending client requests
-    Array<Ptr<TcpClientConnection> > recvConns = this->tcpServer->Recv();
+    // handle pending client requests, only connections which received data are returned
+    const Array<Ptr<TcpClientConnection> >& recvConns = this->tcpServer->Recv();
     IndexT i;
     for (i = 0; i < recvConns.Size(); i++)
     {
-        if (!this->HandleHttpRequest(recvConns[i]))
+        if (!this->HandleHttpRequests(recvConns[i]))
         {
-            recvConns[i]->Shutdown();
+            // responses to earlier requests may still be queued
+            recvConns[i]->ShutdownWhenSent();
         }
     }
 
-    // handle processed http requests
+    // send responses of processed http requests, and stream the parts
+    // of responses which are still being written
     for (i = 0; i < this->pendingRequests.Size();)
     {
-        const Ptr<HttpRequest>& httpRequest = this->pendingRequests[i].httpRequest;
-        if (httpRequest->Handled())
+        if (this->SendResponse(i))
         {
-            const Ptr<TcpClientConnection>& conn = this->pendingRequests[i].clientConnection;
-            if (this->BuildHttpResponse(conn, httpRequest))
-            {
-                conn->Send();
-            }
             this->pendingRequests.EraseIndex(i);
         }
         else
@@ -144,95 +167,273 @@ HttpServer::OnFrame()
 
 //------------------------------------------------------------------------------
 /**
+    Once a response grew beyond the chunk size while its handler is still
+    writing, the response header is sent with chunked transfer encoding and
+    the content follows chunk by chunk. Since the header goes out before the
+    handler finished, streaming only starts once the handler has set the
+    status, so handlers which want their pages streamed set it before
+    writing the content. Otherwise the chunks are kept until the handler
+    is done.
 */
 bool
-HttpServer::HandleHttpRequest(const Ptr<TcpClientConnection>& clientConnection)  
+HttpServer::SendResponse(IndexT pendingIndex)
 {
-    // decode the request
-    Ptr<HttpRequestReader> httpRequestReader = HttpRequestReader::Create();
-    httpRequestReader->SetStream(clientConnection->GetRecvStream());
-    if (httpRequestReader->Open())
+    const PendingRequest& pendingRequest = this->pendingRequests[pendingIndex];
+    const Ptr<TcpClientConnection>& conn = pendingRequest.clientConnection;
+
+    // responses on a kept-alive connection have to go out in request order
+    IndexT i;
+    for (i = 0; i < pendingIndex; i++)
     {
-        httpRequestReader->ReadRequest();
-        httpRequestReader->Close();
+        if (this->pendingRequests[i].clientConnection == conn)
+        {
+            return false;
+        }
     }
-    if (httpRequestReader->IsValidHttpRequest())
+
+    // the connection has been closed in the meantime, drop the response
+    if (!conn->GetSendStream().isvalid())
     {
-        URI requestURI = httpRequestReader->GetRequestURI();
-    
-        // create a content stream for the response
-        Ptr<MemoryStream> responseContentStream = MemoryStream::Create();
-        
-        // build a HttpRequest object
-        Ptr<HttpRequest> httpRequest = HttpRequest::Create();
-        httpRequest->SetMethod(httpRequestReader->GetHttpMethod());
-        httpRequest->SetURI(httpRequestReader->GetRequestURI());
-        httpRequest->SetResponseContentStream(responseContentStream.upcast<Stream>());
-        httpRequest->SetStatus(HttpStatus::NotFound);
+        return true;
+    }
 
-        // find a request handler which accepts the request
-        Ptr<HttpRequestHandler> requestHandler;
-        Array<String> tokens = requestURI.LocalPath().Tokenize("/");
-        if (tokens.Size() > 0)
+    // check the handled flag before taking the chunks, all chunks are handed off before the flag is set,
+    // and the flag is published with release/acquire ordering, so once it is seen whatever the handler
+    // wrote on its own thread, the status and the rest of the content, can be read here
+    const Ptr<HttpRequest>& httpRequest = pendingRequest.httpRequest;
+    bool handled = httpRequest->Handled();
+    if (handled && (HttpStatus::InvalidHttpStatus == httpRequest->GetStatus()))
+    {
+        // the handler didn't set a status
+        httpRequest->SetStatus(HttpStatus::NotFound);
+    }
+    if (!pendingRequest.isChunked)
+    {
+        if (!pendingRequest.contentStream->HasChunks())
         {
-            if (this->requestHandlers.Contains(tokens[0]))
+            if (!handled)
             {
-                requestHandler = this->requestHandlers[tokens[0]];
+                return false;
             }
-        }
-        if (requestHandler.isvalid())
-        {
-            // handle the request, default is asynchronous handling 
-            // (request is added to request handler with PutRequest()
-            // and processed when the thread where the request handler
-            // lives calls HandlePendingRequests()
-            // in SingleThread mode, the request will be processed immediately,
-            // but this is a death-receipt if request handlers live on
-            // different threads!!!
-            if (this->IsSingleThreadMode())
+            if (this->BuildHttpResponse(conn, pendingRequest))
+            {
+                conn->Send();
+            }
+            if (!pendingRequest.keepAlive)
             {
-                // handle request immediately
-                requestHandler->HandleRequest(httpRequest);
-                httpRequest->SetHandled(true);
+                conn->ShutdownWhenSent();
             }
-            else
+            return true;
+        }
+        if (!handled && (HttpStatus::InvalidHttpStatus == httpRequest->GetStatus()))
+        {
+            // wait for the handler to decide on the status
+            return false;
+        }
+    }
+
+    Ptr<HttpResponseWriter> responseWriter = HttpResponseWriter::Create();
+    responseWriter->SetStream(conn->GetSendStream());
+    responseWriter->SetStatusCode(httpRequest->GetStatus());
+    responseWriter->SetContent(pendingRequest.contentStream.upcast<Stream>());
+    responseWriter->SetKeepAlive(pendingRequest.keepAlive);
+    if (responseWriter->Open())
+    {
+        if (!pendingRequest.isChunked)
+        {
+            responseWriter->WriteChunkedResponseHeader();
+            this->pendingRequests[pendingIndex].isChunked = true;
+        }
+
+        HttpChunkStream::Chunk* chunks = pendingRequest.contentStream->DequeueChunks();
+        HttpChunkStream::Chunk* chunk;
+        for (chunk = chunks; nullptr != chunk; chunk = chunk->next)
+        {
+            responseWriter->WriteChunk(chunk->Data(), chunk->size);
+        }
+        HttpChunkStream::FreeChunks(chunks);
+
+        if (handled)
+        {
+            // the rest which didn't fill a complete chunk
+            const Ptr<HttpChunkStream>& content = pendingRequest.contentStream;
+            content->SetAccessMode(Stream::ReadAccess);
+            if ((content->GetSize() > 0) && content->Open())
             {
-                // asynchronously handle the request
-                requestHandler->PutRequest(httpRequest);
+                responseWriter->WriteChunk(content->Map(), (SizeT)content->GetSize());
+                content->Unmap();
+                content->Close();
             }
+            responseWriter->WriteLastChunk();
+        }
+        responseWriter->Close();
+        conn->Send();
+    }
+
+    if (handled && !pendingRequest.keepAlive)
+    {
+        conn->ShutdownWhenSent();
+    }
+    return handled;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Clients may send several requests without waiting for the responses,
+    so the parser runs until all received data is consumed. The responses
+    go out in request order, see SendResponse(). A request which hasn't
+    fully arrived yet stays in the connection's receive stream, and is
+    parsed again once the rest has been received.
+*/
+bool
+HttpServer::HandleHttpRequests(const Ptr<TcpClientConnection>& clientConnection)
+{
+    const Ptr<Stream>& recvStream = clientConnection->GetRecvStream();
+    recvStream->SetAccessMode(Stream::ReadAccess);
+    if (!recvStream->Open())
+    {
+        return false;
+    }
+    bool validRequests = true;
+    bool incomplete = false;
+    bool keepAlive = true;
+    do
+    {
+        // decode the next request, the reader leaves the stream positioned behind it
+        Ptr<HttpRequestReader> httpRequestReader = HttpRequestReader::Create();
+        httpRequestReader->SetStream(recvStream);
+        if (httpRequestReader->Open())
+        {
+            httpRequestReader->ReadRequest();
+            httpRequestReader->Close();
+        }
+        if (httpRequestReader->IsValidHttpRequest())
+        {
+            this->HandleHttpRequest(clientConnection, httpRequestReader);
+            keepAlive = httpRequestReader->IsKeepAlive();
+        }
+        else if (httpRequestReader->IsIncomplete())
+        {
+            // wait for the rest of the request
+            incomplete = true;
         }
         else
         {
-            // no request handler accepts the request, let the default
-            // request handler handle the request
-            this->defaultRequestHandler->HandleRequest(httpRequest);
-            httpRequest->SetHandled(true);
+            // the received data was not a valid HTTP request
+            validRequests = false;
         }
+    }
+    while (validRequests && !incomplete && keepAlive && !recvStream->Eof());
+    const Stream::Position requestStart = recvStream->GetPosition();
+    const Stream::Size pendingSize = recvStream->GetSize() - requestStart;
+    recvStream->Close();
+    if (incomplete)
+    {
+        // a client which never completes its request can't make the server buffer without bounds
+        if (pendingSize > MaxPendingRequestSize)
+        {
+            return false;
+        }
+        clientConnection->KeepRecvData(requestStart);
+    }
+    return validRequests;
+}
 
-        // append request to pending queue
-        PendingRequest pendingRequest;
-        pendingRequest.clientConnection = clientConnection;
-        pendingRequest.httpRequest = httpRequest;
-        this->pendingRequests.Append(pendingRequest);
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpServer::HandleHttpRequest(const Ptr<TcpClientConnection>& clientConnection, const Ptr<HttpRequestReader>& httpRequestReader)
+{
+    URI requestURI = httpRequestReader->GetRequestURI();
 
-        return true;
+    // create a content stream for the response, only HTTP/1.1 clients understand chunked responses
+    Ptr<HttpChunkStream> responseContentStream = HttpChunkStream::Create();
+    if (httpRequestReader->IsHttp11())
+    {
+        responseContentStream->SetChunkSize(this->chunkSize);
+    }
+    
+    // build a HttpRequest object
+    Ptr<HttpRequest> httpRequest = HttpRequest::Create();
+    httpRequest->SetMethod(httpRequestReader->GetHttpMethod());
+    httpRequest->SetURI(httpRequestReader->GetRequestURI());
+    httpRequest->SetResponseContentStream(responseContentStream.upcast<Stream>());
+
+    // find a request handler which accepts the request
+    Ptr<HttpRequestHandler> requestHandler;
+    Array<String> tokens = requestURI.LocalPath().Tokenize("/");
+    if (tokens.Size() > 0)
+    {
+        if (this->requestHandlers.Contains(tokens[0]))
+        {
+            requestHandler = this->requestHandlers[tokens[0]];
+        }
+    }
+    if (requestHandler.isvalid())
+    {
+        // handle the request, default is asynchronous handling 
+        // (request is added to request handler with PutRequest()
+        // and processed when the thread where the request handler
+        // lives calls HandlePendingRequests()
+        // in SingleThread mode, the request will be processed immediately,
+        // but this is a death-receipt if request handlers live on
+        // different threads!!!
+        if (this->IsSingleThreadMode())
+        {
+            // handle request immediately
+            requestHandler->HandleRequest(httpRequest);
+            httpRequest->SetHandled(true);
+        }
+        else if (requestHandler->IsThreadSafe() && (this->workerThreads.Size() > 0))
+        {
+            // hand the request to the least busy worker thread
+            IndexT workerIndex = 0;
+            IndexT i;
+            for (i = 1; i < this->workerThreads.Size(); i++)
+            {
+                if (this->workerThreads[i]->GetNumPendingRequests() < this->workerThreads[workerIndex]->GetNumPendingRequests())
+                {
+                    workerIndex = i;
+                }
+            }
+            this->workerThreads[workerIndex]->PutRequest({ requestHandler, httpRequest });
+        }
+        else
+        {
+            // asynchronously handle the request
+            requestHandler->PutRequest(httpRequest);
+        }
     }
     else
     {
-        // the received data was not a valid HTTP request
-        return false;
+        // no request handler accepts the request, let the default
+        // request handler handle the request
+        this->defaultRequestHandler->HandleRequest(httpRequest);
+        httpRequest->SetHandled(true);
     }
+
+    // append request to pending queue
+    PendingRequest pendingRequest;
+    pendingRequest.clientConnection = clientConnection;
+    pendingRequest.httpRequest = httpRequest;
+    pendingRequest.contentStream = responseContentStream;
+    pendingRequest.keepAlive = httpRequestReader->IsKeepAlive();
+    pendingRequest.isChunked = false;
+    this->pendingRequests.Append(pendingRequest);
 }
 
 //------------------------------------------------------------------------------
 /**
 */
 bool
-HttpServer::BuildHttpResponse(const Ptr<TcpClientConnection>& conn, const Ptr<HttpRequest>& httpRequest)
+HttpServer::BuildHttpResponse(const Ptr<TcpClientConnection>& conn, const PendingRequest& pendingRequest)
 {
+    const Ptr<HttpRequest>& httpRequest = pendingRequest.httpRequest;
     Ptr<HttpResponseWriter> responseWriter = HttpResponseWriter::Create();
     responseWriter->SetStream(conn->GetSendStream());
     responseWriter->SetStatusCode(httpRequest->GetStatus());
+    responseWriter->SetKeepAlive(pendingRequest.keepAlive);
     if (HttpStatus::OK != httpRequest->GetStatus())
     {
         // an error occured, need to write an error message to the response stream
@@ -259,5 +460,64 @@ HttpServer::BuildHttpResponse(const Ptr<TcpClientConnection>& conn, const Ptr<Ht
     return false;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+HttpServer::WorkerThread::WorkerThread() :
+    numPendingRequests(0)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpServer::WorkerThread::PutRequest(const WorkItem& item)
+{
+    Interlocked::Increment(&this->numPendingRequests);
+    this->workQueue.Enqueue(item);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+int
+HttpServer::WorkerThread::GetNumPendingRequests() const
+{
+    return this->numPendingRequests;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpServer::WorkerThread::DoWork()
+{
+    while (!this->ThreadStopRequested())
+    {
+        this->workQueue.Wait();
+        this->workQueue.DequeueAll(this->curWorkItems);
+        IndexT i;
+        for (i = 0; i < this->curWorkItems.Size(); i++)
+        {
+            const WorkItem& item = this->curWorkItems[i];
+            item.requestHandler->HandleRequest(item.httpRequest);
+            item.httpRequest->SetHandled(true);
+            Interlocked::Decrement(&this->numPendingRequests);
+        }
+        this->curWorkItems.Clear();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpServer::WorkerThread::EmitWakeupSignal()
+{
+    this->workQueue.Signal();
+}
+
 } // namespace Http
 
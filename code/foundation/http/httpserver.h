@@ -9,6 +9,13 @@
     HttpRequestHandlers. Can be used to serve debug information about the 
     Nebula application to web browsers.
 
+    Requests for handlers which declared themselves thread-safe are processed
+    by a small pool of worker threads owned by the server, all other requests
+    are handed to the thread which created the handler. Connections are kept
+    alive as requested by the client, and responses to HTTP/1.1 requests which
+    grow beyond the chunk size are streamed with chunked transfer encoding
+    while the handler is still writing them.
+
     @copyright
     (C) 2007 Radon Labs GmbH
     (C) 2013-2020 Individual contributors, see AUTHORS file
@@ -21,6 +28,11 @@
 #include "http/httpresponsewriter.h"
 #include "http/httprequesthandler.h"
 #include "http/defaulthttprequesthandler.h"
+#include "http/httpchunkstream.h"
+#include "http/httprequestreader.h"
+#include "threading/thread.h"
+#include "threading/safequeue.h"
+#include "util/fixedarray.h"
 
 //------------------------------------------------------------------------------
 namespace Http
@@ -43,6 +55,14 @@ public:
     void SetSingleThreadMode(bool b);
     /// get single-thread mode
     bool IsSingleThreadMode() const;
+    /// set number of worker threads for thread-safe request handlers, default is 2
+    void SetNumWorkerThreads(SizeT num);
+    /// get number of worker threads
+    SizeT GetNumWorkerThreads() const;
+    /// set the response size at which streaming with chunked transfer encoding starts, 0 disables streaming
+    void SetChunkSize(SizeT size);
+    /// get the chunk size
+    SizeT GetChunkSize() const;
     /// open the http server
     bool Open();
     /// close the http server
@@ -59,22 +79,63 @@ public:
     void OnFrame();
 
 private:
-    /// handle an HttpRequest
-    bool HandleHttpRequest(const Ptr<Net::TcpClientConnection>& clientConnection);
-    /// build an HttpResponse for a handled http request
-    bool BuildHttpResponse(const Ptr<Net::TcpClientConnection>& clientConnection, const Ptr<HttpRequest>& httpRequest);
-
     struct PendingRequest
     {
         Ptr<Net::TcpClientConnection> clientConnection;
         Ptr<HttpRequest> httpRequest;
+        Ptr<HttpChunkStream> contentStream;
+        bool keepAlive;
+        bool isChunked;
+    };
+
+    struct WorkItem
+    {
+        Ptr<HttpRequestHandler> requestHandler;
+        Ptr<HttpRequest> httpRequest;
+    };
+
+    /// a worker thread handling requests for thread-safe request handlers
+    class WorkerThread : public Threading::Thread
+    {
+        __DeclareClass(WorkerThread);
+    public:
+        /// constructor
+        WorkerThread();
+        /// queue a request for handling
+        void PutRequest(const WorkItem& item);
+        /// get number of queued requests which are not handled yet
+        int GetNumPendingRequests() const;
+    private:
+        /// handle queued requests until the thread is stopped
+        virtual void DoWork();
+        /// wake up the thread
+        virtual void EmitWakeupSignal();
+
+        Threading::SafeQueue<WorkItem> workQueue;
+        Util::Array<WorkItem> curWorkItems;
+        volatile int numPendingRequests;
     };
 
+    /// decode and handle all requests received on a connection, returns false on a malformed request
+    bool HandleHttpRequests(const Ptr<Net::TcpClientConnection>& clientConnection);
+    /// handle the request decoded by the request reader
+    void HandleHttpRequest(const Ptr<Net::TcpClientConnection>& clientConnection, const Ptr<HttpRequestReader>& httpRequestReader);
+    /// build an HttpResponse for a handled http request
+    bool BuildHttpResponse(const Ptr<Net::TcpClientConnection>& clientConnection, const PendingRequest& pendingRequest);
+    /// send the response, or the streamed parts of it which are ready, returns true when the response is complete
+    bool SendResponse(IndexT pendingIndex);
+
+    /// the largest part of a request the server waits to be completed
+    static const SizeT MaxPendingRequestSize = 1024 * 1024;
+
     Util::Dictionary<Util::String, Ptr<HttpRequestHandler> > requestHandlers;
     Ptr<DefaultHttpRequestHandler> defaultRequestHandler;    
     Net::IpAddress ipAddress;
     Ptr<Net::TcpServer> tcpServer;
     Util::Array<PendingRequest> pendingRequests;
+    Util::FixedArray<Ptr<WorkerThread> > workerThreads;
+    SizeT numWorkerThreads;
+    SizeT chunkSize;
     bool isOpen;
     bool isSingleThreadMode;
 };
@@ -112,6 +173,45 @@ HttpServer::IsSingleThreadMode() const
     return this->isSingleThreadMode;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Requests for thread-safe handlers are processed by the worker threads,
+    with 0 workers they are handed to the handler's thread like all others.
+*/
+inline void
+HttpServer::SetNumWorkerThreads(SizeT num)
+{
+    n_assert(!this->isOpen);
+    this->numWorkerThreads = num;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+HttpServer::GetNumWorkerThreads() const
+{
+    return this->numWorkerThreads;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+HttpServer::SetChunkSize(SizeT size)
+{
+    this->chunkSize = size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+HttpServer::GetChunkSize() const
+{
+    return this->chunkSize;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
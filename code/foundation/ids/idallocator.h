@@ -10,10 +10,14 @@
     and fetching each value by providing the index into the list of types, which means the members
     are nameless. 
 
-    The thread safe allocator requires the Get-methods to be within an Enter/Leave
-    lockstep phase. 
+    The thread safe allocator requires the calling thread to own an element to
+    write to it, see Util::ArrayAllocatorSafe.
     
     @class Ids::IdAllocatorSafe
+
+    Freed elements are recycled through a lock-free free list, so only allocations
+    which grow the storage take a lock. Ids returned by Alloc() carry a generation,
+    so using an id after Dealloc() asserts.
     
     @see Ids::IdAllocator
 
@@ -111,44 +115,93 @@ class IdAllocatorSafe : public Util::ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>
 public:
     /// constructor
     IdAllocatorSafe()
+        : freeHead(FreeListEnd)
     {
     };
 
-    /// Allocate an object. 
+    /// Allocate an object, the calling thread owns it until it calls Release()
     uint32_t Alloc()
     {
         /// @note   This purposefully hides the default allocation method and should definitely not be virtual!
-        this->allocationLock.Lock();
         uint32_t index;
-        if (this->freeIds.Size() > 0)
+        if (this->PopFree(index))
         {
-            index = this->freeIds.Back();
+            // Nobody else knows about the element until we return the id, so just take it
             this->owners[index] = Threading::Thread::GetMyThreadId();
-            this->freeIds.EraseBack();
         }
         else
         {
-            alloc_for_each_in_tuple(this->objects);
-            index = this->size++;
-            this->owners.Append(Threading::Thread::GetMyThreadId());
-            n_assert2(MAX_ALLOCS > index, "max amount of allocations exceeded!\n");
+            this->allocationLock.Lock();
+            index = this->Grow();
+            this->nextFree.Append(FreeListEnd);
+            this->allocationLock.Unlock();
         }
-        this->allocationLock.Unlock();
-
-        return index;
+        return this->MakeId(index);
     }
 
-    /// Deallocate an object. Just places it in freeids array for recycling
-    void Dealloc(uint32_t index)
+    /// Deallocate an object, any other id to it is stale from here on
+    void Dealloc(uint32_t id)
     {
-        // TODO: We could possibly get better performance when defragging if we insert it in reverse order (high to low)
-        this->allocationLock.Lock();
-        this->freeIds.Append(index);
-        this->allocationLock.Unlock();
+        this->BumpGeneration(id);
+        this->PushFree(Util::ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::IdIndex(id));
     }
 
 private:
-    Util::Array<uint32_t> freeIds;
+    static constexpr uint32_t FreeListEnd = 0xFFFFFFFF;
+
+    /// pop an index from the free list, returns false if it's empty
+    bool PopFree(uint32_t& index);
+    /// push an index to the free list
+    void PushFree(const uint32_t index);
+
+    /// the lower 32 bits are the first free index, the upper 32 bits count the changes to the head against ABA
+    Threading::AtomicCounter64 freeHead;
+    Util::PinnedArray<MAX_ALLOCS, uint32_t> nextFree;
 };
 
+//------------------------------------------------------------------------------
+/**
+    The next index may already be stale when it's read, if another thread
+    pops the same element and pushes it back, but then the head has changed
+    its count and the exchange fails.
+*/
+template<int MAX_ALLOCS, class... TYPES>
+inline bool
+IdAllocatorSafe<MAX_ALLOCS, TYPES...>::PopFree(uint32_t& index)
+{
+    int64_t head = this->freeHead;
+    while ((uint32_t)head != FreeListEnd)
+    {
+        const uint32_t next = *(volatile uint32_t*)&this->nextFree[(uint32_t)head];
+        const int64_t newHead = (int64_t)(((uint64_t)head & 0xFFFFFFFF00000000ull) + (1ull << 32)) | next;
+        const int64_t previous = Threading::Interlocked::CompareExchange(&this->freeHead, newHead, head);
+        if (previous == head)
+        {
+            index = (uint32_t)head;
+            return true;
+        }
+        head = previous;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<int MAX_ALLOCS, class... TYPES>
+inline void
+IdAllocatorSafe<MAX_ALLOCS, TYPES...>::PushFree(const uint32_t index)
+{
+    int64_t head = this->freeHead;
+    while (true)
+    {
+        *(volatile uint32_t*)&this->nextFree[index] = (uint32_t)head;
+        const int64_t newHead = (int64_t)(((uint64_t)head & 0xFFFFFFFF00000000ull) + (1ull << 32)) | index;
+        const int64_t previous = Threading::Interlocked::CompareExchange(&this->freeHead, newHead, head);
+        if (previous == head)
+            return;
+        head = previous;
+    }
+}
+
 } // namespace Ids
@@ -5,6 +5,7 @@
 //------------------------------------------------------------------------------
 
 #include "io/binaryreader.h"
+#include "math/scalar.h"
 
 namespace IO
 {
@@ -19,8 +20,13 @@ using namespace System;
 BinaryReader::BinaryReader() :
     enableMapping(false),
     isMapped(false),
+    mapBegin(0),
     mapCursor(0),
-    mapEnd(0)
+    mapEnd(0),
+    readAheadBuffer(0),
+    readAheadSize(0),
+    bufferPos(0),
+    bufferFill(0)
 {
     // empty
 }
@@ -47,15 +53,23 @@ BinaryReader::Open()
         if (this->enableMapping && this->stream->CanBeMapped())
         {
             this->isMapped = true;
-            this->mapCursor = (unsigned char*) this->stream->Map();
+            this->mapBegin = (unsigned char*) this->stream->Map();
+            this->mapCursor = this->mapBegin;
             this->mapEnd = this->mapCursor + this->stream->GetSize();
         }
         else
         {
             this->isMapped = false;
+            this->mapBegin = 0;
             this->mapCursor = 0;
             this->mapEnd = 0;
+            if (this->readAheadSize > 0)
+            {
+                this->readAheadBuffer = (unsigned char*) Memory::Alloc(Memory::StreamDataHeap, this->readAheadSize);
+            }
         }
+        this->bufferPos = 0;
+        this->bufferFill = 0;
         return true;
     }
     return false;
@@ -67,69 +81,112 @@ BinaryReader::Open()
 void
 BinaryReader::Close()
 {
+    if (0 != this->readAheadBuffer)
+    {
+        // hand the bytes which were read ahead but not consumed back to the stream
+        SizeT unconsumed = this->bufferFill - this->bufferPos;
+        if ((unconsumed > 0) && this->stream->CanSeek())
+        {
+            this->stream->Seek(-unconsumed, Stream::Current);
+        }
+        Memory::Free(Memory::StreamDataHeap, this->readAheadBuffer);
+        this->readAheadBuffer = 0;
+    }
     StreamReader::Close();
     this->isMapped = false;
+    this->mapBegin = 0;
     this->mapCursor = 0;
     this->mapEnd = 0;
+    this->bufferPos = 0;
+    this->bufferFill = 0;
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-char
-BinaryReader::ReadChar()
+bool
+BinaryReader::Eof() const
 {
+    n_assert(this->IsOpen());
     if (this->isMapped)
     {
-        n_assert(this->mapCursor < this->mapEnd);
-        return *this->mapCursor++;
+        return this->mapCursor >= this->mapEnd;
     }
     else
     {
-        char c;
-        this->stream->Read(&c, sizeof(c));
-        return c;
+        return (this->bufferPos >= this->bufferFill) && this->stream->Eof();
     }
 }
 
 //------------------------------------------------------------------------------
 /**
+    Slow path of the reads, everything which doesn't fit into what's left of
+    the read-ahead buffer ends up here. Reads which are at least as large as
+    the buffer bypass it.
 */
-unsigned char
-BinaryReader::ReadUChar()
+void
+BinaryReader::ReadBytes(void* ptr, SizeT numBytes)
 {
     if (this->isMapped)
     {
-        n_assert(this->mapCursor < this->mapEnd);
-        return *this->mapCursor++;
+        n_assert((this->mapCursor + numBytes) <= this->mapEnd);
+        Memory::Copy(this->mapCursor, ptr, numBytes);
+        this->mapCursor += numBytes;
+    }
+    else if (0 == this->readAheadBuffer)
+    {
+        this->stream->Read(ptr, numBytes);
     }
     else
     {
-        unsigned char c;
-        this->stream->Read(&c, sizeof(c));
-        return c;
+        unsigned char* dst = (unsigned char*) ptr;
+        SizeT buffered = Math::min(numBytes, this->bufferFill - this->bufferPos);
+        Memory::Copy(this->readAheadBuffer + this->bufferPos, dst, buffered);
+        this->bufferPos += buffered;
+        dst += buffered;
+        numBytes -= buffered;
+
+        if (numBytes >= this->readAheadSize)
+        {
+            this->stream->Read(dst, numBytes);
+        }
+        else if (numBytes > 0)
+        {
+            this->bufferFill = (SizeT)this->stream->Read(this->readAheadBuffer, this->readAheadSize);
+            this->bufferPos = 0;
+            n_assert(numBytes <= this->bufferFill);
+            Memory::Copy(this->readAheadBuffer, dst, numBytes);
+            this->bufferPos = numBytes;
+        }
     }
 }
 
+
+//------------------------------------------------------------------------------
+/**
+*/
+char
+BinaryReader::ReadChar()
+{
+    return this->ReadValue<char>();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+unsigned char
+BinaryReader::ReadUChar()
+{
+    return this->ReadValue<unsigned char>();
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 short
 BinaryReader::ReadShort()
 {
-    short val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(short)) <= this->mapEnd);        
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
-    return this->byteOrder.Convert<short>(val);
+    return this->byteOrder.Convert<short>(this->ReadValue<short>());
 }
 
 //------------------------------------------------------------------------------
@@ -138,19 +195,7 @@ BinaryReader::ReadShort()
 unsigned short
 BinaryReader::ReadUShort()
 {
-    ushort val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(unsigned short)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
-    return this->byteOrder.Convert<ushort>(val);
+    return this->byteOrder.Convert<ushort>(this->ReadValue<ushort>());
 }
 
 //------------------------------------------------------------------------------
@@ -159,19 +204,7 @@ BinaryReader::ReadUShort()
 int
 BinaryReader::ReadInt()
 {
-    int val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(int)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
-    return this->byteOrder.Convert<int>(val);
+    return this->byteOrder.Convert<int>(this->ReadValue<int>());
 }
 
 //------------------------------------------------------------------------------
@@ -180,19 +213,7 @@ BinaryReader::ReadInt()
 unsigned int
 BinaryReader::ReadUInt()
 {
-    uint val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(unsigned int)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
-    return this->byteOrder.Convert<uint>(val);
+    return this->byteOrder.Convert<uint>(this->ReadValue<uint>());
 }
 
 //------------------------------------------------------------------------------
@@ -201,19 +222,7 @@ BinaryReader::ReadUInt()
 long long
 BinaryReader::ReadInt64()
 {
-    long long val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(long long)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
-    return this->byteOrder.Convert<int64_t>(val);
+    return this->byteOrder.Convert<int64_t>(this->ReadValue<long long>());
 }
 
 //------------------------------------------------------------------------------
@@ -222,19 +231,7 @@ BinaryReader::ReadInt64()
 unsigned long long
 BinaryReader::ReadUInt64()
 {
-    unsigned long long val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(unsigned long long)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
-    return this->byteOrder.Convert<uint64_t>(val);
+    return this->byteOrder.Convert<uint64_t>(this->ReadValue<unsigned long long>());
 }
 
 //------------------------------------------------------------------------------
@@ -243,19 +240,7 @@ BinaryReader::ReadUInt64()
 float
 BinaryReader::ReadFloat()
 {
-    float val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(float)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
-    return this->byteOrder.Convert<float>(val);
+    return this->byteOrder.Convert<float>(this->ReadValue<float>());
 }
 
 //------------------------------------------------------------------------------
@@ -286,19 +271,7 @@ BinaryReader::ReadFloatFromUnsignedNormalizedUByte2()
 double
 BinaryReader::ReadDouble()
 {
-    double val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(double)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
-    return this->byteOrder.Convert<double>(val);
+    return this->byteOrder.Convert<double>(this->ReadValue<double>());
 }
 
 //------------------------------------------------------------------------------
@@ -307,19 +280,7 @@ BinaryReader::ReadDouble()
 bool
 BinaryReader::ReadBool()
 {
-    bool val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(bool)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));        
-    }
-    return val;
+    return this->ReadValue<bool>();
 }
 
 //------------------------------------------------------------------------------
@@ -328,34 +289,16 @@ BinaryReader::ReadBool()
 Util::String
 BinaryReader::ReadString()
 {
-    if (this->isMapped)
-    {
-        ushort length = this->ReadUShort();
-        n_assert((this->mapCursor + length) <= this->mapEnd);
-        Util::String str;
-        if (length > 0)
-        {
-            str.Fill(length, 0);
-            char* buf = (char*) str.AsCharPtr();
-            Memory::Copy(this->mapCursor, buf, length);
-            this->mapCursor += length;
-            buf[length] = 0;
-        }
-        return str;    
-    }
-    else
+    ushort length = this->ReadUShort();
+    Util::String str;
+    if (length > 0)
     {
-        ushort length = this->ReadUShort();
-        Util::String str;
-        if (length > 0)
-        {
-            str.Fill(length, 0);
-            char* buf = (char*) str.AsCharPtr();
-            this->stream->Read((void*)buf, length);
-            buf[length] = 0;
-        }
-        return str;
+        str.Fill(length, 0);
+        char* buf = (char*) str.AsCharPtr();
+        this->ReadBytes(buf, length);
+        buf[length] = 0;
     }
+    return str;
 }
 
 //------------------------------------------------------------------------------
@@ -367,16 +310,7 @@ BinaryReader::ReadBlob()
     Stream::Size numBytes = this->ReadUInt64();
     Util::Blob blob(numBytes);
     void* ptr = const_cast<void*>(blob.GetPtr());
-    if (this->isMapped)
-    {
-        n_assert((this->mapCursor + numBytes) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, ptr, numBytes);
-        this->mapCursor += numBytes;
-    }
-    else
-    {
-        this->stream->Read(ptr, numBytes);
-    }
+    this->ReadBytes(ptr, numBytes);
     return blob;
 }
 
@@ -397,22 +331,9 @@ BinaryReader::ReadGuid()
 Math::vec2 
 BinaryReader::ReadFloat2()
 {
-    Math::vec2 val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(Math::vec2)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
-
-    val.set(this->byteOrder.Convert<float>(val.x),
-            this->byteOrder.Convert<float>(val.y));
-    return val;    
+    float val[2];
+    this->ReadArray(val, 2);
+    return Math::vec2(val[0], val[1]);
 }
 
 //------------------------------------------------------------------------------
@@ -421,18 +342,7 @@ BinaryReader::ReadFloat2()
 Math::vec4
 BinaryReader::ReadVec4()
 {
-    Math::vec4 val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(Math::vec4)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));     
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
+    Math::vec4 val = this->ReadValue<Math::vec4>();
     this->byteOrder.ConvertInPlace<Math::vec4>(val);
     return val;
 }    
@@ -443,24 +353,8 @@ BinaryReader::ReadVec4()
 Math::vec3 
 BinaryReader::ReadVec3()
 {
-    float val[3];    
-    const SizeT readSize = sizeof(float) * 3;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + readSize) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, val, readSize);
-        this->mapCursor += readSize;
-    }
-    else
-    {
-        this->stream->Read(val, readSize);
-    }
-
-    this->byteOrder.ConvertInPlace<float>(val[0]);
-    this->byteOrder.ConvertInPlace<float>(val[1]);
-    this->byteOrder.ConvertInPlace<float>(val[2]);
-
+    float val[3];
+    this->ReadArray(val, 3);
     return Math::vec3(val[0], val[1], val[2]);
 }
 
@@ -470,18 +364,7 @@ BinaryReader::ReadVec3()
 Math::mat4
 BinaryReader::ReadMat4()
 {
-    Math::mat4 val;
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(Math::mat4)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, &val, sizeof(val));        
-        this->mapCursor += sizeof(val);
-    }
-    else
-    {
-        this->stream->Read(&val, sizeof(val));
-    }
+    Math::mat4 val = this->ReadValue<Math::mat4>();
     this->byteOrder.ConvertInPlace<Math::mat4>(val);
     return val;
 }
@@ -494,23 +377,7 @@ Util::Array<float>
 BinaryReader::ReadFloatArray()
 {
     int size = this->ReadInt();
-    float* buf = (float*)Memory::Alloc(Memory::ScratchHeap, sizeof(float) * size);
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(Math::mat4)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, buf, sizeof(float) * size);        
-        this->mapCursor += sizeof(float) * size;
-    }
-    else
-    {
-        this->stream->Read(buf, sizeof(float) * size);
-    }
-    Util::Array<float> val(size, 0, 0);
-    IndexT i;
-    for (i = 0; i < size; i++) val[i] = buf[i];
-    Memory::Free(Memory::ScratchHeap, (void*)buf);
-    return val;
+    return this->ReadArray<float>(size);
 }
 
 //------------------------------------------------------------------------------
@@ -520,23 +387,7 @@ Util::Array<int>
 BinaryReader::ReadIntArray()
 {
     int size = this->ReadInt();
-    int* buf = (int*)Memory::Alloc(Memory::ScratchHeap, sizeof(int) * size);
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(Math::mat4)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, buf, sizeof(int) * size);        
-        this->mapCursor += sizeof(int) * size;
-    }
-    else
-    {
-        this->stream->Read(buf, sizeof(int) * size);
-    }
-    Util::Array<int> val(size, 0, 0);
-    IndexT i;
-    for (i = 0; i < size; i++) val[i] = buf[i];
-    Memory::Free(Memory::ScratchHeap, (void*)buf);
-    return val;
+    return this->ReadArray<int>(size);
 }
 
 //------------------------------------------------------------------------------
@@ -545,30 +396,8 @@ BinaryReader::ReadIntArray()
 Util::Array<uint>
 BinaryReader::ReadUIntArray()
 {
-    uint size = this->ReadInt();
-    Util::Array<uint> val(size, 0, 0);
-    if (size == 0)
-    {
-        //Early out if size is 0
-        return val;
-    }
-
-    uint* buf = (uint*)Memory::Alloc(Memory::ScratchHeap, sizeof(uint) * size);
-    if (this->isMapped)
-    {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(Math::mat4)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, buf, sizeof(uint) * size);
-        this->mapCursor += sizeof(uint) * size;
-    }
-    else
-    {
-        this->stream->Read(buf, sizeof(uint) * size);
-    }
-    uint i;
-    for (i = 0; i < size; i++) val[i] = buf[i];
-    Memory::Free(Memory::ScratchHeap, (void*)buf);
-    return val;
+    int size = this->ReadInt();
+    return this->ReadArray<uint>(size);
 }
 
 //------------------------------------------------------------------------------
@@ -578,42 +407,82 @@ Util::Array<bool>
 BinaryReader::ReadBoolArray()
 {
     int size = this->ReadInt();
-    bool* buf = (bool*)Memory::Alloc(Memory::ScratchHeap, sizeof(bool) * size);
+    return this->ReadArray<bool>(size);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/ 
+void
+BinaryReader::ReadRawData(void* ptr, SizeT numBytes)
+{
+    n_assert((ptr != 0) && (numBytes > 0));
+    this->ReadBytes(ptr, numBytes);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BinaryReader::Skip(SizeT numBytes)
+{
     if (this->isMapped)
     {
-        // note: the memory copy is necessary to circumvent alignment problem on some CPUs
-        n_assert((this->mapCursor + sizeof(Math::mat4)) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, buf, sizeof(bool) * size);        
-        this->mapCursor += sizeof(bool) * size;
+        n_assert((this->mapCursor + numBytes) <= this->mapEnd);
+        this->mapCursor += numBytes;
     }
     else
     {
-        this->stream->Read(buf, sizeof(bool) * size);
+        SizeT buffered = Math::min(numBytes, this->bufferFill - this->bufferPos);
+        this->bufferPos += buffered;
+        if (numBytes > buffered)
+        {
+            this->stream->Seek(numBytes - buffered, Stream::Current);
+        }
     }
-    Util::Array<bool> val(size, 0, 0);
-    IndexT i;
-    for (i = 0; i < size; i++) val[i] = buf[i];
-    Memory::Free(Memory::ScratchHeap, (void*)buf);
-    return val;
 }
 
 //------------------------------------------------------------------------------
 /**
-*/ 
+    Alignment is relative to the start of the stream, which is also aligned
+    in memory when the stream is mapped.
+*/
 void
-BinaryReader::ReadRawData(void* ptr, SizeT numBytes)
+BinaryReader::Align(SizeT alignment)
 {
-    n_assert((ptr != 0) && (numBytes > 0));
+    n_assert(alignment > 0);
+    Stream::Position pos;
     if (this->isMapped)
     {
-        n_assert((this->mapCursor + numBytes) <= this->mapEnd);
-        Memory::Copy(this->mapCursor, ptr, numBytes);
-        this->mapCursor += numBytes;
+        pos = (Stream::Position)(this->mapCursor - this->mapBegin);
     }
     else
     {
-        this->stream->Read(ptr, numBytes);
+        pos = this->stream->GetPosition() - (this->bufferFill - this->bufferPos);
+    }
+    SizeT padding = (SizeT)((alignment - (pos % alignment)) % alignment);
+    if (padding > 0)
+    {
+        this->Skip(padding);
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+template<> void
+BinaryReader::Get<Util::String>(Util::String& value)
+{
+    value = this->ReadString();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<> void
+BinaryReader::Get<Util::StringAtom>(Util::StringAtom& value)
+{
+    value = this->ReadString();
+}
+
 } // namespace IO
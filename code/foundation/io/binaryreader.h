@@ -7,7 +7,17 @@
     reader can use memory mapping for optimal read performance. Performs
     automatic byte order conversion if necessary.
 
-    @todo convert endianess!
+    Bulk data should be read with ReadArray() instead of per-element reads.
+    If the reader is mapped and the stream has host byte order, View() and
+    ReadSpan() return pointers directly into the mapped memory without
+    copying. Views require the cursor to be aligned for the element type,
+    use Align() to skip padding written by the asset tools.
+
+    Unmapped streams can be read through an internal read-ahead buffer,
+    which replaces the virtual Stream::Read() per value with a single read
+    per buffer refill. Since the stream position then runs ahead of the
+    reader, use the reader's Eof() instead of the stream's while reading.
+    The unconsumed bytes are handed back to seekable streams on Close().
     
     @copyright
     (C) 2006 Radon Labs GmbH
@@ -22,7 +32,9 @@
 #endif
 #include "util/guid.h"
 #include "util/blob.h"
+#include "util/stringatom.h"
 #include "system/byteorder.h"
+#include <type_traits>
 
 //------------------------------------------------------------------------------
 namespace IO
@@ -43,10 +55,16 @@ public:
     void SetStreamByteOrder(System::ByteOrder::Type byteOrder);
     /// get the stream byte order
     System::ByteOrder::Type GetStreamByteOrder() const;
+    /// call before Open() to read unmapped streams through a read-ahead buffer of the given size (0 disables)
+    void SetReadAheadBufferSize(SizeT size);
+    /// get the size of the read-ahead buffer
+    SizeT GetReadAheadBufferSize() const;
     /// begin reading from the stream
     virtual bool Open();
     /// end reading from the stream
     virtual void Close();
+    /// return true if the reader has consumed the entire stream
+    bool Eof() const;
     /// read an 8-bit char from the stream
     char ReadChar();
     /// read an 8-bit unsigned character from the stream
@@ -99,13 +117,43 @@ public:
     Util::Blob ReadBlob();
     /// read raw data
     void ReadRawData(void* ptr, SizeT numBytes);
+    /// skip bytes in the stream
+    void Skip(SizeT numBytes);
+    /// skip padding up to the next multiple of alignment from the start of the stream
+    void Align(SizeT alignment);
+
+    /// read an array of values into a buffer
+    template <typename TYPE> void ReadArray(TYPE* buf, SizeT count);
+    /// read an array of values
+    template <typename TYPE> Util::Array<TYPE> ReadArray(SizeT count);
+    /// return true if count values at the cursor can be viewed in place
+    template <typename TYPE> bool CanView(SizeT count) const;
+    /// get a pointer to count values in the mapped stream and advance the cursor, CanView() must be true
+    template <typename TYPE> const TYPE* View(SizeT count);
+    /// read count values, viewed in place if possible or copied to storage otherwise
+    template <typename TYPE> const TYPE* ReadSpan(SizeT count, Util::Array<TYPE>& storage);
+    /// read a value written by BinaryWriter::Add(), specialize for types which aren't plain data
+    template <typename TYPE> void Get(TYPE& value);
+
+private:
+    /// read a single value through the fast path
+    template <typename TYPE> TYPE ReadValue();
+    /// read bytes from the mapping, the read-ahead buffer or the stream
+    void ReadBytes(void* ptr, SizeT numBytes);
+    /// return true if values have to be converted to host byte order
+    bool IsConverting() const;
 
 public:
     bool enableMapping;
     bool isMapped;
     System::ByteOrder byteOrder;
+    unsigned char* mapBegin;
     unsigned char* mapCursor;
     unsigned char* mapEnd;
+    unsigned char* readAheadBuffer;
+    SizeT readAheadSize;
+    SizeT bufferPos;
+    SizeT bufferFill;
 };
 
 //------------------------------------------------------------------------------
@@ -144,5 +192,176 @@ BinaryReader::GetStreamByteOrder() const
     return this->byteOrder.GetFromByteOrder();
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+BinaryReader::SetReadAheadBufferSize(SizeT size)
+{
+    n_assert(!this->IsOpen());
+    this->readAheadSize = size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+BinaryReader::GetReadAheadBufferSize() const
+{
+    return this->readAheadSize;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+BinaryReader::IsConverting() const
+{
+    return this->byteOrder.GetFromByteOrder() != this->byteOrder.GetToByteOrder();
+}
+
+//------------------------------------------------------------------------------
+/**
+    The fixed size memcpy compiles to a single unaligned load, so values
+    don't need to be aligned in the stream.
+*/
+template <typename TYPE>
+__forceinline TYPE
+BinaryReader::ReadValue()
+{
+    TYPE val;
+    if (this->isMapped)
+    {
+        n_assert((this->mapCursor + sizeof(TYPE)) <= this->mapEnd);
+        memcpy(&val, this->mapCursor, sizeof(TYPE));
+        this->mapCursor += sizeof(TYPE);
+    }
+    else if ((this->bufferFill - this->bufferPos) >= (SizeT)sizeof(TYPE))
+    {
+        memcpy(&val, this->readAheadBuffer + this->bufferPos, sizeof(TYPE));
+        this->bufferPos += sizeof(TYPE);
+    }
+    else
+    {
+        this->ReadBytes(&val, sizeof(TYPE));
+    }
+    return val;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Reads all values with a single copy and only touches them again if
+    they have to be converted to host byte order, which is supported for
+    arithmetic types.
+*/
+template <typename TYPE>
+inline void
+BinaryReader::ReadArray(TYPE* buf, SizeT count)
+{
+    static_assert(std::is_trivially_copyable<TYPE>::value, "BinaryReader::ReadArray() requires trivially copyable types");
+    if (count <= 0)
+        return;
+
+    this->ReadBytes(buf, count * sizeof(TYPE));
+    if constexpr (sizeof(TYPE) > 1)
+    {
+        if (this->IsConverting())
+        {
+            if constexpr (std::is_arithmetic<TYPE>::value)
+            {
+                IndexT i;
+                for (i = 0; i < count; i++)
+                    buf[i] = this->byteOrder.Convert<TYPE>(buf[i]);
+            }
+            else
+            {
+                n_error("BinaryReader::ReadArray(): can't convert byte order of non-arithmetic types!\n");
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <typename TYPE>
+inline Util::Array<TYPE>
+BinaryReader::ReadArray(SizeT count)
+{
+    Util::Array<TYPE> val;
+    if (count > 0)
+    {
+        val.Resize(count);
+        this->ReadArray(val.Begin(), count);
+    }
+    return val;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Mapped streams start at an allocation or page boundary, so values which
+    the asset tools aligned in the file are aligned in memory as well.
+*/
+template <typename TYPE>
+inline bool
+BinaryReader::CanView(SizeT count) const
+{
+    return this->isMapped
+        && !(sizeof(TYPE) > 1 && this->IsConverting())
+        && (this->mapCursor + count * sizeof(TYPE)) <= this->mapEnd
+        && (((uintptr_t)this->mapCursor) & (alignof(TYPE) - 1)) == 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The returned pointer is valid until the reader is closed.
+*/
+template <typename TYPE>
+inline const TYPE*
+BinaryReader::View(SizeT count)
+{
+    static_assert(std::is_trivially_copyable<TYPE>::value, "BinaryReader::View() requires trivially copyable types");
+    n_assert(this->CanView<TYPE>(count));
+    const TYPE* view = (const TYPE*)this->mapCursor;
+    this->mapCursor += count * sizeof(TYPE);
+    return view;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Plain data is read as is, in host byte order.
+*/
+template <typename TYPE>
+inline void
+BinaryReader::Get(TYPE& value)
+{
+    static_assert(std::is_trivially_copyable<TYPE>::value, "BinaryReader::Get() needs a specialization for this type");
+    this->ReadBytes(&value, sizeof(TYPE));
+}
+
+template<> void BinaryReader::Get<Util::String>(Util::String& value);
+template<> void BinaryReader::Get<Util::StringAtom>(Util::StringAtom& value);
+
+//------------------------------------------------------------------------------
+/**
+    Avoids the copy whenever the data can be viewed in place, storage is only
+    touched if it can't.
+*/
+template <typename TYPE>
+inline const TYPE*
+BinaryReader::ReadSpan(SizeT count, Util::Array<TYPE>& storage)
+{
+    if (this->CanView<TYPE>(count))
+    {
+        return this->View<TYPE>(count);
+    }
+    else
+    {
+        storage.Resize(count);
+        this->ReadArray(storage.Begin(), count);
+        return storage.Begin();
+    }
+}
+
 } // namespace IO
 //------------------------------------------------------------------------------
@@ -605,4 +605,22 @@ BinaryWriter::WriteRawData(const void* ptr, SizeT numBytes)
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+template<> void
+BinaryWriter::Add<Util::String>(Util::String const& value)
+{
+    this->WriteString(value);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<> void
+BinaryWriter::Add<Util::StringAtom>(Util::StringAtom const& value)
+{
+    this->WriteString(value.AsString());
+}
+
 } // namespace IO
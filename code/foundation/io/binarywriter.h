@@ -15,7 +15,9 @@
 #include "io/streamwriter.h"
 #include "util/blob.h"
 #include "util/guid.h"
+#include "util/stringatom.h"
 #include "system/byteorder.h"
+#include <type_traits>
 #if !__OSX__
 #include "math/vec2.h"
 #endif
@@ -95,6 +97,8 @@ public:
     void WriteBlob(const Util::Blob& blob);
     /// write raw data
     void WriteRawData(const void* ptr, SizeT numBytes);
+    /// write a value to be read by BinaryReader::Get(), specialize for types which aren't plain data
+    template <typename TYPE> void Add(TYPE const& value);
 
 public:
     bool enableMapping;
@@ -142,5 +146,20 @@ BinaryWriter::GetStreamByteOrder() const
     return this->byteOrder.GetToByteOrder();
 }
 
+//------------------------------------------------------------------------------
+/**
+    Plain data is written as is, in host byte order.
+*/
+template <typename TYPE>
+inline void
+BinaryWriter::Add(TYPE const& value)
+{
+    static_assert(std::is_trivially_copyable<TYPE>::value, "BinaryWriter::Add() needs a specialization for this type");
+    this->WriteRawData(&value, sizeof(TYPE));
+}
+
+template<> void BinaryWriter::Add<Util::String>(Util::String const& value);
+template<> void BinaryWriter::Add<Util::StringAtom>(Util::StringAtom const& value);
+
 } // namespace IO
 //------------------------------------------------------------------------------
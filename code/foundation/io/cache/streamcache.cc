@@ -80,16 +80,16 @@ StreamCache::OpenStream(IO::URI const& uri, Core::Rtti const& rtti)
 void 
 StreamCache::RemoveStream(IO::URI const & uri)
 {
-    Util::String uriString = uri.AsString();
-    n_assert(this->streams.Contains(uriString));
-    CacheEntry& entry = this->streams[uriString];
+    IndexT index = this->streams.FindIndex(uri.AsString());
+    n_assert(index != InvalidIndex);
+    CacheEntry& entry = this->streams.ValueAtIndex(index);
     --entry.useCount;
     if (entry.useCount == 0)
     {
         entry.stream->Unmap();
         entry.stream->Close();
         entry.stream = nullptr;
-        this->streams.Erase(uriString);
+        this->streams.EraseIndex(index);
     }
 }
 
@@ -100,8 +100,9 @@ void
 StreamCache::Discard()
 {
     // release all streams
-    for (CacheEntry& entry : this->streams.ValuesAsArray())
+    for (Util::KeyValuePair<Util::String, CacheEntry>& kvp : this->streams)
     {
+        CacheEntry& entry = kvp.Value();
         entry.stream->Unmap();
         entry.stream->Close();
         entry.stream = nullptr;
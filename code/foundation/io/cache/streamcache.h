@@ -14,7 +14,7 @@
 #include "core/singleton.h"
 #include "io/uri.h"
 #include "io/stream.h"
-#include "util/dictionary.h"
+#include "util/flathashmap.h"
 
 //------------------------------------------------------------------------------
 namespace IO
@@ -48,7 +48,7 @@ private:
         SizeT useCount = 0;
     };
 
-    Util::Dictionary<Util::String, CacheEntry> streams;
+    Util::FlatHashMap<Util::String, CacheEntry> streams;
 };
 
 } // namespace IO
@@ -11,13 +11,28 @@ namespace Jobs2
 {
 
 Jobs2Context ctx;
+thread_local JobThread* currentJobThread = nullptr;
 
 __ImplementClass(Jobs2::JobThread, 'J2TH', Threading::Thread);
+
+//------------------------------------------------------------------------------
+/**
+    Kept out of line, since a job on a fiber may continue on another thread
+    after JobYieldUntil(), and the compiler would otherwise be free to reuse
+    the thread local address it looked up on the thread the job started on.
+*/
+static N_NOINLINE JobThread*
+GetCurrentJobThread()
+{
+    return currentJobThread;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 JobThread::JobThread()
     : wakeupEvent{ false }
+    , activeFiber(nullptr)
 {
     // empty
 }
@@ -53,148 +68,348 @@ JobThread::EmitWakeupSignal()
 
 //------------------------------------------------------------------------------
 /**
+    Finds the first job in the list which has its dependencies met, and
+    takes the next group from it. Returns nullptr if nothing can run.
 */
-void
-JobThread::DoWork()
+static JobContext*
+TakeJob(IndexT& jobIndex)
 {
-    if (this->enableIo)
-        IO::IoServer::Create();
-    if (this->enableProfiling)
-        Profiling::ProfilingRegisterThread();
+    ctx.jobLock.Enter();
+    auto node = ctx.head;
+    auto dragging = ctx.head;
+    Jobs2::JobContext* job = nullptr;
+    jobIndex = -1;
     while (true)
     {
-wait:
-        // Wait for jobs to come
-        this->wakeupEvent.Wait();
-        if (this->ThreadStopRequested())
-            return;
+        // If head is nullptr, we either lost the race to grab a job
+        // or we traversed the whole list but found no job which has it's dependency satisfied,
+        // so let's wait 
+        if (ctx.head == nullptr || node == nullptr)
+        {
+            ctx.jobLock.Leave();
+            return nullptr;
+        }
 
-next:
-        ctx.jobLock.Enter();
-        auto node = ctx.head;
-        auto dragging = ctx.head;
-        Jobs2::JobContext* job = nullptr;
+        bool dependencyDone = true;
 
-        //auto it = ctx.jobs.Begin();
-        int64_t jobIndex = -1;
-        while (true)
-        {
-            // If head is nullptr, we either lost the race to grab a job
-            // or we traversed the whole list but found no job which has it's dependency satisfied,
-            // so let's wait 
-            if (ctx.head == nullptr || node == nullptr)
-            {
-                ctx.jobLock.Leave();
-                goto wait;
-            }
+        // Check dependencies
+        for (IndexT i = 0; i < node->job.numWaitCounters; i++)
+            dependencyDone &= *node->job.waitCounters[i] == 0;
 
-            bool dependencyDone = true;
+        // If dependency is not done, update iterators and progress
+        if (!dependencyDone)
+        {
+            dragging = node;
+            node = node->next;
+            continue;
+        }
 
-            // Check dependencies
-            for (IndexT i = 0; i < node->job.numWaitCounters; i++)
-                dependencyDone &= *node->job.waitCounters[i] == 0;
+        if (node->sequence != nullptr)
+        {
+            job = &node->sequence->job;
+            n_assert(job->remainingGroups > 0);
 
-            // If dependency is not done, update iterators and progress
-            if (!dependencyDone)
+            // If wait hasn't been met, continue to next node in the main list
+            if (job->numWaitCounters == 1 && *job->waitCounters[0] != 0)
             {
                 dragging = node;
                 node = node->next;
                 continue;
             }
 
-            if (node->sequence != nullptr)
+            // If we are consuming the last packet in the sequence, simply point the sequence to the next node
+            jobIndex = --job->remainingGroups;
+            if (job->remainingGroups == 0)
             {
-                job = &node->sequence->job;
-                n_assert(job->remainingGroups > 0);
+                node->sequence = node->sequence->next;
+            }
+        }
+        else
+        {
+            job = &node->job;
+            n_assert(job->remainingGroups > 0);
 
-                // If wait hasn't been met, continue to next node in the main list
-                if (job->numWaitCounters == 1 && *job->waitCounters[0] != 0)
-                {
-                    dragging = node;
-                    node = node->next;
-                    continue;
-                }
+            // If we are consuming the last job packet in this run, disconnect the node
+            jobIndex = --job->remainingGroups;
+            if (job->remainingGroups == 0)
+            {
+                // Update node pointers
+                auto next = node->next;
 
-                // If we are consuming the last packet in the sequence, simply point the sequence to the next node
-                jobIndex = --job->remainingGroups;
-                if (job->remainingGroups == 0)
+                // If node is not head, unlink the node between dragging and the current
+                if (node != ctx.head)
                 {
-                    node->sequence = node->sequence->next;
+                    // If node is the last one in the list, update tail
+                    if (node == ctx.tail)
+                        ctx.tail = dragging;
+                    dragging->next = next;
                 }
-            }
-            else
-            {
-                job = &node->job;
-                n_assert(job->remainingGroups > 0);
-
-                // If we are consuming the last job packet in this run, disconnect the node
-                jobIndex = --job->remainingGroups;
-                if (job->remainingGroups == 0)
+                else
                 {
-                    // Update node pointers
-                    auto next = node->next;
-
-                    // If node is not head, unlink the node between dragging and the current
-                    if (node != ctx.head)
-                    {
-                        // If node is the last one in the list, update tail
-                        if (node == ctx.tail)
-                            ctx.tail = dragging;
-                        dragging->next = next;
-                    }
-                    else
-                    {
-                        // If head, then just unlink the head node
-                        ctx.head = next;
-
-                        // If tail and node point to the same node, unlink tail
-                        if (node == ctx.tail)
-                            ctx.tail = nullptr;
-                    }
+                    // If head, then just unlink the head node
+                    ctx.head = next;
+
+                    // If tail and node point to the same node, unlink tail
+                    if (node == ctx.tail)
+                        ctx.tail = nullptr;
                 }
             }
+        }
 
-            // If we fall through it means we found a job
-            break;
+        // If we fall through it means we found a job
+        break;
+    }
+    ctx.jobLock.Leave();
+
+    // If jobIndex is -1, it means we're trying to run a function on a finished job
+    n_assert(jobIndex != -1);
+    return job;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+FinishJobGroup(JobContext* job)
+{
+    // Decrement number of finished jobs, and if this was the last one, signal the finished event
+    if (Threading::Interlocked::Decrement(&job->groupCompletionCounter) == 0)
+    {
+        // If we have a job counter, only signal the event when the counter reaches 0,
+        // threads waiting on the counter itself are woken up by the decrement
+        if (job->doneCounter != nullptr)
+        {
+            long numDispatchesLeft = Threading::DecrementCounter(job->doneCounter);
+
+            if (job->signalEvent != nullptr && numDispatchesLeft == 0)
+                job->signalEvent->Signal();
+        }
+        else
+        {
+            // If we don't have a counter, just signal it when we're done with this dispatch
+            if (job->signalEvent != nullptr)
+                job->signalEvent->Signal();
         }
-        ctx.jobLock.Leave();
 
-        // If jobIndex is -1, it means we're trying to run a function on a finished job
-        n_assert(jobIndex != -1);
+        // Since other threads might be waiting for this job to finish, trigger other threads to wake up
+        for (Ptr<JobThread>& thread : ctx.threads)
+        {
+            thread->SignalWorkAvailable();
+        }
+    }
+}
 
-        // Run function
-        job->func(job->numInvocations, job->groupSize, jobIndex, jobIndex * job->groupSize, job->data);
+//------------------------------------------------------------------------------
+/**
+    A fiber which waits for the counter is put aside, and only looked at
+    again when a worker wakes up, so counters which aren't the done counter
+    of a dispatch have to be decremented here to resume it.
+*/
+int
+JobDecrementCounter(Threading::AtomicCounter* counter)
+{
+    const int value = Threading::DecrementCounter(counter);
+    if (value == 0 && ctx.numSleepingFibers > 0)
+    {
+        for (Ptr<JobThread>& thread : ctx.threads)
+        {
+            thread->SignalWorkAvailable();
+        }
+    }
+    return value;
+}
 
-        // Decrement number of finished jobs, and if this was the last one, signal the finished event
-        if (Threading::Interlocked::Decrement(&job->groupCompletionCounter) == 0)
+//------------------------------------------------------------------------------
+/**
+    Returns a fiber which waited in JobYieldUntil() and whose counter has
+    reached zero since. Any worker may resume it, the thread it waited on
+    might be blocked in a job which waits for this very fiber.
+*/
+static JobFiber*
+TakeReadyFiber()
+{
+    if (ctx.numSleepingFibers == 0)
+        return nullptr;
+
+    Threading::CriticalScope scope(&ctx.sleepLock);
+    IndexT i;
+    for (i = 0; i < ctx.sleepingFibers.Size(); i++)
+    {
+        JobFiber* fiber = ctx.sleepingFibers[i];
+        if (*fiber->waitCounter == 0)
         {
-            // If we have a job counter, only signal the event when the counter reaches 0
-            if (job->doneCounter != nullptr)
-            {
-                long numDispatchesLeft = Threading::Interlocked::Decrement(job->doneCounter);
+            ctx.sleepingFibers.EraseIndexSwap(i);
+            Threading::Interlocked::Decrement(&ctx.numSleepingFibers);
+            fiber->waitCounter = nullptr;
+            return fiber;
+        }
+    }
+    return nullptr;
+}
 
-                if (job->signalEvent != nullptr && numDispatchesLeft == 0)
-                    job->signalEvent->Signal();
-            }
-            else
-            {
-                // If we don't have a counter, just signal it when we're done with this dispatch
-                if (job->signalEvent != nullptr)
-                    job->signalEvent->Signal();
-            }
+//------------------------------------------------------------------------------
+/**
+*/
+void
+JobThread::DoWork()
+{
+    if (this->enableIo)
+        IO::IoServer::Create();
+    if (this->enableProfiling)
+        Profiling::ProfilingRegisterThread();
+    currentJobThread = this;
+    this->activeFiber = nullptr;
+    if (ctx.fibersEnabled)
+        Fibers::Fiber::ThreadToFiber(this->threadFiber);
 
-            // Since other threads might be waiting for this job to finish, trigger other threads to wake up
-            for (Ptr<JobThread>& thread : ctx.threads)
-            {
-                thread->EmitWakeupSignal();
-            }
+    while (true)
+    {
+        // Wait for jobs to come, or for a counter a fiber waits for to reach zero
+        this->wakeupEvent.Wait();
+        if (this->ThreadStopRequested())
+            break;
+
+        // Work until there is nothing left which can run
+        while (this->RunNext())
+        {
         }
+    }
+
+    if (ctx.fibersEnabled)
+        Fibers::Fiber::FiberToThread(this->threadFiber);
+}
 
-        // Do another
-        goto next;
+//------------------------------------------------------------------------------
+/**
+    Jobs which can continue after JobYieldUntil() go first, they are further
+    along and may hold up other work. If all fibers are taken, the job runs
+    on the thread itself, where JobYieldUntil() has to block.
+*/
+bool
+JobThread::RunNext()
+{
+    JobFiber* fiber = nullptr;
+    if (ctx.fibersEnabled)
+    {
+        fiber = TakeReadyFiber();
+        if (fiber != nullptr)
+        {
+            this->RunFiber(fiber);
+            return true;
+        }
+        ctx.freeFibers.Dequeue(fiber);
+    }
+
+    IndexT jobIndex;
+    JobContext* job = TakeJob(jobIndex);
+    if (job == nullptr)
+    {
+        if (fiber != nullptr)
+            ctx.freeFibers.Enqueue(fiber);
+        return false;
+    }
+
+    if (fiber != nullptr)
+    {
+        fiber->job = job;
+        fiber->jobIndex = jobIndex;
+        this->RunFiber(fiber);
+    }
+    else
+    {
+        job->func(job->numInvocations, job->groupSize, jobIndex, jobIndex * job->groupSize, job->data);
+        FinishJobGroup(job);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    When the fiber switches back, it's either done with its job or waits
+    for a counter. A waiting fiber may only be handed to the other threads
+    now that nothing runs on it anymore, or another thread could resume it
+    while its registers are still being saved. If the counter reached zero
+    before the fiber got to the list, RunNext() finds it right away, since
+    this thread goes around once more before it sleeps.
+*/
+void
+JobThread::RunFiber(JobFiber* fiber)
+{
+    this->activeFiber = fiber;
+    fiber->fiber.SwitchToFiber(this->threadFiber);
+    this->activeFiber = nullptr;
+
+    if (fiber->waitCounter != nullptr)
+    {
+        Threading::CriticalScope scope(&ctx.sleepLock);
+        ctx.sleepingFibers.Append(fiber);
+        Threading::Interlocked::Increment(&ctx.numSleepingFibers);
+    }
+    else
+    {
+        JobContext* job = fiber->job;
+        fiber->job = nullptr;
+        ctx.freeFibers.Enqueue(fiber);
+        FinishJobGroup(job);
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+    Fibers are reused, every switch to a fiber after its job is done runs
+    the next job it has been given.
+*/
+void
+JobFiberFunction(void* param)
+{
+    JobFiber* fiber = (JobFiber*)param;
+    while (true)
+    {
+        JobContext* job = fiber->job;
+        job->func(job->numInvocations, job->groupSize, fiber->jobIndex, fiber->jobIndex * job->groupSize, job->data);
+        GetCurrentJobThread()->threadFiber.SwitchToFiber(fiber->fiber);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    The counter has to be the done counter of a dispatch, or decremented
+    with JobDecrementCounter(), since that's what wakes up the workers.
+    Outside of a job, or in a job which didn't get a fiber, this blocks the
+    thread until the counter reaches zero.
+
+    The job may continue on another thread, so the profiling scopes it has
+    open are taken along with the fiber, and the thread which resumes it
+    continues them.
+*/
+void
+JobYieldUntil(const Threading::AtomicCounter* counter)
+{
+    if (*counter == 0)
+        return;
+
+    JobThread* thread = GetCurrentJobThread();
+    JobFiber* fiber = thread != nullptr ? thread->activeFiber : nullptr;
+    if (fiber == nullptr)
+    {
+        Threading::WaitForCounter(counter);
+        return;
+    }
+
+#if NEBULA_ENABLE_PROFILING
+    Profiling::ProfilingSuspendScopes(fiber->scopes);
+#endif
+
+    // Switch back to the thread, which puts the fiber aside, when we get back here
+    // the counter has reached zero, but we may be on another thread
+    fiber->waitCounter = counter;
+    thread->threadFiber.SwitchToFiber(fiber->fiber);
+
+#if NEBULA_ENABLE_PROFILING
+    Profiling::ProfilingResumeScopes(fiber->scopes);
+#endif
+}
+
 N_DECLARE_COUNTER(N_JOBS2_MEMORY_COUNTER, Jobs2RingBufferMemory)
 
 //------------------------------------------------------------------------------
@@ -203,6 +418,24 @@ N_DECLARE_COUNTER(N_JOBS2_MEMORY_COUNTER, Jobs2RingBufferMemory)
 void
 JobSystemInit(const JobSystemInitInfo& info)
 {
+    // Setup the fiber pool before the threads look at it
+    ctx.fibersEnabled = info.enableFibers;
+    if (info.enableFibers)
+    {
+        n_assert(info.numFibers > 0);
+        ctx.fibers.Resize(info.numFibers);
+        ctx.freeFibers.Resize(info.numFibers);
+        for (IndexT i = 0; i < info.numFibers; i++)
+        {
+            JobFiber& fiber = ctx.fibers[i];
+            fiber.fiber = Fibers::Fiber(JobFiberFunction, &fiber, info.fiberStackSize);
+            fiber.job = nullptr;
+            fiber.jobIndex = -1;
+            fiber.waitCounter = nullptr;
+            ctx.freeFibers.Enqueue(&fiber);
+        }
+    }
+
     // Setup job system threads
     ctx.threads.Resize(info.numThreads);
     for (IndexT i = 0; i < info.numThreads; i++)
@@ -241,6 +474,21 @@ JobSystemUninit()
         thread->Stop();
     }
     ctx.threads.Clear();
+
+    JobFiber* fiber;
+    while (ctx.freeFibers.Dequeue(fiber))
+    {
+    }
+    ctx.sleepingFibers.Clear();
+    ctx.numSleepingFibers = 0;
+    ctx.fibers.Clear();
+    ctx.fibersEnabled = false;
+
+    for (IndexT i = 0; i < ctx.scratchMemory.Size(); i++)
+    {
+        Memory::Free(Memory::ObjectHeap, ctx.scratchMemory[i]);
+    }
+    ctx.scratchMemory.Clear();
 }
 
 //------------------------------------------------------------------------------
@@ -263,13 +511,50 @@ JobAlloc(SizeT bytes)
     // make sure to always pad to next 16 byte alignment in case the 
     // context used needs to be aligned
     bytes = Math::alignptr(bytes, 16);
-    n_assert((ctx.iterator + bytes) < ctx.scratchMemorySize);
-    void* ret = (ctx.scratchMemory[ctx.activeBuffer] + ctx.iterator);
-    ctx.iterator += bytes;
+    const IndexT offset = Threading::Interlocked::Add(&ctx.iterator, bytes);
+    n_assert((offset + bytes) < ctx.scratchMemorySize);
+    void* ret = (ctx.scratchMemory[ctx.activeBuffer] + offset);
     N_BUDGET_COUNTER_INCR(N_JOBS2_MEMORY_COUNTER, bytes);
     return ret;
 }
 
+//------------------------------------------------------------------------------
+/**
+    If ptr is the most recent allocation, the iterator is simply moved,
+    otherwise a new block is allocated and the old content copied over.
+    The old block is never released, which is fine for scratch memory.
+    The iterator is only moved if no other thread allocated in between.
+*/
+void*
+JobRealloc(void* ptr, SizeT oldBytes, SizeT newBytes)
+{
+    if (nullptr == ptr)
+    {
+        return JobAlloc(newBytes);
+    }
+
+    oldBytes = Math::alignptr(oldBytes, 16);
+    newBytes = Math::alignptr(newBytes, 16);
+    const IndexT end = (IndexT)((byte*)ptr + oldBytes - ctx.scratchMemory[ctx.activeBuffer]);
+    const IndexT newEnd = end - oldBytes + newBytes;
+    if (newEnd < ctx.scratchMemorySize && Threading::Interlocked::CompareExchange(&ctx.iterator, newEnd, end) == end)
+    {
+        if (newBytes > oldBytes)
+        {
+            N_BUDGET_COUNTER_INCR(N_JOBS2_MEMORY_COUNTER, newBytes - oldBytes);
+        }
+        else
+        {
+            N_BUDGET_COUNTER_DECR(N_JOBS2_MEMORY_COUNTER, oldBytes - newBytes);
+        }
+        return ptr;
+    }
+
+    void* ret = JobAlloc(newBytes);
+    memcpy(ret, ptr, Math::min(oldBytes, newBytes));
+    return ret;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -289,7 +574,7 @@ Threading::ThreadId sequenceThread;
 */
 void
 JobBeginSequence(
-    const Util::FixedArray<const Threading::AtomicCounter*>& waitCounters
+    const JobWaitCounters& waitCounters
     , Threading::AtomicCounter* doneCounter
     , Threading::Event* signalEvent)
 {
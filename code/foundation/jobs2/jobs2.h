@@ -3,12 +3,22 @@
 #include "threading/event.h"
 #include "util/stringatom.h"
 #include "threading/interlocked.h"
+#include "threading/futex.h"
+#include "threading/mpmcqueue.h"
+#include "fibers/fiber.h"
+#include "profiling/profiling.h"
 
 //------------------------------------------------------------------------------
 /**
     The Jobs2 system provides a set of threads and a pool of jobs from which 
     threads can pickup work.
 
+    If fibers are enabled, every job group runs on a fiber from a pool, and
+    a job can wait for a counter with JobYieldUntil(). The fiber is then put
+    aside and the worker thread goes on with other work, instead of blocking,
+    until the counter reaches zero and any worker picks the fiber up again.
+    This allows jobs to dispatch more jobs and wait for their results.
+
     (C) 2021 Individual contributors, see AUTHORS file
 */
 //------------------------------------------------------------------------------
@@ -47,6 +57,17 @@ struct JobNode
     JobNode* sequence; // set to nullptr for ordinary nodes
 };
 
+struct JobFiber
+{
+    Fibers::Fiber fiber;
+    JobContext* job;
+    IndexT jobIndex;
+    const Threading::AtomicCounter* waitCounter; // set while the job is in JobYieldUntil()
+#if NEBULA_ENABLE_PROFILING
+    Util::Stack<Profiling::ProfilingScope> scopes; // the profiling scopes the job had open when it started to wait
+#endif
+};
+
 struct Jobs2Context
 {
     Threading::CriticalSection jobLock;
@@ -56,10 +77,17 @@ struct Jobs2Context
     Util::Array<JobNode*> queuedJobs;
 
     SizeT numBuffers;
-    IndexT iterator;
+    Threading::AtomicCounter iterator;
     IndexT activeBuffer;
     Util::FixedArray<byte*> scratchMemory;
     SizeT scratchMemorySize;
+
+    bool fibersEnabled = false;
+    Util::FixedArray<JobFiber> fibers;
+    Threading::MpmcQueue<JobFiber*> freeFibers;
+    Threading::CriticalSection sleepLock;
+    Util::Array<JobFiber*> sleepingFibers;
+    Threading::AtomicCounter numSleepingFibers = 0;
 };
 
 extern Jobs2Context ctx;
@@ -87,7 +115,17 @@ protected:
     virtual void DoWork() override;
 
 private:
+    friend void JobYieldUntil(const Threading::AtomicCounter* counter);
+    friend void JobFiberFunction(void* param);
+
+    /// run a job group or continue a job which waited, returns false if there was nothing to do
+    bool RunNext();
+    /// switch to a fiber to run or continue its job, and handle what it did when it switches back
+    void RunFiber(JobFiber* fiber);
+
     Threading::Event wakeupEvent;
+    Fibers::Fiber threadFiber;
+    JobFiber* activeFiber;
 };
 
 struct JobSystemInitInfo
@@ -103,6 +141,10 @@ struct JobSystemInitInfo
     bool enableIo;
     bool enableProfiling;
 
+    bool enableFibers;
+    SizeT numFibers;
+    SizeT fiberStackSize;
+
     JobSystemInitInfo()
         : numThreads(1)
         , affinity(0xFFFFFFFF)
@@ -111,6 +153,9 @@ struct JobSystemInitInfo
         , numBuffers(1)
         , enableIo(false)
         , enableProfiling(true)
+        , enableFibers(false)
+        , numFibers(128)
+        , fiberStackSize(64_KB)
     {};
 };
 
@@ -119,20 +164,32 @@ void JobSystemInit(const JobSystemInitInfo& info);
 /// Destroy job port
 void JobSystemUninit();
 
+/// Wait for a counter to reach zero, inside a job on a fiber the worker runs other jobs meanwhile
+void JobYieldUntil(const Threading::AtomicCounter* counter);
+/// Decrement a counter which isn't a dispatch's done counter, wakes up the workers for jobs waiting on it, returns the new value
+int JobDecrementCounter(Threading::AtomicCounter* counter);
+
 /// Allocate memory and progress memory iterator
 template <typename T> T* JobAlloc(SizeT count);
-/// Allocate memory
+/// Allocate memory, may also be called from within jobs
 void* JobAlloc(SizeT bytes);
+/// Resize memory allocated with JobAlloc, grows in place if it's the latest allocation
+void* JobRealloc(void* ptr, SizeT oldBytes, SizeT newBytes);
 /// Progress to new buffer
 void JobNewFrame();
 
+/// Container allocator policy which allocates from the job scratch memory
+struct JobScratchAllocator;
+/// The counters a job waits for, only lives until the job is dispatched so it's allocated from scratch memory
+typedef Util::FixedArray<const Threading::AtomicCounter*, JobScratchAllocator> JobWaitCounters;
+
 extern JobNode* sequenceNode;
 extern JobNode* sequenceTail;
 extern const Threading::AtomicCounter* prevDoneCounter;
 extern Threading::ThreadId sequenceThread;
 
 /// Begin a sequence of jobs
-void JobBeginSequence(const Util::FixedArray<const Threading::AtomicCounter*>& waitCounters = nullptr
+void JobBeginSequence(const JobWaitCounters& waitCounters = nullptr
     , Threading::AtomicCounter* doneCounter = nullptr
     , Threading::Event* signalEvent = nullptr);
 
@@ -163,6 +220,51 @@ JobAlloc(SizeT count)
     return (T*)JobAlloc(count * sizeof(T));
 }
 
+//------------------------------------------------------------------------------
+/**
+    Container allocator policy which allocates from the job scratch memory,
+    for temporary containers which are filled and consumed within a frame,
+    for instance Util::Array<T, 0, Jobs2::JobScratchAllocator>. Free() does
+    nothing, the memory is recycled in bulk by JobNewFrame(). Like JobAlloc(),
+    this may be used from jobs too, but not across frames.
+*/
+struct JobScratchAllocator
+{
+    /// allocate from scratch memory
+    static void* Alloc(size_t bytes);
+    /// resize a scratch memory allocation
+    static void* Realloc(void* ptr, size_t oldBytes, size_t newBytes);
+    /// does nothing
+    static void Free(void* ptr, size_t bytes);
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void*
+JobScratchAllocator::Alloc(size_t bytes)
+{
+    return JobAlloc((SizeT)bytes);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void*
+JobScratchAllocator::Realloc(void* ptr, size_t oldBytes, size_t newBytes)
+{
+    return JobRealloc(ptr, (SizeT)oldBytes, (SizeT)newBytes);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+JobScratchAllocator::Free(void* ptr, size_t bytes)
+{
+    // released with the scratch buffer
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -172,7 +274,7 @@ JobDispatch(
     , const SizeT numInvocations
     , const SizeT groupSize
     , const CTX& context
-    , const Util::FixedArray<const Threading::AtomicCounter*>& waitCounters = nullptr
+    , const JobWaitCounters& waitCounters = nullptr
     , Threading::AtomicCounter* doneCounter = nullptr
     , Threading::Event* signalEvent = nullptr
 )
@@ -242,7 +344,7 @@ JobDispatch(
     const JobFunc& func
     , const SizeT numInvocations
     , const CTX& context
-    , const Util::FixedArray<const Threading::AtomicCounter*>& waitCounters = nullptr
+    , const JobWaitCounters& waitCounters = nullptr
     , Threading::AtomicCounter* doneCounter = nullptr
     , Threading::Event* signalEvent = nullptr
 )
@@ -0,0 +1,333 @@
+//------------------------------------------------------------------------------
+//  batch.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "math/batch.h"
+
+namespace Math
+{
+
+static const SizeT BatchSize = 8;
+
+//------------------------------------------------------------------------------
+/**
+    The affine part of 8 matrices, m[row][column] holds that element of
+    all of them, or the same element 8 times if built from a single matrix.
+*/
+struct AffineMatrixx8
+{
+    float8 m[4][3];
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+static __forceinline void
+SplatMatrix(AffineMatrixx8& out, const mat4& m)
+{
+    IndexT row;
+    for (row = 0; row < 4; row++)
+    {
+        out.m[row][0] = float8(m.m[row][0]);
+        out.m[row][1] = float8(m.m[row][1]);
+        out.m[row][2] = float8(m.m[row][2]);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static __forceinline void
+TransposeMatrices(AffineMatrixx8& out, const mat4* m)
+{
+    IndexT row;
+    for (row = 0; row < 4; row++)
+    {
+        float8 w;
+        load_transpose(&m->m[row][0], 16, out.m[row][0], out.m[row][1], out.m[row][2], w);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static __forceinline vec3x8
+TransformPoint(const AffineMatrixx8& m, const vec3x8& p)
+{
+    return vec3x8(
+        multiplyadd(p.x, m.m[0][0], multiplyadd(p.y, m.m[1][0], multiplyadd(p.z, m.m[2][0], m.m[3][0]))),
+        multiplyadd(p.x, m.m[0][1], multiplyadd(p.y, m.m[1][1], multiplyadd(p.z, m.m[2][1], m.m[3][1]))),
+        multiplyadd(p.x, m.m[0][2], multiplyadd(p.y, m.m[1][2], multiplyadd(p.z, m.m[2][2], m.m[3][2]))));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Copies the last count elements into a full batch, the unused slots
+    repeat the last element so they can't produce NaNs or denormals.
+*/
+template<class TYPE>
+static __forceinline void
+StageTail(TYPE* staged, const TYPE* in, SizeT count)
+{
+    IndexT i;
+    for (i = 0; i < BatchSize; i++)
+    {
+        staged[i] = in[i < count ? i : count - 1];
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class TYPE>
+static __forceinline void
+UnstageTail(TYPE* out, const TYPE* staged, SizeT count)
+{
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        out[i] = staged[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static __forceinline void
+TransformPointsBatch(point* out, const point* in, const AffineMatrixx8& m)
+{
+    vec3x8 p;
+    p.load(&in->x);
+    TransformPoint(m, p).store(&out->x, 1.0f);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+TransformPoints(point* out, const point* in, SizeT count, const mat4& m)
+{
+    AffineMatrixx8 splat;
+    SplatMatrix(splat, m);
+
+    IndexT i;
+    for (i = 0; i + BatchSize <= count; i += BatchSize)
+    {
+        TransformPointsBatch(out + i, in + i, splat);
+    }
+    if (i < count)
+    {
+        point staged[BatchSize];
+        StageTail(staged, in + i, count - i);
+        TransformPointsBatch(staged, staged, splat);
+        UnstageTail(out + i, staged, count - i);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Matrices are already 4 wide, so these stay in their own layout, but
+    the rows of m are broadcast once for the whole stream instead of once
+    per multiplication, and two rows of the result are computed at once.
+*/
+void
+TransformMatrices(mat4* out, const mat4* in, SizeT count, const mat4& m)
+{
+    const __m256 m0 = _mm256_broadcast_ps(&m.r[0].vec);
+    const __m256 m1 = _mm256_broadcast_ps(&m.r[1].vec);
+    const __m256 m2 = _mm256_broadcast_ps(&m.r[2].vec);
+    const __m256 m3 = _mm256_broadcast_ps(&m.r[3].vec);
+
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        const __m256 r01 = _mm256_loadu_ps(&in[i].m[0][0]);
+        const __m256 r23 = _mm256_loadu_ps(&in[i].m[2][0]);
+
+        float8 o01 = float8(_mm256_shuffle_ps(r01, r01, 0x00)) * m0;
+        o01 = multiplyadd(_mm256_shuffle_ps(r01, r01, 0x55), m1, o01);
+        o01 = multiplyadd(_mm256_shuffle_ps(r01, r01, 0xaa), m2, o01);
+        o01 = multiplyadd(_mm256_shuffle_ps(r01, r01, 0xff), m3, o01);
+
+        float8 o23 = float8(_mm256_shuffle_ps(r23, r23, 0x00)) * m0;
+        o23 = multiplyadd(_mm256_shuffle_ps(r23, r23, 0x55), m1, o23);
+        o23 = multiplyadd(_mm256_shuffle_ps(r23, r23, 0xaa), m2, o23);
+        o23 = multiplyadd(_mm256_shuffle_ps(r23, r23, 0xff), m3, o23);
+
+        o01.storeu(&out[i].m[0][0]);
+        o23.storeu(&out[i].m[2][0]);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Transforms the center of the boxes, and the extents by the absolute
+    of the matrix, which gives the same box as transforming all corners.
+*/
+static __forceinline void
+TransformBoxesBatch(bbox* out, const bbox* in, const AffineMatrixx8& m)
+{
+    // a bbox is 2 points, so the stride between the elements is 8 floats
+    float8 w;
+    vec3x8 pmin, pmax;
+    load_transpose(&in->pmin.x, 8, pmin.x, pmin.y, pmin.z, w);
+    load_transpose(&in->pmax.x, 8, pmax.x, pmax.y, pmax.z, w);
+
+    const float8 half(0.5f);
+    const vec3x8 center = TransformPoint(m, (pmin + pmax) * half);
+    const vec3x8 extents = (pmax - pmin) * half;
+
+    const vec3x8 newExtents(
+        multiplyadd(extents.x, abs(m.m[0][0]), multiplyadd(extents.y, abs(m.m[1][0]), extents.z * abs(m.m[2][0]))),
+        multiplyadd(extents.x, abs(m.m[0][1]), multiplyadd(extents.y, abs(m.m[1][1]), extents.z * abs(m.m[2][1]))),
+        multiplyadd(extents.x, abs(m.m[0][2]), multiplyadd(extents.y, abs(m.m[1][2]), extents.z * abs(m.m[2][2]))));
+
+    const float8 one(1.0f);
+    pmin = center - newExtents;
+    pmax = center + newExtents;
+    transpose_store(&out->pmin.x, 8, pmin.x, pmin.y, pmin.z, one);
+    transpose_store(&out->pmax.x, 8, pmax.x, pmax.y, pmax.z, one);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+TransformBoxes(bbox* out, const bbox* in, SizeT count, const mat4& m)
+{
+    AffineMatrixx8 splat;
+    SplatMatrix(splat, m);
+
+    IndexT i;
+    for (i = 0; i + BatchSize <= count; i += BatchSize)
+    {
+        TransformBoxesBatch(out + i, in + i, splat);
+    }
+    if (i < count)
+    {
+        bbox staged[BatchSize];
+        StageTail(staged, in + i, count - i);
+        TransformBoxesBatch(staged, staged, splat);
+        UnstageTail(out + i, staged, count - i);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+TransformBoxes(bbox* out, const bbox* in, const mat4* transforms, SizeT count)
+{
+    AffineMatrixx8 transposed;
+
+    IndexT i;
+    for (i = 0; i + BatchSize <= count; i += BatchSize)
+    {
+        TransposeMatrices(transposed, transforms + i);
+        TransformBoxesBatch(out + i, in + i, transposed);
+    }
+    if (i < count)
+    {
+        bbox staged[BatchSize];
+        mat4 stagedTransforms[BatchSize];
+        StageTail(staged, in + i, count - i);
+        StageTail(stagedTransforms, transforms + i, count - i);
+        TransposeMatrices(transposed, stagedTransforms);
+        TransformBoxesBatch(staged, staged, transposed);
+        UnstageTail(out + i, staged, count - i);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static __forceinline void
+NormalizeQuatsBatch(quat* out, const quat* in)
+{
+    quatx8 q;
+    q.load(in);
+    normalize(q).store(out);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+NormalizeQuats(quat* out, const quat* in, SizeT count)
+{
+    IndexT i;
+    for (i = 0; i + BatchSize <= count; i += BatchSize)
+    {
+        NormalizeQuatsBatch(out + i, in + i);
+    }
+    if (i < count)
+    {
+        quat staged[BatchSize];
+        StageTail(staged, in + i, count - i);
+        NormalizeQuatsBatch(staged, staged);
+        UnstageTail(out + i, staged, count - i);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<bool SPHERICAL>
+static __forceinline void
+InterpolateQuatsBatch(quat* out, const quat* q1, const quat* q2, const scalar* t)
+{
+    quatx8 from, to;
+    from.load(q1);
+    to.load(q2);
+    float8 weight;
+    weight.loadu(t);
+    if (SPHERICAL)
+        slerp(from, to, weight).store(out);
+    else
+        nlerp(from, to, weight).store(out);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<bool SPHERICAL>
+static void
+InterpolateQuats(quat* out, const quat* q1, const quat* q2, const scalar* t, SizeT count)
+{
+    IndexT i;
+    for (i = 0; i + BatchSize <= count; i += BatchSize)
+    {
+        InterpolateQuatsBatch<SPHERICAL>(out + i, q1 + i, q2 + i, t + i);
+    }
+    if (i < count)
+    {
+        quat stagedFrom[BatchSize], stagedTo[BatchSize];
+        scalar stagedWeights[BatchSize];
+        StageTail(stagedFrom, q1 + i, count - i);
+        StageTail(stagedTo, q2 + i, count - i);
+        StageTail(stagedWeights, t + i, count - i);
+        InterpolateQuatsBatch<SPHERICAL>(stagedFrom, stagedFrom, stagedTo, stagedWeights);
+        UnstageTail(out + i, stagedFrom, count - i);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+SlerpQuats(quat* out, const quat* q1, const quat* q2, const scalar* t, SizeT count)
+{
+    InterpolateQuats<true>(out, q1, q2, t, count);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+NlerpQuats(quat* out, const quat* q1, const quat* q2, const scalar* t, SizeT count)
+{
+    InterpolateQuats<false>(out, q1, q2, t, count);
+}
+
+} // namespace Math
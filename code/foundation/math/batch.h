@@ -0,0 +1,47 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file batch.h
+
+    Stream functions which apply the same operation to many elements. The
+    elements are kept in their usual array of structures layout in memory,
+    and are transposed 8 at a time into the structure of arrays types
+    Math::vec3x8 and Math::quatx8, which keep all 8 lanes of a register
+    busy instead of spending a quarter of every vector on w.
+
+    Input and output may be the same array. A count which is not a
+    multiple of 8 is fine, the remainder is run through a padded batch so
+    it gets exactly the same results as the rest.
+
+    The matrices passed in are expected to be affine.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "math/vec3x8.h"
+#include "math/quatx8.h"
+#include "math/mat4.h"
+#include "math/point.h"
+#include "math/bbox.h"
+
+//------------------------------------------------------------------------------
+namespace Math
+{
+
+/// transform points, out[i] = m * in[i]
+void TransformPoints(point* out, const point* in, SizeT count, const mat4& m);
+/// transform matrices, out[i] = m * in[i]
+void TransformMatrices(mat4* out, const mat4* in, SizeT count, const mat4& m);
+/// transform bounding boxes by the same matrix, same as bbox::affine_transform()
+void TransformBoxes(bbox* out, const bbox* in, SizeT count, const mat4& m);
+/// transform each bounding box by its own matrix, same as bbox::affine_transform()
+void TransformBoxes(bbox* out, const bbox* in, const mat4* transforms, SizeT count);
+/// normalize quaternions
+void NormalizeQuats(quat* out, const quat* in, SizeT count);
+/// spherical linear interpolation, out[i] = slerp(q1[i], q2[i], t[i])
+void SlerpQuats(quat* out, const quat* q1, const quat* q2, const scalar* t, SizeT count);
+/// normalized linear interpolation, out[i] = nlerp(q1[i], q2[i], t[i])
+void NlerpQuats(quat* out, const quat* q1, const quat* q2, const scalar* t, SizeT count);
+
+} // namespace Math
+//------------------------------------------------------------------------------
@@ -0,0 +1,334 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @struct Math::float8
+
+    Eight floats in one AVX register, the building block for the structure
+    of arrays types Math::vec3x8 and Math::quatx8. Where vec4 holds the
+    components of one vector, a float8 holds the same component of 8
+    vectors, so no lane is wasted on w and no shuffles are needed for
+    dot products.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+#include "math/scalar.h"
+#include <immintrin.h>
+
+//------------------------------------------------------------------------------
+namespace Math
+{
+struct float8
+{
+public:
+    /// default constructor, NOTE: does NOT setup components!
+    float8() = default;
+    /// construct from single value
+    float8(scalar v);
+    /// construct from AVX 256 bit float array
+    float8(const __m256& rhs);
+
+    /// load content from 32-byte-aligned memory
+    void load(const scalar* ptr);
+    /// load content from unaligned memory
+    void loadu(const scalar* ptr);
+    /// write content to 32-byte-aligned memory
+    void store(scalar* ptr) const;
+    /// write content to unaligned memory
+    void storeu(scalar* ptr) const;
+
+    /// inplace add
+    void operator+=(const float8& rhs);
+    /// inplace sub
+    void operator-=(const float8& rhs);
+    /// inplace multiply
+    void operator*=(const float8& rhs);
+
+    __m256 vec;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline
+float8::float8(scalar v)
+{
+    this->vec = _mm256_set1_ps(v);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline
+float8::float8(const __m256& rhs)
+{
+    this->vec = rhs;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+float8::load(const scalar* ptr)
+{
+    this->vec = _mm256_load_ps(ptr);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+float8::loadu(const scalar* ptr)
+{
+    this->vec = _mm256_loadu_ps(ptr);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+float8::store(scalar* ptr) const
+{
+    _mm256_store_ps(ptr, this->vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+float8::storeu(scalar* ptr) const
+{
+    _mm256_storeu_ps(ptr, this->vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+float8::operator+=(const float8& rhs)
+{
+    this->vec = _mm256_add_ps(this->vec, rhs.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+float8::operator-=(const float8& rhs)
+{
+    this->vec = _mm256_sub_ps(this->vec, rhs.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+float8::operator*=(const float8& rhs)
+{
+    this->vec = _mm256_mul_ps(this->vec, rhs.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+operator-(const float8& lhs)
+{
+    return _mm256_xor_ps(lhs.vec, _mm256_set1_ps(-0.0f));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+operator+(const float8& lhs, const float8& rhs)
+{
+    return _mm256_add_ps(lhs.vec, rhs.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+operator-(const float8& lhs, const float8& rhs)
+{
+    return _mm256_sub_ps(lhs.vec, rhs.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+operator*(const float8& lhs, const float8& rhs)
+{
+    return _mm256_mul_ps(lhs.vec, rhs.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+operator/(const float8& lhs, const float8& rhs)
+{
+    return _mm256_div_ps(lhs.vec, rhs.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+    (v0 * v1) + v2, fused if the build targets FMA
+*/
+__forceinline float8
+multiplyadd(const float8& v0, const float8& v1, const float8& v2)
+{
+#if N_USE_FMA
+    return _mm256_fmadd_ps(v0.vec, v1.vec, v2.vec);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(v0.vec, v1.vec), v2.vec);
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+minimize(const float8& v0, const float8& v1)
+{
+    return _mm256_min_ps(v0.vec, v1.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+maximize(const float8& v0, const float8& v1)
+{
+    return _mm256_max_ps(v0.vec, v1.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+abs(const float8& v)
+{
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+sqrt(const float8& v)
+{
+    return _mm256_sqrt_ps(v.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+reciprocal(const float8& v)
+{
+    return _mm256_div_ps(_mm256_set1_ps(1.0f), v.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Approximate 1 / sqrt(v), with one Newton-Raphson step the result is
+    accurate to about 22 bits.
+*/
+__forceinline float8
+reciprocalsqrt(const float8& v)
+{
+    const __m256 est = _mm256_rsqrt_ps(v.vec);
+    const __m256 estSq = _mm256_mul_ps(est, est);
+    const __m256 half = _mm256_mul_ps(est, _mm256_set1_ps(0.5f));
+    return _mm256_mul_ps(half, _mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(v.vec, estSq)));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Lane mask of v0 < v1, for use with select()
+*/
+__forceinline float8
+less(const float8& v0, const float8& v1)
+{
+    return _mm256_cmp_ps(v0.vec, v1.vec, _CMP_LT_OQ);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Lane mask of v0 > v1, for use with select()
+*/
+__forceinline float8
+greater(const float8& v0, const float8& v1)
+{
+    return _mm256_cmp_ps(v0.vec, v1.vec, _CMP_GT_OQ);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Per lane mask ? v1 : v0
+*/
+__forceinline float8
+select(const float8& v0, const float8& v1, const float8& mask)
+{
+    return _mm256_blendv_ps(v0.vec, v1.vec, mask.vec);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Loads 8 consecutive 4 component elements, stride floats apart, and
+    transposes them so that x, y, z and w each hold one component of all
+    8 elements.
+*/
+__forceinline void
+load_transpose(const scalar* ptr, SizeT stride, float8& x, float8& y, float8& z, float8& w)
+{
+    const __m256 t0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptr + 0 * stride)), _mm_loadu_ps(ptr + 4 * stride), 1);
+    const __m256 t1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptr + 1 * stride)), _mm_loadu_ps(ptr + 5 * stride), 1);
+    const __m256 t2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptr + 2 * stride)), _mm_loadu_ps(ptr + 6 * stride), 1);
+    const __m256 t3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptr + 3 * stride)), _mm_loadu_ps(ptr + 7 * stride), 1);
+
+    const __m256 xy01 = _mm256_unpacklo_ps(t0, t1);
+    const __m256 zw01 = _mm256_unpackhi_ps(t0, t1);
+    const __m256 xy23 = _mm256_unpacklo_ps(t2, t3);
+    const __m256 zw23 = _mm256_unpackhi_ps(t2, t3);
+
+    x = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(1, 0, 1, 0));
+    y = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 2, 3, 2));
+    z = _mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(1, 0, 1, 0));
+    w = _mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Inverse of load_transpose(), writes 8 elements of 4 components, stride
+    floats apart.
+*/
+__forceinline void
+transpose_store(scalar* ptr, SizeT stride, const float8& x, const float8& y, const float8& z, const float8& w)
+{
+    const __m256 xy01 = _mm256_unpacklo_ps(x.vec, y.vec);
+    const __m256 xy23 = _mm256_unpackhi_ps(x.vec, y.vec);
+    const __m256 zw01 = _mm256_unpacklo_ps(z.vec, w.vec);
+    const __m256 zw23 = _mm256_unpackhi_ps(z.vec, w.vec);
+
+    const __m256 t0 = _mm256_shuffle_ps(xy01, zw01, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 t1 = _mm256_shuffle_ps(xy01, zw01, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 t2 = _mm256_shuffle_ps(xy23, zw23, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 t3 = _mm256_shuffle_ps(xy23, zw23, _MM_SHUFFLE(3, 2, 3, 2));
+
+    _mm_storeu_ps(ptr + 0 * stride, _mm256_castps256_ps128(t0));
+    _mm_storeu_ps(ptr + 1 * stride, _mm256_castps256_ps128(t1));
+    _mm_storeu_ps(ptr + 2 * stride, _mm256_castps256_ps128(t2));
+    _mm_storeu_ps(ptr + 3 * stride, _mm256_castps256_ps128(t3));
+    _mm_storeu_ps(ptr + 4 * stride, _mm256_extractf128_ps(t0, 1));
+    _mm_storeu_ps(ptr + 5 * stride, _mm256_extractf128_ps(t1, 1));
+    _mm_storeu_ps(ptr + 6 * stride, _mm256_extractf128_ps(t2, 1));
+    _mm_storeu_ps(ptr + 7 * stride, _mm256_extractf128_ps(t3, 1));
+}
+
+} // namespace Math
+//------------------------------------------------------------------------------
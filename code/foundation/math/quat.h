@@ -18,7 +18,20 @@ namespace Math
 {
 struct quat;
 
+// coefficients of the polynomial slerp estimate, see slerp()
+static const float _slerp_u[8] =
+{
+    1.0f / (1 * 3), 1.0f / (2 * 5), 1.0f / (3 * 7), 1.0f / (4 * 9),
+    1.0f / (5 * 11), 1.0f / (6 * 13), 1.0f / (7 * 15), 1.85298109240830f / (8 * 17)
+};
+static const float _slerp_v[8] =
+{
+    1.0f / 3, 2.0f / 5, 3.0f / 7, 4.0f / 9,
+    5.0f / 11, 6.0f / 13, 7.0f / 15, 1.85298109240830f * 8 / 17
+};
+
 quat slerp(const quat& q1, const quat& q2, scalar t);
+quat nlerp(const quat& q1, const quat& q2, scalar t);
 
 quat rotationmatrix(const mat4& m);
 vec3 to_euler(const quat& q);
@@ -456,52 +469,56 @@ rotationquataxis(const vec3& axis, scalar angle)
 
 //------------------------------------------------------------------------------
 /**
-    quat slerp
-    TODO: rewrite using sse/avx
+    Spherical linear interpolation along the shorter arc.
+
+    Instead of acos() and sin(), sin(t * a) / sin(a) is estimated with a
+    polynomial in cos(a) and t (D. Eberly, "A Fast and Accurate Algorithm
+    for Computing SLERP"), which has no branches and is accurate to 3e-5
+    for any angle. The weights for t and 1 - t are computed side by side
+    in one register.
 */
 __forceinline quat
 slerp(const quat& q1, const quat& q2, scalar t)
 {
-    __m128 to;
+    const __m128 signMask = _mm_castsi128_ps(_sign);
+    const __m128 cosAngle = _mm_dp_ps(q1.vec, q2.vec, 0xff);
+    const __m128 to = _mm_xor_ps(q2.vec, _mm_and_ps(cosAngle, signMask));
+    const __m128 xm1 = _mm_sub_ps(_mm_andnot_ps(signMask, cosAngle), _plus1);
 
-    float qdot = dot(q1, q2);
-    // flip when negative angle
-    if (qdot < 0)
+    const __m128 ts = _mm_setr_ps(t, 1.0f - t, t, 1.0f - t);
+    const __m128 tsSq = _mm_mul_ps(ts, ts);
+    __m128 c = _plus1;
+    IndexT i;
+    for (i = 7; i >= 0; i--)
     {
-        qdot = -qdot;
-        to = _mm_mul_ps(q2.vec, _mm_set_ps1(-1.0f));
-    }
-    else
-    {
-        to = q2.vec;
+        const __m128 b = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(_slerp_u[i]), tsSq), _mm_set1_ps(_slerp_v[i])), xm1);
+        c = fmadd(b, c, _plus1);
     }
+    c = _mm_mul_ps(c, ts);
 
-    // just lerp when angle between is narrow
-    if (qdot < 0.95f)
-    {
-        //dont break acos
-        float clamped = Math::clamp(qdot, -1.0f, 1.0f);
-        float angle = Math::acos(clamped);
-
-        float sin_angle = Math::sin(angle);
-        float sin_angle_t = Math::sin(angle * t);
-        float sin_omega_t = Math::sin(angle * (1.0f - t));
-
-        __m128 s0 = _mm_set_ps1(sin_omega_t);
-        __m128 s1 = _mm_set_ps1(sin_angle_t);
-        __m128 sin_div = _mm_set_ps1(1.0f / sin_angle);
-        return  _mm_mul_ps(_mm_add_ps(_mm_mul_ps(q1.vec, s0), _mm_mul_ps(to, s1)), sin_div);
-    }
-    else
-    {
+    const __m128 scale1 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 scale0 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(1, 1, 1, 1));
+    return fmadd(q1.vec, scale0, _mm_mul_ps(to, scale1));
+}
 
-        float scale0 = 1.0f - t;
-        float scale1 = t;
-        __m128 s0 = _mm_set_ps1(scale0);
-        __m128 s1 = _mm_set_ps1(scale1);
+//------------------------------------------------------------------------------
+/**
+    Normalized linear interpolation along the shorter arc.
 
-        return _mm_add_ps(_mm_mul_ps(q1.vec, s0), _mm_mul_ps(to, s1));
-    }
+    Cheaper than slerp(), but the angle doesn't advance evenly with t. The
+    worst case error of the resulting rotation, depending on the angle
+    between q1 and q2, is 0.033 degrees at 30, 0.11 at 45, 0.92 at 90 and
+    8.1 at 180 degrees, so it is a good fit for keys or poses which are
+    close to each other.
+*/
+__forceinline quat
+nlerp(const quat& q1, const quat& q2, scalar t)
+{
+    const __m128 signMask = _mm_castsi128_ps(_sign);
+    const __m128 cosAngle = _mm_dp_ps(q1.vec, q2.vec, 0xff);
+    const __m128 to = _mm_xor_ps(q2.vec, _mm_and_ps(cosAngle, signMask));
+    const __m128 res = fmadd(_mm_sub_ps(to, q1.vec), _mm_set1_ps(t), q1.vec);
+    return _mm_div_ps(res, _mm_sqrt_ps(_mm_dp_ps(res, res, 0xff)));
 }
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,190 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @struct Math::quatx8
+
+    Eight quaternions in structure of arrays layout, one Math::float8 per
+    component. The operations follow the conventions of Math::quat, so
+    q0 * q1 applies q0 first, then q1.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "math/float8.h"
+#include "math/vec3x8.h"
+#include "math/quat.h"
+
+//------------------------------------------------------------------------------
+namespace Math
+{
+struct quatx8
+{
+public:
+    /// default constructor, NOTE: does NOT setup components!
+    quatx8() = default;
+    /// construct from components
+    quatx8(const float8& x, const float8& y, const float8& z, const float8& w);
+    /// construct by splatting a single quaternion
+    explicit quatx8(const quat& q);
+
+    /// load 8 consecutive quaternions
+    void load(const quat* ptr);
+    /// store 8 consecutive quaternions
+    void store(quat* ptr) const;
+
+    float8 x, y, z, w;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline
+quatx8::quatx8(const float8& x, const float8& y, const float8& z, const float8& w) :
+    x(x),
+    y(y),
+    z(z),
+    w(w)
+{
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline
+quatx8::quatx8(const quat& q) :
+    x(q.x),
+    y(q.y),
+    z(q.z),
+    w(q.w)
+{
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+quatx8::load(const quat* ptr)
+{
+    load_transpose(&ptr->x, 4, this->x, this->y, this->z, this->w);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+quatx8::store(quat* ptr) const
+{
+    transpose_store(&ptr->x, 4, this->x, this->y, this->z, this->w);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+dot(const quatx8& q0, const quatx8& q1)
+{
+    return multiplyadd(q0.x, q1.x, multiplyadd(q0.y, q1.y, multiplyadd(q0.z, q1.z, q0.w * q1.w)));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline quatx8
+conjugate(const quatx8& q)
+{
+    return quatx8(-q.x, -q.y, -q.z, q.w);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline quatx8
+normalize(const quatx8& q)
+{
+    const float8 invLen = reciprocal(sqrt(dot(q, q)));
+    return quatx8(q.x * invLen, q.y * invLen, q.z * invLen, q.w * invLen);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Same as operator*(const quat&, const quat&), the rotation q0 followed by q1
+*/
+__forceinline quatx8
+operator*(const quatx8& q0, const quatx8& q1)
+{
+    return quatx8(
+        multiplyadd(q1.w, q0.x, multiplyadd(q1.x, q0.w, q1.y * q0.z - q1.z * q0.y)),
+        multiplyadd(q1.w, q0.y, multiplyadd(q1.y, q0.w, q1.z * q0.x - q1.x * q0.z)),
+        multiplyadd(q1.w, q0.z, multiplyadd(q1.z, q0.w, q1.x * q0.y - q1.y * q0.x)),
+        q1.w * q0.w - multiplyadd(q1.x, q0.x, multiplyadd(q1.y, q0.y, q1.z * q0.z)));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Spherical linear interpolation along the shorter arc, with the same
+    polynomial estimate as slerp(const quat&, const quat&, scalar)
+*/
+__forceinline quatx8
+slerp(const quatx8& q1, const quatx8& q2, const float8& t)
+{
+    const float8 signMask(-0.0f);
+    const float8 cosAngle = dot(q1, q2);
+    const float8 flip = _mm256_and_ps(cosAngle.vec, signMask.vec);
+    const float8 xm1 = abs(cosAngle) - float8(1.0f);
+
+    const float8 s = float8(1.0f) - t;
+    const float8 tSq = t * t;
+    const float8 sSq = s * s;
+    float8 ct(1.0f), cs(1.0f);
+    IndexT i;
+    for (i = 7; i >= 0; i--)
+    {
+        const float8 u(_slerp_u[i]);
+        const float8 v(_slerp_v[i]);
+        ct = multiplyadd((u * tSq - v) * xm1, ct, float8(1.0f));
+        cs = multiplyadd((u * sSq - v) * xm1, cs, float8(1.0f));
+    }
+
+    // the sign of the angle goes into the weight of q2
+    const float8 scale1 = _mm256_xor_ps((ct * t).vec, flip.vec);
+    const float8 scale0 = cs * s;
+    return quatx8(
+        multiplyadd(q1.x, scale0, q2.x * scale1),
+        multiplyadd(q1.y, scale0, q2.y * scale1),
+        multiplyadd(q1.z, scale0, q2.z * scale1),
+        multiplyadd(q1.w, scale0, q2.w * scale1));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Normalized linear interpolation along the shorter arc, see
+    nlerp(const quat&, const quat&, scalar) for the error bounds
+*/
+__forceinline quatx8
+nlerp(const quatx8& q1, const quatx8& q2, const float8& t)
+{
+    const float8 flip = _mm256_and_ps(dot(q1, q2).vec, _mm256_set1_ps(-0.0f));
+    const float8 scale1 = _mm256_xor_ps(t.vec, flip.vec);
+    const float8 scale0 = float8(1.0f) - t;
+    return normalize(quatx8(
+        multiplyadd(q1.x, scale0, q2.x * scale1),
+        multiplyadd(q1.y, scale0, q2.y * scale1),
+        multiplyadd(q1.z, scale0, q2.z * scale1),
+        multiplyadd(q1.w, scale0, q2.w * scale1)));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Rotate vectors by quaternions, see rotate(const quat&, const vec3&)
+*/
+__forceinline vec3x8
+rotate(const quatx8& q, const vec3x8& v)
+{
+    const vec3x8 i(q.x, q.y, q.z);
+    const vec3x8 qxv = cross(i, v);
+    const vec3x8 rot = cross(i, multiplyadd(v, q.w, qxv)) * float8(2.0f);
+    return v + rot;
+}
+
+} // namespace Math
+//------------------------------------------------------------------------------
@@ -0,0 +1,375 @@
+//------------------------------------------------------------------------------
+//  simdkernels.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "math/simdkernels.h"
+
+namespace Math
+{
+
+using namespace System;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+MultiplyMatricesGeneric(mat4* out, const mat4* lhs, const mat4* rhs, SizeT count)
+{
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        out[i] = lhs[i] * rhs[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Same as the AVX operator*, two rows of the result per register, with
+    fused multiply-adds.
+*/
+N_TARGET_AVX2 static void
+MultiplyMatricesAVX2(mat4* out, const mat4* lhs, const mat4* rhs, SizeT count)
+{
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        const float* l = &lhs[i].m[0][0];
+        const __m256 l0 = _mm256_broadcast_ps((const __m128*)(l + 0));
+        const __m256 l1 = _mm256_broadcast_ps((const __m128*)(l + 4));
+        const __m256 l2 = _mm256_broadcast_ps((const __m128*)(l + 8));
+        const __m256 l3 = _mm256_broadcast_ps((const __m128*)(l + 12));
+        const __m256 r01 = _mm256_loadu_ps(&rhs[i].m[0][0]);
+        const __m256 r23 = _mm256_loadu_ps(&rhs[i].m[2][0]);
+
+        __m256 o01 = _mm256_mul_ps(_mm256_shuffle_ps(r01, r01, 0x00), l0);
+        o01 = _mm256_fmadd_ps(_mm256_shuffle_ps(r01, r01, 0x55), l1, o01);
+        o01 = _mm256_fmadd_ps(_mm256_shuffle_ps(r01, r01, 0xaa), l2, o01);
+        o01 = _mm256_fmadd_ps(_mm256_shuffle_ps(r01, r01, 0xff), l3, o01);
+
+        __m256 o23 = _mm256_mul_ps(_mm256_shuffle_ps(r23, r23, 0x00), l0);
+        o23 = _mm256_fmadd_ps(_mm256_shuffle_ps(r23, r23, 0x55), l1, o23);
+        o23 = _mm256_fmadd_ps(_mm256_shuffle_ps(r23, r23, 0xaa), l2, o23);
+        o23 = _mm256_fmadd_ps(_mm256_shuffle_ps(r23, r23, 0xff), l3, o23);
+
+        _mm256_storeu_ps(&out[i].m[0][0], o01);
+        _mm256_storeu_ps(&out[i].m[2][0], o23);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    A whole matrix per register, each 128 bit lane computes one row.
+*/
+N_TARGET_AVX512 static void
+MultiplyMatricesAVX512(mat4* out, const mat4* lhs, const mat4* rhs, SizeT count)
+{
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        const float* l = &lhs[i].m[0][0];
+        const __m512 l0 = _mm512_broadcast_f32x4(_mm_loadu_ps(l + 0));
+        const __m512 l1 = _mm512_broadcast_f32x4(_mm_loadu_ps(l + 4));
+        const __m512 l2 = _mm512_broadcast_f32x4(_mm_loadu_ps(l + 8));
+        const __m512 l3 = _mm512_broadcast_f32x4(_mm_loadu_ps(l + 12));
+        const __m512 r = _mm512_loadu_ps(&rhs[i].m[0][0]);
+
+        __m512 o = _mm512_mul_ps(_mm512_permute_ps(r, 0x00), l0);
+        o = _mm512_fmadd_ps(_mm512_permute_ps(r, 0x55), l1, o);
+        o = _mm512_fmadd_ps(_mm512_permute_ps(r, 0xaa), l2, o);
+        o = _mm512_fmadd_ps(_mm512_permute_ps(r, 0xff), l3, o);
+        _mm512_storeu_ps(&out[i].m[0][0], o);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+MultiplyMatrices(mat4* out, const mat4* lhs, const mat4* rhs, SizeT count)
+{
+    typedef void (*Func)(mat4*, const mat4*, const mat4*, SizeT);
+    static const Func Table[Cpu::NumSimdLevels] =
+    {
+        MultiplyMatricesGeneric,
+        MultiplyMatricesAVX2,
+        MultiplyMatricesAVX512
+    };
+    Table[Cpu::GetSimdLevel()](out, lhs, rhs, count);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+LerpMatricesGeneric(mat4* out, const mat4* from, const mat4* to, scalar t, SizeT count)
+{
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        out[i].r[0] = lerp(from[i].r[0], to[i].r[0], t);
+        out[i].r[1] = lerp(from[i].r[1], to[i].r[1], t);
+        out[i].r[2] = lerp(from[i].r[2], to[i].r[2], t);
+        out[i].r[3] = lerp(from[i].r[3], to[i].r[3], t);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Two rows per register, from + (to - from) * t as a single fused multiply-add.
+*/
+N_TARGET_AVX2 static void
+LerpMatricesAVX2(mat4* out, const mat4* from, const mat4* to, scalar t, SizeT count)
+{
+    const __m256 weight = _mm256_set1_ps(t);
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        const __m256 f01 = _mm256_loadu_ps(&from[i].m[0][0]);
+        const __m256 f23 = _mm256_loadu_ps(&from[i].m[2][0]);
+        const __m256 t01 = _mm256_loadu_ps(&to[i].m[0][0]);
+        const __m256 t23 = _mm256_loadu_ps(&to[i].m[2][0]);
+        _mm256_storeu_ps(&out[i].m[0][0], _mm256_fmadd_ps(_mm256_sub_ps(t01, f01), weight, f01));
+        _mm256_storeu_ps(&out[i].m[2][0], _mm256_fmadd_ps(_mm256_sub_ps(t23, f23), weight, f23));
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX512 static void
+LerpMatricesAVX512(mat4* out, const mat4* from, const mat4* to, scalar t, SizeT count)
+{
+    const __m512 weight = _mm512_set1_ps(t);
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        const __m512 f = _mm512_loadu_ps(&from[i].m[0][0]);
+        const __m512 d = _mm512_sub_ps(_mm512_loadu_ps(&to[i].m[0][0]), f);
+        _mm512_storeu_ps(&out[i].m[0][0], _mm512_fmadd_ps(d, weight, f));
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+LerpMatrices(mat4* out, const mat4* from, const mat4* to, scalar t, SizeT count)
+{
+    typedef void (*Func)(mat4*, const mat4*, const mat4*, scalar, SizeT);
+    static const Func Table[Cpu::NumSimdLevels] =
+    {
+        LerpMatricesGeneric,
+        LerpMatricesAVX2,
+        LerpMatricesAVX512
+    };
+    Table[Cpu::GetSimdLevel()](out, from, to, t, count);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+ClipBoxesGeneric(ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, SizeT count, const mat4& viewProjection, bool isOrtho)
+{
+    vec4 colX[4], colY[4], colZ[4], colW[4];
+    IndexT i;
+    for (i = 0; i < 4; i++)
+    {
+        colX[i] = splat_x(viewProjection.r[i]);
+        colY[i] = splat_y(viewProjection.r[i]);
+        colZ[i] = splat_z(viewProjection.r[i]);
+        colW[i] = splat_w(viewProjection.r[i]);
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (inOutStatus[i] == ClipStatus::Outside)
+            inOutStatus[i] = boxes[ids[i]].clipstatus(colX, colY, colZ, colW, isOrtho);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Transforms all 8 corners of a box at once, one corner per lane, and
+    tests them against all 6 planes. The box is outside if all corners are
+    outside of the same plane, and inside if no corner is outside of any.
+*/
+N_TARGET_AVX2 static void
+ClipBoxesAVX2(ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, SizeT count, const mat4& viewProjection, bool isOrtho)
+{
+    __m256 mx[4], my[4], mz[4], mw[4];
+    IndexT i;
+    for (i = 0; i < 4; i++)
+    {
+        mx[i] = _mm256_set1_ps(viewProjection.m[i][0]);
+        my[i] = _mm256_set1_ps(viewProjection.m[i][1]);
+        mz[i] = _mm256_set1_ps(viewProjection.m[i][2]);
+        mw[i] = _mm256_set1_ps(viewProjection.m[i][3]);
+    }
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+    for (i = 0; i < count; i++)
+    {
+        if (inOutStatus[i] != ClipStatus::Outside)
+            continue;
+
+        const bbox& box = boxes[ids[i]];
+        const __m256 x = _mm256_blend_ps(_mm256_set1_ps(box.pmin.x), _mm256_set1_ps(box.pmax.x), 0xaa);
+        const __m256 y = _mm256_blend_ps(_mm256_set1_ps(box.pmin.y), _mm256_set1_ps(box.pmax.y), 0xcc);
+        const __m256 z = _mm256_blend_ps(_mm256_set1_ps(box.pmin.z), _mm256_set1_ps(box.pmax.z), 0xf0);
+
+        const __m256 cx = _mm256_fmadd_ps(mx[2], z, _mm256_fmadd_ps(mx[1], y, _mm256_fmadd_ps(mx[0], x, mx[3])));
+        const __m256 cy = _mm256_fmadd_ps(my[2], z, _mm256_fmadd_ps(my[1], y, _mm256_fmadd_ps(my[0], x, my[3])));
+        const __m256 cz = _mm256_fmadd_ps(mz[2], z, _mm256_fmadd_ps(mz[1], y, _mm256_fmadd_ps(mz[0], x, mz[3])));
+        const __m256 cw = isOrtho ? one : _mm256_fmadd_ps(mw[2], z, _mm256_fmadd_ps(mw[1], y, _mm256_fmadd_ps(mw[0], x, mw[3])));
+        const __m256 ncw = _mm256_xor_ps(cw, signMask);
+
+        const int left = _mm256_movemask_ps(_mm256_cmp_ps(cx, ncw, _CMP_LT_OQ));
+        const int right = _mm256_movemask_ps(_mm256_cmp_ps(cx, cw, _CMP_GT_OQ));
+        const int bottom = _mm256_movemask_ps(_mm256_cmp_ps(cy, ncw, _CMP_LT_OQ));
+        const int top = _mm256_movemask_ps(_mm256_cmp_ps(cy, cw, _CMP_GT_OQ));
+        const int zFar = _mm256_movemask_ps(_mm256_cmp_ps(cz, ncw, _CMP_LT_OQ));
+        const int zNear = _mm256_movemask_ps(_mm256_cmp_ps(cz, cw, _CMP_GT_OQ));
+
+        if (0 == (left | right | bottom | top | zFar | zNear))
+            inOutStatus[i] = ClipStatus::Inside;
+        else if (0xff == left || 0xff == right || 0xff == bottom || 0xff == top || 0xff == zFar || 0xff == zNear)
+            inOutStatus[i] = ClipStatus::Outside;
+        else
+            inOutStatus[i] = ClipStatus::Clipped;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ClipBoxes(ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, SizeT count, const mat4& viewProjection, bool isOrtho)
+{
+    typedef void (*Func)(ClipStatus::Type*, const bbox*, const uint32*, SizeT, const mat4&, bool);
+    static const Func Table[Cpu::NumSimdLevels] =
+    {
+        ClipBoxesGeneric,
+        ClipBoxesAVX2,
+        ClipBoxesAVX2       // nothing to gain from wider registers with 8 corners per box
+    };
+    Table[Cpu::GetSimdLevel()](inOutStatus, boxes, ids, count, viewProjection, isOrtho);
+}
+
+//------------------------------------------------------------------------------
+/**
+    The view rotation keeps lengths, so the y row of the view projection
+    scales a length in the world to one in normalized device coordinates,
+    before the divide by w. The size is the radius of the bounding sphere
+    over half of the screen height of 2.
+*/
+static scalar
+ProjectionScaleY(const mat4& viewProjection)
+{
+    return length(vec3(viewProjection.m[0][1], viewProjection.m[1][1], viewProjection.m[2][1]));
+}
+
+/// a perspective w below which the box is considered to reach behind the eye
+static const scalar ProjectMinW = 1e-5f;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+ProjectBoxesGeneric(scalar* outSizes, scalar* outDistances, const bbox* boxes, const uint32* ids, SizeT count, const mat4& viewProjection, const point& eye, bool isOrtho)
+{
+    const scalar scaleY = ProjectionScaleY(viewProjection);
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        const bbox& box = boxes[ids[i]];
+        const scalar cx = (box.pmin.x + box.pmax.x) * 0.5f;
+        const scalar cy = (box.pmin.y + box.pmax.y) * 0.5f;
+        const scalar cz = (box.pmin.z + box.pmax.z) * 0.5f;
+        const scalar hx = (box.pmax.x - box.pmin.x) * 0.5f;
+        const scalar hy = (box.pmax.y - box.pmin.y) * 0.5f;
+        const scalar hz = (box.pmax.z - box.pmin.z) * 0.5f;
+        const scalar radius = Math::sqrt(hx * hx + hy * hy + hz * hz);
+
+        const scalar w = isOrtho ? 1.0f : viewProjection.m[0][3] * cx + viewProjection.m[1][3] * cy + viewProjection.m[2][3] * cz + viewProjection.m[3][3];
+        outSizes[i] = w > ProjectMinW ? radius * scaleY / w : FLT_MAX;
+
+        const scalar dx = cx - eye.x;
+        const scalar dy = cy - eye.y;
+        const scalar dz = cz - eye.z;
+        outDistances[i] = Math::sqrt(dx * dx + dy * dy + dz * dz);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Eight boxes at once, gathered by their ids. The last few go through the
+    generic variant.
+*/
+N_TARGET_AVX2 static void
+ProjectBoxesAVX2(scalar* outSizes, scalar* outDistances, const bbox* boxes, const uint32* ids, SizeT count, const mat4& viewProjection, const point& eye, bool isOrtho)
+{
+    const __m256 scale = _mm256_set1_ps(ProjectionScaleY(viewProjection));
+    const __m256 w0 = _mm256_set1_ps(viewProjection.m[0][3]);
+    const __m256 w1 = _mm256_set1_ps(viewProjection.m[1][3]);
+    const __m256 w2 = _mm256_set1_ps(viewProjection.m[2][3]);
+    const __m256 w3 = _mm256_set1_ps(viewProjection.m[3][3]);
+    const __m256 eyeX = _mm256_set1_ps(eye.x);
+    const __m256 eyeY = _mm256_set1_ps(eye.y);
+    const __m256 eyeZ = _mm256_set1_ps(eye.z);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minW = _mm256_set1_ps(ProjectMinW);
+    const __m256 maxSize = _mm256_set1_ps(FLT_MAX);
+
+    // a box is 8 floats, pmin and pmax with their w
+    const float* base = &boxes[0].pmin.x;
+    IndexT i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i index = _mm256_slli_epi32(_mm256_loadu_si256((const __m256i*)(ids + i)), 3);
+        const __m256 minX = _mm256_i32gather_ps(base + 0, index, 4);
+        const __m256 minY = _mm256_i32gather_ps(base + 1, index, 4);
+        const __m256 minZ = _mm256_i32gather_ps(base + 2, index, 4);
+        const __m256 maxX = _mm256_i32gather_ps(base + 4, index, 4);
+        const __m256 maxY = _mm256_i32gather_ps(base + 5, index, 4);
+        const __m256 maxZ = _mm256_i32gather_ps(base + 6, index, 4);
+
+        const __m256 cx = _mm256_mul_ps(_mm256_add_ps(minX, maxX), half);
+        const __m256 cy = _mm256_mul_ps(_mm256_add_ps(minY, maxY), half);
+        const __m256 cz = _mm256_mul_ps(_mm256_add_ps(minZ, maxZ), half);
+        const __m256 hx = _mm256_mul_ps(_mm256_sub_ps(maxX, minX), half);
+        const __m256 hy = _mm256_mul_ps(_mm256_sub_ps(maxY, minY), half);
+        const __m256 hz = _mm256_mul_ps(_mm256_sub_ps(maxZ, minZ), half);
+        const __m256 radius = _mm256_sqrt_ps(_mm256_fmadd_ps(hz, hz, _mm256_fmadd_ps(hy, hy, _mm256_mul_ps(hx, hx))));
+
+        const __m256 w = isOrtho ? one : _mm256_fmadd_ps(w2, cz, _mm256_fmadd_ps(w1, cy, _mm256_fmadd_ps(w0, cx, w3)));
+        const __m256 size = _mm256_div_ps(_mm256_mul_ps(radius, scale), w);
+        _mm256_storeu_ps(outSizes + i, _mm256_blendv_ps(maxSize, size, _mm256_cmp_ps(w, minW, _CMP_GT_OQ)));
+
+        const __m256 dx = _mm256_sub_ps(cx, eyeX);
+        const __m256 dy = _mm256_sub_ps(cy, eyeY);
+        const __m256 dz = _mm256_sub_ps(cz, eyeZ);
+        _mm256_storeu_ps(outDistances + i, _mm256_sqrt_ps(_mm256_fmadd_ps(dz, dz, _mm256_fmadd_ps(dy, dy, _mm256_mul_ps(dx, dx)))));
+    }
+    ProjectBoxesGeneric(outSizes + i, outDistances + i, boxes, ids + i, count - i, viewProjection, eye, isOrtho);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ProjectBoxes(scalar* outSizes, scalar* outDistances, const bbox* boxes, const uint32* ids, SizeT count, const mat4& viewProjection, const point& eye, bool isOrtho)
+{
+    typedef void (*Func)(scalar*, scalar*, const bbox*, const uint32*, SizeT, const mat4&, const point&, bool);
+    static const Func Table[Cpu::NumSimdLevels] =
+    {
+        ProjectBoxesGeneric,
+        ProjectBoxesAVX2,
+        ProjectBoxesAVX2    // the gathers are the bottleneck, not the width
+    };
+    Table[Cpu::GetSimdLevel()](outSizes, outDistances, boxes, ids, count, viewProjection, eye, isOrtho);
+}
+
+} // namespace Math
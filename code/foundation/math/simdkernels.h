@@ -0,0 +1,35 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file simdkernels.h
+
+    Bulk math kernels which are selected at runtime for the best instruction
+    set of the cpu, see System::Cpu::GetSimdLevel(). Each kernel exists in
+    a generic variant for the instruction set the build targets, and in
+    variants for AVX2/FMA and AVX-512 where these pay off. Since the choice
+    is made per call, these should only be used for batches, not single
+    elements.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "math/mat4.h"
+#include "math/bbox.h"
+#include "math/clipstatus.h"
+#include "system/cpu.h"
+
+//------------------------------------------------------------------------------
+namespace Math
+{
+
+/// multiply matrices pairwise, out[i] = lhs[i] * rhs[i], out may alias lhs or rhs
+void MultiplyMatrices(mat4* out, const mat4* lhs, const mat4* rhs, SizeT count);
+/// interpolate matrices component wise, out[i] = from[i] + (to[i] - from[i]) * t, out may alias from or to
+void LerpMatrices(mat4* out, const mat4* from, const mat4* to, scalar t, SizeT count);
+/// clip boxes[ids[i]] against a view projection, only entries of inOutStatus which are still Outside are updated
+void ClipBoxes(ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, SizeT count, const mat4& viewProjection, bool isOrtho);
+/// get the projected size of boxes[ids[i]] as a share of the screen height, and their distance to the eye, boxes reaching behind a perspective eye get FLT_MAX as size
+void ProjectBoxes(scalar* outSizes, scalar* outDistances, const bbox* boxes, const uint32* ids, SizeT count, const mat4& viewProjection, const point& eye, bool isOrtho);
+
+} // namespace Math
+//------------------------------------------------------------------------------
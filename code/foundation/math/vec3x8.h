@@ -0,0 +1,218 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @struct Math::vec3x8
+
+    Eight 3D vectors in structure of arrays layout, one Math::float8 per
+    component.
+
+    load() and store() convert from and to 8 consecutive vec3, point or
+    vector elements, all of which share the same 16 byte layout.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "math/float8.h"
+#include "math/vec3.h"
+
+//------------------------------------------------------------------------------
+namespace Math
+{
+struct vec3x8
+{
+public:
+    /// default constructor, NOTE: does NOT setup components!
+    vec3x8() = default;
+    /// construct from components
+    vec3x8(const float8& x, const float8& y, const float8& z);
+    /// construct by splatting a single vector
+    explicit vec3x8(const vec3& v);
+
+    /// load 8 elements of 4 floats each, w is ignored
+    void load(const scalar* ptr);
+    /// store 8 elements of 4 floats each, with w set to the given value
+    void store(scalar* ptr, scalar w) const;
+    /// load from 3 separate component streams
+    void load(const scalar* xs, const scalar* ys, const scalar* zs);
+    /// store to 3 separate component streams
+    void store(scalar* xs, scalar* ys, scalar* zs) const;
+
+    float8 x, y, z;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline
+vec3x8::vec3x8(const float8& x, const float8& y, const float8& z) :
+    x(x),
+    y(y),
+    z(z)
+{
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline
+vec3x8::vec3x8(const vec3& v) :
+    x(v.x),
+    y(v.y),
+    z(v.z)
+{
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+vec3x8::load(const scalar* ptr)
+{
+    float8 w;
+    load_transpose(ptr, 4, this->x, this->y, this->z, w);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+vec3x8::store(scalar* ptr, scalar w) const
+{
+    transpose_store(ptr, 4, this->x, this->y, this->z, float8(w));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+vec3x8::load(const scalar* xs, const scalar* ys, const scalar* zs)
+{
+    this->x.loadu(xs);
+    this->y.loadu(ys);
+    this->z.loadu(zs);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+vec3x8::store(scalar* xs, scalar* ys, scalar* zs) const
+{
+    this->x.storeu(xs);
+    this->y.storeu(ys);
+    this->z.storeu(zs);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline vec3x8
+operator+(const vec3x8& lhs, const vec3x8& rhs)
+{
+    return vec3x8(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline vec3x8
+operator-(const vec3x8& lhs, const vec3x8& rhs)
+{
+    return vec3x8(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline vec3x8
+operator*(const vec3x8& lhs, const float8& s)
+{
+    return vec3x8(lhs.x * s, lhs.y * s, lhs.z * s);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline vec3x8
+operator*(const vec3x8& lhs, const vec3x8& rhs)
+{
+    return vec3x8(lhs.x * rhs.x, lhs.y * rhs.y, lhs.z * rhs.z);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline vec3x8
+multiplyadd(const vec3x8& v0, const float8& s, const vec3x8& v2)
+{
+    return vec3x8(multiplyadd(v0.x, s, v2.x), multiplyadd(v0.y, s, v2.y), multiplyadd(v0.z, s, v2.z));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+dot(const vec3x8& v0, const vec3x8& v1)
+{
+    return multiplyadd(v0.x, v1.x, multiplyadd(v0.y, v1.y, v0.z * v1.z));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline vec3x8
+cross(const vec3x8& v0, const vec3x8& v1)
+{
+    return vec3x8(
+        v0.y * v1.z - v0.z * v1.y,
+        v0.z * v1.x - v0.x * v1.z,
+        v0.x * v1.y - v0.y * v1.x);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+lengthsq(const vec3x8& v)
+{
+    return dot(v, v);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline float8
+length(const vec3x8& v)
+{
+    return sqrt(dot(v, v));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline vec3x8
+normalize(const vec3x8& v)
+{
+    return v * reciprocal(length(v));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline vec3x8
+minimize(const vec3x8& v0, const vec3x8& v1)
+{
+    return vec3x8(minimize(v0.x, v1.x), minimize(v0.y, v1.y), minimize(v0.z, v1.z));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline vec3x8
+maximize(const vec3x8& v0, const vec3x8& v1)
+{
+    return vec3x8(maximize(v0.x, v1.x), maximize(v0.y, v1.y), maximize(v0.z, v1.z));
+}
+
+} // namespace Math
+//------------------------------------------------------------------------------
@@ -26,6 +26,8 @@ MemoryPageHandler::MemoryPageHandler()
     this->SetName("Memory");
     this->SetDesc("show memory debug information");
     this->SetRootLocation("memory");
+    // only reads the interlocked heap statistics
+    this->SetThreadSafe(true);
 }
 
 //------------------------------------------------------------------------------
@@ -42,6 +44,8 @@ MemoryPageHandler::HandleRequest(const Ptr<HttpRequest>& request)
     htmlWriter->SetTitle("Nebula Memory Info");
     if (htmlWriter->Open())
     {
+        // set the status before writing, so the page can be streamed while it is generated
+        request->SetStatus(HttpStatus::OK);
         htmlWriter->Element(HtmlElement::Heading1, "Memory");
         htmlWriter->AddAttr("href", "/index.html");
         htmlWriter->Element(HtmlElement::Anchor, "Home");
@@ -168,7 +172,6 @@ MemoryPageHandler::HandleRequest(const Ptr<HttpRequest>& request)
 
         #endif // NEBULA_MEMORY_STATS
         htmlWriter->Close();
-        request->SetStatus(HttpStatus::OK);
     }
     else
     {
@@ -19,14 +19,76 @@
 #error "UNKNOWN PLATFORM"
 #endif
 
+namespace Memory
+{
+
+//------------------------------------------------------------------------------
+/**
+    The default allocator policy of the container classes, see Util::Array.
+
+    An allocator policy is a class with the static methods Alloc(), Realloc()
+    and Free(), which is passed as template argument to a container to
+    redirect its element buffer to a different memory source, for instance
+    a per-frame scratch buffer which is released in bulk.
+*/
+struct ObjectArrayHeapAllocator
+{
+    /// allocate a block of memory
+    static void* Alloc(size_t bytes);
+    /// grow or shrink a block of memory, the content is preserved up to the smaller size
+    static void* Realloc(void* ptr, size_t oldBytes, size_t newBytes);
+    /// free a block of memory
+    static void Free(void* ptr, size_t bytes);
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void*
+ObjectArrayHeapAllocator::Alloc(size_t bytes)
+{
+    return Memory::Alloc(Memory::ObjectArrayHeap, bytes);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void*
+ObjectArrayHeapAllocator::Realloc(void* ptr, size_t oldBytes, size_t newBytes)
+{
+    return Memory::Realloc(Memory::ObjectArrayHeap, ptr, newBytes);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+ObjectArrayHeapAllocator::Free(void* ptr, size_t bytes)
+{
+    Memory::Free(Memory::ObjectArrayHeap, ptr);
+}
+
 //------------------------------------------------------------------------------
 /**
+    Types which can be moved to a new address with a plain memory copy,
+    without running the move constructor and the destructor. Containers
+    grow buffers of such types with a realloc, which often extends the
+    buffer in place. Specialize this for types which are not trivially
+    copyable but don't point into themselves either.
 */
 template<typename TYPE>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<TYPE> {};
+
+} // namespace Memory
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<typename TYPE, typename ALLOCATOR = Memory::ObjectArrayHeapAllocator>
 TYPE* 
 ArrayAlloc(size_t size)
 {
-    TYPE* buffer = (TYPE*)Memory::Alloc(Memory::ObjectArrayHeap, size * sizeof(TYPE));
+    TYPE* buffer = (TYPE*)ALLOCATOR::Alloc(size * sizeof(TYPE));
     if constexpr (!std::is_trivially_constructible<TYPE>::value)
     {
         for (size_t i = 0; i < size; ++i)
@@ -39,8 +101,37 @@ ArrayAlloc(size_t size)
 
 //------------------------------------------------------------------------------
 /**
+    Resizes a buffer allocated with ArrayAlloc() by reallocating it, only
+    valid for trivially relocatable types. Elements beyond the old size
+    are constructed, elements beyond the new size destroyed.
 */
-template<typename TYPE>
+template<typename TYPE, typename ALLOCATOR = Memory::ObjectArrayHeapAllocator>
+TYPE*
+ArrayRealloc(size_t oldSize, size_t newSize, TYPE* buffer)
+{
+    static_assert(Memory::IsTriviallyRelocatable<TYPE>::value, "ArrayRealloc() requires a trivially relocatable type");
+    if constexpr (!std::is_trivially_destructible<TYPE>::value)
+    {
+        for (size_t i = newSize; i < oldSize; ++i)
+        {
+            buffer[i].~TYPE();
+        }
+    }
+    buffer = (TYPE*)ALLOCATOR::Realloc((void*)buffer, oldSize * sizeof(TYPE), newSize * sizeof(TYPE));
+    if constexpr (!std::is_trivially_constructible<TYPE>::value)
+    {
+        for (size_t i = oldSize; i < newSize; ++i)
+        {
+            ::new( &buffer[i] ) TYPE;
+        }
+    }
+    return buffer;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<typename TYPE, typename ALLOCATOR = Memory::ObjectArrayHeapAllocator>
 void 
 ArrayFree(size_t size, TYPE* buffer)
 {
@@ -51,5 +142,5 @@ ArrayFree(size_t size, TYPE* buffer)
             buffer[i].~TYPE();
         }
     }
-    Memory::Free(Memory::ObjectArrayHeap, (void*)buffer);
+    ALLOCATOR::Free((void*)buffer, size * sizeof(TYPE));
 }
@@ -19,6 +19,7 @@
 #include "io/binarywriter.h"
 #include "messaging/id.h"
 #include "threading/interlocked.h"
+#include <atomic>
 
 //------------------------------------------------------------------------------
 /**
@@ -71,7 +72,7 @@ public:
     /// enable distribution over network
     void SetDistribute(bool b);
 protected:
-    volatile int handled;
+    std::atomic<int> handled;
     bool deferred;
     bool deferredHandled;
     bool distribute;
@@ -88,20 +89,25 @@ Message::CheckId(const Messaging::Id& id) const
 
 //------------------------------------------------------------------------------
 /**
+    Messages are often handled on another thread than the one which sent
+    them, so this publishes everything the handler wrote into the message
+    before, see Handled().
 */
 inline void
 Message::SetHandled(bool b)
 {
-    Threading::Interlocked::Exchange(&this->handled, (int)b);
+    this->handled.store((int)b, std::memory_order_release);
 }
 
 //------------------------------------------------------------------------------
 /**
+    Once this returns true, the results the handler wrote into the message
+    are visible to the calling thread.
 */
 inline bool
 Message::Handled() const
 {
-    return 0 != this->handled;
+    return 0 != this->handled.load(std::memory_order_acquire);
 }
 
 //------------------------------------------------------------------------------
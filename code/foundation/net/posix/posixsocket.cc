@@ -332,6 +332,11 @@ PosixSocket::Accept(Ptr<Net::Socket>& outSocket)
     if (INVALID_SOCKET == newSocket)
     {
         this->SetToLastSocketError();
+        if (!this->isBlocking && (ErrorWouldBlock == this->error))
+        {
+            // no more pending connections on a non-blocking server socket
+            return false;
+        }
         n_printf("PosixSocket::Accept(): accept() failed with '%s'!\n", this->GetErrorString().AsCharPtr());
         return false;
     }
@@ -440,10 +445,10 @@ PosixSocket::Send(const void* buf, SizeT numBytes, SizeT& bytesSent)
     n_assert(0 != buf);
     this->ClearError();
     bytesSent = 0;
-    int res = send(this->sock, (const char*) buf, numBytes, 0);
+    int res = send(this->sock, (const char*) buf, numBytes, MSG_NOSIGNAL);
     if (SOCKET_ERROR == res)
     {
-        if (EWOULDBLOCK == res)
+        if (EWOULDBLOCK == errno)
         {
             return WouldBlock;
         }
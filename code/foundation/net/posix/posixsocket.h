@@ -154,6 +154,8 @@ public:
     bool GetBlocking() const;
     /// get the maximum message size that can be sent atomically
     SizeT GetMaxMsgSize();
+    /// get the native socket descriptor
+    SOCKET GetSocket() const;
 
     /// bind socket to ip address
     bool Bind();
@@ -237,6 +239,15 @@ PosixSocket::IsBound() const
     return this->isBound;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline SOCKET
+PosixSocket::GetSocket() const
+{
+    return this->sock;
+}
+
 //------------------------------------------------------------------------------
 /**
     Set internet address of socket.
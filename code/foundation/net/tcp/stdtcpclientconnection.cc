@@ -5,6 +5,7 @@
 //------------------------------------------------------------------------------
 
 #include "net/tcp/stdtcpclientconnection.h"
+#include "net/tcp/stdtcpserver.h"
 #include "io/memorystream.h"
 
 namespace Net
@@ -17,7 +18,17 @@ using namespace IO;
 //------------------------------------------------------------------------------
 /**
 */
-StdTcpClientConnection::StdTcpClientConnection()
+StdTcpClientConnection::StdTcpClientConnection() :
+    server(nullptr),
+    recvBuffer(nullptr),
+    recvKeepSize(0),
+    sendQueue(nullptr),
+    sendQueueSize(0),
+    sendQueueOffset(0),
+    sendQueueCapacity(0),
+    isNonBlocking(false),
+    isPeerClosed(false),
+    isClosing(false)
 {
     // empty
 }
@@ -28,6 +39,16 @@ StdTcpClientConnection::StdTcpClientConnection()
 StdTcpClientConnection::~StdTcpClientConnection()
 {
     this->Shutdown();
+    if (nullptr != this->recvBuffer)
+    {
+        Memory::Free(Memory::NetworkHeap, this->recvBuffer);
+        this->recvBuffer = nullptr;
+    }
+    if (nullptr != this->sendQueue)
+    {
+        Memory::Free(Memory::NetworkHeap, this->sendQueue);
+        this->sendQueue = nullptr;
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -73,17 +94,113 @@ StdTcpClientConnection::IsConnected() const
 
 //------------------------------------------------------------------------------
 /**
+    Closes the connection right away. The send queue gets one last
+    non-blocking flush, whatever the socket doesn't accept then is dropped.
+    Use ShutdownWhenSent() if the queued data has to be delivered.
 */
 void
 StdTcpClientConnection::Shutdown()
 {
     if (this->socket.isvalid())
     {
+        if (this->isNonBlocking && this->HasQueuedSendData())
+        {
+            this->FlushSendQueue();
+        }
         this->socket->Close();
         this->socket = nullptr;
+
+        // let the server drop the connection from its reactor
+        if (nullptr != this->server)
+        {
+            this->server->OnConnectionClosing(this);
+        }
     }
     this->sendStream = nullptr;
     this->recvStream = nullptr;
+    this->recvKeepSize = 0;
+    this->sendQueueSize = 0;
+    this->sendQueueOffset = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Without a reactor sends are blocking, so the connection can be shut down
+    right away.
+*/
+void
+StdTcpClientConnection::ShutdownWhenSent()
+{
+    if (nullptr != this->server && this->HasQueuedSendData())
+    {
+        this->server->OnConnectionClosing(this);
+    }
+    else
+    {
+        this->Shutdown();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    The receive buffer is allocated once here and reused for every Recv(), the
+    send queue only grows when the socket can't keep up with the sent data.
+*/
+void
+StdTcpClientConnection::SetupNonBlocking(StdTcpServer* serv)
+{
+    n_assert(this->socket.isvalid());
+    this->server = serv;
+    this->socket->SetBlocking(false);
+    this->isNonBlocking = true;
+    if (nullptr == this->recvBuffer)
+    {
+        this->recvBuffer = (uchar*)Memory::Alloc(Memory::NetworkHeap, RecvBufferSize);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+Socket::Result
+StdTcpClientConnection::FlushSendQueue()
+{
+    Socket::Result res = Socket::Success;
+    while ((Socket::Success == res) && this->HasQueuedSendData())
+    {
+        SizeT bytesSent = 0;
+        res = this->socket->Send(this->sendQueue + this->sendQueueOffset, this->sendQueueSize - this->sendQueueOffset, bytesSent);
+        this->sendQueueOffset += bytesSent;
+    }
+    if (!this->HasQueuedSendData())
+    {
+        this->sendQueueSize = 0;
+        this->sendQueueOffset = 0;
+    }
+    return (Socket::WouldBlock == res) ? Socket::Success : res;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+StdTcpClientConnection::QueueSendData(const uchar* ptr, SizeT size)
+{
+    // move the unsent rest to the front before growing the queue
+    if (this->sendQueueOffset > 0)
+    {
+        this->sendQueueSize -= this->sendQueueOffset;
+        Memory::Move(this->sendQueue + this->sendQueueOffset, this->sendQueue, this->sendQueueSize);
+        this->sendQueueOffset = 0;
+    }
+    if (this->sendQueueSize + size > this->sendQueueCapacity)
+    {
+        SizeT newCapacity = Math::max(this->sendQueueCapacity * 2, this->sendQueueSize + size);
+        this->sendQueue = (uchar*)Memory::Realloc(Memory::NetworkHeap, this->sendQueue, newCapacity);
+        this->sendQueueCapacity = newCapacity;
+    }
+    Memory::Copy(ptr, this->sendQueue + this->sendQueueSize, size);
+    this->sendQueueSize += size;
 }
 
 //------------------------------------------------------------------------------
@@ -111,7 +228,36 @@ StdTcpClientConnection::Send(const Ptr<Stream>& stream)
     
     Socket::Result res = Socket::Success;
     stream->SetAccessMode(Stream::ReadAccess);
-    if (stream->Open())
+    if (this->isNonBlocking && stream->Open())
+    {
+        // send directly as long as the socket accepts data, unless earlier
+        // data is still queued, and queue whatever is left
+        Stream::Size sendSize = stream->GetSize();
+        n_assert(sendSize < INT_MAX);
+        const uchar* ptr = (const uchar*) stream->Map();
+        SizeT bytesLeft = (SizeT)sendSize;
+        if (!this->HasQueuedSendData())
+        {
+            while ((Socket::Success == res) && (bytesLeft > 0))
+            {
+                SizeT bytesSent = 0;
+                res = this->socket->Send(ptr, bytesLeft, bytesSent);
+                ptr += bytesSent;
+                bytesLeft -= bytesSent;
+            }
+        }
+        if (Socket::Error != res)
+        {
+            if (bytesLeft > 0)
+            {
+                this->QueueSendData(ptr, bytesLeft);
+            }
+            res = Socket::Success;
+        }
+        stream->Unmap();
+        stream->Close();
+    }
+    else if (stream->Open())
     {
         // we may not exceed the maximum message size...
         // so we may have to split the send data into
@@ -158,21 +304,54 @@ Socket::Result
 StdTcpClientConnection::Recv()
 {
     n_assert(this->recvStream.isvalid());
-    this->recvStream->SetAccessMode(Stream::WriteAccess);
-    this->recvStream->SetSize(0);
+    if (this->recvKeepSize > 0)
+    {
+        // append to the data which hasn't been consumed yet
+        this->recvStream->SetAccessMode(Stream::AppendAccess);
+    }
+    else
+    {
+        this->recvStream->SetAccessMode(Stream::WriteAccess);
+        this->recvStream->SetSize(0);
+    }
+    const Stream::Size keptSize = this->recvKeepSize;
+    this->recvKeepSize = 0;
     Socket::Result res = Socket::Success;
     if (this->recvStream->Open())
     {
-        // NOTE: the following loop will make sure that Recv()
-        // never blocks
-        uchar buf[1024];
-        while ((Socket::Success == res) && (this->socket->HasRecvData()))
+        if (this->isNonBlocking)
         {
+            // the reactor is edge-triggered, so the socket must be drained
+            // until it would block, otherwise no further event is signalled
             SizeT bytesReceived = 0;
-            res = this->socket->Recv(&buf, sizeof(buf), bytesReceived);
-            if ((bytesReceived > 0) && (Socket::Success == res))
+            while (Socket::Success == (res = this->socket->Recv(this->recvBuffer, RecvBufferSize, bytesReceived)))
+            {
+                this->recvStream->Write(this->recvBuffer, bytesReceived);
+            }
+            if (Socket::WouldBlock == res)
+            {
+                res = Socket::Success;
+            }
+            else if ((Socket::Closed == res) && (this->recvStream->GetSize() > keptSize))
             {
-                this->recvStream->Write(buf, bytesReceived);
+                // hand out the remaining data first, the server drops the connection later
+                this->isPeerClosed = true;
+                res = Socket::Success;
+            }
+        }
+        else
+        {
+            // NOTE: the following loop will make sure that Recv()
+            // never blocks
+            uchar buf[1024];
+            while ((Socket::Success == res) && (this->socket->HasRecvData()))
+            {
+                SizeT bytesReceived = 0;
+                res = this->socket->Recv(&buf, sizeof(buf), bytesReceived);
+                if ((bytesReceived > 0) && (Socket::Success == res))
+                {
+                    this->recvStream->Write(buf, bytesReceived);
+                }
             }
         }
         this->recvStream->Close();
@@ -180,12 +359,15 @@ StdTcpClientConnection::Recv()
     this->recvStream->SetAccessMode(Stream::ReadAccess);
     if (Socket::Success == res)
     {
-        if (this->recvStream->GetSize() > 0)
+        // kept data alone doesn't count, it has been looked at before
+        if (this->recvStream->GetSize() > keptSize)
         {
             return Socket::Success;
         }
         else
         {
+            // still keep it for the next try
+            this->recvKeepSize = keptSize;
             return Socket::WouldBlock;
         }
     }
@@ -213,4 +395,34 @@ StdTcpClientConnection::GetRecvStream()
     return this->recvStream;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Moves the data from offset on to the front of the receive stream. This
+    is for protocols whose messages may be split across several Recv()
+    calls, the part of a message which has arrived so far stays in the
+    stream and the next Recv() adds the rest behind it.
+*/
+void
+StdTcpClientConnection::KeepRecvData(Stream::Position offset)
+{
+    n_assert(this->recvStream.isvalid());
+    n_assert(!this->recvStream->IsOpen());
+    const Stream::Size size = this->recvStream->GetSize();
+    n_assert((offset >= 0) && (offset <= size));
+    if ((offset > 0) && (offset < size))
+    {
+        this->recvStream->SetAccessMode(Stream::ReadWriteAccess);
+        if (this->recvStream->Open())
+        {
+            uchar* ptr = (uchar*)this->recvStream->Map();
+            Memory::Move(ptr + offset, ptr, (size_t)(size - offset));
+            this->recvStream->Unmap();
+            this->recvStream->Close();
+        }
+        this->recvStream->SetAccessMode(Stream::ReadAccess);
+    }
+    this->recvStream->SetSize(size - offset);
+    this->recvKeepSize = size - offset;
+}
+
 } // namespace Net
@@ -17,6 +17,12 @@
     XmlReader, etc...). To send data back to the client just do the reverse:
     write data to the SendStream, and at any time call the Send() method which
     will send all data accumulated in the SendStream to the client.
+
+    When the connection is driven by the epoll reactor of the StdTcpServer,
+    the socket is switched to non-blocking mode. Recv() then drains the socket
+    through a preallocated receive buffer, and Send() never blocks: whatever the
+    socket doesn't accept immediately is appended to a send queue, which the
+    server flushes once the socket becomes writable again.
     
     @copyright
     (C) 2006 Radon Labs GmbH
@@ -30,6 +36,7 @@
 //------------------------------------------------------------------------------
 namespace Net
 {
+class StdTcpServer;
 class StdTcpClientConnection : public Core::RefCounted
 {
     __DeclareClass(StdTcpClientConnection);
@@ -42,8 +49,10 @@ public:
     virtual bool Connect(const Ptr<Socket>& s);
     /// get the connection status
     bool IsConnected() const;
-    /// shutdown the connection
+    /// shutdown the connection immediately, queued data which can't be sent right away is dropped
     virtual void Shutdown();
+    /// shutdown the connection once all queued data has been sent
+    void ShutdownWhenSent();
     /// get the client's ip address
     const IpAddress& GetClientAddress() const;
     /// send accumulated content of send stream to server
@@ -56,12 +65,46 @@ public:
     virtual Socket::Result Recv();
     /// access to recv stream
     virtual const Ptr<IO::Stream>& GetRecvStream();
+    /// keep the received data from offset on, the next Recv() appends to it instead of replacing it
+    void KeepRecvData(IO::Stream::Position offset);
 
 protected:
+    friend class StdTcpServer;
+
+    /// switch to non-blocking operation, called by the server when the connection is added to its reactor
+    void SetupNonBlocking(StdTcpServer* server);
+    /// send as much of the send queue as the socket accepts
+    Socket::Result FlushSendQueue();
+    /// return true if data is waiting in the send queue
+    bool HasQueuedSendData() const;
+    /// append data which couldn't be sent yet to the send queue
+    void QueueSendData(const uchar* ptr, SizeT size);
+
+    static const SizeT RecvBufferSize = 16 * 1024;
+
     Ptr<Socket> socket;
     Ptr<IO::Stream> sendStream;
     Ptr<IO::Stream> recvStream;
+    StdTcpServer* server;
+    uchar* recvBuffer;
+    IO::Stream::Size recvKeepSize;
+    uchar* sendQueue;
+    SizeT sendQueueSize;
+    SizeT sendQueueOffset;
+    SizeT sendQueueCapacity;
+    bool isNonBlocking;
+    bool isPeerClosed;
+    bool isClosing;
 };
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+StdTcpClientConnection::HasQueuedSendData() const
+{
+    return this->sendQueueOffset < this->sendQueueSize;
+}
+
 } // namespace Net
 //------------------------------------------------------------------------------
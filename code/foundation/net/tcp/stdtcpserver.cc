@@ -5,6 +5,9 @@
 //------------------------------------------------------------------------------
 
 #include "net/tcp/stdtcpserver.h"
+#if __linux__
+#include <unistd.h>
+#endif
 
 namespace Net
 {
@@ -20,6 +23,9 @@ using namespace IO;
 */
 StdTcpServer::StdTcpServer() :
     isOpen(false)
+#if __linux__
+    , epollFd(-1)
+#endif
 {
     this->connectionClassRtti = &TcpClientConnection::RTTI;
 }
@@ -42,6 +48,12 @@ StdTcpServer::Open()
     n_assert(!this->listenerThread.isvalid());
     n_assert(this->clientConnections.IsEmpty());
 
+#if __linux__
+    if (!this->OpenReactor())
+    {
+        return false;
+    }
+#else
     // create the listener thread
     this->listenerThread = ListenerThread::Create();
     this->listenerThread->SetName("StdTcpServer::ListenerThread");
@@ -50,6 +62,7 @@ StdTcpServer::Open()
     this->listenerThread->SetThreadAffinity(System::Cpu::Core4);
     this->listenerThread->SetClientConnectionClass(*this->connectionClassRtti);
     this->listenerThread->Start();
+#endif
     
     this->isOpen = true;
     return true;
@@ -62,11 +75,20 @@ void
 StdTcpServer::Close()
 {
     n_assert(this->isOpen);
+
+#if __linux__
+    this->listenSocket->Close();
+    this->listenSocket = nullptr;
+    close(this->epollFd);
+    this->epollFd = -1;
+    this->closingConnections.Clear();
+#else
     n_assert(this->listenerThread.isvalid());
     
     // stop the listener thread
     this->listenerThread->Stop();
     this->listenerThread = nullptr;
+#endif
 
     // disconnect client connections
     this->connectionCritSect.Enter();
@@ -74,9 +96,11 @@ StdTcpServer::Close()
     for (clientIndex = 0; clientIndex < this->clientConnections.Size(); clientIndex++)
     {
         const Ptr<TcpClientConnection>& curConnection = this->clientConnections[clientIndex];
+        curConnection->server = nullptr;
         curConnection->Shutdown();
     }
     this->clientConnections.Clear();
+    this->clientsWithData.Clear();
     this->connectionCritSect.Leave();
 
     this->isOpen = false;
@@ -96,12 +120,131 @@ StdTcpServer::AddClientConnection(const Ptr<TcpClientConnection>& conn)
 
 //------------------------------------------------------------------------------
 /**
+    Schedules the connection to be removed by the next Recv(). Connections
+    which were closed by the peer are kept until their send queue is empty.
 */
-Array<Ptr<TcpClientConnection> >
+void
+StdTcpServer::OnConnectionClosing(StdTcpClientConnection* conn)
+{
+    n_assert(nullptr != conn);
+#if __linux__
+    this->connectionCritSect.Enter();
+    if (!conn->isClosing)
+    {
+        conn->isClosing = true;
+        this->closingConnections.Append(conn);
+    }
+    this->connectionCritSect.Leave();
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+    Must be called with the connection critical section entered.
+*/
+void
+StdTcpServer::DropClientConnection(StdTcpClientConnection* conn)
+{
+#if __linux__
+    if (conn->socket.isvalid())
+    {
+        epoll_ctl(this->epollFd, EPOLL_CTL_DEL, conn->socket->GetSocket(), nullptr);
+    }
+#endif
+    conn->server = nullptr;
+    conn->Shutdown();
+
+    IndexT clientIndex;
+    for (clientIndex = 0; clientIndex < this->clientConnections.Size(); clientIndex++)
+    {
+        if (this->clientConnections[clientIndex].get_unsafe() == conn)
+        {
+            this->clientConnections.EraseIndexSwap(clientIndex);
+            break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const Array<Ptr<TcpClientConnection> >&
 StdTcpServer::Recv()
 {
-    Array<Ptr<TcpClientConnection> > clientsWithData;
+    // the result array is reused every frame, the connections it still
+    // references from the last call are released here
+    this->clientsWithData.Clear();
+
+#if __linux__
+    this->connectionCritSect.Enter();
+
+    // drop connections which were shut down, or closed by the peer and are done sending
+    IndexT closingIndex;
+    for (closingIndex = 0; closingIndex < this->closingConnections.Size();)
+    {
+        StdTcpClientConnection* conn = this->closingConnections[closingIndex];
+        if (!conn->socket.isvalid() || !conn->HasQueuedSendData())
+        {
+            this->closingConnections.EraseIndexSwap(closingIndex);
+            this->DropClientConnection(conn);
+        }
+        else
+        {
+            closingIndex++;
+        }
+    }
+
+    // only connections with pending events are touched, don't wait if there are none
+    int numEvents = epoll_wait(this->epollFd, this->events, MaxEvents, 0);
+    int eventIndex;
+    for (eventIndex = 0; eventIndex < numEvents; eventIndex++)
+    {
+        const epoll_event& event = this->events[eventIndex];
+        if (nullptr == event.data.ptr)
+        {
+            this->AcceptClientConnections();
+            continue;
+        }
+
+        TcpClientConnection* conn = (TcpClientConnection*)event.data.ptr;
+        if (conn->isClosing)
+        {
+            // only finish sending the queued data, the next Recv() drops the connection
+            if ((event.events & (EPOLLERR | EPOLLHUP)) || ((event.events & EPOLLOUT) && (Socket::Error == conn->FlushSendQueue())))
+            {
+                conn->Shutdown();
+            }
+            continue;
+        }
 
+        bool dropClient = (0 != (event.events & EPOLLERR));
+        if (!dropClient && (event.events & EPOLLOUT))
+        {
+            dropClient = (Socket::Error == conn->FlushSendQueue());
+        }
+        if (!dropClient && (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP)))
+        {
+            Socket::Result res = conn->Recv();
+            if (res == Socket::Success)
+            {
+                this->clientsWithData.Append(conn);
+            }
+            else if ((res == Socket::Error) || (res == Socket::Closed))
+            {
+                dropClient = true;
+            }
+        }
+        if (dropClient)
+        {
+            this->DropClientConnection(conn);
+        }
+        else if (conn->isPeerClosed)
+        {
+            this->OnConnectionClosing(conn);
+        }
+    }
+    this->connectionCritSect.Leave();
+#else
     // iterate over all clients, and check for new data,
     // if the client connection has been closed, remove
     // the client from the list
@@ -116,7 +259,7 @@ StdTcpServer::Recv()
             Socket::Result res = cur->Recv();
             if (res == Socket::Success)
             {
-                clientsWithData.Append(cur);
+                this->clientsWithData.Append(cur);
             }
             else if ((res == Socket::Error) || (res == Socket::Closed))
             {
@@ -140,7 +283,8 @@ StdTcpServer::Recv()
         }
     }
     this->connectionCritSect.Leave();
-    return clientsWithData;
+#endif
+    return this->clientsWithData;
 }
 
 //------------------------------------------------------------------------------
@@ -163,6 +307,75 @@ StdTcpServer::Broadcast(const Ptr<Stream>& msg)
     return result;
 }
 
+#if __linux__
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+StdTcpServer::OpenReactor()
+{
+    this->listenSocket = Socket::Create();
+    if (!this->listenSocket->Open(Socket::TCP))
+    {
+        this->listenSocket = nullptr;
+        return false;
+    }
+    this->listenSocket->SetAddress(this->ipAddress);
+    this->listenSocket->SetReUseAddr(true);
+    if (!this->listenSocket->Bind() || !this->listenSocket->Listen())
+    {
+        n_warn2(false, "StdTcpServer: failed to bind listen socket!");
+        this->listenSocket->Close();
+        this->listenSocket = nullptr;
+        return false;
+    }
+    this->listenSocket->SetBlocking(false);
+
+    this->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    n_assert(this->epollFd != -1);
+
+    // the listen socket is identified by a null pointer in the event data
+    epoll_event event;
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = nullptr;
+    epoll_ctl(this->epollFd, EPOLL_CTL_ADD, this->listenSocket->GetSocket(), &event);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The listen socket is edge-triggered as well, so accept until no more
+    connections are pending.
+*/
+void
+StdTcpServer::AcceptClientConnections()
+{
+    Ptr<Socket> newSocket;
+    while (this->listenSocket->Accept(newSocket))
+    {
+        // create a new connection object and add to connection array
+        Ptr<TcpClientConnection> newConnection = (TcpClientConnection*)this->connectionClassRtti->Create();
+        if (newConnection->Connect(newSocket))
+        {
+            newConnection->SetupNonBlocking(this);
+
+            epoll_event event;
+            event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+            event.data.ptr = newConnection.get();
+            if (0 == epoll_ctl(this->epollFd, EPOLL_CTL_ADD, newSocket->GetSocket(), &event))
+            {
+                this->clientConnections.Append(newConnection);
+            }
+            else
+            {
+                newConnection->server = nullptr;
+                newConnection->Shutdown();
+            }
+        }
+    }
+}
+#endif
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -9,6 +9,14 @@
     TcpClientConnection object which can be used by the application
     to communicate with a specific client.
 
+    On Linux the server runs an edge-triggered epoll reactor instead of the
+    listener thread. The listen socket and all client sockets are non-blocking
+    and registered with a single epoll instance, which Recv() polls without
+    waiting. Only connections with pending events are touched, so an idle server
+    costs a single system call per Recv(), independent of the number of
+    connected clients. Sends which the socket can't take immediately are queued
+    by the client connection and flushed when the socket signals writability.
+
     @copyright
     (C) 2006 Radon Labs GmbH
     (C) 2013-2020 Individual contributors, see AUTHORS file
@@ -19,6 +27,9 @@
 #include "net/tcpclientconnection.h"
 #include "net/socket/socket.h"
 #include "threading/criticalsection.h"
+#if __linux__
+#include <sys/epoll.h>
+#endif
 
 //------------------------------------------------------------------------------
 namespace Net
@@ -46,7 +57,7 @@ public:
     /// return true if server is open
     bool IsOpen() const;
     /// poll clients connections for received data, call this frequently!
-    Util::Array<Ptr<TcpClientConnection> > Recv();
+    const Util::Array<Ptr<TcpClientConnection> >& Recv();
     /// broadcast a message to all clients
     bool Broadcast(const Ptr<IO::Stream>& msg);
 
@@ -74,15 +85,34 @@ private:
         const Core::Rtti* connectionClassRtti;
     };
     friend class ListenerThread;
+    friend class StdTcpClientConnection;
     /// add a client connection (called by the listener thread)
     void AddClientConnection(const Ptr<TcpClientConnection>& connection);
+    /// schedule a connection to be dropped (called when the connection shuts down or the peer closed it)
+    void OnConnectionClosing(StdTcpClientConnection* connection);
+    /// remove a connection from the reactor and the connection array
+    void DropClientConnection(StdTcpClientConnection* connection);
 
     IpAddress ipAddress;
     Ptr<ListenerThread> listenerThread;
     bool isOpen;
     Util::Array<Ptr<TcpClientConnection> > clientConnections;
+    Util::Array<Ptr<TcpClientConnection> > clientsWithData;
     Threading::CriticalSection connectionCritSect;
     const Core::Rtti* connectionClassRtti;
+
+#if __linux__
+    /// open the non-blocking listen socket and register it with the reactor
+    bool OpenReactor();
+    /// accept all pending connections
+    void AcceptClientConnections();
+
+    static const int MaxEvents = 64;
+    int epollFd;
+    Ptr<Socket> listenSocket;
+    epoll_event events[MaxEvents];
+    Util::Array<StdTcpClientConnection*> closingConnections;
+#endif
 };
 
 //------------------------------------------------------------------------------
@@ -107,6 +107,66 @@ ProfilingGetTime()
     return ctx.timer.GetTime();
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+SizeT
+ProfilingGetScopeDepth()
+{
+    if (ProfilingContextIndex == InvalidIndex)
+        return 0;
+    return profilingContexts[ProfilingContextIndex].scopes.Size();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Every open scope holds the context mutex once, so it's released here
+    for each of them. The start times are kept relative to now, since
+    every thread has its own timer. The time the scopes spend aside isn't
+    counted, the thread runs other scopes meanwhile.
+*/
+void
+ProfilingSuspendScopes(Util::Stack<ProfilingScope>& scopes)
+{
+    n_assert(scopes.IsEmpty());
+    if (ProfilingContextIndex == InvalidIndex)
+        return;
+
+    ProfilingContext& ctx = profilingContexts[ProfilingContextIndex];
+    const Timing::Time now = ctx.timer.GetTime();
+    IndexT i;
+    for (i = 0; i < ctx.scopes.Size(); i++)
+    {
+        ctx.scopes[i].start -= now;
+        contextMutexes[ProfilingContextIndex]->Leave();
+    }
+    scopes = ctx.scopes;
+    ctx.scopes.Clear();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ProfilingResumeScopes(Util::Stack<ProfilingScope>& scopes)
+{
+    if (scopes.IsEmpty())
+        return;
+    n_assert(ProfilingContextIndex != InvalidIndex);
+
+    ProfilingContext& ctx = profilingContexts[ProfilingContextIndex];
+    n_assert(ctx.scopes.IsEmpty());
+    const Timing::Time now = ctx.timer.GetTime();
+    IndexT i;
+    for (i = 0; i < scopes.Size(); i++)
+    {
+        contextMutexes[ProfilingContextIndex]->Enter();
+        scopes[i].start += now;
+    }
+    ctx.scopes = scopes;
+    scopes.Clear();
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -157,8 +217,8 @@ ProfilingClear()
 }
 
 Threading::CriticalSection counterLock;
-Util::Dictionary<const char*, uint64> counters;
-Util::Dictionary<const char*, Util::Pair<uint64, uint64>> budgetCounters;
+Util::FlatHashMap<const char*, uint64> counters;
+Util::FlatHashMap<const char*, Util::Pair<uint64, uint64>> budgetCounters;
 
 //------------------------------------------------------------------------------
 /**
@@ -167,13 +227,7 @@ void
 ProfilingIncreaseCounter(const char* id, uint64 value)
 {
     counterLock.Enter();
-    IndexT idx = counters.FindIndex(id);
-    if (idx == InvalidIndex)
-        counters.Add(id, value);
-    else
-    {
-        counters.ValueAtIndex(idx) += value;
-    }
+    counters.Emplace(id) += value;
     counterLock.Leave();
 }
 
@@ -193,7 +247,18 @@ ProfilingDecreaseCounter(const char* id, uint64 value)
 //------------------------------------------------------------------------------
 /**
 */
-const Util::Dictionary<const char*, uint64>&
+void
+ProfilingSetCounter(const char* id, uint64 value)
+{
+    counterLock.Enter();
+    counters.Emplace(id) = value;
+    counterLock.Leave();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const Util::FlatHashMap<const char*, uint64>&
 ProfilingGetCounters()
 {
     return counters;
@@ -253,7 +318,7 @@ ProfilingBudgetResetCounter(const char* id)
 //------------------------------------------------------------------------------
 /**
 */
-const Util::Dictionary<const char*, Util::Pair<uint64, uint64>>&
+const Util::FlatHashMap<const char*, Util::Pair<uint64, uint64>>&
 ProfilingGetBudgetCounters()
 {
     return budgetCounters;
@@ -11,6 +11,7 @@
 #include "timing/timer.h"
 #include "util/stack.h"
 #include "util/dictionary.h"
+#include "util/flathashmap.h"
 #include "util/stringatom.h"
 #include "util/tupleutility.h"
 #include "threading/thread.h"
@@ -36,6 +37,7 @@
 #define N_MARKER_END()                  { Profiling::ProfilingPopScope(); }
 #define N_COUNTER_INCR(name, value)     Profiling::ProfilingIncreaseCounter(name, value);
 #define N_COUNTER_DECR(name, value)     Profiling::ProfilingDecreaseCounter(name, value);
+#define N_COUNTER_SET(name, value)      Profiling::ProfilingSetCounter(name, value);
 #define N_BUDGET_COUNTER_SETUP(name, budget) Profiling::ProfilingSetupBudgetCounter(name, budget);
 #define N_BUDGET_COUNTER_INCR(name, value) Profiling::ProfilingBudgetIncreaseCounter(name, value);
 #define N_BUDGET_COUNTER_DECR(name, value) Profiling::ProfilingBudgetDecreaseCounter(name, value);
@@ -50,6 +52,7 @@
 #define N_MARKER_END()
 #define N_COUNTER_INCR(name, value)
 #define N_COUNTER_DECR(name, value)
+#define N_COUNTER_SET(name, value)
 #define N_DECLARE_COUNTER(name, label)
 #endif
 
@@ -67,6 +70,12 @@ void ProfilingPopScope();
 void ProfilingNewFrame();
 /// get current frametime
 Timing::Time ProfilingGetTime();
+/// get the number of scopes open on the calling thread, 0 if the thread isn't registered
+SizeT ProfilingGetScopeDepth();
+/// move the scopes open on the calling thread aside, for a fiber which is about to be switched away from
+void ProfilingSuspendScopes(Util::Stack<ProfilingScope>& scopes);
+/// continue scopes moved aside with ProfilingSuspendScopes() on the calling thread, which may be another one
+void ProfilingResumeScopes(Util::Stack<ProfilingScope>& scopes);
 
 /// register a new thread for the profiling
 void ProfilingRegisterThread();
@@ -90,8 +99,10 @@ extern Threading::AtomicCounter ProfilingContextCounter;
 void ProfilingIncreaseCounter(const char* id, uint64 value);
 /// decrement profiling counter
 void ProfilingDecreaseCounter(const char* id, uint64 value);
+/// set profiling counter, for values which are measured anew every frame
+void ProfilingSetCounter(const char* id, uint64 value);
 /// return table of counters
-const Util::Dictionary<const char*, uint64>& ProfilingGetCounters();
+const Util::FlatHashMap<const char*, uint64>& ProfilingGetCounters();
 
 /// Setup a profiling budget counter
 void ProfilingSetupBudgetCounter(const char* id, uint64 budget);
@@ -102,11 +113,11 @@ void ProfilingBudgetDecreaseCounter(const char* id, uint64 value);
 /// Reset budget counter
 void ProfilingBudgetResetCounter(const char* id);
 /// Return set of budget counters
-const Util::Dictionary<const char*, Util::Pair<uint64, uint64>>& ProfilingGetBudgetCounters();
+const Util::FlatHashMap<const char*, Util::Pair<uint64, uint64>>& ProfilingGetBudgetCounters();
 
 extern Threading::CriticalSection counterLock;
-extern Util::Dictionary<const char*, Util::Pair<uint64, uint64>> budgetCounters;
-extern Util::Dictionary<const char*, uint64> counters;
+extern Util::FlatHashMap<const char*, Util::Pair<uint64, uint64>> budgetCounters;
+extern Util::FlatHashMap<const char*, uint64> counters;
 
 struct ProfilingScope
 {
@@ -0,0 +1,145 @@
+//------------------------------------------------------------------------------
+//  cpu.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "system/cpu.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define N_CPU_X86 (1)
+#if __VC__
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace System
+{
+
+Cpu::Feature Cpu::features = Cpu::NoFeatures;
+Cpu::SimdLevel Cpu::maxSimdLevel = Cpu::SimdGeneric;
+Cpu::SimdLevel Cpu::simdLevel = Cpu::SimdGeneric;
+bool Cpu::isSetup = false;
+
+#if N_CPU_X86
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+CpuId(uint32_t leaf, uint32_t subLeaf, uint32_t regs[4])
+{
+#if __VC__
+    __cpuidex((int*)regs, (int)leaf, (int)subLeaf);
+#else
+    __cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+//------------------------------------------------------------------------------
+/**
+    Returns the register state the os saves on context switches, the
+    wider registers can't be used unless the os preserves them.
+*/
+static uint64_t
+XGetBv()
+{
+#if __VC__
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+#endif
+}
+#endif
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Cpu::Setup()
+{
+    Feature f = NoFeatures;
+#if N_CPU_X86
+    uint32_t regs[4];
+    CpuId(0, 0, regs);
+    const uint32_t maxLeaf = regs[0];
+
+    CpuId(1, 0, regs);
+    const uint32_t ecx1 = regs[2];
+    const uint32_t edx1 = regs[3];
+    if (edx1 & N_BIT(26)) f |= SSE2;
+    if (ecx1 & N_BIT(0))  f |= SSE3;
+    if (ecx1 & N_BIT(19)) f |= SSE41;
+    if (ecx1 & N_BIT(20)) f |= SSE42;
+
+    // the os has to save the ymm (and zmm) registers, otherwise the extensions are useless
+    const bool osxsave = (ecx1 & N_BIT(27)) != 0;
+    const uint64_t xcr0 = osxsave ? XGetBv() : 0;
+    const bool ymmEnabled = (xcr0 & 0x6) == 0x6;
+    const bool zmmEnabled = (xcr0 & 0xe6) == 0xe6;
+    if (ymmEnabled)
+    {
+        if (ecx1 & N_BIT(28)) f |= AVX;
+        if (ecx1 & N_BIT(12)) f |= FMA;
+        if (ecx1 & N_BIT(29)) f |= F16C;
+    }
+
+    if (maxLeaf >= 7)
+    {
+        CpuId(7, 0, regs);
+        const uint32_t ebx7 = regs[1];
+        if (ebx7 & N_BIT(8)) f |= BMI2;
+        if (ymmEnabled && (ebx7 & N_BIT(5))) f |= AVX2;
+        if (zmmEnabled)
+        {
+            if (ebx7 & N_BIT(16)) f |= AVX512F;
+            if (ebx7 & N_BIT(17)) f |= AVX512DQ;
+            if (ebx7 & N_BIT(30)) f |= AVX512BW;
+            if (ebx7 & N_BIT(31)) f |= AVX512VL;
+        }
+    }
+#endif
+
+    SimdLevel level = SimdGeneric;
+    if ((f & (AVX2 | FMA)) == (AVX2 | FMA))
+    {
+        level = SimdAVX2;
+        const Feature avx512 = AVX512F | AVX512DQ | AVX512BW | AVX512VL;
+        if ((f & avx512) == avx512)
+            level = SimdAVX512;
+    }
+
+    features = f;
+    maxSimdLevel = level;
+    simdLevel = level;
+    isSetup = true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+Cpu::SetSimdLevel(SimdLevel level)
+{
+    n_assert(level <= GetMaxSimdLevel());
+    simdLevel = level;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const char*
+Cpu::SimdLevelAsString(SimdLevel level)
+{
+    switch (level)
+    {
+        case SimdGeneric:   return "generic";
+        case SimdAVX2:      return "avx2";
+        case SimdAVX512:    return "avx512";
+        default:            return "unknown";
+    }
+}
+
+} // namespace System
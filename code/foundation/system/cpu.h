@@ -4,11 +4,21 @@
     @class System::Cpu
     
     Provides information about the system's CPU(s).
+
+    The instruction set extensions are queried once with CPUID when the
+    runtime is set up, before any job threads exist, so the getters can be
+    called from any thread without synchronization. Kernels
+    which have variants for several instruction sets select one through
+    GetSimdLevel(), usually by indexing a table of function pointers:
+
+        static const KernelFunc Table[System::Cpu::NumSimdLevels] = { ... };
+        Table[System::Cpu::GetSimdLevel()](...);
     
     @copyright
     (C) 2007 Radon Labs GmbH
     (C) 2013-2020 Individual contributors, see AUTHORS file
 */
+#include "core/types.h"
 #include "core/rttimacros.h"
 namespace System
 {
@@ -51,8 +61,102 @@ public:
         Core31 = 0x80000000,  // << Threadripper gen 1 level
         All = (Core31 << 1) - 1
     };
+
+    /// instruction set extensions
+    enum Feature : uint32_t
+    {
+        SSE2     = N_BIT(0),
+        SSE3     = N_BIT(1),
+        SSE41    = N_BIT(2),
+        SSE42    = N_BIT(3),
+        AVX      = N_BIT(4),
+        AVX2     = N_BIT(5),
+        FMA      = N_BIT(6),
+        F16C     = N_BIT(7),
+        BMI2     = N_BIT(8),
+        AVX512F  = N_BIT(9),
+        AVX512DQ = N_BIT(10),
+        AVX512BW = N_BIT(11),
+        AVX512VL = N_BIT(12),
+
+        NoFeatures = 0
+    };
+
+    /// the instruction set levels kernels are specialized for, each includes the ones before
+    enum SimdLevel
+    {
+        SimdGeneric,            // what the build targets, SSE4.2 + AVX
+        SimdAVX2,               // + AVX2, FMA
+        SimdAVX512,             // + AVX-512 F/DQ/BW/VL
+
+        NumSimdLevels
+    };
+
+    /// get the instruction set extensions supported by both the cpu and the os
+    static Feature GetFeatures();
+    /// return true if all of the given features are supported
+    static bool HasFeatures(Feature features);
+    /// get the highest supported simd level, or the one set with SetSimdLevel()
+    static SimdLevel GetSimdLevel();
+    /// override the simd level, must be supported (used by tests and benchmarks to run all variants)
+    static void SetSimdLevel(SimdLevel level);
+    /// get the highest simd level supported by the cpu
+    static SimdLevel GetMaxSimdLevel();
+    /// convert simd level to string
+    static const char* SimdLevelAsString(SimdLevel level);
+
+    /// query the cpu, called once by SysFunc::Setup() before any threads are started
+    static void Setup();
+
+private:
+
+    static Feature features;
+    static SimdLevel maxSimdLevel;
+    static SimdLevel simdLevel;
+    static bool isSetup;
 };
 
+__ImplementEnumBitOperators(System::Cpu::Feature);
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline Cpu::Feature
+Cpu::GetFeatures()
+{
+    n_assert(isSetup);
+    return features;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+Cpu::HasFeatures(Feature f)
+{
+    return (GetFeatures() & f) == f;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline Cpu::SimdLevel
+Cpu::GetSimdLevel()
+{
+    n_assert(isSetup);
+    return simdLevel;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline Cpu::SimdLevel
+Cpu::GetMaxSimdLevel()
+{
+    n_assert(isSetup);
+    return maxSimdLevel;
+}
+
 __ImplementEnumBitOperators(System::Cpu::CoreId);
 }
 //------------------------------------------------------------------------------
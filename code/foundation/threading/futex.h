@@ -0,0 +1,99 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Threading::Futex
+
+    Put threads to sleep on the address of an int, and wake them up again.
+    Wait() only sleeps if the int still holds the expected value, and may
+    return spuriously, so it's always used in a loop which rechecks the
+    condition. This is the building block for the Linux Event,
+    CriticalSection and ThreadBarrier, and for waiting on an AtomicCounter
+    directly with WaitForCounter().
+
+    Linux uses the futex system call, Windows WaitOnAddress(), other
+    platforms fall back to yielding the thread.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/config.h"
+#include "threading/interlocked.h"
+#include <atomic>
+#if (__WIN32__)
+#include "threading/win32/win32futex.h"
+namespace Threading
+{
+class Futex : public Win32::Win32Futex
+{ };
+}
+#elif __linux__
+#include "threading/linux/linuxfutex.h"
+namespace Threading
+{
+class Futex : public Linux::LinuxFutex
+{ };
+}
+#elif ( __OSX__ || __APPLE__ )
+#include "threading/posix/posixfutex.h"
+namespace Threading
+{
+class Futex : public Posix::PosixFutex
+{ };
+}
+#else
+#error "Threading::Futex not implemented on this platform!"
+#endif
+
+namespace Threading
+{
+
+/// number of times a waiting thread polls before it goes to sleep
+static const int FutexSpinCount = 128;
+
+/// wait until the counter reaches zero, spins for a while before the thread goes to sleep
+void WaitForCounter(const AtomicCounter* counter);
+/// decrement the counter, wakes up threads in WaitForCounter() when it reaches zero, returns the new value
+int DecrementCounter(AtomicCounter* counter);
+
+//------------------------------------------------------------------------------
+/**
+    The thread sleeps on whatever value it last saw, if the counter moves
+    on before the kernel looks at it, the wait returns right away and the
+    thread goes around again, so only the last decrement has to wake it.
+*/
+inline void
+WaitForCounter(const AtomicCounter* counter)
+{
+    IndexT i;
+    for (i = 0; i < FutexSpinCount; i++)
+    {
+        if (*counter == 0)
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return;
+        }
+        Futex::Pause();
+    }
+
+    int value;
+    while ((value = *counter) != 0)
+    {
+        Futex::Wait(counter, value);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline int
+DecrementCounter(AtomicCounter* counter)
+{
+    const int value = Interlocked::Decrement(counter);
+    if (value == 0)
+        Futex::WakeAll(counter);
+    return value;
+}
+
+} // namespace Threading
+//------------------------------------------------------------------------------
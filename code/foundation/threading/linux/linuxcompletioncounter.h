@@ -2,13 +2,17 @@
 //----------------------------------------------------------------------------------------
 /**
     @class Linux::LinuxCompletionCounter
-    
+
     Block a thread until count reaches 0.
-    
+
+    The counter itself is the futex, waiting threads spin for a while and
+    then sleep on it until the last Decrement() wakes them all up.
+
     (C) 2010 Radon Labs GmbH
-    (C) 2013-2018 Individual contributors, see AUTHORS file
+    (C) 2013-2024 Individual contributors, see AUTHORS file
 */
 #include "core/types.h"
+#include "threading/futex.h"
 
 //----------------------------------------------------------------------------------------
 namespace Linux
@@ -20,7 +24,7 @@ public:
     LinuxCompletionCounter();
     /// destructor
     ~LinuxCompletionCounter();
-    
+
     /// reset the counter, call from main thread
     void Reset(int count);
     /// decrement the counter, call from worker threads, return true if count has reached zero
@@ -31,8 +35,7 @@ public:
     bool Peek();
 
 private:
-    volatile int curCount;
-    pthread_cond_t completionEvent;
+    Threading::AtomicCounter curCount;
 };
 
 //----------------------------------------------------------------------------------------
@@ -42,8 +45,7 @@ inline
 LinuxCompletionCounter::LinuxCompletionCounter() :
     curCount(0)
 {
-    // create a manual-reset event, and initially in signalled state
-    pthread_cond_init(&this->completionEvent, 0);
+    // empty
 }
 
 //----------------------------------------------------------------------------------------
@@ -52,13 +54,13 @@ LinuxCompletionCounter::LinuxCompletionCounter() :
 inline
 LinuxCompletionCounter::~LinuxCompletionCounter()
 {
-    pthread_cond_destroy(&this->completionEvent);
+    // empty
 }
 
 //----------------------------------------------------------------------------------------
 /**
     Reset the counter. Call this method from the main thread before work items
-    are pushed to the worker threads. It is safe to use non-thread-safe 
+    are pushed to the worker threads. It is safe to use non-thread-safe
     functions here.
 */
 inline void
@@ -72,15 +74,17 @@ LinuxCompletionCounter::Reset(int count)
 //----------------------------------------------------------------------------------------
 /**
     This method is called from several worker thread to decrement the counter.
-    When the counter reaches 0, the completionEvent will be signalled and the method 
+    When the counter reaches 0, the waiting threads will be woken up and the method
     will return true, otherwise false.
 */
 inline bool
 LinuxCompletionCounter::Decrement(int num)
 {
-    if (LinuxInterlocked::Add(this->curCount, -num) == num)
+    const int value = __atomic_sub_fetch(&this->curCount, num, __ATOMIC_ACQ_REL);
+    n_assert(value >= 0);
+    if (value == 0)
     {
-        pthread_cond_signal(&this->completionEvent);
+        LinuxFutex::WakeAll(&this->curCount);
         return true;
     }
     else
@@ -91,21 +95,14 @@ LinuxCompletionCounter::Decrement(int num)
 
 //----------------------------------------------------------------------------------------
 /**
-    This method may be called by either one of the worker threads, or the 
+    This method may be called by either one of the worker threads, or the
     main thread to wait for the completion of an event. Any number of threads
     may wait for completion.
 */
 inline void
 LinuxCompletionCounter::Wait()
 {
-    pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
-    pthread_mutex_lock(&m);
-    while(this->curCount > 0) 
-    {
-        pthread_cond_wait(&this->completionEvent, &m);
-    }
-    pthread_mutex_unlock(&m);
-    pthread_mutex_destroy(&m);
+    Threading::WaitForCounter(&this->curCount);
 }
 
 //----------------------------------------------------------------------------------------
@@ -0,0 +1,155 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Linux::LinuxCriticalSection
+
+    Linux implementation of critical section on top of a futex.
+
+    The lock word is either unlocked, locked, or locked with threads which
+    may be asleep on it. Entering an unlocked section is a single
+    compare-and-swap, and leaving one nobody waits for is a single
+    exchange. A thread which finds the section locked spins for a while,
+    since most sections are held very briefly, and only then marks the
+    lock as contended and goes to sleep, which tells the owner to wake
+    somebody up when it leaves.
+
+    Like the other implementations, the section is recursive, the owning
+    thread may enter it again as long as it leaves it as often.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+#include "threading/futex.h"
+#include <pthread.h>
+
+//------------------------------------------------------------------------------
+namespace Linux
+{
+class LinuxCriticalSection
+{
+public:
+    /// constructor
+    LinuxCriticalSection();
+    /// destructor
+    ~LinuxCriticalSection();
+    /// move assignment, neither section may be entered
+    void operator=(LinuxCriticalSection&& rhs);
+    /// enter the critical section
+    void Enter() const;
+    /// leave the critical section
+    void Leave() const;
+
+private:
+    /// spin and then sleep until the lock can be taken
+    void EnterContended() const;
+
+    enum LockState
+    {
+        Unlocked = 0,
+        Locked = 1,
+        Contended = 2,
+    };
+
+    mutable volatile int lock;
+    mutable pthread_t owner;
+    mutable int recursionCount;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline
+LinuxCriticalSection::LinuxCriticalSection() :
+    lock(Unlocked),
+    owner(0),
+    recursionCount(0)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline
+LinuxCriticalSection::~LinuxCriticalSection()
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+LinuxCriticalSection::operator=(LinuxCriticalSection&& rhs)
+{
+    n_assert(this->lock == Unlocked);
+    n_assert(rhs.lock == Unlocked);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Only the owning thread ever stores its own id in owner, so a thread
+    can only read its id back if it really holds the section.
+*/
+inline void
+LinuxCriticalSection::Enter() const
+{
+    const pthread_t self = pthread_self();
+    if (__atomic_load_n(&this->owner, __ATOMIC_RELAXED) == self)
+    {
+        this->recursionCount++;
+        return;
+    }
+
+    int expected = Unlocked;
+    if (!__atomic_compare_exchange_n(&this->lock, &expected, Locked, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        this->EnterContended();
+
+    __atomic_store_n(&this->owner, self, __ATOMIC_RELAXED);
+    this->recursionCount = 1;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Once a thread goes to sleep it leaves the lock marked as contended,
+    and so does the thread it is woken up for, since it can't know if
+    there are more sleepers behind it. At worst that costs one
+    unnecessary wake up call.
+*/
+inline void
+LinuxCriticalSection::EnterContended() const
+{
+    IndexT i;
+    for (i = 0; i < Threading::FutexSpinCount; i++)
+    {
+        LinuxFutex::Pause();
+        int expected = Unlocked;
+        if (__atomic_load_n(&this->lock, __ATOMIC_RELAXED) == Unlocked
+            && __atomic_compare_exchange_n(&this->lock, &expected, Locked, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            return;
+    }
+
+    while (__atomic_exchange_n(&this->lock, Contended, __ATOMIC_ACQUIRE) != Unlocked)
+    {
+        LinuxFutex::Wait(&this->lock, Contended);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+LinuxCriticalSection::Leave() const
+{
+    n_assert(this->recursionCount > 0);
+    if (--this->recursionCount > 0)
+        return;
+
+    __atomic_store_n(&this->owner, (pthread_t)0, __ATOMIC_RELAXED);
+    if (__atomic_exchange_n(&this->lock, Unlocked, __ATOMIC_RELEASE) == Contended)
+        LinuxFutex::WakeOne(&this->lock);
+}
+
+} // namespace Linux
+//------------------------------------------------------------------------------
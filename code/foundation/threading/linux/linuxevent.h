@@ -2,14 +2,24 @@
 //------------------------------------------------------------------------------
 /**
     @class Linux::LinuxEvent
- 
-    Linux implementation of Event. Uses pthread condition variables.
- 
+
+    Linux implementation of Event on top of a futex.
+
+    The event is a single int which is either signalled or not. Waiting
+    threads poll it for a short while before they go to sleep on the
+    futex, and Signal() only makes a system call if somebody is actually
+    asleep, so an event which is signalled before anybody waits for it,
+    or which is waited on only briefly, never enters the kernel.
+
+    Like on Windows, an auto-reset event releases a single waiter and
+    resets itself, a manual-reset event releases all waiters and stays
+    signalled until Reset() is called.
+
     (C) 2010 Radon Labs GmbH
-    (C) 2013-2018 Individual contributors, see AUTHORS file
+    (C) 2013-2024 Individual contributors, see AUTHORS file
 */
 #include "core/types.h"
-#include <bits/pthreadtypes.h>
+#include "threading/futex.h"
 
 //------------------------------------------------------------------------------
 namespace Linux
@@ -37,19 +47,19 @@ public:
     bool IsManual() const;
 
 private:
+    /// take the signal if the event is signalled, auto-reset events are reset
+    bool TryAcquire() const;
+
     // emulate windows event behaviour (*sigh*)
     enum EventStatus
     {
         SIGNAL_NONE = 0,
-        SIGNAL_ONE = 1,
-        SIGNAL_ALL = 2,
+        SIGNAL_SET = 1,
     };
 
-    mutable pthread_mutex_t mutex;
-    mutable pthread_cond_t cond;
-    
     bool manualReset;
-    volatile mutable EventStatus status;
+    mutable volatile int status;
+    mutable volatile int waiting;
 };
 
 //------------------------------------------------------------------------------
@@ -59,66 +69,66 @@ inline
 LinuxEvent::LinuxEvent(bool manual)
     : manualReset(manual)
     , status(SIGNAL_NONE)
+    , waiting(0)
 {
-    // setup the mutex    
-    int res = pthread_mutex_init(&this->mutex, nullptr);
-    n_assert(0 == res);
-
-    // setup the condition variable
-    res = pthread_cond_init(&this->cond, nullptr);
-    n_assert(0 == res);
+    // empty
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-inline 
+inline
 LinuxEvent::LinuxEvent(LinuxEvent&& ev)
+    : manualReset(ev.manualReset)
+    , status(ev.status)
+    , waiting(0)
 {
-    int res = pthread_cond_destroy(&this->cond);
-    n_assert(0 == res);
-    res = pthread_mutex_destroy(&this->mutex);
-    n_assert(0 == res);
-
-    this->mutex = ev.mutex;
-    this->cond = ev.cond;
-    this->manualReset = ev.manualReset;
-    this->status = ev.status;
-    ev.mutex = pthread_mutex_t{};
-    ev.cond = pthread_cond_t{};
+    n_assert(ev.waiting == 0);
     ev.status = SIGNAL_NONE;
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-inline 
+inline
 LinuxEvent::~LinuxEvent()
 {
-    int res = pthread_cond_destroy(&this->cond);
-    n_assert(0 == res);
-    res = pthread_mutex_destroy(&this->mutex);
-    n_assert(0 == res);
+    // empty
 }
-    
+
 //------------------------------------------------------------------------------
 /**
+    The status is published before the waiting count is read, and waiters
+    raise the count before they check the status, so either the waiter
+    sees the signal or we see the waiter.
 */
 inline void
 LinuxEvent::Signal()
 {
-    pthread_mutex_lock(&this->mutex);
-    if(this->manualReset)
-    {
-        this->status = SIGNAL_ALL;
-        pthread_cond_broadcast(&this->cond);
-    }
-    else
+    __atomic_store_n(&this->status, SIGNAL_SET, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&this->waiting, __ATOMIC_SEQ_CST) > 0)
     {
-        this->status = SIGNAL_ONE;
-        pthread_cond_signal(&this->cond);
+        if (this->manualReset)
+            LinuxFutex::WakeAll(&this->status);
+        else
+            LinuxFutex::WakeOne(&this->status);
     }
-    pthread_mutex_unlock(&this->mutex);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline bool
+LinuxEvent::TryAcquire() const
+{
+    if (__atomic_load_n(&this->status, __ATOMIC_ACQUIRE) == SIGNAL_NONE)
+        return false;
+    if (this->manualReset)
+        return true;
+
+    // more than one thread may have seen the signal, only one gets to reset it
+    int expected = SIGNAL_SET;
+    return __atomic_compare_exchange_n(&this->status, &expected, SIGNAL_NONE, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
 }
 
 //------------------------------------------------------------------------------
@@ -127,80 +137,63 @@ LinuxEvent::Signal()
 inline void
 LinuxEvent::Wait() const
 {
-    pthread_mutex_lock(&this->mutex);
+    IndexT i;
+    for (i = 0; i < Threading::FutexSpinCount; i++)
+    {
+        if (this->TryAcquire())
+            return;
+        LinuxFutex::Pause();
+    }
 
-    bool locked = false;
-    do
+    __atomic_add_fetch(&this->waiting, 1, __ATOMIC_SEQ_CST);
+    while (!this->TryAcquire())
     {
-        // dont wait for cond if already triggered
-        if (this->status == SIGNAL_ONE)
-        {
-            this->status = SIGNAL_NONE;
-            locked = true;
-        }
-        else if( this->status == SIGNAL_ALL)
-        {
-            // we are in a manual reset event, do nothing
-            locked = true;
-        }
-        else
-        {
-            // we actually have to wait
-            int res = pthread_cond_wait(&this->cond, &this->mutex);
-            n_assert(res == 0);
-        }
-    } while (!locked);
-    pthread_mutex_unlock(&this->mutex);
+        LinuxFutex::Wait(&this->status, SIGNAL_NONE);
+    }
+    __atomic_sub_fetch(&this->waiting, 1, __ATOMIC_RELAXED);
 }
 
 //------------------------------------------------------------------------------
 /**
+    A wake up doesn't guarantee we get the signal, so the time-out is
+    tracked against a deadline over all the sleeps.
 */
 inline bool
 LinuxEvent::WaitTimeout(int ms) const
 {
-    bool timeOutOccured = false;
-    pthread_mutex_lock(&this->mutex);
-    
-    bool locked = false;
-    do
+    IndexT i;
+    for (i = 0; i < Threading::FutexSpinCount; i++)
     {
-        // dont wait for cond if already triggered
-        if (this->status == SIGNAL_ONE)
-        {
-            this->status = SIGNAL_NONE;
-            locked = true;
-        }
-        else if( this->status == SIGNAL_ALL)
-        {
-            // we are in a manual reset event, do nothing
-            locked = true;
-        }
-        else
-        {
-            timespec timeSpec;
-            timeSpec.tv_sec = ms / 1000;
-            timeSpec.tv_nsec = (ms - timeSpec.tv_sec * 1000) * 1000000;
-        
-            int res = pthread_cond_timedwait(&this->cond, &this->mutex, &timeSpec);
-
-            if (ETIMEDOUT == res)
-            {
-                timeOutOccured = true;
-            }
-        }
-    } while(!locked && !timeOutOccured);
-    pthread_mutex_unlock(&this->mutex);    
-    return !timeOutOccured;
+        if (this->TryAcquire())
+            return true;
+        LinuxFutex::Pause();
+    }
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const int64_t deadline = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000 + ms;
+
+    bool signalled = false;
+    __atomic_add_fetch(&this->waiting, 1, __ATOMIC_SEQ_CST);
+    while (!(signalled = this->TryAcquire()))
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const int64_t remaining = deadline - ((int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+        if (remaining <= 0)
+            break;
+        LinuxFutex::WaitTimeout(&this->status, SIGNAL_NONE, (int)remaining);
+    }
+    __atomic_sub_fetch(&this->waiting, 1, __ATOMIC_RELAXED);
+    return signalled;
 }
-    
+
 //------------------------------------------------------------------------------
 /**
 */
 inline bool
 LinuxEvent::Peek() const
 {
-    return this->status != SIGNAL_NONE;
+    return __atomic_load_n(&this->status, __ATOMIC_ACQUIRE) != SIGNAL_NONE;
 }
 
 //------------------------------------------------------------------------------
@@ -209,15 +202,13 @@ LinuxEvent::Peek() const
 inline void
 LinuxEvent::Reset()
 {
-    pthread_mutex_lock(&this->mutex);
-    this->status = SIGNAL_NONE;
-    pthread_mutex_unlock(&this->mutex);    
+    __atomic_store_n(&this->status, SIGNAL_NONE, __ATOMIC_RELEASE);
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-inline bool 
+inline bool
 LinuxEvent::IsManual() const
 {
     return this->manualReset;
@@ -225,4 +216,3 @@ LinuxEvent::IsManual() const
 
 } // namespace Linux
 //------------------------------------------------------------------------------
-
@@ -0,0 +1,107 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Linux::LinuxFutex
+
+    Thin wrapper around the futex system call. A futex is just an int in
+    user memory, the kernel only gets involved when a thread actually has
+    to sleep or be woken up, so primitives built on top of it cost a single
+    atomic operation as long as nobody has to wait.
+
+    Wait() only puts the thread to sleep if the int still holds the
+    expected value when the kernel looks at it, which closes the race
+    between checking a condition and going to sleep. Waits may return
+    spuriously, so callers always have to check their condition again.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <climits>
+#include <errno.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+namespace Linux
+{
+class LinuxFutex
+{
+public:
+    /// sleep while *addr equals value, may return spuriously
+    static void Wait(const volatile int* addr, int value);
+    /// sleep while *addr equals value, with time-out in millisecs, returns false if the time-out expired
+    static bool WaitTimeout(const volatile int* addr, int value, int ms);
+    /// wake up one thread sleeping on addr
+    static void WakeOne(const volatile int* addr);
+    /// wake up all threads sleeping on addr
+    static void WakeAll(const volatile int* addr);
+    /// tell the cpu we are spinning on a futex word
+    static void Pause();
+};
+
+//------------------------------------------------------------------------------
+/**
+    The futexes are never shared between processes, so the private
+    operations are used, which skip the lookup of the backing memory
+    object in the kernel.
+*/
+inline void
+LinuxFutex::Wait(const volatile int* addr, int value)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+}
+
+//------------------------------------------------------------------------------
+/**
+    The time-out of FUTEX_WAIT is relative.
+*/
+inline bool
+LinuxFutex::WaitTimeout(const volatile int* addr, int value, int ms)
+{
+    timespec timeout;
+    timeout.tv_sec = ms / 1000;
+    timeout.tv_nsec = (ms % 1000) * 1000000;
+    long res = syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, &timeout, nullptr, 0);
+    return !(res == -1 && errno == ETIMEDOUT);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+LinuxFutex::WakeOne(const volatile int* addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+LinuxFutex::WakeAll(const volatile int* addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Architectures without a spin-wait hint just spin.
+*/
+__forceinline void
+LinuxFutex::Pause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+} // namespace Linux
+//------------------------------------------------------------------------------
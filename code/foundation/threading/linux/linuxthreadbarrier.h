@@ -0,0 +1,144 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Linux::LinuxThreadBarrier
+
+    Block until all thread have arrived at the barrier.
+
+    Threads which arrive early sleep on a generation count, which the last
+    thread bumps in SignalContinue(), instead of polling a semaphore.
+    Since a thread reads the generation while it still holds the critical
+    section from Arrive(), it can't miss the bump even if the others
+    already race ahead to the next round.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+#include "threading/criticalsection.h"
+#include "threading/futex.h"
+
+//------------------------------------------------------------------------------
+namespace Linux
+{
+class LinuxThreadBarrier
+{
+public:
+    /// constructor
+    LinuxThreadBarrier();
+    /// destructor
+    ~LinuxThreadBarrier();
+    /// setup the object with the number of threads
+    void Setup(SizeT numThreads);
+    /// return true if the object has been setup
+    bool IsValid() const;
+    /// enter thread barrier, return false if not all threads have arrived yet
+    bool Arrive();
+    /// call after Arrive() returns false to wait for other threads
+    void Wait();
+    /// call after Arrive() returns true to resume all threads
+    void SignalContinue();
+
+private:
+    Threading::CriticalSection critSect;
+    SizeT numThreads;
+    SizeT outstandingThreads;
+    volatile int generation;
+    bool isValid;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline
+LinuxThreadBarrier::LinuxThreadBarrier() :
+    numThreads(0),
+    outstandingThreads(0),
+    generation(0),
+    isValid(false)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline
+LinuxThreadBarrier::~LinuxThreadBarrier()
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+LinuxThreadBarrier::Setup(SizeT num)
+{
+    n_assert(!this->isValid);
+    this->numThreads = num;
+    this->outstandingThreads = num;
+    this->isValid = true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+LinuxThreadBarrier::IsValid() const
+{
+    return this->isValid;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Notify arrival at thread-sync point, return false if not all threads
+    have arrived yet, and true if all threads have arrived. If the
+    method returns false, you should immediately call Wait(), if the
+    method returns true, the caller has a chance to perform some actions
+    which should happen before threads continue, and then call the
+    SignalContinue() method.
+*/
+inline bool
+LinuxThreadBarrier::Arrive()
+{
+    this->critSect.Enter();
+    n_assert(this->outstandingThreads > 0);
+    this->outstandingThreads--;
+    return (0 == this->outstandingThreads);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+LinuxThreadBarrier::Wait()
+{
+    const int current = this->generation;
+    this->critSect.Leave();
+
+    IndexT i;
+    for (i = 0; i < Threading::FutexSpinCount && __atomic_load_n(&this->generation, __ATOMIC_ACQUIRE) == current; i++)
+    {
+        LinuxFutex::Pause();
+    }
+    while (__atomic_load_n(&this->generation, __ATOMIC_ACQUIRE) == current)
+    {
+        LinuxFutex::Wait(&this->generation, current);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+LinuxThreadBarrier::SignalContinue()
+{
+    this->outstandingThreads = this->numThreads;
+    __atomic_add_fetch(&this->generation, 1, __ATOMIC_RELEASE);
+    LinuxFutex::WakeAll(&this->generation);
+    this->critSect.Leave();
+}
+
+} // namespace Linux
+//------------------------------------------------------------------------------
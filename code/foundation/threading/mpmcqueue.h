@@ -0,0 +1,434 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Threading::MpmcQueue
+
+    Bounded lock-free queue for any number of producer and consumer threads.
+
+    The elements live in a ring, and every cell carries a sequence number
+    which says if the cell is ready to be written or read in the current
+    lap around the ring. A producer claims a position with a single
+    compare-and-swap on the enqueue position, writes its element and
+    publishes it by bumping the sequence number of the cell, consumers do
+    the same on the dequeue position. No nodes are allocated, and since
+    the two positions live on separate cache lines, producers and consumers
+    only touch the same memory when they meet in the same cell.
+
+    The capacity is rounded up to the next power of two. Enqueue() puts
+    the producer to sleep until a consumer makes room if the queue is
+    full, TryEnqueue() returns false instead. A producer which may also be
+    the consumer, or which must never wait on one, uses TryEnqueue() with
+    an overflow path of its own.
+
+    A consumer can block in Wait() until an element arrives. Both sides
+    sleep on a Futex word and only bump the word and wake the other side
+    while someone is actually waiting, so enqueueing into or dequeueing
+    from a queue nobody sleeps on never makes a system call.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "core/types.h"
+#include "threading/thread.h"
+#include "threading/futex.h"
+#include <atomic>
+
+namespace Threading
+{
+
+template <class TYPE>
+class MpmcQueue
+{
+public:
+    /// constructor
+    MpmcQueue();
+    /// destructor
+    ~MpmcQueue();
+
+    /// resizes the queue to hold at least N elements, must not run concurrently with anything else
+    void Resize(const SizeT size);
+    /// get the capacity
+    SizeT Capacity() const;
+
+    /// enqueue item, waits for room if the queue is full
+    void Enqueue(const TYPE& item);
+    /// enqueue item, waits for room if the queue is full
+    void Enqueue(TYPE&& item);
+    /// enqueue item, returns false if the queue is full
+    bool TryEnqueue(const TYPE& item);
+    /// enqueue item, returns false if the queue is full
+    bool TryEnqueue(TYPE&& item);
+    /// dequeue item, returns false if the queue is empty
+    bool Dequeue(TYPE& item);
+
+    /// get size, only a snapshot if other threads are using the queue
+    SizeT Size() const;
+    /// returns true if empty, only a snapshot if other threads are using the queue
+    bool IsEmpty() const;
+
+    /// wait until queue contains at least one element
+    void Wait();
+    /// wait until queue contains at least one element, or time-out happens
+    void WaitTimeout(int ms);
+    /// wake up a consumer, so that Wait() will return
+    void Signal();
+
+private:
+    struct Cell
+    {
+        std::atomic<uint64_t> sequence;
+        TYPE data;
+    };
+
+    /// claim a cell and move the item into it
+    template <class ARG> bool Push(ARG&& item);
+    /// returns true if the next cell to write still holds an element of the last lap
+    bool IsFull() const;
+    /// put the producer to sleep until the queue is no longer full
+    void WaitForRoom();
+    /// wake up a waiting consumer, if any
+    void SignalWaiting();
+    /// wake up a producer waiting for room, if any
+    void SignalRoom();
+
+    NEBULA_ALIGN_CACHELINE std::atomic<uint64_t> enqueuePos;
+    NEBULA_ALIGN_CACHELINE std::atomic<uint64_t> dequeuePos;
+    NEBULA_ALIGN_CACHELINE std::atomic<int> waiting;
+    std::atomic<int> producersWaiting;
+    AtomicCounter enqueueWord;
+    AtomicCounter dequeueWord;
+    AtomicCounter signaled;
+    Cell* cells;
+    uint64_t mask;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline
+MpmcQueue<TYPE>::MpmcQueue() :
+    enqueuePos(0),
+    dequeuePos(0),
+    waiting(0),
+    producersWaiting(0),
+    enqueueWord(0),
+    dequeueWord(0),
+    signaled(0),
+    cells(nullptr),
+    mask(0)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline
+MpmcQueue<TYPE>::~MpmcQueue()
+{
+    delete[] this->cells;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline void
+MpmcQueue<TYPE>::Resize(const SizeT size)
+{
+    n_assert(size > 0);
+    uint64_t capacity = 1;
+    while (capacity < (uint64_t)size)
+        capacity <<= 1;
+
+    delete[] this->cells;
+    this->cells = new Cell[capacity];
+    this->mask = capacity - 1;
+
+    uint64_t i;
+    for (i = 0; i < capacity; i++)
+        this->cells[i].sequence.store(i, std::memory_order_relaxed);
+    this->enqueuePos.store(0, std::memory_order_relaxed);
+    this->dequeuePos.store(0, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline SizeT
+MpmcQueue<TYPE>::Capacity() const
+{
+    return this->cells != nullptr ? (SizeT)(this->mask + 1) : 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline void
+MpmcQueue<TYPE>::Enqueue(const TYPE& item)
+{
+    while (!this->Push(item))
+        this->WaitForRoom();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Push() only moves from item once it has claimed a cell, so retrying
+    with the same item is fine
+*/
+template <class TYPE>
+inline void
+MpmcQueue<TYPE>::Enqueue(TYPE&& item)
+{
+    while (!this->Push(std::move(item)))
+        this->WaitForRoom();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline bool
+MpmcQueue<TYPE>::TryEnqueue(const TYPE& item)
+{
+    return this->Push(item);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline bool
+MpmcQueue<TYPE>::TryEnqueue(TYPE&& item)
+{
+    return this->Push(std::move(item));
+}
+
+//------------------------------------------------------------------------------
+/**
+    A cell is free to write in lap n when its sequence equals the position,
+    if it's lower the consumers are a whole lap behind and the queue is full.
+*/
+template <class TYPE>
+template <class ARG>
+inline bool
+MpmcQueue<TYPE>::Push(ARG&& item)
+{
+    n_assert(this->cells != nullptr);
+    Cell* cell;
+    uint64_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &this->cells[pos & this->mask];
+        const uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+        const int64_t diff = (int64_t)(seq - pos);
+        if (diff == 0)
+        {
+            // on failure, pos is reloaded with the current position
+            if (this->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return false;
+        else
+            pos = this->enqueuePos.load(std::memory_order_relaxed);
+    }
+
+    cell->data = std::forward<ARG>(item);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    this->SignalWaiting();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    A cell is ready to read when its sequence is one past the position,
+    once read it is handed to the producers of the next lap.
+*/
+template <class TYPE>
+inline bool
+MpmcQueue<TYPE>::Dequeue(TYPE& item)
+{
+    if (this->cells == nullptr)
+        return false;
+
+    Cell* cell;
+    uint64_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        cell = &this->cells[pos & this->mask];
+        const uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+        const int64_t diff = (int64_t)(seq - (pos + 1));
+        if (diff == 0)
+        {
+            if (this->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return false;
+        else
+            pos = this->dequeuePos.load(std::memory_order_relaxed);
+    }
+
+    item = std::move(cell->data);
+    cell->sequence.store(pos + this->mask + 1, std::memory_order_release);
+    this->SignalRoom();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline SizeT
+MpmcQueue<TYPE>::Size() const
+{
+    const uint64_t dequeued = this->dequeuePos.load(std::memory_order_relaxed);
+    const uint64_t enqueued = this->enqueuePos.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? (SizeT)(enqueued - dequeued) : 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline bool
+MpmcQueue<TYPE>::IsEmpty() const
+{
+    return this->Size() == 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The waiting count is raised before the word is read and the queue is
+    checked one last time, and producers check it after claiming their
+    position, so either the consumer sees the element or the producer sees
+    the consumer and moves the word, which keeps the Futex from sleeping.
+    A Signal() which arrives before any consumer gets here is remembered,
+    like the event it replaces.
+*/
+template <class TYPE>
+inline void
+MpmcQueue<TYPE>::Wait()
+{
+    if (!this->IsEmpty())
+        return;
+
+    this->waiting.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int word = this->enqueueWord;
+    if (this->IsEmpty() && Interlocked::Exchange(&this->signaled, 0) == 0)
+    {
+        Futex::Wait(&this->enqueueWord, word);
+        Interlocked::Exchange(&this->signaled, 0);
+    }
+    this->waiting.fetch_sub(1, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline void
+MpmcQueue<TYPE>::WaitTimeout(int ms)
+{
+    if (!this->IsEmpty())
+        return;
+
+    this->waiting.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int word = this->enqueueWord;
+    if (this->IsEmpty() && Interlocked::Exchange(&this->signaled, 0) == 0)
+    {
+        Futex::WaitTimeout(&this->enqueueWord, word, ms);
+        Interlocked::Exchange(&this->signaled, 0);
+    }
+    this->waiting.fetch_sub(1, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Wakes up a consumer in Wait(), or makes the next Wait() return right
+    away. This method may be useful to wake up a thread waiting for
+    elements when it should stop.
+*/
+template <class TYPE>
+inline void
+MpmcQueue<TYPE>::Signal()
+{
+    Interlocked::Exchange(&this->signaled, 1);
+    Interlocked::Increment(&this->enqueueWord);
+    Futex::WakeOne(&this->enqueueWord);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Looks at the cell rather than at the positions, a consumer may have
+    moved the dequeue position past a cell it hasn't handed back yet.
+*/
+template <class TYPE>
+inline bool
+MpmcQueue<TYPE>::IsFull() const
+{
+    const uint64_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+    const uint64_t seq = this->cells[pos & this->mask].sequence.load(std::memory_order_acquire);
+    return (int64_t)(seq - pos) < 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The same handshake as Wait() with the sides swapped, a producer raises
+    the count before it reads the word and looks for room one last time,
+    and consumers check the count after handing a cell back.
+*/
+template <class TYPE>
+inline void
+MpmcQueue<TYPE>::WaitForRoom()
+{
+    this->producersWaiting.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int word = this->dequeueWord;
+    if (this->IsFull())
+        Futex::Wait(&this->dequeueWord, word);
+    this->producersWaiting.fetch_sub(1, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+__forceinline void
+MpmcQueue<TYPE>::SignalWaiting()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->waiting.load(std::memory_order_relaxed) > 0)
+    {
+        Interlocked::Increment(&this->enqueueWord);
+        Futex::WakeOne(&this->enqueueWord);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Every dequeued cell makes room for exactly one producer, so one is
+    woken per cell instead of all of them racing for it.
+*/
+template <class TYPE>
+__forceinline void
+MpmcQueue<TYPE>::SignalRoom()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->producersWaiting.load(std::memory_order_relaxed) > 0)
+    {
+        Interlocked::Increment(&this->dequeueWord);
+        Futex::WakeOne(&this->dequeueWord);
+    }
+}
+
+} // namespace Threading
+//------------------------------------------------------------------------------
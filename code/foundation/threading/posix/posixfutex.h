@@ -0,0 +1,85 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Posix::PosixFutex
+
+    Fallback for Threading::Futex on platforms without a public futex
+    call. Waiting just gives up the time slice, which is allowed since
+    futex waits may always return spuriously, and waking up is a no-op.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+#include <sched.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+namespace Posix
+{
+class PosixFutex
+{
+public:
+    /// sleep while *addr equals value, may return spuriously
+    static void Wait(const volatile int* addr, int value);
+    /// sleep while *addr equals value, with time-out in millisecs, returns false if the time-out expired
+    static bool WaitTimeout(const volatile int* addr, int value, int ms);
+    /// wake up one thread sleeping on addr
+    static void WakeOne(const volatile int* addr);
+    /// wake up all threads sleeping on addr
+    static void WakeAll(const volatile int* addr);
+    /// tell the cpu we are spinning on a futex word
+    static void Pause();
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+PosixFutex::Wait(const volatile int* addr, int value)
+{
+    if (*addr == value)
+        sched_yield();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Sleeps for a millisecond at most, callers keep track of the total time.
+*/
+inline bool
+PosixFutex::WaitTimeout(const volatile int* addr, int value, int ms)
+{
+    if (*addr == value && ms > 0)
+        usleep(1000);
+    return ms > 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+PosixFutex::WakeOne(const volatile int* addr)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+PosixFutex::WakeAll(const volatile int* addr)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+PosixFutex::Pause()
+{
+    sched_yield();
+}
+
+} // namespace Posix
+//------------------------------------------------------------------------------
@@ -0,0 +1,416 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Threading::SpscQueue
+
+    Bounded lock-free queue between exactly one producer thread and one
+    consumer thread.
+
+    With a single thread on each side, the read and write positions are
+    each only written by their owner, so there are no compare-and-swaps,
+    just a release store to publish and an acquire load to observe. Each
+    side also keeps a copy of the other side's position and only reloads
+    it when the queue looks full or empty, so in steady state producer
+    and consumer don't even share a cache line.
+
+    The capacity is rounded up to the next power of two. Enqueue() puts
+    the producer to sleep until the consumer makes room if the queue is
+    full, TryEnqueue() returns false instead. Producers which must never
+    wait on the consumer use TryEnqueue() with an overflow path of their
+    own.
+
+    The consumer can block in Wait() until an element arrives. Both sides
+    sleep on a Futex word, and each side only bumps the word and wakes the
+    other while it is actually waiting, so neither enqueue nor dequeue
+    makes a system call while the other thread is busy.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "core/types.h"
+#include "threading/thread.h"
+#include "threading/futex.h"
+#include "util/array.h"
+#include <atomic>
+
+namespace Threading
+{
+
+template <class TYPE>
+class SpscQueue
+{
+public:
+    /// constructor
+    SpscQueue();
+    /// destructor
+    ~SpscQueue();
+
+    /// resizes the queue to hold at least N elements, must not run concurrently with anything else
+    void Resize(const SizeT size);
+    /// get the capacity
+    SizeT Capacity() const;
+
+    /// enqueue item from the producer thread, waits for room if the queue is full
+    void Enqueue(const TYPE& item);
+    /// enqueue item from the producer thread, waits for room if the queue is full
+    void Enqueue(TYPE&& item);
+    /// enqueue item from the producer thread, returns false if the queue is full
+    bool TryEnqueue(const TYPE& item);
+    /// enqueue item from the producer thread, returns false if the queue is full
+    bool TryEnqueue(TYPE&& item);
+    /// dequeue item from the consumer thread, returns false if the queue is empty
+    bool Dequeue(TYPE& item);
+    /// dequeue all items from the consumer thread
+    void DequeueAll(Util::Array<TYPE>& outArray);
+
+    /// get size, only a snapshot if the other thread is using the queue
+    SizeT Size() const;
+    /// returns true if empty, only a snapshot if the other thread is using the queue
+    bool IsEmpty() const;
+
+    /// wait until queue contains at least one element, consumer thread only
+    void Wait();
+    /// wait until queue contains at least one element, or time-out happens, consumer thread only
+    void WaitTimeout(int ms);
+    /// wake up the consumer, so that Wait() will return
+    void Signal();
+
+private:
+    /// write the item into the next free slot
+    template <class ARG> bool Push(ARG&& item);
+    /// put the producer to sleep until the queue is no longer full
+    void WaitForRoom();
+    /// wake up the consumer if it's waiting
+    void SignalWaiting();
+    /// wake up the producer if it's waiting for room
+    void SignalRoom();
+
+    // producer side
+    NEBULA_ALIGN_CACHELINE std::atomic<uint64_t> writePos;
+    uint64_t cachedReadPos;
+    std::atomic<int> producerWaiting;
+
+    // consumer side
+    NEBULA_ALIGN_CACHELINE std::atomic<uint64_t> readPos;
+    uint64_t cachedWritePos;
+    std::atomic<int> waiting;
+
+    NEBULA_ALIGN_CACHELINE TYPE* elements;
+    uint64_t mask;
+    AtomicCounter enqueueWord;
+    AtomicCounter dequeueWord;
+    AtomicCounter signaled;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline
+SpscQueue<TYPE>::SpscQueue() :
+    writePos(0),
+    cachedReadPos(0),
+    producerWaiting(0),
+    readPos(0),
+    cachedWritePos(0),
+    waiting(0),
+    elements(nullptr),
+    mask(0),
+    enqueueWord(0),
+    dequeueWord(0),
+    signaled(0)
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline
+SpscQueue<TYPE>::~SpscQueue()
+{
+    delete[] this->elements;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline void
+SpscQueue<TYPE>::Resize(const SizeT size)
+{
+    n_assert(size > 0);
+    uint64_t capacity = 1;
+    while (capacity < (uint64_t)size)
+        capacity <<= 1;
+
+    delete[] this->elements;
+    this->elements = new TYPE[capacity];
+    this->mask = capacity - 1;
+    this->writePos.store(0, std::memory_order_relaxed);
+    this->readPos.store(0, std::memory_order_relaxed);
+    this->cachedReadPos = 0;
+    this->cachedWritePos = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline SizeT
+SpscQueue<TYPE>::Capacity() const
+{
+    return this->elements != nullptr ? (SizeT)(this->mask + 1) : 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline void
+SpscQueue<TYPE>::Enqueue(const TYPE& item)
+{
+    while (!this->Push(item))
+        this->WaitForRoom();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Push() only moves from item once there is room, so retrying with the
+    same item is fine
+*/
+template <class TYPE>
+inline void
+SpscQueue<TYPE>::Enqueue(TYPE&& item)
+{
+    while (!this->Push(std::move(item)))
+        this->WaitForRoom();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline bool
+SpscQueue<TYPE>::TryEnqueue(const TYPE& item)
+{
+    return this->Push(item);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline bool
+SpscQueue<TYPE>::TryEnqueue(TYPE&& item)
+{
+    return this->Push(std::move(item));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+template <class ARG>
+inline bool
+SpscQueue<TYPE>::Push(ARG&& item)
+{
+    n_assert(this->elements != nullptr);
+    const uint64_t pos = this->writePos.load(std::memory_order_relaxed);
+    if (pos - this->cachedReadPos > this->mask)
+    {
+        // looks full, see how far the consumer has come
+        this->cachedReadPos = this->readPos.load(std::memory_order_acquire);
+        if (pos - this->cachedReadPos > this->mask)
+            return false;
+    }
+
+    this->elements[pos & this->mask] = std::forward<ARG>(item);
+    this->writePos.store(pos + 1, std::memory_order_release);
+    this->SignalWaiting();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline bool
+SpscQueue<TYPE>::Dequeue(TYPE& item)
+{
+    const uint64_t pos = this->readPos.load(std::memory_order_relaxed);
+    if (pos == this->cachedWritePos)
+    {
+        // looks empty, see if the producer has added anything
+        this->cachedWritePos = this->writePos.load(std::memory_order_acquire);
+        if (pos == this->cachedWritePos)
+            return false;
+    }
+
+    item = std::move(this->elements[pos & this->mask]);
+    this->readPos.store(pos + 1, std::memory_order_release);
+    this->SignalRoom();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Takes everything which has been published when the call starts, and
+    hands the slots back to the producer in one store.
+*/
+template <class TYPE>
+inline void
+SpscQueue<TYPE>::DequeueAll(Util::Array<TYPE>& outArray)
+{
+    outArray.Clear();
+    uint64_t pos = this->readPos.load(std::memory_order_relaxed);
+    this->cachedWritePos = this->writePos.load(std::memory_order_acquire);
+    if (pos == this->cachedWritePos)
+        return;
+
+    for (; pos != this->cachedWritePos; pos++)
+    {
+        outArray.Append(std::move(this->elements[pos & this->mask]));
+    }
+    this->readPos.store(pos, std::memory_order_release);
+    this->SignalRoom();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline SizeT
+SpscQueue<TYPE>::Size() const
+{
+    const uint64_t read = this->readPos.load(std::memory_order_relaxed);
+    const uint64_t write = this->writePos.load(std::memory_order_relaxed);
+    return write > read ? (SizeT)(write - read) : 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline bool
+SpscQueue<TYPE>::IsEmpty() const
+{
+    return this->Size() == 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The waiting flag is raised before the word is read and the queue is
+    checked one last time, and the producer checks the flag after
+    publishing, so either the consumer sees the element or the producer
+    sees the consumer and moves the word, which keeps the Futex from
+    sleeping. A Signal() which arrives before the consumer gets here is
+    remembered, like the event it replaces.
+*/
+template <class TYPE>
+inline void
+SpscQueue<TYPE>::Wait()
+{
+    if (!this->IsEmpty())
+        return;
+
+    this->waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int word = this->enqueueWord;
+    if (this->IsEmpty() && Interlocked::Exchange(&this->signaled, 0) == 0)
+    {
+        Futex::Wait(&this->enqueueWord, word);
+        Interlocked::Exchange(&this->signaled, 0);
+    }
+    this->waiting.store(0, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+inline void
+SpscQueue<TYPE>::WaitTimeout(int ms)
+{
+    if (!this->IsEmpty())
+        return;
+
+    this->waiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int word = this->enqueueWord;
+    if (this->IsEmpty() && Interlocked::Exchange(&this->signaled, 0) == 0)
+    {
+        Futex::WaitTimeout(&this->enqueueWord, word, ms);
+        Interlocked::Exchange(&this->signaled, 0);
+    }
+    this->waiting.store(0, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Wakes up the consumer in Wait(), or makes its next Wait() return right
+    away. This method may be useful to wake up a thread waiting for
+    elements when it should stop.
+*/
+template <class TYPE>
+inline void
+SpscQueue<TYPE>::Signal()
+{
+    Interlocked::Exchange(&this->signaled, 1);
+    Interlocked::Increment(&this->enqueueWord);
+    Futex::WakeOne(&this->enqueueWord);
+}
+
+//------------------------------------------------------------------------------
+/**
+    The same handshake as Wait() with the sides swapped, the producer
+    raises its flag before it reads the word and looks for room one last
+    time, and the consumer checks the flag after handing slots back.
+*/
+template <class TYPE>
+inline void
+SpscQueue<TYPE>::WaitForRoom()
+{
+    this->producerWaiting.store(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int word = this->dequeueWord;
+    const uint64_t pos = this->writePos.load(std::memory_order_relaxed);
+    if (pos - this->readPos.load(std::memory_order_acquire) > this->mask)
+        Futex::Wait(&this->dequeueWord, word);
+    this->producerWaiting.store(0, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+__forceinline void
+SpscQueue<TYPE>::SignalWaiting()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->waiting.load(std::memory_order_relaxed) != 0)
+    {
+        Interlocked::Increment(&this->enqueueWord);
+        Futex::WakeOne(&this->enqueueWord);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template <class TYPE>
+__forceinline void
+SpscQueue<TYPE>::SignalRoom()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->producerWaiting.load(std::memory_order_relaxed) != 0)
+    {
+        Interlocked::Increment(&this->dequeueWord);
+        Futex::WakeOne(&this->dequeueWord);
+    }
+}
+
+} // namespace Threading
+//------------------------------------------------------------------------------
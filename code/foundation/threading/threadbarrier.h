@@ -17,7 +17,14 @@ namespace Threading
 class ThreadBarrier : public Win32::Win32ThreadBarrier
 { };
 }
-#elif (__linux__ || __OSX__ || __APPLE__)
+#elif __linux__
+#include "threading/linux/linuxthreadbarrier.h"
+namespace Threading
+{
+class ThreadBarrier : public Linux::LinuxThreadBarrier
+{ };
+}
+#elif (__OSX__ || __APPLE__)
 namespace Threading
 {
 #include "threading/posix/posixthreadbarrier.h"
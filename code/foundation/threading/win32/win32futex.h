@@ -0,0 +1,83 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Win32::Win32Futex
+
+    Win32 implementation of Threading::Futex on top of WaitOnAddress(),
+    which behaves like a Linux futex: the thread only sleeps if the
+    address still holds the expected value, and waits may return
+    spuriously. Needs Synchronization.lib.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+#include <immintrin.h>
+
+//------------------------------------------------------------------------------
+namespace Win32
+{
+class Win32Futex
+{
+public:
+    /// sleep while *addr equals value, may return spuriously
+    static void Wait(const volatile int* addr, int value);
+    /// sleep while *addr equals value, with time-out in millisecs, returns false if the time-out expired
+    static bool WaitTimeout(const volatile int* addr, int value, int ms);
+    /// wake up one thread sleeping on addr
+    static void WakeOne(const volatile int* addr);
+    /// wake up all threads sleeping on addr
+    static void WakeAll(const volatile int* addr);
+    /// tell the cpu we are spinning on a futex word
+    static void Pause();
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+Win32Futex::Wait(const volatile int* addr, int value)
+{
+    WaitOnAddress((volatile VOID*)addr, &value, sizeof(int), INFINITE);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline bool
+Win32Futex::WaitTimeout(const volatile int* addr, int value, int ms)
+{
+    if (WaitOnAddress((volatile VOID*)addr, &value, sizeof(int), ms))
+        return true;
+    return GetLastError() != ERROR_TIMEOUT;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+Win32Futex::WakeOne(const volatile int* addr)
+{
+    WakeByAddressSingle((PVOID)addr);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+Win32Futex::WakeAll(const volatile int* addr)
+{
+    WakeByAddressAll((PVOID)addr);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+__forceinline void
+Win32Futex::Pause()
+{
+    _mm_pause();
+}
+
+} // namespace Win32
+//------------------------------------------------------------------------------
@@ -9,9 +9,11 @@
     The default constructor will not pre-allocate elements, so no space
     is wasted as long as no elements are added. As soon as the first element
     is added to the array, an initial buffer of 16 elements is created.
-    Whenever the element buffer would overflow, a new buffer of twice
-    the size of the previous buffer is created and the existing elements 
-    are then copied over to the new buffer. The element buffer will
+    Whenever the element buffer would overflow, a new buffer of one and
+    a half times the size of the previous buffer is created and the existing
+    elements are then moved over to the new buffer. Element types which are
+    trivially relocatable (see Memory::IsTriviallyRelocatable) skip the move
+    and grow their buffer with a realloc instead. The element buffer will
     never shrink, the only way to reclaim unused memory is to 
     copy the Array to a new Array object. This is usually not a problem
     since most arrays will oscillate around some specific size, so once
@@ -27,6 +29,11 @@
     element shuffling in some situations (especially when sorting and erasing
     elements).
 
+    The element buffer is allocated through the ALLOCATOR policy, which
+    defaults to the object array heap (see Memory::ObjectArrayHeapAllocator).
+    Short-lived arrays can use a policy which allocates from scratch memory
+    that is released in bulk, like Jobs2::JobScratchAllocator.
+
     @copyright
     (C) 2006 RadonLabs GmbH
     (C) 2013-2020 Individual contributors, see AUTHORS file
@@ -56,14 +63,14 @@ struct _smallvector<TYPE, 0>
     TYPE* data() { return nullptr; }
 };
 
-template<class TYPE, int SMALL_VECTOR_SIZE = 0> class Array
+template<class TYPE, int SMALL_VECTOR_SIZE = 0, class ALLOCATOR = Memory::ObjectArrayHeapAllocator> class Array
 {
 public:
     /// define iterator
     typedef TYPE* Iterator;
     typedef const TYPE* ConstIterator;
 
-    using ArrayT = Array<TYPE, SMALL_VECTOR_SIZE>;
+    using ArrayT = Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>;
 
     /// constructor with default parameters
     Array();
@@ -85,17 +92,17 @@ public:
     ~Array();
 
     /// assignment operator
-    void operator=(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs);
+    void operator=(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs);
     /// move operator
-    void operator=(Array<TYPE, SMALL_VECTOR_SIZE>&& rhs) noexcept;
+    void operator=(Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>&& rhs) noexcept;
     /// [] operator
     TYPE& operator[](IndexT index) const;
     /// [] operator
     TYPE& operator[](IndexT index);
     /// equality operator
-    bool operator==(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs) const;
+    bool operator==(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs) const;
     /// inequality operator
-    bool operator!=(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs) const;
+    bool operator!=(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs) const;
     /// convert to "anything"
     template<typename T> T As() const;
 
@@ -110,7 +117,7 @@ public:
     /// append an element which is being forwarded
     void Append(TYPE&& elm);
     /// append the contents of an array to this array
-    void AppendArray(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs);
+    void AppendArray(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs);
     /// append from C array
     void AppendArray(const TYPE* arr, const SizeT count);
     /// Emplace item (create new item and return reference)
@@ -185,7 +192,7 @@ public:
     /// clear contents and preallocate with new attributes
     void Realloc(SizeT capacity, SizeT grow);
     /// returns new array with elements which are not in rhs (slow!)
-    ArrayT Difference(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs);
+    ArrayT Difference(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs);
     /// sort the array
     void Sort();
     /// quick sort the array
@@ -222,7 +229,7 @@ protected:
     /// destroy an element (call destructor without freeing memory)
     void Destroy(TYPE* elm);
     /// copy content
-    void Copy(const Array<TYPE, SMALL_VECTOR_SIZE>& src);
+    void Copy(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& src);
     /// delete content
     void Delete();
     /// grow array to target size
@@ -237,7 +244,6 @@ protected:
     void MoveRange(TYPE* to, TYPE* from, SizeT num);
 
     static const SizeT MinGrowSize = 16;
-    static const SizeT MaxGrowSize = 65536; // FIXME: big grow size needed for mesh tools
     SizeT grow;                             // grow by this number of elements if array exhausted
     SizeT capacity;                         // number of elements allocated
     SizeT count;                            // number of elements in array
@@ -249,8 +255,8 @@ protected:
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::Array() :
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Array() :
     grow(16),
     capacity(SMALL_VECTOR_SIZE),
     count(0),
@@ -261,8 +267,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Array() :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::Array(SizeT _capacity, SizeT _grow) :
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Array(SizeT _capacity, SizeT _grow) :
     grow(_grow),
     capacity(SMALL_VECTOR_SIZE),
     count(0),
@@ -278,8 +284,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Array(SizeT _capacity, SizeT _grow) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::Array(SizeT initialSize, SizeT _grow, const TYPE& initialValue) :
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Array(SizeT initialSize, SizeT _grow, const TYPE& initialValue) :
     grow(_grow),
     capacity(SMALL_VECTOR_SIZE),
     count(0),
@@ -302,8 +308,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Array(SizeT initialSize, SizeT _grow, const TYPE
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::Array(const TYPE* const buf, SizeT num) :
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Array(const TYPE* const buf, SizeT num) :
     grow(16),
     capacity(SMALL_VECTOR_SIZE),
     count(0),
@@ -319,8 +325,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Array(const TYPE* const buf, SizeT num) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::Array(std::initializer_list<TYPE> list) :
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Array(std::initializer_list<TYPE> list) :
     grow(16),
     capacity(SMALL_VECTOR_SIZE),
     count(0),
@@ -338,8 +344,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Array(std::initializer_list<TYPE> list) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::Array(std::nullptr_t) :
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Array(std::nullptr_t) :
     grow(16),
     capacity(SMALL_VECTOR_SIZE),
     count(0),
@@ -350,8 +356,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Array(std::nullptr_t) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::Array(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs) :
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Array(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs) :
     grow(16),
     capacity(SMALL_VECTOR_SIZE),
     count(0),
@@ -363,8 +369,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Array(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::Array(Array<TYPE, SMALL_VECTOR_SIZE>&& rhs) noexcept :
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Array(Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>&& rhs) noexcept :
     grow(rhs.grow),
     capacity(rhs.capacity),
     count(rhs.count),
@@ -389,9 +395,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Array(Array<TYPE, SMALL_VECTOR_SIZE>&& rhs) noex
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Copy(const Array<TYPE, SMALL_VECTOR_SIZE>& src)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Copy(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& src)
 {
     #if NEBULA_BOUNDSCHECKS
     // Make sure array is either empty, or stack array before copy
@@ -411,9 +417,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Copy(const Array<TYPE, SMALL_VECTOR_SIZE>& src)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Delete()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Delete()
 {
     this->grow = 16;
     
@@ -421,7 +427,7 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Delete()
     {
         if (this->elements != this->stackElements.data())
         {
-            ArrayFree(this->capacity, this->elements);
+            ArrayFree<TYPE, ALLOCATOR>(this->capacity, this->elements);
         }
         else
         {
@@ -437,8 +443,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Delete()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> void
-Array<TYPE, SMALL_VECTOR_SIZE>::Destroy(TYPE* elm)
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> void
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Destroy(TYPE* elm)
 {
     elm->~TYPE();
 }
@@ -446,8 +452,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Destroy(TYPE* elm)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::~Array()
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::~Array()
 {
     this->Delete();
 }
@@ -455,8 +461,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::~Array()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> void
-Array<TYPE, SMALL_VECTOR_SIZE>::Realloc(SizeT _capacity, SizeT _grow)
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> void
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Realloc(SizeT _capacity, SizeT _grow)
 {
     this->Delete();
     this->grow = _grow;
@@ -475,8 +481,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Realloc(SizeT _capacity, SizeT _grow)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> void 
-Array<TYPE, SMALL_VECTOR_SIZE>::operator=(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs)
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> void 
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::operator=(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs)
 {
     if (this != &rhs)
     {
@@ -505,8 +511,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::operator=(const Array<TYPE, SMALL_VECTOR_SIZE>&
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> void
-Array<TYPE, SMALL_VECTOR_SIZE>::operator=(Array<TYPE, SMALL_VECTOR_SIZE>&& rhs) noexcept
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> void
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::operator=(Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>&& rhs) noexcept
 {
     if (this != &rhs)
     {
@@ -535,19 +541,31 @@ Array<TYPE, SMALL_VECTOR_SIZE>::operator=(Array<TYPE, SMALL_VECTOR_SIZE>&& rhs)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> void
-Array<TYPE, SMALL_VECTOR_SIZE>::GrowTo(SizeT newCapacity)
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> void
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::GrowTo(SizeT newCapacity)
 {
     if (newCapacity > SMALL_VECTOR_SIZE)
     {
-        TYPE* newArray = ArrayAlloc<TYPE>(newCapacity);
+        if constexpr (Memory::IsTriviallyRelocatable<TYPE>::value)
+        {
+            // realloc may extend the buffer in place, and otherwise copies the
+            // whole capacity, which is fine as the elements don't care where they live
+            if (this->elements && this->elements != this->stackElements.data() && this->capacity > 0)
+            {
+                this->elements = ArrayRealloc<TYPE, ALLOCATOR>(this->capacity, newCapacity, this->elements);
+                this->capacity = newCapacity;
+                return;
+            }
+        }
+
+        TYPE* newArray = ArrayAlloc<TYPE, ALLOCATOR>(newCapacity);
         if (this->elements)
         {
             this->MoveRange(newArray, this->elements, this->count);
 
             // discard old array if not the stack array
             if (this->elements != this->stackElements.data())
-                ArrayFree(this->capacity, this->elements);
+                ArrayFree<TYPE, ALLOCATOR>(this->capacity, this->elements);
         }
         this->elements = newArray;
         this->capacity = newCapacity;
@@ -557,9 +575,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::GrowTo(SizeT newCapacity)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Grow()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Grow()
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->grow > 0);
@@ -572,16 +590,13 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Grow()
     }
     else
     {
-        // grow by half of the current capacity, but never more then MaxGrowSize
+        // grow by half of the current capacity, keeping the growth geometric
+        // so appending stays amortized O(1) even for very large arrays
         SizeT growBy = this->capacity >> 1;
         if (growBy == 0)
         {
             growBy = MinGrowSize;
         }
-        else if (growBy > MaxGrowSize)
-        {
-            growBy = MaxGrowSize;
-        }
         growToSize = this->capacity + growBy;
     }
     this->GrowTo(growToSize);
@@ -592,9 +607,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Grow()
     30-Jan-03   floh    serious bugfixes!
     07-Dec-04   jo      bugfix: neededSize >= this->capacity => neededSize > capacity   
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Move(IndexT fromIndex, IndexT toIndex)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Move(IndexT fromIndex, IndexT toIndex)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements);
@@ -643,9 +658,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Move(IndexT fromIndex, IndexT toIndex)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 inline void 
-Array<TYPE, SMALL_VECTOR_SIZE>::DestroyRange(IndexT fromIndex, IndexT toIndex)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::DestroyRange(IndexT fromIndex, IndexT toIndex)
 {    
     if constexpr (!std::is_trivially_destructible<TYPE>::value)
     {
@@ -663,9 +678,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::DestroyRange(IndexT fromIndex, IndexT toIndex)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 inline void 
-Array<TYPE, SMALL_VECTOR_SIZE>::CopyRange(TYPE* to, TYPE* from, SizeT num)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::CopyRange(TYPE* to, TYPE* from, SizeT num)
 {
     // this is a backward move
     if constexpr (!std::is_trivially_copyable<TYPE>::value)
@@ -685,9 +700,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::CopyRange(TYPE* to, TYPE* from, SizeT num)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 inline void 
-Array<TYPE, SMALL_VECTOR_SIZE>::MoveRange(TYPE* to, TYPE* from, SizeT num)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::MoveRange(TYPE* to, TYPE* from, SizeT num)
 {
     // copy over contents
     if constexpr (!std::is_trivially_move_assignable<TYPE>::value && std::is_move_assignable<TYPE>::value)
@@ -707,9 +722,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::MoveRange(TYPE* to, TYPE* from, SizeT num)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 inline TYPE& 
-Array<TYPE, SMALL_VECTOR_SIZE>::Get(IndexT index) const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Get(IndexT index) const
 {
 #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements != nullptr);
@@ -721,9 +736,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Get(IndexT index) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Append(const TYPE& elm)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Append(const TYPE& elm)
 {
     // grow allocated space if exhausted
     if (this->count == this->capacity)
@@ -739,9 +754,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Append(const TYPE& elm)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void 
-Array<TYPE, SMALL_VECTOR_SIZE>::Append(TYPE&& elm)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Append(TYPE&& elm)
 {
     // grow allocated space if exhausted
     if (this->count == this->capacity)
@@ -757,9 +772,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Append(TYPE&& elm)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::AppendArray(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::AppendArray(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs)
 {
     SizeT neededCapacity = this->count + rhs.count;
     if (neededCapacity > this->capacity)
@@ -779,9 +794,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::AppendArray(const Array<TYPE, SMALL_VECTOR_SIZE>
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::AppendArray(const TYPE* arr, const SizeT count)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::AppendArray(const TYPE* arr, const SizeT count)
 {
     SizeT neededCapacity = this->count + count;
     if (neededCapacity > this->capacity)
@@ -801,9 +816,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::AppendArray(const TYPE* arr, const SizeT count)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 TYPE& 
-Array<TYPE, SMALL_VECTOR_SIZE>::Emplace()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Emplace()
 {
     // grow allocated space if exhausted
     if (this->count == this->capacity)
@@ -820,9 +835,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Emplace()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 TYPE* 
-Array<TYPE, SMALL_VECTOR_SIZE>::EmplaceArray(const SizeT count)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::EmplaceArray(const SizeT count)
 {
     SizeT neededCapacity = this->count + count;
     if (neededCapacity > this->capacity)
@@ -851,9 +866,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::EmplaceArray(const SizeT count)
     NOTE: the functionality of this method has been changed as of 26-Apr-08,
     it will now only change the capacity of the array, not its size.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Reserve(SizeT num)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Reserve(SizeT num)
 {
 #if NEBULA_BOUNDSCHECKS
     n_assert(num >= 0);
@@ -869,9 +884,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Reserve(SizeT num)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 const SizeT
-Array<TYPE, SMALL_VECTOR_SIZE>::Size() const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Size() const
 {
     return this->count;
 }
@@ -879,9 +894,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Size() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 const SizeT
-Array<TYPE, SMALL_VECTOR_SIZE>::ByteSize() const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::ByteSize() const
 {
     return this->count * sizeof(TYPE);
 }
@@ -889,9 +904,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::ByteSize() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 const SizeT
-Array<TYPE, SMALL_VECTOR_SIZE>::Capacity() const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Capacity() const
 {
     return this->capacity;
 }
@@ -901,9 +916,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Capacity() const
     Access an element. This method will NOT grow the array, and instead do
     a range check, which may throw an assertion.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 TYPE&
-Array<TYPE, SMALL_VECTOR_SIZE>::operator[](IndexT index) const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::operator[](IndexT index) const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements && (index < this->count) && (index >= 0));
@@ -916,9 +931,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::operator[](IndexT index) const
     Access an element. This method will NOT grow the array, and instead do
     a range check, which may throw an assertion.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 TYPE&
-Array<TYPE, SMALL_VECTOR_SIZE>::operator[](IndexT index) 
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::operator[](IndexT index) 
 {
 #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements && (index < this->count) && (index >= 0));
@@ -931,9 +946,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::operator[](IndexT index)
     The equality operator returns true if all elements are identical. The
     TYPE class must support the equality operator.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 bool
-Array<TYPE, SMALL_VECTOR_SIZE>::operator==(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs) const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::operator==(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs) const
 {
     if (rhs.Size() == this->Size())
     {
@@ -959,9 +974,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::operator==(const Array<TYPE, SMALL_VECTOR_SIZE>&
     The inequality operator returns true if at least one element in the 
     array is different, or the array sizes are different.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 bool
-Array<TYPE, SMALL_VECTOR_SIZE>::operator!=(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs) const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::operator!=(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs) const
 {
     return !(*this == rhs);
 }
@@ -969,9 +984,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::operator!=(const Array<TYPE, SMALL_VECTOR_SIZE>&
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 TYPE&
-Array<TYPE, SMALL_VECTOR_SIZE>::Front() const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Front() const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements && (this->count > 0));
@@ -982,9 +997,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Front() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 TYPE&
-Array<TYPE, SMALL_VECTOR_SIZE>::Back() const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Back() const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements && (this->count > 0));
@@ -995,9 +1010,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Back() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::push_back(const TYPE& item)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::push_back(const TYPE& item)
 {
     this->Append(item);
 }
@@ -1005,9 +1020,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::push_back(const TYPE& item)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 bool 
-Array<TYPE, SMALL_VECTOR_SIZE>::IsEmpty() const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::IsEmpty() const
 {
     return (this->count == 0);
 }
@@ -1015,9 +1030,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::IsEmpty() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 bool
-Array<TYPE, SMALL_VECTOR_SIZE>::IsValidIndex(IndexT index) const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::IsValidIndex(IndexT index) const
 {
     return this->elements && (index < this->count) && (index >= 0);
 }
@@ -1025,9 +1040,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::IsValidIndex(IndexT index) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::EraseIndex(IndexT index)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::EraseIndex(IndexT index)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements && (index < this->count) && (index >= 0));
@@ -1047,9 +1062,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::EraseIndex(IndexT index)
 /**    
     NOTE: this method is fast but destroys the sorting order!
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::EraseIndexSwap(IndexT index)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::EraseIndexSwap(IndexT index)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements && (index < this->count) && (index >= 0));
@@ -1070,9 +1085,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::EraseIndexSwap(IndexT index)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-typename Array<TYPE, SMALL_VECTOR_SIZE>::Iterator
-Array<TYPE, SMALL_VECTOR_SIZE>::Erase(typename Array<TYPE, SMALL_VECTOR_SIZE>::Iterator iter)
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Iterator
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Erase(typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Iterator iter)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements && (iter >= this->elements) && (iter < (this->elements + this->count)));
@@ -1085,9 +1100,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Erase(typename Array<TYPE, SMALL_VECTOR_SIZE>::I
 /**
     NOTE: this method is fast but destroys the sorting order!
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-typename Array<TYPE, SMALL_VECTOR_SIZE>::Iterator
-Array<TYPE, SMALL_VECTOR_SIZE>::EraseSwap(typename Array<TYPE, SMALL_VECTOR_SIZE>::Iterator iter)
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Iterator
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::EraseSwap(typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Iterator iter)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements && (iter >= this->elements) && (iter < (this->elements + this->count)));
@@ -1099,9 +1114,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::EraseSwap(typename Array<TYPE, SMALL_VECTOR_SIZE
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void 
-Array<TYPE, SMALL_VECTOR_SIZE>::EraseRange(IndexT start, IndexT end)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::EraseRange(IndexT start, IndexT end)
 {
     n_assert(end >= start);
     n_assert(end <= this->count);
@@ -1120,9 +1135,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::EraseRange(IndexT start, IndexT end)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::EraseBack()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::EraseBack()
 {
     n_assert(this->count > 0);
     if constexpr (!std::is_trivially_destructible<TYPE>::value)
@@ -1133,9 +1148,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::EraseBack()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::EraseFront()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::EraseFront()
 {
     this->EraseIndex(0);
 }
@@ -1143,9 +1158,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::EraseFront()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 inline TYPE 
-Array<TYPE, SMALL_VECTOR_SIZE>::PopFront()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::PopFront()
 {
 #if NEBULA_BOUNDSCHECKS
     n_assert(this->count > 0);
@@ -1158,9 +1173,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::PopFront()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 inline TYPE 
-Array<TYPE, SMALL_VECTOR_SIZE>::PopBack()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::PopBack()
 {
 #if NEBULA_BOUNDSCHECKS
     n_assert(this->count > 0);
@@ -1172,9 +1187,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::PopBack()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Insert(IndexT index, const TYPE& elm)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Insert(IndexT index, const TYPE& elm)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(index <= this->count && (index >= 0));
@@ -1196,9 +1211,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Insert(IndexT index, const TYPE& elm)
     The current implementation of this method does not shrink the 
     preallocated space. It simply sets the array _size to 0.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Clear()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Clear()
 {
     if (this->count > 0)
     {
@@ -1212,9 +1227,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Clear()
     This is identical with Clear(), but does NOT call destructors (it just
     resets the _size member. USE WITH CARE!
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Reset()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Reset()
 {
     this->count = 0;
 }
@@ -1223,9 +1238,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Reset()
 /**
     Free up memory and reset the grow
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void 
-Array<TYPE, SMALL_VECTOR_SIZE>::Free()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Free()
 {
     this->Delete();
     this->grow = 16;
@@ -1234,9 +1249,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Free()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-typename Array<TYPE, SMALL_VECTOR_SIZE>::Iterator
-Array<TYPE, SMALL_VECTOR_SIZE>::Begin() const
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Iterator
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Begin() const
 {
     return this->elements;
 }
@@ -1244,19 +1259,19 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Begin() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-typename Array<TYPE, SMALL_VECTOR_SIZE>::ConstIterator
-Array<TYPE, SMALL_VECTOR_SIZE>::ConstBegin() const
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::ConstIterator
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::ConstBegin() const
 {
-    return static_cast<Array<TYPE, SMALL_VECTOR_SIZE>::ConstIterator>(this->elements);
+    return static_cast<Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::ConstIterator>(this->elements);
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-typename Array<TYPE, SMALL_VECTOR_SIZE>::Iterator
-Array<TYPE, SMALL_VECTOR_SIZE>::End() const
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Iterator
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::End() const
 {
     return this->elements + this->count;
 }
@@ -1264,11 +1279,11 @@ Array<TYPE, SMALL_VECTOR_SIZE>::End() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-typename Array<TYPE, SMALL_VECTOR_SIZE>::ConstIterator
-Array<TYPE, SMALL_VECTOR_SIZE>::ConstEnd() const
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::ConstIterator
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::ConstEnd() const
 {
-    return static_cast<Array<TYPE, SMALL_VECTOR_SIZE>::ConstIterator>(this->elements + this->count);
+    return static_cast<Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::ConstIterator>(this->elements + this->count);
 }
 
 //------------------------------------------------------------------------------
@@ -1279,9 +1294,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::ConstEnd() const
     @param  elm     element to find
     @return         element iterator, or 0 if not found
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-typename Array<TYPE, SMALL_VECTOR_SIZE>::Iterator
-Array<TYPE, SMALL_VECTOR_SIZE>::Find(const TYPE& elm, const IndexT start) const
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Iterator
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Find(const TYPE& elm, const IndexT start) const
 {
     n_assert(start <= this->count);
     IndexT index;
@@ -1303,9 +1318,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Find(const TYPE& elm, const IndexT start) const
     @param  elm     element to find
     @return         index to element, or InvalidIndex if not found
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 IndexT
-Array<TYPE, SMALL_VECTOR_SIZE>::FindIndex(const TYPE& elm, const IndexT start) const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::FindIndex(const TYPE& elm, const IndexT start) const
 {
     n_assert(start <= this->count);
     IndexT index;
@@ -1322,10 +1337,10 @@ Array<TYPE, SMALL_VECTOR_SIZE>::FindIndex(const TYPE& elm, const IndexT start) c
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 template<typename ...ELEM_TYPE>
 inline void 
-Array<TYPE, SMALL_VECTOR_SIZE>::Append(const TYPE& first, const ELEM_TYPE&... elements)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Append(const TYPE& first, const ELEM_TYPE&... elements)
 {
     // The plus one is for the first element
     const int size = sizeof...(elements) + 1;
@@ -1352,10 +1367,10 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Append(const TYPE& first, const ELEM_TYPE&... el
     @param  elm     element to find
     @return         index to element, or InvalidIndex if not found
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 template<typename KEYTYPE> 
 inline IndexT
-Array<TYPE, SMALL_VECTOR_SIZE>::FindIndex(typename std::enable_if<true, const KEYTYPE&>::type elm, const IndexT start) const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::FindIndex(typename std::enable_if<true, const KEYTYPE&>::type elm, const IndexT start) const
 {
     n_assert(start <= this->count);
     IndexT index;
@@ -1378,9 +1393,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::FindIndex(typename std::enable_if<true, const KE
     @param  num     num elements to fill
     @param  elm     fill value
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Fill(IndexT first, SizeT num, const TYPE& elm)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Fill(IndexT first, SizeT num, const TYPE& elm)
 {
     if ((first + num) > this->count)
     {
@@ -1402,11 +1417,11 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Fill(IndexT first, SizeT num, const TYPE& elm)
 
     @todo this method is broken, check test case to see why!
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-Array<TYPE, SMALL_VECTOR_SIZE>
-Array<TYPE, SMALL_VECTOR_SIZE>::Difference(const Array<TYPE, SMALL_VECTOR_SIZE>& rhs)
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Difference(const Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>& rhs)
 {
-    Array<TYPE, SMALL_VECTOR_SIZE> diff;
+    Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR> diff;
     IndexT i;
     SizeT num = rhs.Size();
     for (i = 0; i < num; i++)
@@ -1423,9 +1438,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Difference(const Array<TYPE, SMALL_VECTOR_SIZE>&
 /**
     Sorts the array. This just calls the STL sort algorithm.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Sort()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Sort()
 {
     std::sort(this->Begin(), this->End());
 }
@@ -1434,9 +1449,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Sort()
 /**
     Sorts the array using quick sort. This just calls the STL sort algorithm.
 */
-template <class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::QuickSort()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::QuickSort()
 {
     std::qsort(
         this->Begin(),
@@ -1454,9 +1469,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::QuickSort()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Util::Array<TYPE, SMALL_VECTOR_SIZE>::SortWithFunc(bool (*func)(const TYPE& lhs, const TYPE& rhs))
+Util::Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::SortWithFunc(bool (*func)(const TYPE& lhs, const TYPE& rhs))
 {
     std::sort(this->Begin(), this->End(), func);
 }
@@ -1464,9 +1479,9 @@ Util::Array<TYPE, SMALL_VECTOR_SIZE>::SortWithFunc(bool (*func)(const TYPE& lhs,
 //------------------------------------------------------------------------------
 /**
 */
-template <class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::QuickSortWithFunc(int (*func)(const void* lhs, const void* rhs))
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::QuickSortWithFunc(int (*func)(const void* lhs, const void* rhs))
 {
     std::qsort(
         this->Begin(),
@@ -1481,9 +1496,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::QuickSortWithFunc(int (*func)(const void* lhs, c
     Does a binary search on the array, returns the index of the identical
     element, or InvalidIndex if not found
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 IndexT
-Array<TYPE, SMALL_VECTOR_SIZE>::BinarySearchIndex(const TYPE& elm) const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::BinarySearchIndex(const TYPE& elm) const
 {
     SizeT num = this->Size();
     if (num > 0)
@@ -1541,9 +1556,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::BinarySearchIndex(const TYPE& elm) const
     by using typename to put the template type in a non-deducable context.
     The enable_if does nothing except allow us to use typename.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 template<typename KEYTYPE> inline IndexT 
-Array<TYPE, SMALL_VECTOR_SIZE>::BinarySearchIndex(typename std::enable_if<true, const KEYTYPE&>::type elm) const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::BinarySearchIndex(typename std::enable_if<true, const KEYTYPE&>::type elm) const
 {
     SizeT num = this->Size();
     if (num > 0)
@@ -1595,9 +1610,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::BinarySearchIndex(typename std::enable_if<true,
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::Resize(SizeT num)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Resize(SizeT num)
 {
     if (num < this->count)
     {
@@ -1614,9 +1629,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Resize(SizeT num)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::clear() noexcept
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::clear() noexcept
 {
     this->Clear();
 }
@@ -1624,16 +1639,16 @@ Array<TYPE, SMALL_VECTOR_SIZE>::clear() noexcept
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE>
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR>
 inline void 
-Array<TYPE, SMALL_VECTOR_SIZE>::Fit()
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Fit()
 {
-    TYPE* newArray = ArrayAlloc<TYPE>(this->count);
+    TYPE* newArray = ArrayAlloc<TYPE, ALLOCATOR>(this->count);
     if (this->elements)
     {
         this->MoveRange(newArray, this->elements, this->count);
         if (this->elements != this->stackElements.data())
-            ArrayFree(this->capacity, this->elements);
+            ArrayFree<TYPE, ALLOCATOR>(this->capacity, this->elements);
     }
     this->elements = newArray;
 
@@ -1643,9 +1658,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::Fit()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 inline constexpr SizeT 
-Array<TYPE, SMALL_VECTOR_SIZE>::TypeSize() const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::TypeSize() const
 {
     return sizeof(TYPE);
 }
@@ -1653,9 +1668,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::TypeSize() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 size_t
-Array<TYPE, SMALL_VECTOR_SIZE>::size() const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::size() const
 {
     return this->count;
 }
@@ -1664,9 +1679,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::size() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-typename Array<TYPE, SMALL_VECTOR_SIZE>::Iterator
-Array<TYPE, SMALL_VECTOR_SIZE>::begin() const
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Iterator
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::begin() const
 {
     return this->elements;
 }
@@ -1674,9 +1689,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::begin() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
-typename Array<TYPE, SMALL_VECTOR_SIZE>::Iterator
-Array<TYPE, SMALL_VECTOR_SIZE>::end() const
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
+typename Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::Iterator
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::end() const
 {
     return this->elements + this->count;
 }
@@ -1684,9 +1699,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::end() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 void
-Array<TYPE, SMALL_VECTOR_SIZE>::resize(size_t s)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::resize(size_t s)
 {
     if (static_cast<SizeT>(s) > this->capacity)
     {
@@ -1701,9 +1716,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::resize(size_t s)
     This tests, whether the array is sorted. This is a slow operation
     O(n).
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 bool
-Array<TYPE, SMALL_VECTOR_SIZE>::IsSorted() const
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::IsSorted() const
 {
     if (this->count > 1)
     {
@@ -1725,9 +1740,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::IsSorted() const
     starting at a given index. Performance is O(n). Returns the index
     at which the element was added.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 IndexT
-Array<TYPE, SMALL_VECTOR_SIZE>::InsertAtEndOfIdenticalRange(IndexT startIndex, const TYPE& elm)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::InsertAtEndOfIdenticalRange(IndexT startIndex, const TYPE& elm)
 {
     IndexT i = startIndex + 1;
     for (; i < this->count; i++)
@@ -1749,9 +1764,9 @@ Array<TYPE, SMALL_VECTOR_SIZE>::InsertAtEndOfIdenticalRange(IndexT startIndex, c
     This inserts the element into a sorted array. Returns the index
     at which the element was inserted.
 */
-template<class TYPE, int SMALL_VECTOR_SIZE> 
+template<class TYPE, int SMALL_VECTOR_SIZE, class ALLOCATOR> 
 IndexT
-Array<TYPE, SMALL_VECTOR_SIZE>::InsertSorted(const TYPE& elm)
+Array<TYPE, SMALL_VECTOR_SIZE, ALLOCATOR>::InsertSorted(const TYPE& elm)
 {
     SizeT num = this->Size();
     if (num == 0)
@@ -1839,5 +1854,8 @@ Array<TYPE, SMALL_VECTOR_SIZE>::InsertSorted(const TYPE& elm)
 template<class TYPE, int STACK_SIZE>
 using StackArray = Array<TYPE, STACK_SIZE>;
 
+template<class TYPE, class ALLOCATOR>
+using AllocArray = Array<TYPE, 0, ALLOCATOR>;
+
 } // namespace Util
 //------------------------------------------------------------------------------
@@ -13,8 +13,15 @@
     There are two versions of this type, an unsafe and a safe one. Both are implemented
     in the same way.
 
-    The thread safe allocator requires the Get-methods to be within an Enter/Leave
-    lockstep phase. 
+    Writing to an element requires the calling thread to own it, either because it
+    allocated it or because it acquired it with Acquire() or an AllocatorLock. Reading
+    an element nobody owns is always allowed.
+
+    All storage is pinned, so elements never move when the allocator grows, and reads
+    of an element are wait-free even while other threads allocate. Ids carry a generation
+    in the bits above the index, which is bumped when an element is freed, so stale ids
+    are caught with a plain load instead of a lock. The 24 bits of an id are split between
+    index and generation depending on MAX_ALLOCS, which leaves at least 8 generation bits.
 
     @see    arrayallocator.h
 
@@ -26,6 +33,7 @@
 #include "util/pinnedarray.h"
 #include "threading/readwritelock.h"
 #include "threading/spinlock.h"
+#include "threading/interlocked.h"
 #include <tuple>
 #include "tupleutility.h"
 #include "ids/id.h"
@@ -64,6 +72,15 @@ template <uint MAX_ALLOCS = 0xFFFF, class ... TYPES>
 class ArrayAllocatorSafe
 {
 public:
+    static_assert(MAX_ALLOCS <= 0xFFFF, "ArrayAllocatorSafe needs at least 8 bits of the id for the generation");
+
+    /// number of bits of an id holding the index
+    static constexpr uint IndexBits = MAX_ALLOCS <= 0xFF ? 8 : (MAX_ALLOCS <= 0xFFF ? 12 : 16);
+    /// number of bits of an id holding the generation
+    static constexpr uint GenerationBits = 24 - IndexBits;
+    static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+    static constexpr uint32_t GenerationMask = (1u << GenerationBits) - 1;
+
     /// constructor
     ArrayAllocatorSafe();
 
@@ -93,19 +110,19 @@ public:
 
     /// get single item from resource
     template <int MEMBER>
-    tuple_array_t<MEMBER, TYPES...>& Get(const uint32_t index);
+    tuple_array_t<MEMBER, TYPES...>& Get(const uint32_t id);
 
     /// Get const explicitly
     template <int MEMBER>
-    const tuple_array_t<MEMBER, TYPES...>& ConstGet(const uint32_t index) const;
+    const tuple_array_t<MEMBER, TYPES...>& ConstGet(const uint32_t id) const;
 
     /// same as 32 bit get, but const
     template <int MEMBER>
-    const tuple_array_t<MEMBER, TYPES...>& Get(const uint32_t index) const;
+    const tuple_array_t<MEMBER, TYPES...>& Get(const uint32_t id) const;
 
     /// set single item
     template <int MEMBER>
-    void Set(const uint32_t index, const tuple_array_t<MEMBER, TYPES...>& type);
+    void Set(const uint32_t id, const tuple_array_t<MEMBER, TYPES...>& type);
 
     /// get array const reference
     template <int MEMBER>
@@ -116,7 +133,7 @@ public:
     Util::Array<tuple_array_t<MEMBER, TYPES...>>& GetArray();
 
     /// set for each in tuple
-    void Set(const uint32_t index, TYPES...);
+    void Set(const uint32_t id, TYPES...);
 
     /// get number of used indices
     const uint32_t Size() const;
@@ -132,17 +149,33 @@ public:
     void UpdateSize();
 
     /// Spinlock to acquire 
-    void TryAcquire(const uint32_t index);
+    void TryAcquire(const uint32_t id);
     /// Acquire element, asserts if false and returns true if this call acquired
-    bool Acquire(const uint32_t index);
+    bool Acquire(const uint32_t id);
     /// Release an object, the next thread that acquires may use this instance as it fits
-    void Release(const uint32_t index);
+    void Release(const uint32_t id);
+
+    /// returns true if the id refers to an element which hasn't been freed since, does not lock
+    bool IsValid(const uint32_t id) const;
+    /// get the element index of an id
+    static uint32_t IdIndex(const uint32_t id);
+    /// get the generation of an id
+    static uint32_t IdGeneration(const uint32_t id);
 
 protected:
+    /// get the element index of an id, and assert that the id isn't stale
+    uint32_t Index(const uint32_t id) const;
+    /// make an id from an element index and its current generation
+    uint32_t MakeId(const uint32_t index) const;
+    /// add an element owned by the calling thread and return its index, the allocation lock has to be held
+    uint32_t Grow();
+    /// invalidate all ids of an element and release it, asserts if the id is already stale
+    void BumpGeneration(const uint32_t id);
      
     uint32_t size;
     std::tuple<Util::PinnedArray<MAX_ALLOCS, TYPES>...> objects;
-    Util::Array<Threading::ThreadId> owners;
+    Util::PinnedArray<MAX_ALLOCS, Threading::ThreadIdStorage> owners;
+    Util::PinnedArray<MAX_ALLOCS, int> generations;
 
     Threading::Spinlock allocationLock;
 };
@@ -168,6 +201,8 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::ArrayAllocatorSafe(ArrayAllocatorSafe<
     this->allocationLock.Lock();
     rhs.allocationLock.Lock();
     this->objects = rhs.objects;
+    this->owners = rhs.owners;
+    this->generations = rhs.generations;
     this->size = rhs.size;
     rhs.Clear();
 
@@ -184,6 +219,8 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::ArrayAllocatorSafe(const ArrayAllocato
 {
     this->allocationLock.Lock();
     this->objects = rhs.objects;
+    this->owners = rhs.owners;
+    this->generations = rhs.generations;
     this->size = rhs.size;
     this->allocationLock.Unlock();
 }
@@ -207,6 +244,8 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::operator=(const ArrayAllocatorSafe<MAX
 {
     this->allocationLock.Lock();
     this->objects = rhs.objects;
+    this->owners = rhs.owners;
+    this->generations = rhs.generations;
     this->size = rhs.size;
     this->allocationLock.Unlock();
 }
@@ -221,6 +260,8 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::operator=(ArrayAllocatorSafe<MAX_ALLOC
     this->allocationLock.Lock();
     rhs.allocationLock.Lock();
     this->objects = rhs.objects;
+    this->owners = rhs.owners;
+    this->generations = rhs.generations;
     this->size = rhs.size;
     rhs.Clear();
 
@@ -237,11 +278,9 @@ inline uint32_t
 ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Alloc()
 {
     this->allocationLock.Lock();
-    alloc_for_each_in_tuple(this->objects);
-    auto i = this->size++;
-    this->owners.Append(Threading::Thread::GetMyThreadId());
+    uint32_t i = this->Grow();
     this->allocationLock.Unlock();
-    return i;
+    return this->MakeId(i);
 }
 
 //------------------------------------------------------------------------------
@@ -254,6 +293,8 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::EraseIndex(const uint32_t id)
     n_assert(this->owners[id] == Threading::Thread::GetMyThreadId());
     this->allocationLock.Lock();
     erase_index_for_each_in_tuple(this->objects, id);
+    this->owners.EraseIndex(id);
+    this->generations.EraseIndex(id);
     this->allocationLock.Unlock();
     this->size--;
 }
@@ -268,6 +309,8 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::EraseIndexSwap(const uint32_t id)
     n_assert(this->owners[id] == Threading::Thread::GetMyThreadId());
     this->allocationLock.Lock();
     erase_index_swap_for_each_in_tuple(this->objects, id);
+    this->owners.EraseIndexSwap(id);
+    this->generations.EraseIndexSwap(id);
     this->allocationLock.Unlock();
     this->size--;
 }
@@ -279,7 +322,6 @@ template<uint MAX_ALLOCS, class ...TYPES>
 inline const uint32_t
 ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Size() const
 {
-    n_assert2(this->numReaders > 0, "Size requires a read lock");
     return this->size;
 }
 
@@ -292,6 +334,8 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Reserve(uint32_t num)
 {
     this->allocationLock.Lock();
     reserve_for_each_in_tuple(this->objects, num);
+    this->owners.Reserve(num);
+    this->generations.Reserve(num);
     this->allocationLock.Unlock();
     // Size is still the same.
 }
@@ -303,10 +347,12 @@ template<uint MAX_ALLOCS, class ...TYPES>
 inline void
 ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Clear()
 {
-    this->allocationLock.Enter();
+    this->allocationLock.Lock();
     clear_for_each_in_tuple(this->objects);
+    this->owners.Clear();
+    this->generations.Clear();
     this->size = 0;
-    this->allocationLock.Leave();
+    this->allocationLock.Unlock();
 }
 
 //------------------------------------------------------------------------------
@@ -315,8 +361,9 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Clear()
 template<uint MAX_ALLOCS, class ...TYPES>
 template<int MEMBER>
 inline tuple_array_t<MEMBER, TYPES...>&
-ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Get(const uint32_t index)
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Get(const uint32_t id)
 {
+    const uint32_t index = this->Index(id);
     n_assert(this->owners[index] == Threading::Thread::GetMyThreadId());
     return std::get<MEMBER>(this->objects)[index];
 }
@@ -327,9 +374,10 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Get(const uint32_t index)
 template<uint MAX_ALLOCS, class ...TYPES>
 template<int MEMBER>
 inline const tuple_array_t<MEMBER, TYPES...>&
-ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::ConstGet(const uint32_t index) const
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::ConstGet(const uint32_t id) const
 {
     // Allow const get when no thread is owning the element as well
+    const uint32_t index = this->Index(id);
     n_assert(this->owners[index] == Threading::Thread::GetMyThreadId() || this->owners[index] == Threading::InvalidThreadId);
     return std::get<MEMBER>(this->objects)[index];
 }
@@ -340,9 +388,10 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::ConstGet(const uint32_t index) const
 template<uint MAX_ALLOCS, class ...TYPES>
 template<int MEMBER>
 inline const tuple_array_t<MEMBER, TYPES...>&
-ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Get(const uint32_t index) const
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Get(const uint32_t id) const
 {
     // Allow const get when no thread is owning the element as well
+    const uint32_t index = this->Index(id);
     n_assert(this->owners[index] == Threading::Thread::GetMyThreadId() || this->owners[index] == Threading::InvalidThreadId);
     return std::get<MEMBER>(this->objects)[index];
 }
@@ -353,8 +402,9 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Get(const uint32_t index) const
 template<uint MAX_ALLOCS, class ...TYPES>
 template<int MEMBER>
 inline void 
-ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Set(const uint32_t index, const tuple_array_t<MEMBER, TYPES...>& type)
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Set(const uint32_t id, const tuple_array_t<MEMBER, TYPES...>& type)
 {
+    const uint32_t index = this->Index(id);
     n_assert(this->owners[index] == Threading::Thread::GetMyThreadId());
     std::get<MEMBER>(this->objects)[index] = type;
 }
@@ -386,8 +436,9 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::GetArray()
 */
 template<uint MAX_ALLOCS, class ...TYPES> 
 void
-ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Set(const uint32_t index, TYPES... values)
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Set(const uint32_t id, TYPES... values)
 {
+    const uint32_t index = this->Index(id);
     set_for_each_in_tuple(this->objects, index, values...);
 }
 
@@ -406,8 +457,9 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::UpdateSize()
 */
 template<uint MAX_ALLOCS, class ...TYPES>
 void 
-ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::TryAcquire(const uint32_t index)
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::TryAcquire(const uint32_t id)
 {
+    const uint32_t index = this->Index(id);
     Threading::ThreadId myThread = Threading::Thread::GetMyThreadId();
     Threading::ThreadId currentThread = Threading::Interlocked::CompareExchange((volatile Threading::ThreadIdStorage*)&this->owners[index], myThread, Threading::InvalidThreadId);
     n_assert(currentThread == Threading::InvalidThreadId);
@@ -418,8 +470,9 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::TryAcquire(const uint32_t index)
 */
 template<uint MAX_ALLOCS, class ...TYPES>
 bool 
-ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Acquire(const uint32_t index)
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Acquire(const uint32_t id)
 {
+    const uint32_t index = this->Index(id);
     Threading::ThreadId myThread = Threading::Thread::GetMyThreadId();
     if (this->owners[index] == myThread)
         return false;
@@ -434,13 +487,114 @@ ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Acquire(const uint32_t index)
 
 //------------------------------------------------------------------------------
 /**
+    Releasing an element which has been freed while it was acquired, for
+    instance from an AllocatorLock going out of scope, does nothing, the
+    element has already been released when it was freed.
 */
 template<uint MAX_ALLOCS, class ...TYPES>
 void 
-ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Release(const uint32_t index)
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Release(const uint32_t id)
 {
+    if (!this->IsValid(id))
+        return;
+    const uint32_t index = IdIndex(id);
     n_assert(this->owners[index] == Threading::Thread::GetMyThreadId());
     Threading::Interlocked::Exchange((volatile Threading::ThreadIdStorage*)&this->owners[index], Threading::InvalidThreadId);
 }
 
+//------------------------------------------------------------------------------
+/**
+    Elements are never moved or unmapped, so this is safe to call with any id
+    from any thread, though the element may of course be freed right after.
+*/
+template<uint MAX_ALLOCS, class ...TYPES>
+inline bool
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::IsValid(const uint32_t id) const
+{
+    const uint32_t index = IdIndex(id);
+    if (index >= (uint32_t)this->generations.Size())
+        return false;
+    return (uint32_t)*(volatile const int*)&this->generations[index] == IdGeneration(id);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<uint MAX_ALLOCS, class ...TYPES>
+inline uint32_t
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::IdIndex(const uint32_t id)
+{
+    return id & IndexMask;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<uint MAX_ALLOCS, class ...TYPES>
+inline uint32_t
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::IdGeneration(const uint32_t id)
+{
+    return (id >> IndexBits) & GenerationMask;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<uint MAX_ALLOCS, class ...TYPES>
+inline uint32_t
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Index(const uint32_t id) const
+{
+    n_assert2(this->IsValid(id), "Id is stale, the element it refers to has been freed");
+    return IdIndex(id);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<uint MAX_ALLOCS, class ...TYPES>
+inline uint32_t
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::MakeId(const uint32_t index) const
+{
+    return ((uint32_t)this->generations[index] << IndexBits) | index;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Appending to pinned arrays only commits more of their reserved memory, so
+    threads reading other elements meanwhile are fine.
+*/
+template<uint MAX_ALLOCS, class ...TYPES>
+inline uint32_t
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::Grow()
+{
+    const uint32_t index = this->size;
+    n_assert2(MAX_ALLOCS > index, "max amount of allocations exceeded!\n");
+    alloc_for_each_in_tuple(this->objects);
+    this->owners.Append(Threading::Thread::GetMyThreadId());
+    this->generations.Append(0);
+    this->size++;
+    return index;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The generation is swapped in with a compare and exchange, so two threads
+    freeing the same element can't both succeed. Only then is the owner
+    cleared, since the old owner can't release it anymore with a stale id. The generation which would
+    turn the id into InvalidId24 is skipped.
+*/
+template<uint MAX_ALLOCS, class ...TYPES>
+inline void
+ArrayAllocatorSafe<MAX_ALLOCS, TYPES...>::BumpGeneration(const uint32_t id)
+{
+    const uint32_t index = IdIndex(id);
+    const int generation = (int)IdGeneration(id);
+    int next = (int)((generation + 1) & GenerationMask);
+    if ((((uint32_t)next << IndexBits) | index) == Ids::InvalidId24)
+        next = 0;
+    const int previous = Threading::Interlocked::CompareExchange((volatile int*)&this->generations[index], next, generation);
+    n_assert2(previous == generation, "Id is stale, the element it refers to has already been freed");
+    Threading::Interlocked::Exchange((volatile Threading::ThreadIdStorage*)&this->owners[index], Threading::InvalidThreadId);
+}
+
 } // namespace Util
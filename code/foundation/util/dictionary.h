@@ -20,6 +20,9 @@
     Any methods which require the internal array to be sorted will
     throw an assertion between BeginBulkAdd() and EndBulkAdd().
 
+    The key/value pairs are allocated through the ALLOCATOR policy, see
+    Util::Array.
+
     @copyright
     (C) 2006 Radon Labs GmbH
     (C) 2013-2020 Individual contributors, see AUTHORS file 
@@ -30,19 +33,19 @@
 //------------------------------------------------------------------------------
 namespace Util
 {
-template<class KEYTYPE, class VALUETYPE> class Dictionary
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR = Memory::ObjectArrayHeapAllocator> class Dictionary
 {
 public:
     /// default constructor
     Dictionary();
     /// copy constructor
-    Dictionary(const Dictionary<KEYTYPE, VALUETYPE>& rhs);
+    Dictionary(const Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>& rhs);
     /// move constructor
-    Dictionary(Dictionary<KEYTYPE, VALUETYPE>&& rhs) noexcept;
+    Dictionary(Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>&& rhs) noexcept;
     /// assignment operator
-    void operator=(const Dictionary<KEYTYPE, VALUETYPE>& rhs);
+    void operator=(const Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>& rhs);
     /// move operator
-    void operator=(Dictionary<KEYTYPE, VALUETYPE>&& rhs) noexcept;
+    void operator=(Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>&& rhs) noexcept;
     /// read/write [] operator
     VALUETYPE& operator[](const KEYTYPE& key);
     /// read-only [] operator
@@ -66,7 +69,7 @@ public:
     /// end a bulk insert (this will sort the internal array)
     void EndBulkAdd();
     /// merge two dictionaries
-    void Merge(const Dictionary<KEYTYPE, VALUETYPE>& rhs);
+    void Merge(const Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>& rhs);
     /// erase a key and its associated value
     void Erase(const KEYTYPE& key);
     /// erase a key at index
@@ -104,15 +107,15 @@ protected:
     /// make sure the key value pair array is sorted
     void SortIfDirty() const;
 
-    Array<KeyValuePair<KEYTYPE, VALUETYPE> > keyValuePairs;
+    Array<KeyValuePair<KEYTYPE, VALUETYPE>, 0, ALLOCATOR> keyValuePairs;
     bool inBulkInsert;
 };
 
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
-Dictionary<KEYTYPE, VALUETYPE>::Dictionary() :
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Dictionary() :
     inBulkInsert(false)
 {
     // empty
@@ -121,8 +124,8 @@ Dictionary<KEYTYPE, VALUETYPE>::Dictionary() :
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
-Dictionary<KEYTYPE, VALUETYPE>::Dictionary(const Dictionary<KEYTYPE, VALUETYPE>& rhs) :
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Dictionary(const Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>& rhs) :
     keyValuePairs(rhs.keyValuePairs),
     inBulkInsert(false)
 {
@@ -134,8 +137,8 @@ Dictionary<KEYTYPE, VALUETYPE>::Dictionary(const Dictionary<KEYTYPE, VALUETYPE>&
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
-Dictionary<KEYTYPE, VALUETYPE>::Dictionary(Dictionary<KEYTYPE, VALUETYPE>&& rhs) noexcept :
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Dictionary(Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>&& rhs) noexcept :
     keyValuePairs(std::move(rhs.keyValuePairs)),
     inBulkInsert(false)
 {
@@ -147,9 +150,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Dictionary(Dictionary<KEYTYPE, VALUETYPE>&& rhs)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::operator=(const Dictionary<KEYTYPE, VALUETYPE>& rhs)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::operator=(const Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>& rhs)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -161,9 +164,9 @@ Dictionary<KEYTYPE, VALUETYPE>::operator=(const Dictionary<KEYTYPE, VALUETYPE>&
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::operator=(Dictionary<KEYTYPE, VALUETYPE>&& rhs) noexcept
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::operator=(Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>&& rhs) noexcept
 {
 #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -175,9 +178,9 @@ Dictionary<KEYTYPE, VALUETYPE>::operator=(Dictionary<KEYTYPE, VALUETYPE>&& rhs)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::Clear()
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Clear()
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -188,9 +191,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Clear()
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline SizeT
-Dictionary<KEYTYPE, VALUETYPE>::Size() const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Size() const
 {
     return this->keyValuePairs.Size();
 }
@@ -198,9 +201,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Size() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE> 
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR> 
 inline bool
-Dictionary<KEYTYPE, VALUETYPE>::IsEmpty() const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::IsEmpty() const
 {
     return (0 == this->keyValuePairs.Size());
 }
@@ -208,9 +211,9 @@ Dictionary<KEYTYPE, VALUETYPE>::IsEmpty() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::Reserve(SizeT numElements)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Reserve(SizeT numElements)
 {
     this->keyValuePairs.Reserve(numElements);
 }
@@ -218,9 +221,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Reserve(SizeT numElements)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::BeginBulkAdd()
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::BeginBulkAdd()
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -231,9 +234,9 @@ Dictionary<KEYTYPE, VALUETYPE>::BeginBulkAdd()
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::EndBulkAdd()
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::EndBulkAdd()
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->inBulkInsert);
@@ -245,9 +248,9 @@ Dictionary<KEYTYPE, VALUETYPE>::EndBulkAdd()
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::Merge(const Dictionary<KEYTYPE, VALUETYPE>& rhs)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Merge(const Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>& rhs)
 {
     this->BeginBulkAdd();
     IndexT i;
@@ -262,9 +265,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Merge(const Dictionary<KEYTYPE, VALUETYPE>& rhs)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline IndexT
-Dictionary<KEYTYPE, VALUETYPE>::Add(const KeyValuePair<KEYTYPE, VALUETYPE>& kvp)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Add(const KeyValuePair<KEYTYPE, VALUETYPE>& kvp)
 {
     if (this->inBulkInsert)
     {
@@ -280,9 +283,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Add(const KeyValuePair<KEYTYPE, VALUETYPE>& kvp)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline IndexT
-Dictionary<KEYTYPE, VALUETYPE>::Add(const KEYTYPE& key, const VALUETYPE& value)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Add(const KEYTYPE& key, const VALUETYPE& value)
 {
     //n_assert(!this->Contains(key));
     KeyValuePair<KEYTYPE, VALUETYPE> kvp(key, value);
@@ -300,9 +303,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Add(const KEYTYPE& key, const VALUETYPE& value)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline VALUETYPE&
-Dictionary<KEYTYPE, VALUETYPE>::Emplace(const KEYTYPE& key)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Emplace(const KEYTYPE& key)
 {
     IndexT i = this->FindIndex(key);
     if (i == InvalidIndex)
@@ -318,9 +321,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Emplace(const KEYTYPE& key)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::Erase(const KEYTYPE& key)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Erase(const KEYTYPE& key)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -335,9 +338,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Erase(const KEYTYPE& key)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::EraseAtIndex(IndexT index)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::EraseAtIndex(IndexT index)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -348,9 +351,9 @@ Dictionary<KEYTYPE, VALUETYPE>::EraseAtIndex(IndexT index)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE> 
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR> 
 inline IndexT
-Dictionary<KEYTYPE, VALUETYPE>::FindIndex(const KEYTYPE& key) const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::FindIndex(const KEYTYPE& key) const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -361,9 +364,9 @@ Dictionary<KEYTYPE, VALUETYPE>::FindIndex(const KEYTYPE& key) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline bool
-Dictionary<KEYTYPE, VALUETYPE>::Contains(const KEYTYPE& key) const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Contains(const KEYTYPE& key) const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -374,9 +377,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Contains(const KEYTYPE& key) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline bool
-Dictionary<KEYTYPE, VALUETYPE>::Contains(const KEYTYPE& key, IndexT& index) const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::Contains(const KEYTYPE& key, IndexT& index) const
 {
 #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -388,9 +391,9 @@ Dictionary<KEYTYPE, VALUETYPE>::Contains(const KEYTYPE& key, IndexT& index) cons
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE> 
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR> 
 inline const KEYTYPE&
-Dictionary<KEYTYPE, VALUETYPE>::KeyAtIndex(IndexT index) const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::KeyAtIndex(IndexT index) const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -401,9 +404,9 @@ Dictionary<KEYTYPE, VALUETYPE>::KeyAtIndex(IndexT index) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE> 
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR> 
 inline VALUETYPE&
-Dictionary<KEYTYPE, VALUETYPE>::ValueAtIndex(IndexT index)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::ValueAtIndex(IndexT index)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -414,9 +417,9 @@ Dictionary<KEYTYPE, VALUETYPE>::ValueAtIndex(IndexT index)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE> 
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR> 
 inline const VALUETYPE&
-Dictionary<KEYTYPE, VALUETYPE>::ValueAtIndex(IndexT index) const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::ValueAtIndex(IndexT index) const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -427,9 +430,9 @@ Dictionary<KEYTYPE, VALUETYPE>::ValueAtIndex(IndexT index) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE> 
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR> 
 inline KeyValuePair<KEYTYPE, VALUETYPE>&
-Dictionary<KEYTYPE, VALUETYPE>::KeyValuePairAtIndex(IndexT index) const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::KeyValuePairAtIndex(IndexT index) const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -440,9 +443,9 @@ Dictionary<KEYTYPE, VALUETYPE>::KeyValuePairAtIndex(IndexT index) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE> 
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR> 
 inline VALUETYPE&
-Dictionary<KEYTYPE, VALUETYPE>::operator[](const KEYTYPE& key)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::operator[](const KEYTYPE& key)
 {
     int keyValuePairIndex = this->FindIndex(key);
     #if NEBULA_BOUNDSCHECKS
@@ -454,9 +457,9 @@ Dictionary<KEYTYPE, VALUETYPE>::operator[](const KEYTYPE& key)
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE> 
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR> 
 inline const VALUETYPE&
-Dictionary<KEYTYPE, VALUETYPE>::operator[](const KEYTYPE& key) const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::operator[](const KEYTYPE& key) const
 {
     int keyValuePairIndex = this->FindIndex(key);
     #if NEBULA_BOUNDSCHECKS
@@ -468,10 +471,10 @@ Dictionary<KEYTYPE, VALUETYPE>::operator[](const KEYTYPE& key) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 template<class RETURNTYPE>
 RETURNTYPE
-Dictionary<KEYTYPE, VALUETYPE>::ValuesAs() const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::ValuesAs() const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(!this->inBulkInsert);
@@ -488,9 +491,9 @@ Dictionary<KEYTYPE, VALUETYPE>::ValuesAs() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline Array<VALUETYPE>
-Dictionary<KEYTYPE, VALUETYPE>::ValuesAsArray() const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::ValuesAsArray() const
 {
     return this->ValuesAs<Array<VALUETYPE> >();
 }
@@ -498,10 +501,10 @@ Dictionary<KEYTYPE, VALUETYPE>::ValuesAsArray() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE> 
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR> 
 template<class RETURNTYPE>
 inline RETURNTYPE
-Dictionary<KEYTYPE, VALUETYPE>::KeysAs() const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::KeysAs() const
 {
     #if NEBULA_BOUNDSCHECKS    
     n_assert(!this->inBulkInsert);
@@ -518,9 +521,9 @@ Dictionary<KEYTYPE, VALUETYPE>::KeysAs() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline Array<KEYTYPE>
-Dictionary<KEYTYPE, VALUETYPE>::KeysAsArray() const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::KeysAsArray() const
 {
     return this->KeysAs<Array<KEYTYPE> >();
 }
@@ -528,36 +531,36 @@ Dictionary<KEYTYPE, VALUETYPE>::KeysAsArray() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline KeyValuePair<KEYTYPE, VALUETYPE>*
-Dictionary<KEYTYPE, VALUETYPE>::begin() const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::begin() const
 {
     return this->keyValuePairs.begin();
 }
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline KeyValuePair<KEYTYPE, VALUETYPE>*
-Dictionary<KEYTYPE, VALUETYPE>::end() const
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::end() const
 {
     return this->keyValuePairs.end();
 }
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::clear()
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::clear()
 {
     this->Clear();
 }
 //------------------------------------------------------------------------------
 /**
 */
-template<class KEYTYPE, class VALUETYPE>
+template<class KEYTYPE, class VALUETYPE, class ALLOCATOR>
 inline void
-Dictionary<KEYTYPE, VALUETYPE>::emplace(KEYTYPE&&key, VALUETYPE&&value)
+Dictionary<KEYTYPE, VALUETYPE, ALLOCATOR>::emplace(KEYTYPE&&key, VALUETYPE&&value)
 {
     this->Add(key, value);
 }
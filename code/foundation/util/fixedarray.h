@@ -4,6 +4,8 @@
     @class Util::FixedArray
     
     Implements a fixed size one-dimensional array.
+
+    The elements are allocated through the ALLOCATOR policy, see Util::Array.
     
     @copyright
     (C) 2006 Radon Labs GmbH
@@ -16,7 +18,7 @@
 //------------------------------------------------------------------------------
 namespace Util
 {
-template<class TYPE> class FixedArray
+template<class TYPE, class ALLOCATOR = Memory::ObjectArrayHeapAllocator> class FixedArray
 {
 public:
     /// define element iterator
@@ -29,11 +31,11 @@ public:
     /// constructor with size and initial value
     FixedArray(const SizeT s, const TYPE& initialValue);
     /// copy constructor
-    FixedArray(const FixedArray<TYPE>& rhs);
+    FixedArray(const FixedArray<TYPE, ALLOCATOR>& rhs);
     /// construct from array
     FixedArray(const Array<TYPE>& rhs);
     /// move constructor
-    FixedArray(FixedArray<TYPE>&& rhs);
+    FixedArray(FixedArray<TYPE, ALLOCATOR>&& rhs);
     /// constructor from initializer list
     FixedArray(std::initializer_list<TYPE> list);
     /// construct an empty fixed array
@@ -41,15 +43,15 @@ public:
     /// destructor
     ~FixedArray();
     /// assignment operator
-    void operator=(const FixedArray<TYPE>& rhs);
+    void operator=(const FixedArray<TYPE, ALLOCATOR>& rhs);
     /// move assignment operator
-    void operator=(FixedArray<TYPE>&& rhs) noexcept;
+    void operator=(FixedArray<TYPE, ALLOCATOR>&& rhs) noexcept;
     /// write [] operator
     TYPE& operator[](IndexT index) const;
     /// equality operator
-    bool operator==(const FixedArray<TYPE>& rhs) const;
+    bool operator==(const FixedArray<TYPE, ALLOCATOR>& rhs) const;
     /// inequality operator
-    bool operator!=(const FixedArray<TYPE>& rhs) const;
+    bool operator!=(const FixedArray<TYPE, ALLOCATOR>& rhs) const;
 
     /// set number of elements (clears existing content)
     void SetSize(SizeT s);
@@ -93,7 +95,7 @@ private:
     /// allocate array for given size
     void Alloc(SizeT s);
     /// copy content
-    void Copy(const FixedArray<TYPE>& src);
+    void Copy(const FixedArray<TYPE, ALLOCATOR>& src);
 
     SizeT count;
     TYPE* elements;
@@ -102,8 +104,8 @@ private:
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE>
-FixedArray<TYPE>::FixedArray() :
+template<class TYPE, class ALLOCATOR>
+FixedArray<TYPE, ALLOCATOR>::FixedArray() :
     count(0),
     elements(nullptr)
 {
@@ -113,12 +115,12 @@ FixedArray<TYPE>::FixedArray() :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::Delete()
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::Delete()
 {
     if (this->elements)
     {
-        delete[] this->elements;
+        ArrayFree<TYPE, ALLOCATOR>(this->count, this->elements);
         this->elements = nullptr;
     }
     this->count = 0;
@@ -127,15 +129,15 @@ FixedArray<TYPE>::Delete()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::Alloc(SizeT s)
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::Alloc(SizeT s)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(0 == this->elements) 
     #endif
     if (s > 0)
     {
-        this->elements = new TYPE[s];
+        this->elements = ArrayAlloc<TYPE, ALLOCATOR>(s);
     }
     this->count = s;
 }
@@ -144,8 +146,8 @@ FixedArray<TYPE>::Alloc(SizeT s)
 /**
     NOTE: only works on deleted array. This is intended.
 */
-template<class TYPE> void
-FixedArray<TYPE>::Copy(const FixedArray<TYPE>& rhs)
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::Copy(const FixedArray<TYPE, ALLOCATOR>& rhs)
 {
     if (this != &rhs && rhs.count > 0)
     {
@@ -166,8 +168,8 @@ FixedArray<TYPE>::Copy(const FixedArray<TYPE>& rhs)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE>
-FixedArray<TYPE>::FixedArray(const SizeT s) :
+template<class TYPE, class ALLOCATOR>
+FixedArray<TYPE, ALLOCATOR>::FixedArray(const SizeT s) :
     count(0),
     elements(nullptr)
 {
@@ -177,8 +179,8 @@ FixedArray<TYPE>::FixedArray(const SizeT s) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE>
-FixedArray<TYPE>::FixedArray(const SizeT s, const TYPE& initialValue) :
+template<class TYPE, class ALLOCATOR>
+FixedArray<TYPE, ALLOCATOR>::FixedArray(const SizeT s, const TYPE& initialValue) :
     count(0),
     elements(nullptr)
 {
@@ -189,8 +191,8 @@ FixedArray<TYPE>::FixedArray(const SizeT s, const TYPE& initialValue) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE>
-FixedArray<TYPE>::FixedArray(const FixedArray<TYPE>& rhs) :
+template<class TYPE, class ALLOCATOR>
+FixedArray<TYPE, ALLOCATOR>::FixedArray(const FixedArray<TYPE, ALLOCATOR>& rhs) :
     count(0),
     elements(nullptr)
 {
@@ -200,8 +202,8 @@ FixedArray<TYPE>::FixedArray(const FixedArray<TYPE>& rhs) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE>
-FixedArray<TYPE>::FixedArray(const Array<TYPE>& rhs) :
+template<class TYPE, class ALLOCATOR>
+FixedArray<TYPE, ALLOCATOR>::FixedArray(const Array<TYPE>& rhs) :
     count(rhs.Size()),
     elements(nullptr)
 {
@@ -224,8 +226,8 @@ FixedArray<TYPE>::FixedArray(const Array<TYPE>& rhs) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE>
-FixedArray<TYPE>::FixedArray(FixedArray<TYPE>&& rhs) :
+template<class TYPE, class ALLOCATOR>
+FixedArray<TYPE, ALLOCATOR>::FixedArray(FixedArray<TYPE, ALLOCATOR>&& rhs) :
     count(rhs.count),
     elements(rhs.elements)
 {
@@ -236,8 +238,8 @@ FixedArray<TYPE>::FixedArray(FixedArray<TYPE>&& rhs) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE>
-FixedArray<TYPE>::FixedArray(std::initializer_list<TYPE> list) :
+template<class TYPE, class ALLOCATOR>
+FixedArray<TYPE, ALLOCATOR>::FixedArray(std::initializer_list<TYPE> list) :
     count(0),
     elements(nullptr)
 {
@@ -257,8 +259,8 @@ FixedArray<TYPE>::FixedArray(std::initializer_list<TYPE> list) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE>
-FixedArray<TYPE>::FixedArray(std::nullptr_t) :
+template<class TYPE, class ALLOCATOR>
+FixedArray<TYPE, ALLOCATOR>::FixedArray(std::nullptr_t) :
     count(0),
     elements(nullptr)
 {
@@ -267,8 +269,8 @@ FixedArray<TYPE>::FixedArray(std::nullptr_t) :
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE>
-FixedArray<TYPE>::~FixedArray()
+template<class TYPE, class ALLOCATOR>
+FixedArray<TYPE, ALLOCATOR>::~FixedArray()
 {
     this->Delete();
 }
@@ -276,8 +278,8 @@ FixedArray<TYPE>::~FixedArray()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::operator=(const FixedArray<TYPE>& rhs)
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::operator=(const FixedArray<TYPE, ALLOCATOR>& rhs)
 {
     if (this != &rhs)
     {
@@ -289,8 +291,8 @@ FixedArray<TYPE>::operator=(const FixedArray<TYPE>& rhs)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::operator=(FixedArray<TYPE>&& rhs) noexcept
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::operator=(FixedArray<TYPE, ALLOCATOR>&& rhs) noexcept
 {
     if (this != &rhs)
     {
@@ -305,8 +307,8 @@ FixedArray<TYPE>::operator=(FixedArray<TYPE>&& rhs) noexcept
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> TYPE&
-FixedArray<TYPE>::operator[](IndexT index) const
+template<class TYPE, class ALLOCATOR> TYPE&
+FixedArray<TYPE, ALLOCATOR>::operator[](IndexT index) const
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert(this->elements && (index < this->count));
@@ -317,8 +319,8 @@ FixedArray<TYPE>::operator[](IndexT index) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> bool
-FixedArray<TYPE>::operator==(const FixedArray<TYPE>& rhs) const
+template<class TYPE, class ALLOCATOR> bool
+FixedArray<TYPE, ALLOCATOR>::operator==(const FixedArray<TYPE, ALLOCATOR>& rhs) const
 {
     if (this->count != rhs.count)
     {
@@ -345,8 +347,8 @@ FixedArray<TYPE>::operator==(const FixedArray<TYPE>& rhs) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> bool
-FixedArray<TYPE>::operator!=(const FixedArray<TYPE>& rhs) const
+template<class TYPE, class ALLOCATOR> bool
+FixedArray<TYPE, ALLOCATOR>::operator!=(const FixedArray<TYPE, ALLOCATOR>& rhs) const
 {
     return !(*this == rhs);
 }
@@ -354,8 +356,8 @@ FixedArray<TYPE>::operator!=(const FixedArray<TYPE>& rhs) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::SetSize(SizeT s)
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::SetSize(SizeT s)
 {
     this->Delete();
     this->Alloc(s);
@@ -364,14 +366,25 @@ FixedArray<TYPE>::SetSize(SizeT s)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::Resize(SizeT newSize)
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::Resize(SizeT newSize)
 {
+    if constexpr (Memory::IsTriviallyRelocatable<TYPE>::value)
+    {
+        // resize in place if possible, realloc takes care of copying otherwise
+        if (this->elements && newSize > 0)
+        {
+            this->elements = ArrayRealloc<TYPE, ALLOCATOR>(this->count, newSize, this->elements);
+            this->count = newSize;
+            return;
+        }
+    }
+
     // allocate new array and copy over old elements
     TYPE* newElements = 0;
     if (newSize > 0)
     {
-        newElements = new TYPE[newSize];
+        newElements = ArrayAlloc<TYPE, ALLOCATOR>(newSize);
         SizeT numCopy = this->count;
         if (numCopy > 0)
         {
@@ -403,8 +416,8 @@ FixedArray<TYPE>::Resize(SizeT newSize)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> const SizeT
-FixedArray<TYPE>::Size() const
+template<class TYPE, class ALLOCATOR> const SizeT
+FixedArray<TYPE, ALLOCATOR>::Size() const
 {
     return this->count;
 }
@@ -412,8 +425,8 @@ FixedArray<TYPE>::Size() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> const SizeT
-FixedArray<TYPE>::ByteSize() const
+template<class TYPE, class ALLOCATOR> const SizeT
+FixedArray<TYPE, ALLOCATOR>::ByteSize() const
 {
     return this->count * sizeof(TYPE);
 }
@@ -421,8 +434,8 @@ FixedArray<TYPE>::ByteSize() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> bool
-FixedArray<TYPE>::IsEmpty() const
+template<class TYPE, class ALLOCATOR> bool
+FixedArray<TYPE, ALLOCATOR>::IsEmpty() const
 {
     return 0 == this->count;
 }
@@ -430,8 +443,8 @@ FixedArray<TYPE>::IsEmpty() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::Clear()
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::Clear()
 {
     this->Delete();
 }
@@ -439,8 +452,8 @@ FixedArray<TYPE>::Clear()
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::Fill(const TYPE& val)
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::Fill(const TYPE& val)
 {
     IndexT i;
     for (i = 0; i < this->count; i++)
@@ -452,8 +465,8 @@ FixedArray<TYPE>::Fill(const TYPE& val)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::Fill(IndexT first, SizeT num, const TYPE& val)
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::Fill(IndexT first, SizeT num, const TYPE& val)
 {
     #if NEBULA_BOUNDSCHECKS
     n_assert((first + num) <= this->count);
@@ -469,8 +482,8 @@ FixedArray<TYPE>::Fill(IndexT first, SizeT num, const TYPE& val)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> typename FixedArray<TYPE>::Iterator
-FixedArray<TYPE>::Begin() const
+template<class TYPE, class ALLOCATOR> typename FixedArray<TYPE, ALLOCATOR>::Iterator
+FixedArray<TYPE, ALLOCATOR>::Begin() const
 {
     return this->elements;
 }
@@ -478,8 +491,8 @@ FixedArray<TYPE>::Begin() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> typename FixedArray<TYPE>::Iterator
-FixedArray<TYPE>::End() const
+template<class TYPE, class ALLOCATOR> typename FixedArray<TYPE, ALLOCATOR>::Iterator
+FixedArray<TYPE, ALLOCATOR>::End() const
 {
     return this->elements + this->count;
 }
@@ -487,8 +500,8 @@ FixedArray<TYPE>::End() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> typename FixedArray<TYPE>::Iterator
-FixedArray<TYPE>::Find(const TYPE& elm) const
+template<class TYPE, class ALLOCATOR> typename FixedArray<TYPE, ALLOCATOR>::Iterator
+FixedArray<TYPE, ALLOCATOR>::Find(const TYPE& elm) const
 {
     IndexT i;
     for (i = 0; i < this->count; i++)
@@ -504,8 +517,8 @@ FixedArray<TYPE>::Find(const TYPE& elm) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> IndexT
-FixedArray<TYPE>::FindIndex(const TYPE& elm) const
+template<class TYPE, class ALLOCATOR> IndexT
+FixedArray<TYPE, ALLOCATOR>::FindIndex(const TYPE& elm) const
 {
     IndexT i;
     for (i = 0; i < this->count; i++)
@@ -521,8 +534,8 @@ FixedArray<TYPE>::FindIndex(const TYPE& elm) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::Sort()
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::Sort()
 {
     std::sort(this->Begin(), this->End());
 }
@@ -531,8 +544,8 @@ FixedArray<TYPE>::Sort()
 /**
     @todo hmm, this is copy-pasted from Array...
 */
-template<class TYPE> IndexT
-FixedArray<TYPE>::BinarySearchIndex(const TYPE& elm) const
+template<class TYPE, class ALLOCATOR> IndexT
+FixedArray<TYPE, ALLOCATOR>::BinarySearchIndex(const TYPE& elm) const
 {
     SizeT num = this->Size();
     if (num > 0)
@@ -584,8 +597,8 @@ FixedArray<TYPE>::BinarySearchIndex(const TYPE& elm) const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> Array<TYPE>
-FixedArray<TYPE>::AsArray() const
+template<class TYPE, class ALLOCATOR> Array<TYPE>
+FixedArray<TYPE, ALLOCATOR>::AsArray() const
 {
     Array<TYPE> result;
     result.Reserve(this->count);
@@ -600,8 +613,8 @@ FixedArray<TYPE>::AsArray() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> typename FixedArray<TYPE>::Iterator
-FixedArray<TYPE>::begin() const
+template<class TYPE, class ALLOCATOR> typename FixedArray<TYPE, ALLOCATOR>::Iterator
+FixedArray<TYPE, ALLOCATOR>::begin() const
 {
     return this->elements;
 }
@@ -609,8 +622,8 @@ FixedArray<TYPE>::begin() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> typename FixedArray<TYPE>::Iterator
-FixedArray<TYPE>::end() const
+template<class TYPE, class ALLOCATOR> typename FixedArray<TYPE, ALLOCATOR>::Iterator
+FixedArray<TYPE, ALLOCATOR>::end() const
 {
     return this->elements + this->count;
 }
@@ -618,8 +631,8 @@ FixedArray<TYPE>::end() const
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> void
-FixedArray<TYPE>::resize(size_t s)
+template<class TYPE, class ALLOCATOR> void
+FixedArray<TYPE, ALLOCATOR>::resize(size_t s)
 {
     if (s > this->capacity)
     {
@@ -631,8 +644,8 @@ FixedArray<TYPE>::resize(size_t s)
 //------------------------------------------------------------------------------
 /**
 */
-template<class TYPE> size_t
-FixedArray<TYPE>::size() const
+template<class TYPE, class ALLOCATOR> size_t
+FixedArray<TYPE, ALLOCATOR>::size() const
 {
     return this->count;
 }
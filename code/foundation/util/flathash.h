@@ -0,0 +1,876 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Util::FlatHashTable
+
+    Open addressing hash table core shared by Util::FlatHashMap and
+    Util::FlatHashSet.
+
+    Slots are stored in one flat array, next to an array with one control
+    byte per slot. A control byte is either Empty, Deleted, or holds the
+    lower 7 bits of the hash of the key in the slot. Lookups probe whole
+    groups of 16 control bytes at once (with SSE2 a single compare and
+    movemask), so keys are only compared for slots whose 7 hash bits
+    match, and a lookup stops at the first group with an empty slot.
+    The table grows by doubling once it is 7/8 full, and is rebuilt
+    at the same size if mostly tombstones filled it.
+
+    Hashes are computed by the HASHER functor, Util::FlatHash by default:
+    integral and enum keys hash their value, pointer keys hash their
+    address, and all other keys call their HashCode() method, so every
+    key type which works with Util::HashTable works here as well. Lookup
+    methods are templated on the key type, so a key can be looked up
+    by any type the hasher accepts and which compares equal with the key
+    type, for instance a Util::String key by a const char*.
+
+    Slot indices are stable until the next insertion, iterating visits the
+    slots in no particular order.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+#include "util/bit.h"
+#include "util/string.h"
+#include "util/keyvaluepair.h"
+#include "math/scalar.h"
+#include <type_traits>
+#include <new>
+#include <string.h>
+#if (defined(__SSE2__) || defined(_M_X64))
+#include <emmintrin.h>
+#define NEBULA_FLATHASH_SSE2 (1)
+#else
+#define NEBULA_FLATHASH_SSE2 (0)
+#endif
+
+//------------------------------------------------------------------------------
+namespace Util
+{
+
+//------------------------------------------------------------------------------
+/**
+    Default hasher, calls HashCode() on the key.
+*/
+template<class TYPE, class ENABLE = void>
+struct FlatHash
+{
+    uint32 operator()(const TYPE& key) const
+    {
+        return key.HashCode();
+    }
+};
+
+//------------------------------------------------------------------------------
+/**
+    Integral and enum keys hash their value.
+*/
+template<class TYPE>
+struct FlatHash<TYPE, typename std::enable_if<std::is_integral<TYPE>::value || std::is_enum<TYPE>::value>::type>
+{
+    uint32 operator()(TYPE key) const
+    {
+        uint64 value = (uint64)key;
+        return uint32(value ^ (value >> 32));
+    }
+};
+
+//------------------------------------------------------------------------------
+/**
+    Pointer keys hash their address, matching pointer equality.
+*/
+template<class TYPE>
+struct FlatHash<TYPE*, void>
+{
+    uint32 operator()(const TYPE* key) const
+    {
+        uint64 value = (uint64)(uintptr_t)key;
+        return uint32(value ^ (value >> 32));
+    }
+};
+
+//------------------------------------------------------------------------------
+/**
+    String keys hash like String::HashCode(), and can also be looked up
+    with a const char* without constructing a string.
+*/
+template<>
+struct FlatHash<String, void>
+{
+    uint32 operator()(const String& key) const
+    {
+        return key.HashCode();
+    }
+    uint32 operator()(const char* key) const
+    {
+        return String::Hash(key, SizeT(strlen(key)));
+    }
+};
+
+//------------------------------------------------------------------------------
+template<class KEYTYPE, class SLOTTYPE, class HASHER> class FlatHashTable
+{
+public:
+    /// number of control bytes probed at once
+    static const SizeT GroupWidth = 16;
+
+    /// default constructor
+    FlatHashTable();
+    /// copy constructor
+    FlatHashTable(const FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>& rhs);
+    /// move constructor
+    FlatHashTable(FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>&& rhs) noexcept;
+    /// destructor
+    ~FlatHashTable();
+    /// assignment operator
+    void operator=(const FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>& rhs);
+    /// move assignment operator
+    void operator=(FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>&& rhs) noexcept;
+
+    /// return number of elements
+    SizeT Size() const;
+    /// return number of slots
+    SizeT Capacity() const;
+    /// return true if empty
+    bool IsEmpty() const;
+    /// destroy all elements, keeps the allocated slots
+    void Clear();
+    /// make room for at least numElements without growing
+    void Reserve(SizeT numElements);
+
+    /// find slot index of key (InvalidIndex if it doesn't exist)
+    template<class LOOKUPTYPE> IndexT FindIndex(const LOOKUPTYPE& key) const;
+    /// return true if key exists
+    template<class LOOKUPTYPE> bool Contains(const LOOKUPTYPE& key) const;
+    /// erase a key, asserts that it exists
+    template<class LOOKUPTYPE> void Erase(const LOOKUPTYPE& key);
+    /// erase the element at a slot index
+    void EraseIndex(IndexT index);
+    /// return true if the slot index holds an element
+    bool IsOccupied(IndexT index) const;
+
+    /// iterator over the occupied slots
+    class Iterator
+    {
+    public:
+        /// advance to the next occupied slot
+        Iterator& operator++();
+        /// access the element
+        SLOTTYPE& operator*() const;
+        /// access the element
+        SLOTTYPE* operator->() const;
+        /// check if iterators differ
+        bool operator!=(const Iterator& rhs) const;
+        /// check if iterators are equal
+        bool operator==(const Iterator& rhs) const;
+    private:
+        friend class FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>;
+        const FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>* table;
+        IndexT index;
+    };
+
+    /// for range-based iteration
+    Iterator begin() const;
+    /// for range-based iteration
+    Iterator end() const;
+
+protected:
+    /// find the slot of a key, or claim a new slot for it which the caller must construct
+    IndexT PrepareInsert(const KEYTYPE& key, bool& outInserted);
+    /// get element at slot index
+    SLOTTYPE& SlotAtIndex(IndexT index) const;
+
+private:
+    static const int8 Empty = -128;
+    static const int8 Deleted = -2;
+
+    /// a group of control bytes
+    struct Group
+    {
+        /// load the group at pos
+        explicit Group(const int8* pos);
+        /// get mask of the bytes matching h2
+        uint Match(int8 h2) const;
+        /// get mask of the empty bytes
+        uint MatchEmpty() const;
+        /// get mask of the empty or deleted bytes
+        uint MatchEmptyOrDeleted() const;
+
+        #if NEBULA_FLATHASH_SSE2
+        __m128i ctrl;
+        #else
+        const int8* ctrl;
+        #endif
+    };
+
+    /// spread a 32 bit hash code over 64 bits
+    static uint64 Mix(uint32 hash);
+    /// get the key of a set slot
+    static const KEYTYPE& SlotKey(const KEYTYPE& slot);
+    /// get the key of a map slot
+    template<class VALUETYPE> static const KEYTYPE& SlotKey(const KeyValuePair<KEYTYPE, VALUETYPE>& slot);
+    /// max number of elements for a capacity
+    static SizeT MaxLoad(SizeT capacity);
+
+    /// find the slot of a key with a mixed hash
+    template<class LOOKUPTYPE> IndexT FindWithHash(const LOOKUPTYPE& key, uint64 hash) const;
+    /// find the first empty or deleted slot for a mixed hash
+    IndexT FindInsertSlot(uint64 hash) const;
+    /// reallocate to a new capacity and reinsert all elements
+    void Resize(SizeT newCapacity);
+    /// destroy all elements and free the slots
+    void Delete();
+    /// copy all elements from another table
+    void Copy(const FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>& rhs);
+
+    int8* ctrl;
+    SLOTTYPE* slots;
+    SizeT capacity;
+    SizeT size;
+    SizeT growthLeft;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Group::Group(const int8* pos)
+{
+    #if NEBULA_FLATHASH_SSE2
+    this->ctrl = _mm_loadu_si128((const __m128i*)pos);
+    #else
+    this->ctrl = pos;
+    #endif
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline uint
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Group::Match(int8 h2) const
+{
+    #if NEBULA_FLATHASH_SSE2
+    return (uint)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), this->ctrl));
+    #else
+    uint mask = 0;
+    IndexT i;
+    for (i = 0; i < GroupWidth; i++)
+    {
+        mask |= uint(this->ctrl[i] == h2) << i;
+    }
+    return mask;
+    #endif
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline uint
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Group::MatchEmpty() const
+{
+    return this->Match(Empty);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Empty and deleted are the only negative control bytes.
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline uint
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Group::MatchEmptyOrDeleted() const
+{
+    #if NEBULA_FLATHASH_SSE2
+    return (uint)_mm_movemask_epi8(this->ctrl);
+    #else
+    uint mask = 0;
+    IndexT i;
+    for (i = 0; i < GroupWidth; i++)
+    {
+        mask |= uint(this->ctrl[i] < 0) << i;
+    }
+    return mask;
+    #endif
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::FlatHashTable() :
+    ctrl(nullptr),
+    slots(nullptr),
+    capacity(0),
+    size(0),
+    growthLeft(0)
+{
+    static_assert(alignof(SLOTTYPE) <= GroupWidth, "FlatHashTable: slot alignment must not exceed the group width");
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::FlatHashTable(const FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>& rhs) :
+    ctrl(nullptr),
+    slots(nullptr),
+    capacity(0),
+    size(0),
+    growthLeft(0)
+{
+    this->Copy(rhs);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::FlatHashTable(FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>&& rhs) noexcept :
+    ctrl(rhs.ctrl),
+    slots(rhs.slots),
+    capacity(rhs.capacity),
+    size(rhs.size),
+    growthLeft(rhs.growthLeft)
+{
+    rhs.ctrl = nullptr;
+    rhs.slots = nullptr;
+    rhs.capacity = 0;
+    rhs.size = 0;
+    rhs.growthLeft = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::~FlatHashTable()
+{
+    this->Delete();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline void
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::operator=(const FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>& rhs)
+{
+    if (this != &rhs)
+    {
+        this->Clear();
+        this->Copy(rhs);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline void
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::operator=(FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>&& rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        this->Delete();
+        this->ctrl = rhs.ctrl;
+        this->slots = rhs.slots;
+        this->capacity = rhs.capacity;
+        this->size = rhs.size;
+        this->growthLeft = rhs.growthLeft;
+        rhs.ctrl = nullptr;
+        rhs.slots = nullptr;
+        rhs.capacity = 0;
+        rhs.size = 0;
+        rhs.growthLeft = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline SizeT
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Size() const
+{
+    return this->size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline SizeT
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Capacity() const
+{
+    return this->capacity;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline bool
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::IsEmpty() const
+{
+    return 0 == this->size;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline void
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Clear()
+{
+    IndexT i;
+    for (i = 0; i < this->capacity; i++)
+    {
+        if (this->ctrl[i] >= 0)
+        {
+            this->slots[i].~SLOTTYPE();
+        }
+    }
+    if (this->capacity > 0)
+    {
+        memset(this->ctrl, Empty, this->capacity);
+    }
+    this->size = 0;
+    this->growthLeft = MaxLoad(this->capacity);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline void
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Reserve(SizeT numElements)
+{
+    if (numElements <= MaxLoad(this->capacity))
+    {
+        return;
+    }
+    SizeT newCapacity = GroupWidth;
+    while (MaxLoad(newCapacity) < numElements)
+    {
+        newCapacity *= 2;
+    }
+    this->Resize(newCapacity);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+template<class LOOKUPTYPE>
+inline IndexT
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::FindIndex(const LOOKUPTYPE& key) const
+{
+    if (0 == this->size)
+    {
+        return InvalidIndex;
+    }
+    return this->FindWithHash(key, Mix(HASHER()(key)));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+template<class LOOKUPTYPE>
+inline bool
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Contains(const LOOKUPTYPE& key) const
+{
+    return InvalidIndex != this->FindIndex(key);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+template<class LOOKUPTYPE>
+inline void
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Erase(const LOOKUPTYPE& key)
+{
+    IndexT index = this->FindIndex(key);
+    n_assert(InvalidIndex != index);
+    this->EraseIndex(index);
+}
+
+//------------------------------------------------------------------------------
+/**
+    If the group of the slot still has an empty slot, no lookup ever probed
+    past it, so the slot can become empty again. Otherwise it must become
+    a tombstone to keep the probe sequences of other keys intact.
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline void
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::EraseIndex(IndexT index)
+{
+    n_assert(this->IsOccupied(index));
+    this->slots[index].~SLOTTYPE();
+    Group group(this->ctrl + (index & ~(GroupWidth - 1)));
+    if (0 != group.MatchEmpty())
+    {
+        this->ctrl[index] = Empty;
+        this->growthLeft++;
+    }
+    else
+    {
+        this->ctrl[index] = Deleted;
+    }
+    this->size--;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline bool
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::IsOccupied(IndexT index) const
+{
+    return (index >= 0) && (index < this->capacity) && (this->ctrl[index] >= 0);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline SLOTTYPE&
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::SlotAtIndex(IndexT index) const
+{
+    #if NEBULA_BOUNDSCHECKS
+    n_assert(this->IsOccupied(index));
+    #endif
+    return this->slots[index];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline typename FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Iterator
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::begin() const
+{
+    Iterator it;
+    it.table = this;
+    it.index = 0;
+    while ((it.index < this->capacity) && (this->ctrl[it.index] < 0))
+    {
+        it.index++;
+    }
+    return it;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline typename FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Iterator
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::end() const
+{
+    Iterator it;
+    it.table = this;
+    it.index = this->capacity;
+    return it;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline typename FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Iterator&
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Iterator::operator++()
+{
+    do
+    {
+        this->index++;
+    }
+    while ((this->index < this->table->capacity) && (this->table->ctrl[this->index] < 0));
+    return *this;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline SLOTTYPE&
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Iterator::operator*() const
+{
+    return this->table->slots[this->index];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline SLOTTYPE*
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Iterator::operator->() const
+{
+    return &this->table->slots[this->index];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline bool
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Iterator::operator!=(const Iterator& rhs) const
+{
+    return this->index != rhs.index;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline bool
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Iterator::operator==(const Iterator& rhs) const
+{
+    return this->index == rhs.index;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Hash codes are often small integers or weak string hashes, the
+    multiplication spreads every input bit over the upper half, which
+    is then folded back into the lower bits used for probing.
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline uint64
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Mix(uint32 hash)
+{
+    uint64 mixed = uint64(hash) * 0x9E3779B97F4A7C15ull;
+    return mixed ^ (mixed >> 32);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline const KEYTYPE&
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::SlotKey(const KEYTYPE& slot)
+{
+    return slot;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+template<class VALUETYPE>
+inline const KEYTYPE&
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::SlotKey(const KeyValuePair<KEYTYPE, VALUETYPE>& slot)
+{
+    return slot.Key();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline SizeT
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::MaxLoad(SizeT capacity)
+{
+    return capacity - capacity / 8;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Groups are probed in triangular order, which visits every group once
+    for a power of two number of groups. The lower 7 bits of the hash are
+    stored in the control bytes, the bits above select the first group.
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+template<class LOOKUPTYPE>
+inline IndexT
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::FindWithHash(const LOOKUPTYPE& key, uint64 hash) const
+{
+    const int8 h2 = int8(hash & 0x7F);
+    const SizeT groupMask = this->capacity / GroupWidth - 1;
+    SizeT group = SizeT(hash >> 7) & groupMask;
+    SizeT step = 0;
+    for (;;)
+    {
+        const IndexT base = group * GroupWidth;
+        Group ctrlGroup(this->ctrl + base);
+        uint match = ctrlGroup.Match(h2);
+        while (0 != match)
+        {
+            IndexT index = base + FirstOne(match);
+            if (SlotKey(this->slots[index]) == key)
+            {
+                return index;
+            }
+            match &= match - 1;
+        }
+        if (0 != ctrlGroup.MatchEmpty())
+        {
+            return InvalidIndex;
+        }
+        step++;
+        group = (group + step) & groupMask;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline IndexT
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::FindInsertSlot(uint64 hash) const
+{
+    const SizeT groupMask = this->capacity / GroupWidth - 1;
+    SizeT group = SizeT(hash >> 7) & groupMask;
+    SizeT step = 0;
+    for (;;)
+    {
+        uint match = Group(this->ctrl + group * GroupWidth).MatchEmptyOrDeleted();
+        if (0 != match)
+        {
+            return group * GroupWidth + FirstOne(match);
+        }
+        step++;
+        group = (group + step) & groupMask;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Returns the slot of the key. If the key isn't in the table yet, a slot
+    is claimed and outInserted is set, the caller must then placement-construct
+    the element in it before the table is used again.
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline IndexT
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::PrepareInsert(const KEYTYPE& key, bool& outInserted)
+{
+    uint64 hash = Mix(HASHER()(key));
+    IndexT index = InvalidIndex;
+    if (this->size > 0)
+    {
+        index = this->FindWithHash(key, hash);
+        if (InvalidIndex != index)
+        {
+            outInserted = false;
+            return index;
+        }
+    }
+
+    // tombstones can always be reused, empty slots only while below the max load
+    if (this->capacity > 0)
+    {
+        index = this->FindInsertSlot(hash);
+    }
+    if ((InvalidIndex == index) || ((0 == this->growthLeft) && (Empty == this->ctrl[index])))
+    {
+        if ((this->capacity > 0) && (this->size < MaxLoad(this->capacity) / 2))
+        {
+            // mostly tombstones, rebuilding at the same size is enough
+            this->Resize(this->capacity);
+        }
+        else
+        {
+            this->Resize(Math::max<SizeT>(this->capacity * 2, GroupWidth));
+        }
+        index = this->FindInsertSlot(hash);
+    }
+
+    if (Empty == this->ctrl[index])
+    {
+        this->growthLeft--;
+    }
+    this->ctrl[index] = int8(hash & 0x7F);
+    this->size++;
+    outInserted = true;
+    return index;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Control bytes and slots share a single allocation, the control bytes
+    come first and are a multiple of the group width, so the slots are
+    aligned as well.
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline void
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Resize(SizeT newCapacity)
+{
+    n_assert((newCapacity >= GroupWidth) && (0 == (newCapacity & (newCapacity - 1))));
+    n_assert(MaxLoad(newCapacity) >= this->size);
+
+    int8* oldCtrl = this->ctrl;
+    SLOTTYPE* oldSlots = this->slots;
+    SizeT oldCapacity = this->capacity;
+
+    byte* block = (byte*)Memory::Alloc(Memory::ObjectArrayHeap, newCapacity + newCapacity * sizeof(SLOTTYPE));
+    this->ctrl = (int8*)block;
+    this->slots = (SLOTTYPE*)(block + newCapacity);
+    this->capacity = newCapacity;
+    this->growthLeft = MaxLoad(newCapacity) - this->size;
+    memset(this->ctrl, Empty, newCapacity);
+
+    IndexT i;
+    for (i = 0; i < oldCapacity; i++)
+    {
+        if (oldCtrl[i] >= 0)
+        {
+            uint64 hash = Mix(HASHER()(SlotKey(oldSlots[i])));
+            IndexT index = this->FindInsertSlot(hash);
+            this->ctrl[index] = int8(hash & 0x7F);
+            ::new (&this->slots[index]) SLOTTYPE(std::move(oldSlots[i]));
+            oldSlots[i].~SLOTTYPE();
+        }
+    }
+    if (nullptr != oldCtrl)
+    {
+        Memory::Free(Memory::ObjectArrayHeap, oldCtrl);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline void
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Delete()
+{
+    if (nullptr != this->ctrl)
+    {
+        this->Clear();
+        Memory::Free(Memory::ObjectArrayHeap, this->ctrl);
+        this->ctrl = nullptr;
+        this->slots = nullptr;
+        this->capacity = 0;
+        this->growthLeft = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class SLOTTYPE, class HASHER>
+inline void
+FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>::Copy(const FlatHashTable<KEYTYPE, SLOTTYPE, HASHER>& rhs)
+{
+    n_assert(0 == this->size);
+    this->Reserve(rhs.size);
+    IndexT i;
+    for (i = 0; i < rhs.capacity; i++)
+    {
+        if (rhs.ctrl[i] >= 0)
+        {
+            bool inserted;
+            IndexT index = this->PrepareInsert(SlotKey(rhs.slots[i]), inserted);
+            ::new (&this->slots[index]) SLOTTYPE(rhs.slots[i]);
+        }
+    }
+}
+
+} // namespace Util
+//------------------------------------------------------------------------------
@@ -0,0 +1,187 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Util::FlatHashMap
+
+    A growable hash map of key/value pairs, stored flat in a single
+    allocation and probed 16 slots at a time, see Util::FlatHashTable.
+
+    Compared to Util::Dictionary, insertion and lookup are O(1) instead of
+    a binary search and a sorted insert, and compared to Util::HashTable
+    the map grows with its content instead of being bound to a table size
+    fixed at compile time. The elements are not sorted, and the index of
+    an element returned by FindIndex() or Add() is only valid until the
+    next insertion.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "util/flathash.h"
+#include "util/array.h"
+
+//------------------------------------------------------------------------------
+namespace Util
+{
+template<class KEYTYPE, class VALUETYPE, class HASHER = FlatHash<KEYTYPE>> class FlatHashMap :
+    public FlatHashTable<KEYTYPE, KeyValuePair<KEYTYPE, VALUETYPE>, HASHER>
+{
+public:
+    /// read/write [] operator, asserts if key not found
+    template<class LOOKUPTYPE> VALUETYPE& operator[](const LOOKUPTYPE& key);
+    /// read-only [] operator, asserts if key not found
+    template<class LOOKUPTYPE> const VALUETYPE& operator[](const LOOKUPTYPE& key) const;
+
+    /// add a key/value pair object, asserts if the key exists, returns the index of the element
+    IndexT Add(const KeyValuePair<KEYTYPE, VALUETYPE>& kvp);
+    /// add a key and associated value, asserts if the key exists, returns the index of the element
+    IndexT Add(const KEYTYPE& key, const VALUETYPE& value);
+    /// adds a default constructed element if the key doesn't exist, and returns a reference to its value
+    VALUETYPE& Emplace(const KEYTYPE& key);
+
+    /// get a key at given index
+    const KEYTYPE& KeyAtIndex(IndexT index) const;
+    /// access value at given index
+    VALUETYPE& ValueAtIndex(IndexT index);
+    /// access value at given index
+    const VALUETYPE& ValueAtIndex(IndexT index) const;
+    /// get all keys as an Util::Array
+    Array<KEYTYPE> KeysAsArray() const;
+    /// get all values as an Util::Array
+    Array<VALUETYPE> ValuesAsArray() const;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+template<class LOOKUPTYPE>
+inline VALUETYPE&
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::operator[](const LOOKUPTYPE& key)
+{
+    IndexT index = this->FindIndex(key);
+    n_assert(InvalidIndex != index);
+    return this->SlotAtIndex(index).Value();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+template<class LOOKUPTYPE>
+inline const VALUETYPE&
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::operator[](const LOOKUPTYPE& key) const
+{
+    IndexT index = this->FindIndex(key);
+    n_assert(InvalidIndex != index);
+    return this->SlotAtIndex(index).Value();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+inline IndexT
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::Add(const KeyValuePair<KEYTYPE, VALUETYPE>& kvp)
+{
+    bool inserted;
+    IndexT index = this->PrepareInsert(kvp.Key(), inserted);
+    n_assert2(inserted, "FlatHashMap::Add(): key already exists!");
+    ::new (&this->SlotAtIndex(index)) KeyValuePair<KEYTYPE, VALUETYPE>(kvp);
+    return index;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+inline IndexT
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::Add(const KEYTYPE& key, const VALUETYPE& value)
+{
+    bool inserted;
+    IndexT index = this->PrepareInsert(key, inserted);
+    n_assert2(inserted, "FlatHashMap::Add(): key already exists!");
+    ::new (&this->SlotAtIndex(index)) KeyValuePair<KEYTYPE, VALUETYPE>(key, value);
+    return index;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+inline VALUETYPE&
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::Emplace(const KEYTYPE& key)
+{
+    bool inserted;
+    IndexT index = this->PrepareInsert(key, inserted);
+    KeyValuePair<KEYTYPE, VALUETYPE>& kvp = this->SlotAtIndex(index);
+    if (inserted)
+    {
+        ::new (&kvp) KeyValuePair<KEYTYPE, VALUETYPE>(key);
+    }
+    return kvp.Value();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+inline const KEYTYPE&
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::KeyAtIndex(IndexT index) const
+{
+    return this->SlotAtIndex(index).Key();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+inline VALUETYPE&
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::ValueAtIndex(IndexT index)
+{
+    return this->SlotAtIndex(index).Value();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+inline const VALUETYPE&
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::ValueAtIndex(IndexT index) const
+{
+    return this->SlotAtIndex(index).Value();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+inline Array<KEYTYPE>
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::KeysAsArray() const
+{
+    Array<KEYTYPE> result;
+    result.Reserve(this->Size());
+    for (const KeyValuePair<KEYTYPE, VALUETYPE>& kvp : *this)
+    {
+        result.Append(kvp.Key());
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class VALUETYPE, class HASHER>
+inline Array<VALUETYPE>
+FlatHashMap<KEYTYPE, VALUETYPE, HASHER>::ValuesAsArray() const
+{
+    Array<VALUETYPE> result;
+    result.Reserve(this->Size());
+    for (const KeyValuePair<KEYTYPE, VALUETYPE>& kvp : *this)
+    {
+        result.Append(kvp.Value());
+    }
+    return result;
+}
+
+} // namespace Util
+//------------------------------------------------------------------------------
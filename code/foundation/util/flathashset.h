@@ -0,0 +1,76 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Util::FlatHashSet
+
+    A growable hash set of unique keys, stored flat in a single allocation
+    and probed 16 slots at a time, see Util::FlatHashTable.
+
+    Adding the same key more than once has no effect. Unlike Util::Set,
+    the keys are not sorted.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "util/flathash.h"
+#include "util/array.h"
+
+//------------------------------------------------------------------------------
+namespace Util
+{
+template<class KEYTYPE, class HASHER = FlatHash<KEYTYPE>> class FlatHashSet :
+    public FlatHashTable<KEYTYPE, KEYTYPE, HASHER>
+{
+public:
+    /// add a key, returns true if it wasn't in the set yet
+    bool Add(const KEYTYPE& key);
+    /// get a key at given index
+    const KEYTYPE& KeyAtIndex(IndexT index) const;
+    /// get all keys as an Util::Array
+    Array<KEYTYPE> KeysAsArray() const;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class HASHER>
+inline bool
+FlatHashSet<KEYTYPE, HASHER>::Add(const KEYTYPE& key)
+{
+    bool inserted;
+    IndexT index = this->PrepareInsert(key, inserted);
+    if (inserted)
+    {
+        ::new (&this->SlotAtIndex(index)) KEYTYPE(key);
+    }
+    return inserted;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class HASHER>
+inline const KEYTYPE&
+FlatHashSet<KEYTYPE, HASHER>::KeyAtIndex(IndexT index) const
+{
+    return this->SlotAtIndex(index);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class KEYTYPE, class HASHER>
+inline Array<KEYTYPE>
+FlatHashSet<KEYTYPE, HASHER>::KeysAsArray() const
+{
+    Array<KEYTYPE> result;
+    result.Reserve(this->Size());
+    for (const KEYTYPE& key : *this)
+    {
+        result.Append(key);
+    }
+    return result;
+}
+
+} // namespace Util
+//------------------------------------------------------------------------------
@@ -5,20 +5,31 @@
 //------------------------------------------------------------------------------
 
 #include "util/globalstringatomtable.h"
+#include "threading/interlocked.h"
+
+#include <string.h>
 
 namespace Util
 {
 __ImplementInterfaceSingleton(Util::GlobalStringAtomTable);
 
+using namespace Threading;
+
 //------------------------------------------------------------------------------
 /**
 */
 GlobalStringAtomTable::GlobalStringAtomTable()
 {
     __ConstructInterfaceSingleton;
-    
-    // setup the global string buffer
-    this->stringBuffer.Setup(NEBULA_GLOBAL_STRINGBUFFER_CHUNKSIZE);
+
+    IndexT i;
+    for (i = 0; i < NumShards; i++)
+    {
+        Shard& shard = this->shards[i];
+        shard.slots = AllocSlotArray(InitialShardCapacity);
+        shard.size = 0;
+        shard.stringBuffer.Setup(NEBULA_GLOBAL_STRINGBUFFER_CHUNKSIZE);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -26,71 +37,216 @@ GlobalStringAtomTable::GlobalStringAtomTable()
 */
 GlobalStringAtomTable::~GlobalStringAtomTable()
 {
-    this->critSect.Enter();
-    this->stringBuffer.Discard();
+    IndexT i;
+    for (i = 0; i < NumShards; i++)
+    {
+        Shard& shard = this->shards[i];
+        shard.critSect.Enter();
+        SlotArray* slots = shard.slots;
+        while (nullptr != slots)
+        {
+            SlotArray* prev = slots->prev;
+            Memory::Free(Memory::StringDataHeap, slots);
+            slots = prev;
+        }
+        shard.slots = nullptr;
+        shard.size = 0;
+        shard.stringBuffer.Discard();
+        shard.critSect.Leave();
+    }
     __DestructInterfaceSingleton;
-    this->critSect.Leave();
 }
 
 //------------------------------------------------------------------------------
 /**
+    FNV-1a followed by a final avalanche, so both the upper bits (which
+    select the shard) and the lower bits (which select the slot) are
+    well distributed.
 */
-void
-GlobalStringAtomTable::Lock()
+uint32
+GlobalStringAtomTable::Hash(const char* str, SizeT& outLength)
 {
-    this->critSect.Enter();
+    uint32 hash = 2166136261u;
+    const char* ptr = str;
+    while (0 != *ptr)
+    {
+        hash ^= (uchar)*ptr++;
+        hash *= 16777619u;
+    }
+    outLength = SizeT(ptr - str);
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-void
-GlobalStringAtomTable::Unlock()
+GlobalStringAtomTable::SlotArray*
+GlobalStringAtomTable::AllocSlotArray(SizeT capacity)
 {
-    this->critSect.Leave();
+    n_assert(0 == (capacity & (capacity - 1)));
+    size_t size = sizeof(SlotArray) + capacity * sizeof(Slot);
+    SlotArray* slots = (SlotArray*)Memory::Alloc(Memory::StringDataHeap, size);
+    Memory::Clear(slots, size);
+    slots->capacity = capacity;
+    slots->prev = nullptr;
+    return slots;
 }
 
 //------------------------------------------------------------------------------
 /**
-    This adds a new string to the atom table and the global string buffer,
-    and returns the pointer to the string in the string buffer.
+    Linear probing until an empty slot is hit. The string pointer of a slot
+    is published last, so a reader seeing a string also sees its hash. Should
+    a reader on a weakly ordered cpu still see a stale hash, it only misses
+    the string and the caller confirms the miss under the shard lock.
+*/
+const char*
+GlobalStringAtomTable::FindInSlots(const SlotArray* slots, const char* str, uint32 hash)
+{
+    const Slot* slot = slots->Slots();
+    SizeT mask = slots->capacity - 1;
+    IndexT i = hash & mask;
+    for (;;)
+    {
+        const char* slotStr = slot[i].str;
+        if (nullptr == slotStr)
+        {
+            return nullptr;
+        }
+        if ((slot[i].hash == hash) && (0 == strcmp(slotStr, str)))
+        {
+            return slotStr;
+        }
+        i = (i + 1) & mask;
+    }
+}
 
-    NOTE: you MUST call this method within Lock()/Unlock()!
+//------------------------------------------------------------------------------
+/**
+    Lock-free lookup. The slot array of the shard may be replaced by
+    another thread at any time, but retired slot arrays stay valid until
+    the table is destroyed.
 */
 const char*
-GlobalStringAtomTable::Add(const char* str)
+GlobalStringAtomTable::Find(const char* str, uint32 hash) const
 {
-    StaticString sstr;
-    sstr.ptr = (char*)this->stringBuffer.AddString(str);
-    this->table.InsertSorted(sstr);
-    return sstr.ptr;
+    const Shard& shard = this->shards[hash >> (32 - NumShardBits)];
+    return FindInSlots(shard.slots, str, hash);
 }
 
 //------------------------------------------------------------------------------
 /**
-    Debug method: get an array with all string in the table.
+    The new slot array is filled completely before it is published, the
+    old one is kept in the list of the new one and freed with the table.
+*/
+void
+GlobalStringAtomTable::Grow(Shard& shard)
+{
+    SlotArray* oldSlots = shard.slots;
+    SlotArray* newSlots = AllocSlotArray(oldSlots->capacity * 2);
+    newSlots->prev = oldSlots;
+
+    const Slot* src = oldSlots->Slots();
+    Slot* dst = newSlots->Slots();
+    SizeT mask = newSlots->capacity - 1;
+    IndexT i;
+    for (i = 0; i < oldSlots->capacity; i++)
+    {
+        if (nullptr != src[i].str)
+        {
+            IndexT j = src[i].hash & mask;
+            while (nullptr != dst[j].str)
+            {
+                j = (j + 1) & mask;
+            }
+            dst[j].hash = src[i].hash;
+            dst[j].str = src[i].str;
+        }
+    }
+    Interlocked::ExchangePointer((void* volatile*)&shard.slots, newSlots);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Adds a new string to the shard of its hash and to the string buffer of
+    the shard, and returns the pointer to the string in the string buffer.
+    If another thread added the same string in the meantime, its pointer is
+    returned instead.
+*/
+const char*
+GlobalStringAtomTable::Add(const char* str, SizeT length, uint32 hash)
+{
+    Shard& shard = this->shards[hash >> (32 - NumShardBits)];
+    shard.critSect.Enter();
+    const char* result = FindInSlots(shard.slots, str, hash);
+    if (nullptr == result)
+    {
+        // keep the load factor below 3/4 so probe sequences stay short
+        if ((shard.size + 1) * 4 > shard.slots->capacity * 3)
+        {
+            Grow(shard);
+        }
+        result = shard.stringBuffer.AddString(str, length);
+
+        Slot* slot = shard.slots->Slots();
+        SizeT mask = shard.slots->capacity - 1;
+        IndexT i = hash & mask;
+        while (nullptr != slot[i].str)
+        {
+            i = (i + 1) & mask;
+        }
+        slot[i].hash = hash;
+        Interlocked::ExchangePointer((void* volatile*)&slot[i].str, (void*)result);
+        shard.size++;
+    }
+    shard.critSect.Leave();
+    return result;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Debug method: get an array with all string in the table, sorted
+    alphabetically.
 */
 GlobalStringAtomTable::DebugInfo
 GlobalStringAtomTable::GetDebugInfo() const
 {
-    this->critSect.Enter();
     DebugInfo debugInfo;
-    debugInfo.strings.Reserve(this->table.Size());
     debugInfo.chunkSize = NEBULA_GLOBAL_STRINGBUFFER_CHUNKSIZE;
-    debugInfo.numChunks = this->stringBuffer.GetNumChunks();
-    debugInfo.allocSize = debugInfo.chunkSize * debugInfo.numChunks;
+    debugInfo.numChunks = 0;
     debugInfo.usedSize  = 0;
     debugInfo.growthEnabled = NEBULA_ENABLE_GLOBAL_STRINGBUFFER_GROWTH;
 
     IndexT i;
-    for (i = 0; i < table.Size(); i++)
-    {        
-        const char* str = this->table[i].ptr;
-        debugInfo.strings.Append(this->table[i].ptr);
-        debugInfo.usedSize += strlen(str) + 1;
+    for (i = 0; i < NumShards; i++)
+    {
+        const Shard& shard = this->shards[i];
+        shard.critSect.Enter();
+        debugInfo.numChunks += shard.stringBuffer.GetNumChunks();
+        const Slot* slot = shard.slots->Slots();
+        IndexT j;
+        for (j = 0; j < shard.slots->capacity; j++)
+        {
+            const char* str = slot[j].str;
+            if (nullptr != str)
+            {
+                debugInfo.strings.Append(str);
+                debugInfo.usedSize += strlen(str) + 1;
+            }
+        }
+        shard.critSect.Leave();
     }
-    this->critSect.Leave();
+    debugInfo.allocSize = debugInfo.chunkSize * debugInfo.numChunks;
+    debugInfo.strings.SortWithFunc([](const char* const& lhs, const char* const& rhs)
+    {
+        return strcmp(lhs, rhs) < 0;
+    });
     return debugInfo;
 }
 
-} // namespace Util
\ No newline at end of file
+} // namespace Util
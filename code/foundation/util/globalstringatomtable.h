@@ -2,18 +2,24 @@
 //------------------------------------------------------------------------------
 /**
     @class Util::GlobalStringAtomTable
-  
+
     Global string atom table. This is the definitive string atom table which
-    contains the string of all string atoms of all threads. Locking
-    is necessary to lookup or add a string (that's why thread-local
-    string atom tables exist as local cache to prevent too much locking of
-    the global table).
-    
+    contains the string of all string atoms of all threads.
+
+    The table is an open addressing hash table split into shards by the
+    upper bits of the string hash. Looking up a string which is already
+    in the table never takes a lock: the slots are only ever published
+    with an atomic exchange, and a shard which outgrows its slot array
+    publishes a new one but keeps the old one alive, so readers racing
+    with an insert always see a consistent array. Only a lookup which
+    misses takes the lock of its shard, looks again and adds the string
+    to the string buffer of the shard. Since strings never move and are
+    only stored once, atoms can still be compared by pointer.
+
     @copyright
     (C) 2009 Radon Labs GmbH
     (C) 2013-2020 Individual contributors, see AUTHORS file
 */
-#include "util/stringatomtablebase.h"
 #include "core/singleton.h"
 #include "threading/criticalsection.h"
 #include "util/stringbuffer.h"
@@ -21,7 +27,7 @@
 //------------------------------------------------------------------------------
 namespace Util
 {
-class GlobalStringAtomTable : public StringAtomTableBase
+class GlobalStringAtomTable
 {
     __DeclareInterfaceSingleton(GlobalStringAtomTable);
 public:
@@ -30,9 +36,6 @@ public:
     /// destructor
     ~GlobalStringAtomTable();
 
-    /// get pointer to global string buffer
-    StringBuffer* GetGlobalStringBuffer() const;
-
     /// debug functionality: DebugInfo struct
     struct DebugInfo
     {
@@ -43,24 +46,65 @@ public:
         size_t usedSize;
         bool growthEnabled;
     };
-    
+
     /// debug functionality: get copy of the string atom table
     DebugInfo GetDebugInfo() const;
 
 private:
     friend class StringAtom;
 
-    /// take the critical section
-    void Lock();
-    /// add a string pointer to the atom table and string buffer (must be called inside Lock())
-    const char* Add(const char* str);
-    /// release the critical section
-    void Unlock();
+    /// compute the hash of a string and its length in a single pass
+    static uint32 Hash(const char* str, SizeT& outLength);
+    /// find a string in the table without locking, returns nullptr if not found
+    const char* Find(const char* str, uint32 hash) const;
+    /// add a string if it isn't in the table yet, returns the pointer to the atom string
+    const char* Add(const char* str, SizeT length, uint32 hash);
+
+    static const SizeT NumShardBits = 3;
+    static const SizeT NumShards = 1 << NumShardBits;
+    static const SizeT InitialShardCapacity = 256;
 
-    Threading::CriticalSection critSect;
-    StringBuffer stringBuffer;
+    struct Slot
+    {
+        const char* volatile str;
+        uint32 hash;
+    };
+
+    struct SlotArray
+    {
+        SizeT capacity;
+        SlotArray* prev;
+
+        /// get pointer to the slots, which follow the header in memory
+        Slot* Slots() const;
+    };
+
+    struct Shard
+    {
+        SlotArray* volatile slots;
+        SizeT size;
+        Threading::CriticalSection critSect;
+        StringBuffer stringBuffer;
+    };
+
+    /// allocate a cleared slot array
+    static SlotArray* AllocSlotArray(SizeT capacity);
+    /// find a string in a single slot array
+    static const char* FindInSlots(const SlotArray* slots, const char* str, uint32 hash);
+    /// double the capacity of a shard (must be called inside the shard's critical section)
+    static void Grow(Shard& shard);
+
+    Shard shards[NumShards];
 };
 
-} // namespace Util
 //------------------------------------------------------------------------------
+/**
+*/
+inline GlobalStringAtomTable::Slot*
+GlobalStringAtomTable::SlotArray::Slots() const
+{
+    return (Slot*)(this + 1);
+}
 
+} // namespace Util
+//------------------------------------------------------------------------------
@@ -665,17 +665,13 @@ PinnedArray<MAX_ALLOCS, TYPE>::Grow()
     }
     else
     {
-        // grow by half of the current capacity, but never more then MaxGrowSize
+        // grow by half of the current capacity, but never past the reservation
         SizeT growBy = this->capacity >> 1;
         if (growBy == 0)
         {
             growBy = Array<TYPE>::MinGrowSize;
         }
-        else if (growBy > Array<TYPE>::MaxGrowSize)
-        {
-            growBy = Array<TYPE>::MaxGrowSize;
-        }
-        growToSize = this->capacity + growBy;
+        growToSize = Math::min(this->capacity + growBy, (SizeT)MAX_ALLOCS);
     }
     this->GrowTo(growToSize);
 }
@@ -701,7 +697,7 @@ PinnedArray<MAX_ALLOCS, TYPE>::GrowTo(SizeT newCapacity)
 
     // Rounded up to the page size so we don't waste memory we allocate anyways
     SizeT totalBytesNeeded = Math::align(totalByteSize, pageSize);
-    n_assert(totalBytesNeeded <= MAX_ALLOCS * sizeof(TYPE));
+    n_assert(totalBytesNeeded <= Math::align(MAX_ALLOCS * sizeof(TYPE), pageSize));
     SizeT roundedUpNewCapacity = totalBytesNeeded / sizeof(TYPE);
     SizeT offset = Math::align(this->capacity * sizeof(TYPE), pageSize);
     if (totalBytesNeeded > offset)
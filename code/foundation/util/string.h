@@ -172,6 +172,8 @@ public:
     static bool MatchPattern(const String& str, const String& pattern);
     /// return a 32-bit hash code for the string
     uint32_t HashCode() const;
+    /// compute the hash code of a raw string, identical to HashCode() of a String with the same content
+    static uint32_t Hash(const char* ptr, SizeT length);
 
     /// set content to char ptr
     void SetCharPtr(const char* s);
@@ -672,12 +674,19 @@ String::IsValid() const
 */
 inline uint32_t
 String::HashCode() const
+{
+    return Hash(this->AsCharPtr(), this->strLen);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline uint32_t
+String::Hash(const char* ptr, SizeT length)
 {
     uint32_t hash = 0;
-    const char* ptr = this->AsCharPtr();
-    SizeT len = this->strLen;
     SizeT i;
-    for (i = 0; i < len; i++)
+    for (i = 0; i < length; i++)
     {
         hash += ptr[i];
         hash += hash << 10;
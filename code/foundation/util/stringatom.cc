@@ -43,16 +43,17 @@ StringAtom::Setup(const char* str)
     #endif
 
     // the string wasn't in the local table (or thread-local tables are disabled), 
-    // so we need to check the global table, this involves thread synchronisation
+    // so we need to check the global table, a lookup which hits doesn't lock
     GlobalStringAtomTable* globalTable = GlobalStringAtomTable::Instance();
-    globalTable->Lock();
-    this->content = globalTable->Find(str);
+    SizeT length;
+    uint32 hash = GlobalStringAtomTable::Hash(str, length);
+    this->content = globalTable->Find(str, hash);
     if (0 == this->content)
     {
-        // hrmpf, string isn't in global table either yet, so add it...
-        this->content = globalTable->Add(str);
+        // hrmpf, string isn't in global table either yet, so add it, this
+        // only locks the shard the string belongs to
+        this->content = globalTable->Add(str, length, hash);
     }
-    globalTable->Unlock();
 
     #if NEBULA_ENABLE_THREADLOCAL_STRINGATOM_TABLES
         // finally, add the new string to our local table as well, so the
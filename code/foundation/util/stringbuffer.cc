@@ -81,12 +81,24 @@ StringBuffer::AllocNewChunk()
 */
 const char*
 StringBuffer::AddString(const char* str)
+{
+    n_assert(0 != str);
+    return this->AddString(str, SizeT(strlen(str)));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Copies a string of known length to the end of the string buffer,
+    returns pointer to copied string.
+*/
+const char*
+StringBuffer::AddString(const char* str, SizeT length)
 {
     n_assert(0 != str);
     n_assert(this->IsValid());
 
-    // get string length, must be less then chunk size
-    SizeT strLength = SizeT(strlen(str) + 1);
+    // string length including terminator must be less then chunk size
+    SizeT strLength = length + 1;
     n_assert(strLength < this->chunkSize);
 
     // check if a new buffer must be allocated
@@ -101,7 +113,7 @@ StringBuffer::AddString(const char* str)
 
     // copy string into string buffer
     char* dstPointer = this->curPointer;
-    strcpy(dstPointer, str);
+    memcpy(dstPointer, str, strLength);
     this->curPointer += strLength;
     return dstPointer;
 }
@@ -44,6 +44,8 @@ public:
 
     /// add a string to the end of the string buffer, return pointer to string
     const char* AddString(const char* str);
+    /// add a string with known length (excluding the terminator), return pointer to string
+    const char* AddString(const char* str, SizeT length);
     /// DEBUG: return next string in string buffer
     const char* NextString(const char* prev);
     /// DEBUG: get number of allocated chunks
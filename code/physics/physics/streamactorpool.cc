@@ -93,7 +93,7 @@ StreamActorPool::CreateActorInstance(ActorResourceId id, Math::mat4 const& trans
     actor.userData = userData;
 
 #if NEBULA_DEBUG
-    actor.debugName = Util::String::Sprintf("%s %d", this->names[id.resourceId].AsString().AsCharPtr(), newId);
+    actor.debugName = Util::String::Sprintf("%s %d", this->names[id.loaderInstanceId].AsString().AsCharPtr(), newId);
     newActor->setName(actor.debugName.AsCharPtr());
 #endif
 
@@ -0,0 +1,72 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file animationlod.h
+
+    Animation level of detail. Characters which are small on screen are
+    updated less often and with fewer joints, the poses in between are
+    blended towards a pose which is sampled ahead by one update period.
+    Characters which aren't seen by any observer are not updated at all.
+
+    The levels of a skeleton's joint masks match the levels here, see
+    SkeletonGetLodMask().
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+
+//------------------------------------------------------------------------------
+namespace Characters
+{
+
+enum AnimationLod : uchar
+{
+    AnimationLod_Full,          // every frame, all joints
+    AnimationLod_Reduced,       // every 2nd frame, without the joints at the end of a chain
+    AnimationLod_Minimal,       // every 4th frame, without the last two joints of a chain
+    AnimationLod_Culled,        // not seen by any observer, only the clock runs
+
+    NumAnimationLods
+};
+
+//------------------------------------------------------------------------------
+/**
+    The screen size is the length of the bounding box extents over the view
+    distance, the same measure the model context streams textures by.
+*/
+inline AnimationLod
+AnimationLodFromScreenSize(float screenSize, float reducedScreenSize, float minimalScreenSize)
+{
+    if (screenSize >= reducedScreenSize)
+        return AnimationLod_Full;
+    else if (screenSize >= minimalScreenSize)
+        return AnimationLod_Reduced;
+    else
+        return AnimationLod_Minimal;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Number of frames from one update to the next.
+*/
+inline SizeT
+AnimationLodUpdatePeriod(AnimationLod lod)
+{
+    n_assert(lod < AnimationLod_Culled);
+    return 1 << lod;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Characters are staggered by their index, so the updates of a level are
+    spread evenly over its period instead of all landing on the same frame.
+*/
+inline bool
+AnimationLodIsUpdateFrame(AnimationLod lod, IndexT frameIndex, IndexT character)
+{
+    return ((frameIndex + character) & (AnimationLodUpdatePeriod(lod) - 1)) == 0;
+}
+
+} // namespace Characters
+//------------------------------------------------------------------------------
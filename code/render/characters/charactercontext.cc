@@ -14,6 +14,8 @@
 #include "models/nodes/characterskinnode.h"
 #include "profiling/profiling.h"
 #include "resources/resourceserver.h"
+#include "math/simdkernels.h"
+#include "graphics/cameracontext.h"
 
 using namespace Graphics;
 using namespace Resources;
@@ -24,8 +26,9 @@ CharacterContext::CharacterContextAllocator CharacterContext::characterContextAl
 __ImplementContext(CharacterContext, CharacterContext::characterContextAllocator);
 
 Util::HashTable<Util::StringAtom, CoreAnimation::AnimSampleMask> CharacterContext::masks;
-Threading::Event CharacterContext::totalCompletionEvent;
 Threading::AtomicCounter CharacterContext::ConstantUpdateCounter = 0;
+float CharacterContext::lodReducedScreenSize = 0.1f;
+float CharacterContext::lodMinimalScreenSize = 0.04f;
 
 //------------------------------------------------------------------------------
 /**
@@ -109,6 +112,7 @@ CharacterContext::Setup(
             // setup joints, scaled joints and user controlled joints
             characterContextAllocator.Get<JointPalette>(cid.id).Resize(joints.Size());
             characterContextAllocator.Get<JointPaletteScaled>(cid.id).Resize(joints.Size());
+            characterContextAllocator.Get<JointPaletteTarget>(cid.id).Resize(joints.Size());
             characterContextAllocator.Get<UserControlledJoint>(cid.id).Resize(joints.Size());
 
             // setup job joints
@@ -134,6 +138,13 @@ CharacterContext::Setup(
             characterContextAllocator.Set<SupportMix>(cid.id, supportBlending);
         }, nullptr, true);
 
+    // the first update sets the joint palette right away
+    AnimationLodState& lodState = characterContextAllocator.Get<AnimLod>(cid.id);
+    lodState.lod = AnimationLod_Culled;
+    lodState.updatePeriod = 1;
+    lodState.framesSinceUpdate = 0;
+    lodState.snap = true;
+
     // clear playing animation state
     IndexT i;
     for (i = 0; i < MaxNumTracks; i++)
@@ -374,6 +385,20 @@ GetAbsoluteStopTime(const CharacterContext::AnimationRuntime& runtime)
     return (runtime.baseTime + runtime.startTime + runtime.duration) - runtime.fadeOutTime;
 }
 
+//------------------------------------------------------------------------------
+/**
+    What happens to a character this frame, decided by UpdateCharacterTracks.
+*/
+struct CharacterFrame
+{
+    Timing::Tick lookahead;     // the pose is sampled ahead of the clock by one update period
+    Timing::Tick poseTime;      // time in the clip of the only playing track
+    IndexT poseClip;            // the only playing clip, -1 if more tracks play and the pose can't be shared
+    IndexT poseSource;          // the character which samples and evaluates the pose
+    AnimationLod lod;           // AnimationLod_Culled if there is nothing to animate
+    bool update;                // sample and evaluate the skeleton this frame
+};
+
 struct CharacterJobContext
 {
     const Util::Array<Timing::Time>* times;
@@ -384,25 +409,31 @@ struct CharacterJobContext
     const Util::Array<SkeletonId>* skeletons;
     const Util::Array<Util::FixedArray<Math::mat4>>* jointPalettes;
     const Util::Array<Util::FixedArray<Math::mat4>>* scaledJointPalettes;
+    const Util::Array<Util::FixedArray<Math::mat4>>* targetJointPalettes;
     const Util::Array<Util::FixedArray<Math::mat4>>* userJoints;
-    float** tmpSamples;
-    uint** tmpSampleIndices;
-    Math::mat4** tmpJoints;
-    
+    const Util::Array<CharacterContext::AnimationLodState>* lodStates;
+    const Util::Array<IndexT>* characterNodeIndices;
+    CharacterFrame* frames;
+
     const Util::Array<Graphics::GraphicsEntityId>* entities;
-    CoreAnimation::AnimSampleMixInfo* animMixInfos;
+    Math::vec4 cameraPosition;
+    float reducedScreenSize;
+    float minimalScreenSize;
     float frameTime;
     Timing::Tick time;
     Timing::Tick ticks;
+    IndexT frameIndex;
 };
 
 //------------------------------------------------------------------------------
 /**
+    Advances the tracks of every character and picks its level of detail
+    from last frame's visibility and the size of its skin node on screen.
 */
 void
-EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+UpdateCharacterTracks(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
 {
-    N_SCOPE(EvalCharacter, Graphics);
+    N_SCOPE(UpdateCharacterTracks, Graphics);
     auto context = static_cast<CharacterJobContext*>(ctx);
     using namespace CoreAnimation;
 
@@ -412,6 +443,14 @@ EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocat
         if (index >= totalJobs)
             return;
 
+        CharacterFrame& frame = context->frames[index];
+        frame.lookahead = 0;
+        frame.poseTime = 0;
+        frame.poseClip = -1;
+        frame.poseSource = index;
+        frame.lod = AnimationLod_Culled;
+        frame.update = false;
+
         // update time, get track controller
         Timing::Time& currentTime = context->times->Get(index);
         currentTime += context->frameTime;
@@ -419,23 +458,16 @@ EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocat
         const AnimationId anim = context->anims->Get(index);
         if (anim == InvalidAnimationId)
             continue;
-        const Util::FixedArray<SkeletonJobJoint>& jobJoint = context->jobJoints->Get(index);
         const SkeletonId skeleton = context->skeletons->Get(index);
         if (skeleton == InvalidSkeletonId)
             continue;
-        const Util::FixedArray<Math::mat4>& bindPose = Characters::SkeletonGetBindPose(skeleton);
-        const Util::FixedArray<Math::mat4>& jointPalette = context->jointPalettes->Get(index);
-        const Util::FixedArray<Math::mat4>& scaledJointPalette = context->scaledJointPalettes->Get(index);
-        const Util::FixedArray<Math::vec4>& idleSamples = Characters::SkeletonGetIdleSamples(skeleton);
-        const CoreAnimation::AnimSampleBuffer& sampleBuffer = context->sampleBuffers->Get(index);
-        Math::mat4* tmpMatrices = context->tmpJoints[index];
-        float* tmpSamples = context->tmpSamples[index];
-        uint* tmpSampleIndices = context->tmpSampleIndices[index];
-        auto sampleMixInfo = context->animMixInfos + index;
-        bool runSkeletonThisFrame = false;
+        const Graphics::GraphicsEntityId entity = context->entities->Get(index);
+        if (entity == Graphics::InvalidGraphicsEntityId)
+            continue;
 
         // loop over all tracks, and update the playing clip on each respective track
-        bool firstAnimTrack = true;
+        SizeT numPlaying = 0;
+        IndexT playingTrack = InvalidIndex;
         IndexT j;
         for (j = 0; j < CharacterContext::MaxNumTracks; j++)
         {
@@ -532,108 +564,269 @@ EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocat
                     playing.sampleTime += playing.timeOffset;
                 }
 
-                // Need to compute the sample weight and pointers to "before" and "after" keys
-                const CoreAnimation::AnimClip& clip = CoreAnimation::AnimGetClip(anim, playing.clip);
-                const Ptr<AnimKeyBuffer>& buffer = AnimGetBuffer(anim);
+                playingTrack = j;
+                numPlaying++;
+            }
+        }
 
-                // Create scratch memory
-                Memory::Clear(sampleMixInfo, sizeof(AnimSampleMixInfo));
-                sampleMixInfo->sampleType = SampleType::Linear;
-                sampleMixInfo->velocityScale.set(playing.timeFactor, playing.timeFactor, playing.timeFactor, 0);
+        // If we have no animations, just skip the character skeleton update
+        if (numPlaying == 0)
+            continue;
 
-                // Get pointers to memory and size
-                const float* srcPtr = buffer->GetKeyBufferPointer();
-                const AnimKeyBuffer::Interval* srcTimePtr = buffer->GetIntervalBufferPointer();
+        // characters no observer saw last frame only keep their clocks running
+        const Models::NodeInstanceRange& range = Models::ModelContext::GetModelRenderableRange(entity);
+        const Models::ModelContext::ModelInstance::Renderable& renderables = Models::ModelContext::GetModelRenderables();
+        const IndexT node = range.begin + context->characterNodeIndices->Get(index);
+        CharacterContext::AnimationLodState& lodState = context->lodStates->Get(index);
+        if (!AnyBits(renderables.nodeFlags[node], Models::NodeInstanceFlags::NodeInstance_Visible | Models::NodeInstanceFlags::NodeInstance_AlwaysVisible))
+        {
+            lodState.lod = AnimationLod_Culled;
+            lodState.snap = true;
+            continue;
+        }
 
-                const Util::FixedArray<AnimCurve>& curves = CoreAnimation::AnimGetCurves(anim);
-                Timing::Tick evalTime = playing.sampleTime % clip.duration;
+        const Math::bbox& box = renderables.nodeBoundingBoxes[node];
+        const float viewDistance = Math::length(context->cameraPosition - Math::vec4(box.center()));
+        const float screenSize = Math::length(box.extents()) / Math::max(1.0f, viewDistance);
+        frame.lod = AnimationLodFromScreenSize(screenSize, context->reducedScreenSize, context->minimalScreenSize);
+        lodState.lod = frame.lod;
 
-                if (firstAnimTrack
-                    || playing.blend != 1.0f)
-                {
-                    if (sampleMixInfo->sampleType == SampleType::Step)
-                        AnimSampleStep(clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, srcPtr, srcTimePtr, playing.curveSampleIndices.Begin(), sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer());
-                    else
-                        AnimSampleLinear(clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, srcPtr, srcTimePtr, playing.curveSampleIndices.Begin(), sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer());
-                }
-                else // Playing with mix
-                {
-                    uchar tmpSampleCounts = 0;
-                    if (sampleMixInfo->sampleType == SampleType::Step)
-                        AnimSampleStep(clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, srcPtr, srcTimePtr, tmpSampleIndices, tmpSamples, &tmpSampleCounts);
-                    else
-                        AnimSampleLinear(clip, curves, evalTime, sampleMixInfo->velocityScale, idleSamples, srcPtr, srcTimePtr, tmpSampleIndices, tmpSamples, &tmpSampleCounts);
+        // a character which comes back into view is updated right away
+        frame.update = lodState.snap || AnimationLodIsUpdateFrame(frame.lod, context->frameIndex, index);
+        if (!frame.update)
+            continue;
 
-                    AnimMix(clip, curves.Size(), playing.mask, sampleMixInfo->mixWeight, sampleBuffer.GetSamplesPointer(), tmpSamples, sampleBuffer.GetSampleCountsPointer(), &tmpSampleCounts, sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer());
-                }
+        const SizeT period = AnimationLodUpdatePeriod(frame.lod);
+        frame.lookahead = Timing::SecondsToTicks(context->frameTime * (period - 1));
 
-                // Run skeleton as soon as we have a single anim job queued
-                runSkeletonThisFrame = true;
+        // a single clip samples the same pose as any other character playing it at the same time
+        if (numPlaying == 1)
+        {
+            const CharacterContext::AnimationRuntime& playing = trackController.playingAnimations[playingTrack];
+            const CoreAnimation::AnimClip& clip = CoreAnimation::AnimGetClip(anim, playing.clip);
+            frame.poseClip = playing.clip;
+            frame.poseTime = (playing.sampleTime + frame.lookahead) % clip.duration;
+        }
+    }
+}
 
-                // flip the first anim track flag, which will trigger the next job to mix
-                firstAnimTrack = false;
-            }
+//------------------------------------------------------------------------------
+/**
+    Characters which play a single clip of the same animation on the same
+    skeleton, at the same time and level of detail, end up with the same
+    pose, so only the first of them samples and evaluates it. This runs as
+    a single job since all characters go into one table.
+*/
+void
+ShareCharacterPoses(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    N_SCOPE(ShareCharacterPoses, Graphics);
+    auto context = static_cast<CharacterJobContext*>(ctx);
 
-        }
+    // open addressing, with at least twice as many slots as characters
+    SizeT numSlots = 16;
+    while (numSlots < totalJobs * 2)
+        numSlots <<= 1;
+    IndexT* slots = Jobs2::JobAlloc<IndexT>(numSlots);
+    memset(slots, 0xFF, numSlots * sizeof(IndexT));
 
-        // If we have no animations, just skip the character skeleton update
-        if (!runSkeletonThisFrame)
+    IndexT i;
+    for (i = 0; i < totalJobs; i++)
+    {
+        CharacterFrame& frame = context->frames[i];
+        if (!frame.update || frame.poseClip == -1)
             continue;
 
-        // Evaluate skeleton
-        const Math::mat4* invPoseMatrixBase = bindPose.Begin();
-        Math::mat4* unscaledMatrixBase = tmpMatrices;
+        const CoreAnimation::AnimationId anim = context->anims->Get(i);
+        const SkeletonId skeleton = context->skeletons->Get(i);
+        uint hash = (uint)frame.poseTime * 0x9E3779B1u;
+        hash ^= ((uint)frame.poseClip + ((uint)frame.lod << 24)) * 0x85EBCA77u;
+        hash ^= anim.HashCode() * 0xC2B2AE3Du;
+        hash ^= skeleton.HashCode() * 0x27D4EB2Fu;
 
-        Math::vec3 translate(0.0f, 0.0f, 0.0f);
-        Math::vec3 scale(1.0f, 1.0f, 1.0f);
-        Math::quat rotate;
+        IndexT slot = hash & (numSlots - 1);
+        while (slots[slot] != InvalidIndex)
+        {
+            const IndexT other = slots[slot];
+            const CharacterFrame& otherFrame = context->frames[other];
+            if (otherFrame.poseClip == frame.poseClip
+                && otherFrame.poseTime == frame.poseTime
+                && otherFrame.lod == frame.lod
+                && context->anims->Get(other) == anim
+                && context->skeletons->Get(other) == skeleton)
+                break;
+            slot = (slot + 1) & (numSlots - 1);
+        }
 
-        // load pointers from context
-        // NOTE: the samplesBase pointer may be NULL if no valid animation
-        // data exists, in this case the skeleton should simply be set
-        // to its jesus pose
-        const SkeletonJobJoint* compsBase = jobJoint.Begin();
-        n_assert(0 != compsBase);
-        const float* samplesBase = sampleBuffer.GetSamplesPointer();
-        const float* samplesPtr = samplesBase;
+        if (slots[slot] == InvalidIndex)
+            slots[slot] = i;
+        else
+            frame.poseSource = slots[slot];
+    }
+}
 
-        Math::mat4* scaledMatrixBase = scaledJointPalette.Begin();
-        Math::mat4* skinMatrixBase = jointPalette.Begin();
+//------------------------------------------------------------------------------
+/**
+    Samples and mixes the playing tracks and evaluates the skeleton of the
+    characters which update their own pose this frame. The skin palette
+    goes to the target palette, which BlendCharacterPalettes moves towards.
+*/
+void
+EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    N_SCOPE(EvalCharacter, Graphics);
+    auto context = static_cast<CharacterJobContext*>(ctx);
+    using namespace CoreAnimation;
 
-        // input samples may optionally include velocity samples which we need to skip...
-        uint sampleWidth = (sampleBuffer.GetNumSamples() / jointPalette.Size());
+    // scratch memory is reused by all characters in the group, and only grows if one needs more
+    Math::mat4* tmpMatrices = nullptr;
+    SizeT numTmpMatrices = 0;
+    float* tmpSamples = nullptr;
+    uchar* tmpSampleCounts = nullptr;
+    uint* tmpSampleIndices = nullptr;
+    SizeT numTmpSamples = 0;
+
+    for (IndexT i = 0; i < groupSize; i++)
+    {
+        IndexT index = invocationOffset + i;
+        if (index >= totalJobs)
+            return;
+
+        const CharacterFrame& frame = context->frames[index];
+        if (!frame.update || frame.poseSource != index)
+            continue;
 
-        // compute number of joints
-        int jointIndex;
-        for (jointIndex = 0; jointIndex < jointPalette.Size(); jointIndex++)
+        CharacterContext::AnimationTracks& trackController = context->tracks->Get(index);
+        const AnimationId anim = context->anims->Get(index);
+        const SkeletonId skeleton = context->skeletons->Get(index);
+        const Util::FixedArray<SkeletonJobJoint>& jobJoint = context->jobJoints->Get(index);
+        const Util::FixedArray<Math::mat4>& scaledJointPalette = context->scaledJointPalettes->Get(index);
+        const Util::FixedArray<Math::mat4>& targetJointPalette = context->targetJointPalettes->Get(index);
+        const Util::FixedArray<Math::vec4>& idleSamples = Characters::SkeletonGetIdleSamples(skeleton);
+        const CoreAnimation::AnimSampleBuffer& sampleBuffer = context->sampleBuffers->Get(index);
+        const AnimSampleMask* lodMask = Characters::SkeletonGetLodMask(skeleton, frame.lod);
+
+        if (numTmpMatrices < targetJointPalette.Size())
         {
-            static const size_t TRANSLATION_OFFSET = 0;
-            static const size_t ROTATION_OFFSET = 3;
-            static const size_t SCALE_OFFSET = 7;
+            numTmpMatrices = targetJointPalette.Size();
+            tmpMatrices = Jobs2::JobAlloc<Math::mat4>(numTmpMatrices);
+        }
 
-            translate.load(samplesPtr + TRANSLATION_OFFSET);
-            rotate.load(samplesPtr + ROTATION_OFFSET);
-            scale.load(samplesPtr + SCALE_OFFSET);
+        // Get pointers to memory and size
+        const Ptr<AnimKeyBuffer>& buffer = AnimGetBuffer(anim);
+        const float* srcPtr = buffer->GetKeyBufferPointer();
+        const ushort* srcPackedPtr = buffer->GetPackedKeyBufferPointer();
+        const AnimKeyBuffer::Interval* srcTimePtr = buffer->GetIntervalBufferPointer();
+        const Util::FixedArray<AnimCurve>& curves = CoreAnimation::AnimGetCurves(anim);
 
-            samplesPtr += sampleWidth;
+        // loop over all tracks, and sample the playing clip on each respective track
+        bool firstAnimTrack = true;
+        IndexT j;
+        for (j = 0; j < CharacterContext::MaxNumTracks; j++)
+        {
+            CharacterContext::AnimationRuntime& playing = trackController.playingAnimations[j];
+            if (playing.clip == -1)
+                continue;
 
-            const SkeletonJobJoint& comps = compsBase[jointIndex];
+            // Need to compute the sample weight and pointers to "before" and "after" keys
+            const CoreAnimation::AnimClip& clip = CoreAnimation::AnimGetClip(anim, playing.clip);
+            Timing::Tick evalTime = (playing.sampleTime + frame.lookahead) % clip.duration;
 
-            Math::mat4& unscaledMatrix = unscaledMatrixBase[jointIndex];
-            Math::mat4& scaledMatrix = scaledMatrixBase[jointIndex];
+            AnimSampleMixInfo sampleMixInfo;
+            Memory::Clear(&sampleMixInfo, sizeof(AnimSampleMixInfo));
+            sampleMixInfo.sampleType = SampleType::Linear;
+            sampleMixInfo.velocityScale.set(playing.timeFactor, playing.timeFactor, playing.timeFactor, 0);
 
-            // update unscaled matrix
-            // animation rotation
-            scaledMatrix = Math::affine(scale, rotate, translate);
-            unscaledMatrix = Math::affine(Math::vec3(1), rotate, translate);
-            if (InvalidIndex != comps.parentJointIndex)
+            if (firstAnimTrack
+                || playing.blend != 1.0f)
             {
-                const Math::mat4& parentUnscaledMatrix = unscaledMatrixBase[comps.parentJointIndex];
-                scaledMatrix = parentUnscaledMatrix * scaledMatrix;
-                unscaledMatrix = parentUnscaledMatrix * unscaledMatrix;
+                if (sampleMixInfo.sampleType == SampleType::Step)
+                    AnimSampleStep(clip, curves, evalTime, sampleMixInfo.velocityScale, idleSamples, srcPtr, srcPackedPtr, srcTimePtr, playing.curveSampleIndices.Begin(), sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer(), lodMask);
+                else
+                    AnimSampleLinear(clip, curves, evalTime, sampleMixInfo.velocityScale, idleSamples, srcPtr, srcPackedPtr, srcTimePtr, playing.curveSampleIndices.Begin(), sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer(), lodMask);
             }
+            else // Playing with mix
+            {
+                if (numTmpSamples < sampleBuffer.GetNumSamples())
+                {
+                    numTmpSamples = sampleBuffer.GetNumSamples();
+                    tmpSamples = Jobs2::JobAlloc<float>(numTmpSamples);
+                    tmpSampleCounts = Jobs2::JobAlloc<uchar>(numTmpSamples);
+                    tmpSampleIndices = Jobs2::JobAlloc<uint>(numTmpSamples);
+                }
+                memset(tmpSampleIndices, 0, clip.numCurves * sizeof(uint));
 
-            skinMatrixBase[jointIndex] = scaledMatrix * invPoseMatrixBase[jointIndex];
+                if (sampleMixInfo.sampleType == SampleType::Step)
+                    AnimSampleStep(clip, curves, evalTime, sampleMixInfo.velocityScale, idleSamples, srcPtr, srcPackedPtr, srcTimePtr, tmpSampleIndices, tmpSamples, tmpSampleCounts, lodMask);
+                else
+                    AnimSampleLinear(clip, curves, evalTime, sampleMixInfo.velocityScale, idleSamples, srcPtr, srcPackedPtr, srcTimePtr, tmpSampleIndices, tmpSamples, tmpSampleCounts, lodMask);
+
+                AnimMix(clip, curves, playing.mask, sampleMixInfo.mixWeight, sampleBuffer.GetSamplesPointer(), tmpSamples, sampleBuffer.GetSampleCountsPointer(), tmpSampleCounts, sampleBuffer.GetSamplesPointer(), sampleBuffer.GetSampleCountsPointer());
+            }
+
+            // flip the first anim track flag, which will trigger the next job to mix
+            firstAnimTrack = false;
+        }
+
+        // input samples may optionally include velocity samples which we need to skip...
+        uint sampleWidth = (sampleBuffer.GetNumSamples() / targetJointPalette.Size());
+        SkeletonEvaluate(skeleton, jobJoint.Begin(), sampleBuffer.GetSamplesPointer(), sampleWidth, tmpMatrices, scaledJointPalette.Begin(), targetJointPalette.Begin());
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Moves the joint palette of every animated character towards its target.
+    Going 1 / (period - n) of the remaining way on the n-th frame after an
+    update is the same as lerping from the palette before the update to
+    the target over the whole period, without keeping a copy of the former.
+*/
+void
+BlendCharacterPalettes(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    N_SCOPE(BlendCharacterPalettes, Graphics);
+    auto context = static_cast<CharacterJobContext*>(ctx);
+
+    for (IndexT i = 0; i < groupSize; i++)
+    {
+        IndexT index = invocationOffset + i;
+        if (index >= totalJobs)
+            return;
+
+        const CharacterFrame& frame = context->frames[index];
+        if (frame.lod == AnimationLod_Culled)
+            continue;
+
+        CharacterContext::AnimationLodState& lodState = context->lodStates->Get(index);
+        const Util::FixedArray<Math::mat4>& jointPalette = context->jointPalettes->Get(index);
+        const Util::FixedArray<Math::mat4>& targetJointPalette = context->targetJointPalettes->Get(index);
+        if (frame.update)
+        {
+            // characters sharing a pose copy it from the one which evaluated it
+            if (frame.poseSource != index)
+            {
+                const Util::FixedArray<Math::mat4>& scaledJointPalette = context->scaledJointPalettes->Get(index);
+                Memory::Copy(context->targetJointPalettes->Get(frame.poseSource).Begin(), targetJointPalette.Begin(), targetJointPalette.ByteSize());
+                Memory::Copy(context->scaledJointPalettes->Get(frame.poseSource).Begin(), scaledJointPalette.Begin(), scaledJointPalette.ByteSize());
+            }
+
+            lodState.updatePeriod = (uchar)AnimationLodUpdatePeriod(frame.lod);
+            lodState.framesSinceUpdate = 0;
+            if (lodState.snap)
+            {
+                Memory::Copy(targetJointPalette.Begin(), jointPalette.Begin(), jointPalette.ByteSize());
+                lodState.snap = false;
+                continue;
+            }
+        }
+        else if (lodState.framesSinceUpdate < lodState.updatePeriod)
+            lodState.framesSinceUpdate++;
+
+        // once the period is over the palette holds the target
+        if (lodState.framesSinceUpdate < lodState.updatePeriod)
+        {
+            const float weight = 1.0f / (lodState.updatePeriod - lodState.framesSinceUpdate);
+            Math::LerpMatrices(jointPalette.Begin(), jointPalette.Begin(), targetJointPalette.Begin(), weight, jointPalette.Size());
         }
     }
 }
@@ -654,17 +847,24 @@ CharacterContext::UpdateAnimations(const Graphics::FrameContext& ctx)
     const Util::Array<SkeletonId>& skeletons = characterContextAllocator.GetArray<Skeleton>();
     const Util::Array<Util::FixedArray<Math::mat4>>& jointPalettes = characterContextAllocator.GetArray<JointPalette>();
     const Util::Array<Util::FixedArray<Math::mat4>>& scaledJointPalettes = characterContextAllocator.GetArray<JointPaletteScaled>();
+    const Util::Array<Util::FixedArray<Math::mat4>>& targetJointPalettes = characterContextAllocator.GetArray<JointPaletteTarget>();
     const Util::Array<Util::FixedArray<Math::mat4>>& userJoints = characterContextAllocator.GetArray<UserControlledJoint>();
+    const Util::Array<AnimationLodState>& lodStates = characterContextAllocator.GetArray<AnimLod>();
     const Util::Array<Graphics::GraphicsEntityId>& models = characterContextAllocator.GetArray<EntityId>();
-    const Util::Array<bool>& supportsBlending = characterContextAllocator.GetArray<SupportMix>();
     const Util::Array<IndexT>& characterSkinNodeIndices = characterContextAllocator.GetArray<CharacterSkinNodeIndexOffset>();
 
     if (!models.IsEmpty())
     {
+        static Threading::AtomicCounter trackCounter = 0;
+        static Threading::AtomicCounter shareCounter = 0;
+        static Threading::AtomicCounter evalCounter = 0;
         static Threading::AtomicCounter animationCounter = 0;
 
         // Set total counter
         n_assert(animationCounter == 0);
+        trackCounter = 1;
+        shareCounter = 1;
+        evalCounter = 1;
         animationCounter = 1;
 
         CharacterJobContext charCtx;
@@ -676,38 +876,25 @@ CharacterContext::UpdateAnimations(const Graphics::FrameContext& ctx)
         charCtx.skeletons = &skeletons;
         charCtx.jointPalettes = &jointPalettes;
         charCtx.scaledJointPalettes = &scaledJointPalettes;
+        charCtx.targetJointPalettes = &targetJointPalettes;
         charCtx.userJoints = &userJoints;
+        charCtx.lodStates = &lodStates;
+        charCtx.characterNodeIndices = &characterSkinNodeIndices;
         charCtx.entities = &models;
+        charCtx.cameraPosition = Graphics::CameraContext::GetTransform(Graphics::CameraContext::GetLODCamera()).position;
+        charCtx.reducedScreenSize = lodReducedScreenSize;
+        charCtx.minimalScreenSize = lodMinimalScreenSize;
         charCtx.frameTime = ctx.frameTime;
         charCtx.ticks = ctx.ticks;
         charCtx.time = ctx.time;
-        charCtx.animMixInfos = Jobs2::JobAlloc<AnimSampleMixInfo>(models.Size());
-
-        charCtx.tmpJoints = Jobs2::JobAlloc<Math::mat4*>(models.Size());
-        charCtx.tmpSampleIndices = Jobs2::JobAlloc<uint*>(models.Size());
-        charCtx.tmpSamples = Jobs2::JobAlloc<float*>(models.Size());
-
-        IndexT i;
-        for (i = 0; i < models.Size(); i++)
-        {
-            if (models[i] == Graphics::InvalidGraphicsEntityId)
-                continue;
-
-            // Allocate scratch memory for character transforms
-            const Util::FixedArray<Math::mat4>& jointPalette = jointPalettes[i];
-            charCtx.tmpJoints[i] = Jobs2::JobAlloc<Math::mat4>(jointPalette.Size());
+        charCtx.frameIndex = ctx.frameIndex;
+        charCtx.frames = Jobs2::JobAlloc<CharacterFrame>(models.Size());
 
-            // Allocate scratch memory for animation mixing
-            const CoreAnimation::AnimSampleBuffer& sampleBuffer = sampleBuffers[i];
-            if (supportsBlending[i])
-            {
-                charCtx.tmpSampleIndices[i] = Jobs2::JobAlloc<uint>(jointPalette.Size() * 3);
-                charCtx.tmpSamples[i] = Jobs2::JobAlloc<float>(sampleBuffer.GetNumSamples());
-            }
-        }
-
-        // Run job
-        Jobs2::JobDispatch(EvalCharacter, models.Size(), 64, charCtx, nullptr, &animationCounter, nullptr);
+        // The level of detail needs this frame's bounding boxes, and the visibility flags of last frame
+        Jobs2::JobDispatch(UpdateCharacterTracks, models.Size(), 64, charCtx, { &Models::ModelContext::ConstantsUpdateCounter }, &trackCounter, nullptr);
+        Jobs2::JobDispatch(ShareCharacterPoses, models.Size(), charCtx, { &trackCounter }, &shareCounter, nullptr);
+        Jobs2::JobDispatch(EvalCharacter, models.Size(), 64, charCtx, { &shareCounter }, &evalCounter, nullptr);
+        Jobs2::JobDispatch(BlendCharacterPalettes, models.Size(), 64, charCtx, { &evalCounter }, &animationCounter, nullptr);
 
         n_assert(ConstantUpdateCounter == 0);
         ConstantUpdateCounter = 1;
@@ -764,10 +951,8 @@ CharacterContext::UpdateAnimations(const Graphics::FrameContext& ctx)
                 renderables.nodeStates[node].resourceTableOffsets[renderables.nodeStates[node].skinningConstantsIndex] = offset;
             }
 
-        }, characterSkinNodeIndices.Size(), 64, jobCtx, { &animationCounter }, &ConstantUpdateCounter, &CharacterContext::totalCompletionEvent);
+        }, characterSkinNodeIndices.Size(), 64, jobCtx, { &animationCounter }, &ConstantUpdateCounter, nullptr);
     }
-    else // If we have no jobs, just signal completion event
-        CharacterContext::totalCompletionEvent.Signal();
 }
 
 //------------------------------------------------------------------------------
@@ -777,7 +962,8 @@ void
 CharacterContext::WaitForCharacterJobs(const Graphics::FrameContext& ctx)
 {
     N_MARKER_BEGIN(WaitForCharacter, Graphics);
-    CharacterContext::totalCompletionEvent.Wait();
+    // the counter stays at zero if there were no jobs this frame
+    Threading::WaitForCounter(&ConstantUpdateCounter);
     N_MARKER_END();
 }
 
@@ -802,6 +988,27 @@ CharacterContext::GetAnimSampleMask(const Util::StringAtom& name)
     return &CharacterContext::masks.ValueAtIndex(name, index);
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CharacterContext::SetAnimationLodScreenSizes(float reduced, float minimal)
+{
+    n_assert(minimal <= reduced);
+    lodReducedScreenSize = reduced;
+    lodMinimalScreenSize = minimal;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+AnimationLod
+CharacterContext::GetAnimationLod(const Graphics::GraphicsEntityId id)
+{
+    const ContextEntityId cid = GetContextId(id);
+    return characterContextAllocator.Get<AnimLod>(cid.id).lod;
+}
+
 #ifndef PUBLIC_BUILD 
 //------------------------------------------------------------------------------
 /**
@@ -21,6 +21,11 @@
         Animations can be played without enqueueing, which replaces the currently
         playing animation on that track.
 
+    The update rate and the number of sampled joints follow the screen size
+    of the character, see animationlod.h, and characters which are culled
+    for every observer only advance their clocks. Characters which play a
+    single clip at the same time and level of detail share one sampled pose.
+
 
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
@@ -34,6 +39,7 @@
 #include "coreanimation/animation.h"
 #include "coreanimation/animsamplebuffer.h"
 #include "characters/skeletonjoint.h"
+#include "characters/animationlod.h"
 #include "jobs/jobs.h"
 
 namespace CoreAnimation
@@ -127,6 +133,11 @@ public:
     /// get anim sample mask by name
     static CoreAnimation::AnimSampleMask* GetAnimSampleMask(const Util::StringAtom& name);
 
+    /// set the screen sizes below which characters are animated at the reduced and minimal level, 0 keeps all characters at full
+    static void SetAnimationLodScreenSizes(float reduced, float minimal);
+    /// get the animation level of detail a character was updated with last frame
+    static AnimationLod GetAnimationLod(const Graphics::GraphicsEntityId id);
+
 #ifndef PUBLIC_DEBUG    
     /// debug rendering
     static void OnRenderDebug(uint32_t flags);
@@ -166,7 +177,10 @@ private:
     friend const bool IsExpired(const CharacterContext::AnimationRuntime& runtime, const Timing::Time time);
     friend const bool IsInfinite(const CharacterContext::AnimationRuntime& runtime);
     friend Timing::Tick GetAbsoluteStopTime(const CharacterContext::AnimationRuntime& runtime);
+    friend void UpdateCharacterTracks(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx);
+    friend void ShareCharacterPoses(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx);
     friend void EvalCharacter(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx);
+    friend void BlendCharacterPalettes(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx);
 
     static const SizeT MaxNumTracks = 16;
     struct AnimationTracks
@@ -175,6 +189,14 @@ private:
         AnimationRuntime                        playingAnimations[MaxNumTracks]; // max 16 tracks
     };
 
+    struct AnimationLodState
+    {
+        AnimationLod lod;
+        uchar updatePeriod;         // period of the last update, in frames
+        uchar framesSinceUpdate;
+        bool snap;                  // the next update replaces the joint palette instead of blending into it
+    };
+
     enum
     {
         Skeleton,
@@ -184,12 +206,14 @@ private:
         AnimTime,
         JointPalette,
         JointPaletteScaled,
+        JointPaletteTarget,
         UserControlledJoint,
         JobJoints,
         SampleBuffer,
         SupportMix,
         EntityId,
-        CharacterSkinNodeIndexOffset
+        CharacterSkinNodeIndexOffset,
+        AnimLod
     };
 
     typedef Ids::IdAllocator<
@@ -201,11 +225,13 @@ private:
         Util::FixedArray<Math::mat4>,
         Util::FixedArray<Math::mat4>,
         Util::FixedArray<Math::mat4>,
+        Util::FixedArray<Math::mat4>,
         Util::FixedArray<SkeletonJobJoint>,
         CoreAnimation::AnimSampleBuffer,
         bool,
         Graphics::GraphicsEntityId,
-        IndexT
+        IndexT,
+        AnimationLodState
     > CharacterContextAllocator;
     static CharacterContextAllocator characterContextAllocator;
 
@@ -215,7 +241,8 @@ private:
     static void Dealloc(Graphics::ContextEntityId id);
 
     static Util::HashTable<Util::StringAtom, CoreAnimation::AnimSampleMask> masks;
-    static Threading::Event totalCompletionEvent;
+    static float lodReducedScreenSize;
+    static float lodMinimalScreenSize;
 };
 
 __ImplementEnumBitOperators(CharacterContext::LoadState);
@@ -8,6 +8,99 @@ namespace Characters
 {
 
 SkeletonAllocator skeletonAllocator;
+
+//------------------------------------------------------------------------------
+/**
+    The joints at the end of a chain, like finger tips, toes and face
+    joints, barely change the silhouette of a character which is small on
+    screen. LOD mask n leaves out every joint which is at most n - 1 joints
+    away from the end of its chain, those keep their idle pose. Parents
+    always come before their children, so the distances are gathered in
+    a single pass from the back.
+*/
+static void
+SetupLodMasks(const Util::FixedArray<CharacterJoint>& joints, Util::FixedArray<CoreAnimation::AnimSampleMask>& masks)
+{
+    Util::FixedArray<IndexT> height(joints.Size(), 0);
+    IndexT i;
+    for (i = joints.Size() - 1; i >= 0; i--)
+    {
+        const IndexT parent = joints[i].parentJointIndex;
+        if (parent != InvalidIndex)
+            height[parent] = Math::max(height[parent], height[i] + 1);
+    }
+
+    masks.Resize(SkeletonNumLodMasks);
+    IndexT level;
+    for (level = 0; level < SkeletonNumLodMasks; level++)
+    {
+        CoreAnimation::AnimSampleMask& mask = masks[level];
+        mask.weights.Resize(joints.Size());
+        for (i = 0; i < joints.Size(); i++)
+        {
+            const bool root = joints[i].parentJointIndex == InvalidIndex;
+            mask.weights[i] = (root || height[i] > level) ? 1.0f : 0.0f;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Joints are evaluated in batches, so a batch must not hold a joint and
+    its parent. Going breadth first puts all joints of the same depth next
+    to each other, and a batch is only cut early when it would get the
+    parent of the next joint. The last batch is filled up by repeating its
+    last joint, which evaluates it again to the same result.
+*/
+static void
+SetupEvalOrder(const Util::FixedArray<CharacterJoint>& joints, Util::FixedArray<IndexT>& evalOrder)
+{
+    Util::FixedArray<IndexT> depth(joints.Size(), 0);
+    IndexT maxDepth = 0;
+    IndexT i;
+    for (i = 0; i < joints.Size(); i++)
+    {
+        const IndexT parent = joints[i].parentJointIndex;
+        if (parent != InvalidIndex)
+            depth[i] = depth[parent] + 1;
+        maxDepth = Math::max(maxDepth, depth[i]);
+    }
+
+    Util::Array<IndexT> order;
+    order.Reserve(joints.Size() + SkeletonEvalBatchSize);
+    Util::FixedArray<IndexT> batchOfJoint(joints.Size(), InvalidIndex);
+    IndexT batch = 0, lane = 0, level;
+    for (level = 0; level <= maxDepth; level++)
+    {
+        for (i = 0; i < joints.Size(); i++)
+        {
+            if (depth[i] != level)
+                continue;
+
+            const IndexT parent = joints[i].parentJointIndex;
+            if (lane == SkeletonEvalBatchSize || (lane > 0 && parent != InvalidIndex && batchOfJoint[parent] == batch))
+            {
+                for (; lane < SkeletonEvalBatchSize; lane++)
+                    order.Append(order.Back());
+                batch++;
+                lane = 0;
+            }
+            order.Append(i);
+            batchOfJoint[i] = batch;
+            lane++;
+        }
+    }
+    if (lane > 0)
+    {
+        for (; lane < SkeletonEvalBatchSize; lane++)
+            order.Append(order.Back());
+    }
+
+    evalOrder.Resize(order.Size());
+    for (i = 0; i < order.Size(); i++)
+        evalOrder[i] = order[i];
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -19,6 +112,8 @@ CreateSkeleton(const SkeletonCreateInfo& info)
     skeletonAllocator.Set<Skeleton_BindPose>(id, info.bindPoses);
     skeletonAllocator.Set<Skeleton_JointNameMap>(id, info.jointIndexMap);
     skeletonAllocator.Set<Skeleton_IdleSamples>(id, info.idleSamples);
+    SetupLodMasks(info.joints, skeletonAllocator.Get<Skeleton_LodMasks>(id));
+    SetupEvalOrder(info.joints, skeletonAllocator.Get<Skeleton_EvalOrder>(id));
 
     SkeletonId ret;
     ret.id24 = id;
@@ -80,4 +175,25 @@ SkeletonGetIdleSamples(const SkeletonId id)
     return skeletonAllocator.Get<Skeleton_IdleSamples>(id.id24);
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+const Util::FixedArray<IndexT>&
+SkeletonGetEvalOrder(const SkeletonId id)
+{
+    return skeletonAllocator.Get<Skeleton_EvalOrder>(id.id24);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const CoreAnimation::AnimSampleMask*
+SkeletonGetLodMask(const SkeletonId id, const IndexT level)
+{
+    n_assert(level <= SkeletonNumLodMasks);
+    if (level == 0)
+        return nullptr;
+    return &skeletonAllocator.Get<Skeleton_LodMasks>(id.id24)[level - 1];
+}
+
 } // namespace Characters
@@ -11,6 +11,8 @@
 #include "resources/resourceid.h"
 #include "util/fixedarray.h"
 #include "math/vector.h"
+#include "coreanimation/animsamplemask.h"
+#include "characters/skeletonjoint.h"
 namespace Characters
 {
 
@@ -50,19 +52,44 @@ const IndexT SkeletonGetJointIndex(const SkeletonId id, const Util::StringAtom&
 /// Get idle samples
 const Util::FixedArray<Math::vec4>& SkeletonGetIdleSamples(const SkeletonId id);
 
+/// number of reduced joint masks per skeleton
+static const SizeT SkeletonNumLodMasks = 2;
+/// get the joint mask for an animation LOD level, level 0 samples all joints and has no mask
+const CoreAnimation::AnimSampleMask* SkeletonGetLodMask(const SkeletonId id, const IndexT level);
+
+/// number of joints evaluated side by side
+static const SizeT SkeletonEvalBatchSize = 8;
+/// get the joints in evaluation order, in batches of SkeletonEvalBatchSize whose parents are all in earlier batches
+const Util::FixedArray<IndexT>& SkeletonGetEvalOrder(const SkeletonId id);
+
+/// evaluate the scaled and the skin joint palette from translation, rotation and scale samples
+void SkeletonEvaluate(
+    const SkeletonId id,
+    const SkeletonJobJoint* joints,
+    const float* samples,
+    const SizeT sampleWidth,
+    Math::mat4* tmpMatrices,
+    Math::mat4* scaledPalette,
+    Math::mat4* skinPalette
+);
+
 enum
 {
     Skeleton_Joints,
     Skeleton_BindPose,
     Skeleton_JointNameMap,
-    Skeleton_IdleSamples
+    Skeleton_IdleSamples,
+    Skeleton_LodMasks,
+    Skeleton_EvalOrder
 };
 
 typedef Ids::IdAllocator<
     Util::FixedArray<CharacterJoint>,
     Util::FixedArray<Math::mat4>,
     Util::HashTable<Util::StringAtom, IndexT>,
-    Util::FixedArray<Math::vec4>
+    Util::FixedArray<Math::vec4>,
+    Util::FixedArray<CoreAnimation::AnimSampleMask>,
+    Util::FixedArray<IndexT>
 > SkeletonAllocator;
 extern SkeletonAllocator skeletonAllocator;
 
@@ -7,12 +7,231 @@
 #include "math/vec4.h"
 #include "math/mat4.h"
 #include "characters/skeletonjoint.h"
+#include "characters/skeleton.h"
+#include "math/simdkernels.h"
+#include "math/quatx8.h"
+#include "system/cpu.h"
 #include "profiling/profiling.h"
 
 using namespace Math;
 namespace Characters
 {
 
+//------------------------------------------------------------------------------
+/**
+    Loads 4 floats at offset from each of the 8 lanes' pointers, and
+    transposes them into one float8 per component, like load_transpose()
+    does for evenly spaced elements.
+*/
+static __forceinline void
+LoadLanes(const float* const* ptrs, IndexT offset, float8& x, float8& y, float8& z, float8& w)
+{
+    const __m256 t0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptrs[0] + offset)), _mm_loadu_ps(ptrs[4] + offset), 1);
+    const __m256 t1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptrs[1] + offset)), _mm_loadu_ps(ptrs[5] + offset), 1);
+    const __m256 t2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptrs[2] + offset)), _mm_loadu_ps(ptrs[6] + offset), 1);
+    const __m256 t3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(ptrs[3] + offset)), _mm_loadu_ps(ptrs[7] + offset), 1);
+
+    const __m256 xy01 = _mm256_unpacklo_ps(t0, t1);
+    const __m256 zw01 = _mm256_unpackhi_ps(t0, t1);
+    const __m256 xy23 = _mm256_unpacklo_ps(t2, t3);
+    const __m256 zw23 = _mm256_unpackhi_ps(t2, t3);
+
+    x = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(1, 0, 1, 0));
+    y = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 2, 3, 2));
+    z = _mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(1, 0, 1, 0));
+    w = _mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Inverse of LoadLanes().
+*/
+static __forceinline void
+StoreLanes(float* const* ptrs, IndexT offset, const float8& x, const float8& y, const float8& z, const float8& w)
+{
+    const __m256 xy01 = _mm256_unpacklo_ps(x.vec, y.vec);
+    const __m256 xy23 = _mm256_unpackhi_ps(x.vec, y.vec);
+    const __m256 zw01 = _mm256_unpacklo_ps(z.vec, w.vec);
+    const __m256 zw23 = _mm256_unpackhi_ps(z.vec, w.vec);
+
+    const __m256 t0 = _mm256_shuffle_ps(xy01, zw01, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 t1 = _mm256_shuffle_ps(xy01, zw01, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m256 t2 = _mm256_shuffle_ps(xy23, zw23, _MM_SHUFFLE(1, 0, 1, 0));
+    const __m256 t3 = _mm256_shuffle_ps(xy23, zw23, _MM_SHUFFLE(3, 2, 3, 2));
+
+    _mm_storeu_ps(ptrs[0] + offset, _mm256_castps256_ps128(t0));
+    _mm_storeu_ps(ptrs[1] + offset, _mm256_castps256_ps128(t1));
+    _mm_storeu_ps(ptrs[2] + offset, _mm256_castps256_ps128(t2));
+    _mm_storeu_ps(ptrs[3] + offset, _mm256_castps256_ps128(t3));
+    _mm_storeu_ps(ptrs[4] + offset, _mm256_extractf128_ps(t0, 1));
+    _mm_storeu_ps(ptrs[5] + offset, _mm256_extractf128_ps(t1, 1));
+    _mm_storeu_ps(ptrs[6] + offset, _mm256_extractf128_ps(t2, 1));
+    _mm_storeu_ps(ptrs[7] + offset, _mm256_extractf128_ps(t3, 1));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Evaluates one batch of joints, lane i is joint batch[i]. The local
+    matrix of a joint is the same as affine(scale, rotate, translate) and
+    is never built, its rotation part goes straight into the products with
+    the rows of the parent's unscaled matrix. Roots use the identity as
+    parent, which leaves the local matrix as it is.
+*/
+static __forceinline void
+SkeletonEvaluateBatch(const IndexT* batch, const SkeletonJobJoint* joints, const float* samples, const SizeT sampleWidth, mat4* tmpMatrices, mat4* scaledPalette)
+{
+    static const size_t TRANSLATION_OFFSET = 0;
+    static const size_t ROTATION_OFFSET = 3;
+    static const size_t SCALE_OFFSET = 7;
+
+    const float* samplePtrs[SkeletonEvalBatchSize];
+    const float* parentPtrs[SkeletonEvalBatchSize];
+    float* unscaledPtrs[SkeletonEvalBatchSize];
+    float* scaledPtrs[SkeletonEvalBatchSize];
+    IndexT lane;
+    for (lane = 0; lane < SkeletonEvalBatchSize; lane++)
+    {
+        const IndexT joint = batch[lane];
+        const IndexT parent = joints[joint].parentJointIndex;
+        samplePtrs[lane] = samples + joint * sampleWidth;
+        parentPtrs[lane] = parent != InvalidIndex ? &tmpMatrices[parent].m[0][0] : &mat4::identity.m[0][0];
+        unscaledPtrs[lane] = &tmpMatrices[joint].m[0][0];
+        scaledPtrs[lane] = &scaledPalette[joint].m[0][0];
+    }
+
+    // translation, rotation and the x scale come in two loads, the last two scale components one by one
+    vec3x8 translate, scale;
+    quatx8 rotate;
+    LoadLanes(samplePtrs, TRANSLATION_OFFSET, translate.x, translate.y, translate.z, rotate.x);
+    LoadLanes(samplePtrs, ROTATION_OFFSET + 1, rotate.y, rotate.z, rotate.w, scale.x);
+    scale.y = _mm256_setr_ps(
+        samplePtrs[0][SCALE_OFFSET + 1], samplePtrs[1][SCALE_OFFSET + 1], samplePtrs[2][SCALE_OFFSET + 1], samplePtrs[3][SCALE_OFFSET + 1],
+        samplePtrs[4][SCALE_OFFSET + 1], samplePtrs[5][SCALE_OFFSET + 1], samplePtrs[6][SCALE_OFFSET + 1], samplePtrs[7][SCALE_OFFSET + 1]);
+    scale.z = _mm256_setr_ps(
+        samplePtrs[0][SCALE_OFFSET + 2], samplePtrs[1][SCALE_OFFSET + 2], samplePtrs[2][SCALE_OFFSET + 2], samplePtrs[3][SCALE_OFFSET + 2],
+        samplePtrs[4][SCALE_OFFSET + 2], samplePtrs[5][SCALE_OFFSET + 2], samplePtrs[6][SCALE_OFFSET + 2], samplePtrs[7][SCALE_OFFSET + 2]);
+
+    // rotation matrix, the same as rotationquat()
+    const float8 one(1.0f);
+    const float8 s = float8(2.0f) / dot(rotate, rotate);
+    const float8 xs = rotate.x * s, ys = rotate.y * s, zs = rotate.z * s;
+    const float8 wx = rotate.w * xs, wy = rotate.w * ys, wz = rotate.w * zs;
+    const float8 xx = rotate.x * xs, xy = rotate.x * ys, xz = rotate.x * zs;
+    const float8 yy = rotate.y * ys, yz = rotate.y * zs, zz = rotate.z * zs;
+    const float8 rotation[3][3] =
+    {
+        { one - (yy + zz), xy + wz, xz - wy },
+        { xy - wz, one - (xx + zz), yz + wx },
+        { xz + wy, yz - wx, one - (xx + yy) }
+    };
+
+    float8 parent[4][4];
+    IndexT row, column;
+    for (row = 0; row < 4; row++)
+        LoadLanes(parentPtrs, row * 4, parent[row][0], parent[row][1], parent[row][2], parent[row][3]);
+
+    // parent * local, the scaled matrix scales the columns of the rotation
+    for (row = 0; row < 3; row++)
+    {
+        const float8 sr0 = rotation[row][0] * scale.x;
+        const float8 sr1 = rotation[row][1] * scale.y;
+        const float8 sr2 = rotation[row][2] * scale.z;
+        float8 unscaled[4], scaled[4];
+        for (column = 0; column < 4; column++)
+        {
+            unscaled[column] = multiplyadd(rotation[row][0], parent[0][column], multiplyadd(rotation[row][1], parent[1][column], rotation[row][2] * parent[2][column]));
+            scaled[column] = multiplyadd(sr0, parent[0][column], multiplyadd(sr1, parent[1][column], sr2 * parent[2][column]));
+        }
+        StoreLanes(unscaledPtrs, row * 4, unscaled[0], unscaled[1], unscaled[2], unscaled[3]);
+        StoreLanes(scaledPtrs, row * 4, scaled[0], scaled[1], scaled[2], scaled[3]);
+    }
+
+    float8 position[4];
+    for (column = 0; column < 4; column++)
+        position[column] = multiplyadd(translate.x, parent[0][column], multiplyadd(translate.y, parent[1][column], multiplyadd(translate.z, parent[2][column], parent[3][column])));
+    StoreLanes(unscaledPtrs, 12, position[0], position[1], position[2], position[3]);
+    StoreLanes(scaledPtrs, 12, position[0], position[1], position[2], position[3]);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static __forceinline void
+SkeletonEvaluateImpl(const IndexT* evalOrder, SizeT numBatches, const SkeletonJobJoint* joints, const float* samples, const SizeT sampleWidth, mat4* tmpMatrices, mat4* scaledPalette)
+{
+    IndexT i;
+    for (i = 0; i < numBatches; i++)
+    {
+        SkeletonEvaluateBatch(evalOrder + i * SkeletonEvalBatchSize, joints, samples, sampleWidth, tmpMatrices, scaledPalette);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    The variants below only differ in the instruction set the inlined
+    batches are compiled for.
+*/
+static void
+SkeletonEvaluateGeneric(const IndexT* evalOrder, SizeT numBatches, const SkeletonJobJoint* joints, const float* samples, const SizeT sampleWidth, mat4* tmpMatrices, mat4* scaledPalette)
+{
+    SkeletonEvaluateImpl(evalOrder, numBatches, joints, samples, sampleWidth, tmpMatrices, scaledPalette);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX2 static void
+SkeletonEvaluateAVX2(const IndexT* evalOrder, SizeT numBatches, const SkeletonJobJoint* joints, const float* samples, const SizeT sampleWidth, mat4* tmpMatrices, mat4* scaledPalette)
+{
+    SkeletonEvaluateImpl(evalOrder, numBatches, joints, samples, sampleWidth, tmpMatrices, scaledPalette);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX512 static void
+SkeletonEvaluateAVX512(const IndexT* evalOrder, SizeT numBatches, const SkeletonJobJoint* joints, const float* samples, const SizeT sampleWidth, mat4* tmpMatrices, mat4* scaledPalette)
+{
+    SkeletonEvaluateImpl(evalOrder, numBatches, joints, samples, sampleWidth, tmpMatrices, scaledPalette);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Samples hold translation, rotation and scale per joint, followed by
+    optional velocity samples which are skipped by the sample width.
+
+    Joints are evaluated SkeletonEvalBatchSize at a time, in the batches
+    of SkeletonGetEvalOrder(), with the samples transposed into one
+    register per component. The parents of a batch are all done by then.
+*/
+void
+SkeletonEvaluate(
+    const SkeletonId id,
+    const SkeletonJobJoint* joints,
+    const float* samples,
+    const SizeT sampleWidth,
+    Math::mat4* tmpMatrices,
+    Math::mat4* scaledPalette,
+    Math::mat4* skinPalette)
+{
+    const Util::FixedArray<Math::mat4>& bindPose = SkeletonGetBindPose(id);
+    const Util::FixedArray<IndexT>& evalOrder = SkeletonGetEvalOrder(id);
+    n_assert(0 != joints);
+    n_assert(sampleWidth >= 10);
+
+    typedef void (*Func)(const IndexT*, SizeT, const SkeletonJobJoint*, const float*, const SizeT, mat4*, mat4*);
+    static const Func Table[System::Cpu::NumSimdLevels] =
+    {
+        SkeletonEvaluateGeneric,
+        SkeletonEvaluateAVX2,
+        SkeletonEvaluateAVX512
+    };
+    Table[System::Cpu::GetSimdLevel()](evalOrder.Begin(), evalOrder.Size() / SkeletonEvalBatchSize, joints, samples, sampleWidth, tmpMatrices, scaledPalette);
+
+    // the skin palette doesn't depend on the hierarchy, so it's done in one batch with the widest kernel available
+    Math::MultiplyMatrices(skinPalette, scaledPalette, bindPose.Begin(), bindPose.Size());
+}
+
 //------------------------------------------------------------------------------
 /**
 */
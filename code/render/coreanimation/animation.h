@@ -42,10 +42,12 @@ extern void AnimSampleStep(
     const Math::vec4& velocityScale,
     const Util::FixedArray<Math::vec4>& idleSamples,
     const float* srcSamplePtr,
+    const ushort* packedSamplePtr,
     const AnimKeyBuffer::Interval* intervalPtr,
     uint* outSampleKeyPtr,
     float* outSamplePtr,
-    uchar* outSampleCounts
+    uchar* outSampleCounts,
+    const AnimSampleMask* lodMask = nullptr
 );
 
 //------------------------------------------------------------------------------
@@ -58,10 +60,12 @@ extern void AnimSampleLinear(
     const Math::vec4& velocityScale,
     const Util::FixedArray<Math::vec4>& idleSamples,
     const float* srcSamplePtr,
+    const ushort* packedSamplePtr,
     const AnimKeyBuffer::Interval* intervalPtr,
     uint* outSampleKeyPtr,
     float* outSamplePtr,
-    uchar* outSampleCounts
+    uchar* outSampleCounts,
+    const AnimSampleMask* lodMask = nullptr
 );
 
 //------------------------------------------------------------------------------
@@ -69,7 +73,7 @@ extern void AnimSampleLinear(
 */
 extern void AnimMix(
     const AnimClip& clip,
-    const SizeT numSamples,
+    const Util::FixedArray<AnimCurve>& curves,
     const AnimSampleMask* mask,
     float mixWeight,
     const float* src0SamplePtr,
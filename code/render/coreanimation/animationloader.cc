@@ -33,12 +33,15 @@ AnimationLoader::InitializeResource(const Ids::Id32 entry, const Util::StringAto
     Nax3Header* naxHeader = (Nax3Header*)ptr;
     ptr += sizeof(Nax3Header);
 
-    // check magic value
-    if (FourCC(naxHeader->magic) != NEBULA_NAX3_MAGICNUMBER)
+    // check magic value, NA01 files have no packed keys
+    const bool legacy = FourCC(naxHeader->magic) == NEBULA_NAX3_LEGACY_MAGICNUMBER;
+    if (FourCC(naxHeader->magic) != NEBULA_NAX3_MAGICNUMBER && !legacy)
     {
         n_error("StreamAnimationLoader::InitializeResource(): '%s' has invalid file format (magic number doesn't match)!", stream->GetURI().AsString().AsCharPtr());
         return Resources::InvalidResourceUnknownId;
     }
+    const SizeT animSize = legacy ? offsetof(Nax3Anim, numPackedKeys) : sizeof(Nax3Anim);
+    const SizeT curveSize = legacy ? offsetof(Nax3Curve, keyFormat) : sizeof(Nax3Curve);
 
     // load animation if it has clips in it
     Util::FixedArray<CoreAnimation::AnimationId> animations(naxHeader->numAnimations);
@@ -46,7 +49,8 @@ AnimationLoader::InitializeResource(const Ids::Id32 entry, const Util::StringAto
     for (IndexT animationIndex = 0; animationIndex < naxHeader->numAnimations; animationIndex++)
     {
         Nax3Anim* anim = (Nax3Anim*)ptr;
-        ptr += sizeof(Nax3Anim);
+        ptr += animSize;
+        const SizeT numPackedKeys = legacy ? 0 : anim->numPackedKeys;
 
         Util::HashTable<Util::StringAtom, IndexT, 32> clipIndices;
         Util::FixedArray<AnimCurve> curves;
@@ -56,7 +60,7 @@ AnimationLoader::InitializeResource(const Ids::Id32 entry, const Util::StringAto
             for (IndexT curveIndex = 0; curveIndex < anim->numCurves; curveIndex++)
             {
                 Nax3Curve* naxCurve = (Nax3Curve*)ptr;
-                ptr += sizeof(Nax3Curve);
+                ptr += curveSize;
 
                 AnimCurve& curve = curves[curveIndex];
                 curve.firstIntervalOffset = naxCurve->firstIntervalOffset;
@@ -64,6 +68,12 @@ AnimationLoader::InitializeResource(const Ids::Id32 entry, const Util::StringAto
                 curve.preInfinityType = (CoreAnimation::InfinityType::Code)naxCurve->preInfinityType;
                 curve.postInfinityType = (CoreAnimation::InfinityType::Code)naxCurve->postInfinityType;
                 curve.curveType = (CoreAnimation::CurveType::Code)naxCurve->curveType;
+                if (!legacy)
+                {
+                    curve.keyFormat = (CoreAnimation::KeyFormat::Code)naxCurve->keyFormat;
+                    curve.keyOffset.loadu(naxCurve->keyOffset);
+                    curve.keyScale.loadu(naxCurve->keyScale);
+                }
             }
         }
 
@@ -113,10 +123,12 @@ AnimationLoader::InitializeResource(const Ids::Id32 entry, const Util::StringAto
 
         // Load keys
         keyBuffer = AnimKeyBuffer::Create();
-        keyBuffer->Setup(anim->numIntervals, anim->numKeys, ptr, ptr + sizeof(Nax3Interval) * anim->numIntervals);
+        uchar* keyPtr = ptr + sizeof(Nax3Interval) * anim->numIntervals;
+        uchar* packedKeyPtr = keyPtr + sizeof(float) * anim->numKeys;
+        keyBuffer->Setup(anim->numIntervals, anim->numKeys, numPackedKeys, ptr, keyPtr, packedKeyPtr);
 
         // Advance pointer by keys and timings
-        ptr += anim->numKeys * sizeof(float) + anim->numIntervals * sizeof(AnimKeyBuffer::Interval);
+        ptr = packedKeyPtr + numPackedKeys * sizeof(ushort);
 
         // Create animation
         AnimationCreateInfo info;
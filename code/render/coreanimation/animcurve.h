@@ -7,7 +7,10 @@
     AnimCurves are always part of an AnimClip object, and share properties
     with all other AnimCurves in their AnimClip object. An AnimCurve may
     be collapsed into a single key, so that AnimCurves where all keys
-    are identical don't take up any space in the animation key buffer.
+    are identical don't take up any space in the animation key buffer,
+    the key is then kept in keyOffset. Quantized curves keep their keys
+    in the packed key buffer, and keyOffset and keyScale undo the range
+    reduction of translation, scale and velocity keys.
     For performance reasons, AnimCurve's are not as flexible as their
     Maya counterparts, for instance it is not possible to set 
     the pre- and post-infinity types per curve, but only per clip.
@@ -19,6 +22,7 @@
 #include "core/types.h"
 #include "coreanimation/curvetype.h"
 #include "coreanimation/infinitytype.h"
+#include "coreanimation/animkeycompression.h"
 #include "math/vec4.h"
 
 //------------------------------------------------------------------------------
@@ -35,6 +39,9 @@ public:
     CoreAnimation::InfinityType::Code preInfinityType;
     CoreAnimation::InfinityType::Code postInfinityType;
     CurveType::Code curveType;
+    KeyFormat::Code keyFormat;
+    Math::vec4 keyOffset;
+    Math::vec4 keyScale;
 };
 
 //------------------------------------------------------------------------------
@@ -47,6 +54,9 @@ AnimCurve::AnimCurve()
     , preInfinityType(CoreAnimation::InfinityType::InvalidInfinityType)
     , postInfinityType(CoreAnimation::InfinityType::InvalidInfinityType)
     , curveType(CoreAnimation::CurveType::InvalidCurveType)
+    , keyFormat(KeyFormat::Float)
+    , keyOffset(0.0f)
+    , keyScale(0.0f)
 {
     // empty
 }
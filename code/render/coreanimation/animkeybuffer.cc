@@ -5,6 +5,7 @@
 //------------------------------------------------------------------------------
 
 #include "coreanimation/animkeybuffer.h"
+#include "coreanimation/animkeycompression.h"
 
 namespace CoreAnimation
 {
@@ -18,8 +19,10 @@ using namespace Math;
 AnimKeyBuffer::AnimKeyBuffer()
     : numKeys(0)
     , numIntervals(0)
+    , numPackedKeys(0)
     , mapCount(0)
     , keyBuffer(nullptr)
+    , packedKeyBuffer(nullptr)
     , intervalBuffer(nullptr)
 {
     // empty
@@ -41,13 +44,31 @@ AnimKeyBuffer::~AnimKeyBuffer()
 */
 void
 AnimKeyBuffer::Setup(SizeT numIntervals, SizeT numKeys, void* intervalPtr, void* keyPtr)
+{
+    this->Setup(numIntervals, numKeys, 0, intervalPtr, keyPtr, nullptr);
+}
+
+//------------------------------------------------------------------------------
+/**
+    The packed keys get padded, since unpacking reads a bit past the key.
+*/
+void
+AnimKeyBuffer::Setup(SizeT numIntervals, SizeT numKeys, SizeT numPackedKeys, void* intervalPtr, void* keyPtr, void* packedKeyPtr)
 {
     n_assert(!this->IsValid());
     this->numIntervals = numIntervals;
     this->numKeys = numKeys;
+    this->numPackedKeys = numPackedKeys;
     this->mapCount = 0;
     this->keyBuffer = (float*)Memory::Alloc(Memory::ResourceHeap, sizeof(float) * this->numKeys);
-    Memory::Copy(keyPtr, this->keyBuffer, this->GetByteSize());
+    Memory::Copy(keyPtr, this->keyBuffer, sizeof(float) * this->numKeys);
+    if (this->numPackedKeys > 0)
+    {
+        const SizeT packedByteSize = sizeof(ushort) * this->numPackedKeys;
+        this->packedKeyBuffer = (ushort*)Memory::Alloc(Memory::ResourceHeap, packedByteSize + sizeof(ushort) * PackedKeyPadding);
+        Memory::Copy(packedKeyPtr, this->packedKeyBuffer, packedByteSize);
+        Memory::Clear(this->packedKeyBuffer + this->numPackedKeys, sizeof(ushort) * PackedKeyPadding);
+    }
     this->intervalBuffer = (AnimKeyBuffer::Interval*)Memory::Alloc(Memory::ResourceHeap, sizeof(AnimKeyBuffer::Interval) * this->numIntervals);
     Memory::Copy(intervalPtr, this->intervalBuffer, sizeof(AnimKeyBuffer::Interval) * this->numIntervals);
 }
@@ -63,7 +84,13 @@ AnimKeyBuffer::Discard()
     this->keyBuffer = 0;
     Memory::Free(Memory::ResourceHeap, this->intervalBuffer);
     this->intervalBuffer = 0;
+    if (this->packedKeyBuffer != nullptr)
+    {
+        Memory::Free(Memory::ResourceHeap, this->packedKeyBuffer);
+        this->packedKeyBuffer = nullptr;
+    }
     this->numKeys = 0;
+    this->numPackedKeys = 0;
 }
 
 } // namespace CoreAnimation
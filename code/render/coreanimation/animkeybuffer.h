@@ -4,6 +4,10 @@
     @class CoreAnimation::AnimKeyBuffer
     
     A simple buffer of vec4 animation keys.
+
+    Quantized curves keep their keys in a second buffer of ushorts, see
+    animkeycompression.h. The interval keys of a curve index into the
+    buffer which matches the curve's key format.
     
     @copyright
     (C) 2008 Radon Labs GmbH
@@ -32,24 +36,32 @@ public:
     virtual ~AnimKeyBuffer();
     /// setup the buffer
     void Setup(SizeT numIntervals, SizeT numKeys, void* intervalPtr, void* keyPtr);
+    /// setup the buffer with packed keys
+    void Setup(SizeT numIntervals, SizeT numKeys, SizeT numPackedKeys, void* intervalPtr, void* keyPtr, void* packedKeyPtr);
     /// discard the buffer
     void Discard();
     /// return true if the object has been setup
     bool IsValid() const;
     /// get number of keys in buffer
     SizeT GetNumKeys() const;
+    /// get number of ushorts in the packed key buffer
+    SizeT GetNumPackedKeys() const;
     /// get buffer size in bytes
     SizeT GetByteSize() const;
     /// Get direct pointer to keys
     const float* GetKeyBufferPointer() const;
+    /// get direct pointer to packed keys
+    const ushort* GetPackedKeyBufferPointer() const;
     /// get direct pointer to interval buffer
     const AnimKeyBuffer::Interval* GetIntervalBufferPointer() const;
 
 private:
     SizeT numKeys;
     SizeT numIntervals;
+    SizeT numPackedKeys;
     uint mapCount;
     float* keyBuffer;
+    ushort* packedKeyBuffer;
     AnimKeyBuffer::Interval* intervalBuffer;
 };
 
@@ -71,13 +83,22 @@ AnimKeyBuffer::GetNumKeys() const
     return this->numKeys;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline SizeT
+AnimKeyBuffer::GetNumPackedKeys() const
+{
+    return this->numPackedKeys;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 inline SizeT
 AnimKeyBuffer::GetByteSize() const
 {
-    return this->numKeys * sizeof(float);
+    return this->numKeys * sizeof(float) + this->numPackedKeys * sizeof(ushort);
 }
 
 //------------------------------------------------------------------------------
@@ -89,6 +110,15 @@ AnimKeyBuffer::GetKeyBufferPointer() const
     return this->keyBuffer;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline const ushort*
+AnimKeyBuffer::GetPackedKeyBufferPointer() const
+{
+    return this->packedKeyBuffer;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
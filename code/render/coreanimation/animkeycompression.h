@@ -0,0 +1,147 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @file animkeycompression.h
+
+    Packing and unpacking of quantized animation keys.
+
+    A quantized key is always 3 ushorts. Rotations use the smallest three
+    encoding, the largest component of the unit quaternion is dropped and
+    rebuilt from the other three, which all lie in [-1/sqrt(2), 1/sqrt(2)]
+    and are stored with 15 bits each. The index of the dropped component
+    goes into the top bits of the first two words. Translation, scale and
+    velocity keys are reduced to the range of their curve and stored with
+    16 bits per component, the curve holds the offset and scale to undo it.
+
+    The unpack functions read 8 bytes per key, so a packed key buffer needs
+    one ushort of padding after the last key.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "core/types.h"
+#include "math/vec3.h"
+#include "math/vec4.h"
+#include "math/quat.h"
+
+//------------------------------------------------------------------------------
+namespace CoreAnimation
+{
+class KeyFormat
+{
+public:
+    /// how the keys of an animation curve are stored
+    enum Code : uchar
+    {
+        Float,          //> raw float keys in the key buffer
+        Constant,       //> no keys, the curve's key offset is the value
+        Quantized,      //> 3 ushorts per key in the packed key buffer
+    };
+};
+
+/// number of ushorts per quantized key
+static const SizeT PackedKeyStride = 3;
+/// padding in ushorts after the last packed key
+static const SizeT PackedKeyPadding = 1;
+
+/// range of the 3 smallest components of a unit quaternion
+static const float RotationKeyMin = -0.70710678f;
+static const float RotationKeyStep = 1.41421356f / 32767.0f;
+
+/// lane order which moves the rebuilt component from w to its place
+alignas(16) static const int RotationKeyShuffle[4][4] =
+{
+    { 3, 0, 1, 2 },
+    { 0, 3, 1, 2 },
+    { 0, 1, 3, 2 },
+    { 0, 1, 2, 3 },
+};
+
+//------------------------------------------------------------------------------
+/**
+    Pack a unit quaternion, the largest component is made positive since
+    q and -q describe the same rotation.
+*/
+inline void
+PackRotationKey(const Math::quat& rotation, ushort* key)
+{
+    const float components[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+    int largest = 0;
+    IndexT i;
+    for (i = 1; i < 4; i++)
+    {
+        if (Math::abs(components[i]) > Math::abs(components[largest]))
+            largest = i;
+    }
+    const float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    IndexT word = 0;
+    for (i = 0; i < 4; i++)
+    {
+        if (i == largest)
+            continue;
+        const float value = (components[i] * sign - RotationKeyMin) / RotationKeyStep;
+        key[word++] = (ushort)Math::clamp((int)(value + 0.5f), 0, 32767);
+    }
+    key[0] |= (ushort)((largest & 1) << 15);
+    key[1] |= (ushort)((largest >> 1) << 15);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Pack a vector key into the range described by offset and scale, a
+    component with a scale of zero is always packed as zero.
+*/
+inline void
+PackVectorKey(const float* value, const Math::vec4& offset, const Math::vec4& scale, ushort* key)
+{
+    IndexT i;
+    for (i = 0; i < 3; i++)
+    {
+        if (scale[i] > 0.0f)
+        {
+            const float quantized = (value[i] - offset[i]) / scale[i];
+            key[i] = (ushort)Math::clamp((int)(quantized + 0.5f), 0, 65535);
+        }
+        else
+            key[i] = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Unpack a smallest three rotation key.
+*/
+__forceinline Math::quat
+UnpackRotationKey(const ushort* key)
+{
+    const __m128i words = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)key));
+    const __m128i components = _mm_and_si128(words, _mm_setr_epi32(0x7fff, 0x7fff, 0x7fff, 0));
+    const int largest = (key[0] >> 15) | ((key[1] >> 15) << 1);
+
+    // the mask zeroes w, so it doesn't count for the dot product
+    const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    const Math::vec4 step(_mm_and_ps(_mm_set1_ps(RotationKeyStep), mask));
+    const Math::vec4 offset(_mm_and_ps(_mm_set1_ps(RotationKeyMin), mask));
+    const Math::vec4 xyz = Math::multiplyadd(Math::vec4(_mm_cvtepi32_ps(components)), step, offset);
+
+    const __m128 lengthSq = _mm_dp_ps(xyz.vec, xyz.vec, 0x7F);
+    const __m128 w = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.0f), lengthSq), _mm_setzero_ps()));
+    const __m128 xyzw = _mm_blend_ps(xyz.vec, w, 0x8);
+    return Math::quat(_mm_permutevar_ps(xyzw, _mm_load_si128((const __m128i*)RotationKeyShuffle[largest])));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Unpack a range reduced vector key, w is zero as long as the w of the
+    offset and scale are.
+*/
+__forceinline Math::vec3
+UnpackVectorKey(const ushort* key, const Math::vec4& offset, const Math::vec4& scale)
+{
+    const __m128i words = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)key));
+    return Math::vec3(Math::multiplyadd(Math::vec4(_mm_cvtepi32_ps(words)), scale, offset).vec);
+}
+
+} // namespace CoreAnimation
+//------------------------------------------------------------------------------
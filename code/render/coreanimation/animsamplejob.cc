@@ -7,6 +7,8 @@
 #include "animkeybuffer.h"
 #include "animcurve.h"
 #include "animclip.h"
+#include "animkeycompression.h"
+#include "math/batch.h"
 
 using namespace Math;
 namespace CoreAnimation
@@ -64,6 +66,60 @@ FindNextInterval(
 
 //------------------------------------------------------------------------------
 /**
+    Load a vector key from the buffer which matches the curve's key format.
+*/
+static __forceinline Math::vec3
+LoadVectorKey(const AnimCurve& curve, const float* srcSamplePtr, const ushort* packedSamplePtr, uint key)
+{
+    if (curve.keyFormat == KeyFormat::Quantized)
+        return UnpackVectorKey(&packedSamplePtr[key], curve.keyOffset, curve.keyScale);
+
+    Math::vec3 v;
+    v.loadu(&srcSamplePtr[key]);
+    return v;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Load a rotation key from the buffer which matches the curve's key format.
+*/
+static __forceinline Math::quat
+LoadRotationKey(const AnimCurve& curve, const float* srcSamplePtr, const ushort* packedSamplePtr, uint key)
+{
+    if (curve.keyFormat == KeyFormat::Quantized)
+        return UnpackRotationKey(&packedSamplePtr[key]);
+
+    Math::quat q;
+    q.loadu(&srcSamplePtr[key]);
+    return q;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Curves of joints left out by a LOD mask aren't sampled, they output
+    the idle sample and count as inactive. The mask holds one weight per
+    joint, and each joint has a translation, rotation and scale curve.
+*/
+static inline bool
+SkipCurve(const AnimSampleMask* lodMask, IndexT curveIndex, const Math::vec4& idleSample, float*& outSamplePtr, uchar*& outSampleCounts, uint*& lastUsedIntervalPtr, int stride)
+{
+    if (lodMask == nullptr || lodMask->weights[curveIndex / 3] != 0.0f)
+        return false;
+
+    if (stride == 4)
+        idleSample.storeu(outSamplePtr);
+    else
+        xyz(idleSample).storeu(outSamplePtr);
+    outSamplePtr += stride;
+    *outSampleCounts++ = 0;
+    ++lastUsedIntervalPtr;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Constant curves have no intervals, but they are still active and
+    output their key.
 */
 void
 AnimSampleStep(
@@ -73,21 +129,27 @@ AnimSampleStep(
     const vec4& velocityScale,
     const Util::FixedArray<Math::vec4>& idleSamples,
     const float* srcSamplePtr,
+    const ushort* packedSamplePtr,
     const AnimKeyBuffer::Interval* intervalPtr,
     uint* lastUsedIntervalPtr,
     float* outSamplePtr,
-    uchar* outSampleCounts)
+    uchar* outSampleCounts,
+    const AnimSampleMask* lodMask)
 {
     int i;
     for (i = 0; i < clip.numCurves; i ++)
     {
         const AnimCurve& curve = curves[clip.firstCurve + i];
-        const bool activeCurve = curve.numIntervals > 0;
+        if (SkipCurve(lodMask, i, idleSamples[i], outSamplePtr, outSampleCounts, lastUsedIntervalPtr, curve.curveType == CurveType::Rotation ? 4 : 3))
+            continue;
+
+        const bool hasKeys = curve.numIntervals > 0;
+        const bool activeCurve = hasKeys || curve.keyFormat == KeyFormat::Constant;
         int stride = 0;
 
         uint key = *lastUsedIntervalPtr;
         AnimKeyBuffer::Interval currentTime = intervalPtr[key];
-        if (activeCurve)
+        if (hasKeys)
         {
             AnimKeyBuffer::Interval curveLastTime = intervalPtr[curve.firstIntervalOffset + curve.numIntervals - 1];
             Timing::Tick wrappedTime = WrapTime(curve, time, curveLastTime.end);
@@ -98,10 +160,12 @@ AnimSampleStep(
         {
             case CurveType::Rotation:
             {
-                if (activeCurve)
-                    memcpy(outSamplePtr, &srcSamplePtr[currentTime.key0], 4 * sizeof(float));
+                if (hasKeys)
+                    LoadRotationKey(curve, srcSamplePtr, packedSamplePtr, currentTime.key0).storeu(outSamplePtr);
+                else if (activeCurve)
+                    curve.keyOffset.storeu(outSamplePtr);
                 else
-                    idleSamples[i].store(outSamplePtr);
+                    idleSamples[i].storeu(outSamplePtr);
                 stride = 4;
                 break;
             }
@@ -109,10 +173,12 @@ AnimSampleStep(
             case CurveType::Velocity:
             case CurveType::Translation:
             {
-                if (activeCurve)
-                    memcpy(outSamplePtr, &srcSamplePtr[currentTime.key0], 3 * sizeof(float));
+                if (hasKeys)
+                    LoadVectorKey(curve, srcSamplePtr, packedSamplePtr, currentTime.key0).storeu(outSamplePtr);
+                else if (activeCurve)
+                    xyz(curve.keyOffset).storeu(outSamplePtr);
                 else
-                    idleSamples[i].store(outSamplePtr);
+                    idleSamples[i].storeu(outSamplePtr);
                 stride = 3;
                 break;
             }
@@ -138,6 +204,57 @@ AnimSampleStep(
 
 //------------------------------------------------------------------------------
 /**
+    Rotation curves waiting to be interpolated. They are collected while
+    walking the curves and run through the batched quaternion functions
+    8 at a time, then written back to their place in the sample buffer.
+*/
+struct QuatBatch
+{
+    static const SizeT Size = 8;
+    typedef void (*InterpolateFunc)(Math::quat*, const Math::quat*, const Math::quat*, const Math::scalar*, SizeT);
+
+    Math::quat from[Size];
+    Math::quat to[Size];
+    float weights[Size];
+    float* dst[Size];
+    SizeT count;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+FlushQuatBatch(QuatBatch& batch, QuatBatch::InterpolateFunc interpolate)
+{
+    Math::quat result[QuatBatch::Size];
+    interpolate(result, batch.from, batch.to, batch.weights, batch.count);
+
+    IndexT i;
+    for (i = 0; i < batch.count; i++)
+        result[i].storeu(batch.dst[i]);
+    batch.count = 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static inline void
+PushQuatBatch(QuatBatch& batch, QuatBatch::InterpolateFunc interpolate, const Math::quat& from, const Math::quat& to, float weight, float* dst)
+{
+    batch.from[batch.count] = from;
+    batch.to[batch.count] = to;
+    batch.weights[batch.count] = weight;
+    batch.dst[batch.count] = dst;
+    if (++batch.count == QuatBatch::Size)
+        FlushQuatBatch(batch, interpolate);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Rotations are slerped in batches of 8 with Math::SlerpQuats, the
+    output of a rotation curve is only valid after the final flush.
+    Quantized keys are unpacked in registers right before they are
+    interpolated, so they are never written out at full precision.
 */
 void 
 AnimSampleLinear(
@@ -147,23 +264,32 @@ AnimSampleLinear(
     const vec4& velocityScale,
     const Util::FixedArray<Math::vec4>& idleSamples,
     const float* srcSamplePtr,
+    const ushort* packedSamplePtr,
     const AnimKeyBuffer::Interval* intervalPtr,
     uint* lastUsedIntervalPtr,
     float* outSamplePtr,
-    uchar* outSampleCounts)
+    uchar* outSampleCounts,
+    const AnimSampleMask* lodMask)
 {
+    QuatBatch rotations;
+    rotations.count = 0;
+
     int i;
     for (i = 0; i < clip.numCurves; i++)
     {
         const AnimCurve& curve = curves[clip.firstCurve + i];
-        const bool activeCurve = curve.numIntervals > 0;
+        if (SkipCurve(lodMask, i, idleSamples[i], outSamplePtr, outSampleCounts, lastUsedIntervalPtr, curve.curveType == CurveType::Rotation ? 4 : 3))
+            continue;
+
+        const bool hasKeys = curve.numIntervals > 0;
+        const bool activeCurve = hasKeys || curve.keyFormat == KeyFormat::Constant;
 
         float sampleWeight = 0.0f;
         int stride = 0;
 
         uint key = *lastUsedIntervalPtr;
         AnimKeyBuffer::Interval currentTime = intervalPtr[key];
-        if (activeCurve)
+        if (hasKeys)
         {
             AnimKeyBuffer::Interval curveLastTime = intervalPtr[curve.firstIntervalOffset + curve.numIntervals - 1];
             Timing::Tick wrappedTime = WrapTime(curve, time, curveLastTime.end);
@@ -179,18 +305,16 @@ AnimSampleLinear(
         {
             case CurveType::Rotation:
             {
-                Math::quat q0;
-                if (activeCurve)
+                if (hasKeys)
                 {
-                    Math::quat q1;
-                    q0.load(&srcSamplePtr[currentTime.key0]);
-                    q1.load(&srcSamplePtr[currentTime.key1]);
-                    q0 = Math::slerp(q0, q1, sampleWeight);
+                    const Math::quat q0 = LoadRotationKey(curve, srcSamplePtr, packedSamplePtr, currentTime.key0);
+                    const Math::quat q1 = LoadRotationKey(curve, srcSamplePtr, packedSamplePtr, currentTime.key1);
+                    PushQuatBatch(rotations, Math::SlerpQuats, q0, q1, sampleWeight, outSamplePtr);
                 }
+                else if (activeCurve)
+                    curve.keyOffset.storeu(outSamplePtr);
                 else
-                    q0 = idleSamples[i].vec;
-
-                q0.store(outSamplePtr);
+                    idleSamples[i].storeu(outSamplePtr);
                 stride = 4;
                 break;
             }
@@ -199,17 +323,18 @@ AnimSampleLinear(
             case CurveType::Translation:
             {
                 Math::vec3 v0;
-                if (activeCurve)
+                if (hasKeys)
                 {
-                    Math::vec3 v1;
-                    v0.load(&srcSamplePtr[currentTime.key0]);
-                    v1.load(&srcSamplePtr[currentTime.key1]);
+                    v0 = LoadVectorKey(curve, srcSamplePtr, packedSamplePtr, currentTime.key0);
+                    const Math::vec3 v1 = LoadVectorKey(curve, srcSamplePtr, packedSamplePtr, currentTime.key1);
                     v0 = Math::lerp(v0, v1, sampleWeight);
                 }
+                else if (activeCurve)
+                    v0 = xyz(curve.keyOffset);
                 else
                     v0 = xyz(idleSamples[i]);
 
-                v0.store(outSamplePtr);
+                v0.storeu(outSamplePtr);
                 stride = 3;
                 break;
             }
@@ -231,15 +356,24 @@ AnimSampleLinear(
         *lastUsedIntervalPtr = key;
         ++lastUsedIntervalPtr;
     }
+
+    if (rotations.count > 0)
+        FlushQuatBatch(rotations, Math::SlerpQuats);
 }
 
 //------------------------------------------------------------------------------
 /**
+    Mixes the samples curve by curve, the sample counts hold one entry per
+    curve. Vectors are lerped, rotations are nlerped along the shorter arc
+    in batches of 8 with Math::NlerpQuats, which keeps them normalized.
+
+    The mask holds one weight per joint, and each joint has a translation,
+    rotation and scale curve.
 */
 void 
 AnimMix(
     const AnimClip& clip,
-    const SizeT numSamples,
+    const Util::FixedArray<AnimCurve>& curves,
     const AnimSampleMask* mask,
     float mixWeight,
     const float* src0SamplePtr,
@@ -249,9 +383,14 @@ AnimMix(
     float* outSamplePtr,
     uchar* outSampleCounts)
 {
+    QuatBatch rotations;
+    rotations.count = 0;
+
     int i;
-    for (i = 0; i < numSamples; i++)
+    for (i = 0; i < clip.numCurves; i++)
     {
+        const AnimCurve& curve = curves[clip.firstCurve + i];
+        const int stride = curve.curveType == CurveType::Rotation ? 4 : 3;
         uchar src0Count = src0SampleCounts[i];
         uchar src1Count = src1SampleCounts[i];
 
@@ -261,21 +400,32 @@ AnimMix(
         if ((src0Count > 0) && (src1Count > 0))
         {
             float maskWeight = 1;
+            if (mask != nullptr) maskWeight = mask->weights[i / 3];
 
-            // we have 4 curves per joint
-            if (mask != 0) maskWeight = mask->weights[i / 4];
-
-            *outSamplePtr = Math::lerp(*src0SamplePtr, *src1SamplePtr, mixWeight * maskWeight);
+            if (curve.curveType == CurveType::Rotation)
+            {
+                Math::quat q0, q1;
+                q0.loadu(src0SamplePtr);
+                q1.loadu(src1SamplePtr);
+                PushQuatBatch(rotations, Math::NlerpQuats, q0, q1, mixWeight * maskWeight, outSamplePtr);
+            }
+            else
+            {
+                Math::vec3 v0, v1;
+                v0.loadu(src0SamplePtr);
+                v1.loadu(src1SamplePtr);
+                Math::lerp(v0, v1, mixWeight * maskWeight).store(outSamplePtr);
+            }
         }
         else if (src0Count > 0)
         {
             // only "left" sample is valid
-            *outSamplePtr = *src0SamplePtr;
+            memmove(outSamplePtr, src0SamplePtr, stride * sizeof(float));
         }
         else if (src1Count > 0)
         {
             // only "right" sample is valid
-            *outSamplePtr = *src1SamplePtr;
+            memmove(outSamplePtr, src1SamplePtr, stride * sizeof(float));
         }
         else
         {
@@ -284,10 +434,13 @@ AnimMix(
         }
 
         // update pointers
-        src0SamplePtr++;
-        src1SamplePtr++;
-        outSamplePtr++;
+        src0SamplePtr += stride;
+        src1SamplePtr += stride;
+        outSamplePtr += stride;
     }
+
+    if (rotations.count > 0)
+        FlushQuatBatch(rotations, Math::NlerpQuats);
 }
 
 } // namespace CoreAnimation
@@ -15,13 +15,18 @@ namespace CoreAnimation
 {
 #pragma pack(push, 1)
 
-#define NEBULA_NAX3_MAGICNUMBER 'NA01'
+#define NEBULA_NAX3_MAGICNUMBER 'NA02'
+#define NEBULA_NAX3_LEGACY_MAGICNUMBER 'NA01'
 
 //------------------------------------------------------------------------------
 /** 
     NAX3 file format structs.
 
     NOTE: keep all header-structs 4-byte aligned!
+
+    NA02 files append the packed key count to Nax3Anim and the key format
+    to Nax3Curve, and store the packed keys as ushorts after the float
+    keys. NA01 files stop at the members marked as such.
 */
 struct Nax3Header
 {
@@ -36,6 +41,7 @@ struct Nax3Anim
     ushort numEvents;
     uint numKeys;
     uint numIntervals;
+    uint numPackedKeys;             // NA02, number of ushorts in the packed keys
 };
 
 struct Nax3Interval
@@ -73,6 +79,9 @@ struct Nax3Curve
     uchar preInfinityType;          // CoreAnimation::InfinityType::Code
     uchar postInfinityType;         // CoreAnimation::InfinityType::Code
     uchar curveType;                // CoreAnimation::CurveType::Code
+    uchar keyFormat;                // NA02, CoreAnimation::KeyFormat::Code
+    float keyOffset[4];             // NA02
+    float keyScale[4];              // NA02
 };
 
 //------------------------------------------------------------------------------
@@ -35,6 +35,7 @@ extern bool MeshShadersSupported;
 struct GraphicsDeviceCreateInfo
 {
     uint64 globalConstantBufferMemorySize;
+    uint64 globalPersistentConstantBufferMemorySize;    // constants which survive frames, placed before the per frame constants
     uint64 globalVertexBufferMemorySize;
     uint64 globalIndexBufferMemorySize;
     uint64 globalUploadMemorySize;
@@ -96,7 +97,9 @@ struct GraphicsDeviceState
     Util::FixedArray<CoreGraphics::SemaphoreId> renderingFinishedSemaphores;
 
     uint globalConstantBufferMaxValue;
+    uint globalPersistentConstantBufferSize;
     Util::FixedArray<CoreGraphics::BufferId> globalConstantBuffer;
+    Memory::RangeAllocator persistentConstantAllocator;
 
     CoreGraphics::ResourceTableId tickResourceTableGraphics;
     CoreGraphics::ResourceTableId tickResourceTableCompute;
@@ -198,6 +201,10 @@ void LockConstantUpdates();
 void SetConstantsInternal(ConstantBufferOffset offset, const void* data, SizeT size);
 /// Reserve range of constant buffer memory and return offset
 ConstantBufferOffset AllocateConstantBufferMemory(uint size);
+/// Reserve range of constant buffer memory which isn't reset between frames, it has to be written once in every buffered frame
+Memory::RangeAllocation AllocatePersistentConstantBufferMemory(uint size);
+/// Free persistent constant buffer memory
+void DeallocatePersistentConstantBufferMemory(const Memory::RangeAllocation& alloc);
 
 /// return id to global graphics constant buffer
 CoreGraphics::BufferId GetConstantBuffer(IndexT i);
@@ -185,6 +185,26 @@ MeshLoader::LodMask(const Ids::Id32 entry, float lod) const
     return 0x3;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Bit 0 is the vertex data and bit 1 the index data, see StreamResource
+*/
+uint64
+MeshLoader::LodBytes(const Ids::Id32 entry, uint bits) const
+{
+    const MeshStreamData* streamData = (const MeshStreamData*)this->streams[entry].data;
+    if (streamData == nullptr)
+        return 0;
+
+    auto header = (const Nvx3Header*)streamData->mappedData;
+    uint64 bytes = 0;
+    if (AllBits(bits, 1 << 0))
+        bytes += header->vertexDataSize;
+    if (AllBits(bits, 1 << 1))
+        bytes += header->indexDataSize;
+    return bytes;
+}
+
 //------------------------------------------------------------------------------
 /**
     Setup the mesh resource from a nvx3 file (Nebula's
@@ -44,6 +44,8 @@ private:
     void Unload(const Resources::ResourceId id) override;
     /// Create load mask based on LOD
     uint LodMask(const Ids::Id32 entry, float lod) const override;
+    /// Get the amount of vertex and index memory in the mask
+    uint64 LodBytes(const Ids::Id32 entry, uint bits) const override;
 
     /// setup mesh from nvx3 file in memory
     void SetupMeshFromNvx(const Ptr<IO::Stream>& stream, const Ids::Id32 entry, const MeshResourceId meshResource);
@@ -291,4 +291,52 @@ TextureLoader::LodMask(const Ids::Id32 entry, float lod) const
     return mask;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+uint64
+TextureLoader::LodBytes(const Ids::Id32 entry, uint bits) const
+{
+    const TextureStreamData* streamData = static_cast<const TextureStreamData*>(this->streams[entry].data);
+    if (streamData == nullptr)
+        return 0;
+
+    // Bit 0 is the lowest mip, same as in LoadMips
+    uint64 bytes = 0;
+    while (bits != 0x0)
+    {
+        uint mipIndex = Util::FirstOne(bits);
+        bits &= ~(1 << mipIndex);
+        if (mipIndex >= streamData->numMips)
+            break;
+
+        uint mip = streamData->numMips - 1 - mipIndex;
+        for (uint layer = 0; layer < streamData->numLayers; layer++)
+            bytes += streamData->ctx.image_size(layer, mip);
+    }
+    return bytes;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The view is clamped to the remaining mips, which are the ones the texture
+    was created with, and the dropped ones are uploaded again when requested.
+*/
+uint
+TextureLoader::EvictLod(const Resources::ResourceId& id, uint loadedBits, uint keepBits)
+{
+    uint remaining = loadedBits & keepBits;
+    if (remaining == loadedBits || remaining == 0x0)
+        return loadedBits;
+
+    TextureStreamData* streamData = static_cast<TextureStreamData*>(this->streams[id.loaderInstanceId].data);
+    TextureId texture;
+    texture.resourceId = id.resourceId;
+    texture.resourceType = id.resourceType;
+    TextureIdAcquire(texture);
+    TextureSetHighestLod(texture, streamData->numMips - 1 - Util::LastOne(remaining));
+    TextureIdRelease(texture);
+    return remaining;
+}
+
 } // namespace CoreGraphics
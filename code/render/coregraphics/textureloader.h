@@ -36,6 +36,10 @@ private:
 
     /// Create load mask based on LOD
     uint LodMask(const Ids::Id32 entry, float lod) const override;
+    /// Get the size of the mips in the mask
+    uint64 LodBytes(const Ids::Id32 entry, uint bits) const override;
+    /// Drop the mips streamed in on top of the base LOD
+    uint EvictLod(const Resources::ResourceId& id, uint loadedBits, uint keepBits) override;
 };
 
 } // namespace CoreGraphics
@@ -1079,16 +1079,19 @@ CreateGraphicsDevice(const GraphicsDeviceCreateInfo& info)
     {
         Vulkan::GraphicsDeviceState::ConstantsRingBuffer& cboRing = state.constantBufferRings[i];
         cboRing.allowConstantAllocation = true;
-        cboRing.endAddress = 0;
-        cboRing.gfx.flushedStart = cboRing.cmp.flushedStart = 0;
+        cboRing.endAddress = info.globalPersistentConstantBufferMemorySize;
+        cboRing.gfx.flushedStart = cboRing.cmp.flushedStart = cboRing.endAddress;
     }
 
     BufferCreateInfo cboInfo;
-        
-    state.globalConstantBufferMaxValue = info.globalConstantBufferMemorySize;
+
+    // The persistent constants sit at the start of every buffered constant buffer, the per frame ring after them
+    state.globalPersistentConstantBufferSize = info.globalPersistentConstantBufferMemorySize;
+    state.globalConstantBufferMaxValue = info.globalPersistentConstantBufferMemorySize + info.globalConstantBufferMemorySize;
+    state.persistentConstantAllocator = Memory::RangeAllocator(info.globalPersistentConstantBufferMemorySize, 0xFFFF);
 
     cboInfo.name = "Global Constant Buffer";
-    cboInfo.byteSize = info.globalConstantBufferMemorySize;
+    cboInfo.byteSize = state.globalConstantBufferMaxValue;
     cboInfo.mode = CoreGraphics::BufferAccessMode::DeviceAndHost;
     cboInfo.usageFlags = CoreGraphics::ConstantBuffer | CoreGraphics::TransferBufferDestination;
     state.globalConstantBuffer.Resize(info.numBufferedFrames);
@@ -1642,6 +1645,31 @@ AllocateConstantBufferMemory(uint size)
     return ret;
 }
 
+static Threading::CriticalSection persistentConstantAllocationMutex;
+
+//------------------------------------------------------------------------------
+/**
+*/
+Memory::RangeAllocation
+AllocatePersistentConstantBufferMemory(uint size)
+{
+    Threading::CriticalScope scope(&persistentConstantAllocationMutex);
+    uint alignment = state.deviceProps[state.currentDevice].properties.limits.minUniformBufferOffsetAlignment;
+    Memory::RangeAllocation alloc = state.persistentConstantAllocator.Alloc(Math::align(size, alignment), alignment);
+    n_assert2(alloc.offset != alloc.OOM, "Out of persistent constant memory, increase GraphicsDeviceCreateInfo::globalPersistentConstantBufferMemorySize");
+    return alloc;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+DeallocatePersistentConstantBufferMemory(const Memory::RangeAllocation& alloc)
+{
+    Threading::CriticalScope scope(&persistentConstantAllocationMutex);
+    state.persistentConstantAllocator.Dealloc(alloc);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -2135,7 +2163,7 @@ NewFrame()
 
     // update constant buffer offsets
     Vulkan::GraphicsDeviceState::ConstantsRingBuffer& nextCboRing = state.constantBufferRings[state.currentBufferedFrameIndex];
-    nextCboRing.endAddress = 0;
+    nextCboRing.endAddress = state.globalPersistentConstantBufferSize;
     nextCboRing.gfx.flushedStart = nextCboRing.cmp.flushedStart = nextCboRing.endAddress;
 
     Vulkan::GraphicsDeviceState::UploadRingBuffer& nextUploadRing = state.uploadRingBuffers[state.currentBufferedFrameIndex];
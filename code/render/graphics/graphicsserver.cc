@@ -64,6 +64,7 @@ GraphicsServer::Open()
 
     CoreGraphics::GraphicsDeviceCreateInfo gfxInfo {
         .globalConstantBufferMemorySize = 16_MB,
+        .globalPersistentConstantBufferMemorySize = 8_MB,
         .globalVertexBufferMemorySize = 64_MB,
         .globalIndexBufferMemorySize = 64_MB,
         .globalUploadMemorySize = 100_MB,
@@ -240,7 +240,7 @@ MaterialAddLODTexture(const MaterialId mat, const Resources::ResourceId tex)
 /**
 */
 void
-MaterialSetLowestLod(const MaterialId mat, float lod)
+MaterialSetLowestLod(const MaterialId mat, float lod, float priority)
 {
     Threading::CriticalScope scope(&materialTextureLoadSection);
     Util::Array<Resources::ResourceId>& textures = materialAllocator.Get<Material_LODTextures>(mat.resourceId);
@@ -251,7 +251,7 @@ MaterialSetLowestLod(const MaterialId mat, float lod)
 
     for (IndexT i = 0; i < textures.Size(); i++)
     {
-        Resources::SetMinLod(textures[i], lod, false);
+        Resources::SetMinLod(textures[i], lod, false, priority);
     }
 }
 
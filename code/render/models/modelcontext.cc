@@ -11,7 +11,8 @@
 #include "visibility/visibilitycontext.h"
 #include "profiling/profiling.h"
 #include "graphics/cameracontext.h"
-#include "threading/lockfreequeue.h"
+#include "threading/mpmcqueue.h"
+#include "threading/criticalsection.h"
 #include "materials/material.h"
 
 #include "objects_shared.h"
@@ -21,6 +22,11 @@
 #include "dynui/im3d/im3dcontext.h"
 #endif
 
+N_DECLARE_COUNTER(N_MODEL_INSTANCES_UPDATED, Model Instances Updated);
+N_DECLARE_COUNTER(N_MODEL_INSTANCES_SKIPPED, Model Instances Skipped);
+N_DECLARE_COUNTER(N_MODEL_CONSTANTS_UPDATED, Model Constants Updated);
+N_DECLARE_COUNTER(N_MODEL_CONSTANTS_SKIPPED, Model Constants Skipped);
+
 using namespace Graphics;
 using namespace Resources;
 namespace Models
@@ -32,14 +38,35 @@ __ImplementContext(ModelContext, ModelContext::modelContextAllocator);
 
 Threading::AtomicCounter ModelContext::ConstantsUpdateCounter = 0;
 Threading::AtomicCounter ModelContext::TransformsUpdateCounter = 0;
+Threading::AtomicCounter ModelContext::LodUpdateCounter = 0;
 
 Memory::RangeAllocator ModelContext::TransformInstanceAllocator, ModelContext::RenderInstanceAllocator;
 
 Util::Dictionary<Models::ModelNode*, ModelContext::MaterialInstanceContext> ModelContext::materialInstanceContexts;
 
-Threading::Event ModelContext::completionEvent;
 
-Threading::LockFreeQueue<std::function<void()>> setupCompleteQueue;
+Threading::MpmcQueue<std::function<void()>> setupCompleteQueue;
+/// callbacks which didn't fit in the queue, the main thread also queues and must never wait for itself to make room
+Threading::CriticalSection setupCompleteOverflowLock;
+Util::Array<std::function<void()>> setupCompleteOverflow;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+QueueSetupComplete(const std::function<void()>& callback)
+{
+    if (!setupCompleteQueue.TryEnqueue(callback))
+    {
+        Threading::CriticalScope lock(&setupCompleteOverflowLock);
+        setupCompleteOverflow.Append(callback);
+    }
+}
+
+#if NEBULA_ENABLE_PROFILING
+/// instances and constants updated and skipped by the jobs, reported at the start of the next update
+static Threading::AtomicCounter instancesUpdated = 0, instancesSkipped = 0, constantsUpdated = 0, constantsSkipped = 0;
+#endif
 
 //------------------------------------------------------------------------------
 /**
@@ -123,6 +150,7 @@ ModelContext::Setup(const Graphics::GraphicsEntityId gfxId, const Resources::Res
             NodeInstances.transformable.nodeParents.Resize(transformRange.end);
             NodeInstances.transformable.origTransforms.Resize(transformRange.end);
             NodeInstances.transformable.nodeTransforms.Resize(transformRange.end);
+            NodeInstances.transformable.nodeOccluders.Resize(transformRange.end);
         }
         
         for (SizeT i = 0; i < transformNodes.Size(); i++)
@@ -137,6 +165,7 @@ ModelContext::Setup(const Graphics::GraphicsEntityId gfxId, const Resources::Res
             trans.setscalepivot(tNode->scalePivot);
             NodeInstances.transformable.origTransforms[index] = trans.getmatrix();
             NodeInstances.transformable.nodeTransforms[index] = trans.getmatrix();
+            NodeInstances.transformable.nodeOccluders[index] = tNode->GetOccluder().indices.IsEmpty() ? nullptr : &tNode->GetOccluder();
             if (tNode->parent != nullptr)
                 NodeInstances.transformable.nodeParents[index] = nodeLookup[tNode->parent];
             else
@@ -169,6 +198,8 @@ ModelContext::Setup(const Graphics::GraphicsEntityId gfxId, const Resources::Res
             NodeInstances.renderable.nodePrimitiveGroup.Resize(stateRange.end);
             NodeInstances.renderable.nodeDrawModifiers.Resize(stateRange.end); // Base 1 instance 0 offset
             NodeInstances.renderable.nodeSortId.Resize(stateRange.end);
+            NodeInstances.renderable.nodePersistentConstants.Resize(stateRange.end);
+            NodeInstances.renderable.nodeConstantsPending.Resize(stateRange.end);
 
 #if NEBULA_GRAPHICS_DEBUG
             NodeInstances.renderable.nodeNames.Resize(stateRange.end);
@@ -219,7 +250,7 @@ ModelContext::Setup(const Graphics::GraphicsEntityId gfxId, const Resources::Res
             NodeInstances.renderable.nodeLodDistances[index] = sNode->useLodDistances ? Util::MakeTuple(sNode->minDistance, sNode->maxDistance) : Util::MakeTuple(FLT_MAX, FLT_MAX);
             NodeInstances.renderable.nodeLods[index] = 0.0f;
             NodeInstances.renderable.textureLods[index] = FLT_MAX;
-            NodeInstances.renderable.nodeFlags[index] = Models::NodeInstanceFlags::NodeInstance_Active;
+            NodeInstances.renderable.nodeFlags[index] = Models::NodeInstanceFlags::NodeInstance_Active | Models::NodeInstanceFlags::NodeInstance_Moved;
             NodeInstances.renderable.nodeMaterials[index] = sNode->material;
             NodeInstances.renderable.nodeShaderConfigs[index] = MaterialGetShaderConfig(sNode->material);
             NodeInstances.renderable.nodeTypes[index] = sNode->GetType();
@@ -227,6 +258,8 @@ ModelContext::Setup(const Graphics::GraphicsEntityId gfxId, const Resources::Res
             NodeInstances.renderable.nodeMeshes[index] = sNode->GetMesh();
             NodeInstances.renderable.nodePrimitiveGroup[index] = sNode->GetPrimitiveGroup();
             NodeInstances.renderable.nodeDrawModifiers[index] = Util::MakeTuple(1, 0); // Base 1 instance 0 offset
+            NodeInstances.renderable.nodePersistentConstants[index] = Memory::RangeAllocation{ .offset = Memory::RangeAllocation::OOM, .node = 0 };
+            NodeInstances.renderable.nodeConstantsPending[index] = 0;
 
             modelContextAllocator.Get<Model_NodeLookup>(cid.id).Add(sNode->GetName(), i);
 
@@ -246,7 +279,7 @@ ModelContext::Setup(const Graphics::GraphicsEntityId gfxId, const Resources::Res
 
         // add the callbacks to a lockfree queue, and dequeue and call them when it's safe
         if (finishedCallback != nullptr)
-            setupCompleteQueue.Enqueue(finishedCallback);
+            QueueSetupComplete(finishedCallback);
     };
 
     Resources::CreateResource(name, tag, successCallback, successCallback, false);
@@ -281,6 +314,7 @@ ModelContext::Setup(
     NodeInstances.transformable.origTransforms.Append(Math::mat4());
     NodeInstances.transformable.nodeTransforms.Append(transform);
     NodeInstances.transformable.nodeParents.Append(UINT32_MAX);
+    NodeInstances.transformable.nodeOccluders.Append(nullptr);
     roots.Append(0);
 
      // Setup node states
@@ -308,7 +342,7 @@ ModelContext::Setup(
     NodeInstances.renderable.nodeLodDistances.Append(Util::MakeTuple(FLT_MAX, FLT_MAX));
     NodeInstances.renderable.nodeLods.Append(0.0f);
     NodeInstances.renderable.textureLods.Append(1.0f);
-    NodeInstances.renderable.nodeFlags.Append(Models::NodeInstanceFlags::NodeInstance_Active);
+    NodeInstances.renderable.nodeFlags.Append(Models::NodeInstanceFlags::NodeInstance_Active | Models::NodeInstanceFlags::NodeInstance_Moved);
     NodeInstances.renderable.nodeMaterials.Append(material);
     NodeInstances.renderable.nodeShaderConfigs.Append(MaterialGetShaderConfig(material));
     NodeInstances.renderable.nodeTypes.Append(Models::PrimitiveNodeType);
@@ -316,6 +350,8 @@ ModelContext::Setup(
     NodeInstances.renderable.nodeMeshes.Append(mesh);
     NodeInstances.renderable.nodePrimitiveGroup.Append(MeshGetPrimitiveGroup(mesh, primitiveGroup));
     NodeInstances.renderable.nodeDrawModifiers.Append(Util::MakeTuple(1, 0)); // Base 1 instance 0 offset
+    NodeInstances.renderable.nodePersistentConstants.Append(Memory::RangeAllocation{ .offset = Memory::RangeAllocation::OOM, .node = 0 });
+    NodeInstances.renderable.nodeConstantsPending.Append(0);
 
     modelContextAllocator.Get<Model_NodeLookup>(cid.id).Add(debugName, 0);
 
@@ -350,7 +386,7 @@ ModelContext::ChangeModel(const Graphics::GraphicsEntityId gfxId, const Resource
         const Math::mat4& pending = modelContextAllocator.Get<Model_Transform>(cid.id);
         
         if (finishedCallback != nullptr)
-            setupCompleteQueue.Enqueue(finishedCallback);
+            QueueSetupComplete(finishedCallback);
     };
 
     Resources::ResourceId model = Resources::CreateResource(name, tag, successCallback, successCallback, true);
@@ -389,6 +425,29 @@ ModelContext::SetTransform(const Graphics::GraphicsEntityId id, const Math::mat4
     hasPending = true;
 }
 
+//------------------------------------------------------------------------------
+/**
+    Static models keep their object constants in persistent constant memory,
+    which is only rewritten when the model moves or its LOD fade changes.
+    Models are dynamic by default.
+*/
+void
+ModelContext::SetStatic(const Graphics::GraphicsEntityId id, bool isStatic)
+{
+    const ContextEntityId cid = GetContextId(id);
+    modelContextAllocator.Set<Model_Static>(cid.id, isStatic);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+bool
+ModelContext::IsStatic(const Graphics::GraphicsEntityId id)
+{
+    const ContextEntityId cid = GetContextId(id);
+    return modelContextAllocator.Get<Model_Static>(cid.id);
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -581,17 +640,39 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
     while (setupCompleteQueue.Dequeue(callback))
         callback();
 
+    // callbacks may set up more models, so run the overflow outside of the lock
+    Util::Array<std::function<void()>> overflow;
+    setupCompleteOverflowLock.Enter();
+    overflow = std::move(setupCompleteOverflow);
+    setupCompleteOverflowLock.Leave();
+    IndexT i;
+    for (i = 0; i < overflow.Size(); i++)
+        overflow[i]();
+
     N_SCOPE(UpdateTransforms, Models);
+
+#if NEBULA_ENABLE_PROFILING
+    // report what the previous frame's jobs updated and skipped
+    N_COUNTER_SET(N_MODEL_INSTANCES_UPDATED, Threading::Interlocked::Exchange(&instancesUpdated, 0));
+    N_COUNTER_SET(N_MODEL_INSTANCES_SKIPPED, Threading::Interlocked::Exchange(&instancesSkipped, 0));
+    N_COUNTER_SET(N_MODEL_CONSTANTS_UPDATED, Threading::Interlocked::Exchange(&constantsUpdated, 0));
+    N_COUNTER_SET(N_MODEL_CONSTANTS_SKIPPED, Threading::Interlocked::Exchange(&constantsSkipped, 0));
+#endif
+
     const Util::Array<NodeInstanceRange>& nodeInstanceTransformRanges = modelContextAllocator.GetArray<Model_NodeInstanceTransform>();
     const Util::Array<NodeInstanceRange>& nodeInstanceStateRanges = modelContextAllocator.GetArray<Model_NodeInstanceStates>();
     const Util::Array<Util::Array<uint32>>& nodeInstanceRoots = modelContextAllocator.GetArray<Model_NodeInstanceRoots>();
     Util::Array<Math::bbox>& instanceBoxes = NodeInstances.renderable.nodeBoundingBoxes;
     Util::Array<Math::mat4>& pending = modelContextAllocator.GetArray<Model_Transform>();
     Util::Array<bool>& hasPending = modelContextAllocator.GetArray<Model_Dirty>();
+    const Util::Array<bool>& isStatic = modelContextAllocator.GetArray<Model_Static>();
 
-    // get the lod camera
+    // get the lod camera, LODs of instances which didn't move only change if it moved
     Graphics::GraphicsEntityId lodCamera = Graphics::CameraContext::GetLODCamera();
     const Math::mat4& cameraTransform = Graphics::CameraContext::GetTransform(lodCamera);
+    static Math::vec4 lastCameraPosition = Math::vec4(FLT_MAX);
+    const bool cameraMoved = cameraTransform.position != lastCameraPosition;
+    lastCameraPosition = cameraTransform.position;
 
     n_assert(TransformsUpdateCounter == 0);
     TransformsUpdateCounter = 1;
@@ -599,11 +680,13 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
     struct TransformUpdateContext
     {
         const Util::Array<NodeInstanceRange>* nodeInstanceTransformRanges;
+        const Util::Array<NodeInstanceRange>* nodeInstanceStateRanges;
         const Util::Array<Util::Array<uint32>>* nodeInstanceRoots;
         Util::Array<Math::mat4>* pending;
         Util::Array<bool>* hasPending;
     } transCtx;
     transCtx.nodeInstanceTransformRanges = &nodeInstanceTransformRanges;
+    transCtx.nodeInstanceStateRanges = &nodeInstanceStateRanges;
     transCtx.nodeInstanceRoots = &nodeInstanceRoots;
     transCtx.pending = &pending;
     transCtx.hasPending = &hasPending;
@@ -640,13 +723,17 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
                     Math::mat4 orig = NodeInstances.transformable.origTransforms[j];
                     NodeInstances.transformable.nodeTransforms[j] = parentTransform * orig;
                 }
+
+                // Flag the nodes for the bounding box, LOD and constant updates
+                const NodeInstanceRange& stateRange = context->nodeInstanceStateRanges->Get(index);
+                for (j = stateRange.begin; j < stateRange.end; j++)
+                    NodeInstances.renderable.nodeFlags[j] = SetBits(NodeInstances.renderable.nodeFlags[j], Models::NodeInstanceFlags::NodeInstance_Moved);
             }
         }
     }, nodeInstanceTransformRanges.Size(), 256, transCtx, nullptr, &TransformsUpdateCounter, nullptr);
 
-    static Threading::AtomicCounter lodUpdateCounter = 0;
-    n_assert(lodUpdateCounter == 0);
-    lodUpdateCounter = 1;
+    n_assert(LodUpdateCounter == 0);
+    LodUpdateCounter = 1;
 
     struct LodUpdateContext
     {
@@ -654,56 +741,80 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
         const Util::Array<NodeInstanceRange>* nodeInstanceStateRanges;
         Util::Array<Math::bbox>* instanceBoxes;
         Math::mat4 cameraTransform;
+        bool cameraMoved;
+        uint8 numBufferedFrames;
     } renderCtx;
     renderCtx.nodeInstanceTransformRanges = &nodeInstanceTransformRanges;
     renderCtx.nodeInstanceStateRanges = &nodeInstanceStateRanges;
     renderCtx.instanceBoxes = &instanceBoxes;
     renderCtx.cameraTransform = cameraTransform;
+    renderCtx.cameraMoved = cameraMoved;
+    renderCtx.numBufferedFrames = CoreGraphics::GetNumBufferedFrames();
 
     Jobs2::JobDispatch([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
     {
         N_SCOPE(ModelLodUpdate, Graphics);
         auto context = static_cast<LodUpdateContext*>(ctx);
+        SizeT numUpdated = 0, numSkipped = 0;
         for (IndexT i = 0; i < groupSize; i++)
         {
             IndexT index = i + invocationOffset;
             if (index >= totalJobs)
-                return;
+                break;
 
             const NodeInstanceRange& stateRange = context->nodeInstanceStateRanges->Get(index);
             const NodeInstanceRange& transformRange = context->nodeInstanceTransformRanges->Get(index);
             SizeT j;
             for (j = stateRange.begin; j < stateRange.end; j++)
             {
-                Math::mat4 transform = NodeInstances.transformable.nodeTransforms[transformRange.begin + NodeInstances.renderable.nodeTransformIndex[j]];
-                Math::bbox box = NodeInstances.renderable.origBoundingBoxes[j];
-                box.affine_transform(transform);
-                NodeInstances.renderable.nodeBoundingBoxes[j] = box;
-
                 Models::PrimitiveNode* primitiveNode = static_cast<Models::PrimitiveNode*>(NodeInstances.renderable.nodes[j]);
                 NodeInstances.renderable.nodeMeshes[j] = primitiveNode->GetMesh();
                 NodeInstances.renderable.nodePrimitiveGroup[j] = primitiveNode->GetPrimitiveGroup();
 
-                // calculate view vector to calculate LOD
-                Math::vec4 viewVector = context->cameraTransform.position - transform.position;
+                Models::NodeInstanceFlags nodeFlag = NodeInstances.renderable.nodeFlags[j];
+                const bool moved = AllBits(nodeFlag, Models::NodeInstanceFlags::NodeInstance_Moved);
+
+                // Neither the instance nor the camera moved, the box, LOD and constants still hold
+                if (!moved && !context->cameraMoved)
+                {
+                    numSkipped++;
+                    continue;
+                }
+
+                Math::mat4 transform = NodeInstances.transformable.nodeTransforms[transformRange.begin + NodeInstances.renderable.nodeTransformIndex[j]];
+                if (moved)
+                {
+                    Math::bbox box = NodeInstances.renderable.origBoundingBoxes[j];
+                    box.affine_transform(transform);
+                    NodeInstances.renderable.nodeBoundingBoxes[j] = box;
+                    numUpdated++;
+                }
+                else
+                    numSkipped++;
+
+                // calculate view vector to calculate LOD, from the center of the box as the visibility contribution system does
+                Math::vec4 viewVector = context->cameraTransform.position - Math::vec4(NodeInstances.renderable.nodeBoundingBoxes[j].center());
                 float viewDistance = length(viewVector);
                 float textureLod = Math::max(0.0f, (viewDistance - 10.0f) / 30.5f);
 
                 if (textureLod < NodeInstances.renderable.textureLods[j])
                 {
+                    // Prioritize streaming by the approximate screen size of the instance
+                    float screenSize = length(NodeInstances.renderable.nodeBoundingBoxes[j].extents()) / Math::max(1.0f, viewDistance);
+
                     // Notify materials system this LOD might be used (this is a bit shitty in comparison to actually using texture sampling feedback)
-                    Materials::MaterialSetLowestLod(NodeInstances.renderable.nodeMaterials[j], textureLod);
+                    Materials::MaterialSetLowestLod(NodeInstances.renderable.nodeMaterials[j], textureLod, screenSize);
                     NodeInstances.renderable.textureLods[j] = textureLod;
                 }
 
-                Models::NodeInstanceFlags nodeFlag = NodeInstances.renderable.nodeFlags[j];
-
                 // Calculate if object should be culled due to LOD
                 const auto& [min, max] = NodeInstances.renderable.nodeLodDistances[j];
                 float lodFactor = 0.0f;
                 if (min < FLT_MAX || max < FLT_MAX)
                 {
-                    lodFactor = (viewDistance - (min + 1.5f)) / (max - (min + 1.5f));
+                    // Nodes outside of their LOD range aren't drawn at all, since the draw lists leave out nodes without
+                    // NodeInstance_LodActive, so the factor is clamped and the constants stay unchanged outside of the fade range
+                    lodFactor = Math::clamp((viewDistance - (min + 1.5f)) / (max - (min + 1.5f)), 0.0f, 1.0f);
                     if (viewDistance >= min && viewDistance < max)
                         nodeFlag = SetBits(nodeFlag, Models::NodeInstanceFlags::NodeInstance_LodActive);
                     else
@@ -713,15 +824,22 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
                     // If not, make the lod active by default
                     nodeFlag = SetBits(nodeFlag, Models::NodeInstanceFlags::NodeInstance_LodActive);
 
+                // Object constants of static instances are rewritten in every buffered frame once they change
+                if (moved || lodFactor != NodeInstances.renderable.nodeLods[j])
+                    NodeInstances.renderable.nodeConstantsPending[j] = context->numBufferedFrames;
+
                 // Set the flags back
-                NodeInstances.renderable.nodeFlags[j] = nodeFlag;
+                NodeInstances.renderable.nodeFlags[j] = UnsetBits(nodeFlag, Models::NodeInstanceFlags::NodeInstance_Moved);
 
                 // Set LOD factor for dithering and other shader effects
                 NodeInstances.renderable.nodeLods[j] = lodFactor;
-
             }
         }
-    }, nodeInstanceStateRanges.Size(), 256, renderCtx, { &TransformsUpdateCounter }, &lodUpdateCounter, nullptr);
+#if NEBULA_ENABLE_PROFILING
+        Threading::Interlocked::Add(&instancesUpdated, numUpdated);
+        Threading::Interlocked::Add(&instancesSkipped, numSkipped);
+#endif
+    }, nodeInstanceStateRanges.Size(), 256, renderCtx, { &TransformsUpdateCounter }, &LodUpdateCounter, nullptr);
 
     n_assert(ConstantsUpdateCounter == 0);
     ConstantsUpdateCounter = 1;
@@ -730,23 +848,55 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
     {
         const Util::Array<NodeInstanceRange>* nodeInstanceTransformRanges;
         const Util::Array<NodeInstanceRange>* nodeInstanceStateRanges;
-    };
+        const Util::Array<bool>* isStatic;
+    } constCtx;
+    constCtx.nodeInstanceTransformRanges = &nodeInstanceTransformRanges;
+    constCtx.nodeInstanceStateRanges = &nodeInstanceStateRanges;
+    constCtx.isStatic = &isStatic;
 
     Jobs2::JobDispatch([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
     {
         N_SCOPE(ModelConstantUpdate, Graphics);
         auto context = static_cast<ConstantUpdateContext*>(ctx);
+        SizeT numUpdated = 0, numSkipped = 0;
         for (IndexT i = 0; i < groupSize; i++)
         {
             IndexT index = i + invocationOffset;
             if (index >= totalJobs)
-                return;
+                break;
 
             const NodeInstanceRange& stateRange = context->nodeInstanceStateRanges->Get(index);
             const NodeInstanceRange& transformRange = context->nodeInstanceTransformRanges->Get(index);
+            const bool isStatic = context->isStatic->Get(index);
             SizeT j;
             for (j = stateRange.begin; j < stateRange.end; j++)
             {
+                NodeInstanceState& state = NodeInstances.renderable.nodeStates[j];
+                Memory::RangeAllocation& persistent = NodeInstances.renderable.nodePersistentConstants[j];
+                uint8& pendingFrames = NodeInstances.renderable.nodeConstantsPending[j];
+                if (isStatic)
+                {
+                    if (persistent.offset == Memory::RangeAllocation::OOM)
+                    {
+                        persistent = CoreGraphics::AllocatePersistentConstantBufferMemory(sizeof(ObjectsShared::ObjectBlock));
+                        pendingFrames = CoreGraphics::GetNumBufferedFrames();
+                    }
+
+                    // Every buffered constant buffer holds the current constants, the offset from before is still valid
+                    if (pendingFrames == 0)
+                    {
+                        numSkipped++;
+                        continue;
+                    }
+                    pendingFrames--;
+                }
+                else if (persistent.offset != Memory::RangeAllocation::OOM)
+                {
+                    // No longer static, go back to per frame constants
+                    CoreGraphics::DeallocatePersistentConstantBufferMemory(persistent);
+                    persistent.offset = Memory::RangeAllocation::OOM;
+                }
+
                 Math::mat4 transform = NodeInstances.transformable.nodeTransforms[transformRange.begin + NodeInstances.renderable.nodeTransformIndex[j]];
 
                 // Allocate object constants
@@ -756,11 +906,23 @@ ModelContext::UpdateTransforms(const Graphics::FrameContext& ctx)
                 block.DitherFactor = NodeInstances.renderable.nodeLods[j];
                 block.ObjectId = j;
 
-                uint offset = CoreGraphics::SetConstants(block);
-                NodeInstances.renderable.nodeStates[j].resourceTableOffsets[NodeInstances.renderable.nodeStates[j].objectConstantsIndex] = offset;
+                uint offset;
+                if (isStatic)
+                {
+                    offset = persistent.offset;
+                    CoreGraphics::SetConstants(offset, block);
+                }
+                else
+                    offset = CoreGraphics::SetConstants(block);
+                state.resourceTableOffsets[state.objectConstantsIndex] = offset;
+                numUpdated++;
             }
         }
-    }, nodeInstanceStateRanges.Size(), 256, renderCtx, { &lodUpdateCounter }, &ConstantsUpdateCounter, &ModelContext::completionEvent);
+#if NEBULA_ENABLE_PROFILING
+        Threading::Interlocked::Add(&constantsUpdated, numUpdated);
+        Threading::Interlocked::Add(&constantsSkipped, numSkipped);
+#endif
+    }, nodeInstanceStateRanges.Size(), 256, constCtx, { &LodUpdateCounter }, &ConstantsUpdateCounter, nullptr);
 }
 
 //------------------------------------------------------------------------------
@@ -770,7 +932,7 @@ void
 ModelContext::WaitForWork(const Graphics::FrameContext& ctx)
 {
     N_SCOPE(WaitForModels, Graphics);
-    ModelContext::completionEvent.Wait();
+    Threading::WaitForCounter(&ConstantsUpdateCounter);
 }
 
 //------------------------------------------------------------------------------
@@ -12,9 +12,11 @@
 #include "resources/resourceid.h"
 #include "resources/resourceserver.h"
 #include "coregraphics/resourcetable.h"
+#include "coregraphics/graphicsdevice.h"
 #include "materials/shaderconfigserver.h"
 #include "model.h"
 #include "nodes/modelnode.h"
+#include "nodes/transformnode.h"
 
 namespace Jobs
 {
@@ -51,7 +53,7 @@ enum class NodeInstanceFlags
     , NodeInstance_LodActive = N_BIT(2)         // If set, the node's LOD is active
     , NodeInstance_AlwaysVisible = N_BIT(3)     // Should always resolve to being visible by visibility
     , NodeInstance_Visible = N_BIT(4)           // Set to true if any observer sees it
-    , NodeInstance_Moved = N_BIT(5)
+    , NodeInstance_Moved = N_BIT(5)             // Set when the transform changed, cleared when the bounding box and LOD have followed
 };
 __ImplementEnumBitOperators(NodeInstanceFlags);
 
@@ -91,6 +93,10 @@ public:
 
     /// set the transform for a model
     static void SetTransform(const Graphics::GraphicsEntityId id, const Math::mat4& transform);
+    /// mark a model as static, its object constants are kept across frames and only rewritten when it moves
+    static void SetStatic(const Graphics::GraphicsEntityId id, bool isStatic);
+    /// get if a model is static
+    static bool IsStatic(const Graphics::GraphicsEntityId id);
     /// get the transform for a model
     static Math::mat4 GetTransform(const Graphics::GraphicsEntityId id);
     /// get the transform for a model
@@ -141,6 +147,7 @@ public:
             Util::PinnedArray<0xFFFF, Math::mat4> origTransforms;
             Util::PinnedArray<0xFFFF, Math::mat4> nodeTransforms;
             Util::PinnedArray<0xFFFF, uint32> nodeParents;
+            Util::PinnedArray<0xFFFF, const Models::Occluder*> nodeOccluders;     // occluder of the transform node, or nullptr
         } transformable;
 
         /// The bounding boxes are used by visibility and the states by rendering
@@ -162,6 +169,8 @@ public:
             Util::PinnedArray<0xFFFF, CoreGraphics::MeshId> nodeMeshes;
             Util::PinnedArray<0xFFFF, CoreGraphics::PrimitiveGroup> nodePrimitiveGroup;
             Util::PinnedArray<0xFFFF, Util::Tuple<uint32, uint32>> nodeDrawModifiers;
+            Util::PinnedArray<0xFFFF, Memory::RangeAllocation> nodePersistentConstants;   // object constants of static models
+            Util::PinnedArray<0xFFFF, uint8> nodeConstantsPending;                        // buffered frames with outdated object constants
 
             Util::PinnedArray<0xFFFF, void*> nodeSpecialData;
 #if NEBULA_GRAPHICS_DEBUG
@@ -196,6 +205,8 @@ public:
 
     static Threading::AtomicCounter ConstantsUpdateCounter;
     static Threading::AtomicCounter TransformsUpdateCounter;
+    /// done when the node bounding boxes and lods for this frame are written
+    static Threading::AtomicCounter LodUpdateCounter;
 
 private:
     friend class Visibility::VisibilityContext;
@@ -212,7 +223,8 @@ private:
         Model_NodeInstanceStates,
         Model_NodeLookup,
         Model_Transform,
-        Model_Dirty
+        Model_Dirty,
+        Model_Static
     };
     typedef Ids::IdAllocator<
         Resources::ResourceId,
@@ -221,14 +233,13 @@ private:
         NodeInstanceRange,
         Util::Dictionary<Util::StringAtom, IndexT>,
         Math::mat4,         // pending transforms
-        bool                // transform is dirty
+        bool,               // transform is dirty
+        bool                // model doesn't move, object constants persist across frames
     > ModelContextAllocator;
     static ModelContextAllocator modelContextAllocator;
 
     static Util::Dictionary<Models::ModelNode*, MaterialInstanceContext> materialInstanceContexts;
 
-    static Threading::Event completionEvent;
-
     /// allocate a new slice for this context
     static Graphics::ContextEntityId Alloc();
     /// deallocate a slice
@@ -259,8 +270,26 @@ ModelContext::Dealloc(Graphics::ContextEntityId id)
 
     modelContextAllocator.Get<Model_NodeInstanceRoots>(id.id).Clear();
     modelContextAllocator.Get<Model_NodeLookup>(id.id).Clear();
-    TransformInstanceAllocator.Dealloc(modelContextAllocator.Get<Model_NodeInstanceTransform>(id.id).allocation);
-    RenderInstanceAllocator.Dealloc(modelContextAllocator.Get<Model_NodeInstanceStates>(id.id).allocation);
+    // the occluders belong to the model resource, so they mustn't be seen once it's discarded
+    NodeInstanceRange& transformRange = modelContextAllocator.Get<Model_NodeInstanceTransform>(id.id);
+    for (IndexT i = transformRange.begin; i < transformRange.end; i++)
+        NodeInstances.transformable.nodeOccluders[i] = nullptr;
+    TransformInstanceAllocator.Dealloc(transformRange.allocation);
+
+    // release the object constants of static nodes
+    NodeInstanceRange& stateRange = modelContextAllocator.Get<Model_NodeInstanceStates>(id.id);
+    for (IndexT i = stateRange.begin; i < stateRange.end; i++)
+    {
+        Memory::RangeAllocation& constants = NodeInstances.renderable.nodePersistentConstants[i];
+        if (constants.offset != Memory::RangeAllocation::OOM)
+        {
+            CoreGraphics::DeallocatePersistentConstantBufferMemory(constants);
+            constants.offset = Memory::RangeAllocation::OOM;
+        }
+    }
+    RenderInstanceAllocator.Dealloc(stateRange.allocation);
+    stateRange.begin = stateRange.end = 0;
+    modelContextAllocator.Set<Model_Static>(id.id, false);
 
     modelContextAllocator.Dealloc(id.id);
 }
@@ -101,22 +101,14 @@ CharacterNode::Load(const Util::FourCC& fourcc, const Util::StringAtom& tag, con
     {
         StringAtom maskName = reader->ReadString();
         SizeT num = reader->ReadInt();
-        IndexT i;
-        for (i = 0; i < num; i++)
-        {
-            reader->ReadFloat();
-        }
+        reader->Skip(num * sizeof(float));
         /*
         CharacterJointMask mask;
         StringAtom maskName = reader->ReadString();
         SizeT num = reader->ReadInt();
         Util::FixedArray<scalar> weights;
         weights.Resize(num);
-        IndexT i;
-        for (i = 0; i < num; i++)
-        {
-            weights[i] = reader->ReadFloat();
-        }
+        reader->ReadArray(weights.Begin(), num);
         mask.SetName(maskName);
         mask.SetWeights(weights);
         this->character->Skeleton().AddJointMask(mask);
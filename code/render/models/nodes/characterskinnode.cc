@@ -50,14 +50,8 @@ CharacterSkinNode::Load(const Util::FourCC& fourcc, const Util::StringAtom& tag,
     {
         // SkinFragment
         this->loadContext.primIndex = reader->ReadInt();
-        Array<IndexT> jointPalette;
         SizeT numJoints = reader->ReadInt();
-        jointPalette.Reserve(numJoints);
-        IndexT i;
-        for (i = 0; i < numJoints; i++)
-        {
-            jointPalette.Append(reader->ReadInt());
-        }
+        Array<IndexT> jointPalette = reader->ReadArray<IndexT>(numJoints);
         this->AddFragment(this->loadContext.primIndex, jointPalette);
     }
     else
@@ -103,6 +103,24 @@ TransformNode::Load(const Util::FourCC& fourcc, const Util::StringAtom& tag, con
         this->minDistance = Math::min(this->minDistance, this->maxDistance);
         this->useLodDistances = true;
     }
+    else if (FourCC('OCCL') == fourcc)
+    {
+        // occluder, vertex positions followed by triangle indices
+        const SizeT numVertices = reader->ReadInt();
+        this->occluder.vertices.Reserve(numVertices);
+        this->occluder.boundingBox.begin_extend();
+        IndexT i;
+        for (i = 0; i < numVertices; i++)
+        {
+            const float x = reader->ReadFloat();
+            const float y = reader->ReadFloat();
+            const float z = reader->ReadFloat();
+            this->occluder.vertices.Append(Math::vec3(x, y, z));
+            this->occluder.boundingBox.extend(this->occluder.vertices.Back());
+        }
+        this->occluder.boundingBox.end_extend();
+        this->occluder.indices = reader->ReadUIntArray();
+    }
     else
     {
         retval = ModelNode::Load(fourcc, tag, reader, immediate);
@@ -9,8 +9,18 @@
 //------------------------------------------------------------------------------
 #include "modelnode.h"
 #include "math/quat.h"
+#include "math/bbox.h"
 namespace Models
 {
+
+/// low detail geometry in node space which hides what is behind it, see Visibility::OcclusionSystem
+struct Occluder
+{
+    Util::Array<Math::vec3> vertices;
+    Util::Array<uint32> indices;
+    Math::bbox boundingBox;
+};
+
 class TransformNode : public ModelNode
 {
 public:
@@ -21,6 +31,8 @@ public:
 
     /// Get LOD distances
     void GetLODDistances(float& minDistance, float& maxDistance);
+    /// get occluder geometry, empty if the node has none
+    const Occluder& GetOccluder() const;
 
 protected:
     friend class ModelLoader;
@@ -39,6 +51,16 @@ protected:
     float maxDistance;
     bool useLodDistances;
     bool lockedToViewer;
+    Occluder occluder;
 };
 
+//------------------------------------------------------------------------------
+/**
+*/
+inline const Occluder&
+TransformNode::GetOccluder() const
+{
+    return this->occluder;
+}
+
 } // namespace Models
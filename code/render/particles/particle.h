@@ -3,8 +3,12 @@
 /**
     @class Particles::Particle
     
-    The particle structure holds the current state of a single particle and
-    common data for particle-job and nebula3 particle system
+    The particle structure holds the state of a single particle when it is
+    emitted, and common data for particle-job and nebula3 particle system.
+
+    A running particle system keeps its particles in ParticleStreams, one
+    array per component, so the step job can integrate 8 particles at a time
+    without shuffling them out of their structures first.
 
     !! NOTE: this header is also included from job particlejob.cc, so only 
     !! job-compliant headers can be included here
@@ -15,10 +19,12 @@
 */
 #include "math/vec4.h"
 #include "math/mat4.h"
+#include "math/vector.h"
 #include "math/bbox.h"
 #include "particles/emitterattrs.h"
 #include "threading/interlocked.h"
 #include "threading/event.h"
+#include "memory/memory.h"
 
 //------------------------------------------------------------------------------
 namespace Particles
@@ -74,20 +80,356 @@ namespace Particles
         unsigned int numLivingParticles;
     };
 
+    //------------------------------------------------------------------------------
+    /**
+        The particles of one system in structure of arrays layout. It is used
+        as a ring buffer like Util::RingBuffer, once the capacity is reached the
+        oldest particle is overwritten, but the step job simply walks all
+        Size() slots in memory order. Every stream is padded to a multiple of
+        ParticleBatchSize, so the last batch never reads past the end.
+    */
+    class ParticleStreams
+    {
+    public:
+        /// the component streams, vectors drop their w component
+        enum Stream
+        {
+            PositionX,
+            PositionY,
+            PositionZ,
+            VelocityX,
+            VelocityY,
+            VelocityZ,
+            StartPositionX,
+            StartPositionY,
+            StartPositionZ,
+            StretchPositionX,
+            StretchPositionY,
+            StretchPositionZ,
+            ColorR,
+            ColorG,
+            ColorB,
+            ColorA,
+            UvMinMaxX,
+            UvMinMaxY,
+            UvMinMaxZ,
+            UvMinMaxW,
+            Rotation,
+            RotationVariation,
+            CurrentSize,        // Particle::size, Size() is the particle count
+            SizeVariation,
+            OneDivLifeTime,
+            RelAge,
+            Age,
+            ParticleId,
+
+            NumStreams
+        };
+
+        /// constructor
+        ParticleStreams();
+        /// copy constructor
+        ParticleStreams(const ParticleStreams& rhs);
+        /// move constructor
+        ParticleStreams(ParticleStreams&& rhs);
+        /// destructor
+        ~ParticleStreams();
+        /// assignment operator
+        void operator=(const ParticleStreams& rhs);
+        /// move operator
+        void operator=(ParticleStreams&& rhs);
+
+        /// set capacity (clear previous content)
+        void SetCapacity(SizeT newCapacity);
+        /// get capacity
+        SizeT Capacity() const;
+        /// get number of particles
+        SizeT Size() const;
+        /// reset, drops all particles
+        void Reset();
+        /// add a particle, overwrites the oldest one if full
+        void Add(const Particle& particle);
+        /// get the slot of the oldest particle, the others follow in ring order
+        IndexT Oldest() const;
+        /// get a component stream
+        float* Get(Stream stream);
+        /// get a component stream
+        const float* Get(Stream stream) const;
+
+    private:
+        /// allocate streams
+        void Allocate(SizeT capacity);
+        /// free streams
+        void Delete();
+
+        float* buffer;
+        SizeT stride;
+        SizeT capacity;
+        SizeT size;
+        IndexT headIndex;
+    };
+
     struct ParticleJobContext
     {
-        const Particle* inputParticles;
-        Particle* outputParticles;
+        ParticleStreams* streams;
         const ParticleJobUniformData* uniformData;
         float stepTime;
-        uint numParticles;
+        SizeT numSlices;
+        ParticleJobSliceOutputData* sliceOutputs;
+        Threading::AtomicCounter* pendingSlices;
         ParticleJobSliceOutputData* output;
     };
 
-    static const SizeT ParticleJobInputElementSize = sizeof(Particle);
+    /// particles are stepped this many at a time
+    static const SizeT ParticleBatchSize = 8;
+    /// number of particles stepped by one job group, bigger systems are split over several groups
+    static const SizeT ParticleJobGroupSize = 4096;
+    static_assert(ParticleJobGroupSize % ParticleBatchSize == 0, "Job groups have to start on a batch");
+
+    /// step count particles starting at first, which has to be a multiple of ParticleBatchSize
+    void JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleStreams* streams, IndexT first, SizeT count, ParticleJobSliceOutputData* sliceOutput);
+    /// job function stepping one ParticleJobGroupSize slice of a ParticleJobContext, the last slice to finish merges the outputs
+    void ParticleStepJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx);
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline
+    ParticleStreams::ParticleStreams() :
+        buffer(nullptr),
+        stride(0),
+        capacity(0),
+        size(0),
+        headIndex(0)
+    {
+        // empty
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline
+    ParticleStreams::ParticleStreams(const ParticleStreams& rhs) :
+        buffer(nullptr),
+        stride(0),
+        capacity(0),
+        size(0),
+        headIndex(0)
+    {
+        *this = rhs;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline
+    ParticleStreams::ParticleStreams(ParticleStreams&& rhs) :
+        buffer(rhs.buffer),
+        stride(rhs.stride),
+        capacity(rhs.capacity),
+        size(rhs.size),
+        headIndex(rhs.headIndex)
+    {
+        rhs.buffer = nullptr;
+        rhs.stride = 0;
+        rhs.capacity = 0;
+        rhs.size = 0;
+        rhs.headIndex = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline
+    ParticleStreams::~ParticleStreams()
+    {
+        this->Delete();
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline void
+    ParticleStreams::operator=(const ParticleStreams& rhs)
+    {
+        if (this != &rhs)
+        {
+            this->Delete();
+            if (rhs.capacity > 0)
+            {
+                this->Allocate(rhs.capacity);
+                Memory::Copy(rhs.buffer, this->buffer, NumStreams * this->stride * sizeof(float));
+                this->size = rhs.size;
+                this->headIndex = rhs.headIndex;
+            }
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline void
+    ParticleStreams::operator=(ParticleStreams&& rhs)
+    {
+        if (this != &rhs)
+        {
+            this->Delete();
+            this->buffer = rhs.buffer;
+            this->stride = rhs.stride;
+            this->capacity = rhs.capacity;
+            this->size = rhs.size;
+            this->headIndex = rhs.headIndex;
+            rhs.buffer = nullptr;
+            rhs.stride = 0;
+            rhs.capacity = 0;
+            rhs.size = 0;
+            rhs.headIndex = 0;
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+        The padding is cleared once, the step job integrates it along with the
+        last batch, so it has to hold valid numbers.
+    */
+    inline void
+    ParticleStreams::Allocate(SizeT c)
+    {
+        n_assert(this->buffer == nullptr);
+        n_assert(c > 0);
+        this->capacity = c;
+        this->stride = (c + ParticleBatchSize - 1) & ~(ParticleBatchSize - 1);
+        this->size = 0;
+        this->headIndex = 0;
+        this->buffer = (float*)Memory::Alloc(Memory::ObjectArrayHeap, NumStreams * this->stride * sizeof(float));
+        Memory::Clear(this->buffer, NumStreams * this->stride * sizeof(float));
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline void
+    ParticleStreams::Delete()
+    {
+        if (this->buffer != nullptr)
+        {
+            Memory::Free(Memory::ObjectArrayHeap, this->buffer);
+            this->buffer = nullptr;
+        }
+        this->stride = 0;
+        this->capacity = 0;
+        this->size = 0;
+        this->headIndex = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline void
+    ParticleStreams::SetCapacity(SizeT newCapacity)
+    {
+        this->Delete();
+        this->Allocate(newCapacity);
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline SizeT
+    ParticleStreams::Capacity() const
+    {
+        return this->capacity;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline SizeT
+    ParticleStreams::Size() const
+    {
+        return this->size;
+    }
 
-    static const SizeT ParticleJobInputMaxElementsPerSlice = JobMaxSliceSize / ParticleJobInputElementSize;
-    static const SizeT ParticleJobInputSliceSize = ParticleJobInputMaxElementsPerSlice * ParticleJobInputElementSize;
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline void
+    ParticleStreams::Reset()
+    {
+        this->size = 0;
+        this->headIndex = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline void
+    ParticleStreams::Add(const Particle& particle)
+    {
+        n_assert(this->buffer != nullptr);
+        float* s = this->buffer + this->headIndex;
+        const SizeT n = this->stride;
+        s[PositionX * n] = particle.position.x;
+        s[PositionY * n] = particle.position.y;
+        s[PositionZ * n] = particle.position.z;
+        s[VelocityX * n] = particle.velocity.x;
+        s[VelocityY * n] = particle.velocity.y;
+        s[VelocityZ * n] = particle.velocity.z;
+        s[StartPositionX * n] = particle.startPosition.x;
+        s[StartPositionY * n] = particle.startPosition.y;
+        s[StartPositionZ * n] = particle.startPosition.z;
+        s[StretchPositionX * n] = particle.stretchPosition.x;
+        s[StretchPositionY * n] = particle.stretchPosition.y;
+        s[StretchPositionZ * n] = particle.stretchPosition.z;
+        s[ColorR * n] = particle.color.x;
+        s[ColorG * n] = particle.color.y;
+        s[ColorB * n] = particle.color.z;
+        s[ColorA * n] = particle.color.w;
+        s[UvMinMaxX * n] = particle.uvMinMax.x;
+        s[UvMinMaxY * n] = particle.uvMinMax.y;
+        s[UvMinMaxZ * n] = particle.uvMinMax.z;
+        s[UvMinMaxW * n] = particle.uvMinMax.w;
+        s[Rotation * n] = particle.rotation;
+        s[RotationVariation * n] = particle.rotationVariation;
+        s[CurrentSize * n] = particle.size;
+        s[SizeVariation * n] = particle.sizeVariation;
+        s[OneDivLifeTime * n] = particle.oneDivLifeTime;
+        s[RelAge * n] = particle.relAge;
+        s[Age * n] = particle.age;
+        s[ParticleId * n] = particle.particleId;
+
+        if (++this->headIndex == this->capacity)
+            this->headIndex = 0;
+        if (this->size < this->capacity)
+            this->size++;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline IndexT
+    ParticleStreams::Oldest() const
+    {
+        return this->size < this->capacity ? 0 : this->headIndex;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline float*
+    ParticleStreams::Get(Stream stream)
+    {
+        return this->buffer + stream * this->stride;
+    }
+
+    //------------------------------------------------------------------------------
+    /**
+    */
+    inline const float*
+    ParticleStreams::Get(Stream stream) const
+    {
+        return this->buffer + stream * this->stride;
+    }
 
 } // namespace Particles
 //------------------------------------------------------------------------------
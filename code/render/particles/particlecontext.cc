@@ -23,10 +23,6 @@ namespace Particles
 ParticleContext::ParticleContextAllocator ParticleContext::particleContextAllocator;
 __ImplementContext(ParticleContext, ParticleContext::particleContextAllocator);
 
-extern void JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, unsigned int numParticles,
-             const Particle* particles_input, Particle* particles_output,
-             ParticleJobSliceOutputData* sliceOutput);
-
 CoreGraphics::MeshId ParticleContext::DefaultEmitterMesh;
 const Timing::Time DefaultStepTime = 1.0f / 60.0f;
 Timing::Time StepTime = 1.0f / 60.0f;
@@ -34,7 +30,6 @@ Timing::Time StepTime = 1.0f / 60.0f;
 const SizeT ParticleContextNumEnvelopeSamples = 192;
 Threading::AtomicCounter allSystemsCompleteCounter = 0;
 Threading::AtomicCounter ParticleContext::ConstantUpdateCounter = 0;
-Threading::Event ParticleContext::totalCompletionEvent;
 
 struct
 {
@@ -516,11 +511,8 @@ ParticleContext::OnPrepareView(const Ptr<Graphics::View>& view, const Graphics::
                 }
             }
 
-        }, allSystems.Size(), 128, jobCtx, { &allSystemsCompleteCounter }, &ParticleContext::ConstantUpdateCounter, &ParticleContext::totalCompletionEvent);
+        }, allSystems.Size(), 128, jobCtx, { &allSystemsCompleteCounter }, &ParticleContext::ConstantUpdateCounter, nullptr);
     }
-
-    if (ParticleContext::ConstantUpdateCounter == 0)
-        ParticleContext::totalCompletionEvent.Signal();
 }
 
 //------------------------------------------------------------------------------
@@ -530,7 +522,8 @@ void
 ParticleContext::WaitForParticleUpdates(const Graphics::FrameContext& ctx)
 {
     N_SCOPE(WaitForParticleJobs, Particles);
-    ParticleContext::totalCompletionEvent.Wait();
+    // the counter stays at zero if there were no jobs this frame
+    Threading::WaitForCounter(&ParticleContext::ConstantUpdateCounter);
 
     if (state.numParticlesThisFrame == 0)
         return;
@@ -583,23 +576,31 @@ ParticleContext::WaitForParticleUpdates(const Graphics::FrameContext& ctx)
             ParticleSystemRuntime& system = systems[j];
             SizeT numParticles = 0;
 
-            // stream update vertex buffer region
+            // stream update vertex buffer region, oldest particles first
+            typedef ParticleStreams S;
+            const ParticleStreams& particles = system.particles;
+            IndexT index = particles.Oldest();
             IndexT k;
-            for (k = 0; k < system.outputData.numLivingParticles; k++)
+            for (k = 0; k < particles.Size(); k++)
             {
-                const Particle& particle = system.particles[k];
-                if (particle.relAge < 1.0f && particle.color.w > 0.001f)
+                if (particles.Get(S::RelAge)[index] < 1.0f && particles.Get(S::ColorA)[index] > 0.001f)
                 {
-                    particle.position.stream(buf); buf += 4;
-                    particle.stretchPosition.stream(buf); buf += 4;
-                    particle.color.stream(buf); buf += 4;
-                    particle.uvMinMax.stream(buf); buf += 4;
-                    float sinRot = Math::sin(particle.rotation);
-                    float cosRot = Math::cos(particle.rotation);
-                    tmp.set(sinRot, cosRot, particle.size, particle.particleId);
+                    tmp.set(particles.Get(S::PositionX)[index], particles.Get(S::PositionY)[index], particles.Get(S::PositionZ)[index], 1.0f);
+                    tmp.stream(buf); buf += 4;
+                    tmp.set(particles.Get(S::StretchPositionX)[index], particles.Get(S::StretchPositionY)[index], particles.Get(S::StretchPositionZ)[index], 1.0f);
+                    tmp.stream(buf); buf += 4;
+                    tmp.set(particles.Get(S::ColorR)[index], particles.Get(S::ColorG)[index], particles.Get(S::ColorB)[index], particles.Get(S::ColorA)[index]);
+                    tmp.stream(buf); buf += 4;
+                    tmp.set(particles.Get(S::UvMinMaxX)[index], particles.Get(S::UvMinMaxY)[index], particles.Get(S::UvMinMaxZ)[index], particles.Get(S::UvMinMaxW)[index]);
+                    tmp.stream(buf); buf += 4;
+                    float sinRot = Math::sin(particles.Get(S::Rotation)[index]);
+                    float cosRot = Math::cos(particles.Get(S::Rotation)[index]);
+                    tmp.set(sinRot, cosRot, particles.Get(S::CurrentSize)[index], particles.Get(S::ParticleId)[index]);
                     tmp.stream(buf); buf += 4;
                     numParticles++;
                 }
+                if (++index == particles.Capacity())
+                    index = 0;
             }
 
             // Update mesh to make sure we're using the right VBO
@@ -665,7 +666,7 @@ ParticleContext::OnRenderDebug(uint32_t flags)
     Util::Array<Util::Array<ParticleSystemRuntime>>& allSystems = particleContextAllocator.GetArray<ParticleSystems>();
     for (IndexT i = 0; i < allSystems.Size(); i++)
     {
-        Util::Array<ParticleSystemRuntime> runtimes = allSystems[i];
+        const Util::Array<ParticleSystemRuntime>& runtimes = allSystems[i];
         for (IndexT j = 0; j < runtimes.Size(); j++)
         {
             // for each system, make a white box
@@ -899,32 +900,24 @@ ParticleContext::RunParticleStep(ParticleRuntime& rt, ParticleSystemRuntime& srt
     N_SCOPE(RunParticleStep, Particles);
 
     // if no particles, no need to run the step update
-    if (srt.particles.Size() == 0)
+    const SizeT numParticles = srt.particles.Size();
+    if (numParticles == 0)
         return;
 
-    n_assert(srt.particles.GetBuffer());
-
+    // big systems are split into several groups, each of which bounds its own slice
+    const SizeT numSlices = (numParticles + ParticleJobGroupSize - 1) / ParticleJobGroupSize;
     ParticleJobContext jobContext;
-    jobContext.inputParticles = srt.particles.GetBuffer();
-    jobContext.outputParticles = srt.particles.GetBuffer();
-    jobContext.output = &srt.outputData;
+    jobContext.streams = &srt.particles;
     jobContext.uniformData = &srt.uniformData;
     jobContext.stepTime = stepTime;
-    jobContext.numParticles = srt.particles.Size();
+    jobContext.numSlices = numSlices;
+    jobContext.sliceOutputs = Jobs2::JobAlloc<ParticleJobSliceOutputData>(numSlices);
+    jobContext.pendingSlices = Jobs2::JobAlloc<Threading::AtomicCounter>(1);
+    *jobContext.pendingSlices = numSlices;
+    jobContext.output = &srt.outputData;
 
     // Sequence job
-    Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
-    {
-        N_SCOPE(ParticleStepJob, Graphics);
-        ParticleJobContext* context = static_cast<ParticleJobContext*>(ctx);
-        n_assert(totalJobs == 1); // Assert we only have one particle system per job execution
-
-        context->output->numLivingParticles = 0;
-        context->output->bbox = Math::bbox();
-
-        // Take a job step
-        JobStep(context->uniformData, context->stepTime, context->numParticles, context->inputParticles, context->outputParticles, context->output);
-    }, 1, jobContext);
+    Jobs2::JobAppendSequence(ParticleStepJob, numParticles, ParticleJobGroupSize, jobContext);
 }
 
 } // namespace Particles
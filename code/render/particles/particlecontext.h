@@ -14,7 +14,6 @@
 #include "models/nodes/particlesystemnode.h"
 #include "jobs/jobs.h"
 #include "jobs2/jobs2.h"
-#include "util/ringbuffer.h"
 #include "particle.h"
 namespace Particles
 {
@@ -78,7 +77,6 @@ public:
     static CoreGraphics::MeshId DefaultEmitterMesh;
 
     static Threading::AtomicCounter ConstantUpdateCounter;
-    static Threading::Event totalCompletionEvent;
 private:
 
     struct ParticleRuntime
@@ -104,7 +102,7 @@ private:
     struct ParticleSystemRuntime
     {
         uint32 renderableIndex;
-        Util::RingBuffer<Particle> particles;
+        ParticleStreams particles;
         Math::mat4 transform;
         Math::bbox boundingBox;
         SizeT emissionCounter;
@@ -6,165 +6,314 @@
 
 #include "jobs/jobs.h"
 #include "math/vec4.h"
+#include "math/vec3x8.h"
 #include "particles/particle.h"
-
-#if __NEBULA_NO_ASSERT__
-#define ASSERT_POINT(p)
-#define ASSERT_VECTOR(v)
-#else
-#define ASSERT_POINT(p)     { n_assert(p.w > 0.995f);  n_assert(p.w < 1.005f) }
-#define ASSERT_VECTOR(v)    { n_assert(v.w > -0.005f); n_assert(v.w < 0.005f) }
-#endif
+#include "system/cpu.h"
+#include "util/bit.h"
+#include "profiling/profiling.h"
 
 namespace Particles
 {
 
 using namespace Math;
 
+/// how the stretch position follows the particle, the same for the whole system
+enum StretchMode
+{
+    NoStretch,
+    StretchToStart,
+    StretchOverTime
+};
+
 //------------------------------------------------------------------------------
 /**
-
-    NOTE: JobStepAndVlist does the same as JobStep, but it also generates the vertex 
-          list. It could be in one function, but then we would always have to check a 
-          boolean value for each particle. Thats bad for the SPU, since it doesnt
-          have any branch prediction, and it would have to throw away commands 
-          and fetch new commands from the program in each iteration
+    Looks up the envelope sample row of each of the 8 particles from its
+    relative age, dead particles are clamped to the last row.
 */
+__forceinline void
+LookupEnvelopeSamples(const float* sampleBuffer, const float8& relAge, const float* rows[ParticleBatchSize])
+{
+    const float8 clamped = minimize(maximize(relAge, float8(0.0f)), float8(1.0f));
+    alignas(32) int sampleIndices[ParticleBatchSize];
+    _mm256_store_si256((__m256i*)sampleIndices, _mm256_cvttps_epi32((clamped * float8(float(ParticleSystemNumEnvelopeSamples - 1))).vec));
 
-
-/// lookup samples at index "sampleIndex" in sample-table
-const float* LookupEnvelopeSamples(const float sampleBuffer[ParticleSystemNumEnvelopeSamples*EmitterAttrs::NumEnvelopeAttrs], IndexT sampleIndex);
-/// update bounding box (min, max) with vector v
-void UpdateBbox(const vec4& v, vec4& min, vec4& max);
-/// update the age of one particle
-void ParticleUpdateAge(const float stepTime, const Particle& in, Particle& out);
-/// integrate the particle state with a given time-step
-void ParticleStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, const Particle& in, Particle& out, ParticleJobSliceOutputData* sliceOutput);
-/// update particle system step
-void JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, unsigned int numParticles, const Particle* particles_input, Particle* particles_output, ParticleJobSliceOutputData* sliceOutput);
+    IndexT i;
+    for (i = 0; i < ParticleBatchSize; i++)
+    {
+        n_assert(sampleIndices[i] >= 0);
+        n_assert(sampleIndices[i] < ParticleSystemNumEnvelopeSamples);
+        rows[i] = sampleBuffer + sampleIndices[i] * EmitterAttrs::NumEnvelopeAttrs;
+    }
+}
 
 //------------------------------------------------------------------------------
 /**
+    Collects one envelope attribute of 8 sample rows into a register.
 */
-__forceinline 
-const float*
-LookupEnvelopeSamples(const float sampleBuffer[ParticleSystemNumEnvelopeSamples*EmitterAttrs::NumEnvelopeAttrs], IndexT sampleIndex)
+__forceinline float8
+GatherSamples(const float* const rows[ParticleBatchSize], EmitterAttrs::EnvelopeAttr attr)
 {
-    n_assert(sampleIndex >= 0);
-    n_assert(sampleIndex < ParticleSystemNumEnvelopeSamples);
-    return sampleBuffer + (sampleIndex * EmitterAttrs::NumEnvelopeAttrs);
+    return _mm256_setr_ps(rows[0][attr], rows[1][attr], rows[2][attr], rows[3][attr], rows[4][attr], rows[5][attr], rows[6][attr], rows[7][attr]);
 }
 
 //------------------------------------------------------------------------------
 /**
+    Integrates the 8 particles starting at index i.
+
+    Dead particles are integrated along with the living ones, masking
+    the stores would cost more than it saves. They are skipped when the
+    vertex buffer is filled and overwritten by the next emitted particles,
+    only the bounding box and the living count have to leave them out.
 */
-__forceinline 
-void
-UpdateBbox(const vec4& v, vec4& min, vec4& max)
+template<StretchMode STRETCH>
+__forceinline void
+ParticleStepBatch(const ParticleJobUniformData* perSystemUniforms, const float8& stepTime, ParticleStreams* streams, IndexT i, const float8& laneMask, vec3x8& bboxMin, vec3x8& bboxMax, uint& numLivingParticles)
 {
-    min = minimize(min, v);
-    max = maximize(max, v);
+    typedef ParticleStreams S;
+
+    // update particle's age
+    float8 age, relAge, oneDivLifeTime;
+    age.loadu(streams->Get(S::Age) + i);
+    relAge.loadu(streams->Get(S::RelAge) + i);
+    oneDivLifeTime.loadu(streams->Get(S::OneDivLifeTime) + i);
+    age += stepTime;
+    relAge = multiplyadd(stepTime, oneDivLifeTime, relAge);
+    age.storeu(streams->Get(S::Age) + i);
+    relAge.storeu(streams->Get(S::RelAge) + i);
+
+    const float8 alive = _mm256_and_ps(less(relAge, float8(1.0f)).vec, laneMask.vec);
+
+    const float* rows[ParticleBatchSize];
+    LookupEnvelopeSamples(perSystemUniforms->sampleBuffer, relAge, rows);
+    const float8 airResistance = GatherSamples(rows, EmitterAttrs::AirResistance);
+    const float8 mass = GatherSamples(rows, EmitterAttrs::Mass);
+    const float8 velocityFactor = GatherSamples(rows, EmitterAttrs::VelocityFactor);
+    const float8 size = GatherSamples(rows, EmitterAttrs::Size);
+
+    // compute current particle acceleration
+    const vector& wind = perSystemUniforms->windVector;
+    const vector& gravity = perSystemUniforms->gravity;
+    const vec3x8 acceleration(
+        multiplyadd(float8(wind.x), airResistance, float8(gravity.x)) * mass,
+        multiplyadd(float8(wind.y), airResistance, float8(gravity.y)) * mass,
+        multiplyadd(float8(wind.z), airResistance, float8(gravity.z)) * mass);
+
+    // update position, velocity
+    vec3x8 position, velocity;
+    position.load(streams->Get(S::PositionX) + i, streams->Get(S::PositionY) + i, streams->Get(S::PositionZ) + i);
+    velocity.load(streams->Get(S::VelocityX) + i, streams->Get(S::VelocityY) + i, streams->Get(S::VelocityZ) + i);
+    position = multiplyadd(velocity, velocityFactor * stepTime, position);
+    velocity = multiplyadd(acceleration, stepTime, velocity);
+    position.store(streams->Get(S::PositionX) + i, streams->Get(S::PositionY) + i, streams->Get(S::PositionZ) + i);
+    velocity.store(streams->Get(S::VelocityX) + i, streams->Get(S::VelocityY) + i, streams->Get(S::VelocityZ) + i);
+
+    // extend the bounding box by the living particles, dead lanes keep the begin_extend() values
+    const vec3x8 extents(size, size, size);
+    const vec3x8 emptyMin(vec3(+1000000.0f, +1000000.0f, +1000000.0f));
+    const vec3x8 emptyMax(vec3(-1000000.0f, -1000000.0f, -1000000.0f));
+    const vec3x8 pmin = position - extents;
+    const vec3x8 pmax = position + extents;
+    bboxMin = minimize(bboxMin, vec3x8(select(emptyMin.x, pmin.x, alive), select(emptyMin.y, pmin.y, alive), select(emptyMin.z, pmin.z, alive)));
+    bboxMax = maximize(bboxMax, vec3x8(select(emptyMax.x, pmax.x, alive), select(emptyMax.y, pmax.y, alive), select(emptyMax.z, pmax.z, alive)));
+    numLivingParticles += Util::CountBits(_mm256_movemask_ps(alive.vec));
+
+    // update stretch position and rotation, NOTE: don't support particle rotation in stretch modes
+    if (STRETCH == StretchToStart)
+    {
+        vec3x8 startPosition;
+        startPosition.load(streams->Get(S::StartPositionX) + i, streams->Get(S::StartPositionY) + i, streams->Get(S::StartPositionZ) + i);
+        startPosition.store(streams->Get(S::StretchPositionX) + i, streams->Get(S::StretchPositionY) + i, streams->Get(S::StretchPositionZ) + i);
+    }
+    else if (STRETCH == StretchOverTime)
+    {
+        const float8 stretchTime(perSystemUniforms->stretchTime);
+        const float8 curStretchTime = minimize(stretchTime, age);
+        const vec3x8 stretched = position - (velocity - acceleration * (curStretchTime * float8(0.5f))) * (stretchTime * velocityFactor);
+
+        // a particle without age isn't stretched yet
+        const float8 stretching = greater(curStretchTime, float8(0.0f));
+        vec3x8(select(position.x, stretched.x, stretching), select(position.y, stretched.y, stretching), select(position.z, stretched.z, stretching))
+            .store(streams->Get(S::StretchPositionX) + i, streams->Get(S::StretchPositionY) + i, streams->Get(S::StretchPositionZ) + i);
+    }
+    else
+    {
+        position.store(streams->Get(S::StretchPositionX) + i, streams->Get(S::StretchPositionY) + i, streams->Get(S::StretchPositionZ) + i);
+
+        float8 rotation, rotationVariation;
+        rotation.loadu(streams->Get(S::Rotation) + i);
+        rotationVariation.loadu(streams->Get(S::RotationVariation) + i);
+        rotation = multiplyadd(rotationVariation * GatherSamples(rows, EmitterAttrs::RotationVelocity), stepTime, rotation);
+        rotation.storeu(streams->Get(S::Rotation) + i);
+    }
+
+    // color and size come straight from the envelopes
+    GatherSamples(rows, EmitterAttrs::Red).storeu(streams->Get(S::ColorR) + i);
+    GatherSamples(rows, EmitterAttrs::Green).storeu(streams->Get(S::ColorG) + i);
+    GatherSamples(rows, EmitterAttrs::Blue).storeu(streams->Get(S::ColorB) + i);
+    minimize(maximize(GatherSamples(rows, EmitterAttrs::Alpha), float8(0.0f)), float8(1.0f)).storeu(streams->Get(S::ColorA) + i);
+
+    float8 sizeVariation;
+    sizeVariation.loadu(streams->Get(S::SizeVariation) + i);
+    (size * sizeVariation).storeu(streams->Get(S::CurrentSize) + i);
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-__forceinline
-void ParticleUpdateAge(const float stepTime, const Particle& in, Particle& out)
+__forceinline float
+HorizontalMin(const float8& v)
 {
-    // update particle's age
-    out.oneDivLifeTime = in.oneDivLifeTime;
-    out.age = in.age + stepTime;
-    out.relAge = in.relAge + stepTime * in.oneDivLifeTime;
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(v.vec), _mm256_extractf128_ps(v.vec, 1));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_min_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(m);
 }
 
 //------------------------------------------------------------------------------
 /**
 */
-__forceinline
-void ParticleStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, const Particle& in, Particle& out, ParticleJobSliceOutputData* sliceOutput)
+__forceinline float
+HorizontalMax(const float8& v)
 {
-    ++sliceOutput->numLivingParticles;
-
-    // copy the *const* members
-    out.startPosition = in.startPosition;
-    out.uvMinMax = in.uvMinMax;
-    out.rotationVariation = in.rotationVariation;
-    out.sizeVariation = in.sizeVariation;
-
-    const IndexT sampleIndex = IndexT(out.relAge * (float)(ParticleSystemNumEnvelopeSamples-1));
-    n_assert(sampleIndex >= 0);            
-    n_assert(sampleIndex < ParticleSystemNumEnvelopeSamples);
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v.vec), _mm256_extractf128_ps(v.vec, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(m);
+}
 
-    const float* samples = LookupEnvelopeSamples(perSystemUniforms->sampleBuffer, sampleIndex);
-    
-    // compute current particle acceleration
-    Math::vec4 acceleration = perSystemUniforms->windVector * samples[EmitterAttrs::AirResistance];
-    acceleration += perSystemUniforms->gravity;
-    acceleration *= samples[EmitterAttrs::Mass];
+//------------------------------------------------------------------------------
+/**
+*/
+template<StretchMode STRETCH>
+__forceinline void
+JobStepImpl(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleStreams* streams, IndexT first, SizeT count, ParticleJobSliceOutputData* sliceOutput)
+{
+    n_assert((first % ParticleBatchSize) == 0);
+    n_assert(first + count <= streams->Size());
 
-    float curStretchTime = 0.0f;
+    const float8 step(stepTime);
+    const float8 allLanes(_mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+    vec3x8 bboxMin(vec3(+1000000.0f, +1000000.0f, +1000000.0f));
+    vec3x8 bboxMax(vec3(-1000000.0f, -1000000.0f, -1000000.0f));
+    uint numLivingParticles = 0;
 
-    // fix stretch time (if particle stretch is enabled
-    if (perSystemUniforms->stretchTime > 0.0f)
+    IndexT i;
+    const IndexT end = first + count;
+    for (i = first; i + ParticleBatchSize <= end; i += ParticleBatchSize)
     {
-        curStretchTime = (perSystemUniforms->stretchTime > out.age) ? out.age : perSystemUniforms->stretchTime;
+        ParticleStepBatch<STRETCH>(perSystemUniforms, step, streams, i, allLanes, bboxMin, bboxMax, numLivingParticles);
     }
-
-    // update position, velocity, rotation
-    ASSERT_POINT(in.position);
-    ASSERT_VECTOR(in.velocity);
-    out.position = in.position + in.velocity * samples[EmitterAttrs::VelocityFactor] * stepTime;
-    ASSERT_POINT(out.position);
-    sliceOutput->bbox.extend(Math::bbox(out.position, Math::vector(samples[EmitterAttrs::Size])));
-    out.velocity = in.velocity + acceleration * stepTime;
-    ASSERT_VECTOR(out.velocity);
-    if (perSystemUniforms->stretchToStart)
+    if (i < end)
     {
-        // NOTE: don't support particle rotation in stretch modes
-        out.stretchPosition = in.startPosition;
-        out.rotation = in.rotation;
+        // the streams are padded, so the last batch only has to mask out the lanes past the end
+        const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+        const __m128i remaining = _mm_set1_epi32(end - i);
+        const __m128i lo = _mm_cmplt_epi32(_mm256_castsi256_si128(lanes), remaining);
+        const __m128i hi = _mm_cmplt_epi32(_mm256_extractf128_si256(lanes, 1), remaining);
+        const float8 tailLanes(_mm256_castsi256_ps(_mm256_insertf128_si256(_mm256_castsi128_si256(lo), hi, 1)));
+        ParticleStepBatch<STRETCH>(perSystemUniforms, step, streams, i, tailLanes, bboxMin, bboxMax, numLivingParticles);
     }
-    else if (curStretchTime > 0.0f)
-    {
-        // NOTE: don't support particle rotation in stretch modes
-        // ???
-        out.stretchPosition = out.position -
-                              (out.velocity - acceleration * curStretchTime * 0.5f) *
-                              (perSystemUniforms->stretchTime * samples[EmitterAttrs::VelocityFactor]);
-        out.rotation = in.rotation;
-    }                
+
+    sliceOutput->numLivingParticles = numLivingParticles;
+    sliceOutput->bbox.pmin.set(HorizontalMin(bboxMin.x), HorizontalMin(bboxMin.y), HorizontalMin(bboxMin.z));
+    sliceOutput->bbox.pmax.set(HorizontalMax(bboxMax.x), HorizontalMax(bboxMax.y), HorizontalMax(bboxMax.z));
+}
+
+//------------------------------------------------------------------------------
+/**
+    The stretch mode is constant for a system, so it's resolved once here
+    instead of per particle.
+*/
+__forceinline void
+JobStepImpl(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleStreams* streams, IndexT first, SizeT count, ParticleJobSliceOutputData* sliceOutput)
+{
+    if (perSystemUniforms->stretchToStart)
+        JobStepImpl<StretchToStart>(perSystemUniforms, stepTime, streams, first, count, sliceOutput);
+    else if (perSystemUniforms->stretchTime > 0.0f)
+        JobStepImpl<StretchOverTime>(perSystemUniforms, stepTime, streams, first, count, sliceOutput);
     else
+        JobStepImpl<NoStretch>(perSystemUniforms, stepTime, streams, first, count, sliceOutput);
+}
+
+//------------------------------------------------------------------------------
+/**
+    The variants below only differ in the instruction set the inlined
+    step is compiled for, which lets the compiler use fused multiply-adds
+    for the integration without raising the baseline of the whole build.
+*/
+static void
+JobStepGeneric(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleStreams* streams, IndexT first, SizeT count, ParticleJobSliceOutputData* sliceOutput)
+{
+    JobStepImpl(perSystemUniforms, stepTime, streams, first, count, sliceOutput);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX2 static void
+JobStepAVX2(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleStreams* streams, IndexT first, SizeT count, ParticleJobSliceOutputData* sliceOutput)
+{
+    JobStepImpl(perSystemUniforms, stepTime, streams, first, count, sliceOutput);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX512 static void
+JobStepAVX512(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleStreams* streams, IndexT first, SizeT count, ParticleJobSliceOutputData* sliceOutput)
+{
+    JobStepImpl(perSystemUniforms, stepTime, streams, first, count, sliceOutput);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, ParticleStreams* streams, IndexT first, SizeT count, ParticleJobSliceOutputData* sliceOutput)
+{
+    typedef void (*Func)(const ParticleJobUniformData*, const float, ParticleStreams*, IndexT, SizeT, ParticleJobSliceOutputData*);
+    static const Func Table[System::Cpu::NumSimdLevels] =
     {
-        out.stretchPosition = out.position;
-        out.rotation = in.rotation + in.rotationVariation * samples[EmitterAttrs::RotationVelocity] * stepTime;
-    }
-    out.color.loadu(&(samples[EmitterAttrs::Red]));
-    out.color.w = Math::clamp(out.color.w, 0.0f, 1.0f);
-    out.size = samples[EmitterAttrs::Size] * in.sizeVariation;
+        JobStepGeneric,
+        JobStepAVX2,
+        JobStepAVX512
+    };
+    Table[System::Cpu::GetSimdLevel()](perSystemUniforms, stepTime, streams, first, count, sliceOutput);
 }
 
 //------------------------------------------------------------------------------
 /**
+    Every group bounds its own slice, so the groups of a big system run in
+    parallel, and only the last one to finish folds the few slice outputs
+    into the output of the system.
 */
 void
-JobStep(const ParticleJobUniformData* perSystemUniforms, const float stepTime, unsigned int numParticles,
-             const Particle* particles_input, Particle* particles_output, 
-             ParticleJobSliceOutputData* sliceOutput)
+ParticleStepJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
 {
-    unsigned int i;
-    sliceOutput->bbox.begin_extend();
-    for (i = 0; i < numParticles; i++)
+    N_SCOPE(ParticleStepJob, Graphics);
+    ParticleJobContext* context = static_cast<ParticleJobContext*>(ctx);
+
+    // take a job step on this group's slice
+    const SizeT count = Math::min(groupSize, totalJobs - invocationOffset);
+    JobStep(context->uniformData, context->stepTime, context->streams, invocationOffset, count, &context->sliceOutputs[groupIndex]);
+
+    if (Threading::Interlocked::Decrement(context->pendingSlices) == 0)
     {
-        const Particle &in = particles_input[i];
-        Particle &out = particles_output[i];
-        ParticleUpdateAge(stepTime, in, out);
-        if (out.relAge < 1.0f)
+        ParticleJobSliceOutputData* output = context->output;
+        output->numLivingParticles = 0;
+        output->bbox.begin_extend();
+        IndexT i;
+        for (i = 0; i < context->numSlices; i++)
         {
-            ParticleStep(perSystemUniforms, stepTime, in, out, sliceOutput);
+            const ParticleJobSliceOutputData& slice = context->sliceOutputs[i];
+            if (slice.numLivingParticles > 0)
+            {
+                output->numLivingParticles += slice.numLivingParticles;
+                output->bbox.extend(slice.bbox);
+            }
         }
+        output->bbox.end_extend();
     }
-    sliceOutput->bbox.end_extend();
 }
 
 } // namespace Particles
@@ -10,6 +10,8 @@
 //------------------------------------------------------------------------------
 #include "core/types.h"
 #include "math/scalar.h"
+#include "util/fixedarray.h"
+#include "util/flathashmap.h"
 namespace Terrain
 {
 
@@ -52,6 +54,10 @@ struct TileCacheEntry
     {
         return this->hash != rhs.hash;
     }
+    uint32 HashCode() const
+    {
+        return uint32(this->hash ^ (this->hash >> 32));
+    }
 };
 
 static const TileCacheEntry InvalidTileCacheEntry = TileCacheEntry{ 0x3FF, 0x7FF, 0x7FF, 0xFFFFFFFF };
@@ -97,7 +103,7 @@ private:
 
     Node* head;
     Node* tail;
-    Util::Dictionary<TileCacheEntry, Node*> lookup;
+    Util::FlatHashMap<TileCacheEntry, Node*> lookup;
 
     uint tiles;
     uint tileSize;
@@ -136,6 +142,9 @@ TextureTileCache::Setup(uint tileSize, uint textureSize)
     // keep all nodes linearly in memory!
     this->nodes.Resize(this->tiles * this->tiles);
 
+    // every node can be in the lookup at once, so it never has to grow
+    this->lookup.Reserve(this->tiles * this->tiles);
+
     // setup storage
     for (uint x = 0; x < this->tiles; x++)
     {
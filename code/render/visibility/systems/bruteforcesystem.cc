@@ -7,9 +7,102 @@
 #include "jobs2/jobs2.h"
 #include "math/mat4.h"
 #include "math/clipstatus.h"
+#include "math/simdkernels.h"
+#include "util/bit.h"
 namespace Visibility
 {
 
+/// how many boxes are gathered before they are tested together
+static const SizeT BruteforceBatchSize = 256;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+TestBatch(Math::ClipStatus::Type* testStatus, const uint32* testIds, const IndexT* testIndices, SizeT numBatched, Math::ClipStatus::Type* inOutStatus, Math::ClipStatus::Type* cachedStatus, const Math::bbox* boxes, const Math::mat4& viewProjection, bool isOrtho)
+{
+    Math::ClipBoxes(testStatus, boxes, testIds, numBatched, viewProjection, isOrtho);
+    IndexT i;
+    for (i = 0; i < numBatched; i++)
+    {
+        inOutStatus[testIndices[i]] = testStatus[i];
+        cachedStatus[testIds[i]] = testStatus[i];
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    The boxes which have to be tested are gathered into batches, so the
+    kernel only sees those. A cached result stays valid as long as neither
+    the observer nor the box moves, boxes which aren't tested because
+    another system already found them lose theirs unless that holds.
+*/
+void
+BruteforceClipBoxes(
+    Math::ClipStatus::Type* inOutStatus
+    , Math::ClipStatus::Type* cachedStatus
+    , const Math::bbox* boxes
+    , const uint32* ids
+    , const uint32_t* flags
+    , const uint64* dirtyBits
+    , bool isStatic
+    , SizeT count
+    , const Math::mat4& viewProjection
+    , bool isOrtho
+    , SizeT& outNumTested
+    , SizeT& outNumSkipped)
+{
+    Math::ClipStatus::Type testStatus[BruteforceBatchSize];
+    uint32 testIds[BruteforceBatchSize];
+    IndexT testIndices[BruteforceBatchSize];
+    SizeT numBatched = 0;
+    outNumTested = 0;
+    outNumSkipped = 0;
+
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        const uint32 id = ids[i];
+        const bool reusable = isStatic && dirtyBits != nullptr && !Util::HasBit(dirtyBits[id >> 6], id & 63);
+
+        // Always visible objects are marked inside up front, so the batched test skips them
+        if (AllBits(flags[id], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible))
+            inOutStatus[i] = Math::ClipStatus::Inside;
+
+        if (inOutStatus[i] != Math::ClipStatus::Outside)
+        {
+            if (!reusable)
+                cachedStatus[id] = Math::ClipStatus::Invalid;
+            continue;
+        }
+
+        if (reusable && cachedStatus[id] != Math::ClipStatus::Invalid)
+        {
+            inOutStatus[i] = cachedStatus[id];
+            outNumSkipped++;
+            continue;
+        }
+
+        testStatus[numBatched] = Math::ClipStatus::Outside;
+        testIds[numBatched] = id;
+        testIndices[numBatched] = i;
+        numBatched++;
+
+        if (numBatched == BruteforceBatchSize)
+        {
+            TestBatch(testStatus, testIds, testIndices, numBatched, inOutStatus, cachedStatus, boxes, viewProjection, isOrtho);
+            outNumTested += numBatched;
+            numBatched = 0;
+        }
+    }
+
+    if (numBatched > 0)
+    {
+        TestBatch(testStatus, testIds, testIndices, numBatched, inOutStatus, cachedStatus, boxes, viewProjection, isOrtho);
+        outNumTested += numBatched;
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -22,20 +115,30 @@ BruteforceSystem::Setup(const BruteforceSystemLoadInfo& info)
 /**
 */
 void
-BruteforceSystem::Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*>& extraCounters)
+BruteforceSystem::Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters)
 {
     // This is the context used to provide the job with
     struct Context
     {
-        Math::vec4 colX[4], colY[4], colZ[4], colW[4];
+        Math::mat4 camera;
         bool isOrtho;
+        bool isStatic;
         uint32 objectCount;
         const uint32* ids;
         const Math::bbox* boundingBoxes;
         const uint32_t* flags;
+        const uint64* dirtyBits;
         Math::ClipStatus::Type* clipStatuses;
+        Math::ClipStatus::Type* cachedStatuses;
+        int* testsRun;
+        int* testsSkipped;
     };
 
+    // New node instances have no results to reuse yet
+    const SizeT numNodeInstances = Models::ModelContext::GetModelRenderables().nodeBoundingBoxes.Size();
+    while (this->cachedResults.Size() < this->obs.count)
+        this->cachedResults.Append(Util::Array<Math::ClipStatus::Type>());
+
     IndexT i;
     for (i = 0; i < this->obs.count; i++)
     {
@@ -44,76 +147,83 @@ BruteforceSystem::Run(const Threading::AtomicCounter* const* previousSystemCompl
         n_assert(*this->obs.completionCounters[i] == 0);
         (*this->obs.completionCounters[i]) = 1;
 
+        Util::Array<Math::ClipStatus::Type>& cache = this->cachedResults[i];
+        const SizeT numCached = cache.Size();
+        cache.Resize(numNodeInstances);
+        if (numNodeInstances > numCached)
+            cache.Fill(numCached, numNodeInstances - numCached, Math::ClipStatus::Invalid);
+
+        this->obs.testsRun[i] = 0;
+        this->obs.testsSkipped[i] = 0;
+
         Context ctx;
         ctx.ids = this->ent.ids;
         ctx.boundingBoxes = this->ent.boxes;
         ctx.flags = this->ent.entityFlags;
+        ctx.dirtyBits = this->ent.dirtyBits;
         ctx.isOrtho = this->obs.isOrtho[i];
+        ctx.isStatic = this->obs.isStatic != nullptr && this->obs.isStatic[i];
+        ctx.objectCount = numNodeInstances;
+        ctx.cachedStatuses = cache.Begin();
+        ctx.testsRun = &this->obs.testsRun[i];
+        ctx.testsSkipped = &this->obs.testsSkipped[i];
 
         // Setup counters
-        Util::FixedArray<const Threading::AtomicCounter*> counters(extraCounters.Size() + (previousSystemCompletionCounters == nullptr ? 0 : 1));
+        Jobs2::JobWaitCounters counters(extraCounters.Size() + (previousSystemCompletionCounters == nullptr ? 0 : 1));
         if (!extraCounters.IsEmpty())
             Memory::CopyElements(extraCounters.Begin(), counters.Begin(), extraCounters.Size());
         if (previousSystemCompletionCounters != nullptr)
             counters[extraCounters.Size()] = previousSystemCompletionCounters[i];
 
-        // Splat the matrix such that all _x, _y, ... will contain the column values of x, y, ...
-        // This provides a way to rearrange the camera transform into a more SSE friendly matrix transform in the job
-        ctx.colX[0] = Math::splat_x((camera).r[0]);
-        ctx.colX[1] = Math::splat_x((camera).r[1]);
-        ctx.colX[2] = Math::splat_x((camera).r[2]);
-        ctx.colX[3] = Math::splat_x((camera).r[3]);
-
-        ctx.colY[0] = Math::splat_y((camera).r[0]);
-        ctx.colY[1] = Math::splat_y((camera).r[1]);
-        ctx.colY[2] = Math::splat_y((camera).r[2]);
-        ctx.colY[3] = Math::splat_y((camera).r[3]);
-
-        ctx.colZ[0] = Math::splat_z((camera).r[0]);
-        ctx.colZ[1] = Math::splat_z((camera).r[1]);
-        ctx.colZ[2] = Math::splat_z((camera).r[2]);
-        ctx.colZ[3] = Math::splat_z((camera).r[3]);
-
-        ctx.colW[0] = Math::splat_w((camera).r[0]);
-        ctx.colW[1] = Math::splat_w((camera).r[1]);
-        ctx.colW[2] = Math::splat_w((camera).r[2]);
-        ctx.colW[3] = Math::splat_w((camera).r[3]);
-
+        ctx.camera = camera;
         ctx.clipStatuses = this->obs.results[i].Begin();
 
-        // All set, run the job
-        Jobs2::JobDispatch([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
-        {
-            N_SCOPE(BruteforceViewFrustumCulling, Visibility);
-            auto context = static_cast<Context*>(ctx);
+        Jobs2::JobBeginSequence(counters, this->obs.completionCounters[i]);
 
-            // Iterate over work group
-            for (IndexT i = 0; i < groupSize; i++)
+        // Results from where the observer was last frame are of no use, including those of boxes which aren't tested this frame
+        if (!ctx.isStatic && numNodeInstances > 0)
+        {
+            Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
             {
-                // Get item index
-                IndexT index = i + invocationOffset;
-                if (index >= totalJobs)
+                N_SCOPE(BruteforceCacheReset, Visibility);
+                auto context = static_cast<Context*>(ctx);
+                if (invocationOffset >= totalJobs)
                     return;
+                const SizeT count = Math::min(groupSize, totalJobs - invocationOffset);
+                for (IndexT i = 0; i < count; i++)
+                    context->cachedStatuses[invocationOffset + i] = Math::ClipStatus::Invalid;
+            }, numNodeInstances, 4096, ctx);
+        }
 
-                uint32 objectId = context->ids[index];
-
-                if (AllBits(context->flags[objectId], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible))
-                {
-                    context->clipStatuses[index] = Math::ClipStatus::Inside;
-                    continue;
-                }
+        // Run bounding box check and store output in clip statuses, if clip status is still outside
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(BruteforceViewFrustumCulling, Visibility);
+            auto context = static_cast<Context*>(ctx);
 
-                // Run bounding box check and store output in clip statuses, if clip status is still outside
-                if (context->clipStatuses[index] == Math::ClipStatus::Outside)
-                    context->clipStatuses[index] = context->boundingBoxes[objectId].clipstatus(context->colX, context->colY, context->colZ, context->colW, context->isOrtho);
-            }
-        }
-        , this->ent.count
-        , 1024
-        , ctx
-        , counters
-        , this->obs.completionCounters[i]
-        , nullptr);
+            if (invocationOffset >= totalJobs)
+                return;
+            const SizeT count = Math::min(groupSize, totalJobs - invocationOffset);
+
+            SizeT numTested, numSkipped;
+            BruteforceClipBoxes(
+                context->clipStatuses + invocationOffset
+                , context->cachedStatuses
+                , context->boundingBoxes
+                , context->ids + invocationOffset
+                , context->flags
+                , context->dirtyBits
+                , context->isStatic
+                , count
+                , context->camera
+                , context->isOrtho
+                , numTested
+                , numSkipped);
+            Threading::Interlocked::Add(context->testsRun, numTested);
+            Threading::Interlocked::Add(context->testsSkipped, numSkipped);
+        }, this->ent.count, 1024, ctx);
+
+        Jobs2::JobEndSequence();
     }
 }
 } // namespace Visibility
@@ -3,6 +3,10 @@
 /**
     Brute force system
 
+    Remembers the result of every box per observer, so boxes which didn't
+    move aren't tested again as long as the observer doesn't move either,
+    as is the case for the shadow maps of stationary lights.
+
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
 */
@@ -12,6 +16,9 @@
 namespace Visibility
 {
 
+/// frustum cull boxes[ids[i]] into entries of inOutStatus which are still Outside, reusing cachedStatus[ids[i]] of boxes without dirty bit if the observer is static
+void BruteforceClipBoxes(Math::ClipStatus::Type* inOutStatus, Math::ClipStatus::Type* cachedStatus, const Math::bbox* boxes, const uint32* ids, const uint32_t* flags, const uint64* dirtyBits, bool isStatic, SizeT count, const Math::mat4& viewProjection, bool isOrtho, SizeT& outNumTested, SizeT& outNumSkipped);
+
 class BruteforceSystem : public VisibilitySystem
 {
 private:
@@ -21,7 +28,9 @@ private:
     void Setup(const BruteforceSystemLoadInfo& info);
 
     /// run system
-    void Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*>& extraCounters) override;
+    void Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters) override;
+
+    Util::Array<Util::Array<Math::ClipStatus::Type>> cachedResults;     // per observer and node instance, the result of the last test
 };
 
 } // namespace Visibility
@@ -0,0 +1,96 @@
+//------------------------------------------------------------------------------
+//  contributionsystem.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "contributionsystem.h"
+#include "jobs2/jobs2.h"
+#include "math/mat4.h"
+#include "math/clipstatus.h"
+#include "profiling/profiling.h"
+namespace Visibility
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ContributionSystem::Setup(const ContributionSystemLoadInfo& info)
+{
+    this->minSize = info.screenHeight > 0 ? info.minPixels / info.screenHeight : 0.0f;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ContributionSystem::Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters)
+{
+    // This is the context used to provide the job with
+    struct Context
+    {
+        Math::mat4 camera;
+        bool isOrtho;
+        float minSize;
+        const uint32* ids;
+        const Math::bbox* boundingBoxes;
+        const uint32_t* flags;
+        const Util::Tuple<float, float>* lodDistances;
+        Math::ClipStatus::Type* clipStatuses;
+    };
+
+    const Models::ModelContext::ModelInstance::Renderable& renderables = Models::ModelContext::GetModelRenderables();
+
+    IndexT i;
+    for (i = 0; i < this->obs.count; i++)
+    {
+        n_assert(*this->obs.completionCounters[i] == 0);
+        (*this->obs.completionCounters[i]) = 1;
+
+        Context ctx;
+        ctx.camera = this->obs.transforms[i];
+        ctx.isOrtho = this->obs.isOrtho[i];
+        ctx.minSize = this->minSize;
+        ctx.ids = this->ent.ids;
+        ctx.boundingBoxes = this->ent.boxes;
+        ctx.flags = this->ent.entityFlags;
+        ctx.lodDistances = renderables.nodeLodDistances.Begin();
+        ctx.clipStatuses = this->obs.results[i].Begin();
+
+        // Setup counters
+        Jobs2::JobWaitCounters counters(extraCounters.Size() + (previousSystemCompletionCounters == nullptr ? 0 : 1));
+        if (!extraCounters.IsEmpty())
+            Memory::CopyElements(extraCounters.Begin(), counters.Begin(), extraCounters.Size());
+        if (previousSystemCompletionCounters != nullptr)
+            counters[extraCounters.Size()] = previousSystemCompletionCounters[i];
+
+        // Remove what is too small or the wrong LOD
+        Jobs2::JobDispatch([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(ContributionCulling, Visibility);
+            auto context = static_cast<Context*>(ctx);
+            if (invocationOffset >= totalJobs)
+                return;
+
+            const SizeT count = Math::min(groupSize, totalJobs - invocationOffset);
+            ContributionCullBoxes(
+                context->clipStatuses + invocationOffset
+                , context->boundingBoxes
+                , context->ids + invocationOffset
+                , context->flags
+                , context->lodDistances
+                , count
+                , context->camera
+                , context->isOrtho
+                , context->minSize);
+        }
+        , this->ent.count
+        , 1024
+        , ctx
+        , counters
+        , this->obs.completionCounters[i]
+        , nullptr);
+    }
+}
+
+} // namespace Visibility
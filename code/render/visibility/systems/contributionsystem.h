@@ -0,0 +1,46 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Contribution system
+
+    Removes objects which cover too few pixels to be worth drawing, and picks
+    the level of detail of models per observer, so every shadow map and
+    probe draws the LOD which fits its own view rather than the camera's.
+
+    The projected size is the bounding sphere of an object over the screen
+    height, so the threshold applies the same to the cascades of
+    orthogonal shadow maps. Perspective observers pick LODs by the distance
+    from their eye to the center of the box, orthogonal ones, which have
+    no eye, keep the LOD the camera picked.
+
+    This system only removes objects, so it has to be created after a system
+    which does the frustum culling, and best before the occlusion system.
+    Objects which are marked as always visible are left as they are.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "visibilitysystem.h"
+#include "util/tupleutility.h"
+namespace Visibility
+{
+
+/// remove visible boxes[ids[i]] which are smaller than minSize of the screen height, or whose LOD isn't seen from the observer
+void ContributionCullBoxes(Math::ClipStatus::Type* inOutStatus, const Math::bbox* boxes, const uint32* ids, const uint32_t* flags, const Util::Tuple<float, float>* lodDistances, SizeT count, const Math::mat4& viewProjection, bool isOrtho, float minSize);
+
+class ContributionSystem : public VisibilitySystem
+{
+private:
+    friend class ObserverContext;
+
+    /// setup from load info
+    void Setup(const ContributionSystemLoadInfo& info);
+
+    /// run system
+    void Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters) override;
+
+    float minSize;
+};
+
+} // namespace Visibility
@@ -0,0 +1,89 @@
+//------------------------------------------------------------------------------
+//  contributionsystemjob.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "contributionsystem.h"
+#include "math/simdkernels.h"
+
+using namespace Math;
+namespace Visibility
+{
+
+/// how many boxes are gathered before they are projected together
+static const SizeT ContributionBatchSize = 256;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+CullBatch(ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* batchIds, const IndexT* batchIndices, SizeT numBatched, const uint32_t* flags, const Util::Tuple<float, float>* lodDistances, const mat4& viewProjection, const point& eye, bool isOrtho, float minSize)
+{
+    scalar sizes[ContributionBatchSize];
+    scalar distances[ContributionBatchSize];
+    ProjectBoxes(sizes, distances, boxes, batchIds, numBatched, viewProjection, eye, isOrtho);
+
+    IndexT i;
+    for (i = 0; i < numBatched; i++)
+    {
+        const uint32 id = batchIds[i];
+        bool seen = sizes[i] >= minSize;
+
+        const auto& [min, max] = lodDistances[id];
+        if (seen && (min < FLT_MAX || max < FLT_MAX))
+        {
+            // Orthogonal observers are as far away from everything, they keep the LOD of the camera
+            if (isOrtho)
+                seen = AllBits(flags[id], (uint32_t)Models::NodeInstanceFlags::NodeInstance_LodActive);
+            else
+                seen = distances[i] >= min && distances[i] < max;
+        }
+
+        if (!seen)
+            inOutStatus[batchIndices[i]] = ClipStatus::Outside;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    The eye of a perspective observer is the point its view projection sends
+    to w = 0 in the middle of the screen.
+*/
+void
+ContributionCullBoxes(ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, const uint32_t* flags, const Util::Tuple<float, float>* lodDistances, SizeT count, const mat4& viewProjection, bool isOrtho, float minSize)
+{
+    point eye(0, 0, 0);
+    if (!isOrtho)
+    {
+        const vec4 h = inverse(viewProjection) * vec4(0, 0, 1, 0);
+        eye = point(h.x / h.w, h.y / h.w, h.z / h.w);
+    }
+
+    uint32 batchIds[ContributionBatchSize];
+    IndexT batchIndices[ContributionBatchSize];
+    SizeT numBatched = 0;
+
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        const uint32 id = ids[i];
+        if (inOutStatus[i] == ClipStatus::Outside
+            || AllBits(flags[id], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible))
+            continue;
+
+        batchIds[numBatched] = id;
+        batchIndices[numBatched] = i;
+        numBatched++;
+
+        if (numBatched == ContributionBatchSize)
+        {
+            CullBatch(inOutStatus, boxes, batchIds, batchIndices, numBatched, flags, lodDistances, viewProjection, eye, isOrtho, minSize);
+            numBatched = 0;
+        }
+    }
+
+    if (numBatched > 0)
+        CullBatch(inOutStatus, boxes, batchIds, batchIndices, numBatched, flags, lodDistances, viewProjection, eye, isOrtho, minSize);
+}
+
+} // namespace Visibility
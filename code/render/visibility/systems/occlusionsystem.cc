@@ -0,0 +1,159 @@
+//------------------------------------------------------------------------------
+//  occlusionsystem.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+
+#include "occlusionsystem.h"
+#include "jobs2/jobs2.h"
+#include "math/mat4.h"
+#include "math/clipstatus.h"
+#include "profiling/profiling.h"
+namespace Visibility
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+OcclusionSystem::~OcclusionSystem()
+{
+    IndexT i;
+    for (i = 0; i < this->buffers.Size(); i++)
+        delete this->buffers[i];
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionSystem::Setup(const OcclusionSystemLoadInfo& info)
+{
+    this->width = info.width;
+    this->height = info.height;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Every observer gets a sequence of three jobs: one which projects and bins
+    the occluders in view, one per screen tile which rasterizes them, and the
+    box tests.
+*/
+void
+OcclusionSystem::Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters)
+{
+    // This is the context used to provide the jobs with
+    struct Context
+    {
+        Math::mat4 camera;
+        bool isOrtho;
+        OcclusionBuffer* buffer;
+        const uint32* ids;
+        const Math::bbox* boundingBoxes;
+        const uint32_t* flags;
+        Math::ClipStatus::Type* clipStatuses;
+    };
+
+    while (this->buffers.Size() < this->obs.count)
+    {
+        OcclusionBuffer* buffer = new OcclusionBuffer;
+        OcclusionBufferSetup(*buffer, this->width, this->height);
+        this->buffers.Append(buffer);
+    }
+
+    IndexT i;
+    for (i = 0; i < this->obs.count; i++)
+    {
+        n_assert(*this->obs.completionCounters[i] == 0);
+        (*this->obs.completionCounters[i]) = 1;
+
+        Context ctx;
+        ctx.camera = this->obs.transforms[i];
+        ctx.isOrtho = this->obs.isOrtho[i];
+        ctx.buffer = this->buffers[i];
+        ctx.ids = this->ent.ids;
+        ctx.boundingBoxes = this->ent.boxes;
+        ctx.flags = this->ent.entityFlags;
+        ctx.clipStatuses = this->obs.results[i].Begin();
+
+        // Setup counters
+        Jobs2::JobWaitCounters counters(extraCounters.Size() + (previousSystemCompletionCounters == nullptr ? 0 : 1));
+        if (!extraCounters.IsEmpty())
+            Memory::CopyElements(extraCounters.Begin(), counters.Begin(), extraCounters.Size());
+        if (previousSystemCompletionCounters != nullptr)
+            counters[extraCounters.Size()] = previousSystemCompletionCounters[i];
+
+        Jobs2::JobBeginSequence(counters, this->obs.completionCounters[i]);
+
+        // Project the occluders which are in view and bin their triangles
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(OcclusionBinOccluders, Visibility);
+            auto context = static_cast<Context*>(ctx);
+
+            OcclusionBufferClear(*context->buffer);
+            if (context->isOrtho)
+                return;
+
+            const Models::ModelContext::ModelInstance::Transformable& transformables = Models::ModelContext::GetModelTransformables();
+            for (IndexT i = 0; i < transformables.nodeOccluders.Size(); i++)
+            {
+                const Models::Occluder* occluder = transformables.nodeOccluders[i];
+                if (occluder == nullptr)
+                    continue;
+
+                const Math::mat4& transform = transformables.nodeTransforms[i];
+                Math::bbox box = occluder->boundingBox;
+                box.transform(transform);
+                if (box.clipstatus(context->camera) == Math::ClipStatus::Outside)
+                    continue;
+
+                OcclusionBufferAddOccluder(
+                    *context->buffer
+                    , context->camera * transform
+                    , occluder->vertices.Begin()
+                    , occluder->vertices.Size()
+                    , occluder->indices.Begin()
+                    , occluder->indices.Size());
+            }
+        }, 1, ctx);
+
+        // Rasterize, one tile per invocation
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(OcclusionRasterize, Visibility);
+            auto context = static_cast<Context*>(ctx);
+            if (context->isOrtho)
+                return;
+
+            for (IndexT i = 0; i < groupSize; i++)
+            {
+                const IndexT index = invocationOffset + i;
+                if (index >= totalJobs)
+                    return;
+                OcclusionBufferRasterizeTile(*context->buffer, index);
+            }
+        }, ctx.buffer->tilesX * ctx.buffer->tilesY, 1, ctx);
+
+        // Hide what is behind the occluders
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(OcclusionCulling, Visibility);
+            auto context = static_cast<Context*>(ctx);
+            if (context->isOrtho || invocationOffset >= totalJobs)
+                return;
+
+            const SizeT count = Math::min(groupSize, totalJobs - invocationOffset);
+            OcclusionBufferTestBoxes(
+                *context->buffer
+                , context->clipStatuses + invocationOffset
+                , context->boundingBoxes
+                , context->ids + invocationOffset
+                , context->flags
+                , count
+                , context->camera);
+        }, this->ent.count, 1024, ctx);
+
+        Jobs2::JobEndSequence();
+    }
+}
+
+} // namespace Visibility
@@ -0,0 +1,88 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Occlusion system
+
+    Rasterizes the occluders of models, low detail geometry authored with the
+    'occluder' material, into a small depth buffer per observer, and hides
+    whatever is behind them. The buffer is split into tiles which are
+    rasterized in parallel, 8 pixels at a time, and each block of 8x8 pixels
+    keeps its farthest depth, so most boxes are resolved without looking at
+    single pixels.
+
+    This system only removes objects, so it has to be created after a system
+    which does the frustum culling, such as the bruteforce system. Objects
+    which are marked as always visible are left as they are, and so are
+    orthogonal observers, whose depth is usually clamped to fit the shadow
+    casters.
+
+    The occlusion buffer functions don't need a graphics device, they are
+    used as is by the tests and benchmarks.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "visibilitysystem.h"
+#include "util/fixedarray.h"
+namespace Visibility
+{
+
+/// width of a screen tile in pixels, a tile is rasterized by one job
+static const SizeT OcclusionTileWidth = 64;
+/// height of a screen tile in pixels
+static const SizeT OcclusionTileHeight = 32;
+/// blocks of this many pixels squared keep their farthest depth
+static const SizeT OcclusionBlockSize = 8;
+
+/// a projected occluder triangle, in pixels
+struct OcclusionTriangle
+{
+    float edges[3][3];              // a, b, c of the edge functions a * x + b * y + c, positive inside
+    float depth[3];                 // depth plane, z = depth[0] * x + depth[1] * y + depth[2]
+    int minX, minY, maxX, maxY;     // pixel bounds, inclusive
+};
+
+struct OcclusionBuffer
+{
+    SizeT width, height;
+    SizeT tilesX, tilesY;
+    SizeT blocksX, blocksY;
+    Util::FixedArray<float> depth;                      // nearest occluder depth per pixel, 1 where there is none
+    Util::FixedArray<float> blockDepth;                 // farthest depth of each block of pixels
+    Util::Array<OcclusionTriangle> triangles;
+    Util::Array<Math::vec4> projected;                  // screen position and depth of the occluder vertices, w is 0 behind the near plane
+    Util::FixedArray<Util::Array<uint32>> bins;         // triangles which overlap each tile
+};
+
+/// setup a buffer of width x height pixels, the size is rounded up to whole tiles
+void OcclusionBufferSetup(OcclusionBuffer& buffer, SizeT width, SizeT height);
+/// forget the occluders of the previous frame
+void OcclusionBufferClear(OcclusionBuffer& buffer);
+/// project the triangles of an occluder and bin them into the tiles they overlap
+void OcclusionBufferAddOccluder(OcclusionBuffer& buffer, const Math::mat4& worldViewProjection, const Math::vec3* vertices, SizeT numVertices, const uint32* indices, SizeT numIndices);
+/// rasterize the binned triangles of a tile, and update the depth of its blocks
+void OcclusionBufferRasterizeTile(OcclusionBuffer& buffer, IndexT tile);
+/// test boxes[ids[i]] against the buffer, visible entries which are hidden are set to Outside
+void OcclusionBufferTestBoxes(const OcclusionBuffer& buffer, Math::ClipStatus::Type* inOutStatus, const Math::bbox* boxes, const uint32* ids, const uint32_t* flags, SizeT count, const Math::mat4& viewProjection);
+
+class OcclusionSystem : public VisibilitySystem
+{
+public:
+    /// destructor
+    virtual ~OcclusionSystem();
+
+private:
+    friend class ObserverContext;
+
+    /// setup from load info
+    void Setup(const OcclusionSystemLoadInfo& info);
+
+    /// run system
+    void Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters) override;
+
+    SizeT width, height;
+    Util::Array<OcclusionBuffer*> buffers;
+};
+
+} // namespace Visibility
@@ -0,0 +1,391 @@
+//------------------------------------------------------------------------------
+//  occlusionsystemjob.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "occlusionsystem.h"
+#include "math/float8.h"
+#include "system/cpu.h"
+
+using namespace Math;
+namespace Visibility
+{
+
+/// vertices closer than this to the eye plane are treated as behind it
+static const float OcclusionMinW = 1e-5f;
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionBufferSetup(OcclusionBuffer& buffer, SizeT width, SizeT height)
+{
+    n_assert(width > 0 && height > 0);
+    buffer.tilesX = (width + OcclusionTileWidth - 1) / OcclusionTileWidth;
+    buffer.tilesY = (height + OcclusionTileHeight - 1) / OcclusionTileHeight;
+    buffer.width = buffer.tilesX * OcclusionTileWidth;
+    buffer.height = buffer.tilesY * OcclusionTileHeight;
+    buffer.blocksX = buffer.width / OcclusionBlockSize;
+    buffer.blocksY = buffer.height / OcclusionBlockSize;
+    buffer.depth.Resize(buffer.width * buffer.height);
+    buffer.depth.Fill(1.0f);
+    buffer.blockDepth.Resize(buffer.blocksX * buffer.blocksY);
+    buffer.blockDepth.Fill(1.0f);
+    buffer.bins.Resize(buffer.tilesX * buffer.tilesY);
+    OcclusionBufferClear(buffer);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionBufferClear(OcclusionBuffer& buffer)
+{
+    buffer.triangles.Clear();
+    IndexT i;
+    for (i = 0; i < buffer.bins.Size(); i++)
+        buffer.bins[i].Clear();
+}
+
+//------------------------------------------------------------------------------
+/**
+    Triangles with a corner in front of the near plane are left out rather
+    than clipped. The real geometry is clipped there too, so whatever is
+    behind may be seen through the gap.
+*/
+void
+OcclusionBufferAddOccluder(OcclusionBuffer& buffer, const mat4& worldViewProjection, const vec3* vertices, SizeT numVertices, const uint32* indices, SizeT numIndices)
+{
+    const float halfWidth = buffer.width * 0.5f;
+    const float halfHeight = buffer.height * 0.5f;
+
+    buffer.projected.Clear();
+    buffer.projected.Reserve(numVertices);
+    IndexT i;
+    for (i = 0; i < numVertices; i++)
+    {
+        const vec4 clip = worldViewProjection * vec4(vertices[i], 1.0f);
+        if (clip.w > OcclusionMinW && clip.z >= 0.0f)
+        {
+            const float invW = 1.0f / clip.w;
+            buffer.projected.Append(vec4((clip.x * invW + 1.0f) * halfWidth, (clip.y * invW + 1.0f) * halfHeight, clip.z * invW, 1.0f));
+        }
+        else
+            buffer.projected.Append(vec4(0.0f));
+    }
+
+    for (i = 0; i + 2 < numIndices; i += 3)
+    {
+        const vec4& v0 = buffer.projected[indices[i]];
+        vec4 v1 = buffer.projected[indices[i + 1]];
+        vec4 v2 = buffer.projected[indices[i + 2]];
+        if (v0.w == 0.0f || v1.w == 0.0f || v2.w == 0.0f)
+            continue;
+
+        // both sides occlude, so turn the triangle counter clockwise for positive edge functions inside
+        float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+        if (area < 0.0f)
+        {
+            const vec4 tmp = v1;
+            v1 = v2;
+            v2 = tmp;
+            area = -area;
+        }
+        if (area < 1e-4f)
+            continue;
+
+        // pixels whose centers may be covered
+        OcclusionTriangle tri;
+        tri.minX = Math::max(0, (int)Math::ceil(Math::min(v0.x, Math::min(v1.x, v2.x)) - 0.5f));
+        tri.minY = Math::max(0, (int)Math::ceil(Math::min(v0.y, Math::min(v1.y, v2.y)) - 0.5f));
+        tri.maxX = Math::min((int)buffer.width - 1, (int)Math::floor(Math::max(v0.x, Math::max(v1.x, v2.x)) - 0.5f));
+        tri.maxY = Math::min((int)buffer.height - 1, (int)Math::floor(Math::max(v0.y, Math::max(v1.y, v2.y)) - 0.5f));
+        if (tri.minX > tri.maxX || tri.minY > tri.maxY)
+            continue;
+
+        const vec4* corners[3] = { &v0, &v1, &v2 };
+        IndexT edge;
+        for (edge = 0; edge < 3; edge++)
+        {
+            const vec4& a = *corners[edge];
+            const vec4& b = *corners[(edge + 1) % 3];
+            tri.edges[edge][0] = a.y - b.y;
+            tri.edges[edge][1] = b.x - a.x;
+            tri.edges[edge][2] = a.x * b.y - b.x * a.y;
+        }
+
+        // depth is linear in screen space after the perspective divide
+        const float invArea = 1.0f / area;
+        tri.depth[0] = ((v1.z - v0.z) * (v2.y - v0.y) - (v2.z - v0.z) * (v1.y - v0.y)) * invArea;
+        tri.depth[1] = ((v2.z - v0.z) * (v1.x - v0.x) - (v1.z - v0.z) * (v2.x - v0.x)) * invArea;
+        tri.depth[2] = v0.z - tri.depth[0] * v0.x - tri.depth[1] * v0.y;
+
+        const uint32 index = buffer.triangles.Size();
+        buffer.triangles.Append(tri);
+
+        IndexT x, y;
+        for (y = tri.minY / OcclusionTileHeight; y <= tri.maxY / (int)OcclusionTileHeight; y++)
+        {
+            for (x = tri.minX / OcclusionTileWidth; x <= tri.maxX / (int)OcclusionTileWidth; x++)
+                buffer.bins[y * buffer.tilesX + x].Append(index);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static __forceinline float
+HorizontalMin(const float8& v)
+{
+    __m128 m = _mm_min_ps(_mm256_castps256_ps128(v.vec), _mm256_extractf128_ps(v.vec, 1));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_min_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(m);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static __forceinline float
+HorizontalMax(const float8& v)
+{
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v.vec), _mm256_extractf128_ps(v.vec, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(m);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Evaluates the edge functions and depth plane of a triangle for 8 pixels
+    of a row at once, and keeps the nearest depth of the covered ones.
+*/
+static __forceinline void
+RasterizeTileImpl(OcclusionBuffer& buffer, IndexT tile)
+{
+    const int tileX = (tile % buffer.tilesX) * OcclusionTileWidth;
+    const int tileY = (tile / buffer.tilesX) * OcclusionTileHeight;
+    float* depth = buffer.depth.Begin();
+
+    const float8 one(1.0f);
+    const float8 zero(0.0f);
+    const float8 pixelOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+
+    IndexT x, y;
+    for (y = tileY; y < tileY + (int)OcclusionTileHeight; y++)
+    {
+        for (x = tileX; x < tileX + (int)OcclusionTileWidth; x += 8)
+            one.storeu(depth + y * buffer.width + x);
+    }
+
+    const Util::Array<uint32>& bin = buffer.bins[tile];
+    IndexT i;
+    for (i = 0; i < bin.Size(); i++)
+    {
+        const OcclusionTriangle& tri = buffer.triangles[bin[i]];
+        const int minX = Math::max(tri.minX, tileX) & ~7;
+        const int maxX = Math::min(tri.maxX, tileX + (int)OcclusionTileWidth - 1);
+        const int minY = Math::max(tri.minY, tileY);
+        const int maxY = Math::min(tri.maxY, tileY + (int)OcclusionTileHeight - 1);
+
+        const float8 a0(tri.edges[0][0]), a1(tri.edges[1][0]), a2(tri.edges[2][0]);
+        const float8 dzdx(tri.depth[0]);
+        for (y = minY; y <= maxY; y++)
+        {
+            const float centerY = y + 0.5f;
+            const float8 row0(tri.edges[0][1] * centerY + tri.edges[0][2]);
+            const float8 row1(tri.edges[1][1] * centerY + tri.edges[1][2]);
+            const float8 row2(tri.edges[2][1] * centerY + tri.edges[2][2]);
+            const float8 rowDepth(tri.depth[1] * centerY + tri.depth[2]);
+            float* dst = depth + y * buffer.width;
+            for (x = minX; x <= maxX; x += 8)
+            {
+                const float8 centerX = float8((float)x) + pixelOffsets;
+                const float8 e0 = multiplyadd(a0, centerX, row0);
+                const float8 e1 = multiplyadd(a1, centerX, row1);
+                const float8 e2 = multiplyadd(a2, centerX, row2);
+                const float8 outside = less(minimize(e0, minimize(e1, e2)), zero);
+                const float8 z = multiplyadd(dzdx, centerX, rowDepth);
+
+                float8 current;
+                current.loadu(dst + x);
+                current = minimize(current, select(z, one, outside));
+                current.storeu(dst + x);
+            }
+        }
+    }
+
+    // the blocks of the tile keep the farthest depth, a box in front of it is visible for sure
+    const SizeT blocksPerTileX = OcclusionTileWidth / OcclusionBlockSize;
+    const SizeT blocksPerTileY = OcclusionTileHeight / OcclusionBlockSize;
+    IndexT bx, by;
+    for (by = 0; by < blocksPerTileY; by++)
+    {
+        for (bx = 0; bx < blocksPerTileX; bx++)
+        {
+            const float* src = depth + (tileY + by * OcclusionBlockSize) * buffer.width + tileX + bx * OcclusionBlockSize;
+            float8 farthest;
+            farthest.loadu(src);
+            for (y = 1; y < (int)OcclusionBlockSize; y++)
+            {
+                float8 row;
+                row.loadu(src + y * buffer.width);
+                farthest = maximize(farthest, row);
+            }
+            const IndexT block = (tileY / OcclusionBlockSize + by) * buffer.blocksX + tileX / OcclusionBlockSize + bx;
+            buffer.blockDepth[block] = HorizontalMax(farthest);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    The nearest point of a box is one of its corners, so a box is hidden if
+    the occluders in every pixel it covers are nearer than its nearest corner.
+    The blocks sort out most boxes, only blocks which are partly farther away
+    are looked at pixel by pixel.
+*/
+static __forceinline void
+TestBoxesImpl(const OcclusionBuffer& buffer, ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, const uint32_t* flags, SizeT count, const mat4& viewProjection)
+{
+    float8 mx[4], my[4], mz[4], mw[4];
+    IndexT i;
+    for (i = 0; i < 4; i++)
+    {
+        mx[i] = float8(viewProjection.m[i][0]);
+        my[i] = float8(viewProjection.m[i][1]);
+        mz[i] = float8(viewProjection.m[i][2]);
+        mw[i] = float8(viewProjection.m[i][3]);
+    }
+    const float8 minW(OcclusionMinW);
+    const float8 half(0.5f);
+    const float8 width((float)buffer.width);
+    const float8 height((float)buffer.height);
+    const float* depth = buffer.depth.Begin();
+
+    for (i = 0; i < count; i++)
+    {
+        if (inOutStatus[i] == ClipStatus::Outside)
+            continue;
+        if (flags != nullptr && AllBits(flags[ids[i]], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible))
+            continue;
+
+        const bbox& box = boxes[ids[i]];
+        const float8 x = _mm256_blend_ps(_mm256_set1_ps(box.pmin.x), _mm256_set1_ps(box.pmax.x), 0xaa);
+        const float8 y = _mm256_blend_ps(_mm256_set1_ps(box.pmin.y), _mm256_set1_ps(box.pmax.y), 0xcc);
+        const float8 z = _mm256_blend_ps(_mm256_set1_ps(box.pmin.z), _mm256_set1_ps(box.pmax.z), 0xf0);
+
+        // a box which reaches behind the eye covers everything
+        const float8 cw = multiplyadd(mw[2], z, multiplyadd(mw[1], y, multiplyadd(mw[0], x, mw[3])));
+        if (_mm256_movemask_ps(less(cw, minW).vec) != 0)
+            continue;
+        const float8 invW = reciprocal(cw);
+        const float8 cx = multiplyadd(mx[2], z, multiplyadd(mx[1], y, multiplyadd(mx[0], x, mx[3])));
+        const float8 cy = multiplyadd(my[2], z, multiplyadd(my[1], y, multiplyadd(my[0], x, my[3])));
+        const float8 cz = multiplyadd(mz[2], z, multiplyadd(mz[1], y, multiplyadd(mz[0], x, mz[3])));
+        const float8 sx = multiplyadd(cx * invW, half, half) * width;
+        const float8 sy = multiplyadd(cy * invW, half, half) * height;
+        const float nearest = HorizontalMin(cz * invW);
+
+        // the pixels the box touches, the frustum systems take care of boxes off screen
+        const int minX = Math::max(0, (int)Math::floor(HorizontalMin(sx)));
+        const int minY = Math::max(0, (int)Math::floor(HorizontalMin(sy)));
+        const int maxX = Math::min((int)buffer.width - 1, (int)Math::floor(HorizontalMax(sx)));
+        const int maxY = Math::min((int)buffer.height - 1, (int)Math::floor(HorizontalMax(sy)));
+        if (minX > maxX || minY > maxY)
+            continue;
+
+        bool visible = false;
+        IndexT bx, by, px, py;
+        for (by = minY / OcclusionBlockSize; by <= maxY / (int)OcclusionBlockSize && !visible; by++)
+        {
+            for (bx = minX / OcclusionBlockSize; bx <= maxX / (int)OcclusionBlockSize && !visible; bx++)
+            {
+                if (buffer.blockDepth[by * buffer.blocksX + bx] < nearest)
+                    continue;
+
+                const int blockMaxY = Math::min(maxY, (int)((by + 1) * OcclusionBlockSize) - 1);
+                const int blockMaxX = Math::min(maxX, (int)((bx + 1) * OcclusionBlockSize) - 1);
+                for (py = Math::max(minY, (int)(by * OcclusionBlockSize)); py <= blockMaxY && !visible; py++)
+                {
+                    for (px = Math::max(minX, (int)(bx * OcclusionBlockSize)); px <= blockMaxX && !visible; px++)
+                        visible = depth[py * buffer.width + px] >= nearest;
+                }
+            }
+        }
+        if (!visible)
+            inOutStatus[i] = ClipStatus::Outside;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    The variants below only differ in the instruction set the kernels are
+    compiled for.
+*/
+static void
+RasterizeTileGeneric(OcclusionBuffer& buffer, IndexT tile)
+{
+    RasterizeTileImpl(buffer, tile);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX2 static void
+RasterizeTileAVX2(OcclusionBuffer& buffer, IndexT tile)
+{
+    RasterizeTileImpl(buffer, tile);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+TestBoxesGeneric(const OcclusionBuffer& buffer, ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, const uint32_t* flags, SizeT count, const mat4& viewProjection)
+{
+    TestBoxesImpl(buffer, inOutStatus, boxes, ids, flags, count, viewProjection);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+N_TARGET_AVX2 static void
+TestBoxesAVX2(const OcclusionBuffer& buffer, ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, const uint32_t* flags, SizeT count, const mat4& viewProjection)
+{
+    TestBoxesImpl(buffer, inOutStatus, boxes, ids, flags, count, viewProjection);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionBufferRasterizeTile(OcclusionBuffer& buffer, IndexT tile)
+{
+    typedef void (*Func)(OcclusionBuffer&, IndexT);
+    static const Func Table[System::Cpu::NumSimdLevels] =
+    {
+        RasterizeTileGeneric,
+        RasterizeTileAVX2,
+        RasterizeTileAVX2       // rows of 8 pixels, nothing to gain from wider registers
+    };
+    Table[System::Cpu::GetSimdLevel()](buffer, tile);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionBufferTestBoxes(const OcclusionBuffer& buffer, ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, const uint32_t* flags, SizeT count, const mat4& viewProjection)
+{
+    typedef void (*Func)(const OcclusionBuffer&, ClipStatus::Type*, const bbox*, const uint32*, const uint32_t*, SizeT, const mat4&);
+    static const Func Table[System::Cpu::NumSimdLevels] =
+    {
+        TestBoxesGeneric,
+        TestBoxesAVX2,
+        TestBoxesAVX2           // 8 corners per box fill an AVX register
+    };
+    Table[System::Cpu::GetSimdLevel()](buffer, inOutStatus, boxes, ids, flags, count, viewProjection);
+}
+
+} // namespace Visibility
@@ -4,15 +4,168 @@
 //------------------------------------------------------------------------------
 
 #include "portalsystem.h"
+#include "io/ioserver.h"
+#include "jobs2/jobs2.h"
+#include "profiling/profiling.h"
 namespace Visibility
 {
 
+/// node instances whose cell hasn't been looked up yet
+static const IndexT PortalUnassigned = -2;
+
 //------------------------------------------------------------------------------
 /**
 */
 void
-PortalSystem::Setup(const PortalSystemLoadInfo & info)
+PortalSystem::Setup(const PortalSystemLoadInfo& info)
 {
+    this->assignCounter = 0;
+    if (info.path.IsValid())
+    {
+        Ptr<IO::Stream> stream = IO::IoServer::Instance()->CreateStream(info.path.Value());
+        if (!PortalWorldLoad(this->world, stream))
+            n_warning("PortalSystem: could not load cells and portals from '%s'\n", info.path.Value());
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    First the node instances whose bounding box changed since the last frame
+    are assigned to their cell, then every observer gets a sequence of two
+    jobs: one which finds the cells it sees, and the box tests.
+*/
+void
+PortalSystem::Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters)
+{
+    struct AssignContext
+    {
+        const PortalWorld* world;
+        const uint32* ids;
+        const Math::bbox* boundingBoxes;
+        Math::bbox* entityBoxes;
+        IndexT* entityCells;
+    };
+
+    // This is the context used to provide the jobs with
+    struct Context
+    {
+        Math::mat4 camera;
+        bool isOrtho;
+        const PortalWorld* world;
+        Math::vec4* cellRects;
+        const uint32* ids;
+        const Math::bbox* boundingBoxes;
+        const uint32_t* flags;
+        const IndexT* entityCells;
+        Math::ClipStatus::Type* clipStatuses;
+    };
+
+    // Node instances which appeared since the last frame have no cell yet
+    const SizeT numNodeInstances = Models::ModelContext::GetModelRenderables().nodeBoundingBoxes.Size();
+    this->entityBoxes.Reserve(numNodeInstances);
+    this->entityCells.Reserve(numNodeInstances);
+    while (this->entityCells.Size() < numNodeInstances)
+    {
+        this->entityBoxes.Append(Math::bbox());
+        this->entityCells.Append(PortalUnassigned);
+    }
+
+    while (this->cellRects.Size() < this->obs.count)
+        this->cellRects.Append(Util::FixedArray<Math::vec4>());
+
+    n_assert(this->assignCounter == 0);
+    this->assignCounter = 1;
+
+    AssignContext assignCtx;
+    assignCtx.world = &this->world;
+    assignCtx.ids = this->ent.ids;
+    assignCtx.boundingBoxes = this->ent.boxes;
+    assignCtx.entityBoxes = this->entityBoxes.Begin();
+    assignCtx.entityCells = this->entityCells.Begin();
+
+    Jobs2::JobDispatch([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+    {
+        N_SCOPE(PortalCellAssign, Visibility);
+        auto context = static_cast<AssignContext*>(ctx);
+
+        for (IndexT i = 0; i < groupSize; i++)
+        {
+            const IndexT index = invocationOffset + i;
+            if (index >= totalJobs)
+                return;
+
+            // Only look the cell up again if the box changed
+            const uint32 id = context->ids[index];
+            const Math::bbox& box = context->boundingBoxes[id];
+            Math::bbox& assignedBox = context->entityBoxes[id];
+            if (context->entityCells[id] != PortalUnassigned && box.pmin == assignedBox.pmin && box.pmax == assignedBox.pmax)
+                continue;
+
+            assignedBox = box;
+            context->entityCells[id] = PortalWorldFindCell(*context->world, box);
+        }
+    }, this->ent.count, 1024, assignCtx, extraCounters, &this->assignCounter, nullptr);
+
+    IndexT i;
+    for (i = 0; i < this->obs.count; i++)
+    {
+        n_assert(*this->obs.completionCounters[i] == 0);
+        (*this->obs.completionCounters[i]) = 1;
+
+        this->cellRects[i].Resize(this->world.cells.Size());
+
+        Context ctx;
+        ctx.camera = this->obs.transforms[i];
+        ctx.isOrtho = this->obs.isOrtho[i];
+        ctx.world = &this->world;
+        ctx.cellRects = this->cellRects[i].Begin();
+        ctx.ids = this->ent.ids;
+        ctx.boundingBoxes = this->ent.boxes;
+        ctx.flags = this->ent.entityFlags;
+        ctx.entityCells = this->entityCells.Begin();
+        ctx.clipStatuses = this->obs.results[i].Begin();
+
+        // Setup counters, the cells have to be assigned before the boxes are tested
+        Jobs2::JobWaitCounters counters(extraCounters.Size() + (previousSystemCompletionCounters == nullptr ? 1 : 2));
+        if (!extraCounters.IsEmpty())
+            Memory::CopyElements(extraCounters.Begin(), counters.Begin(), extraCounters.Size());
+        counters[extraCounters.Size()] = &this->assignCounter;
+        if (previousSystemCompletionCounters != nullptr)
+            counters[extraCounters.Size() + 1] = previousSystemCompletionCounters[i];
+
+        Jobs2::JobBeginSequence(counters, this->obs.completionCounters[i]);
+
+        // Walk the portals from the cell of the observer
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(PortalFindVisibleCells, Visibility);
+            auto context = static_cast<Context*>(ctx);
+            PortalWorldFindVisibleCells(*context->world, context->camera, context->cellRects);
+        }, 1, ctx);
+
+        // Test the boxes in the cells which are seen
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(PortalViewFrustumCulling, Visibility);
+            auto context = static_cast<Context*>(ctx);
+            if (invocationOffset >= totalJobs)
+                return;
+
+            const SizeT count = Math::min(groupSize, totalJobs - invocationOffset);
+            PortalWorldClipBoxes(
+                context->cellRects
+                , context->clipStatuses + invocationOffset
+                , context->boundingBoxes
+                , context->ids + invocationOffset
+                , context->entityCells
+                , context->flags
+                , count
+                , context->camera
+                , context->isOrtho);
+        }, this->ent.count, 1024, ctx);
+
+        Jobs2::JobEndSequence();
+    }
 }
 
 } // namespace Visibility
@@ -3,22 +3,121 @@
 /**
     Portal system
 
+    The world is split into authored cells, convex rooms given by their
+    bounding box, which are connected by portals, convex polygons such as
+    doors and windows. For each observer the cell it stands in is found, and
+    the part of the screen every other cell is seen through is narrowed from
+    portal to portal. Cells which can't be seen are culled whole, before any
+    of their objects are tested.
+
+    Objects are assigned to the cell which fully contains their bounding box,
+    and reassigned only when the box changes. Objects which are in no cell,
+    or which stick out of their cell, are only frustum culled. If the observer
+    is outside of all cells, every cell is considered seen.
+
+    Like the bruteforce system, this system sets entries which are still
+    Outside, so it replaces the frustum culling system rather than running
+    after one.
+
+    The cells and portals are loaded from a json file:
+
+        {
+            "cells": [ { "name": "hall", "min": [0, 0, 0], "max": [10, 4, 10] }, ... ],
+            "portals": [ { "cells": [0, 1], "vertices": [[4, 0, 0], [6, 0, 0], [6, 3, 0], [4, 3, 0]] }, ... ]
+        }
+
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
 */
 //------------------------------------------------------------------------------
 #include "visibilitysystem.h"
 #include "jobs/jobs.h"
+#include "io/stream.h"
+#include "util/fixedarray.h"
 namespace Visibility
 {
-    
+
+/// cell of objects which are not within a single cell
+static const IndexT PortalNoCell = -1;
+/// how many portals a cell can be seen through, one after the other
+static const SizeT PortalMaxDepth = 16;
+
+/// a convex room or area, cells should not overlap
+struct PortalCell
+{
+    Util::StringAtom name;
+    Math::bbox box;
+    Util::Array<IndexT> portals;            // portals which lead out of this cell
+};
+
+/// a convex polygon which connects two cells, it can be seen through from both sides
+struct Portal
+{
+    IndexT cells[2];
+    Util::Array<Math::vec3> vertices;
+};
+
+struct PortalWorld
+{
+    Util::Array<PortalCell> cells;
+    Util::Array<Portal> portals;
+};
+
+/// add a cell, returns its index
+IndexT PortalWorldAddCell(PortalWorld& world, const Util::StringAtom& name, const Math::bbox& box);
+/// add a portal between two cells, returns its index
+IndexT PortalWorldAddPortal(PortalWorld& world, IndexT cell0, IndexT cell1, const Math::vec3* vertices, SizeT numVertices);
+/// load cells and portals from a json stream, returns false if the stream could not be read
+bool PortalWorldLoad(PortalWorld& world, const Ptr<IO::Stream>& stream);
+/// get the cell which contains a point, or PortalNoCell
+IndexT PortalWorldFindCell(const PortalWorld& world, const Math::point& point);
+/// get the cell which fully contains a box, or PortalNoCell
+IndexT PortalWorldFindCell(const PortalWorld& world, const Math::bbox& box);
+/// get the part of the screen each cell is seen through, as min x, min y, max x, max y in normalized device coordinates, min > max if not seen
+void PortalWorldFindVisibleCells(const PortalWorld& world, const Math::mat4& viewProjection, Math::vec4* outCellRects);
+/// test boxes[ids[i]] in cells entityCells[ids[i]], only entries of inOutStatus which are still Outside are updated
+void PortalWorldClipBoxes(const Math::vec4* cellRects, Math::ClipStatus::Type* inOutStatus, const Math::bbox* boxes, const uint32* ids, const IndexT* entityCells, const uint32_t* flags, SizeT count, const Math::mat4& viewProjection, bool isOrtho);
+
 class PortalSystem : public VisibilitySystem
 {
 public:
+    /// get the cells and portals
+    const PortalWorld& GetWorld() const;
+    /// get the cells and portals, to add to them
+    PortalWorld& GetWorld();
+
 private:
     friend class ObserverContext;
 
     /// setup from load info
     void Setup(const PortalSystemLoadInfo& info);
+
+    /// run system
+    void Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters) override;
+
+    PortalWorld world;
+    Util::Array<Util::FixedArray<Math::vec4>> cellRects;    // per observer, the part of the screen each cell is seen through
+    Util::Array<Math::bbox> entityBoxes;                    // per node instance, the box its cell was found for
+    Util::Array<IndexT> entityCells;                        // per node instance, the cell it is in
+    Threading::AtomicCounter assignCounter;
 };
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const PortalWorld&
+PortalSystem::GetWorld() const
+{
+    return this->world;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline PortalWorld&
+PortalSystem::GetWorld()
+{
+    return this->world;
+}
+
 } // namespace Visibility
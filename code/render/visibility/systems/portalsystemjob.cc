@@ -4,8 +4,373 @@
 //------------------------------------------------------------------------------
 
 #include "portalsystem.h"
+#include "io/jsonreader.h"
+
+using namespace Math;
 namespace Visibility
 {
 
+/// vertices closer than this to the eye plane are treated as behind it
+static const float PortalMinW = 1e-5f;
+
+//------------------------------------------------------------------------------
+/**
+    Unlike bbox::contains, boxes which touch the sides of the cell are
+    still inside it, which is where floors and walls are.
+*/
+static inline bool
+CellContains(const bbox& cell, const point& min, const point& max)
+{
+    return greaterequal_all(min, cell.pmin) && greaterequal_all(cell.pmax, max);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static inline bool
+RectIsEmpty(const vec4& rect)
+{
+    return rect.x > rect.z || rect.y > rect.w;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static inline bool
+RectContains(const vec4& outer, const vec4& inner)
+{
+    return inner.x >= outer.x && inner.y >= outer.y && inner.z <= outer.z && inner.w <= outer.w;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static inline vec4
+RectIntersect(const vec4& a, const vec4& b)
+{
+    return vec4(Math::max(a.x, b.x), Math::max(a.y, b.y), Math::min(a.z, b.z), Math::min(a.w, b.w));
+}
+
+//------------------------------------------------------------------------------
+/**
+    Get the screen rectangle of points in normalized device coordinates.
+    Returns false if all of them are behind the eye, and the full screen if
+    only some of them are, as the rectangle is then unbounded.
+*/
+static bool
+ProjectRect(const mat4& viewProjection, const vec4* points, SizeT numPoints, vec4& outRect)
+{
+    outRect = vec4(FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX);
+    SizeT numBehind = 0;
+    IndexT i;
+    for (i = 0; i < numPoints; i++)
+    {
+        const vec4 clip = viewProjection * points[i];
+        if (clip.w <= PortalMinW)
+        {
+            numBehind++;
+            continue;
+        }
+        const float x = clip.x / clip.w;
+        const float y = clip.y / clip.w;
+        outRect = vec4(Math::min(outRect.x, x), Math::min(outRect.y, y), Math::max(outRect.z, x), Math::max(outRect.w, y));
+    }
+
+    if (numBehind == numPoints)
+        return false;
+    if (numBehind > 0)
+        outRect = vec4(-1, -1, 1, 1);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+IndexT
+PortalWorldAddCell(PortalWorld& world, const Util::StringAtom& name, const bbox& box)
+{
+    PortalCell& cell = world.cells.Emplace();
+    cell.name = name;
+    cell.box = box;
+    return world.cells.Size() - 1;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+IndexT
+PortalWorldAddPortal(PortalWorld& world, IndexT cell0, IndexT cell1, const vec3* vertices, SizeT numVertices)
+{
+    n_assert(cell0 >= 0 && cell0 < world.cells.Size());
+    n_assert(cell1 >= 0 && cell1 < world.cells.Size());
+    n_assert(cell0 != cell1);
+    n_assert(numVertices >= 3);
+
+    const IndexT index = world.portals.Size();
+    Portal& portal = world.portals.Emplace();
+    portal.cells[0] = cell0;
+    portal.cells[1] = cell1;
+    portal.vertices.AppendArray(vertices, numVertices);
+    world.cells[cell0].portals.Append(index);
+    world.cells[cell1].portals.Append(index);
+    return index;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The data is authored by hand or exported by tools, so portals which
+    don't connect two existing cells or have less than three vertices, and
+    cells without a name or box, fail the load with a warning and leave the
+    world empty.
+*/
+bool
+PortalWorldLoad(PortalWorld& world, const Ptr<IO::Stream>& stream)
+{
+    Ptr<IO::JsonReader> reader = IO::JsonReader::Create();
+    reader->SetStream(stream);
+    if (!reader->Open())
+        return false;
+
+    bool valid = true;
+    if (reader->SetToFirstChild("cells"))
+    {
+        if (reader->SetToFirstChild()) do
+        {
+            if (!reader->HasAttr("name") || !reader->HasAttr("min") || !reader->HasAttr("max"))
+            {
+                n_warning("PortalWorldLoad: cell %d needs a name, min and max\n", world.cells.Size());
+                valid = false;
+                break;
+            }
+            bbox box;
+            box.pmin = point(reader->GetVec3("min"));
+            box.pmax = point(reader->GetVec3("max"));
+            PortalWorldAddCell(world, reader->GetString("name"), box);
+        }
+        while (reader->SetToNextChild());
+        reader->SetToParent();
+    }
+
+    if (valid && reader->SetToFirstChild("portals"))
+    {
+        if (reader->SetToFirstChild()) do
+        {
+            const IndexT portalIndex = world.portals.Size();
+            Util::Array<int> cells;
+            if (reader->HasAttr("cells"))
+                reader->Get(cells, "cells");
+            if (cells.Size() != 2)
+            {
+                n_warning("PortalWorldLoad: portal %d has to connect two cells\n", portalIndex);
+                valid = false;
+                break;
+            }
+            if (cells[0] < 0 || cells[0] >= world.cells.Size() || cells[1] < 0 || cells[1] >= world.cells.Size() || cells[0] == cells[1])
+            {
+                n_warning("PortalWorldLoad: portal %d connects invalid cells %d and %d\n", portalIndex, cells[0], cells[1]);
+                valid = false;
+                break;
+            }
+
+            Util::Array<vec3> vertices;
+            if (reader->SetToFirstChild("vertices"))
+            {
+                if (reader->SetToFirstChild()) do
+                {
+                    vertices.Append(reader->GetVec3());
+                }
+                while (reader->SetToNextChild());
+                reader->SetToParent();
+            }
+            if (vertices.Size() < 3)
+            {
+                n_warning("PortalWorldLoad: portal %d needs at least three vertices\n", portalIndex);
+                valid = false;
+                break;
+            }
+            PortalWorldAddPortal(world, cells[0], cells[1], vertices.Begin(), vertices.Size());
+        }
+        while (reader->SetToNextChild());
+        reader->SetToParent();
+    }
+
+    reader->Close();
+    if (!valid)
+    {
+        world.cells.Clear();
+        world.portals.Clear();
+    }
+    return valid;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+IndexT
+PortalWorldFindCell(const PortalWorld& world, const point& point)
+{
+    IndexT i;
+    for (i = 0; i < world.cells.Size(); i++)
+    {
+        if (CellContains(world.cells[i].box, point, point))
+            return i;
+    }
+    return PortalNoCell;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+IndexT
+PortalWorldFindCell(const PortalWorld& world, const bbox& box)
+{
+    IndexT i;
+    for (i = 0; i < world.cells.Size(); i++)
+    {
+        if (CellContains(world.cells[i].box, box.pmin, box.pmax))
+            return i;
+    }
+    return PortalNoCell;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Walks the portal graph depth first from the cell of the eye, narrowing
+    the screen rectangle by every portal it passes. A cell seen through
+    several portals gets the rectangle around all of them.
+
+    A cell is only entered again if the rectangle it's seen through grows,
+    and the walk then goes on with the grown rectangle. Graphs with many
+    routes to the same cells, like grids of rooms, would otherwise take a
+    number of paths which grows exponentially with the depth.
+
+    The eye is taken to be the center of the near plane, which works for
+    orthographic observers too.
+*/
+void
+PortalWorldFindVisibleCells(const PortalWorld& world, const mat4& viewProjection, vec4* outCellRects)
+{
+    const vec4 fullScreen(-1, -1, 1, 1);
+    const vec4 empty(1, 1, -1, -1);
+    IndexT i;
+
+    const vec4 eye = inverse(viewProjection) * vec4(0, 0, 0, 1);
+    const IndexT eyeCell = PortalWorldFindCell(world, point(eye.x / eye.w, eye.y / eye.w, eye.z / eye.w));
+    if (eyeCell == PortalNoCell)
+    {
+        // outside of the cells, they can be seen from anywhere
+        for (i = 0; i < world.cells.Size(); i++)
+            outCellRects[i] = fullScreen;
+        return;
+    }
+
+    for (i = 0; i < world.cells.Size(); i++)
+        outCellRects[i] = empty;
+
+    struct Visit
+    {
+        IndexT cell;
+        IndexT portal;      // portal the cell was entered through
+        IndexT nextPortal;  // next of the cell's portals to look through
+        vec4 rect;
+    };
+    Visit path[PortalMaxDepth + 1];
+    SizeT depth = 0;
+    path[0] = { eyeCell, InvalidIndex, 0, fullScreen };
+    outCellRects[eyeCell] = fullScreen;
+
+    vec4 points[16];
+    while (true)
+    {
+        Visit& visit = path[depth];
+        const PortalCell& cell = world.cells[visit.cell];
+        if (visit.nextPortal >= cell.portals.Size() || depth == PortalMaxDepth)
+        {
+            if (depth == 0)
+                break;
+            depth--;
+            continue;
+        }
+
+        const IndexT portalIndex = cell.portals[visit.nextPortal++];
+        if (portalIndex == visit.portal)
+            continue;
+
+        const Portal& portal = world.portals[portalIndex];
+        const IndexT next = portal.cells[0] == visit.cell ? portal.cells[1] : portal.cells[0];
+
+        // narrow the view by the portal, polygons with more vertices than fit are seen through whole
+        IndexT j;
+        vec4 rect = visit.rect;
+        if (portal.vertices.Size() <= (SizeT)(sizeof(points) / sizeof(points[0])))
+        {
+            for (j = 0; j < portal.vertices.Size(); j++)
+                points[j] = vec4(portal.vertices[j], 1);
+            vec4 portalRect;
+            if (!ProjectRect(viewProjection, points, portal.vertices.Size(), portalRect))
+                continue;
+            rect = RectIntersect(rect, portalRect);
+            if (RectIsEmpty(rect))
+                continue;
+        }
+
+        // nothing more of the cell is seen this way, which also ends walks in circles
+        vec4& cellRect = outCellRects[next];
+        if (RectIsEmpty(cellRect))
+            cellRect = rect;
+        else if (RectContains(cellRect, rect))
+            continue;
+        else
+            cellRect = vec4(Math::min(cellRect.x, rect.x), Math::min(cellRect.y, rect.y), Math::max(cellRect.z, rect.z), Math::max(cellRect.w, rect.w));
+
+        depth++;
+        path[depth] = { next, portalIndex, 0, cellRect };
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Objects in cells which aren't seen are left Outside without a look at
+    their box, the others are frustum culled and then tested against the
+    screen rectangle of their cell.
+*/
+void
+PortalWorldClipBoxes(const vec4* cellRects, ClipStatus::Type* inOutStatus, const bbox* boxes, const uint32* ids, const IndexT* entityCells, const uint32_t* flags, SizeT count, const mat4& viewProjection, bool isOrtho)
+{
+    vec4 corners[8];
+    IndexT i;
+    for (i = 0; i < count; i++)
+    {
+        if (inOutStatus[i] != ClipStatus::Outside)
+            continue;
+
+        const uint32 id = ids[i];
+        if (flags != nullptr && AllBits(flags[id], (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible))
+        {
+            inOutStatus[i] = ClipStatus::Inside;
+            continue;
+        }
+
+        const IndexT cell = entityCells[id];
+        if (cell != PortalNoCell && RectIsEmpty(cellRects[cell]))
+            continue;
+
+        const bbox& box = boxes[id];
+        const ClipStatus::Type status = box.clipstatus(viewProjection, isOrtho);
+        if (status == ClipStatus::Outside)
+            continue;
+
+        if (cell != PortalNoCell)
+        {
+            IndexT j;
+            for (j = 0; j < 8; j++)
+                corners[j] = box.corner_point(j);
+            vec4 rect;
+            if (!ProjectRect(viewProjection, corners, 8, rect) || RectIsEmpty(RectIntersect(rect, cellRects[cell])))
+                continue;
+        }
+        inOutStatus[i] = status;
+    }
+}
 
 } // namespace Visibility
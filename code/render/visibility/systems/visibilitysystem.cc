@@ -14,17 +14,30 @@ VisibilitySystem::VisibilitySystem()
 {
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+VisibilitySystem::~VisibilitySystem()
+{
+}
+
 //------------------------------------------------------------------------------
 /**
 */
 void
-VisibilitySystem::PrepareObservers(const Math::mat4* transforms, bool* orthoFlags, Util::Array<Math::ClipStatus::Type>* results, const SizeT count)
+VisibilitySystem::PrepareObservers(const Math::mat4* transforms, bool* orthoFlags, const bool* staticFlags, Util::Array<Math::ClipStatus::Type>* results, const SizeT count)
 {
     this->obs.completionCounters.Reserve(count);
     for (IndexT i = 0; i < count; i++)
         this->obs.completionCounters.Append(new Threading::AtomicCounter(0));
+    while (this->obs.testsRun.Size() < count)
+    {
+        this->obs.testsRun.Append(0);
+        this->obs.testsSkipped.Append(0);
+    }
     this->obs.transforms = transforms;
     this->obs.isOrtho = orthoFlags;
+    this->obs.isStatic = staticFlags;
     this->obs.results = results;
     this->obs.count = count;
 }
@@ -33,12 +46,13 @@ VisibilitySystem::PrepareObservers(const Math::mat4* transforms, bool* orthoFlag
 /**
 */
 void
-VisibilitySystem::PrepareEntities(const Math::bbox* boxes, const uint32* ids, const Graphics::GraphicsEntityId* entities, const uint32_t* entityFlags, const SizeT count)
+VisibilitySystem::PrepareEntities(const Math::bbox* boxes, const uint32* ids, const Graphics::GraphicsEntityId* entities, const uint32_t* entityFlags, const uint64* dirtyBits, const SizeT count)
 {
     this->ent.boxes = boxes;
     this->ent.entities = entities;
     this->ent.ids = ids;
     this->ent.entityFlags = entityFlags;
+    this->ent.dirtyBits = dirtyBits;
     this->ent.count = count;
 }
 
@@ -46,7 +60,7 @@ VisibilitySystem::PrepareEntities(const Math::bbox* boxes, const uint32* ids, co
 /**
 */
 void
-VisibilitySystem::Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*>& extraCounters)
+VisibilitySystem::Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters)
 {
     // do nothing
 }
@@ -69,4 +83,23 @@ VisibilitySystem::GetCompletionCounters() const
     return this->obs.completionCounters.ConstBegin();
 }
 
+//------------------------------------------------------------------------------
+/**
+    Systems which don't count their tests report none.
+*/
+void
+VisibilitySystem::GetTestStatistics(IndexT i, SizeT& outTested, SizeT& outSkipped) const
+{
+    if (i < this->obs.testsRun.Size())
+    {
+        outTested = this->obs.testsRun[i];
+        outSkipped = this->obs.testsSkipped[i];
+    }
+    else
+    {
+        outTested = 0;
+        outSkipped = 0;
+    }
+}
+
 } // namespace Visibility
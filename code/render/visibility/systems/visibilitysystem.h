@@ -3,8 +3,8 @@
 /**
     A visibility system describes some virtual representation of the scene, 
     wherein objects are searchable for visibility. This is coarse grained
-    visibility, and does not account for any pixel-perfect techniques like
-    occlusion culling.
+    visibility, except for the occlusion system, which refines the results
+    of the other systems at the resolution of a small depth buffer.
 
     Some systems are procedural (Octree and Quadtree) while other systems require
     authoring. 
@@ -33,6 +33,15 @@
     Bruteforce system:
         Doesn't do anything but view frustum culling on everything in the scene.
 
+    Occlusion system:
+        Rasterizes low detail occluders on the CPU and hides what is behind them.
+        Useful for indoor and city scenes, it only removes objects so it runs after
+        one of the systems above.
+
+    Contribution system:
+        Removes objects which are too small on screen, and picks LODs per observer.
+        Like the occlusion system, it only removes objects.
+
     @copyright
     (C) 2018-2020 Individual contributors, see AUTHORS file
 */
@@ -56,7 +65,7 @@ struct BoxSystemLoadInfo
 
 struct PortalSystemLoadInfo
 {
-    Resources::ResourceName path;   // path to authored portal system
+    Resources::ResourceName path;   // path to authored cells and portals, may be empty to add them through PortalSystem::GetWorld
 };
 
 struct OctreeSystemLoadInfo
@@ -80,24 +89,39 @@ struct BruteforceSystemLoadInfo
     // empty on purpose
 };
 
+struct OcclusionSystemLoadInfo
+{
+    uint width, height;             // size of the depth buffer in pixels
+};
+
+struct ContributionSystemLoadInfo
+{
+    float minPixels;                // objects smaller than this many pixels are culled
+    uint screenHeight;              // height the pixels are counted at, the threshold scales with the height of each observer, 0 only picks LODs
+};
+
 class VisibilitySystem
 {
 public:
 
     /// Constructor
     VisibilitySystem();
+    /// Destructor
+    virtual ~VisibilitySystem();
 
-    /// setup observers
-    virtual void PrepareObservers(const Math::mat4* transforms, bool* orthoFlags, Util::Array<Math::ClipStatus::Type>* results, const SizeT count);
-    /// prepare system with entities to insert into the structure
-    virtual void PrepareEntities(const Math::bbox* transforms, const uint32* ranges, const Graphics::GraphicsEntityId* entities, const uint32_t* entityFlags, const SizeT count);
+    /// setup observers, static observers haven't moved since the last frame
+    virtual void PrepareObservers(const Math::mat4* transforms, bool* orthoFlags, const bool* staticFlags, Util::Array<Math::ClipStatus::Type>* results, const SizeT count);
+    /// prepare system with entities to insert into the structure, dirty bits are set per node instance whose box changed since the last frame
+    virtual void PrepareEntities(const Math::bbox* transforms, const uint32* ranges, const Graphics::GraphicsEntityId* entities, const uint32_t* entityFlags, const uint64* dirtyBits, const SizeT count);
     /// run system
-    virtual void Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Util::FixedArray<const Threading::AtomicCounter*>& extraCounters);
+    virtual void Run(const Threading::AtomicCounter* const* previousSystemCompletionCounters, const Jobs2::JobWaitCounters& extraCounters);
 
     /// Return completion counter for an observer
     const Threading::AtomicCounter* GetCompletionCounter(IndexT i) const;
     /// Return completion counter for all observers
     const Threading::AtomicCounter* const* GetCompletionCounters() const;
+    /// Return how many boxes an observer tested in the last frame, and how many results it reused instead
+    void GetTestStatistics(IndexT i, SizeT& outTested, SizeT& outSkipped) const;
 
 protected:
 
@@ -108,9 +132,12 @@ protected:
     {
         const Math::mat4* transforms;
         const bool* isOrtho;
+        const bool* isStatic;
         Util::Array<Math::ClipStatus::Type>* results;
         SizeT count;
         Util::Array<Threading::AtomicCounter*> completionCounters;
+        Util::Array<int> testsRun;
+        Util::Array<int> testsSkipped;
     } obs;
 
     struct Entity
@@ -119,6 +146,7 @@ protected:
         const Graphics::GraphicsEntityId* entities;
         const uint32* ids;
         const uint32_t* entityFlags;
+        const uint64* dirtyBits;
         SizeT count;
     } ent;
 };
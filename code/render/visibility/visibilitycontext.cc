@@ -19,13 +19,18 @@
 #include "systems/portalsystem.h"
 #include "systems/quadtreesystem.h"
 #include "systems/bruteforcesystem.h"
+#include "systems/occlusionsystem.h"
+#include "systems/contributionsystem.h"
 
 #include "profiling/profiling.h"
 
 #include "util/randomnumbertable.h"
+#include "util/bit.h"
 
 #include "jobs2/jobs2.h"
 
+#include <algorithm>
+
 #ifndef PUBLIC_BUILD
 #include "imgui.h"
 #endif
@@ -33,6 +38,25 @@
 namespace Visibility
 {
 
+/// visible node instances each job of the draw list build gathers and sorts
+static const SizeT DrawListGatherChunkSize = 4096;
+/// sorted draw packets each job of the draw list build resolves into commands
+static const SizeT DrawListBuildChunkSize = 1024;
+
+/// per observer, what the jobs building its draw list hand to each other
+struct DrawListBuild
+{
+    Util::Array<uint64> keys;                   // sort keys, each gather chunk sorts its own part
+    Util::Array<uint64> mergedKeys;             // the other buffer the sorted parts are merged between
+    Util::Array<IndexT> runOffsets;
+    Util::Array<SizeT> runSizes;
+    const uint64* sortedKeys;                   // all visible node instances in draw order
+    SizeT numVisible;
+    Util::Array<Util::Array<ObserverContext::VisibilityBatchCommand>> chunkBatches;   // per build chunk, a batch per material change
+    Util::Array<Util::Array<Materials::ShaderConfig*>> chunkMaterials;                // per build chunk, the material of each batch
+};
+static Util::Array<DrawListBuild> drawListBuilds;
+
 ObserverContext::ObserverAllocator ObserverContext::observerAllocator;
 ObservableContext::ObservableAllocator ObservableContext::observableAllocator;
 
@@ -52,6 +76,10 @@ ObserverContext::Setup(const Graphics::GraphicsEntityId id, VisibilityEntityType
     observerAllocator.Set<Observer_EntityType>(cid.id, entityType);
     observerAllocator.Set<Observer_EntityId>(cid.id, id);
     observerAllocator.Set<Observer_IsOrtho>(cid.id, isOrtho);
+
+    // A matrix no observer has, so results from before the setup aren't reused
+    observerAllocator.Set<Observer_Matrix>(cid.id, Math::mat4(Math::vec4(0), Math::vec4(0), Math::vec4(0), Math::vec4(0)));
+    observerAllocator.Set<Observer_Static>(cid.id, false);
 }
 
 //------------------------------------------------------------------------------
@@ -80,6 +108,7 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
     const Util::Array<Graphics::GraphicsEntityId>& observerIds = observerAllocator.GetArray<Observer_EntityId>();
     const Util::Array<VisibilityEntityType>& observerTypes = observerAllocator.GetArray<Observer_EntityType>();
     Util::Array<VisibilityResultArray>& observerResults = observerAllocator.GetArray<Observer_ResultArray>();
+    Util::Array<bool>& observerStatic = observerAllocator.GetArray<Observer_Static>();
 
     IndexT i;
     for (i = 0; i < observerIds.Size(); i++)
@@ -88,21 +117,29 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
         const VisibilityEntityType type = observerTypes[i];
 
         if (id == Graphics::GraphicsEntityId::Invalid())
+        {
+            observerStatic[i] = false;
             continue;
+        }
 
+        Math::mat4 transform;
         switch (type)
         {
         case Camera:
-            observerTransforms[i] = Graphics::CameraContext::GetViewProjection(id);
+            transform = Graphics::CameraContext::GetViewProjection(id);
             break;
         case Light:
-            observerTransforms[i] = Lighting::LightContext::GetObserverTransform(id);
+            transform = Lighting::LightContext::GetObserverTransform(id);
             break;
         case LightProbe:
-            observerTransforms[i] = Graphics::LightProbeContext::GetTransform(id);
+            transform = Graphics::LightProbeContext::GetTransform(id);
             break;
         default: n_error("unhandled enum"); break;
         }
+
+        // Observers which didn't move can reuse the results of the boxes which didn't either
+        observerStatic[i] = transform == observerTransforms[i];
+        observerTransforms[i] = transform;
     }
 
     // reset all lists to that all entities are visible
@@ -120,7 +157,7 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
         for (i = 0; i < ObserverContext::systems.Size(); i++)
         {
             VisibilitySystem* sys = ObserverContext::systems[i];
-            sys->PrepareObservers(observerTransforms.Begin(), observerIsOrthogonal.Begin(), observerResults.Begin(), observerTransforms.Size());
+            sys->PrepareObservers(observerTransforms.Begin(), observerIsOrthogonal.Begin(), observerStatic.Begin(), observerResults.Begin(), observerTransforms.Size());
         }
     }
 
@@ -130,6 +167,62 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
     nodes.Clear();
     nodes.Resize(observerResults[0].Size());
 
+    // Find the node instances whose box changed since the last frame
+    static Util::Array<Math::bbox> previousBoxes;
+    static Util::Array<uint64> dirtyBits;
+    static Threading::AtomicCounter dirtyCounter;
+    dirtyCounter = 0;
+    const SizeT numNodeInstances = NodeInstances.nodeBoundingBoxes.Size();
+    if (numNodeInstances > 0)
+    {
+        struct DirtyUpdateContext
+        {
+            const Math::bbox* boxes;
+            Math::bbox* previousBoxes;
+            uint64* dirtyBits;
+            SizeT numPrevious;
+            SizeT numNodeInstances;
+        } dirtyCtx;
+
+        dirtyCtx.numPrevious = Math::min(previousBoxes.Size(), numNodeInstances);
+        dirtyCtx.numNodeInstances = numNodeInstances;
+        previousBoxes.Resize(numNodeInstances);
+        dirtyBits.Resize((numNodeInstances + 63) / 64);
+        dirtyCtx.boxes = NodeInstances.nodeBoundingBoxes.Begin();
+        dirtyCtx.previousBoxes = previousBoxes.Begin();
+        dirtyCtx.dirtyBits = dirtyBits.Begin();
+        dirtyCounter = 1;
+
+        // Each invocation owns one word of the bit set
+        Jobs2::JobDispatch([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(VisibilityDirtyUpdateJob, Graphics);
+
+            auto context = static_cast<DirtyUpdateContext*>(ctx);
+            for (IndexT i = 0; i < groupSize; i++)
+            {
+                IndexT word = i + invocationOffset;
+                if (word >= totalJobs)
+                    return;
+
+                uint64 bits = 0;
+                const IndexT first = word * 64;
+                const IndexT last = Math::min(first + 64, context->numNodeInstances);
+                for (IndexT j = first; j < last; j++)
+                {
+                    const Math::bbox& box = context->boxes[j];
+                    Math::bbox& previousBox = context->previousBoxes[j];
+                    if (j >= context->numPrevious || box.pmin != previousBox.pmin || box.pmax != previousBox.pmax)
+                    {
+                        bits = Util::SetBit(bits, j - first);
+                        previousBox = box;
+                    }
+                }
+                context->dirtyBits[word] = bits;
+            }
+        }, dirtyBits.Size(), 64, dirtyCtx, { &Particles::ParticleContext::ConstantUpdateCounter, &Models::ModelContext::LodUpdateCounter }, &dirtyCounter, nullptr);
+    }
+
     static Threading::AtomicCounter idCounter;
     idCounter = 1;
     if (NodeInstances.nodeBoundingBoxes.Size() > 0)
@@ -169,7 +262,7 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
         for (i = 0; i < ObserverContext::systems.Size(); i++)
         {
             VisibilitySystem* sys = ObserverContext::systems[i];
-            sys->PrepareEntities(NodeInstances.nodeBoundingBoxes.Begin(), nodes.Begin(), ids.Begin(), reinterpret_cast<uint32_t*>(NodeInstances.nodeFlags.Begin()), nodes.Size());
+            sys->PrepareEntities(NodeInstances.nodeBoundingBoxes.Begin(), nodes.Begin(), ids.Begin(), reinterpret_cast<uint32_t*>(NodeInstances.nodeFlags.Begin()), dirtyBits.Begin(), nodes.Size());
         }
     }
 
@@ -181,118 +274,204 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
         {
             VisibilitySystem* sys = ObserverContext::systems[i];
 
-            // Wait for transforms and bounding box updates to finish before we do the visibility testing
-            sys->Run(prevSystemCounters, { &idCounter, &Particles::ParticleContext::ConstantUpdateCounter, &Models::ModelContext::TransformsUpdateCounter });
+            // Wait for the bounding box and lod updates to finish before we do the visibility testing
+            sys->Run(prevSystemCounters, { &idCounter, &Particles::ParticleContext::ConstantUpdateCounter, &Models::ModelContext::LodUpdateCounter, &dirtyCounter });
             prevSystemCounters = sys->GetCompletionCounters();
         }
     }
 
+    // Clear last frame's visible flags, once the model and character contexts are done with them
+    static Threading::AtomicCounter visibleResetCounter;
+    visibleResetCounter = 0;
+    if (NodeInstances.nodeFlags.Size() > 0)
+    {
+        struct VisibleResetContext
+        {
+            Models::NodeInstanceFlags* flags;
+        } resetCtx;
+        resetCtx.flags = NodeInstances.nodeFlags.Begin();
+        visibleResetCounter = 1;
+
+        Jobs2::JobDispatch([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(VisibleFlagsReset, Graphics);
+            auto context = static_cast<VisibleResetContext*>(ctx);
+            for (IndexT i = 0; i < groupSize; i++)
+            {
+                IndexT index = i + invocationOffset;
+                if (index >= totalJobs)
+                    return;
+                context->flags[index] = UnsetBits(context->flags[index], Models::NodeInstanceFlags::NodeInstance_Visible);
+            }
+        }, NodeInstances.nodeFlags.Size(), 4096, resetCtx, { &Models::ModelContext::ConstantsUpdateCounter, &Characters::CharacterContext::ConstantUpdateCounter }, &visibleResetCounter, nullptr);
+    }
+
     static Threading::AtomicCounter completionCounter;
-    completionCounter = observerResults.Size();
     Threading::Event* finishedEvent = new Threading::Event;
 
-    for (i = 0; i < observerResults.Size(); i++)
-    {
-        // early abort empty visibility queries
-        if (NodeInstances.nodeStates.Size() == 0)
-        {
-            continue;
-        }
+    // early abort empty visibility queries, but still signal that the draw lists are done
+    const bool buildDrawLists = NodeInstances.nodeStates.Size() > 0 && nodes.Size() > 0;
+    completionCounter = buildDrawLists ? observerResults.Size() : 0;
+    if (completionCounter == 0)
+        finishedEvent->Signal();
 
+    while (drawListBuilds.Size() < observerResults.Size())
+        drawListBuilds.Append(DrawListBuild());
+
+    for (i = 0; i < observerResults.Size() && buildDrawLists; i++)
+    {
         const VisibilityResultArray& results = observerResults[i];
         VisibilityDrawList& visibilities = observerAllocator.Get<Observer_DrawList>(i);
-        Memory::ArenaAllocator<1024>& allocator = observerAllocator.Get<Observer_DrawListAllocator>(i);
+        Util::Array<Memory::ArenaAllocator<1024>>& allocators = observerAllocator.Get<Observer_DrawListAllocator>(i);
+        DrawListBuild& build = drawListBuilds[i];
+
+        // Arenas are only added, chunks past the visible range release theirs
+        const SizeT numGatherChunks = (nodes.Size() + DrawListGatherChunkSize - 1) / DrawListGatherChunkSize;
+        const SizeT numBuildChunks = (nodes.Size() + DrawListBuildChunkSize - 1) / DrawListBuildChunkSize;
+        while (allocators.Size() < numBuildChunks)
+        {
+            allocators.Append(Memory::ArenaAllocator<1024>());
+            build.chunkBatches.Append(Util::Array<VisibilityBatchCommand>());
+            build.chunkMaterials.Append(Util::Array<Materials::ShaderConfig*>());
+        }
+        build.keys.Resize(nodes.Size());
+        build.mergedKeys.Resize(nodes.Size());
+        build.runOffsets.Resize(numGatherChunks);
+        build.runSizes.Resize(numGatherChunks);
 
         struct Context
         {
             Math::ClipStatus::Type* clipStatuses;
             uint32* ids;
+            SizeT numIds;
+            DrawListBuild* build;
             Visibility::ObserverContext::VisibilityDrawList* drawList;
-            Memory::ArenaAllocator<1024>* allocator;
+            Memory::ArenaAllocator<1024>* allocators;
             const Models::ModelContext::ModelInstance::Renderable* renderables;
         } jobCtx;
 
         jobCtx.clipStatuses = results.Begin();
         jobCtx.ids = nodes.Begin();
+        jobCtx.numIds = nodes.Size();
+        jobCtx.build = &build;
         jobCtx.drawList = &visibilities;
-        jobCtx.allocator = &allocator;
+        jobCtx.allocators = allocators.Begin();
         jobCtx.renderables = &NodeInstances;
 
         // Before we create our draws, we have to wait for the constants to be allocated first
         // For particles, that's done before visibility so we can omit it here
-        Util::Array<const Threading::AtomicCounter*> waitCounters =
+        Jobs2::JobWaitCounters waitCounters =
         {
             prevSystemCounters[i],
             &Models::ModelContext::ConstantsUpdateCounter,
             &Characters::CharacterContext::ConstantUpdateCounter,
+            &visibleResetCounter,
         };
 
-        Jobs2::JobDispatch([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        Jobs2::JobBeginSequence(waitCounters, &completionCounter, finishedEvent);
+
+        // Each chunk of ids gathers the visible node instances and sorts them on its own
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
         {
             N_SCOPE(VisibilitySortJob, Graphics);
             auto context = static_cast<Context*>(ctx);
-            context->allocator->Release();
-
-            // calculate amount of models
-            uint32 numNodeInstances = totalJobs;
-
-            if (numNodeInstances == 0)
+            if (invocationOffset >= totalJobs)
                 return;
 
-            Util::Array<uint64> indexBuffer(numNodeInstances, 0);
-            Util::Array<Math::ClipStatus::Type> clipStatuses(context->clipStatuses, numNodeInstances);
-            for (uint32 i = 0; i < numNodeInstances; i++)
+            const IndexT chunk = invocationOffset;
+            const IndexT first = chunk * DrawListGatherChunkSize;
+            const IndexT last = Math::min(first + DrawListGatherChunkSize, context->numIds);
+            uint64* keys = context->build->keys.Begin() + first;
+            SizeT numKeys = 0;
+            for (IndexT i = first; i < last; i++)
             {
                 // Make sure we're not exceeding the number of bits in the index buffer reserved for the actual node instance
-                n_assert(context->ids[i] < 0xFFFFFFFF);
-                indexBuffer.Append(context->ids[i]);
-            }
+                const uint32 index = context->ids[i];
+                n_assert(index < 0xFFFFFFFF);
 
-            // loop over each node and give them the appropriate weight
-            uint32 i = 0;
-            while (i < indexBuffer.Size())
-            {
-                n_assert(indexBuffer[i] < 0x00000000FFFFFFFF);
-                uint64 index = indexBuffer[i] & 0x00000000FFFFFFFF;
-                Math::ClipStatus::Type clipStatus = clipStatuses[i];
-
-                // If not visible nor active, erase item from index list
-                if (!AllBits(context->renderables->nodeFlags[index], Models::NodeInstanceFlags::NodeInstance_Active)
-                    || clipStatus == Math::ClipStatus::Outside)
-                {
-                    indexBuffer.EraseIndexSwap(i);
-                    clipStatuses.EraseIndexSwap(i);
+                // If not visible nor active, or out of its LOD range, leave it out
+                if (!AllBits(context->renderables->nodeFlags[index], Models::NodeInstanceFlags::NodeInstance_Active | Models::NodeInstanceFlags::NodeInstance_LodActive)
+                    || context->clipStatuses[i] == Math::ClipStatus::Outside)
                     continue;
-                }
-                else
-                {
-                    // Set the node visible flag (use this to figure out if a node is seen by __any__ observer)
-                    context->renderables->nodeFlags[index] = SetBits(context->renderables->nodeFlags[index], Models::NodeInstanceFlags::NodeInstance_Visible);
-                }
+
+                // Set the node visible flag (use this to figure out if a node is seen by __any__ observer)
+                context->renderables->nodeFlags[index] = SetBits(context->renderables->nodeFlags[index], Models::NodeInstanceFlags::NodeInstance_Visible);
 
                 // Get sort id and combine with index to get full sort id
-                uint64 sortId = context->renderables->nodeSortId[index];
-                indexBuffer[i] = sortId | index;
-                i++;
+                keys[numKeys++] = context->renderables->nodeSortId[index] | index;
             }
+            std::sort(keys, keys + numKeys);
+            context->build->runOffsets[chunk] = first;
+            context->build->runSizes[chunk] = numKeys;
+        }, numGatherChunks, 1, jobCtx);
 
-            if (indexBuffer.IsEmpty())
-                return; // early out
+        // Merge the sorted chunks pairwise, and size the packet list for the chunks which build it
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(VisibilitySortMergeJob, Graphics);
+            auto context = static_cast<Context*>(ctx);
+            DrawListBuild* build = context->build;
 
-            // sort the index buffer
-            std::qsort(indexBuffer.Begin(), indexBuffer.Size(), sizeof(uint64), [](const void* a, const void* b)
+            uint64* from = build->keys.Begin();
+            uint64* to = build->mergedKeys.Begin();
+            SizeT numRuns = build->runSizes.Size();
+            while (numRuns > 1)
             {
-                uint64 arg1 = *static_cast<const uint64*>(a);
-                uint64 arg2 = *static_cast<const uint64*>(b);
-                return (arg1 > arg2) - (arg1 < arg2);
-            });
+                SizeT offset = 0;
+                SizeT numMerged = 0;
+                for (IndexT run = 0; run < numRuns; run += 2)
+                {
+                    const uint64* first = from + build->runOffsets[run];
+                    const SizeT size = build->runSizes[run];
+                    SizeT mergedSize = size;
+                    if (run + 1 < numRuns)
+                    {
+                        const uint64* second = from + build->runOffsets[run + 1];
+                        mergedSize += build->runSizes[run + 1];
+                        std::merge(first, first + size, second, second + build->runSizes[run + 1], to + offset);
+                    }
+                    else
+                    {
+                        std::copy(first, first + size, to + offset);
+                    }
+
+                    // Runs are read before the merged one is written over them
+                    build->runOffsets[numMerged] = offset;
+                    build->runSizes[numMerged] = mergedSize;
+                    offset += mergedSize;
+                    numMerged++;
+                }
+                std::swap(from, to);
+                numRuns = numMerged;
+            }
 
-            // Now resolve the indexbuffer into draw commands
-            uint32 numDraws = 0;
-            const uint32 numPackets = indexBuffer.Size();
-            context->drawList->drawPackets.Reserve(numPackets);
+            build->sortedKeys = from + build->runOffsets[0];
+            build->numVisible = build->runSizes[0];
+            context->drawList->drawPackets.Resize(build->numVisible);
+        }, 1, jobCtx);
+
+        // Resolve chunks of the sorted range into draw packets and commands, each into its own arena
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(VisibilityDrawListBuildJob, Graphics);
+            auto context = static_cast<Context*>(ctx);
+            if (invocationOffset >= totalJobs)
+                return;
+
+            const IndexT chunk = invocationOffset;
+            DrawListBuild* build = context->build;
+            Memory::ArenaAllocator<1024>* allocator = &context->allocators[chunk];
+            Util::Array<ObserverContext::VisibilityBatchCommand>& batches = build->chunkBatches[chunk];
+            Util::Array<Materials::ShaderConfig*>& materials = build->chunkMaterials[chunk];
+            allocator->Release();
+            batches.Clear();
+            materials.Clear();
+
+            const IndexT first = chunk * DrawListBuildChunkSize;
+            if (first >= build->numVisible)
+                return;
+            const IndexT last = Math::min(first + DrawListBuildChunkSize, build->numVisible);
 
-            // Allocate single command which we can 
             ObserverContext::VisibilityBatchCommand* cmd = nullptr;
             CoreGraphics::MeshId mesh = CoreGraphics::InvalidMeshId;
             Materials::MaterialId mat = Materials::InvalidMaterialId;
@@ -300,22 +479,23 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
             Util::Tuple<uint32, uint32> drawModifiers = NullDrawModifiers;
             Materials::ShaderConfig* currentMaterialType = nullptr;
 
-            for (uint32 i = 0; i < numPackets; i++)
+            for (IndexT i = first; i < last; i++)
             {
-                uint32 index = indexBuffer[i] & 0x00000000FFFFFFFF;
+                uint32 index = build->sortedKeys[i] & 0x00000000FFFFFFFF;
 
-                // If new material, add a new entry into the lookup table
+                // If new material, start a new batch, the merge job puts them into the lookup table
                 auto otherMaterialType = context->renderables->nodeShaderConfigs[index];
                 if (currentMaterialType != otherMaterialType)
                 {
-                    // Add new draw command and get reference to it
-                    cmd = &context->drawList->visibilityTable.Emplace(otherMaterialType);
+                    cmd = &batches.Emplace();
+                    materials.Append(otherMaterialType);
 
                     // Setup initial state for command
-                    cmd->packetOffset = numDraws;
+                    cmd->packetOffset = i;
                     cmd->numDrawPackets = 0;
 
                     mesh = CoreGraphics::InvalidMeshId;
+                    mat = Materials::InvalidMaterialId;
                     drawModifiers = NullDrawModifiers;
                     currentMaterialType = otherMaterialType;
                 }
@@ -338,6 +518,7 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
                     batchCmd.nodeName = context->renderables->nodeNames[index];
 #endif
                     mesh = otherMesh;
+                    mat = otherMat;
                 }
 
                 // If a new set of draw modifiers (instance count and base instance) are used, insert a new draw command
@@ -353,9 +534,9 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
                 }
 
                 // allocate memory for draw packet
-                void* mem = context->allocator->Alloc(sizeof(Models::ShaderStateNode::DrawPacket));
+                void* mem = allocator->Alloc(sizeof(Models::ShaderStateNode::DrawPacket));
 
-                // update packet and add to list
+                // update packet and put it in its place in the list
                 Models::ShaderStateNode::DrawPacket* packet = reinterpret_cast<Models::ShaderStateNode::DrawPacket*>(mem);
                 packet->numOffsets[0] = context->renderables->nodeStates[index].resourceTableOffsets.Size();
                 packet->numTables = 1;
@@ -367,12 +548,51 @@ ObserverContext::RunVisibilityTests(const Graphics::FrameContext& ctx)
 #endif
                 memcpy(packet->offsets[0], context->renderables->nodeStates[index].resourceTableOffsets.Begin(), context->renderables->nodeStates[index].resourceTableOffsets.ByteSize());
                 packet->slots[0] = NEBULA_DYNAMIC_OFFSET_GROUP;
-                context->drawList->drawPackets.Append(packet);
+                context->drawList->drawPackets[i] = packet;
                 cmd->numDrawPackets++;
-                numDraws++;
             }
-        },
-        nodes.Size(), jobCtx, waitCounters, &completionCounter, finishedEvent);
+        }, allocators.Size(), 1, jobCtx);
+
+        // Put the batches of all chunks into the lookup table by material
+        Jobs2::JobAppendSequence([](SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+        {
+            N_SCOPE(VisibilityDrawListMergeJob, Graphics);
+            auto context = static_cast<Context*>(ctx);
+            DrawListBuild* build = context->build;
+
+            ObserverContext::VisibilityBatchCommand* cmd = nullptr;
+            Materials::ShaderConfig* currentMaterialType = nullptr;
+            const SizeT numChunks = (build->numVisible + DrawListBuildChunkSize - 1) / DrawListBuildChunkSize;
+            for (IndexT chunk = 0; chunk < numChunks; chunk++)
+            {
+                Util::Array<ObserverContext::VisibilityBatchCommand>& batches = build->chunkBatches[chunk];
+                const Util::Array<Materials::ShaderConfig*>& materials = build->chunkMaterials[chunk];
+                for (IndexT batch = 0; batch < batches.Size(); batch++)
+                {
+                    ObserverContext::VisibilityBatchCommand& part = batches[batch];
+                    if (cmd == nullptr || currentMaterialType != materials[batch])
+                    {
+                        cmd = &context->drawList->visibilityTable.Emplace(materials[batch]);
+                        *cmd = std::move(part);
+                        currentMaterialType = materials[batch];
+                        continue;
+                    }
+
+                    // The batch goes on from the previous chunk, which may already have applied the first model and draw modifiers
+                    const ObserverContext::VisibilityModelCommand& lastModel = cmd->models.Back();
+                    const ObserverContext::VisibilityDrawCommand& lastDraw = cmd->draws.Back();
+                    const IndexT firstModel = part.models[0].mesh == lastModel.mesh && part.models[0].material == lastModel.material ? 1 : 0;
+                    const IndexT firstDraw = part.draws[0].numInstances == lastDraw.numInstances && part.draws[0].baseInstance == lastDraw.baseInstance ? 1 : 0;
+                    if (firstModel < part.models.Size())
+                        cmd->models.AppendArray(part.models.Begin() + firstModel, part.models.Size() - firstModel);
+                    if (firstDraw < part.draws.Size())
+                        cmd->draws.AppendArray(part.draws.Begin() + firstDraw, part.draws.Size() - firstDraw);
+                    cmd->numDrawPackets += part.numDrawPackets;
+                }
+            }
+        }, 1, jobCtx);
+
+        Jobs2::JobEndSequence();
     }
 
     waitEvents.Enqueue(finishedEvent);
@@ -477,6 +697,32 @@ ObserverContext::CreateBruteforceSystem(const BruteforceSystemLoadInfo& info)
     return system;
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+VisibilitySystem*
+ObserverContext::CreateOcclusionSystem(const OcclusionSystemLoadInfo& info)
+{
+    n_assert(!ObserverContext::systems.IsEmpty());
+    OcclusionSystem* system = new OcclusionSystem;
+    system->Setup(info);
+    ObserverContext::systems.Append(system);
+    return system;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+VisibilitySystem*
+ObserverContext::CreateContributionSystem(const ContributionSystemLoadInfo& info)
+{
+    n_assert(!ObserverContext::systems.IsEmpty());
+    ContributionSystem* system = new ContributionSystem;
+    system->Setup(info);
+    ObserverContext::systems.Append(system);
+    return system;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -548,9 +794,9 @@ ObserverContext::OnRenderDebug(uint32_t flags)
     }
 
     Util::Array<VisibilityResultArray>& vis = observerAllocator.GetArray<Observer_ResultArray>();
-    Util::FixedArray<SizeT> insideCounters(vis.Size(), 0);
-    Util::FixedArray<SizeT> clippedCounters(vis.Size(), 0);
-    Util::FixedArray<SizeT> totalCounters(vis.Size(), 0);
+    Util::FixedArray<SizeT, Jobs2::JobScratchAllocator> insideCounters(vis.Size(), 0);
+    Util::FixedArray<SizeT, Jobs2::JobScratchAllocator> clippedCounters(vis.Size(), 0);
+    Util::FixedArray<SizeT, Jobs2::JobScratchAllocator> totalCounters(vis.Size(), 0);
     for (IndexT i = 0; i < vis.Size(); i++)
     {
         auto res = vis[i];
@@ -581,6 +827,22 @@ ObserverContext::OnRenderDebug(uint32_t flags)
         {
             ImGui::Text("Entities visible for observer %d: %d (inside [%d], clipped [%d])", i, totalCounters[i], insideCounters[i], clippedCounters[i]);
         }
+
+        // How many box tests were saved by reusing last frame's results
+        const Util::Array<bool>& observerStatic = observerAllocator.GetArray<Observer_Static>();
+        for (IndexT i = 0; i < vis.Size(); i++)
+        {
+            SizeT tested = 0, skipped = 0;
+            for (IndexT j = 0; j < ObserverContext::systems.Size(); j++)
+            {
+                SizeT systemTested, systemSkipped;
+                ObserverContext::systems[j]->GetTestStatistics(i, systemTested, systemSkipped);
+                tested += systemTested;
+                skipped += systemSkipped;
+            }
+            const float share = tested + skipped > 0 ? 100.0f * skipped / (tested + skipped) : 0.0f;
+            ImGui::Text("Box tests skipped for observer %d: %d of %d (%.1f%%)%s", i, skipped, tested + skipped, share, observerStatic[i] ? ", static" : "");
+        }
     }   
     ImGui::End();
 }
@@ -605,7 +867,9 @@ ObserverContext::GetVisibilityDrawList(const Graphics::GraphicsEntityId id)
 Graphics::ContextEntityId
 ObserverContext::Alloc()
 {
-    return observerAllocator.Alloc();
+    Ids::Id32 id = observerAllocator.Alloc();
+    observerAllocator.Set<Observer_Static>(id, false);
+    return id;
 }
 
 //------------------------------------------------------------------------------
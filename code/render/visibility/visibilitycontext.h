@@ -37,6 +37,7 @@ enum
     Observer_DependencyMode,
     Observer_DrawList,
     Observer_DrawListAllocator,
+    Observer_Static,
 };
 
 enum
@@ -83,7 +84,7 @@ public:
 
     /// create a box system
     static VisibilitySystem* CreateBoxSystem(const BoxSystemLoadInfo& info);
-    /// create a portal system
+    /// create a portal system, it does the frustum culling for scenes which are split into cells
     static VisibilitySystem* CreatePortalSystem(const PortalSystemLoadInfo& info);
     /// create octree system
     static VisibilitySystem* CreateOctreeSystem(const OctreeSystemLoadInfo& info);
@@ -91,6 +92,10 @@ public:
     static VisibilitySystem* CreateQuadtreeSystem(const QuadtreeSystemLoadInfo& info);
     /// create brute force system
     static VisibilitySystem* CreateBruteforceSystem(const BruteforceSystemLoadInfo& info);
+    /// create occlusion system, has to come after the system which does the frustum culling
+    static VisibilitySystem* CreateOcclusionSystem(const OcclusionSystemLoadInfo& info);
+    /// create contribution system, has to come after the system which does the frustum culling
+    static VisibilitySystem* CreateContributionSystem(const ContributionSystemLoadInfo& info);
 
     /// wait for all visibility jobs
     static void WaitForVisibility(const Graphics::FrameContext& ctx);
@@ -159,7 +164,8 @@ private:
         , Graphics::GraphicsEntityId               // dependency
         , DependencyMode                           // dependency mode
         , VisibilityDrawList                       // draw list
-        , Memory::ArenaAllocator<1024>             // memory allocator for draw commands
+        , Util::Array<Memory::ArenaAllocator<1024>> // memory allocators for draw packets, one per draw list chunk
+        , bool                                     // observer hasn't moved since the last frame
     > ObserverAllocator;
     static ObserverAllocator observerAllocator;
 
@@ -7,6 +7,7 @@
 #include "io/ioserver.h"
 #include "resourceserver.h"
 #include "util/bit.h"
+#include "math/scalar.h"
 
 using namespace IO;
 namespace Resources
@@ -17,11 +18,14 @@ __ImplementAbstractClass(Resources::ResourceLoader, 'RSLO', Core::RefCounted);
 /**
 */
 ResourceLoader::ResourceLoader() :
-    async(false)
+    async(false),
+    streamBytesInFlight(0),
+    streamBytesResident(0)
 {
     // maybe this is arrogant, just 1024 pending resources (actual resources that is) per loader?
     this->pendingLoads.Reserve(1024);
     this->pendingStreamLods.Reserve(1024);
+    this->dequeuedStreamLods.Reserve(1024);
     this->pendingStreamQueue.SetSignalOnEnqueueEnabled(false);
     this->creatorThread = Threading::Thread::GetMyThreadId();
 }
@@ -138,6 +142,26 @@ ResourceLoader::RequestLOD(const Ids::Id32 entry, float lod) const
     // Do nothing
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+uint64
+ResourceLoader::LodBytes(const Ids::Id32 entry, uint bits) const
+{
+    // Assume the loader doesn't stream, whereby it's never held back by the streaming budget
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+uint
+ResourceLoader::EvictLod(const Resources::ResourceId& id, uint loadedBits, uint keepBits)
+{
+    // Assume the loader can't drop subresources once loaded
+    return loadedBits;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -145,6 +169,9 @@ void
 ResourceLoader::Update(IndexT frameIndex)
 {
     IndexT i;
+    if (this->async)
+        this->FlushOverflowJobs();
+
     for (i = this->pendingLoads.Size() - 1; i >= 0; i--)
     {
         // get pending element
@@ -165,21 +192,8 @@ ResourceLoader::Update(IndexT frameIndex)
         resourceLoad.mode = _PendingResourceLoad::None;
     }
 
-    // go through pending lod streams
-    this->pendingStreamQueue.DequeueAll(this->pendingStreamLods);
-    for (i = 0; i < this->pendingStreamLods.Size(); i++)
-    {
-        const _PendingStreamLod& streamLod = this->pendingStreamLods[i];
-
-        this->asyncSection.Enter();
-        _PendingResourceLoad& load = this->loads[streamLod.id.loaderInstanceId];
-        load.lod = streamLod.lod;
-        load.mode |= _PendingResourceLoad::Update;
-
-        // Update state to continue streaming
-        this->pendingLoads.Append(streamLod.id.loaderInstanceId);
-        this->asyncSection.Leave();
-    }
+    // gather pending lod streams, these are issued by the ResourceStreamScheduler once all loaders are updated
+    this->MergePendingStreamLods(frameIndex);
 
     // go through pending unloads
     for (i = this->pendingUnloads.Size() - 1; i >= 0; i--)
@@ -192,6 +206,8 @@ ResourceLoader::Update(IndexT frameIndex)
                 // unload if loaded
                 this->Unload(unload.resourceId);
                 this->states[unload.resourceId.loaderInstanceId] = Resource::Unloaded;
+                Threading::Interlocked::Add(&this->streamBytesResident, -(int64)this->residentLodBytes[unload.resourceId.loaderInstanceId]);
+                this->residentLodBytes[unload.resourceId.loaderInstanceId] = 0;
             }
 
             // give up the resource id
@@ -203,6 +219,163 @@ ResourceLoader::Update(IndexT frameIndex)
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+    Requests for a resource which is already waiting to be streamed are folded into
+    the existing request, so a resource only ever has one pending stream request.
+    The frame of the last request decides which lods are evicted first.
+*/
+void
+ResourceLoader::MergePendingStreamLods(IndexT frameIndex)
+{
+    this->pendingStreamQueue.DequeueAll(this->dequeuedStreamLods);
+    IndexT i;
+    for (i = 0; i < this->dequeuedStreamLods.Size(); i++)
+    {
+        const _PendingStreamLod& streamLod = this->dequeuedStreamLods[i];
+        const Ids::Id32 entry = streamLod.id.loaderInstanceId;
+        this->lastLodRequestFrame[entry] = frameIndex;
+
+        IndexT index = this->pendingStreamIndex[entry];
+        if (index == InvalidIndex)
+        {
+            this->pendingStreamIndex[entry] = this->pendingStreamLods.Size();
+            this->pendingStreamLods.Append(streamLod);
+        }
+        else
+        {
+            _PendingStreamLod& merged = this->pendingStreamLods[index];
+            merged.lod = Math::min(merged.lod, streamLod.lod);
+            merged.priority = Math::max(merged.priority, streamLod.priority);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoader::CompactPendingStreamLods()
+{
+    IndexT i;
+    for (i = this->pendingStreamLods.Size() - 1; i >= 0; i--)
+    {
+        const _PendingStreamLod& streamLod = this->pendingStreamLods[i];
+        if (streamLod.id == ResourceId::Invalid())
+        {
+            this->pendingStreamLods.EraseIndexSwap(i);
+            continue;
+        }
+
+        // requests for resources which have been unloaded since are dropped
+        const Resource::State state = this->states[streamLod.id.loaderInstanceId];
+        if (state == Resource::Unloaded || state == Resource::Failed)
+        {
+            this->pendingStreamIndex[streamLod.id.loaderInstanceId] = InvalidIndex;
+            this->pendingStreamLods.EraseIndexSwap(i);
+        }
+    }
+
+    // the swap erase moves requests around, so point the entries to their new slots
+    for (i = 0; i < this->pendingStreamLods.Size(); i++)
+        this->pendingStreamIndex[this->pendingStreamLods[i].id.loaderInstanceId] = i;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Resources which haven't been initialized yet report no cost, since their lod
+    is applied together with the initial load.
+*/
+bool
+ResourceLoader::PendingStreamBytes(const _PendingStreamLod& streamLod, uint64& outBytes)
+{
+    const Ids::Id32 entry = streamLod.id.loaderInstanceId;
+    bool pending = true;
+    outBytes = 0;
+
+    this->asyncSection.Enter();
+    if (this->states[entry] == Resource::Loaded)
+    {
+        uint bits = this->LodMask(entry, streamLod.lod) & ~this->loadedBits[entry];
+        if (bits == 0x0)
+            pending = false;
+        else
+            outBytes = this->LodBytes(entry, bits);
+    }
+    this->asyncSection.Leave();
+    return pending;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoader::IssueStreamLod(IndexT index, uint64 bytes)
+{
+    n_assert(Threading::Thread::GetMyThreadId() == this->creatorThread);
+    _PendingStreamLod& streamLod = this->pendingStreamLods[index];
+    const Ids::Id32 entry = streamLod.id.loaderInstanceId;
+
+    this->asyncSection.Enter();
+    _PendingResourceLoad& load = this->loads[entry];
+    load.lod = streamLod.lod;
+    load.mode |= _PendingResourceLoad::Update;
+    load.streamBytes += bytes;
+
+    // Update state to continue streaming
+    this->pendingLoads.Append(entry);
+    this->asyncSection.Leave();
+
+    if (bytes > 0)
+        Threading::Interlocked::Add(&this->streamBytesInFlight, (int64)bytes);
+
+    this->DropStreamLod(index);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceLoader::DropStreamLod(IndexT index)
+{
+    // mark as done, the request is removed when compacting
+    _PendingStreamLod& streamLod = this->pendingStreamLods[index];
+    this->pendingStreamIndex[streamLod.id.loaderInstanceId] = InvalidIndex;
+    streamLod.id = ResourceId::Invalid();
+}
+
+//------------------------------------------------------------------------------
+/**
+    The eviction is queued like any other load, so it runs on the loader thread
+    after the streams which are already in flight for the resource. The memory
+    is accounted as released right away, the loader thread settles the difference
+    once the lods are actually dropped.
+*/
+uint64
+ResourceLoader::EvictStreamLods(const Ids::Id32 entry)
+{
+    n_assert(Threading::Thread::GetMyThreadId() == this->creatorThread);
+    uint64 freed = 0;
+
+    this->asyncSection.Enter();
+    _PendingResourceLoad& load = this->loads[entry];
+    if (this->states[entry] == Resource::Loaded
+        && this->residentLodBytes[entry] > 0
+        && this->pendingStreamIndex[entry] == InvalidIndex
+        && load.mode == _PendingResourceLoad::None)
+    {
+        freed = this->residentLodBytes[entry];
+        this->residentLodBytes[entry] = 0;
+        load.mode = _PendingResourceLoad::Evict;
+        this->pendingLoads.Append(entry);
+    }
+    this->asyncSection.Leave();
+
+    if (freed > 0)
+        Threading::Interlocked::Add(&this->streamBytesResident, -(int64)freed);
+    return freed;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -291,6 +464,7 @@ _LoadInternal(ResourceLoader* loader, const ResourceLoader::_PendingResourceLoad
             resource.resourceId = internalResource.resourceId;
             resource.resourceType = internalResource.resourceType;
             requestedBits = loader->LodMask(res.entry, res.lod);
+            loader->baseBits[res.entry] = requestedBits;
 
             if (internalResource == InvalidResourceUnknownId)
             {
@@ -312,6 +486,14 @@ _LoadInternal(ResourceLoader* loader, const ResourceLoader::_PendingResourceLoad
         }
     }
 
+    if (AllBits(res.mode, ResourceLoader::_PendingResourceLoad::Evict))
+    {
+        // Drop back to the lods the resource was created with, the rest is streamed again when requested
+        requestedBits = loader->baseBits[res.entry];
+        loadedBits = loader->EvictLod(resource, loader->loadedBits[res.entry], requestedBits);
+        goto skip_stream;
+    }
+
     if (AllBits(res.mode, ResourceLoader::_PendingResourceLoad::Update))
     {
         requestedBits |= loader->LodMask(res.entry, res.lod);
@@ -335,6 +517,13 @@ skip_stream:
     loader->states[res.entry] = state;
     loader->resources[res.entry] = resource;
 
+    // account for the memory streamed on top of the base lods, and retire the bytes this load was scheduled with
+    uint64 resident = state == Resource::Failed ? 0 : loader->LodBytes(res.entry, loadedBits & ~loader->baseBits[res.entry]);
+    Threading::Interlocked::Add(&loader->streamBytesResident, (int64)resident - (int64)loader->residentLodBytes[res.entry]);
+    loader->residentLodBytes[res.entry] = resident;
+    if (res.streamBytes > 0)
+        Threading::Interlocked::Add(&loader->streamBytesInFlight, -(int64)res.streamBytes);
+
     // We run the callbacks if the resource loaded or failed
     if (state == Resource::Loaded || state == Resource::Failed)
         loader->RunCallbacks(state, resource);
@@ -370,14 +559,16 @@ ResourceLoader::LoadImmediate(_PendingResourceLoad& res)
 void
 ResourceLoader::LoadAsync(_PendingResourceLoad& res)
 {
-    // Create callable function
+    // Create callable function, the streamed bytes are handed to this load only
     auto loadFunc = std::bind(_LoadInternal, this, res);
+    res.streamBytes = 0;
 
-    // If async, add function call to thread
+    // If async, add function call to thread, loads which don't fit keep their order in the overflow list
     if (this->async)
     {
         res.inflight = true;
-        this->streamerThread->jobs.Enqueue(loadFunc);
+        if (!this->overflowJobs.IsEmpty() || !this->streamerThread->jobs.TryEnqueue(loadFunc))
+            this->overflowJobs.Append(loadFunc);
     }
     else
     {
@@ -386,6 +577,26 @@ ResourceLoader::LoadAsync(_PendingResourceLoad& res)
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+    The main thread never waits for the loader thread to make room, a camera
+    cut can request far more loads in one frame than the queue holds, so
+    the rest is handed over in the following frames.
+*/
+bool
+ResourceLoader::FlushOverflowJobs()
+{
+    IndexT i;
+    for (i = 0; i < this->overflowJobs.Size(); i++)
+    {
+        if (!this->streamerThread->jobs.TryEnqueue(this->overflowJobs[i]))
+            break;
+    }
+    if (i > 0)
+        this->overflowJobs.EraseRange(0, i);
+    return this->overflowJobs.IsEmpty();
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -414,11 +625,15 @@ Resources::ResourceLoader::CreateResource(const ResourceName& res, const void* l
             this->states.Resize(this->states.Size() + ResourceIndexGrow);
             this->requestedBits.Resize(this->requestedBits.Size() + ResourceIndexGrow);
             this->loadedBits.Resize(this->loadedBits.Size() + ResourceIndexGrow);
+            this->baseBits.Resize(this->baseBits.Size() + ResourceIndexGrow);
             this->resources.Resize(this->resources.Size() + ResourceIndexGrow);
             this->callbacks.Resize(this->callbacks.Size() + ResourceIndexGrow);
             this->loads.Resize(this->loads.Size() + ResourceIndexGrow);
             this->metaData.Resize(this->metaData.Size() + ResourceIndexGrow);
             this->streams.Resize(this->streams.Size() + ResourceIndexGrow);
+            this->residentLodBytes.Resize(this->residentLodBytes.Size() + ResourceIndexGrow);
+            this->pendingStreamIndex.Resize(this->pendingStreamIndex.Size() + ResourceIndexGrow);
+            this->lastLodRequestFrame.Resize(this->lastLodRequestFrame.Size() + ResourceIndexGrow);
         }
 
         // add the resource name to the resource id
@@ -427,7 +642,11 @@ Resources::ResourceLoader::CreateResource(const ResourceName& res, const void* l
         this->tags[instanceId] = tag;
         this->states[instanceId] = Resource::Pending;
         this->loadedBits[instanceId] = 0x0;
+        this->baseBits[instanceId] = 0x0;
         this->requestedBits[instanceId] = 0xFFFFFFFF;
+        this->residentLodBytes[instanceId] = 0;
+        this->pendingStreamIndex[instanceId] = InvalidIndex;
+        this->lastLodRequestFrame[instanceId] = InvalidIndex;
 
         // allocate metadata if present
         _LoadMetaData metaData;
@@ -596,6 +815,8 @@ Resources::ResourceLoader::DiscardResource(const Resources::ResourceId id)
             {
                 this->Unload(id);
                 this->states[id.loaderInstanceId] = Resource::Unloaded;
+                Threading::Interlocked::Add(&this->streamBytesResident, -(int64)this->residentLodBytes[id.loaderInstanceId]);
+                this->residentLodBytes[id.loaderInstanceId] = 0;
             }
             this->resourceInstanceIndexPool.Dealloc(id.loaderInstanceId);
         }
@@ -723,7 +944,7 @@ ResourceLoader::ReloadResource(const Resources::ResourceId& id, std::function<vo
 /**
 */
 void 
-ResourceLoader::SetMinLod(const Resources::ResourceId& id, const float lod, bool immediate)
+ResourceLoader::SetMinLod(const Resources::ResourceId& id, const float lod, bool immediate, float priority)
 {
     if (immediate)
     {
@@ -734,6 +955,7 @@ ResourceLoader::SetMinLod(const Resources::ResourceId& id, const float lod, bool
         _PendingStreamLod pending;
         pending.id = id;
         pending.lod = lod;
+        pending.priority = priority;
         pending.immediate = immediate;
         this->pendingStreamQueue.Enqueue(pending);
     }
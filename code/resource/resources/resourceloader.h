@@ -27,6 +27,12 @@
     Resources created with tags must also be removed using the tag. A tagged resource can only
     be discarded by using that tag. If a resource is loaded with a tag, it will remain bound
     to that tag, no matter what consecutive loads say. 
+
+    LOD requests made through SetMinLod are not serviced directly. They are collected
+    every frame and handed to the ResourceStreamScheduler owned by the ResourceServer,
+    which decides which of them are streamed in based on priority and the streaming budget.
+    Loaders which want their LODs to be budgeted need to implement LodBytes, and loaders
+    which can drop LODs again under memory pressure need to implement EvictLod.
     
     @copyright
     (C) 2017-2020 Individual contributors, see AUTHORS file
@@ -40,6 +46,7 @@
 #include "threading/safequeue.h"
 #include "threading/threadid.h"
 #include "ids/idpool.h"
+#include "threading/interlocked.h"
 #include <tuple>
 #include <functional>
 
@@ -47,6 +54,7 @@ namespace Resources
 {
 class Resource;
 class ResourceLoaderThread;
+class ResourceStreamScheduler;
 class ResourceLoader : public Core::RefCounted
 {
     __DeclareAbstractClass(ResourceLoader);
@@ -97,11 +105,12 @@ public:
     /// reload resource using resource id
     void ReloadResource(const Resources::ResourceId& id, std::function<void(const Resources::ResourceId)> success, std::function<void(const Resources::ResourceId)> failed);
 
-    /// begin updating a resources lod
-    void SetMinLod(const Resources::ResourceId& id, const float lod, bool immediate);
+    /// begin updating a resources lod, requests with a higher priority are streamed first
+    void SetMinLod(const Resources::ResourceId& id, const float lod, bool immediate, float priority = 0.0f);
 
 protected:
     friend class ResourceServer;
+    friend class ResourceStreamScheduler;
 
     /// struct for pending resources which are about to be loaded
     struct _PendingResourceLoad
@@ -112,16 +121,18 @@ protected:
         bool immediate;
         bool reload;
         float lod;
+        uint64 streamBytes;
 
         enum Mode
         {
             None = 0x0,
             Create = 0x1,
-            Update = 0x2
+            Update = 0x2,
+            Evict = 0x4
         };
         uint mode;
 
-        _PendingResourceLoad() : entry(-1) {};
+        _PendingResourceLoad() : entry(-1), streamBytes(0) {};
     };
 
     /// struct for pending stream
@@ -129,9 +140,10 @@ protected:
     {
         Resources::ResourceId id;
         float lod;
+        float priority;
         bool immediate;
 
-        _PendingStreamLod() : id(ResourceId::Invalid()) {};
+        _PendingStreamLod() : id(ResourceId::Invalid()), lod(1.0f), priority(0.0f), immediate(false) {};
     };
 
     struct _PendingResourceUnload
@@ -175,6 +187,10 @@ protected:
     virtual uint LodMask(const Ids::Id32 entry, float lod) const;
     /// Set lod factor for resource
     virtual void RequestLOD(const Ids::Id32 entry, float lod) const;
+    /// Get the amount of memory occupied by the subresources in the mask, returning 0 opts the loader out of streaming budgets
+    virtual uint64 LodBytes(const Ids::Id32 entry, uint bits) const;
+    /// Drop the loaded subresources which aren't in keepBits, returns the subresources which remain loaded
+    virtual uint EvictLod(const Resources::ResourceId& id, uint loadedBits, uint keepBits);
 
     /// unload resource (overload to implement resource deallocation)
     virtual void Unload(const Resources::ResourceId id) = 0;
@@ -188,8 +204,22 @@ protected:
     Resource::State LoadImmediate(_PendingResourceLoad& res);
     /// Load async
     void LoadAsync(_PendingResourceLoad& res);
+    /// hand loads which didn't fit in the loader thread's queue over to it, returns true if none are left
+    bool FlushOverflowJobs();
     /// run callbacks
     void RunCallbacks(Resource::State status, const Resources::ResourceId id);
+    /// merge incoming stream requests with the ones deferred from earlier frames
+    void MergePendingStreamLods(IndexT frameIndex);
+    /// remove issued or stale stream requests
+    void CompactPendingStreamLods();
+    /// get the amount of memory a pending stream request would add, returns false if the request is already satisfied
+    bool PendingStreamBytes(const _PendingStreamLod& streamLod, uint64& outBytes);
+    /// issue a pending stream request to the loader, must be called from the creator thread
+    void IssueStreamLod(IndexT index, uint64 bytes);
+    /// drop a pending stream request without issuing it
+    void DropStreamLod(IndexT index);
+    /// evict the lods streamed on top of the ones a resource was created with, returns the amount of memory released
+    uint64 EvictStreamLods(const Ids::Id32 entry);
 
     friend Resource::State _LoadInternal(ResourceLoader* loader, const _PendingResourceLoad& res);
 
@@ -220,10 +250,12 @@ protected:
 
     Ptr<ResourceLoaderThread> streamerThread;
     Util::StringAtom streamerThreadName;
+    Util::Array<std::function<void()>> overflowJobs;
 
     Util::Array<IndexT> pendingLoads;
     Util::Array<_PendingResourceUnload> pendingUnloads;
     Util::Array<_PendingStreamLod> pendingStreamLods;
+    Util::Array<_PendingStreamLod> dequeuedStreamLods;
     Threading::SafeQueue<_PendingStreamLod> pendingStreamQueue;
 
     Util::Dictionary<Resources::ResourceName, uint32_t> ids;
@@ -235,13 +267,21 @@ protected:
     Util::FixedArray<Resource::State> states;
     Util::FixedArray<uint> requestedBits;
     Util::FixedArray<uint> loadedBits;
+    Util::FixedArray<uint> baseBits;
     Util::FixedArray<ResourceId> resources;
     Util::FixedArray<Util::Array<_Callbacks>> callbacks;
     Util::FixedArray<_PendingResourceLoad> loads;
     Util::FixedArray<_LoadMetaData> metaData;
     Util::FixedArray<StreamData> streams;
+    Util::FixedArray<uint64> residentLodBytes;
+    Util::FixedArray<IndexT> pendingStreamIndex;
+    Util::FixedArray<IndexT> lastLodRequestFrame;
     uint32_t uniqueResourceId;
 
+    /// memory handed to the loader thread but not yet streamed, and memory of lods streamed on top of the base lods currently resident
+    Threading::AtomicCounter64 streamBytesInFlight;
+    Threading::AtomicCounter64 streamBytesResident;
+
     /// id in resource manager
     int32_t uniqueId;
 
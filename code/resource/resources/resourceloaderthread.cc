@@ -17,7 +17,7 @@ __ImplementClass(Resources::ResourceLoaderThread, 'RETH', Threading::Thread);
 ResourceLoaderThread::ResourceLoaderThread() :
     completeEvent(true)
 {
-    // empty
+    this->jobs.Resize(4096);
 }
 
 //------------------------------------------------------------------------------
@@ -8,7 +8,7 @@
 */
 //------------------------------------------------------------------------------
 #include "threading/thread.h"
-#include "threading/safequeue.h"
+#include "threading/spscqueue.h"
 #include <functional>
 #include "resourceid.h"
 
@@ -39,7 +39,8 @@ private:
     /// emit wakeup signal
     virtual void EmitWakeupSignal() override;
     
-    Threading::SafeQueue<std::function<void()>> jobs;
+    // only ResourceLoader::Update() enqueues, so there is a single producer
+    Threading::SpscQueue<std::function<void()>> jobs;
     Threading::Event completeEvent;
     Ptr<IO::IoServer> ioServer;
 };
@@ -130,6 +130,9 @@ ResourceServer::Update(IndexT frameIndex)
         const Ptr<ResourceLoader>& loader = this->loaders[i];
         loader->Update(frameIndex);
     }
+
+    // issue the LOD requests gathered by the loaders within the streaming budget
+    this->streamScheduler.Update(frameIndex, this->loaders);
 }
 
 //------------------------------------------------------------------------------
@@ -189,7 +192,13 @@ ResourceServer::WaitForLoaderThread()
 {
     for (const Ptr<ResourceLoader>& loader : this->loaders)
     {
-        loader->streamerThread->Wait();
+        // loads which didn't fit in the queue are handed over as the thread makes room
+        bool flushed;
+        do
+        {
+            flushed = loader->FlushOverflowJobs();
+            loader->streamerThread->Wait();
+        } while (!flushed);
     }
 }
 
@@ -16,6 +16,7 @@
 #include "resourceid.h"
 #include "resourceloader.h"
 #include "resourceloaderthread.h"
+#include "resourcestreamscheduler.h"
 namespace Resources
 {
 class ResourceServer : public Core::RefCounted
@@ -52,8 +53,12 @@ public:
     bool HasPendingResources();
     /// reload resource
     void ReloadResource(const ResourceName& res, std::function<void(const Resources::ResourceId)> success = nullptr, std::function<void(const Resources::ResourceId)> failed = nullptr);
-    /// stream in a new LOD
-    void SetMinLod(const ResourceId& id, float lod, bool immediate);
+    /// stream in a new LOD, higher priority requests are streamed first when the streaming budget is exhausted
+    void SetMinLod(const ResourceId& id, float lod, bool immediate, float priority = 0.0f);
+    /// set the budget for LOD streaming
+    void SetStreamingBudget(const ResourceStreamScheduler::Budget& budget);
+    /// get LOD streaming statistics from the last frame
+    const ResourceStreamScheduler::Stats& GetStreamingStats() const;
     /// Create single-fire listener for resource. When resource is loaded, the callbacks will be invoked and the listener is destroyed
     void CreateResourceListener(const ResourceId& id, std::function<void(const Resources::ResourceId)> success, std::function<void(const Resources::ResourceId)> failed = nullptr);
 
@@ -90,6 +95,7 @@ private:
     Util::Dictionary<Util::StringAtom, IndexT> extensionMap;
     Util::Dictionary<const Core::Rtti*, IndexT> typeMap;
     Util::Array<Ptr<ResourceLoader>> loaders;
+    ResourceStreamScheduler streamScheduler;
 
     static int32_t UniquePoolCounter;
 };
@@ -200,7 +206,7 @@ ResourceServer::ReloadResource(const ResourceName& res, std::function<void(const
 /**
 */
 inline void 
-ResourceServer::SetMinLod(const ResourceId& id, float lod, bool immediate)
+ResourceServer::SetMinLod(const ResourceId& id, float lod, bool immediate, float priority)
 {
     // get id of loader
     const Ids::Id8 loaderid = id.loaderIndex;
@@ -210,7 +216,25 @@ ResourceServer::SetMinLod(const ResourceId& id, float lod, bool immediate)
     const Ptr<ResourceLoader>& loader = this->loaders[loaderid].downcast<ResourceLoader>();
 
     // update LOD
-    loader->SetMinLod(id, lod, immediate);
+    loader->SetMinLod(id, lod, immediate, priority);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline void
+ResourceServer::SetStreamingBudget(const ResourceStreamScheduler::Budget& budget)
+{
+    this->streamScheduler.SetBudget(budget);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const ResourceStreamScheduler::Stats&
+ResourceServer::GetStreamingStats() const
+{
+    return this->streamScheduler.GetStats();
 }
 
 //------------------------------------------------------------------------------
@@ -397,9 +421,9 @@ CreateResourceListener(
 /**
 */
 inline void
-SetMinLod(const ResourceId& id, float lod, bool immediate)
+SetMinLod(const ResourceId& id, float lod, bool immediate, float priority = 0.0f)
 {
-    return ResourceServer::Instance()->SetMinLod(id, lod, immediate);
+    return ResourceServer::Instance()->SetMinLod(id, lod, immediate, priority);
 }
 
 //------------------------------------------------------------------------------
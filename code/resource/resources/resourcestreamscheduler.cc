@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+//  resourcestreamscheduler.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "resourcestreamscheduler.h"
+#include "profiling/profiling.h"
+
+N_DECLARE_COUNTER(N_STREAMING_BYTES_PER_FRAME, Streaming Bytes Issued This Frame);
+N_DECLARE_COUNTER(N_STREAMING_BYTES_IN_FLIGHT, Streaming Bytes In Flight);
+N_DECLARE_COUNTER(N_STREAMING_BYTES_RESIDENT, Streaming Bytes Resident);
+N_DECLARE_COUNTER(N_STREAMING_REQUESTS_ISSUED, Streaming Requests Issued);
+N_DECLARE_COUNTER(N_STREAMING_REQUESTS_DEFERRED, Streaming Requests Deferred);
+N_DECLARE_COUNTER(N_STREAMING_LODS_EVICTED, Streaming LODs Evicted);
+
+namespace Resources
+{
+
+//------------------------------------------------------------------------------
+/**
+*/
+ResourceStreamScheduler::ResourceStreamScheduler() :
+    nextEvictionCandidate(0)
+{
+    this->budget.maxBytesPerFrame = 32 * 1024 * 1024;
+    this->budget.maxBytesInFlight = 128 * 1024 * 1024;
+    this->budget.maxBytesResident = __maxTextureBytes__;
+    this->budget.evictionGraceFrames = 300;
+    this->stats = {};
+    this->requests.Reserve(1024);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+ResourceStreamScheduler::~ResourceStreamScheduler()
+{
+    // empty
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceStreamScheduler::SetBudget(const Budget& budget)
+{
+    this->budget = budget;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ResourceStreamScheduler::Update(IndexT frameIndex, const Util::Array<Ptr<ResourceLoader>>& loaders)
+{
+    N_SCOPE(StreamSchedule, Resources);
+
+    this->stats = {};
+    this->requests.Clear();
+    this->evictionCandidates.Clear();
+    this->nextEvictionCandidate = 0;
+
+    // gather the memory currently in flight and resident, as well as the requests waiting to be streamed
+    IndexT i;
+    for (i = 0; i < loaders.Size(); i++)
+    {
+        ResourceLoader* loader = loaders[i];
+        this->stats.bytesInFlight += (uint64)loader->streamBytesInFlight;
+        this->stats.bytesResident += (uint64)loader->streamBytesResident;
+
+        IndexT j;
+        for (j = 0; j < loader->pendingStreamLods.Size(); j++)
+        {
+            const ResourceLoader::_PendingStreamLod& streamLod = loader->pendingStreamLods[j];
+            Request request;
+            request.loader = loader;
+            request.index = j;
+            request.priority = streamLod.priority;
+            request.lod = streamLod.lod;
+            request.satisfied = !loader->PendingStreamBytes(streamLod, request.bytes);
+            this->requests.Append(request);
+        }
+    }
+
+    // most important first, and for equal priority the most detailed lod first
+    this->requests.SortWithFunc([](const Request& lhs, const Request& rhs)
+    {
+        if (lhs.priority != rhs.priority)
+            return lhs.priority > rhs.priority;
+        return lhs.lod < rhs.lod;
+    });
+
+    bool budgetExhausted = false;
+    for (i = 0; i < this->requests.Size(); i++)
+    {
+        const Request& request = this->requests[i];
+
+        // requests which are already satisfied, or for resources which are not streamed, pass through
+        if (request.satisfied)
+        {
+            request.loader->DropStreamLod(request.index);
+            continue;
+        }
+        if (request.bytes == 0)
+        {
+            request.loader->IssueStreamLod(request.index, 0);
+            continue;
+        }
+
+        // once a request doesn't fit, the rest of the frame only passes through the free requests
+        if (!budgetExhausted)
+        {
+            if (this->budget.maxBytesPerFrame > 0 && this->stats.bytesIssued > 0 && this->stats.bytesIssued + request.bytes > this->budget.maxBytesPerFrame)
+                budgetExhausted = true;
+            else if (this->budget.maxBytesInFlight > 0 && this->stats.bytesInFlight > 0 && this->stats.bytesInFlight + request.bytes > this->budget.maxBytesInFlight)
+                budgetExhausted = true;
+        }
+
+        // the memory in flight becomes resident once streamed, so it counts against the resident budget too
+        if (!budgetExhausted && this->budget.maxBytesResident > 0)
+        {
+            const uint64 committed = this->stats.bytesResident + this->stats.bytesInFlight + request.bytes;
+            if (committed > this->budget.maxBytesResident && !this->Evict(frameIndex, committed - this->budget.maxBytesResident, loaders))
+                budgetExhausted = true;
+        }
+
+        if (budgetExhausted)
+        {
+            this->stats.requestsDeferred++;
+            continue;
+        }
+
+        request.loader->IssueStreamLod(request.index, request.bytes);
+        this->stats.bytesIssued += request.bytes;
+        this->stats.bytesInFlight += request.bytes;
+        this->stats.requestsIssued++;
+    }
+
+    // remove the issued requests, the deferred ones stay for the next frame
+    for (i = 0; i < loaders.Size(); i++)
+        loaders[i]->CompactPendingStreamLods();
+
+    N_COUNTER_SET(N_STREAMING_BYTES_PER_FRAME, this->stats.bytesIssued);
+    N_COUNTER_SET(N_STREAMING_BYTES_IN_FLIGHT, this->stats.bytesInFlight);
+    N_COUNTER_SET(N_STREAMING_BYTES_RESIDENT, this->stats.bytesResident);
+    N_COUNTER_INCR(N_STREAMING_REQUESTS_ISSUED, this->stats.requestsIssued);
+    N_COUNTER_INCR(N_STREAMING_REQUESTS_DEFERRED, this->stats.requestsDeferred);
+    N_COUNTER_INCR(N_STREAMING_LODS_EVICTED, this->stats.lodsEvicted);
+}
+
+//------------------------------------------------------------------------------
+/**
+    The candidate list is built the first time a frame runs out of resident memory,
+    and consumed in least recently requested order for the rest of the frame.
+    Resources which are waiting to be streamed, or have never been requested, are
+    left alone.
+*/
+bool
+ResourceStreamScheduler::Evict(IndexT frameIndex, uint64 bytes, const Util::Array<Ptr<ResourceLoader>>& loaders)
+{
+    if (this->nextEvictionCandidate == 0 && this->evictionCandidates.IsEmpty())
+    {
+        IndexT i;
+        for (i = 0; i < loaders.Size(); i++)
+        {
+            ResourceLoader* loader = loaders[i];
+            IndexT j;
+            for (j = 0; j < loader->residentLodBytes.Size(); j++)
+            {
+                const IndexT lastRequestFrame = loader->lastLodRequestFrame[j];
+                if (loader->residentLodBytes[j] > 0
+                    && loader->pendingStreamIndex[j] == InvalidIndex
+                    && lastRequestFrame != InvalidIndex
+                    && frameIndex - lastRequestFrame > this->budget.evictionGraceFrames)
+                    this->evictionCandidates.Append({ loader, (Ids::Id32)j, lastRequestFrame });
+            }
+        }
+        this->evictionCandidates.SortWithFunc([](const EvictionCandidate& lhs, const EvictionCandidate& rhs)
+        {
+            return lhs.lastRequestFrame < rhs.lastRequestFrame;
+        });
+    }
+
+    uint64 freed = 0;
+    while (freed < bytes && this->nextEvictionCandidate < this->evictionCandidates.Size())
+    {
+        const EvictionCandidate& candidate = this->evictionCandidates[this->nextEvictionCandidate++];
+        const uint64 evicted = candidate.loader->EvictStreamLods(candidate.entry);
+        if (evicted > 0)
+        {
+            freed += evicted;
+            this->stats.lodsEvicted++;
+        }
+    }
+
+    this->stats.bytesEvicted += freed;
+    this->stats.bytesResident = freed < this->stats.bytesResident ? this->stats.bytesResident - freed : 0;
+    return freed >= bytes;
+}
+
+} // namespace Resources
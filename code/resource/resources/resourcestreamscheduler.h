@@ -0,0 +1,119 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    The resource stream scheduler decides which of the pending LOD requests
+    of all resource loaders get streamed in each frame.
+
+    Requests are ranked by their priority, which callers derive from screen-space
+    size, and ties are broken by favoring the most detailed LOD. Requests are then
+    issued until the per-frame or in-flight byte budget is exhausted, the remaining
+    requests are kept and reconsidered the next frame. The first request of a frame
+    may exceed the per-frame budget, and a request may exceed the in-flight budget
+    while nothing else is in flight, such that a single LOD larger than the budget
+    can't stall streaming.
+
+    The memory of the LODs streamed on top of the ones a resource was created with
+    is tracked as resident memory. If issuing a request would make it, together with
+    the memory in flight, exceed the resident budget, the least recently requested
+    LODs are evicted until it fits, which lowers those resources back to their base
+    LOD. Resources requested within the last evictionGraceFrames frames are never
+    evicted, and a request which can't be made to fit is deferred.
+
+    A budget of 0 disables that limit. The statistics of each frame are also
+    published as profiling counters.
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "core/ptr.h"
+#include "util/array.h"
+#include "resourceloader.h"
+namespace Resources
+{
+
+class ResourceStreamScheduler
+{
+public:
+    /// constructor
+    ResourceStreamScheduler();
+    /// destructor
+    ~ResourceStreamScheduler();
+
+    struct Budget
+    {
+        uint64 maxBytesPerFrame;
+        uint64 maxBytesInFlight;
+        uint64 maxBytesResident;
+        IndexT evictionGraceFrames;
+    };
+
+    struct Stats
+    {
+        SizeT requestsIssued;
+        SizeT requestsDeferred;
+        SizeT lodsEvicted;
+        uint64 bytesIssued;
+        uint64 bytesEvicted;
+        uint64 bytesInFlight;
+        uint64 bytesResident;
+    };
+
+    /// set the streaming budget
+    void SetBudget(const Budget& budget);
+    /// get the streaming budget
+    const Budget& GetBudget() const;
+    /// get statistics from the last update
+    const Stats& GetStats() const;
+
+    /// issue pending lod requests from all loaders within the budget
+    void Update(IndexT frameIndex, const Util::Array<Ptr<ResourceLoader>>& loaders);
+
+private:
+
+    /// free resident memory by evicting the least recently requested lods, returns true if enough could be freed
+    bool Evict(IndexT frameIndex, uint64 bytes, const Util::Array<Ptr<ResourceLoader>>& loaders);
+
+    struct Request
+    {
+        ResourceLoader* loader;
+        IndexT index;
+        float priority;
+        float lod;
+        bool satisfied;
+        uint64 bytes;
+    };
+
+    struct EvictionCandidate
+    {
+        ResourceLoader* loader;
+        Ids::Id32 entry;
+        IndexT lastRequestFrame;
+    };
+
+    Budget budget;
+    Stats stats;
+    Util::Array<Request> requests;
+    Util::Array<EvictionCandidate> evictionCandidates;
+    IndexT nextEvictionCandidate;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const ResourceStreamScheduler::Budget&
+ResourceStreamScheduler::GetBudget() const
+{
+    return this->budget;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+inline const ResourceStreamScheduler::Stats&
+ResourceStreamScheduler::GetStats() const
+{
+    return this->stats;
+}
+
+} // namespace Resources
@@ -56,6 +56,9 @@ class IDLCodeGenerator:
             IDLDocument.AddInclude(f, "resources/resource.h")
         if (IDLComponent.ContainsEntityTypes()):
             IDLDocument.AddInclude(f, "game/entity.h")
+        if "components" in self.document:
+            IDLDocument.AddInclude(f, "io/binaryreader.h")
+            IDLDocument.AddInclude(f, "io/binarywriter.h")
 
         IDLDocument.WriteIncludeHeader(f)
         IDLDocument.WriteIncludes(f, self.document)
@@ -79,6 +82,12 @@ class IDLCodeGenerator:
 
             IDLDocument.EndNamespace(f, self.document)
 
+        # the binary serializers are defined in the source, but have to be known wherever the components are registered
+        if hasComponents:
+            IDLDocument.BeginNamespaceOverride(f, self.document, "IO")
+            IDLComponent.WriteStructBinarySerializerDeclarations(f, self.document)
+            IDLDocument.EndNamespaceOverride(f, self.document, "IO")
+
         f.Close()
         return
 
@@ -116,6 +125,7 @@ class IDLCodeGenerator:
                 IDLComponent.WriteEnumJsonSerializers(f, self.document);
             if hasComponents:
                 IDLComponent.WriteStructJsonSerializers(f, self.document);
+                IDLComponent.WriteStructBinarySerializers(f, self.document);
                 
             IDLDocument.EndNamespaceOverride(f, self.document, "IO")
 
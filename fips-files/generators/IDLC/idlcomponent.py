@@ -1,6 +1,7 @@
 import IDLC.idltypes as IDLTypes
 import genutil as util
 import IDLC.idldocument as IDLDocument
+import zlib
 
 # Global component list
 components = list()
@@ -58,6 +59,11 @@ class ComponentDefinition:
         return retVal
     pass
 
+    def FieldLayoutHash(self):
+        layout = ''.join('{} {};'.format(IDLTypes.GetCppTypeString(v.type), v.name) for v in self.variables)
+        return zlib.crc32(layout.encode('utf-8')) & 0xFFFFFFFF
+    pass
+
     def AsCsTypeDefString(self):
         retVal = 'public struct {} : NativeComponent\n{{\n'.format(self.componentName)
         for v in self.variables:
@@ -136,6 +142,7 @@ def WriteComponentHeaderDeclarations(f, document):
         f.WriteLine('static constexpr auto name = "{}";'.format(c.componentName))
         f.WriteLine('static constexpr auto fully_qualified_name = "{}.{}";'.format(namespace, c.componentName))
         f.WriteLine('static constexpr size_t num_fields = {};'.format(len(c.variables)))
+        f.WriteLine('static constexpr uint32_t field_layout_hash = 0x{:08X};'.format(c.FieldLayoutHash()))
         if (len(c.variables) > 0):
             f.WriteLine('static constexpr const char* field_names[num_fields] = {')
             for v in c.variables:
@@ -218,6 +225,39 @@ def WriteStructJsonSerializers(f, document):
         f.WriteLine("")
 
 
+#------------------------------------------------------------------------------
+##
+#
+def WriteStructBinarySerializerDeclarations(f, document):
+    namespace = IDLDocument.GetNamespace(document)
+    for comp in components:
+        f.WriteLine('template<> void BinaryReader::Get<{namespace}::{name}>({namespace}::{name}& ret);'.format(namespace=namespace, name=comp.componentName))
+        f.WriteLine('template<> void BinaryWriter::Add<{namespace}::{name}>({namespace}::{name} const& value);'.format(namespace=namespace, name=comp.componentName))
+
+#------------------------------------------------------------------------------
+##
+#
+def WriteStructBinarySerializers(f, document):
+    namespace = IDLDocument.GetNamespace(document)
+    for comp in components:
+        f.WriteLine('template<> void BinaryReader::Get<{namespace}::{name}>({namespace}::{name}& ret)'.format(namespace=namespace, name=comp.componentName))
+        f.WriteLine('{')
+        f.IncreaseIndent()
+        for var in comp.variables:
+            f.WriteLine('this->Get<{type}>(ret.{fieldName});'.format(fieldName=var.name, type=IDLTypes.GetCppTypeString(var.type)))
+        f.DecreaseIndent()
+        f.WriteLine("}")
+        f.WriteLine("")
+
+        f.WriteLine('template<> void BinaryWriter::Add<{namespace}::{name}>({namespace}::{name} const& value)'.format(namespace=namespace, name=comp.componentName))
+        f.WriteLine('{')
+        f.IncreaseIndent()
+        for var in comp.variables:
+            f.WriteLine('this->Add<{type}>(value.{fieldName});'.format(fieldName=var.name, type=IDLTypes.GetCppTypeString(var.type)))
+        f.DecreaseIndent()
+        f.WriteLine("}")
+        f.WriteLine("")
+
 #------------------------------------------------------------------------------
 ##
 #
@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+//  batchmathbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "batchmathbenchmark.h"
+#include "math/batch.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::BatchMathBench, 'BMBM', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Math;
+
+static const int num = 100000;
+static const int rounds = 20;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+Report(const char* name, Time scalarTime, Time batchTime)
+{
+    const double elements = (double)num * rounds;
+    n_printf("%s: scalar %.1f M/s, batch %.1f M/s (%.2fx)\n", name, elements / scalarTime * 1e-6, elements / batchTime * 1e-6, scalarTime / batchTime);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BatchMathBench::Run(Timer& timer)
+{
+    point* points = new point[num];
+    point* outPoints = new point[num];
+    mat4* matrices = new mat4[num];
+    mat4* outMatrices = new mat4[num];
+    bbox* boxes = new bbox[num];
+    bbox* outBoxes = new bbox[num];
+    quat* quats = new quat[num];
+    quat* outQuats = new quat[num];
+
+    const mat4 m = trs(vec3(1.0f, 2.0f, 3.0f), quatyawpitchroll(0.5f, 0.25f, 0.0f), vec3(2.0f));
+    IndexT i;
+    for (i = 0; i < num; i++)
+    {
+        const float f = (float)(i % 1000);
+        points[i] = point(f, -f, f * 0.5f);
+        matrices[i] = trs(vec3(f, 0.0f, -f), quatyawpitchroll(f * 0.01f, 0.0f, 0.0f), vec3(1.0f));
+        boxes[i] = bbox(point(f, 0.0f, -f), vector(1.0f + f * 0.01f));
+        quats[i] = quat(f, 1.0f, -f, 2.0f);
+    }
+
+    timer.Start();
+    IndexT round;
+
+    // points
+    Time start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < num; i++)
+            outPoints[i] = m * points[i];
+    }
+    Time scalarTime = timer.GetTime() - start;
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        TransformPoints(outPoints, points, num, m);
+    }
+    Report("transform points", scalarTime, timer.GetTime() - start);
+
+    // matrices
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < num; i++)
+            outMatrices[i] = m * matrices[i];
+    }
+    scalarTime = timer.GetTime() - start;
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        TransformMatrices(outMatrices, matrices, num, m);
+    }
+    Report("transform matrices", scalarTime, timer.GetTime() - start);
+
+    // boxes by one matrix
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < num; i++)
+        {
+            outBoxes[i] = boxes[i];
+            outBoxes[i].affine_transform(m);
+        }
+    }
+    scalarTime = timer.GetTime() - start;
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        TransformBoxes(outBoxes, boxes, num, m);
+    }
+    Report("transform boxes", scalarTime, timer.GetTime() - start);
+
+    // boxes by their own matrix
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < num; i++)
+        {
+            outBoxes[i] = boxes[i];
+            outBoxes[i].affine_transform(matrices[i]);
+        }
+    }
+    scalarTime = timer.GetTime() - start;
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        TransformBoxes(outBoxes, boxes, matrices, num);
+    }
+    Report("transform boxes per matrix", scalarTime, timer.GetTime() - start);
+
+    // quaternions
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < num; i++)
+            outQuats[i] = normalize(quats[i]);
+    }
+    scalarTime = timer.GetTime() - start;
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        NormalizeQuats(outQuats, quats, num);
+    }
+    Report("normalize quats", scalarTime, timer.GetTime() - start);
+    timer.Stop();
+
+    delete[] points;
+    delete[] outPoints;
+    delete[] matrices;
+    delete[] outMatrices;
+    delete[] boxes;
+    delete[] outBoxes;
+    delete[] quats;
+    delete[] outQuats;
+}
+
+} // namespace Benchmarking
@@ -7,9 +7,13 @@
 #include "util/queue.h"
 #include "util/arrayqueue.h"
 #include "util/list.h"
+#include "util/dictionary.h"
+#include "util/hashtable.h"
+#include "util/flathashmap.h"
 
 
 const int numObjects = 50000;
+const int numHashKeys = 20000;
 
 #define DECLARE_CB_TEST(name, ctype, dtype) ContainerBenchmark<ctype<dtype>, dtype> name;
 #define SETUP_CB_TEST(cb, data, addfunc, rmfunc ) cb.Setup(data, [](decltype(cb)::ctype& c, decltype(cb)::dtype d) { c.addfunc(d); },  [&](decltype(cb)::ctype& c) { return c.rmfunc(); } );
@@ -23,6 +27,58 @@ __ImplementClass(Benchmarking::ContainerBench, 'CTEB', Benchmarking::Benchmark);
 using namespace Core;
 using namespace Timing;
 
+//------------------------------------------------------------------------------
+/**
+    Times inserting all keys, looking all of them up a few times, looking up
+    keys which are not in the map and erasing all keys again.
+*/
+template<class MAP, class KEY>
+static void
+RunHashMapBench(const char* name, Timer& timer, const Util::Array<KEY>& keys, const Util::Array<KEY>& missingKeys)
+{
+    n_printf("benchmarking map: %s\n", name);
+    MAP map;
+    IndexT i;
+    Time start = timer.GetTime();
+    for (i = 0; i < keys.Size(); i++)
+    {
+        map.Add(keys[i], i);
+    }
+    Time last = timer.GetTime();
+    n_printf("insert %d keys: %f\n", keys.Size(), last - start);
+
+    SizeT found = 0;
+    IndexT round;
+    for (round = 0; round < 4; round++)
+    {
+        for (i = 0; i < keys.Size(); i++)
+        {
+            found += map.Contains(keys[i]) ? 1 : 0;
+        }
+    }
+    Time now = timer.GetTime();
+    n_printf("lookup %d existing keys 4 times: %f\n", keys.Size(), now - last);
+    last = now;
+
+    for (i = 0; i < missingKeys.Size(); i++)
+    {
+        found += map.Contains(missingKeys[i]) ? 1 : 0;
+    }
+    now = timer.GetTime();
+    n_printf("lookup %d missing keys: %f\n", missingKeys.Size(), now - last);
+    last = now;
+    n_assert(found == keys.Size() * 4);
+
+    for (i = 0; i < keys.Size(); i++)
+    {
+        map.Erase(keys[i]);
+    }
+    now = timer.GetTime();
+    n_printf("erase %d keys: %f\n", keys.Size(), now - last);
+    n_printf("Total time: %f\n", now - start);
+    n_printf("---------------------------------------------------------------\n");
+}
+
 
 
 //------------------------------------------------------------------------------
@@ -55,7 +111,30 @@ ContainerBench::Run(Timer& timer)
     RUN_CB_TEST(cbs, timer);    
     RUN_CB_TEST(cbqs, timer);
     RUN_CB_TEST(cbls, timer);
-    
+
+    // hash maps, with scattered integer keys and string keys
+    Util::Array<int> intKeys, missingIntKeys;
+    Util::Array<Util::String> stringKeys, missingStringKeys;
+    IndexT i;
+    for (i = 0; i < numHashKeys; i++)
+    {
+        intKeys.Append(int(uint(i) * 2654435761u) & 0x7FFFFFFE);
+        missingIntKeys.Append((int(uint(i) * 2654435761u) & 0x7FFFFFFE) | 1);
+        Util::String key;
+        key.Format("/resources/textures/tile_%d.dds", i);
+        stringKeys.Append(key);
+        key.Format("/resources/textures/tile_%d.dds", i + numHashKeys);
+        missingStringKeys.Append(key);
+    }
+
+    timer.Start();
+    RunHashMapBench<Util::Dictionary<int, IndexT>>("Dictionary<int>", timer, intKeys, missingIntKeys);
+    RunHashMapBench<Util::HashTable<int, IndexT, 1024>>("HashTable<int, 1024>", timer, intKeys, missingIntKeys);
+    RunHashMapBench<Util::FlatHashMap<int, IndexT>>("FlatHashMap<int>", timer, intKeys, missingIntKeys);
+    RunHashMapBench<Util::Dictionary<Util::String, IndexT>>("Dictionary<String>", timer, stringKeys, missingStringKeys);
+    RunHashMapBench<Util::HashTable<Util::String, IndexT, 1024>>("HashTable<String, 1024>", timer, stringKeys, missingStringKeys);
+    RunHashMapBench<Util::FlatHashMap<Util::String, IndexT>>("FlatHashMap<String>", timer, stringKeys, missingStringKeys);
+    timer.Stop();
 }
 
 } // namespace Benchmarking
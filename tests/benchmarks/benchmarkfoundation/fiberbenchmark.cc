@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------------
+//  fiberbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "fiberbenchmark.h"
+#include "fibers/fiber.h"
+#include "jobs2/jobs2.h"
+#include "system/systeminfo.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::FiberBench, 'FIBR', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Jobs2;
+
+static const int numSwitches = 1000000;
+static const int numFrames = 100;
+static const SizeT numOuter = 64;
+static const SizeT numInner = 4096;
+static const SizeT innerGroupSize = 256;
+
+struct SwitchContext
+{
+    Fibers::Fiber* thread;
+    Fibers::Fiber* fiber;
+};
+
+struct NestedContext
+{
+    float* values;
+    float* sums;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+SwitchBack(void* param)
+{
+    SwitchContext* context = (SwitchContext*)param;
+    while (true)
+        context->thread->SwitchToFiber(*context->fiber);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+InnerJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    float* values = *(float**)ctx;
+    IndexT i;
+    for (i = 0; i < groupSize; i++)
+    {
+        IndexT index = i + invocationOffset;
+        if (index >= totalJobs)
+            break;
+        values[index] = Math::sqrt((float)index);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+SumJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    NestedContext* context = (NestedContext*)ctx;
+    const float* values = context->values + groupIndex * numInner;
+    float sum = 0.0f;
+    IndexT i;
+    for (i = 0; i < numInner; i++)
+        sum += values[i];
+    context->sums[groupIndex] = sum;
+}
+
+//------------------------------------------------------------------------------
+/**
+    Every outer job dispatches the inner jobs for its part and waits for
+    them, the worker runs other jobs while the outer job sleeps on its fiber
+*/
+static void
+NestedJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    NestedContext* context = (NestedContext*)ctx;
+    float* values = context->values + groupIndex * numInner;
+    Threading::AtomicCounter counter = 1;
+    JobDispatch(InnerJob, numInner, innerGroupSize, values, nullptr, &counter);
+    JobYieldUntil(&counter);
+    SumJob(totalJobs, groupSize, groupIndex, invocationOffset, ctx);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<bool FIBERS>
+static void
+NestedFrames(const char* name, Timer& timer, NestedContext& context)
+{
+    JobSystemInitInfo info;
+    info.name = "FiberBench";
+    info.numThreads = System::NumCpuCores;
+    info.enableProfiling = false;
+    info.enableFibers = FIBERS;
+    info.scratchMemorySize = 4_MB;
+    JobSystemInit(info);
+
+    const Time start = timer.GetTime();
+    IndexT i;
+    for (i = 0; i < numFrames; i++)
+    {
+        Threading::AtomicCounter counter = 1;
+        if (FIBERS)
+        {
+            JobDispatch(NestedJob, numOuter, 1, context, nullptr, &counter);
+            JobYieldUntil(&counter);
+        }
+        else
+        {
+            // without fibers, the outer work is split in what comes before and after the inner jobs
+            Threading::AtomicCounter innerCounter = 1;
+            JobDispatch(InnerJob, numOuter * numInner, innerGroupSize, context.values, nullptr, &innerCounter);
+            JobDispatch(SumJob, numOuter, 1, context, { &innerCounter }, &counter);
+            JobYieldUntil(&counter);
+        }
+        JobNewFrame();
+    }
+    n_printf("%s: %.1f us/frame\n", name, (timer.GetTime() - start) / numFrames * 1e6);
+
+    JobSystemUninit();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+FiberBench::Run(Timer& timer)
+{
+    Fibers::Fiber threadFiber;
+    Fibers::Fiber::ThreadToFiber(threadFiber);
+    Fibers::Fiber fiber;
+    SwitchContext switchContext = { &threadFiber, &fiber };
+    fiber = Fibers::Fiber(SwitchBack, &switchContext);
+
+    NestedContext context;
+    context.values = new float[numOuter * numInner];
+    context.sums = new float[numOuter];
+
+    timer.Start();
+
+    // every round trip is two switches
+    const Time start = timer.GetTime();
+    IndexT i;
+    for (i = 0; i < numSwitches / 2; i++)
+        fiber.SwitchToFiber(threadFiber);
+    n_printf("fiber switch: %.1f ns\n", (timer.GetTime() - start) / numSwitches * 1e9);
+
+    NestedFrames<true>("nested jobs on fibers", timer, context);
+    NestedFrames<false>("split dispatches", timer, context);
+
+    timer.Stop();
+
+    delete[] context.values;
+    delete[] context.sums;
+    Fibers::Fiber::FiberToThread(threadFiber);
+}
+
+} // namespace Benchmarking
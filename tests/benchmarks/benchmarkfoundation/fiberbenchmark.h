@@ -0,0 +1,25 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::FiberBench
+
+    Measures the cost of a fiber switch, and of jobs which wait for jobs
+    they dispatched, on fibers versus splitting them into two dispatches.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class FiberBench : public Benchmark
+{
+    __DeclareClass(FiberBench);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
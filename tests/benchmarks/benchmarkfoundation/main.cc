@@ -17,6 +17,11 @@
 #include "mempoolbenchmark.h"
 #include "containerbenchmark.h"
 #include "delegates.h"
+#include "simdkernelbenchmark.h"
+#include "batchmathbenchmark.h"
+#include "slerpbenchmark.h"
+#include "syncbenchmark.h"
+#include "fiberbenchmark.h"
 
 using namespace Core;
 using namespace Benchmarking;
@@ -40,6 +45,11 @@ main(int argc, char** argv)
     runner->AttachBenchmark(CreateObjectsByClassName::Create());
     runner->AttachBenchmark(ContainerBench::Create());
     runner->AttachBenchmark(DelegateBench::Create());
+    runner->AttachBenchmark(SimdKernelBench::Create());
+    runner->AttachBenchmark(BatchMathBench::Create());
+    runner->AttachBenchmark(SlerpBench::Create());
+    runner->AttachBenchmark(SyncBench::Create());
+    runner->AttachBenchmark(FiberBench::Create());
     runner->Run();
     
     // shutdown Nebula runtime
@@ -0,0 +1,95 @@
+//------------------------------------------------------------------------------
+//  simdkernelbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "simdkernelbenchmark.h"
+#include "math/simdkernels.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::SimdKernelBench, 'SIMK', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Math;
+using namespace System;
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+SimdKernelBench::Run(Timer& timer)
+{
+    const int num = 100000;
+    const int rounds = 10;
+    mat4* m0 = new mat4[num];
+    mat4* m1 = new mat4[num];
+    mat4* res = new mat4[num];
+    bbox* boxes = new bbox[num];
+    uint32* ids = new uint32[num];
+    ClipStatus::Type* status = new ClipStatus::Type[num];
+    scalar* sizes = new scalar[num];
+    scalar* distances = new scalar[num];
+
+    IndexT i;
+    for (i = 0; i < num; i++)
+    {
+        const float f = (float)(i % 100);
+        m0[i] = rotationyawpitchroll(f, f * 0.5f, 0.0f);
+        m0[i].position = vec4(f, 0.0f, -f, 1.0f);
+        m1[i] = scaling(1.0f + f * 0.01f);
+        boxes[i] = bbox(point((f - 50.0f) * 2.0f, (float)(i % 7) - 3.0f, -f), vector(1.0f + (float)(i % 3)));
+        ids[i] = num - 1 - i;
+    }
+    const mat4 viewProjection = perspfovrh(deg2rad(60.0f), 16.0f / 9.0f, 0.1f, 100.0f) * lookatrh(point(0, 0, 10), point(0, 0, 0), vector(0, 1, 0));
+
+    timer.Start();
+    int level;
+    for (level = Cpu::SimdGeneric; level <= Cpu::GetMaxSimdLevel(); level++)
+    {
+        Cpu::SetSimdLevel((Cpu::SimdLevel)level);
+
+        Time start = timer.GetTime();
+        for (i = 0; i < rounds; i++)
+        {
+            MultiplyMatrices(res, m0, m1, num);
+        }
+        Time last = timer.GetTime();
+        n_printf("%s: multiply %d matrices %d times: %f\n", Cpu::SimdLevelAsString((Cpu::SimdLevel)level), num, rounds, last - start);
+
+        SizeT visible = 0;
+        for (i = 0; i < rounds; i++)
+        {
+            IndexT j;
+            for (j = 0; j < num; j++)
+                status[j] = ClipStatus::Outside;
+            ClipBoxes(status, boxes, ids, num, viewProjection, false);
+            visible = 0;
+            for (j = 0; j < num; j++)
+                visible += status[j] != ClipStatus::Outside ? 1 : 0;
+        }
+        Time now = timer.GetTime();
+        n_printf("%s: clip %d boxes %d times (%d visible): %f\n", Cpu::SimdLevelAsString((Cpu::SimdLevel)level), num, rounds, visible, now - last);
+
+        for (i = 0; i < rounds; i++)
+        {
+            ProjectBoxes(sizes, distances, boxes, ids, num, viewProjection, point(0, 0, 10), false);
+        }
+        last = now;
+        now = timer.GetTime();
+        n_printf("%s: project %d boxes %d times: %f\n", Cpu::SimdLevelAsString((Cpu::SimdLevel)level), num, rounds, now - last);
+    }
+    timer.Stop();
+    Cpu::SetSimdLevel(Cpu::GetMaxSimdLevel());
+
+    delete[] m0;
+    delete[] m1;
+    delete[] res;
+    delete[] boxes;
+    delete[] ids;
+    delete[] status;
+    delete[] sizes;
+    delete[] distances;
+}
+
+} // namespace Benchmarking
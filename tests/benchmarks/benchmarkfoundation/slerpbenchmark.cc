@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+//  slerpbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "slerpbenchmark.h"
+#include "math/batch.h"
+#include <cmath>
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::SlerpBench, 'SLRP', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Math;
+
+static const int num = 100000;
+static const int rounds = 20;
+
+//------------------------------------------------------------------------------
+/**
+    The textbook slerp, in double precision when used as the reference
+*/
+template<class TYPE>
+static quat
+ReferenceSlerp(const quat& q1, const quat& q2, TYPE t)
+{
+    TYPE cosAngle = (TYPE)q1.x * q2.x + (TYPE)q1.y * q2.y + (TYPE)q1.z * q2.z + (TYPE)q1.w * q2.w;
+    TYPE sign = 1;
+    if (cosAngle < 0)
+    {
+        cosAngle = -cosAngle;
+        sign = -1;
+    }
+    TYPE scale0 = 1 - t;
+    TYPE scale1 = t;
+    if (cosAngle < (TYPE)0.9999)
+    {
+        const TYPE angle = std::acos(cosAngle);
+        const TYPE invSin = 1 / std::sin(angle);
+        scale0 = std::sin((1 - t) * angle) * invSin;
+        scale1 = std::sin(t * angle) * invSin;
+    }
+    scale1 *= sign;
+    return quat(
+        (scalar)(q1.x * scale0 + q2.x * scale1),
+        (scalar)(q1.y * scale0 + q2.y * scale1),
+        (scalar)(q1.z * scale0 + q2.z * scale1),
+        (scalar)(q1.w * scale0 + q2.w * scale1));
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static scalar
+MaxError(const quat* results, const quat* reference)
+{
+    scalar maxError = 0.0f;
+    IndexT i;
+    for (i = 0; i < num; i++)
+    {
+        const vec4 diff = abs(vec4(results[i].vec) - vec4(reference[i].vec));
+        maxError = Math::max(maxError, Math::max(Math::max(diff.x, diff.y), Math::max(diff.z, diff.w)));
+    }
+    return maxError;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+Report(const char* name, Time time, scalar maxError)
+{
+    const double elements = (double)num * rounds;
+    n_printf("%s: %.1f M/s, max error %g\n", name, elements / time * 1e-6, maxError);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+SlerpBench::Run(Timer& timer)
+{
+    quat* from = new quat[num];
+    quat* to = new quat[num];
+    scalar* weights = new scalar[num];
+    quat* reference = new quat[num];
+    quat* results = new quat[num];
+
+    // pairs cover every angle between 0 and 360 degrees, which includes the sign flip
+    IndexT i;
+    for (i = 0; i < num; i++)
+    {
+        const scalar f = (scalar)i / num;
+        from[i] = quatyawpitchroll(f * 7.0f, f * 3.0f, 0.0f);
+        to[i] = from[i] * rotationquataxis(normalize(vec3(1.0f, f, 0.5f)), f * 2.0f * N_PI);
+        weights[i] = (scalar)(i % 101) / 100.0f;
+        reference[i] = ReferenceSlerp<double>(from[i], to[i], weights[i]);
+    }
+
+    timer.Start();
+    IndexT round;
+
+    Time start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < num; i++)
+            results[i] = ReferenceSlerp<scalar>(from[i], to[i], weights[i]);
+    }
+    Report("acos/sin slerp", timer.GetTime() - start, MaxError(results, reference));
+
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < num; i++)
+            results[i] = slerp(from[i], to[i], weights[i]);
+    }
+    Report("slerp", timer.GetTime() - start, MaxError(results, reference));
+
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        SlerpQuats(results, from, to, weights, num);
+    }
+    Report("SlerpQuats", timer.GetTime() - start, MaxError(results, reference));
+
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        for (i = 0; i < num; i++)
+            results[i] = nlerp(from[i], to[i], weights[i]);
+    }
+    Report("nlerp", timer.GetTime() - start, MaxError(results, reference));
+
+    start = timer.GetTime();
+    for (round = 0; round < rounds; round++)
+    {
+        NlerpQuats(results, from, to, weights, num);
+    }
+    Report("NlerpQuats", timer.GetTime() - start, MaxError(results, reference));
+    timer.Stop();
+
+    delete[] from;
+    delete[] to;
+    delete[] weights;
+    delete[] reference;
+    delete[] results;
+}
+
+} // namespace Benchmarking
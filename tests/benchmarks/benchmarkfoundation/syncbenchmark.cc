@@ -0,0 +1,278 @@
+//------------------------------------------------------------------------------
+//  syncbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "syncbenchmark.h"
+#include "threading/criticalsection.h"
+#include "threading/event.h"
+#include "threading/futex.h"
+#include "threading/threadbarrier.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::SyncBench, 'SYNC', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Threading;
+
+static const int numThreads = 4;
+static const int uncontendedOps = 1000000;
+static const int contendedOps = 100000;
+static const int rounds = 20000;
+
+//------------------------------------------------------------------------------
+/**
+    An auto-reset event on a mutex and condition variable, which is what
+    Threading::Event used to be on Linux
+*/
+class CondVarEvent
+{
+public:
+    void Signal()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->signalled = true;
+        this->cond.notify_one();
+    }
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->cond.wait(lock, [this] { return this->signalled; });
+        this->signalled = false;
+    }
+private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    bool signalled = false;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+Report(const char* name, Time time, int ops)
+{
+    n_printf("%s: %.1f ns/op\n", name, time / ops * 1e9);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class ENTER, class LEAVE>
+static void
+LockUncontended(const char* name, Timer& timer, ENTER enter, LEAVE leave)
+{
+    int value = 0;
+    const Time start = timer.GetTime();
+    IndexT i;
+    for (i = 0; i < uncontendedOps; i++)
+    {
+        enter();
+        value++;
+        leave();
+    }
+    Report(name, timer.GetTime() - start, uncontendedOps);
+    n_assert(value == uncontendedOps);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class ENTER, class LEAVE>
+static void
+LockContended(const char* name, Timer& timer, ENTER enter, LEAVE leave)
+{
+    int value = 0;
+    std::thread threads[numThreads];
+    const Time start = timer.GetTime();
+    IndexT i;
+    for (i = 0; i < numThreads; i++)
+    {
+        threads[i] = std::thread([&]()
+        {
+            IndexT j;
+            for (j = 0; j < contendedOps; j++)
+            {
+                enter();
+                value++;
+                leave();
+            }
+        });
+    }
+    for (i = 0; i < numThreads; i++)
+        threads[i].join();
+    Report(name, timer.GetTime() - start, contendedOps * numThreads);
+    n_assert(value == contendedOps * numThreads);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Signal and wait on the same thread, so the event is always signalled
+    by the time we wait
+*/
+template<class EVENT>
+static void
+EventUncontended(const char* name, Timer& timer)
+{
+    EVENT event;
+    const Time start = timer.GetTime();
+    IndexT i;
+    for (i = 0; i < uncontendedOps; i++)
+    {
+        event.Signal();
+        event.Wait();
+    }
+    Report(name, timer.GetTime() - start, uncontendedOps);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Two threads hand control back and forth, which measures the latency
+    of waking up a thread, as a job thread waiting for work would
+*/
+template<class EVENT>
+static void
+EventPingPong(const char* name, Timer& timer)
+{
+    EVENT ping, pong;
+    const Time start = timer.GetTime();
+    std::thread other([&]()
+    {
+        IndexT i;
+        for (i = 0; i < rounds; i++)
+        {
+            ping.Wait();
+            pong.Signal();
+        }
+    });
+    IndexT i;
+    for (i = 0; i < rounds; i++)
+    {
+        ping.Signal();
+        pong.Wait();
+    }
+    other.join();
+    Report(name, timer.GetTime() - start, rounds);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Every round, all threads decrement a counter once, and the main thread
+    waits for it to reach zero, the way the render contexts wait for their
+    jobs. With an event, the thread which brings the counter to zero
+    signals it, with a counter wait the decrement wakes up the waiter.
+*/
+template<bool USE_EVENT>
+static void
+CounterFanIn(const char* name, Timer& timer)
+{
+    AtomicCounter counter = 0;
+    AtomicCounter round = 0;
+    CondVarEvent event;
+    std::thread threads[numThreads];
+    IndexT i;
+    for (i = 0; i < numThreads; i++)
+    {
+        threads[i] = std::thread([&]()
+        {
+            IndexT j;
+            for (j = 1; j <= rounds; j++)
+            {
+                int current;
+                while ((current = round) < j)
+                    Futex::Wait(&round, current);
+                if (USE_EVENT)
+                {
+                    if (Interlocked::Decrement(&counter) == 0)
+                        event.Signal();
+                }
+                else
+                    DecrementCounter(&counter);
+            }
+        });
+    }
+
+    const Time start = timer.GetTime();
+    for (i = 1; i <= rounds; i++)
+    {
+        counter = numThreads;
+        Interlocked::Exchange(&round, i);
+        Futex::WakeAll(&round);
+        if (USE_EVENT)
+            event.Wait();
+        else
+            WaitForCounter(&counter);
+    }
+    Report(name, timer.GetTime() - start, rounds);
+
+    for (i = 0; i < numThreads; i++)
+        threads[i].join();
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+BarrierRounds(const char* name, Timer& timer)
+{
+    ThreadBarrier barrier;
+    barrier.Setup(numThreads);
+    int value = 0;
+    std::thread threads[numThreads];
+    const Time start = timer.GetTime();
+    IndexT i;
+    for (i = 0; i < numThreads; i++)
+    {
+        threads[i] = std::thread([&]()
+        {
+            IndexT j;
+            for (j = 0; j < rounds; j++)
+            {
+                if (barrier.Arrive())
+                {
+                    value++;
+                    barrier.SignalContinue();
+                }
+                else
+                    barrier.Wait();
+            }
+        });
+    }
+    for (i = 0; i < numThreads; i++)
+        threads[i].join();
+    Report(name, timer.GetTime() - start, rounds);
+    n_assert(value == rounds);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+SyncBench::Run(Timer& timer)
+{
+    CriticalSection critSect;
+    std::recursive_mutex mutex;
+    timer.Start();
+
+    LockUncontended("CriticalSection uncontended", timer, [&]() { critSect.Enter(); }, [&]() { critSect.Leave(); });
+    LockUncontended("std::recursive_mutex uncontended", timer, [&]() { mutex.lock(); }, [&]() { mutex.unlock(); });
+    LockContended("CriticalSection contended", timer, [&]() { critSect.Enter(); }, [&]() { critSect.Leave(); });
+    LockContended("std::recursive_mutex contended", timer, [&]() { mutex.lock(); }, [&]() { mutex.unlock(); });
+
+    EventUncontended<Event>("Event signal and wait", timer);
+    EventUncontended<CondVarEvent>("condition variable signal and wait", timer);
+    EventPingPong<Event>("Event ping-pong", timer);
+    EventPingPong<CondVarEvent>("condition variable ping-pong", timer);
+
+    CounterFanIn<false>("WaitForCounter fan-in", timer);
+    CounterFanIn<true>("counter and event fan-in", timer);
+
+    BarrierRounds("ThreadBarrier round", timer);
+    timer.Stop();
+}
+
+} // namespace Benchmarking
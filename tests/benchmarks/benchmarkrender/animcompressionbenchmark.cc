@@ -0,0 +1,243 @@
+//------------------------------------------------------------------------------
+//  animcompressionbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "animcompressionbenchmark.h"
+#include "coreanimation/animation.h"
+#include "coreanimation/animkeycompression.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::AnimCompressionBench, 'ANCB', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace CoreAnimation;
+
+static const SizeT numJoints = 128;
+static const SizeT numKeys = 240;
+static const Tick keyDuration = 40;
+static const int numSamples = 20000;
+
+//------------------------------------------------------------------------------
+/**
+    One skeleton animation, every joint has a translation, rotation and
+    scale curve, the scale curves and every fourth translation curve don't
+    move, like in most exported animations.
+*/
+struct BenchAnim
+{
+    AnimClip clip;
+    Util::FixedArray<AnimCurve> curves;
+    Util::Array<AnimKeyBuffer::Interval> intervals;
+    Util::Array<float> keys;
+    Util::Array<ushort> packedKeys;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+static Math::vec4
+TranslationKey(IndexT joint, IndexT key)
+{
+    if (joint % 4 == 0)
+        return Math::vec4(0.0f, 0.25f, 0.0f, 0.0f);
+    const float t = key * 0.05f + joint;
+    return Math::vec4(Math::sin(t) * 0.5f, 0.25f + Math::cos(t * 0.7f) * 0.1f, Math::sin(t * 1.3f) * 0.3f, 0.0f);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static Math::quat
+RotationKey(IndexT joint, IndexT key)
+{
+    const float t = key * 0.05f + joint;
+    const Math::vec3 axis = Math::normalize(Math::vec3(Math::sin(joint * 0.3f), 1.0f, Math::cos(joint * 0.7f)));
+    return Math::rotationquataxis(axis, Math::sin(t) * 1.5f);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Build the animation with float keys, or the way the anim builder saver
+    stores it with quantized and constant curves.
+*/
+static void
+BuildAnim(BenchAnim& anim, bool packed)
+{
+    anim.clip.firstCurve = 0;
+    anim.clip.numCurves = numJoints * 3;
+    anim.clip.duration = (numKeys - 1) * keyDuration;
+    anim.curves.SetSize(numJoints * 3);
+
+    IndexT joint, key, i;
+    for (joint = 0; joint < numJoints; joint++)
+    {
+        for (i = 0; i < 3; i++)
+        {
+            AnimCurve& curve = anim.curves[joint * 3 + i];
+            curve.curveType = i == 0 ? CurveType::Translation : (i == 1 ? CurveType::Rotation : CurveType::Scale);
+            curve.preInfinityType = InfinityType::Cycle;
+            curve.postInfinityType = InfinityType::Cycle;
+            curve.firstIntervalOffset = anim.intervals.Size();
+            curve.numIntervals = numKeys - 1;
+
+            const bool constant = curve.curveType == CurveType::Scale || (curve.curveType == CurveType::Translation && joint % 4 == 0);
+            if (packed && constant)
+            {
+                curve.keyFormat = KeyFormat::Constant;
+                curve.keyOffset = curve.curveType == CurveType::Scale ? Math::vec4(1.0f, 1.0f, 1.0f, 0.0f) : TranslationKey(joint, 0);
+                curve.numIntervals = 0;
+                continue;
+            }
+
+            // range of the vector keys
+            Math::vec4 minKey(FLT_MAX), maxKey(-FLT_MAX);
+            for (key = 0; key < numKeys; key++)
+            {
+                minKey = Math::minimize(minKey, TranslationKey(joint, key));
+                maxKey = Math::maximize(maxKey, TranslationKey(joint, key));
+            }
+            if (packed)
+            {
+                curve.keyFormat = KeyFormat::Quantized;
+                if (curve.curveType == CurveType::Translation)
+                {
+                    curve.keyOffset = minKey;
+                    curve.keyScale = (maxKey - minKey) * (1.0f / 65535.0f);
+                }
+            }
+
+            uint firstKey = packed ? anim.packedKeys.Size() : anim.keys.Size();
+            uint stride = packed ? PackedKeyStride : (curve.curveType == CurveType::Rotation ? 4 : 3);
+            for (key = 0; key < numKeys; key++)
+            {
+                const Math::quat rotation = RotationKey(joint, key);
+                const Math::vec4 translation = curve.curveType == CurveType::Scale ? Math::vec4(1.0f, 1.0f, 1.0f, 0.0f) : TranslationKey(joint, key);
+                if (packed)
+                {
+                    ushort words[PackedKeyStride];
+                    if (curve.curveType == CurveType::Rotation)
+                        PackRotationKey(rotation, words);
+                    else
+                        PackVectorKey(&translation.x, curve.keyOffset, curve.keyScale, words);
+                    anim.packedKeys.AppendArray(words, PackedKeyStride);
+                }
+                else if (curve.curveType == CurveType::Rotation)
+                {
+                    const float values[] = { rotation.x, rotation.y, rotation.z, rotation.w };
+                    anim.keys.AppendArray(values, 4);
+                }
+                else
+                    anim.keys.AppendArray(&translation.x, 3);
+
+                if (key > 0)
+                {
+                    AnimKeyBuffer::Interval interval;
+                    interval.start = (key - 1) * keyDuration;
+                    interval.end = key * keyDuration;
+                    interval.key0 = firstKey + (key - 1) * stride;
+                    interval.key1 = firstKey + key * stride;
+                    interval.duration = 1.0f / keyDuration;
+                    anim.intervals.Append(interval);
+                }
+            }
+        }
+    }
+
+    // unpacking reads past the last key
+    for (i = 0; i < PackedKeyPadding; i++)
+        anim.packedKeys.Append(0);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static SizeT
+ByteSize(const BenchAnim& anim)
+{
+    return anim.keys.Size() * sizeof(float) + anim.packedKeys.Size() * sizeof(ushort) + anim.intervals.Size() * sizeof(AnimKeyBuffer::Interval);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static Time
+SampleAnim(Timer& timer, const BenchAnim& anim, float* samples, uchar* counts)
+{
+    Util::FixedArray<Math::vec4> idleSamples(anim.clip.numCurves, Math::vec4(0.0f));
+    Util::FixedArray<uint> lastIntervals(anim.clip.numCurves, 0);
+    const Time start = timer.GetTime();
+    IndexT i;
+    for (i = 0; i < numSamples; i++)
+    {
+        const Tick time = (i * 7) % anim.clip.duration;
+        AnimSampleLinear(anim.clip, anim.curves, time, Math::vec4(1.0f), idleSamples, anim.keys.Begin(), anim.packedKeys.Begin(), anim.intervals.Begin(), lastIntervals.Begin(), samples, counts);
+    }
+    return timer.GetTime() - start;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+Report(const char* name, Time time, SizeT byteSize)
+{
+    const double curves = (double)numSamples * numJoints * 3;
+    n_printf("%s: %.1f KB, %.2f ns/curve, %.1f M curves/s\n", name, byteSize / 1024.0, time / curves * 1e9, curves / time * 1e-6);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+AnimCompressionBench::Run(Timer& timer)
+{
+    BenchAnim raw, packed;
+    BuildAnim(raw, false);
+    BuildAnim(packed, true);
+
+    const SizeT numFloats = numJoints * 10;
+    float* rawSamples = new float[numFloats];
+    float* packedSamples = new float[numFloats];
+    uchar* counts = new uchar[numJoints * 3];
+
+    timer.Start();
+    Report("float keys", SampleAnim(timer, raw, rawSamples, counts), ByteSize(raw));
+    Report("quantized keys", SampleAnim(timer, packed, packedSamples, counts), ByteSize(packed));
+    timer.Stop();
+    n_printf("memory saved: %.1f%%\n", 100.0 * (1.0 - (double)ByteSize(packed) / ByteSize(raw)));
+
+    // compare both at every key and halfway between them
+    Util::FixedArray<Math::vec4> idleSamples(numJoints * 3, Math::vec4(0.0f));
+    Util::FixedArray<uint> rawIntervals(numJoints * 3, 0), packedIntervals(numJoints * 3, 0);
+    float maxTranslationError = 0.0f, maxRotationError = 0.0f;
+    Tick time;
+    for (time = 0; time < raw.clip.duration; time += keyDuration / 2)
+    {
+        AnimSampleLinear(raw.clip, raw.curves, time, Math::vec4(1.0f), idleSamples, raw.keys.Begin(), nullptr, raw.intervals.Begin(), rawIntervals.Begin(), rawSamples, counts);
+        AnimSampleLinear(packed.clip, packed.curves, time, Math::vec4(1.0f), idleSamples, nullptr, packed.packedKeys.Begin(), packed.intervals.Begin(), packedIntervals.Begin(), packedSamples, counts);
+
+        IndexT i;
+        for (i = 0; i < numFloats; i += 10)
+        {
+            IndexT j;
+            for (j = 0; j < 3; j++)
+                maxTranslationError = Math::max(maxTranslationError, Math::abs(rawSamples[i + j] - packedSamples[i + j]));
+
+            // q and -q are the same rotation
+            const Math::quat q0(rawSamples[i + 3], rawSamples[i + 4], rawSamples[i + 5], rawSamples[i + 6]);
+            const Math::quat q1(packedSamples[i + 3], packedSamples[i + 4], packedSamples[i + 5], packedSamples[i + 6]);
+            const float sign = Math::dot(q0, q1) < 0.0f ? -1.0f : 1.0f;
+            for (j = 3; j < 7; j++)
+                maxRotationError = Math::max(maxRotationError, Math::abs(rawSamples[i + j] - packedSamples[i + j] * sign));
+        }
+    }
+    n_printf("max translation error: %g, max rotation error: %g\n", maxTranslationError, maxRotationError);
+
+    delete[] rawSamples;
+    delete[] packedSamples;
+    delete[] counts;
+}
+
+} // namespace Benchmarking
@@ -0,0 +1,26 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::AnimCompressionBench
+
+    Samples the same skeleton animation from float keys and from quantized
+    keys, and reports the memory saved, the largest error and the sampling
+    throughput of both.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class AnimCompressionBench : public Benchmark
+{
+    __DeclareClass(AnimCompressionBench);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
@@ -0,0 +1,329 @@
+//------------------------------------------------------------------------------
+//  characterlodbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "characterlodbenchmark.h"
+#include "characters/animationlod.h"
+#include "characters/skeleton.h"
+#include "coreanimation/animation.h"
+#include "math/simdkernels.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::CharacterLodBench, 'CLOD', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace CoreAnimation;
+using namespace Characters;
+
+static const SizeT numChains = 7;
+static const SizeT chainLength = 9;
+static const SizeT numJoints = 1 + numChains * chainLength;
+static const SizeT sampleWidth = 10;
+static const SizeT numKeys = 60;
+static const Tick keyDuration = 40;
+static const SizeT numCharacters = 5000;
+static const SizeT numPhases = 16;
+static const int numFrames = 60;
+static const Time frameTime = 1.0 / 60.0;
+static const float reducedScreenSize = 0.1f;
+static const float minimalScreenSize = 0.04f;
+
+//------------------------------------------------------------------------------
+/**
+    A root with a couple of joint chains hanging off it, like the spine,
+    limbs and fingers of a humanoid, playing one looping clip. Characters
+    walk in a few groups which are in step, and stand at growing distances
+    from the camera, every third one behind it.
+*/
+struct BenchCrowd
+{
+    SkeletonId skeleton;
+    Util::FixedArray<SkeletonJobJoint> jobJoints;
+    AnimClip clip;
+    Util::FixedArray<AnimCurve> curves;
+    Util::Array<AnimKeyBuffer::Interval> intervals;
+    Util::Array<float> keys;
+
+    Util::FixedArray<AnimationLod> lods;
+    Util::FixedArray<Tick> phases;
+};
+
+/// what the character context keeps per character
+struct BenchCharacters
+{
+    Util::FixedArray<Math::mat4> palettes;
+    Util::FixedArray<Math::mat4> targets;
+    Util::FixedArray<uint> lastIntervals;
+};
+
+/// scratch memory of one evaluation
+struct BenchScratch
+{
+    float samples[numJoints * sampleWidth];
+    uchar counts[numJoints * 3];
+    Math::mat4 tmpMatrices[numJoints];
+    Math::mat4 scaledMatrices[numJoints];
+};
+
+/// the same as the character context's AnimationLodState
+struct BenchLodState
+{
+    uchar updatePeriod;
+    uchar framesSinceUpdate;
+    bool snap;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+BuildCrowd(BenchCrowd& crowd)
+{
+    SkeletonCreateInfo info;
+    info.joints.Resize(numJoints);
+    info.bindPoses.Resize(numJoints);
+    info.idleSamples.Resize(numJoints * 3);
+    crowd.jobJoints.Resize(numJoints);
+    IndexT i;
+    for (i = 0; i < numJoints; i++)
+    {
+        const IndexT parent = i == 0 ? InvalidIndex : ((i - 1) % chainLength == 0 ? 0 : i - 1);
+        info.joints[i].parentJointIndex = parent;
+        info.joints[i].parentJoint = parent == InvalidIndex ? nullptr : &info.joints[parent];
+        info.bindPoses[i] = Math::translation(0.0f, -0.25f * i, 0.0f);
+        info.idleSamples[i * 3] = Math::vec4(0.0f, 0.25f, 0.0f, 0.0f);
+        info.idleSamples[i * 3 + 1] = Math::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        info.idleSamples[i * 3 + 2] = Math::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+        crowd.jobJoints[i].parentJointIndex = parent;
+    }
+    crowd.skeleton = CreateSkeleton(info);
+
+    // translation and rotation move, scale is constant
+    crowd.clip.firstCurve = 0;
+    crowd.clip.numCurves = numJoints * 3;
+    crowd.clip.duration = (numKeys - 1) * keyDuration;
+    crowd.curves.Resize(numJoints * 3);
+    IndexT j, key;
+    for (i = 0; i < numJoints; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            AnimCurve& curve = crowd.curves[i * 3 + j];
+            curve.curveType = j == 0 ? CurveType::Translation : (j == 1 ? CurveType::Rotation : CurveType::Scale);
+            curve.preInfinityType = InfinityType::Cycle;
+            curve.postInfinityType = InfinityType::Cycle;
+            curve.firstIntervalOffset = crowd.intervals.Size();
+            if (curve.curveType == CurveType::Scale)
+            {
+                curve.keyFormat = KeyFormat::Constant;
+                curve.keyOffset = Math::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+                continue;
+            }
+
+            curve.numIntervals = numKeys - 1;
+            const uint firstKey = crowd.keys.Size();
+            const uint stride = curve.curveType == CurveType::Rotation ? 4 : 3;
+            for (key = 0; key < numKeys; key++)
+            {
+                const float t = Math::sin(key * N_PI_DOUBLE / (numKeys - 1)) + i * 0.1f;
+                if (curve.curveType == CurveType::Rotation)
+                {
+                    const Math::quat rotation = Math::rotationquataxis(Math::vec3(1.0f, 0.0f, 0.0f), Math::sin(t) * 0.5f);
+                    const float values[] = { rotation.x, rotation.y, rotation.z, rotation.w };
+                    crowd.keys.AppendArray(values, 4);
+                }
+                else
+                {
+                    const float values[] = { Math::sin(t) * 0.05f, 0.25f, Math::cos(t) * 0.05f };
+                    crowd.keys.AppendArray(values, 3);
+                }
+
+                if (key > 0)
+                {
+                    AnimKeyBuffer::Interval interval;
+                    interval.start = (key - 1) * keyDuration;
+                    interval.end = key * keyDuration;
+                    interval.key0 = firstKey + (key - 1) * stride;
+                    interval.key1 = firstKey + key * stride;
+                    interval.duration = 1.0f / keyDuration;
+                    crowd.intervals.Append(interval);
+                }
+            }
+        }
+    }
+
+    // a character is about two units big and stands 2 to 100 units away
+    crowd.lods.Resize(numCharacters);
+    crowd.phases.Resize(numCharacters);
+    for (i = 0; i < numCharacters; i++)
+    {
+        const float viewDistance = 2.0f + (i * 7 % 99);
+        if (i % 3 == 0)
+            crowd.lods[i] = AnimationLod_Culled;
+        else
+            crowd.lods[i] = AnimationLodFromScreenSize(2.0f / viewDistance, reducedScreenSize, minimalScreenSize);
+        crowd.phases[i] = (i % numPhases) * keyDuration * 3;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+    Sample the clip and evaluate the skeleton, as EvalCharacter does.
+*/
+static void
+EvaluatePose(const BenchCrowd& crowd, Tick time, const AnimSampleMask* lodMask, uint* lastIntervals, BenchScratch& scratch, Math::mat4* palette)
+{
+    const Util::FixedArray<Math::vec4>& idleSamples = SkeletonGetIdleSamples(crowd.skeleton);
+    AnimSampleLinear(crowd.clip, crowd.curves, time % crowd.clip.duration, Math::vec4(1.0f), idleSamples, crowd.keys.Begin(), nullptr, crowd.intervals.Begin(), lastIntervals, scratch.samples, scratch.counts, lodMask);
+    SkeletonEvaluate(crowd.skeleton, crowd.jobJoints.Begin(), scratch.samples, sampleWidth, scratch.tmpMatrices, scratch.scaledMatrices, palette);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Every character which is animated at all is evaluated every frame.
+*/
+static Time
+RunFull(Timer& timer, const BenchCrowd& crowd, BenchCharacters& characters, BenchScratch& scratch, SizeT& numEvaluated)
+{
+    numEvaluated = 0;
+    const Time start = timer.GetTime();
+    IndexT frame, i;
+    for (frame = 0; frame < numFrames; frame++)
+    {
+        const Tick now = SecondsToTicks(frame * frameTime);
+        for (i = 0; i < numCharacters; i++)
+        {
+            if (crowd.lods[i] == AnimationLod_Culled)
+                continue;
+            EvaluatePose(crowd, now + crowd.phases[i], nullptr, &characters.lastIntervals[i * numJoints * 3], scratch, &characters.palettes[i * numJoints]);
+            numEvaluated++;
+        }
+    }
+    return timer.GetTime() - start;
+}
+
+//------------------------------------------------------------------------------
+/**
+    The character context's track update, pose sharing, evaluation and
+    palette blending, in one pass on one thread.
+*/
+static Time
+RunLod(Timer& timer, const BenchCrowd& crowd, BenchCharacters& characters, BenchScratch& scratch, SizeT& numEvaluated)
+{
+    BenchLodState initialState = { 1, 0, true };
+    Util::FixedArray<BenchLodState> lodStates(numCharacters, initialState);
+    Util::FixedArray<IndexT> poseOwners(numPhases * NumAnimationLods);
+
+    numEvaluated = 0;
+    const Time start = timer.GetTime();
+    IndexT frame, i;
+    for (frame = 0; frame < numFrames; frame++)
+    {
+        const Tick now = SecondsToTicks(frame * frameTime);
+        poseOwners.Fill(InvalidIndex);
+        for (i = 0; i < numCharacters; i++)
+        {
+            const AnimationLod lod = crowd.lods[i];
+            BenchLodState& lodState = lodStates[i];
+            if (lod == AnimationLod_Culled)
+            {
+                lodState.snap = true;
+                continue;
+            }
+
+            Math::mat4* palette = &characters.palettes[i * numJoints];
+            Math::mat4* target = &characters.targets[i * numJoints];
+            if (lodState.snap || AnimationLodIsUpdateFrame(lod, frame, i))
+            {
+                const SizeT period = AnimationLodUpdatePeriod(lod);
+                const Tick lookahead = SecondsToTicks(frameTime * (period - 1));
+
+                // characters in step share the pose of the first one
+                IndexT& owner = poseOwners[crowd.phases[i] / (keyDuration * 3) * NumAnimationLods + lod];
+                if (owner == InvalidIndex)
+                {
+                    owner = i;
+                    EvaluatePose(crowd, now + crowd.phases[i] + lookahead, SkeletonGetLodMask(crowd.skeleton, lod), &characters.lastIntervals[i * numJoints * 3], scratch, target);
+                    numEvaluated++;
+                }
+                else
+                    Memory::Copy(&characters.targets[owner * numJoints], target, numJoints * sizeof(Math::mat4));
+
+                lodState.updatePeriod = (uchar)period;
+                lodState.framesSinceUpdate = 0;
+                if (lodState.snap)
+                {
+                    Memory::Copy(target, palette, numJoints * sizeof(Math::mat4));
+                    lodState.snap = false;
+                    continue;
+                }
+            }
+            else if (lodState.framesSinceUpdate < lodState.updatePeriod)
+                lodState.framesSinceUpdate++;
+
+            if (lodState.framesSinceUpdate < lodState.updatePeriod)
+                Math::LerpMatrices(palette, palette, target, 1.0f / (lodState.updatePeriod - lodState.framesSinceUpdate), numJoints);
+        }
+    }
+    return timer.GetTime() - start;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+Report(const char* name, Time time, SizeT numEvaluated)
+{
+    n_printf("%s: %.3f ms/frame, %.1f poses evaluated per frame\n", name, time / numFrames * 1e3, (double)numEvaluated / numFrames);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CharacterLodBench::Run(Timer& timer)
+{
+    BenchCrowd crowd;
+    BuildCrowd(crowd);
+
+    BenchCharacters full, lod;
+    full.palettes.Resize(numCharacters * numJoints);
+    full.lastIntervals.Resize(numCharacters * numJoints * 3);
+    full.lastIntervals.Fill(0);
+    lod.palettes.Resize(numCharacters * numJoints);
+    lod.targets.Resize(numCharacters * numJoints);
+    lod.lastIntervals.Resize(numCharacters * numJoints * 3);
+    lod.lastIntervals.Fill(0);
+    BenchScratch* scratch = new BenchScratch;
+
+    SizeT numFull, numLod;
+    timer.Start();
+    const Time fullTime = RunFull(timer, crowd, full, *scratch, numFull);
+    const Time lodTime = RunLod(timer, crowd, lod, *scratch, numLod);
+    timer.Stop();
+    Report("full", fullTime, numFull);
+    Report("animation lod", lodTime, numLod);
+    n_printf("speedup: %.2fx\n", fullTime / lodTime);
+
+    // both end on the same frame, the lod palettes lag behind by what the blend hasn't caught up yet
+    float maxError = 0.0f;
+    IndexT i, j;
+    for (i = 0; i < numCharacters; i++)
+    {
+        if (crowd.lods[i] == AnimationLod_Culled)
+            continue;
+        for (j = 0; j < numJoints; j++)
+        {
+            const Math::vec4 delta = full.palettes[i * numJoints + j].r[3] - lod.palettes[i * numJoints + j].r[3];
+            maxError = Math::max(maxError, Math::length(delta));
+        }
+    }
+    n_printf("max joint position error: %g\n", maxError);
+
+    delete scratch;
+    DestroySkeleton(crowd.skeleton);
+}
+
+} // namespace Benchmarking
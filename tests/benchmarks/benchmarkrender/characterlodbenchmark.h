@@ -0,0 +1,28 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::CharacterLodBench
+
+    Animates a crowd of characters the way the character context does,
+    once with every character sampled and evaluated every frame, and once
+    with animation LOD, where small characters update less often and with
+    fewer joints, unseen ones not at all, and characters in step share
+    their pose.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class CharacterLodBench : public Benchmark
+{
+    __DeclareClass(CharacterLodBench);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
@@ -0,0 +1,42 @@
+//------------------------------------------------------------------------------
+//  main.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "core/coreserver.h"
+#include "core/sysfunc.h"
+#include "benchmarkbase/benchmarkrunner.h"
+
+#include "particlebenchmark.h"
+#include "animcompressionbenchmark.h"
+#include "characterlodbenchmark.h"
+#include "skeletonevalbenchmark.h"
+#include "occlusioncullingbenchmark.h"
+
+using namespace Core;
+using namespace Benchmarking;
+
+int __cdecl
+main(int argc, char** argv)
+{
+    // create Nebula runtime
+    Ptr<CoreServer> coreServer = CoreServer::Create();
+    coreServer->SetAppName(Util::StringAtom("Nebula Render Benchmark Runner"));
+    coreServer->Open();
+
+    // setup and run benchmarks, these only run the cpu side and need no graphics device
+    Ptr<BenchmarkRunner> runner = BenchmarkRunner::Create();
+    runner->AttachBenchmark(ParticleBench::Create());
+    runner->AttachBenchmark(AnimCompressionBench::Create());
+    runner->AttachBenchmark(CharacterLodBench::Create());
+    runner->AttachBenchmark(SkeletonEvalBench::Create());
+    runner->AttachBenchmark(OcclusionCullingBench::Create());
+    runner->Run();
+
+    // shutdown Nebula runtime
+    runner = nullptr;
+    coreServer->Close();
+    coreServer = nullptr;
+    SysFunc::Exit(0);
+    return 0;
+}
@@ -0,0 +1,272 @@
+//------------------------------------------------------------------------------
+//  occlusioncullingbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "occlusioncullingbenchmark.h"
+#include "visibility/systems/occlusionsystem.h"
+#include "jobs2/jobs2.h"
+#include "system/cpu.h"
+#include "system/systeminfo.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::OcclusionCullingBench, 'OCCB', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Math;
+using namespace Visibility;
+
+static const SizeT gridSize = 20;
+static const float blockSpacing = 20.0f;
+static const SizeT numProps = 20000;
+static const SizeT bufferWidth = 320;
+static const SizeT bufferHeight = 160;
+static const int numRounds = 20;
+static const SizeT propGroupSize = 1024;
+
+//------------------------------------------------------------------------------
+/**
+*/
+struct BenchCity
+{
+    Util::Array<vec3> buildingVertices;
+    Util::Array<uint32> buildingIndices;
+    Util::Array<mat4> buildingTransforms;
+    Util::Array<bbox> buildingBoxes;
+
+    Util::FixedArray<bbox> props;
+    Util::FixedArray<uint32> visibleIds;
+    Util::FixedArray<ClipStatus::Type> status;
+    SizeT numVisible;
+
+    mat4 viewProjection;
+};
+
+/// what the culling jobs get
+struct BenchCullContext
+{
+    OcclusionBuffer* buffer;
+    BenchCity* city;
+};
+
+//------------------------------------------------------------------------------
+/**
+    Buildings of different heights on a grid of blocks, with the props
+    scattered over the streets and between the buildings. The camera
+    stands on a street and looks down along it.
+*/
+static void
+BuildCity(BenchCity& city)
+{
+    // a unit cube, corner i has its x, y and z set by the bits of i
+    IndexT i;
+    for (i = 0; i < 8; i++)
+        city.buildingVertices.Append(vec3(i & 1 ? 0.5f : -0.5f, i & 2 ? 1.0f : 0.0f, i & 4 ? 0.5f : -0.5f));
+    const uint32 faces[6][4] = { { 0, 2, 6, 4 }, { 1, 3, 7, 5 }, { 0, 1, 5, 4 }, { 2, 3, 7, 6 }, { 0, 1, 3, 2 }, { 4, 5, 7, 6 } };
+    for (i = 0; i < 6; i++)
+    {
+        const uint32 quad[6] = { faces[i][0], faces[i][1], faces[i][2], faces[i][0], faces[i][2], faces[i][3] };
+        city.buildingIndices.AppendArray(quad, 6);
+    }
+
+    const float origin = -0.5f * blockSpacing * gridSize;
+    IndexT x, z;
+    for (z = 0; z < gridSize; z++)
+    {
+        for (x = 0; x < gridSize; x++)
+        {
+            const vec3 size(Math::rand(10.0f, 14.0f), Math::rand(8.0f, 40.0f), Math::rand(10.0f, 14.0f));
+            const mat4 transform = translation(origin + (x + 0.5f) * blockSpacing, 0, origin + (z + 0.5f) * blockSpacing) * scaling(size);
+            bbox box(point(0, 0.5f, 0), vector(0.5f));
+            box.transform(transform);
+            city.buildingTransforms.Append(transform);
+            city.buildingBoxes.Append(box);
+        }
+    }
+
+    city.props.Resize(numProps);
+    city.status.Resize(numProps);
+    city.visibleIds.Resize(numProps);
+    for (i = 0; i < numProps; i++)
+    {
+        const point center(Math::rand(origin, -origin), Math::rand(0.5f, 3.0f), Math::rand(origin, -origin));
+        city.props[i] = bbox(center, vector(Math::rand(0.3f, 1.5f)));
+    }
+
+    const mat4 view = inverse(lookatrh(point(origin + gridSize / 2 * blockSpacing, 1.8f, -origin), point(origin + gridSize / 2 * blockSpacing + 10.0f, 1.8f, 0), vector(0, 1, 0)));
+    city.viewProjection = perspfovrh(deg2rad(60.0f), float(bufferWidth) / bufferHeight, 0.1f, 1000.0f) * view;
+
+    // what the frustum culling leaves for the occlusion culling
+    city.numVisible = 0;
+    for (i = 0; i < numProps; i++)
+    {
+        if (city.props[i].clipstatus(city.viewProjection) != ClipStatus::Outside)
+            city.visibleIds[city.numVisible++] = i;
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+AddBuildings(OcclusionBuffer& buffer, const BenchCity& city)
+{
+    OcclusionBufferClear(buffer);
+    IndexT i;
+    for (i = 0; i < city.buildingTransforms.Size(); i++)
+    {
+        if (city.buildingBoxes[i].clipstatus(city.viewProjection) == ClipStatus::Outside)
+            continue;
+        OcclusionBufferAddOccluder(buffer, city.viewProjection * city.buildingTransforms[i], city.buildingVertices.Begin(), city.buildingVertices.Size(), city.buildingIndices.Begin(), city.buildingIndices.Size());
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static SizeT
+CountHidden(const BenchCity& city)
+{
+    SizeT hidden = 0;
+    IndexT i;
+    for (i = 0; i < city.numVisible; i++)
+    {
+        if (city.status[city.visibleIds[i]] == ClipStatus::Outside)
+            hidden++;
+    }
+    return hidden;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+ResetStatus(BenchCity& city)
+{
+    IndexT i;
+    for (i = 0; i < city.numVisible; i++)
+        city.status[city.visibleIds[i]] = ClipStatus::Inside;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+RasterizeJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    auto context = static_cast<BenchCullContext*>(ctx);
+    IndexT i;
+    for (i = 0; i < groupSize; i++)
+    {
+        const IndexT index = invocationOffset + i;
+        if (index >= totalJobs)
+            return;
+        OcclusionBufferRasterizeTile(*context->buffer, index);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+TestJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    auto context = static_cast<BenchCullContext*>(ctx);
+    if (invocationOffset >= totalJobs)
+        return;
+    BenchCity& city = *context->city;
+    OcclusionBufferTestBoxes(*context->buffer, city.status.Begin(), city.props.Begin(), city.visibleIds.Begin() + invocationOffset, nullptr, Math::min(groupSize, totalJobs - invocationOffset), city.viewProjection);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+RunSingleThread(Timer& timer, OcclusionBuffer& buffer, BenchCity& city)
+{
+    Time binTime = 0, rasterTime = 0, testTime = 0;
+    IndexT round, i;
+    for (round = 0; round < numRounds; round++)
+    {
+        ResetStatus(city);
+        Time start = timer.GetTime();
+        AddBuildings(buffer, city);
+        binTime += timer.GetTime() - start;
+
+        start = timer.GetTime();
+        for (i = 0; i < buffer.tilesX * buffer.tilesY; i++)
+            OcclusionBufferRasterizeTile(buffer, i);
+        rasterTime += timer.GetTime() - start;
+
+        start = timer.GetTime();
+        OcclusionBufferTestBoxes(buffer, city.status.Begin(), city.props.Begin(), city.visibleIds.Begin(), nullptr, city.numVisible, city.viewProjection);
+        testTime += timer.GetTime() - start;
+    }
+    n_printf("%s, 1 thread: bin %.3f ms, raster %.3f ms, test %.3f ms per frame\n", System::Cpu::SimdLevelAsString(System::Cpu::GetSimdLevel()), binTime / numRounds * 1e3, rasterTime / numRounds * 1e3, testTime / numRounds * 1e3);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+RunJobs(Timer& timer, OcclusionBuffer& buffer, BenchCity& city, SizeT numThreads)
+{
+    const Time start = timer.GetTime();
+    IndexT round;
+    for (round = 0; round < numRounds; round++)
+    {
+        ResetStatus(city);
+        AddBuildings(buffer, city);
+
+        BenchCullContext context;
+        context.buffer = &buffer;
+        context.city = &city;
+        Threading::AtomicCounter rasterCounter = 1;
+        Jobs2::JobDispatch(RasterizeJob, buffer.tilesX * buffer.tilesY, 1, context, nullptr, &rasterCounter);
+        Threading::WaitForCounter(&rasterCounter);
+        Threading::AtomicCounter testCounter = 1;
+        Jobs2::JobDispatch(TestJob, city.numVisible, propGroupSize, context, nullptr, &testCounter);
+        Threading::WaitForCounter(&testCounter);
+        Jobs2::JobNewFrame();
+    }
+    n_printf("%s, %d job threads: %.3f ms per frame\n", System::Cpu::SimdLevelAsString(System::Cpu::GetSimdLevel()), numThreads, (timer.GetTime() - start) / numRounds * 1e3);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionCullingBench::Run(Timer& timer)
+{
+    BenchCity city;
+    BuildCity(city);
+
+    OcclusionBuffer buffer;
+    OcclusionBufferSetup(buffer, bufferWidth, bufferHeight);
+
+    Jobs2::JobSystemInitInfo info;
+    info.name = "OcclusionCullingBench";
+    info.numThreads = System::NumCpuCores;
+    info.enableProfiling = false;
+    info.scratchMemorySize = 4_MB;
+    Jobs2::JobSystemInit(info);
+
+    timer.Start();
+    int level;
+    for (level = System::Cpu::SimdGeneric; level <= System::Cpu::GetMaxSimdLevel(); level++)
+    {
+        System::Cpu::SetSimdLevel((System::Cpu::SimdLevel)level);
+        RunSingleThread(timer, buffer, city);
+    }
+    System::Cpu::SetSimdLevel(System::Cpu::GetMaxSimdLevel());
+    RunJobs(timer, buffer, city, info.numThreads);
+    timer.Stop();
+
+    const SizeT hidden = CountHidden(city);
+    n_printf("%d props, %d in the frustum, %d hidden by %d occluder triangles, %.1f%% culled by occlusion\n", numProps, city.numVisible, hidden, buffer.triangles.Size(), city.numVisible > 0 ? 100.0f * hidden / city.numVisible : 0.0f);
+
+    Jobs2::JobSystemUninit();
+}
+
+} // namespace Benchmarking
@@ -0,0 +1,27 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::OcclusionCullingBench
+
+    Culls the props of a city block grid seen from street level, first by
+    the frustum only and then against the buildings rasterized into the
+    occlusion buffer, on one thread for each instruction set and over the
+    job threads.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class OcclusionCullingBench : public Benchmark
+{
+    __DeclareClass(OcclusionCullingBench);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
@@ -0,0 +1,137 @@
+//------------------------------------------------------------------------------
+//  particlebenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "particlebenchmark.h"
+#include "particles/particle.h"
+#include "jobs2/jobs2.h"
+#include "system/systeminfo.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::ParticleBench, 'PTBM', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Particles;
+
+static const SizeT numParticles = 1000000;
+static const int numSteps = 100;
+static const float stepTime = 1.0f / 60.0f;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+Report(const char* name, Time time, const ParticleJobSliceOutputData& output)
+{
+    const double particles = (double)numParticles * numSteps;
+    n_printf("%s: %.2f ms/step, %.1f M particles/s, %d living\n", name, time / numSteps * 1e3, particles / time * 1e-6, output.numLivingParticles);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Every particle is emitted with a different age, so they die off one
+    after the other over the steps, and the envelope lookups spread over
+    all samples like they would in a running system.
+*/
+static void
+EmitParticles(ParticleStreams& streams)
+{
+    streams.SetCapacity(numParticles);
+    const float lifeTime = numSteps * stepTime * 2.0f;
+    IndexT i;
+    for (i = 0; i < numParticles; i++)
+    {
+        const float f = (float)i / numParticles;
+        Particle particle;
+        particle.position.set(Math::rand(-10.0f, 10.0f), Math::rand(0.0f, 10.0f), Math::rand(-10.0f, 10.0f), 1.0f);
+        particle.startPosition = particle.position;
+        particle.stretchPosition = particle.position;
+        particle.velocity.set(Math::rand(-1.0f, 1.0f), Math::rand(2.0f, 5.0f), Math::rand(-1.0f, 1.0f), 0.0f);
+        particle.uvMinMax.set(1.0f, 1.0f, 0.0f, 0.0f);
+        particle.color.set(1.0f, 1.0f, 1.0f, 1.0f);
+        particle.rotation = 0.0f;
+        particle.rotationVariation = Math::rand(-1.0f, 1.0f);
+        particle.size = 1.0f;
+        particle.sizeVariation = Math::rand(0.5f, 1.0f);
+        particle.oneDivLifeTime = 1.0f / lifeTime;
+        particle.age = f * lifeTime;
+        particle.relAge = f;
+        particle.particleId = 1.0f;
+        streams.Add(particle);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ParticleBench::Run(Timer& timer)
+{
+    // smooth envelopes, the values don't matter as long as they are sane
+    float* sampleBuffer = new float[ParticleSystemNumEnvelopeSamples * EmitterAttrs::NumEnvelopeAttrs];
+    IndexT i;
+    for (i = 0; i < ParticleSystemNumEnvelopeSamples * EmitterAttrs::NumEnvelopeAttrs; i++)
+    {
+        const float t = (float)(i / EmitterAttrs::NumEnvelopeAttrs) / ParticleSystemNumEnvelopeSamples;
+        sampleBuffer[i] = 1.0f - t * 0.5f;
+    }
+
+    ParticleJobUniformData uniforms;
+    uniforms.gravity = Math::vector(0.0f, -9.81f, 0.0f);
+    uniforms.windVector = Math::vector(1.0f, 0.0f, 0.5f);
+    uniforms.sampleBuffer = sampleBuffer;
+
+    ParticleStreams streams;
+    ParticleJobSliceOutputData output;
+    IndexT step;
+
+    timer.Start();
+
+    // one thread, the whole system in one slice
+    EmitParticles(streams);
+    Time start = timer.GetTime();
+    for (step = 0; step < numSteps; step++)
+    {
+        JobStep(&uniforms, stepTime, &streams, 0, streams.Size(), &output);
+    }
+    Report("particle step, 1 thread", timer.GetTime() - start, output);
+
+    // split in groups over all job threads
+    Jobs2::JobSystemInitInfo info;
+    info.name = "ParticleBench";
+    info.numThreads = System::NumCpuCores;
+    info.enableProfiling = false;
+    info.scratchMemorySize = 4_MB;
+    Jobs2::JobSystemInit(info);
+
+    EmitParticles(streams);
+    start = timer.GetTime();
+    for (step = 0; step < numSteps; step++)
+    {
+        const SizeT numSlices = (streams.Size() + ParticleJobGroupSize - 1) / ParticleJobGroupSize;
+        ParticleJobContext context;
+        context.streams = &streams;
+        context.uniformData = &uniforms;
+        context.stepTime = stepTime;
+        context.numSlices = numSlices;
+        context.sliceOutputs = Jobs2::JobAlloc<ParticleJobSliceOutputData>(numSlices);
+        context.pendingSlices = Jobs2::JobAlloc<Threading::AtomicCounter>(1);
+        *context.pendingSlices = numSlices;
+        context.output = &output;
+
+        Threading::AtomicCounter counter = 1;
+        Jobs2::JobDispatch(ParticleStepJob, streams.Size(), ParticleJobGroupSize, context, nullptr, &counter);
+        Threading::WaitForCounter(&counter);
+        Jobs2::JobNewFrame();
+    }
+    Report(Util::String::Sprintf("particle step, %d job threads", info.numThreads).AsCharPtr(), timer.GetTime() - start, output);
+
+    Jobs2::JobSystemUninit();
+    timer.Stop();
+
+    delete[] sampleBuffer;
+}
+
+} // namespace Benchmarking
@@ -0,0 +1,291 @@
+//------------------------------------------------------------------------------
+//  skeletonevalbenchmark.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "skeletonevalbenchmark.h"
+#include "characters/skeleton.h"
+#include "math/simdkernels.h"
+#include "jobs2/jobs2.h"
+#include "system/systeminfo.h"
+
+namespace Benchmarking
+{
+__ImplementClass(Benchmarking::SkeletonEvalBench, 'SKEV', Benchmarking::Benchmark);
+
+using namespace Timing;
+using namespace Characters;
+
+static const SizeT sampleWidth = 10;
+static const SizeT numCharacterCounts = 3;
+static const SizeT characterCounts[numCharacterCounts] = { 100, 1000, 10000 };
+static const SizeT maxCharacters = 10000;
+static const int numRounds = 20;
+static const SizeT characterGroupSize = 64;
+
+//------------------------------------------------------------------------------
+/**
+*/
+struct BenchSkeletons
+{
+    SkeletonId skeleton;
+    SizeT numJoints;
+    Util::FixedArray<SkeletonJobJoint> jobJoints;
+    Util::FixedArray<float> samples;
+    Util::FixedArray<Math::mat4> scaledPalettes;
+    Util::FixedArray<Math::mat4> skinPalettes;
+};
+
+/// what the evaluation jobs get
+struct BenchEvalContext
+{
+    BenchSkeletons* skeletons;
+};
+
+//------------------------------------------------------------------------------
+/**
+*/
+static IndexT
+AddJoint(Util::Array<IndexT>& parents, IndexT parent)
+{
+    parents.Append(parent);
+    return parents.Size() - 1;
+}
+
+//------------------------------------------------------------------------------
+/**
+    A humanoid with a spine, a head, arms with five fingers of three
+    joints each and legs with toes, 53 joints in all.
+*/
+static void
+BuildSkeletons(BenchSkeletons& skeletons)
+{
+    Util::Array<IndexT> parents;
+    const IndexT root = AddJoint(parents, InvalidIndex);
+    const IndexT pelvis = AddJoint(parents, root);
+    const IndexT spine = AddJoint(parents, AddJoint(parents, AddJoint(parents, pelvis)));
+    AddJoint(parents, AddJoint(parents, spine));
+    IndexT side, finger;
+    for (side = 0; side < 2; side++)
+    {
+        const IndexT hand = AddJoint(parents, AddJoint(parents, AddJoint(parents, AddJoint(parents, spine))));
+        for (finger = 0; finger < 5; finger++)
+            AddJoint(parents, AddJoint(parents, AddJoint(parents, hand)));
+        AddJoint(parents, AddJoint(parents, AddJoint(parents, AddJoint(parents, pelvis))));
+    }
+
+    SkeletonCreateInfo info;
+    skeletons.numJoints = parents.Size();
+    info.joints.Resize(skeletons.numJoints);
+    info.bindPoses.Resize(skeletons.numJoints);
+    info.idleSamples.Resize(skeletons.numJoints * 3);
+    skeletons.jobJoints.Resize(skeletons.numJoints);
+    IndexT i;
+    for (i = 0; i < skeletons.numJoints; i++)
+    {
+        info.joints[i].parentJointIndex = parents[i];
+        info.joints[i].parentJoint = parents[i] == InvalidIndex ? nullptr : &info.joints[parents[i]];
+        info.bindPoses[i] = Math::translation(0.0f, -0.1f * i, 0.0f);
+        info.idleSamples[i * 3] = Math::vec4(0.0f, 0.1f, 0.0f, 0.0f);
+        info.idleSamples[i * 3 + 1] = Math::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        info.idleSamples[i * 3 + 2] = Math::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+        skeletons.jobJoints[i].parentJointIndex = parents[i];
+    }
+    skeletons.skeleton = CreateSkeleton(info);
+
+    // every character gets its own pose, as if sampled from different clips
+    skeletons.samples.Resize(maxCharacters * skeletons.numJoints * sampleWidth);
+    for (i = 0; i < maxCharacters * skeletons.numJoints; i++)
+    {
+        float* sample = &skeletons.samples[i * sampleWidth];
+        const Math::quat rotation = Math::rotationquataxis(Math::normalize(Math::vec3(Math::rand(-1.0f, 1.0f), 1.0f, Math::rand(-1.0f, 1.0f))), Math::rand(-1.0f, 1.0f));
+        sample[0] = Math::rand(-0.05f, 0.05f);
+        sample[1] = 0.1f;
+        sample[2] = Math::rand(-0.05f, 0.05f);
+        sample[3] = rotation.x;
+        sample[4] = rotation.y;
+        sample[5] = rotation.z;
+        sample[6] = rotation.w;
+        sample[7] = sample[8] = sample[9] = Math::rand(0.9f, 1.1f);
+    }
+    skeletons.scaledPalettes.Resize(maxCharacters * skeletons.numJoints);
+    skeletons.skinPalettes.Resize(maxCharacters * skeletons.numJoints);
+}
+
+//------------------------------------------------------------------------------
+/**
+    The evaluation as the character jobs did it before the joints were
+    batched, one affine matrix and parent multiplication per joint.
+*/
+static void
+EvaluateSerial(BenchSkeletons& skeletons, IndexT character, Math::mat4* tmpMatrices)
+{
+    const Util::FixedArray<Math::mat4>& bindPose = SkeletonGetBindPose(skeletons.skeleton);
+    const float* samples = &skeletons.samples[character * skeletons.numJoints * sampleWidth];
+    Math::mat4* scaledPalette = &skeletons.scaledPalettes[character * skeletons.numJoints];
+    Math::mat4* skinPalette = &skeletons.skinPalettes[character * skeletons.numJoints];
+
+    Math::vec3 translate, scale;
+    Math::quat rotate;
+    IndexT i;
+    for (i = 0; i < skeletons.numJoints; i++)
+    {
+        translate.load(samples);
+        rotate.load(samples + 3);
+        scale.load(samples + 7);
+        samples += sampleWidth;
+
+        Math::mat4& unscaledMatrix = tmpMatrices[i];
+        Math::mat4& scaledMatrix = scaledPalette[i];
+        scaledMatrix = Math::affine(scale, rotate, translate);
+        unscaledMatrix = Math::affine(Math::vec3(1), rotate, translate);
+        const IndexT parent = skeletons.jobJoints[i].parentJointIndex;
+        if (InvalidIndex != parent)
+        {
+            scaledMatrix = tmpMatrices[parent] * scaledMatrix;
+            unscaledMatrix = tmpMatrices[parent] * unscaledMatrix;
+        }
+    }
+    Math::MultiplyMatrices(skinPalette, scaledPalette, bindPose.Begin(), bindPose.Size());
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+EvaluateBatched(BenchSkeletons& skeletons, IndexT character, Math::mat4* tmpMatrices)
+{
+    SkeletonEvaluate(
+        skeletons.skeleton,
+        skeletons.jobJoints.Begin(),
+        &skeletons.samples[character * skeletons.numJoints * sampleWidth],
+        sampleWidth,
+        tmpMatrices,
+        &skeletons.scaledPalettes[character * skeletons.numJoints],
+        &skeletons.skinPalettes[character * skeletons.numJoints]);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+EvaluateJob(SizeT totalJobs, SizeT groupSize, IndexT groupIndex, SizeT invocationOffset, void* ctx)
+{
+    auto context = static_cast<BenchEvalContext*>(ctx);
+    Math::mat4* tmpMatrices = Jobs2::JobAlloc<Math::mat4>(context->skeletons->numJoints);
+    IndexT i;
+    for (i = 0; i < groupSize; i++)
+    {
+        const IndexT index = invocationOffset + i;
+        if (index >= totalJobs)
+            return;
+        EvaluateBatched(*context->skeletons, index, tmpMatrices);
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+template<class EVAL>
+static Time
+RunSingleThread(Timer& timer, BenchSkeletons& skeletons, SizeT numCharacters, EVAL eval)
+{
+    Util::FixedArray<Math::mat4> tmpMatrices(skeletons.numJoints);
+    const Time start = timer.GetTime();
+    IndexT round, i;
+    for (round = 0; round < numRounds; round++)
+    {
+        for (i = 0; i < numCharacters; i++)
+            eval(skeletons, i, tmpMatrices.Begin());
+    }
+    return timer.GetTime() - start;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static Time
+RunJobs(Timer& timer, BenchSkeletons& skeletons, SizeT numCharacters)
+{
+    const Time start = timer.GetTime();
+    IndexT round;
+    for (round = 0; round < numRounds; round++)
+    {
+        BenchEvalContext context;
+        context.skeletons = &skeletons;
+        Threading::AtomicCounter counter = 1;
+        Jobs2::JobDispatch(EvaluateJob, numCharacters, characterGroupSize, context, nullptr, &counter);
+        Threading::WaitForCounter(&counter);
+        Jobs2::JobNewFrame();
+    }
+    return timer.GetTime() - start;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+Report(const char* name, SizeT numCharacters, SizeT numJoints, Time time)
+{
+    n_printf("%s, %d skeletons: %.3f ms/frame, %.1f ns/joint\n", name, numCharacters, time / numRounds * 1e3, time / ((double)numRounds * numCharacters * numJoints) * 1e9);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Largest difference between the skin palettes of both evaluations.
+*/
+static float
+CompareSerial(BenchSkeletons& skeletons, SizeT numCharacters)
+{
+    Util::FixedArray<Math::mat4> tmpMatrices(skeletons.numJoints);
+    Util::FixedArray<Math::mat4> batched(skeletons.numJoints);
+    float maxError = 0.0f;
+    IndexT i, j, k;
+    for (i = 0; i < numCharacters; i++)
+    {
+        EvaluateBatched(skeletons, i, tmpMatrices.Begin());
+        Memory::Copy(&skeletons.skinPalettes[i * skeletons.numJoints], batched.Begin(), batched.ByteSize());
+        EvaluateSerial(skeletons, i, tmpMatrices.Begin());
+        for (j = 0; j < skeletons.numJoints; j++)
+        {
+            for (k = 0; k < 4; k++)
+                maxError = Math::max(maxError, Math::length(batched[j].r[k] - skeletons.skinPalettes[i * skeletons.numJoints + j].r[k]));
+        }
+    }
+    return maxError;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+SkeletonEvalBench::Run(Timer& timer)
+{
+    BenchSkeletons skeletons;
+    BuildSkeletons(skeletons);
+    n_printf("%d joints in %d batches of %d\n", skeletons.numJoints, SkeletonGetEvalOrder(skeletons.skeleton).Size() / SkeletonEvalBatchSize, SkeletonEvalBatchSize);
+
+    Jobs2::JobSystemInitInfo info;
+    info.name = "SkeletonEvalBench";
+    info.numThreads = System::NumCpuCores;
+    info.enableProfiling = false;
+    info.scratchMemorySize = 4_MB;
+    Jobs2::JobSystemInit(info);
+
+    timer.Start();
+    IndexT i;
+    for (i = 0; i < numCharacterCounts; i++)
+    {
+        const SizeT numCharacters = characterCounts[i];
+        Report("joint by joint, 1 thread", numCharacters, skeletons.numJoints, RunSingleThread(timer, skeletons, numCharacters, EvaluateSerial));
+        Report("batched joints, 1 thread", numCharacters, skeletons.numJoints, RunSingleThread(timer, skeletons, numCharacters, EvaluateBatched));
+        Report(Util::String::Sprintf("batched joints, %d job threads", info.numThreads).AsCharPtr(), numCharacters, skeletons.numJoints, RunJobs(timer, skeletons, numCharacters));
+    }
+    timer.Stop();
+    n_printf("max skin matrix difference: %g\n", CompareSerial(skeletons, characterCounts[0]));
+
+    Jobs2::JobSystemUninit();
+    DestroySkeleton(skeletons.skeleton);
+}
+
+} // namespace Benchmarking
@@ -0,0 +1,27 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Benchmarking::SkeletonEvalBench
+
+    Evaluates the skeletons of 100, 1000 and 10000 characters the way
+    the character jobs used to, one joint after the other, and in batches
+    of joints transposed into structure of arrays registers, on one thread
+    and over the job threads.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "benchmarkbase/benchmark.h"
+
+//------------------------------------------------------------------------------
+namespace Benchmarking
+{
+class SkeletonEvalBench : public Benchmark
+{
+    __DeclareClass(SkeletonEvalBench);
+public:
+    /// run the benchmark
+    virtual void Run(Timing::Timer& timer);
+};
+
+} // namespace Benchmarking
+//------------------------------------------------------------------------------
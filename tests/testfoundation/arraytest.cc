@@ -11,6 +11,19 @@ __ImplementClass(Test::ArrayTest, 'ARRT', Test::TestCase);
 
 using namespace Util;
 
+//------------------------------------------------------------------------------
+/**
+    Allocator policy which counts the live allocations of the test arrays.
+*/
+struct CountingAllocator
+{
+    static int numAllocs;
+    static void* Alloc(size_t bytes) { numAllocs++; return Memory::Alloc(Memory::ObjectArrayHeap, bytes); }
+    static void* Realloc(void* ptr, size_t oldBytes, size_t newBytes) { return Memory::Realloc(Memory::ObjectArrayHeap, ptr, newBytes); }
+    static void Free(void* ptr, size_t bytes) { numAllocs--; Memory::Free(Memory::ObjectArrayHeap, ptr); }
+};
+int CountingAllocator::numAllocs = 0;
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -134,6 +147,30 @@ ArrayTest::Run()
     VERIFY(array0.BinarySearchIndex(3) == 2);
     VERIFY(array0.BinarySearchIndex(4) == 3);
     VERIFY(array0.BinarySearchIndex(5) == -1);
+
+    // test growing with a custom allocator, the capacity must grow geometrically
+    // and trivially relocatable elements keep their content when reallocated
+    {
+        Array<int, 0, CountingAllocator> array3;
+        for (i = 0; i < 500000; i++)
+        {
+            array3.Append(i);
+        }
+        VERIFY(array3.Size() == 500000);
+        VERIFY(array3.Capacity() < 500000 * 2);
+        VERIFY(array3[0] == 0);
+        VERIFY(array3[499999] == 499999);
+        VERIFY(CountingAllocator::numAllocs == 1);
+
+        Array<String, 0, CountingAllocator> array4;
+        for (i = 0; i < 100; i++)
+        {
+            array4.Append(String::FromInt(i));
+        }
+        VERIFY(array4[99] == "99");
+        VERIFY(CountingAllocator::numAllocs == 2);
+    }
+    VERIFY(CountingAllocator::numAllocs == 0);
 }
 
 }; // namespace Test
\ No newline at end of file
@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+//  batchmathtest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "batchmathtest.h"
+#include "math/batch.h"
+
+namespace Test
+{
+__ImplementClass(Test::BatchMathTest, 'BMTT', Test::TestCase);
+
+using namespace Math;
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+BatchMathTest::Run()
+{
+    // not a multiple of the batch size, so the remainder path is covered too
+    const SizeT num = 13;
+    const float eps = 0.0001f;
+    const mat4 m = trs(vec3(1.0f, -2.0f, 3.0f), quatyawpitchroll(0.3f, -1.1f, 0.7f), vec3(2.0f, 1.0f, 0.5f));
+
+    point points[num];
+    point transformedPoints[num];
+    mat4 matrices[num];
+    mat4 transformedMatrices[num];
+    bbox boxes[num];
+    bbox transformedBoxes[num];
+    mat4 boxTransforms[num];
+    quat quats[num];
+    quat normalizedQuats[num];
+    IndexT i;
+    for (i = 0; i < num; i++)
+    {
+        const float f = (float)i;
+        points[i] = point(f, f * 0.5f - 3.0f, 10.0f - f);
+        matrices[i] = trs(vec3(f, 0.0f, -f), quatyawpitchroll(f * 0.1f, 0.2f, -f * 0.3f), vec3(1.0f + f * 0.1f));
+        boxes[i] = bbox(point(f, -f, f * 2.0f), vector(1.0f, 2.0f + f, 0.5f));
+        boxTransforms[i] = matrices[num - 1 - i];
+        quats[i] = quat(f - 6.0f, 1.0f, f * 0.25f, 2.0f);
+    }
+
+    // points
+    TransformPoints(transformedPoints, points, num, m);
+    bool pointsEqual = true;
+    for (i = 0; i < num; i++)
+    {
+        pointsEqual &= nearequal(transformedPoints[i], point(m * points[i]), eps);
+    }
+    VERIFY(pointsEqual);
+
+    // in place
+    TransformPoints(points, points, num, m);
+    VERIFY(memcmp(points, transformedPoints, sizeof(points)) == 0);
+
+    // matrices
+    TransformMatrices(transformedMatrices, matrices, num, m);
+    bool matricesEqual = true;
+    for (i = 0; i < num; i++)
+    {
+        const mat4 ref = m * matrices[i];
+        IndexT row;
+        for (row = 0; row < 4; row++)
+            matricesEqual &= nearequal(transformedMatrices[i].r[row], ref.r[row], eps);
+    }
+    VERIFY(matricesEqual);
+
+    // boxes by a single matrix and by one matrix each
+    TransformBoxes(transformedBoxes, boxes, num, m);
+    bool boxesEqual = true;
+    for (i = 0; i < num; i++)
+    {
+        bbox ref = boxes[i];
+        ref.affine_transform(m);
+        boxesEqual &= nearequal(transformedBoxes[i].pmin, ref.pmin, eps) && nearequal(transformedBoxes[i].pmax, ref.pmax, eps);
+    }
+    VERIFY(boxesEqual);
+
+    TransformBoxes(transformedBoxes, boxes, boxTransforms, num);
+    boxesEqual = true;
+    for (i = 0; i < num; i++)
+    {
+        bbox ref = boxes[i];
+        ref.affine_transform(boxTransforms[i]);
+        boxesEqual &= nearequal(transformedBoxes[i].pmin, ref.pmin, eps) && nearequal(transformedBoxes[i].pmax, ref.pmax, eps);
+    }
+    VERIFY(boxesEqual);
+
+    // quaternions
+    NormalizeQuats(normalizedQuats, quats, num);
+    bool quatsEqual = true;
+    for (i = 0; i < num; i++)
+    {
+        const quat ref = normalize(quats[i]);
+        quatsEqual &= nearequal(vec4(normalizedQuats[i].vec), vec4(ref.vec), eps);
+    }
+    VERIFY(quatsEqual);
+
+    // interpolation, against the reversed quaternions so some pairs take the sign flip
+    quat targetQuats[num];
+    quat interpolatedQuats[num];
+    scalar weights[num];
+    for (i = 0; i < num; i++)
+    {
+        targetQuats[i] = normalizedQuats[num - 1 - i];
+        weights[i] = (scalar)i / (num - 1);
+    }
+    SlerpQuats(interpolatedQuats, normalizedQuats, targetQuats, weights, num);
+    quatsEqual = true;
+    for (i = 0; i < num; i++)
+    {
+        const quat ref = slerp(normalizedQuats[i], targetQuats[i], weights[i]);
+        quatsEqual &= nearequal(vec4(interpolatedQuats[i].vec), vec4(ref.vec), eps);
+    }
+    VERIFY(quatsEqual);
+    VERIFY(nearequal(vec4(interpolatedQuats[0].vec), vec4(normalizedQuats[0].vec), eps));
+    VERIFY(fabs(dot(interpolatedQuats[num - 1], targetQuats[num - 1])) > 1.0f - eps);
+
+    NlerpQuats(interpolatedQuats, normalizedQuats, targetQuats, weights, num);
+    quatsEqual = true;
+    for (i = 0; i < num; i++)
+    {
+        const quat ref = nlerp(normalizedQuats[i], targetQuats[i], weights[i]);
+        quatsEqual &= nearequal(vec4(interpolatedQuats[i].vec), vec4(ref.vec), eps);
+    }
+    VERIFY(quatsEqual);
+}
+
+} // namespace Test
@@ -0,0 +1,27 @@
+#ifndef TEST_BATCHMATHTEST_H
+#define TEST_BATCHMATHTEST_H
+//------------------------------------------------------------------------------
+/**
+    @class Test::BatchMathTest
+
+    Test the batched math stream functions against their single element
+    counterparts.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "testbase/testcase.h"
+
+//------------------------------------------------------------------------------
+namespace Test
+{
+class BatchMathTest : public TestCase
+{
+    __DeclareClass(BatchMathTest);
+public:
+    /// run the test
+    virtual void Run();
+};
+
+} // namespace Test
+//------------------------------------------------------------------------------
+#endif
@@ -139,6 +139,65 @@ BinaryReaderWriterTest::Run()
     VERIFY(reader->ReadBlob() == testBlob);
     reader->Close();
     stream->Close();
+
+    // write bulk data, padded such that the floats are aligned
+    int ints[5] = { 1, -2, 3, -4, 5 };
+    float floats[4] = { 0.5f, 1.5f, 2.5f, 3.5f };
+    stream->SetAccessMode(Stream::WriteAccess);
+    VERIFY(stream->Open());
+    writer->SetStream(stream.upcast<Stream>());
+    writer->SetMemoryMappingEnabled(false);
+    VERIFY(writer->Open());
+    writer->WriteRawData(ints, sizeof(ints));
+    writer->WriteUChar(7);
+    writer->WriteUChar(0);
+    writer->WriteUChar(0);
+    writer->WriteUChar(0);
+    writer->WriteRawData(floats, sizeof(floats));
+    writer->WriteInt(42);
+    writer->Close();
+    stream->Close();
+
+    // read the bulk data back in place from the mapped stream
+    stream->SetAccessMode(Stream::ReadAccess);
+    VERIFY(stream->Open());
+    reader->SetStream(stream.upcast<Stream>());
+    reader->SetMemoryMappingEnabled(true);
+    VERIFY(reader->Open());
+    Array<int> intArray = reader->ReadArray<int>(5);
+    VERIFY(intArray.Size() == 5);
+    VERIFY(intArray[1] == -2 && intArray[4] == 5);
+    VERIFY(reader->ReadUChar() == 7);
+    reader->Align(sizeof(float));
+    VERIFY(reader->CanView<float>(4));
+    const float* floatView = reader->View<float>(4);
+    VERIFY(floatView[0] == 0.5f && floatView[3] == 3.5f);
+    VERIFY(reader->ReadInt() == 42);
+    VERIFY(reader->Eof());
+    reader->Close();
+    stream->Close();
+
+    // and through the read-ahead buffer, with a buffer smaller than the data
+    stream->SetAccessMode(Stream::ReadAccess);
+    VERIFY(stream->Open());
+    reader->SetStream(stream.upcast<Stream>());
+    reader->SetMemoryMappingEnabled(false);
+    reader->SetReadAheadBufferSize(8);
+    VERIFY(reader->Open());
+    VERIFY(reader->ReadInt() == 1);
+    int tail[4];
+    reader->ReadArray(tail, 4);
+    VERIFY(tail[0] == -2 && tail[3] == 5);
+    VERIFY(reader->ReadUChar() == 7);
+    reader->Align(sizeof(float));
+    Array<float> floatStorage;
+    const float* floatSpan = reader->ReadSpan<float>(4, floatStorage);
+    VERIFY(floatStorage.Size() == 4);
+    VERIFY(floatSpan[0] == 0.5f && floatSpan[3] == 3.5f);
+    VERIFY(reader->ReadInt() == 42);
+    VERIFY(reader->Eof());
+    reader->Close();
+    stream->Close();
 }
 
 } // namespace Test
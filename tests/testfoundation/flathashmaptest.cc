@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+//  flathashmaptest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "flathashmaptest.h"
+#include "util/flathashmap.h"
+#include "util/flathashset.h"
+#include "util/dictionary.h"
+
+namespace Test
+{
+__ImplementClass(Test::FlatHashMapTest, 'FHMT', Test::TestCase);
+
+using namespace Util;
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+FlatHashMapTest::Run()
+{
+    Array<String> titles;
+    titles.Append("Nausicaa of the Valley of Wind");
+    titles.Append("Laputa: The Castle in the Sky");
+    titles.Append("My Neighbor Totoro");
+    titles.Append("Kiki's Delivery Service");
+    titles.Append("Porco Rosso");
+    titles.Append("Princess Mononoke");
+
+    FlatHashMap<String, IndexT> table;
+    VERIFY(table.Size() == 0);
+    VERIFY(table.IsEmpty());
+    VERIFY(table.Capacity() == 0);
+    VERIFY(!table.Contains("Ein schoener Tag"));
+
+    // populate the map
+    IndexT i;
+    SizeT num = titles.Size();
+    for (i = 0; i < num; i++)
+    {
+        table.Add(titles[i], i);
+    }
+    VERIFY(!table.IsEmpty());
+    VERIFY(table.Size() == titles.Size());
+    for (i = 0; i < num; i++)
+    {
+        VERIFY(table.Contains(titles[i]));
+        VERIFY(table[titles[i]] == i);
+    }
+
+    // lookup by raw string, without constructing a String
+    VERIFY(table["Porco Rosso"] == 4);
+    VERIFY(table.Contains("My Neighbor Totoro"));
+    VERIFY(!table.Contains("My Neighbor"));
+
+    // check copy constructor
+    FlatHashMap<String, IndexT> copy = table;
+    for (i = 0; i < num; i++)
+    {
+        VERIFY(copy.Contains(titles[i]));
+        VERIFY(copy[titles[i]] == i);
+    }
+
+    // check erasing
+    table.Erase(titles[1]);
+    VERIFY(table.Size() == (titles.Size() - 1));
+    VERIFY(table.Contains(titles[0]));
+    VERIFY(table.Contains(titles[2]));
+    VERIFY(table.Contains(titles[3]));
+    VERIFY(table.Contains(titles[4]));
+    VERIFY(table.Contains(titles[5]));
+    VERIFY(!table.Contains(titles[1]));
+    VERIFY(copy.Contains(titles[1]));
+
+    // emplace only adds missing keys
+    table.Emplace(titles[1]) = 10;
+    table.Emplace(titles[1]) += 1;
+    VERIFY(table[titles[1]] == 11);
+
+    // iterating visits every element once
+    SizeT visited = 0;
+    IndexT sum = 0;
+    for (const KeyValuePair<String, IndexT>& kvp : table)
+    {
+        VERIFY(table.Contains(kvp.Key()));
+        sum += kvp.Value();
+        visited++;
+    }
+    VERIFY(visited == table.Size());
+    VERIFY(sum == 0 + 11 + 2 + 3 + 4 + 5);
+
+    // check clearing
+    table.Clear();
+    VERIFY(table.Size() == 0);
+    VERIFY(table.IsEmpty());
+    VERIFY(table.begin() == table.end());
+
+    // grow well beyond one group, with erasing in between to create tombstones,
+    // and compare against a dictionary
+    FlatHashMap<int, int> intTable;
+    Dictionary<int, int> reference;
+    bool consistent = true;
+    for (i = 0; i < 20000; i++)
+    {
+        int key = (i * 7919) % 3001;
+        if ((i % 3) == 2)
+        {
+            IndexT index = intTable.FindIndex(key);
+            consistent &= ((index != InvalidIndex) == reference.Contains(key));
+            if (index != InvalidIndex)
+            {
+                intTable.EraseIndex(index);
+                reference.Erase(key);
+            }
+        }
+        else
+        {
+            intTable.Emplace(key) = i;
+            if (reference.Contains(key)) reference[key] = i;
+            else                         reference.Add(key, i);
+        }
+    }
+    VERIFY(consistent);
+    VERIFY(intTable.Size() == reference.Size());
+    for (i = 0; i < reference.Size(); i++)
+    {
+        consistent &= (intTable[reference.KeyAtIndex(i)] == reference.ValueAtIndex(i));
+    }
+    VERIFY(consistent);
+
+    // reserving up front never grows
+    FlatHashMap<int, int> reserved;
+    reserved.Reserve(1000);
+    SizeT capacity = reserved.Capacity();
+    for (i = 0; i < 1000; i++)
+    {
+        reserved.Add(i, i);
+    }
+    VERIFY(reserved.Capacity() == capacity);
+
+    // pointer keys compare by address
+    const char* a = "a";
+    const char* b = "b";
+    FlatHashSet<const char*> set;
+    VERIFY(set.Add(a));
+    VERIFY(set.Add(b));
+    VERIFY(!set.Add(a));
+    VERIFY(set.Size() == 2);
+    VERIFY(set.Contains(a));
+    set.Erase(a);
+    VERIFY(!set.Contains(a));
+    VERIFY(set.Contains(b));
+}
+
+} // namespace Test
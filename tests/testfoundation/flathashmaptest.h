@@ -0,0 +1,26 @@
+#ifndef TEST_FLATHASHMAPTEST_H
+#define TEST_FLATHASHMAPTEST_H
+//------------------------------------------------------------------------------
+/**
+    @class Test::FlatHashMapTest
+
+    Test FlatHashMap and FlatHashSet functionality.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "testbase/testcase.h"
+
+//------------------------------------------------------------------------------
+namespace Test
+{
+class FlatHashMapTest : public TestCase
+{
+    __DeclareClass(FlatHashMapTest);
+public:
+    /// run the test
+    virtual void Run();
+};
+
+} // namespace Test
+//------------------------------------------------------------------------------
+#endif
@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+//  httpservertest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "httpservertest.h"
+#include "http/httpserver.h"
+#include "http/httprequestreader.h"
+#include "net/tcpclient.h"
+#include "io/memorystream.h"
+#include "timing/time.h"
+
+namespace Test
+{
+__ImplementClass(Test::HttpServerTest, 'HSVT', Test::TestCase);
+
+using namespace Util;
+using namespace IO;
+using namespace Net;
+using namespace Http;
+
+//------------------------------------------------------------------------------
+/**
+*/
+static void
+AppendToStream(const Ptr<Stream>& stream, const char* str)
+{
+    stream->SetAccessMode(Stream::AppendAccess);
+    if (stream->Open())
+    {
+        stream->Write(str, (Stream::Size)strlen(str));
+        stream->Close();
+    }
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+HttpServerTest::Run()
+{
+    // a request whose content hasn't fully arrived is put back, header names are case-insensitive
+    {
+        Ptr<MemoryStream> stream = MemoryStream::Create();
+        AppendToStream(stream.upcast<Stream>(), "POST /test HTTP/1.1\r\nHOST: localhost\r\nconnection: Close\r\nContent-length: 4\r\n\r\nab");
+
+        Ptr<HttpRequestReader> reader = HttpRequestReader::Create();
+        reader->SetStream(stream.upcast<Stream>());
+        stream->SetAccessMode(Stream::ReadAccess);
+        VERIFY(stream->Open());
+        VERIFY(reader->Open());
+        VERIFY(!reader->ReadRequest());
+        VERIFY(!reader->IsValidHttpRequest());
+        VERIFY(reader->IsIncomplete());
+        VERIFY(stream->GetPosition() == 0);
+        reader->Close();
+        stream->Close();
+
+        AppendToStream(stream.upcast<Stream>(), "cd");
+        stream->SetAccessMode(Stream::ReadAccess);
+        VERIFY(stream->Open());
+        VERIFY(reader->Open());
+        VERIFY(reader->ReadRequest());
+        VERIFY(reader->IsValidHttpRequest());
+        VERIFY(!reader->IsIncomplete());
+        VERIFY(!reader->IsKeepAlive());
+        VERIFY(reader->GetRequestURI().Host() == "localhost");
+        VERIFY(stream->Eof());
+        reader->Close();
+        stream->Close();
+    }
+
+    // a header which ends in the middle of a line is incomplete as well, not malformed
+    {
+        Ptr<MemoryStream> stream = MemoryStream::Create();
+        AppendToStream(stream.upcast<Stream>(), "GET / HTTP/1.1\r\nHo");
+
+        Ptr<HttpRequestReader> reader = HttpRequestReader::Create();
+        reader->SetStream(stream.upcast<Stream>());
+        VERIFY(reader->Open());
+        VERIFY(!reader->ReadRequest());
+        VERIFY(reader->IsIncomplete());
+        reader->Close();
+    }
+
+    // the server keeps a request split across two Recv() calls and answers it once it's complete
+    {
+        Ptr<HttpServer> httpServer = HttpServer::Create();
+        httpServer->SetPort(2102);
+        VERIFY(httpServer->Open());
+
+        Ptr<TcpClient> client = TcpClient::Create();
+        client->SetBlocking(true);
+        client->SetServerAddress(IpAddress("localhost", 2102));
+        VERIFY(TcpClient::Success == client->Connect());
+
+        IndexT frame;
+        AppendToStream(client->GetSendStream(), "GET / HTTP/1.1\r\nHost: local");
+        VERIFY(client->Send());
+        for (frame = 0; frame < 10; frame++)
+        {
+            httpServer->OnFrame();
+            Timing::Sleep(0.01);
+        }
+
+        AppendToStream(client->GetSendStream(), "host\r\nConnection: close\r\n\r\n");
+        VERIFY(client->Send());
+        for (frame = 0; frame < 10; frame++)
+        {
+            httpServer->OnFrame();
+            Timing::Sleep(0.01);
+        }
+
+        // the server closes the connection once the response is sent
+        String response;
+        while (client->Recv())
+        {
+            const Ptr<Stream>& recvStream = client->GetRecvStream();
+            recvStream->SetAccessMode(Stream::ReadAccess);
+            if (recvStream->Open())
+            {
+                String part;
+                part.Set((const char*)recvStream->Map(), (SizeT)recvStream->GetSize());
+                recvStream->Unmap();
+                recvStream->Close();
+                response.Append(part);
+            }
+        }
+        VERIFY(String::MatchPattern(response, "HTTP/1.1 200*"));
+
+        client->Disconnect();
+        httpServer->Close();
+    }
+}
+
+} // namespace Test
@@ -0,0 +1,25 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    @class Test::HttpServerTest
+    
+    Test Http::HttpServer and Http::HttpRequestReader with requests which
+    arrive in several pieces.
+    
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "testbase/testcase.h"
+
+//------------------------------------------------------------------------------
+namespace Test
+{
+class HttpServerTest : public TestCase
+{
+    __DeclareClass(HttpServerTest);
+public:
+    /// run the test
+    virtual void Run();
+};
+
+} // namespace Test
+//------------------------------------------------------------------------------
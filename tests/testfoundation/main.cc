@@ -9,6 +9,7 @@
 #include "io/gamecontentserver.h"
 #include "testbase/testrunner.h"
 #include "stringtest.h"
+#include "stringatomtest.h"
 #include "arraytest.h"
 #include "arrayallocatortest.h"
 #include "stacktest.h"
@@ -17,6 +18,7 @@
 #include "fixedarraytest.h"
 #include "fixedtabletest.h"
 #include "hashtabletest.h"
+#include "flathashmaptest.h"
 #include "queuetest.h"
 #include "arrayqueuetest.h"
 #include "memorystreamtest.h"
@@ -41,6 +43,7 @@
 #include "zipfstest.h"
 #include "float4test.h"
 #include "matrix44test.h"
+#include "batchmathtest.h"
 #include "threadtest.h"
 #include "memorypooltest.h"
 #include "runlengthcodectest.h"
@@ -50,6 +53,7 @@
 #include "delegatetest.h"
 #include "delegatetabletest.h"
 #include "httpclienttest.h"
+#include "httpservertest.h"
 #include "bxmlreadertest.h"
 #include "blobtest.h"
 #include "profilingtest.h"
@@ -81,6 +85,7 @@ __cdecl main()
     //testRunner->AttachTestCase(BXmlReaderTest::Create());
     testRunner->AttachTestCase(CVarTest::Create());    
     testRunner->AttachTestCase(HttpClientTest::Create());    
+    testRunner->AttachTestCase(HttpServerTest::Create());
     testRunner->AttachTestCase(DelegateTableTest::Create());
     testRunner->AttachTestCase(DelegateTest::Create());
     testRunner->AttachTestCase(BlobTest::Create());
@@ -93,6 +98,7 @@ __cdecl main()
     testRunner->AttachTestCase(MemoryPoolTest::Create());
     testRunner->AttachTestCase(Matrix44Test::Create());
     testRunner->AttachTestCase(Float4Test::Create());
+    testRunner->AttachTestCase(BatchMathTest::Create());
     testRunner->AttachTestCase(ZipFSTest::Create());
     //testRunner->AttachTestCase(FileWatcherTest::Create());
     testRunner->AttachTestCase(LuaServerTest::Create());
@@ -101,6 +107,7 @@ __cdecl main()
     testRunner->AttachTestCase(MediaTypeTest::Create());
     testRunner->AttachTestCase(URITest::Create());
     testRunner->AttachTestCase(StringTest::Create());   
+    testRunner->AttachTestCase(StringAtomTest::Create());
     testRunner->AttachTestCase(ArrayTest::Create());
     testRunner->AttachTestCase(PinnedArrayTest::Create());
     testRunner->AttachTestCase(StackArrayTest::Create());
@@ -110,6 +117,7 @@ __cdecl main()
     testRunner->AttachTestCase(FixedArrayTest::Create());
     testRunner->AttachTestCase(FixedTableTest::Create());
     testRunner->AttachTestCase(HashTableTest::Create());
+    testRunner->AttachTestCase(FlatHashMapTest::Create());
     testRunner->AttachTestCase(QueueTest::Create());
     testRunner->AttachTestCase(ArrayQueueTest::Create());
     testRunner->AttachTestCase(MemoryStreamTest::Create());
@@ -126,6 +126,13 @@ ProfilingTest::Run()
             RecursivePrintScopes(ctx.topLevelScopes[j], 0);
         }
     }
+
+    // per-frame counters are replaced, not accumulated
+    ProfilingSetCounter("ProfilingTestCounter", 10);
+    ProfilingSetCounter("ProfilingTestCounter", 3);
+    VERIFY(ProfilingGetCounters()["ProfilingTestCounter"] == 3);
+    ProfilingIncreaseCounter("ProfilingTestCounter", 2);
+    VERIFY(ProfilingGetCounters()["ProfilingTestCounter"] == 5);
 }
 
 }; // namespace Test
@@ -0,0 +1,101 @@
+//------------------------------------------------------------------------------
+//  stringatomtest.cc
+//  (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "stringatomtest.h"
+#include "util/stringatom.h"
+#include "util/fixedarray.h"
+#include "threading/thread.h"
+
+namespace Test
+{
+__ImplementClass(Test::StringAtomTest, 'SATT', Test::TestCase);
+
+using namespace Util;
+using namespace Threading;
+
+// enough strings to make every shard of the global table grow a few times
+static const SizeT NumAtoms = 8000;
+
+class AtomThread : public Thread
+{
+    __DeclareClass(AtomThread);
+public:
+    /// create all atoms, in a different order per thread
+    void DoWork()
+    {
+        this->atoms.Resize(NumAtoms);
+        IndexT i;
+        for (i = 0; i < NumAtoms; i++)
+        {
+            IndexT index = (i * this->stride) % NumAtoms;
+            String str;
+            str.Format("stringatomtest_%d", index);
+            this->atoms[index] = str.AsCharPtr();
+        }
+    }
+
+    FixedArray<StringAtom> atoms;
+    IndexT stride = 1;
+};
+__ImplementClass(Test::AtomThread, 'SATH', Threading::Thread);
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+StringAtomTest::Run()
+{
+    // atoms of equal strings share the same pointer
+    StringAtom atom0("Hello World");
+    StringAtom atom1(String("Hello World"));
+    StringAtom atom2("Hello Nebula");
+    VERIFY(atom0 == atom1);
+    VERIFY(atom0.Value() == atom1.Value());
+    VERIFY(atom0 != atom2);
+    VERIFY(atom0 == "Hello World");
+    VERIFY(atom2.AsString() == "Hello Nebula");
+
+    // create the same strings concurrently, every thread must end up with the same pointers
+    const SizeT numThreads = 4;
+    const IndexT strides[numThreads] = { 1, 7, 13, 7919 };
+    Array<Ptr<AtomThread>> threads;
+    IndexT i;
+    for (i = 0; i < numThreads; i++)
+    {
+        Ptr<AtomThread> thread = AtomThread::Create();
+        thread->stride = strides[i];
+        String name;
+        name.Format("StringAtomTest%d", i);
+        thread->SetName(name);
+        thread->Start();
+        threads.Append(thread);
+    }
+    for (i = 0; i < numThreads; i++)
+    {
+        while (threads[i]->IsRunning())
+        {
+            n_sleep(0.01);
+        }
+    }
+
+    bool samePointers = true;
+    bool sameContent = true;
+    for (i = 0; i < NumAtoms; i++)
+    {
+        String str;
+        str.Format("stringatomtest_%d", i);
+        StringAtom atom(str);
+        sameContent &= (atom == str.AsCharPtr());
+        IndexT j;
+        for (j = 0; j < numThreads; j++)
+        {
+            samePointers &= (threads[j]->atoms[i].Value() == atom.Value());
+        }
+    }
+    VERIFY(sameContent);
+    VERIFY(samePointers);
+}
+
+} // namespace Test
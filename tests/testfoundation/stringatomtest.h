@@ -0,0 +1,26 @@
+#ifndef TEST_STRINGATOMTEST_H
+#define TEST_STRINGATOMTEST_H
+//------------------------------------------------------------------------------
+/**
+    @class Test::StringAtomTest
+
+    Test StringAtom interning, also from several threads at once.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+#include "testbase/testcase.h"
+
+//------------------------------------------------------------------------------
+namespace Test
+{
+class StringAtomTest : public TestCase
+{
+    __DeclareClass(StringAtomTest);
+public:
+    /// run the test
+    virtual void Run();
+};
+
+} // namespace Test
+//------------------------------------------------------------------------------
+#endif
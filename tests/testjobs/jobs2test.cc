@@ -94,6 +94,61 @@ Jobs2Test::Run()
 
     delete[] ctx.inout;
     delete[] ctx.input2;
+    JobSystemUninit();
+
+    // Run again with fibers, where jobs dispatch more jobs and wait for them
+    portInfo.enableFibers = true;
+    JobSystemInit(portInfo);
+
+    struct NestedContext
+    {
+        int* sums;
+        SizeT numInner;
+    } nestedCtx;
+    const SizeT NumOuter = 64;
+    nestedCtx.sums = new int[NumOuter];
+    nestedCtx.numInner = 1000;
+
+    auto outer = [](SizeT totalJobs, SizeT groupSize, IndexT invocationIndex, SizeT invocationOffset, void* ctx)
+    {
+        // The scope stays open across the wait, and is continued on whichever thread resumes the job
+        N_SCOPE(NestedOuterJob, Test);
+        NestedContext* context = static_cast<NestedContext*>(ctx);
+        int* values = JobAlloc<int>(context->numInner);
+        auto inner = [](SizeT totalJobs, SizeT groupSize, IndexT invocationIndex, SizeT invocationOffset, void* ctx)
+        {
+            int* values = *static_cast<int**>(ctx);
+            for (IndexT i = 0; i < groupSize; i++)
+            {
+                IndexT index = i + invocationOffset;
+                if (index >= totalJobs)
+                    break;
+                values[index] = index;
+            }
+        };
+
+        // The counter lives on the fiber stack, which stays put while we wait
+        Threading::AtomicCounter innerCounter = 1;
+        JobDispatch(inner, context->numInner, 100, values, nullptr, &innerCounter);
+        JobYieldUntil(&innerCounter);
+
+        int sum = 0;
+        for (IndexT i = 0; i < context->numInner; i++)
+            sum += values[i];
+        context->sums[invocationIndex] = sum;
+    };
+
+    Threading::AtomicCounter nestedCounter = 1;
+    JobDispatch(outer, NumOuter, 1, nestedCtx, nullptr, &nestedCounter);
+    JobYieldUntil(&nestedCounter);
+
+    result = true;
+    for (IndexT i = 0; i < NumOuter; i++)
+        result &= nestedCtx.sums[i] == (999 * 1000) / 2;
+    VERIFY(result);
+
+    delete[] nestedCtx.sums;
+    JobSystemUninit();
 }
 
 } // namespace Test
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "coreanimation/animcurve.h"
 #include "timing/time.h"
 #include "coreanimation/animation.h"
+#include "coreanimation/animkeycompression.h"
 #include "animtest.h"
 namespace Test
 {
@@ -37,6 +38,8 @@ AnimTest::Run()
 
     const SizeT numKeys = sizeof(keyBuffer) / sizeof(keyBuffer[0]);
     const SizeT numIntervals = sizeof(intervalBuffer) / sizeof(intervalBuffer[0]);
+    for (AnimKeyBuffer::Interval& interval : intervalBuffer)
+        interval.duration = 1.0f / (interval.end - interval.start);
     buffer->Setup(numIntervals, numKeys, intervalBuffer, keyBuffer);
     Util::FixedArray<uint> sampleIndices(3, 0x0);
 
@@ -107,7 +110,7 @@ AnimTest::Run()
     // Run anim sample with one active (pos) and two dead (scale rotation) curves
     float value[10];
     uchar count[3] = { 0, 0, 0 };
-    AnimSampleStep(clip, curves, 0, Math::vec4{ 1 }, idleSamples, keySampleBuffer, keyIntervalBuffer, sampleIndexBuffer, value, count);
+    AnimSampleStep(clip, curves, 0, Math::vec4{ 1 }, idleSamples, keySampleBuffer, nullptr, keyIntervalBuffer, sampleIndexBuffer, value, count);
     VERIFY(value[0] == 0.0f);
     VERIFY(value[1] == 1.0f);
     VERIFY(value[2] == 2.0f);
@@ -123,7 +126,7 @@ AnimTest::Run()
     // 1.5 - lerp(0.0f, 1.0f, 0.5f);
     // 2.5f - lerp(1.0f, 2.0f, 1.5f);
     // 3.5f - lerp(2.0f, 3.0f, 2.5f);
-    AnimSampleLinear(clip, curves, 12, Math::vec4{ 1 }, idleSamples, keySampleBuffer, keyIntervalBuffer, sampleIndexBuffer, value, count);
+    AnimSampleLinear(clip, curves, 12, Math::vec4{ 1 }, idleSamples, keySampleBuffer, nullptr, keyIntervalBuffer, sampleIndexBuffer, value, count);
     VERIFY(value[0] == 0.5f);
     VERIFY(value[1] == 1.5f);
     VERIFY(value[2] == 2.5f);
@@ -134,6 +137,48 @@ AnimTest::Run()
     VERIFY(value[7] == 0.0f);
     VERIFY(value[8] == 0.0f);
     VERIFY(value[9] == 1.0f);
+
+    // A rotation survives packing with the smallest three encoding, up to sign
+    Math::quat rotation = Math::normalize(Math::quat(0.1f, -0.7f, 0.3f, -0.5f));
+    ushort packedRotation[PackedKeyStride + PackedKeyPadding] = { 0 };
+    PackRotationKey(rotation, packedRotation);
+    Math::quat unpackedRotation = UnpackRotationKey(packedRotation);
+    VERIFY(Math::abs(Math::abs(Math::dot(rotation, unpackedRotation)) - 1.0f) < 0.0001f);
+
+    // Quantized translation keys, (0, 1, 2), (1, 2, 3), (2, 3, 4), (3, 4, 5)
+    AnimCurve packedPos = posCurve;
+    packedPos.keyFormat = KeyFormat::Quantized;
+    packedPos.keyOffset = Math::vec4(0, 1, 2, 0);
+    packedPos.keyScale = Math::vec4(3.0f / 65535.0f, 3.0f / 65535.0f, 3.0f / 65535.0f, 0);
+    ushort packedKeys[4 * PackedKeyStride + PackedKeyPadding] = { 0 };
+    IndexT i;
+    for (i = 0; i < 4; i++)
+    {
+        const float key[] = { float(i), float(i + 1), float(i + 2) };
+        PackVectorKey(key, packedPos.keyOffset, packedPos.keyScale, &packedKeys[i * PackedKeyStride]);
+    }
+    AnimKeyBuffer::Interval packedIntervals[] = {
+        { 0, 24, 0, 3 }, { 24, 48, 3, 6 }, { 48, 72, 6, 9 }
+    };
+    packedIntervals[0].duration = packedIntervals[1].duration = packedIntervals[2].duration = 1.0f / 24.0f;
+
+    // A constant scale curve has no intervals, but is active
+    AnimCurve constantScale = nullScale;
+    constantScale.keyFormat = KeyFormat::Constant;
+    constantScale.keyOffset = Math::vec4(2, 2, 2, 0);
+
+    Util::FixedArray<AnimCurve> packedCurves = { packedPos, constantScale, nullRotation };
+    sampleIndices.Fill(0);
+    AnimSampleLinear(clip, packedCurves, 36, Math::vec4{ 1 }, idleSamples, nullptr, packedKeys, packedIntervals, sampleIndexBuffer, value, count);
+    VERIFY(Math::abs(value[0] - 1.5f) < 0.0001f);
+    VERIFY(Math::abs(value[1] - 2.5f) < 0.0001f);
+    VERIFY(Math::abs(value[2] - 3.5f) < 0.0001f);
+    VERIFY(value[3] == 2.0f);
+    VERIFY(value[4] == 2.0f);
+    VERIFY(value[5] == 2.0f);
+    VERIFY(count[0] == 1);
+    VERIFY(count[1] == 1);
+    VERIFY(count[2] == 0);
 }
 
 } // namespace Test
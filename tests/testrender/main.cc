@@ -8,6 +8,7 @@
 #include "testbase/testrunner.h"
 #include "animtest.h"
 #include "rendertest.h"
+#include "streamingtest.h"
 
 using namespace Core;
 using namespace Test;
@@ -29,6 +30,7 @@ NebulaMain(const Util::CommandLineArgs& args)
     Ptr<TestRunner> testRunner = TestRunner::Create();
     testRunner->AttachTestCase(AnimTest::Create());
     testRunner->AttachTestCase(RenderTest::Create());
+    testRunner->AttachTestCase(StreamingTest::Create());
     testRunner->Run();
     //testRunner->AttachTestCase(BXmlReaderTest::Create());
 
@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------------
+//  @file streamingtest.cc
+//  @copyright (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "foundation/stdneb.h"
+#include "io/ioserver.h"
+#include "util/bit.h"
+#include "resources/resourceloader.h"
+#include "resources/resourcestreamscheduler.h"
+#include "streamingtest.h"
+
+using namespace Resources;
+namespace Test
+{
+
+//------------------------------------------------------------------------------
+/**
+    Loads resources synchronously, every resource has four lods of 1 MB each,
+    of which the first one is loaded when the resource is created
+*/
+class StreamingTestLoader : public ResourceLoader
+{
+    __DeclareClass(StreamingTestLoader);
+public:
+    /// constructor
+    StreamingTestLoader()
+    {
+        this->async = false;
+        this->uniqueId = 0;
+    }
+
+    /// run the per frame update, which loads what the scheduler issued
+    void Tick(IndexT frameIndex)
+    {
+        this->Update(frameIndex);
+    }
+    /// get the lods a resource has loaded
+    uint GetLoadedBits(const ResourceId id) const
+    {
+        return this->loadedBits[id.loaderInstanceId];
+    }
+
+private:
+    /// initialize resource
+    ResourceUnknownId InitializeResource(const Ids::Id32 entry, const Util::StringAtom& tag, const Ptr<IO::Stream>& stream, bool immediate) override
+    {
+        return ResourceUnknownId(entry, 0);
+    }
+    /// all requested lods load at once
+    uint StreamResource(const ResourceId entry, uint requestedBits) override
+    {
+        return requestedBits;
+    }
+    /// nothing to unload
+    void Unload(const ResourceId id) override
+    {
+    }
+    /// lod 1 is the first lod, lod 0 all four
+    uint LodMask(const Ids::Id32 entry, float lod) const override
+    {
+        return (1 << (1 + (uint)((1.0f - lod) * 3.0f + 0.5f))) - 1;
+    }
+    /// every lod is 1 MB
+    uint64 LodBytes(const Ids::Id32 entry, uint bits) const override
+    {
+        return Util::CountBits(bits) * 1_MB;
+    }
+    /// drop the lods which aren't kept
+    uint EvictLod(const ResourceId& id, uint loadedBits, uint keepBits) override
+    {
+        return loadedBits & keepBits;
+    }
+};
+
+__ImplementClass(Test::StreamingTestLoader, 'STLO', Resources::ResourceLoader);
+__ImplementClass(Test::StreamingTest, 'STTE', Core::RefCounted);
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+StreamingTest::Run()
+{
+    Ptr<IO::IoServer> ioServer = IO::IoServer::Create();
+
+    Ptr<StreamingTestLoader> loader = StreamingTestLoader::Create();
+    loader->Setup();
+    Util::Array<Ptr<ResourceLoader>> loaders;
+    loaders.Append(loader.upcast<ResourceLoader>());
+
+    // the loader opens the files, but the test loader doesn't read them
+    const SizeT NumResources = 4;
+    ResourceId ids[NumResources];
+    IndexT i;
+    for (i = 0; i < NumResources; i++)
+    {
+        Util::String name = Util::String::Sprintf("temp:streamingtest%d.bin", i);
+        Ptr<IO::Stream> stream = ioServer->CreateStream(name);
+        stream->SetAccessMode(IO::Stream::WriteAccess);
+        VERIFY(stream->Open());
+        stream->Write(name.AsCharPtr(), name.Length());
+        stream->Close();
+        ids[i] = loader->CreateResource(name, nullptr, 0, "streamingtest"_atm, nullptr, nullptr, false, true);
+    }
+
+    ResourceStreamScheduler scheduler;
+    ResourceStreamScheduler::Budget budget;
+    budget.maxBytesPerFrame = 0;
+    budget.maxBytesInFlight = 0;
+    budget.maxBytesResident = 8_MB;
+    budget.evictionGraceFrames = 0;
+    scheduler.SetBudget(budget);
+
+    loader->Tick(0);
+    scheduler.Update(0, loaders);
+    for (i = 0; i < NumResources; i++)
+        VERIFY(loader->GetLoadedBits(ids[i]) == 0x1);
+    VERIFY(scheduler.GetStats().bytesResident == 0);
+
+    // two resources fit, 3 MB on top of their first lod each
+    loader->SetMinLod(ids[0], 0.0f, false, 1.0f);
+    loader->Tick(1);
+    scheduler.Update(1, loaders);
+    VERIFY(scheduler.GetStats().requestsIssued == 1);
+    loader->SetMinLod(ids[1], 0.0f, false, 1.0f);
+    loader->Tick(2);
+    scheduler.Update(2, loaders);
+    VERIFY(scheduler.GetStats().requestsIssued == 1);
+    VERIFY(scheduler.GetStats().bytesResident + scheduler.GetStats().bytesInFlight == 6_MB);
+
+    // a third one goes past the resident budget, and the least recently requested one makes room
+    loader->SetMinLod(ids[2], 0.0f, false, 1.0f);
+    loader->Tick(3);
+    scheduler.Update(3, loaders);
+    VERIFY(scheduler.GetStats().requestsIssued == 1);
+    VERIFY(scheduler.GetStats().lodsEvicted == 1);
+    VERIFY(scheduler.GetStats().bytesEvicted == 3_MB);
+
+    loader->Tick(4);
+    VERIFY(loader->GetLoadedBits(ids[0]) == 0x1);
+    VERIFY(loader->GetLoadedBits(ids[1]) == 0xF);
+    VERIFY(loader->GetLoadedBits(ids[2]) == 0xF);
+
+    // resources requested this frame aren't evicted, so the last one has to wait
+    loader->SetMinLod(ids[1], 0.0f, false, 1.0f);
+    loader->SetMinLod(ids[2], 0.0f, false, 1.0f);
+    loader->SetMinLod(ids[3], 0.0f, false, 0.5f);
+    loader->Tick(5);
+    scheduler.Update(5, loaders);
+    VERIFY(scheduler.GetStats().bytesResident == 6_MB);
+    VERIFY(scheduler.GetStats().requestsIssued == 0);
+    VERIFY(scheduler.GetStats().requestsDeferred == 1);
+    VERIFY(scheduler.GetStats().lodsEvicted == 0);
+
+    // once the others haven't been asked for in a while, the deferred request gets its memory
+    loader->Tick(6);
+    scheduler.Update(6, loaders);
+    VERIFY(scheduler.GetStats().requestsIssued == 1);
+    VERIFY(scheduler.GetStats().lodsEvicted == 1);
+    loader->Tick(7);
+    VERIFY(loader->GetLoadedBits(ids[3]) == 0xF);
+    scheduler.Update(7, loaders);
+    VERIFY(scheduler.GetStats().bytesResident == 6_MB);
+    VERIFY(scheduler.GetStats().bytesResident <= budget.maxBytesResident);
+
+    for (i = 0; i < NumResources; i++)
+        ioServer->DeleteFile(Util::String::Sprintf("temp:streamingtest%d.bin", i));
+}
+
+} // namespace Test
@@ -0,0 +1,22 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Test for the LOD stream scheduler's budgets and eviction
+
+    @copyright
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+
+class StreamingTest : public TestCase
+{
+    __DeclareClass(StreamingTest);
+public:
+    /// run test
+    virtual void Run();
+};
+
+} // namespace Test
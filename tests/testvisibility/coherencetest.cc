@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// coherencetest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "coherencetest.h"
+#include "visibility/systems/bruteforcesystem.h"
+#include "math/simdkernels.h"
+
+using namespace Math;
+using namespace Visibility;
+
+namespace Test
+{
+__ImplementClass(Test::CoherenceTest, 'COTE', Test::TestCase);
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+CoherenceTest::Run()
+{
+    const mat4 view = inverse(lookatrh(point(0, 0, 10), point(0, 0, 0), vector(0, 1, 0)));
+    const mat4 viewProjection = perspfovrh(deg2rad(60.0f), 1.0f, 0.1f, 100.0f) * view;
+
+    // in front, behind the eye, on the edge of the screen and always visible behind the eye
+    bbox boxes[] =
+    {
+        bbox(point(0, 0, 0), vector(1)),
+        bbox(point(0, 0, 20), vector(1)),
+        bbox(point(5.77f, 0, 0), vector(1)),
+        bbox(point(0, 0, 30), vector(1)),
+    };
+    const SizeT numBoxes = sizeof(boxes) / sizeof(boxes[0]);
+
+    // the ids are in another order than the node instances, as they are in the visibility context
+    const uint32 ids[numBoxes] = { 3, 1, 0, 2 };
+    uint32_t flags[numBoxes] = { 0, 0, 0, (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible };
+    ClipStatus::Type cache[numBoxes] = { ClipStatus::Invalid, ClipStatus::Invalid, ClipStatus::Invalid, ClipStatus::Invalid };
+    uint64 dirtyBits = 0xF;
+
+    ClipStatus::Type expected[numBoxes];
+    ClipStatus::Type status[numBoxes];
+    IndexT i;
+    for (i = 0; i < numBoxes; i++)
+        expected[i] = ClipStatus::Outside;
+    ClipBoxes(expected, boxes, ids, numBoxes, viewProjection, false);
+    expected[0] = ClipStatus::Inside;
+    VERIFY(expected[1] == ClipStatus::Outside);
+    VERIFY(expected[2] == ClipStatus::Inside);
+    VERIFY(expected[3] == ClipStatus::Clipped);
+
+    // the first frame tests everything
+    SizeT numTested, numSkipped;
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Outside;
+    BruteforceClipBoxes(status, cache, boxes, ids, flags, &dirtyBits, false, numBoxes, viewProjection, false, numTested, numSkipped);
+    VERIFY(numTested == 3 && numSkipped == 0);
+    for (i = 0; i < numBoxes; i++)
+        VERIFY(status[i] == expected[i]);
+
+    // nothing moved, nothing is tested
+    dirtyBits = 0;
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Outside;
+    BruteforceClipBoxes(status, cache, boxes, ids, flags, &dirtyBits, true, numBoxes, viewProjection, false, numTested, numSkipped);
+    VERIFY(numTested == 0 && numSkipped == 3);
+    for (i = 0; i < numBoxes; i++)
+        VERIFY(status[i] == expected[i]);
+
+    // the box behind the eye moves in front of it
+    boxes[1] = bbox(point(0, 0, -5), vector(1));
+    dirtyBits = Util::SetBit(dirtyBits, 1);
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Outside;
+    BruteforceClipBoxes(status, cache, boxes, ids, flags, &dirtyBits, true, numBoxes, viewProjection, false, numTested, numSkipped);
+    VERIFY(numTested == 1 && numSkipped == 2);
+    VERIFY(status[1] == ClipStatus::Inside);
+    VERIFY(cache[1] == ClipStatus::Inside);
+
+    // a box another system already found and which moved has to be tested again the frame after
+    boxes[0] = bbox(point(0, 0, 40), vector(1));
+    dirtyBits = Util::SetBit((uint64)0, 0);
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Outside;
+    status[2] = ClipStatus::Inside;
+    BruteforceClipBoxes(status, cache, boxes, ids, flags, &dirtyBits, true, numBoxes, viewProjection, false, numTested, numSkipped);
+    VERIFY(numTested == 0 && numSkipped == 2);
+    VERIFY(cache[0] == ClipStatus::Invalid);
+
+    dirtyBits = 0;
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Outside;
+    BruteforceClipBoxes(status, cache, boxes, ids, flags, &dirtyBits, true, numBoxes, viewProjection, false, numTested, numSkipped);
+    VERIFY(numTested == 1 && numSkipped == 2);
+    VERIFY(status[2] == ClipStatus::Outside);
+
+    // an observer which moved tests everything
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Outside;
+    BruteforceClipBoxes(status, cache, boxes, ids, flags, &dirtyBits, false, numBoxes, viewProjection, false, numTested, numSkipped);
+    VERIFY(numTested == 3 && numSkipped == 0);
+}
+
+} // namespace Test
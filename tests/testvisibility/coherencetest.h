@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Tests that the brute force system reuses the results of the last frame
+    only for boxes which didn't move, seen by observers which didn't either.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class CoherenceTest : public TestCase
+{
+    __DeclareClass(CoherenceTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
@@ -0,0 +1,119 @@
+//------------------------------------------------------------------------------
+// contributiontest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "contributiontest.h"
+#include "visibility/systems/contributionsystem.h"
+#include "math/simdkernels.h"
+#include "system/cpu.h"
+
+using namespace Math;
+using namespace Visibility;
+using namespace System;
+
+namespace Test
+{
+__ImplementClass(Test::ContributionTest, 'CNTE', Test::TestCase);
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ContributionTest::Run()
+{
+    const mat4 view = inverse(lookatrh(point(0, 0, 10), point(0, 0, 0), vector(0, 1, 0)));
+    const mat4 perspective = perspfovrh(deg2rad(90.0f), 1.0f, 0.1f, 100.0f) * view;
+    const mat4 ortho = orthorh(20.0f, 20.0f, 0.1f, 100.0f) * view;
+    const float minSize = 2.0f / 1080.0f;
+
+    const bbox boxes[] =
+    {
+        bbox(point(0, 0, 0), vector(1)),
+        bbox(point(0, 0, -40), vector(0.05f)),
+        bbox(point(0, 0, -40), vector(0.05f)),
+        bbox(point(0, 0, 0), vector(1)),
+        bbox(point(0, 0, 0), vector(1)),
+        bbox(point(0, 0, -20), vector(1)),
+        bbox(point(0, 0, -20), vector(1)),
+        bbox(point(0, 0, -40), vector(0.005f)),
+    };
+    const SizeT numBoxes = sizeof(boxes) / sizeof(boxes[0]);
+    const uint32 ids[numBoxes] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    const uint32_t lodActive = (uint32_t)Models::NodeInstanceFlags::NodeInstance_LodActive;
+    const uint32_t flags[numBoxes] = { 0, 0, (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible, lodActive, 0, 0, lodActive, 0 };
+
+    // a near and a far LOD for the box in the middle and the one behind it
+    const Util::Tuple<float, float> noLod = Util::MakeTuple(FLT_MAX, FLT_MAX);
+    const Util::Tuple<float, float> nearLod = Util::MakeTuple(0.0f, 20.0f);
+    const Util::Tuple<float, float> farLod = Util::MakeTuple(20.0f, 50.0f);
+    const Util::Tuple<float, float> lods[numBoxes] = { noLod, noLod, noLod, nearLod, farLod, nearLod, farLod, noLod };
+
+    // the bounding sphere of the box in the middle covers a sixth of the screen height from 10 units away
+    scalar sizes[numBoxes], distances[numBoxes];
+    ProjectBoxes(sizes, distances, boxes, ids, numBoxes, perspective, point(0, 0, 10), false);
+    VERIFY(Math::abs(sizes[0] - Math::sqrt(3.0f) / 10.0f) < 1e-4f);
+    VERIFY(Math::abs(distances[0] - 10.0f) < 1e-4f);
+    VERIFY(Math::abs(distances[5] - 30.0f) < 1e-4f);
+    ProjectBoxes(sizes, distances, boxes, ids, numBoxes, ortho, point(0, 0, 10), true);
+    VERIFY(Math::abs(sizes[0] - Math::sqrt(3.0f) / 10.0f) < 1e-4f);
+    VERIFY(Math::abs(sizes[5] - sizes[0]) < 1e-6f);
+
+    ClipStatus::Type status[numBoxes];
+    IndexT i;
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Inside;
+    status[7] = ClipStatus::Outside;
+    ContributionCullBoxes(status, boxes, ids, flags, lods, numBoxes, perspective, false, minSize);
+    VERIFY(status[0] == ClipStatus::Inside);
+    VERIFY(status[1] == ClipStatus::Outside);
+    VERIFY(status[2] == ClipStatus::Inside);
+    VERIFY(status[3] == ClipStatus::Inside);
+    VERIFY(status[4] == ClipStatus::Outside);
+    VERIFY(status[5] == ClipStatus::Outside);
+    VERIFY(status[6] == ClipStatus::Inside);
+    VERIFY(status[7] == ClipStatus::Outside);
+
+    // orthogonal observers keep the size of what is far away and the LOD of the camera
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Inside;
+    ContributionCullBoxes(status, boxes, ids, flags, lods, numBoxes, ortho, true, minSize);
+    VERIFY(status[0] == ClipStatus::Inside);
+    VERIFY(status[1] == ClipStatus::Inside);
+    VERIFY(status[3] == ClipStatus::Inside);
+    VERIFY(status[4] == ClipStatus::Outside);
+    VERIFY(status[5] == ClipStatus::Outside);
+    VERIFY(status[6] == ClipStatus::Inside);
+    VERIFY(status[7] == ClipStatus::Outside);
+
+    // every variant of the kernel comes to the same sizes, also for more boxes than fit a register
+    Util::FixedArray<bbox> many(37);
+    Util::FixedArray<uint32> manyIds(many.Size());
+    for (i = 0; i < many.Size(); i++)
+    {
+        many[i] = bbox(point((float)(i % 5) - 2.0f, 0.5f * (i % 3), 5.0f - 2.0f * i), vector(0.1f + 0.05f * i));
+        manyIds[i] = many.Size() - 1 - i;
+    }
+    Util::FixedArray<scalar> firstSizes(many.Size()), firstDistances(many.Size());
+    Util::FixedArray<scalar> levelSizes(many.Size()), levelDistances(many.Size());
+    int level;
+    for (level = Cpu::SimdGeneric; level <= Cpu::GetMaxSimdLevel(); level++)
+    {
+        Cpu::SetSimdLevel((Cpu::SimdLevel)level);
+        ProjectBoxes(levelSizes.Begin(), levelDistances.Begin(), many.Begin(), manyIds.Begin(), many.Size(), perspective, point(0, 0, 10), false);
+        if (level == Cpu::SimdGeneric)
+        {
+            firstSizes = levelSizes;
+            firstDistances = levelDistances;
+            continue;
+        }
+        for (i = 0; i < many.Size(); i++)
+        {
+            VERIFY(Math::abs(levelSizes[i] - firstSizes[i]) <= 1e-5f * Math::max(1.0f, firstSizes[i]));
+            VERIFY(Math::abs(levelDistances[i] - firstDistances[i]) < 1e-4f);
+        }
+    }
+    Cpu::SetSimdLevel(Cpu::GetMaxSimdLevel());
+}
+
+} // namespace Test
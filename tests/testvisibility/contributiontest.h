@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Tests the screen size culling and per observer LOD selection of the
+    contribution system, for perspective and orthogonal observers.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class ContributionTest : public TestCase
+{
+    __DeclareClass(ContributionTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
@@ -7,6 +7,10 @@
 #include "core/coreserver.h"
 #include "testbase/testrunner.h"
 #include "visibilitytest.h"
+#include "occlusiontest.h"
+#include "portaltest.h"
+#include "coherencetest.h"
+#include "contributiontest.h"
 
 using namespace Core;
 using namespace Test;
@@ -23,6 +27,10 @@ int main(int argc, char** argv)
 
     // setup and run test runner
     Ptr<TestRunner> testRunner = TestRunner::Create();
+    testRunner->AttachTestCase(OcclusionTest::Create());
+    testRunner->AttachTestCase(PortalTest::Create());
+    testRunner->AttachTestCase(CoherenceTest::Create());
+    testRunner->AttachTestCase(ContributionTest::Create());
     testRunner->AttachTestCase(VisibilityTest::Create());
     testRunner->Run();
     //testRunner->AttachTestCase(BXmlReaderTest::Create());
@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+// occlusiontest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "occlusiontest.h"
+#include "visibility/systems/occlusionsystem.h"
+#include "system/cpu.h"
+
+using namespace Math;
+using namespace Visibility;
+using namespace System;
+
+namespace Test
+{
+__ImplementClass(Test::OcclusionTest, 'OCTE', Test::TestCase);
+
+/// a box which is expected to be hidden or not
+struct TestBox
+{
+    bbox box;
+    ClipStatus::Type status;    // what the frustum culling left
+    bool alwaysVisible;
+    ClipStatus::Type expected;
+};
+
+//------------------------------------------------------------------------------
+/**
+    A wall 12 wide and 4 high at the origin, looked at head on from 10 units
+    away, with a grid of boxes behind it and a few around it.
+*/
+static void
+BuildScene(Util::Array<TestBox>& boxes)
+{
+    IndexT i, j;
+    for (i = -4; i <= 4; i++)
+    {
+        for (j = 1; j <= 4; j++)
+            boxes.Append({ bbox(point(i, 1.5f, -3.0f * j), vector(0.4f)), ClipStatus::Inside, false, ClipStatus::Outside });
+    }
+
+    // above the wall, in front of it, next to it, partly next to it and stuck in it
+    boxes.Append({ bbox(point(0, 8, -6), vector(0.5f)), ClipStatus::Inside, false, ClipStatus::Inside });
+    boxes.Append({ bbox(point(0, 1.5f, 3), vector(0.5f)), ClipStatus::Inside, false, ClipStatus::Inside });
+    boxes.Append({ bbox(point(12, 1.5f, -3), vector(0.5f)), ClipStatus::Clipped, false, ClipStatus::Clipped });
+    boxes.Append({ bbox(point(8, 1.5f, -3), vector(0.5f)), ClipStatus::Inside, false, ClipStatus::Inside });
+    boxes.Append({ bbox(point(0, 1.5f, 0), vector(0.5f)), ClipStatus::Inside, false, ClipStatus::Inside });
+
+    // hidden, but always visible or already culled by the frustum
+    boxes.Append({ bbox(point(1, 1.5f, -6), vector(0.5f)), ClipStatus::Inside, true, ClipStatus::Inside });
+    boxes.Append({ bbox(point(-1, 1.5f, -6), vector(0.5f)), ClipStatus::Outside, false, ClipStatus::Outside });
+
+    // reaching behind the eye
+    boxes.Append({ bbox(point(0, 1.5f, 10), vector(1.0f)), ClipStatus::Clipped, false, ClipStatus::Clipped });
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+OcclusionTest::Run()
+{
+    const mat4 view = inverse(lookatrh(point(0, 1.5f, 10), point(0, 1.5f, 0), vector(0, 1, 0)));
+    const mat4 viewProjection = perspfovrh(deg2rad(60.0f), 2.0f, 0.1f, 100.0f) * view;
+
+    const vec3 wall[] = { vec3(-6, 0, 0), vec3(6, 0, 0), vec3(6, 4, 0), vec3(-6, 4, 0) };
+    const uint32 wallIndices[] = { 0, 1, 2, 0, 2, 3 };
+
+    Util::Array<TestBox> testBoxes;
+    BuildScene(testBoxes);
+    Util::FixedArray<bbox> boxes(testBoxes.Size());
+    Util::FixedArray<uint32> ids(testBoxes.Size());
+    Util::FixedArray<uint32_t> flags(testBoxes.Size());
+    IndexT i;
+    for (i = 0; i < testBoxes.Size(); i++)
+    {
+        boxes[i] = testBoxes[i].box;
+        ids[i] = i;
+        flags[i] = testBoxes[i].alwaysVisible ? (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible : 0;
+    }
+
+    // every variant of the kernels has to come to the same result, to the bit
+    Util::FixedArray<float> firstDepth;
+    int level;
+    for (level = Cpu::SimdGeneric; level <= Cpu::GetMaxSimdLevel(); level++)
+    {
+        Cpu::SetSimdLevel((Cpu::SimdLevel)level);
+
+        OcclusionBuffer buffer;
+        OcclusionBufferSetup(buffer, 250, 120);
+        VERIFY(buffer.width == 256);
+        VERIFY(buffer.height == 128);
+
+        // the wall is placed by its transform, as the occlusion system does
+        OcclusionBufferAddOccluder(buffer, viewProjection * translation(0, 0, -0.1f), wall, 4, wallIndices, 6);
+        VERIFY(buffer.triangles.Size() == 2);
+        for (i = 0; i < buffer.tilesX * buffer.tilesY; i++)
+            OcclusionBufferRasterizeTile(buffer, i);
+
+        // the middle of the screen sees the wall
+        const vec4 center = viewProjection * vec4(0, 1.5f, -0.1f, 1);
+        VERIFY(Math::abs(buffer.depth[(buffer.height / 2) * buffer.width + buffer.width / 2] - center.z / center.w) < 1e-4f);
+        VERIFY(buffer.depth[0] == 1.0f);
+        VERIFY(buffer.blockDepth[0] == 1.0f);
+
+        Util::FixedArray<ClipStatus::Type> status(testBoxes.Size());
+        for (i = 0; i < testBoxes.Size(); i++)
+            status[i] = testBoxes[i].status;
+        OcclusionBufferTestBoxes(buffer, status.Begin(), boxes.Begin(), ids.Begin(), flags.Begin(), status.Size(), viewProjection);
+        for (i = 0; i < testBoxes.Size(); i++)
+            VERIFY(status[i] == testBoxes[i].expected);
+
+        if (level == Cpu::SimdGeneric)
+            firstDepth = buffer.depth;
+        else
+            VERIFY(firstDepth == buffer.depth);
+
+        // nothing is hidden once the occluders are gone
+        OcclusionBufferClear(buffer);
+        for (i = 0; i < buffer.tilesX * buffer.tilesY; i++)
+            OcclusionBufferRasterizeTile(buffer, i);
+        for (i = 0; i < testBoxes.Size(); i++)
+            status[i] = testBoxes[i].status;
+        OcclusionBufferTestBoxes(buffer, status.Begin(), boxes.Begin(), ids.Begin(), flags.Begin(), status.Size(), viewProjection);
+        for (i = 0; i < testBoxes.Size(); i++)
+            VERIFY(status[i] == testBoxes[i].status);
+
+        // a wall which reaches past the eye is left out rather than clipped
+        const vec3 sideWall[] = { vec3(-2, 0, -5), vec3(-2, 0, 15), vec3(-2, 4, 15), vec3(-2, 4, -5) };
+        OcclusionBufferAddOccluder(buffer, viewProjection, sideWall, 4, wallIndices, 6);
+        VERIFY(buffer.triangles.IsEmpty());
+    }
+    Cpu::SetSimdLevel(Cpu::GetMaxSimdLevel());
+}
+
+} // namespace Test
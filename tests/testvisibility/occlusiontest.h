@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Tests the occlusion buffer on a fixed scene of walls and boxes, without
+    a window or graphics device.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class OcclusionTest : public TestCase
+{
+    __DeclareClass(OcclusionTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
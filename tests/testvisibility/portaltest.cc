@@ -0,0 +1,174 @@
+//------------------------------------------------------------------------------
+// portaltest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "portaltest.h"
+#include "visibility/systems/portalsystem.h"
+#include "io/memorystream.h"
+
+using namespace Math;
+using namespace Visibility;
+
+namespace Test
+{
+__ImplementClass(Test::PortalTest, 'PRTE', Test::TestCase);
+
+/// three rooms in a row, a door leads from the first to the second and one in the corner from the second to the third
+static const char* Rooms =
+    "{"
+    "  \"cells\": ["
+    "    { \"name\": \"hall\", \"min\": [0, 0, 0], \"max\": [10, 4, 10] },"
+    "    { \"name\": \"kitchen\", \"min\": [0, 0, -10], \"max\": [10, 4, 0] },"
+    "    { \"name\": \"cellar\", \"min\": [0, 0, -20], \"max\": [10, 4, -10] }"
+    "  ],"
+    "  \"portals\": ["
+    "    { \"cells\": [0, 1], \"vertices\": [[4, 0, 0], [6, 0, 0], [6, 3, 0], [4, 3, 0]] },"
+    "    { \"cells\": [1, 2], \"vertices\": [[0, 0, -10], [2, 0, -10], [2, 3, -10], [0, 3, -10]] }"
+    "  ]"
+    "}";
+
+/// the second portal leads into a cell which doesn't exist
+static const char* BrokenRooms =
+    "{"
+    "  \"cells\": ["
+    "    { \"name\": \"hall\", \"min\": [0, 0, 0], \"max\": [10, 4, 10] },"
+    "    { \"name\": \"kitchen\", \"min\": [0, 0, -10], \"max\": [10, 4, 0] }"
+    "  ],"
+    "  \"portals\": ["
+    "    { \"cells\": [0, 1], \"vertices\": [[4, 0, 0], [6, 0, 0], [6, 3, 0], [4, 3, 0]] },"
+    "    { \"cells\": [1, 2], \"vertices\": [[0, 0, -10], [2, 0, -10], [2, 3, -10], [0, 3, -10]] }"
+    "  ]"
+    "}";
+
+//------------------------------------------------------------------------------
+/**
+*/
+static bool
+Load(PortalWorld& world, const char* json)
+{
+    Ptr<IO::MemoryStream> stream = IO::MemoryStream::Create();
+    stream->SetAccessMode(IO::Stream::WriteAccess);
+    if (!stream->Open())
+        return false;
+    stream->Write(json, strlen(json));
+    stream->Close();
+    return PortalWorldLoad(world, stream.upcast<IO::Stream>());
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+static mat4
+LookDown(const point& eye)
+{
+    const mat4 view = inverse(lookatrh(eye, eye - vector(0, 0, 1), vector(0, 1, 0)));
+    return perspfovrh(deg2rad(90.0f), 1.0f, 0.1f, 100.0f) * view;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+PortalTest::Run()
+{
+    PortalWorld world;
+    VERIFY(Load(world, Rooms));
+    VERIFY(world.cells.Size() == 3);
+    VERIFY(world.portals.Size() == 2);
+    VERIFY(world.cells[1].name == "kitchen");
+    VERIFY(world.cells[1].portals.Size() == 2);
+    VERIFY(world.portals[1].cells[0] == 1 && world.portals[1].cells[1] == 2);
+    VERIFY(world.portals[1].vertices.Size() == 4);
+
+    // objects in each room, one in the doorway and one behind the eye
+    const bbox boxes[] =
+    {
+        bbox(point(5, 1, 5), vector(0.5f)),
+        bbox(point(5, 1, -5), vector(0.5f)),
+        bbox(point(1, 1, -5), vector(0.5f)),
+        bbox(point(5, 1, -15), vector(0.5f)),
+        bbox(point(5, 1, 0), vector(0.5f)),
+        bbox(point(6, 1, -15), vector(0.5f)),
+        bbox(point(7, 1, -15), vector(0.5f)),
+        bbox(point(5, 1, 9.5f), vector(0.3f)),
+        bbox(point(1, 1, -15), vector(0.5f)),
+    };
+    const SizeT numBoxes = sizeof(boxes) / sizeof(boxes[0]);
+    uint32 ids[numBoxes];
+    uint32_t flags[numBoxes];
+    IndexT cells[numBoxes];
+    IndexT i;
+    for (i = 0; i < numBoxes; i++)
+    {
+        ids[i] = i;
+        flags[i] = 0;
+        cells[i] = PortalWorldFindCell(world, boxes[i]);
+    }
+    flags[5] = (uint32_t)Models::NodeInstanceFlags::NodeInstance_AlwaysVisible;
+
+    VERIFY(cells[0] == 0);
+    VERIFY(cells[1] == 1);
+    VERIFY(cells[2] == 1);
+    VERIFY(cells[3] == 2);
+    VERIFY(cells[4] == PortalNoCell);
+    VERIFY(PortalWorldFindCell(world, point(5, 1, 5)) == 0);
+    VERIFY(PortalWorldFindCell(world, point(5, 1, 15)) == PortalNoCell);
+
+    // from the hall the kitchen is seen through the door, the cellar door is out of sight
+    Util::FixedArray<vec4> rects(world.cells.Size());
+    mat4 viewProjection = LookDown(point(5, 1.5f, 8));
+    PortalWorldFindVisibleCells(world, viewProjection, rects.Begin());
+    VERIFY(rects[0] == vec4(-1, -1, 1, 1));
+    VERIFY(Math::abs(rects[1].x + 0.125f) < 1e-4f && Math::abs(rects[1].z - 0.125f) < 1e-4f);
+    VERIFY(Math::abs(rects[1].y + 0.1875f) < 1e-4f && Math::abs(rects[1].w - 0.1875f) < 1e-4f);
+    VERIFY(rects[2].x > rects[2].z);
+
+    ClipStatus::Type status[numBoxes];
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Outside;
+    status[6] = ClipStatus::Inside;
+    PortalWorldClipBoxes(rects.Begin(), status, boxes, ids, cells, flags, numBoxes, viewProjection, false);
+    VERIFY(status[0] != ClipStatus::Outside);
+    VERIFY(status[1] != ClipStatus::Outside);
+    VERIFY(status[2] == ClipStatus::Outside);
+    VERIFY(status[3] == ClipStatus::Outside);
+    VERIFY(status[4] != ClipStatus::Outside);
+    VERIFY(status[5] == ClipStatus::Inside);
+    VERIFY(status[6] == ClipStatus::Inside);
+    VERIFY(status[7] == ClipStatus::Outside);
+    VERIFY(status[8] == ClipStatus::Outside);
+
+    // from the kitchen corner only the corner of the cellar is seen
+    viewProjection = LookDown(point(1, 1.5f, -2));
+    PortalWorldFindVisibleCells(world, viewProjection, rects.Begin());
+    VERIFY(rects[2].x <= rects[2].z);
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Outside;
+    PortalWorldClipBoxes(rects.Begin(), status, boxes, ids, cells, flags, numBoxes, viewProjection, false);
+    VERIFY(status[0] == ClipStatus::Outside);
+    VERIFY(status[3] == ClipStatus::Outside);
+    VERIFY(status[8] != ClipStatus::Outside);
+
+    // outside of the rooms only the frustum counts
+    viewProjection = LookDown(point(5, 1.5f, 20));
+    PortalWorldFindVisibleCells(world, viewProjection, rects.Begin());
+    for (i = 0; i < world.cells.Size(); i++)
+        VERIFY(rects[i] == vec4(-1, -1, 1, 1));
+    for (i = 0; i < numBoxes; i++)
+        status[i] = ClipStatus::Outside;
+    PortalWorldClipBoxes(rects.Begin(), status, boxes, ids, cells, flags, numBoxes, viewProjection, false);
+    for (i = 0; i < numBoxes; i++)
+        VERIFY(status[i] != ClipStatus::Outside);
+
+    // an object which moves into another room is found there
+    VERIFY(PortalWorldFindCell(world, bbox(point(5, 1, -15), vector(0.5f))) == 2);
+    VERIFY(PortalWorldFindCell(world, bbox(point(5, 1, -10), vector(0.5f))) == PortalNoCell);
+
+    // malformed data is rejected instead of asserting
+    PortalWorld broken;
+    VERIFY(!Load(broken, BrokenRooms));
+    VERIFY(broken.cells.IsEmpty() && broken.portals.IsEmpty());
+}
+
+} // namespace Test
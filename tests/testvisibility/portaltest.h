@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Tests the cells and portals of the portal system on a fixed scene of rooms,
+    without a window or graphics device.
+
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class PortalTest : public TestCase
+{
+    __DeclareClass(PortalTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
@@ -0,0 +1,144 @@
+//------------------------------------------------------------------------------
+// allocatorcontentiontest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "allocatorcontentiontest.h"
+#include "timing/timer.h"
+#include "util/fixedarray.h"
+#include "ids/idallocator.h"
+#include "threading/mpmcqueue.h"
+#include <atomic>
+#include <thread>
+
+using namespace Threading;
+namespace Test
+{
+__ImplementClass(AllocatorContentionTest, 'ACTT', Core::RefCounted);
+
+static const SizeT NumThreads = 4;
+static const SizeT OpsPerThread = 200000;
+static const SizeT KeptPerThread = 64;
+
+typedef Ids::IdAllocatorSafe<0xFFFF, uint, uint64_t> TestAllocator;
+
+//------------------------------------------------------------------------------
+/**
+    Every thread keeps a few elements for the whole run and checks them
+    while it allocates and frees others. Freed elements are passed through
+    a queue, so they are also freed by other threads than the ones that
+    allocated them.
+*/
+void
+AllocatorContentionTest::Run()
+{
+    TestAllocator allocator;
+    MpmcQueue<uint32_t> live;
+    live.Resize(4096);
+    Util::FixedArray<std::atomic<int>> inUse(0xFFFF);
+    IndexT i;
+    for (i = 0; i < inUse.Size(); i++)
+        inUse[i].store(0);
+
+    std::atomic<int> duplicates(0);
+    std::atomic<int> corrupted(0);
+    std::atomic<int> staleAccepted(0);
+    std::atomic<uint64_t> allocs(0);
+
+    Timing::Timer timer;
+    timer.Start();
+
+    Util::FixedArray<std::thread> threads(NumThreads);
+    for (i = 0; i < NumThreads; i++)
+    {
+        threads[i] = std::thread([&, i]()
+        {
+            auto alloc = [&](uint value) -> uint32_t
+            {
+                uint32_t id = allocator.Alloc();
+                if (inUse[TestAllocator::IdIndex(id)].exchange(1) != 0)
+                    duplicates++;
+                allocator.Set<0>(id, value);
+                allocator.Set<1>(id, (uint64_t)value * 3);
+                allocator.Release(id);
+                allocs++;
+                return id;
+            };
+            auto check = [&](uint32_t id, uint value)
+            {
+                __Lock(allocator, id);
+                const uint v = allocator.Get<0>(id);
+                if ((value != 0 && v != value) || allocator.Get<1>(id) != (uint64_t)v * 3)
+                    corrupted++;
+            };
+            auto free = [&](uint32_t id)
+            {
+                check(id, 0);
+                inUse[TestAllocator::IdIndex(id)].store(0);
+                allocator.Dealloc(id);
+                if (allocator.IsValid(id))
+                    staleAccepted++;
+            };
+
+            uint32_t kept[KeptPerThread];
+            IndexT j;
+            for (j = 0; j < KeptPerThread; j++)
+                kept[j] = alloc((uint)(i * KeptPerThread + j + 1));
+
+            for (j = 0; j < OpsPerThread; j++)
+            {
+                switch (j % 4)
+                {
+                    case 0:
+                    case 1:
+                    {
+                        uint32_t id = alloc((uint)j + 1);
+                        if (!live.TryEnqueue(id))
+                            free(id);
+                        break;
+                    }
+                    case 2:
+                    {
+                        uint32_t id;
+                        if (live.Dequeue(id))
+                            free(id);
+                        break;
+                    }
+                    case 3:
+                    {
+                        const IndexT k = j % KeptPerThread;
+                        check(kept[k], (uint)(i * KeptPerThread + k + 1));
+                        break;
+                    }
+                }
+            }
+
+            for (j = 0; j < KeptPerThread; j++)
+                free(kept[j]);
+        });
+    }
+    for (i = 0; i < NumThreads; i++)
+        threads[i].join();
+
+    uint32_t id;
+    while (live.Dequeue(id))
+    {
+        inUse[TestAllocator::IdIndex(id)].store(0);
+        allocator.Dealloc(id);
+    }
+
+    timer.Stop();
+    n_printf("IdAllocatorSafe, %d threads: %.1f M allocs/s, %d elements\n", NumThreads, allocs.load() / timer.GetTime() * 1e-6, allocator.Size());
+
+    VERIFY(duplicates.load() == 0);
+    VERIFY(corrupted.load() == 0);
+    VERIFY(staleAccepted.load() == 0);
+
+    // every element is free now, so allocating as many again must not grow the allocator
+    const uint32_t size = allocator.Size();
+    for (i = 0; i < (IndexT)size; i++)
+        allocator.Alloc();
+    VERIFY(allocator.Size() == size);
+}
+
+} // namespace Test
@@ -0,0 +1,22 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Mixes allocations, frees and reads of an Ids::IdAllocatorSafe from several
+    threads, and checks that no element is handed out twice, that elements
+    don't move or change while the allocator grows, and that freed ids are
+    detected as stale
+    
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class AllocatorContentionTest : public TestCase
+{
+    __DeclareClass(AllocatorContentionTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
@@ -7,6 +7,8 @@
 #include "core/coreserver.h"
 #include "testbase/testrunner.h"
 #include "threadstresstest.h"
+#include "queuecontentiontest.h"
+#include "allocatorcontentiontest.h"
 
 using namespace Core;
 using namespace Test;
@@ -24,6 +26,8 @@ int main(int argc, char** argv)
     // setup and run test runner
     Ptr<TestRunner> testRunner = TestRunner::Create();
     testRunner->AttachTestCase(ThreadStressTest::Create());
+    testRunner->AttachTestCase(QueueContentionTest::Create());
+    testRunner->AttachTestCase(AllocatorContentionTest::Create());
     bool result = testRunner->Run();    
 
     coreServer->Close();
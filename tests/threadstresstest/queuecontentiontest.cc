@@ -0,0 +1,191 @@
+//------------------------------------------------------------------------------
+// queuecontentiontest.cc
+// (C) 2024 Individual contributors, see AUTHORS file
+//------------------------------------------------------------------------------
+#include "stdneb.h"
+#include "queuecontentiontest.h"
+#include "timing/timer.h"
+#include "util/fixedarray.h"
+#include "threading/safequeue.h"
+#include "threading/mpmcqueue.h"
+#include "threading/spscqueue.h"
+#include <atomic>
+#include <thread>
+
+using namespace Threading;
+namespace Test
+{
+__ImplementClass(QueueContentionTest, 'QCTT', Core::RefCounted);
+
+static const uint ItemsPerProducer = 500000;
+
+//------------------------------------------------------------------------------
+/**
+    Every producer pushes 1 to ItemsPerProducer, the consumers pop until
+    all items are accounted for and add them up. pop() returns the number
+    of items it took.
+*/
+template <class PUSH, class POP>
+static bool
+Contend(const char* name, SizeT numProducers, SizeT numConsumers, PUSH push, POP pop)
+{
+    const uint64_t total = (uint64_t)numProducers * ItemsPerProducer;
+    std::atomic<uint64_t> consumed(0);
+    std::atomic<uint64_t> sum(0);
+
+    Timing::Timer timer;
+    timer.Start();
+
+    Util::FixedArray<std::thread> threads(numProducers + numConsumers);
+    IndexT i;
+    for (i = 0; i < numProducers; i++)
+    {
+        threads[i] = std::thread([&push]()
+        {
+            uint v;
+            for (v = 1; v <= ItemsPerProducer; v++)
+                push(v);
+        });
+    }
+    for (i = 0; i < numConsumers; i++)
+    {
+        threads[numProducers + i] = std::thread([&]()
+        {
+            uint64_t localSum = 0;
+            uint64_t pending = 0;
+            while (consumed.load(std::memory_order_relaxed) < total)
+            {
+                const SizeT count = pop(localSum);
+                pending += count;
+
+                // keep the shared counter out of the measurement as much as possible
+                if (count == 0 || pending >= 1024)
+                {
+                    consumed.fetch_add(pending, std::memory_order_relaxed);
+                    pending = 0;
+                }
+            }
+            sum.fetch_add(localSum, std::memory_order_relaxed);
+        });
+    }
+    for (i = 0; i < threads.Size(); i++)
+        threads[i].join();
+
+    timer.Stop();
+    n_printf("%s, %d producers, %d consumers: %.1f M items/s\n", name, numProducers, numConsumers, total / timer.GetTime() * 1e-6);
+
+    const uint64_t expected = (uint64_t)numProducers * ItemsPerProducer * (ItemsPerProducer + 1) / 2;
+    return sum.load() == expected;
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+void
+QueueContentionTest::Run()
+{
+    // many to many
+    {
+        SafeQueue<uint> queue;
+        queue.SetSignalOnEnqueueEnabled(false);
+        bool correct = Contend("SafeQueue", 4, 4,
+            [&queue](uint v) { queue.Enqueue(v); },
+            [&queue](uint64_t& sum) -> SizeT
+            {
+                thread_local Util::Array<uint> items;
+                queue.DequeueAll(items);
+                IndexT i;
+                for (i = 0; i < items.Size(); i++)
+                    sum += items[i];
+                return items.Size();
+            });
+        VERIFY(correct);
+    }
+    {
+        MpmcQueue<uint> queue;
+        queue.Resize(4096);
+        bool correct = Contend("MpmcQueue", 4, 4,
+            [&queue](uint v) { queue.Enqueue(v); },
+            [&queue](uint64_t& sum) -> SizeT
+            {
+                uint v;
+                if (!queue.Dequeue(v))
+                    return 0;
+                sum += v;
+                return 1;
+            });
+        VERIFY(correct);
+    }
+
+    // one to one, the consumer of the SpscQueue blocks while the queue is empty
+    {
+        SafeQueue<uint> queue;
+        queue.SetSignalOnEnqueueEnabled(false);
+        bool correct = Contend("SafeQueue", 1, 1,
+            [&queue](uint v) { queue.Enqueue(v); },
+            [&queue](uint64_t& sum) -> SizeT
+            {
+                if (queue.IsEmpty())
+                    return 0;
+                sum += queue.Dequeue();
+                return 1;
+            });
+        VERIFY(correct);
+    }
+    {
+        SpscQueue<uint> queue;
+        queue.Resize(4096);
+        bool correct = Contend("SpscQueue", 1, 1,
+            [&queue](uint v) { queue.Enqueue(v); },
+            [&queue](uint64_t& sum) -> SizeT
+            {
+                uint v;
+                if (!queue.Dequeue(v))
+                {
+                    // the time-out only matters once the last item is gone
+                    queue.WaitTimeout(1);
+                    return 0;
+                }
+                sum += v;
+                return 1;
+            });
+        VERIFY(correct);
+    }
+
+    // tiny rings, the producers keep finding the queue full and sleep until a consumer makes room
+    {
+        MpmcQueue<uint> queue;
+        queue.Resize(16);
+        bool correct = Contend("MpmcQueue (full)", 4, 4,
+            [&queue](uint v) { queue.Enqueue(v); },
+            [&queue](uint64_t& sum) -> SizeT
+            {
+                uint v;
+                if (!queue.Dequeue(v))
+                    return 0;
+                sum += v;
+                return 1;
+            });
+        VERIFY(correct);
+    }
+    {
+        SpscQueue<uint> queue;
+        queue.Resize(16);
+        bool correct = Contend("SpscQueue (full)", 1, 1,
+            [&queue](uint v) { queue.Enqueue(v); },
+            [&queue](uint64_t& sum) -> SizeT
+            {
+                uint v;
+                if (!queue.Dequeue(v))
+                {
+                    queue.WaitTimeout(1);
+                    return 0;
+                }
+                sum += v;
+                return 1;
+            });
+        VERIFY(correct);
+    }
+}
+
+} // namespace Test
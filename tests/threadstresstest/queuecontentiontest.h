@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------------------------
+/**
+    Measures the throughput of the thread safe queues under contention, and
+    checks that every element arrives exactly once
+    
+    (C) 2024 Individual contributors, see AUTHORS file
+*/
+//------------------------------------------------------------------------------
+#include "testbase/testcase.h"
+namespace Test
+{
+class QueueContentionTest : public TestCase
+{
+    __DeclareClass(QueueContentionTest);
+public:
+    /// run test
+    virtual void Run();
+};
+} // namespace Test
@@ -7,6 +7,7 @@
 #include "model/animutil/animbuildersaver.h"
 #include "io/ioserver.h"
 #include "coreanimation/naxfileformatstructs.h"
+#include "coreanimation/animkeycompression.h"
 
 namespace ToolkitUtil
 {
@@ -16,6 +17,183 @@ using namespace System;
 using namespace CoreAnimation;
 using namespace Math;
 
+/// largest error a decompressed translation, scale or velocity key may have
+static const float MaxVectorKeyError = 0.0005f;
+/// largest error per component a decompressed rotation key may have
+static const float MaxRotationKeyError = 0.0005f;
+
+//------------------------------------------------------------------------------
+/**
+    Get key i of a curve, rotations are flipped into the hemisphere of the
+    first key, so constant curves can be detected per component.
+*/
+static vec4
+GetCurveKey(const AnimBuilder& anim, const AnimBuilderCurve& curve, IndexT i)
+{
+    const float* key = &anim.keys[curve.firstKeyOffset];
+    if (curve.curveType == CurveType::Rotation)
+    {
+        vec4 first(key[0], key[1], key[2], key[3]);
+        vec4 value(key[i * 4], key[i * 4 + 1], key[i * 4 + 2], key[i * 4 + 3]);
+        return dot(first, value) < 0.0f ? -value : value;
+    }
+    return vec4(key[i * 3], key[i * 3 + 1], key[i * 3 + 2], 0.0f);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Decide on the key format of a curve and fill in its key offset and scale.
+*/
+static void
+ChooseKeyFormat(const AnimBuilder& anim, const AnimBuilderCurve& curve, Nax3Curve& nax3Curve)
+{
+    const bool rotation = curve.curveType == CurveType::Rotation;
+    const float maxError = rotation ? MaxRotationKeyError : MaxVectorKeyError;
+
+    vec4 minKey = GetCurveKey(anim, curve, 0);
+    vec4 maxKey = minKey;
+    IndexT i;
+    for (i = 1; i < (IndexT)curve.numKeys; i++)
+    {
+        const vec4 key = GetCurveKey(anim, curve, i);
+        minKey = minimize(minKey, key);
+        maxKey = maximize(maxKey, key);
+    }
+
+    const vec4 extent = maxKey - minKey;
+    vec4 offset = minKey;
+    vec4 scale = extent * (1.0f / 65535.0f);
+    KeyFormat::Code keyFormat = KeyFormat::Quantized;
+    if (max(max(extent.x, extent.y), max(extent.z, extent.w)) <= 2.0f * maxError)
+    {
+        keyFormat = KeyFormat::Constant;
+        offset = (minKey + maxKey) * 0.5f;
+        if (rotation)
+            offset = normalize(offset);
+        scale = vec4(0.0f);
+    }
+    else
+    {
+        // make sure the quantization stays within the error bound
+        ushort packed[PackedKeyStride + PackedKeyPadding] = { 0 };
+        for (i = 0; i < (IndexT)curve.numKeys && keyFormat == KeyFormat::Quantized; i++)
+        {
+            const vec4 key = GetCurveKey(anim, curve, i);
+            vec4 error;
+            if (rotation)
+            {
+                const quat q = normalize(quat(key));
+                PackRotationKey(q, packed);
+                const vec4 unpacked(UnpackRotationKey(packed).vec);
+                error = abs(dot(unpacked, vec4(q.vec)) < 0.0f ? unpacked + vec4(q.vec) : unpacked - vec4(q.vec));
+            }
+            else
+            {
+                PackVectorKey(&key.x, offset, scale, packed);
+                error = abs(vec4(UnpackVectorKey(packed, offset, scale).vec) - key);
+            }
+            if (max(max(error.x, error.y), max(error.z, error.w)) > maxError)
+                keyFormat = KeyFormat::Float;
+        }
+        if (rotation || keyFormat == KeyFormat::Float)
+        {
+            offset = vec4(0.0f);
+            scale = vec4(0.0f);
+        }
+    }
+
+    nax3Curve.keyFormat = keyFormat;
+    offset.storeu(nax3Curve.keyOffset);
+    scale.storeu(nax3Curve.keyScale);
+}
+
+//------------------------------------------------------------------------------
+/**
+    Append the keys of a curve in its key format together with the
+    intervals between them. A key which equals both neighbours is left
+    out, so a run of identical keys only spans a single interval.
+*/
+static void
+AppendCurveKeys(const AnimBuilder& anim, const AnimBuilderCurve& curve, Nax3Curve& nax3Curve, Array<Nax3Interval>& intervals, Array<float>& keys, Array<ushort>& packedKeys)
+{
+    const bool rotation = curve.curveType == CurveType::Rotation;
+    const bool quantized = nax3Curve.keyFormat == KeyFormat::Quantized;
+    const SizeT stride = quantized ? PackedKeyStride : (rotation ? 4 : 3);
+    const vec4 offset(nax3Curve.keyOffset[0], nax3Curve.keyOffset[1], nax3Curve.keyOffset[2], nax3Curve.keyOffset[3]);
+    const vec4 scale(nax3Curve.keyScale[0], nax3Curve.keyScale[1], nax3Curve.keyScale[2], nax3Curve.keyScale[3]);
+
+    // encode all keys first, so identical keys can be compared bitwise
+    Array<uint> words;
+    words.Reserve(curve.numKeys * stride);
+    IndexT i, j;
+    for (i = 0; i < (IndexT)curve.numKeys; i++)
+    {
+        if (quantized)
+        {
+            ushort packed[PackedKeyStride];
+            if (rotation)
+                PackRotationKey(normalize(quat(GetCurveKey(anim, curve, i))), packed);
+            else
+            {
+                const vec4 key = GetCurveKey(anim, curve, i);
+                PackVectorKey(&key.x, offset, scale, packed);
+            }
+            for (j = 0; j < (IndexT)stride; j++)
+                words.Append(packed[j]);
+        }
+        else
+        {
+            const float* key = &anim.keys[curve.firstKeyOffset + i * stride];
+            for (j = 0; j < (IndexT)stride; j++)
+                words.Append(*(const uint*)&key[j]);
+        }
+    }
+
+    auto sameKey = [&](IndexT a, IndexT b)
+    {
+        return memcmp(&words[a * stride], &words[b * stride], stride * sizeof(uint)) == 0;
+    };
+
+    nax3Curve.firstIntervalOffset = intervals.Size();
+    nax3Curve.numIntervals = 0;
+    IndexT prevTime = 0;
+    uint prevKey = 0;
+    for (i = 0; i < (IndexT)curve.numKeys; i++)
+    {
+        const bool last = i == (IndexT)curve.numKeys - 1;
+        if (i > 0 && !last && sameKey(i, i - 1) && sameKey(i, i + 1))
+            continue;
+
+        uint key;
+        if (quantized)
+        {
+            key = packedKeys.Size();
+            for (j = 0; j < (IndexT)stride; j++)
+                packedKeys.Append((ushort)words[i * stride + j]);
+        }
+        else
+        {
+            key = keys.Size();
+            for (j = 0; j < (IndexT)stride; j++)
+                keys.Append(*(const float*)&words[i * stride + j]);
+        }
+
+        if (i > 0)
+        {
+            Nax3Interval interval;
+            interval.start = anim.keyTimes[curve.firstTimeOffset + prevTime];
+            interval.end = anim.keyTimes[curve.firstTimeOffset + i];
+            interval.key0 = prevKey;
+            interval.key1 = key;
+            interval.duration = 1 / float(interval.end - interval.start);
+            intervals.Append(interval);
+            nax3Curve.numIntervals++;
+        }
+        prevTime = i;
+        prevKey = key;
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -67,55 +245,55 @@ AnimBuilderSaver::WriteAnimations(const Ptr<IO::Stream>& stream, const Util::Arr
 {
     for (auto& anim : animBuilders)
     {
-        Nax3Anim nax3;
-        nax3.numClips = anim.GetNumClips();
-        nax3.numEvents = anim.events.Size();
-        nax3.numCurves = anim.curves.Size();
-        nax3.numKeys = anim.keys.Size();
-        nax3.numIntervals = 0;
-        for (const auto& curve : anim.curves)
-        {
-            nax3.numIntervals += curve.numKeys - 1;
-        }
-
-        // write header
-        stream->Write(&nax3, sizeof(nax3));
-
+        // compress the curves before anything is written, the header needs the key counts
+        Util::Array<Nax3Curve> nax3Curves;
         Util::Array<Nax3Interval> intervals;
-
+        Util::Array<float> keys;
+        Util::Array<ushort> packedKeys;
         for (const auto& curve : anim.curves)
         {
-            // write curve attributes
             Nax3Curve nax3Curve;
-            nax3Curve.firstIntervalOffset = intervals.Size();
-            nax3Curve.numIntervals = curve.numKeys == 0 ? 0 : curve.numKeys - 1;
+            Memory::Clear(&nax3Curve, sizeof(nax3Curve));
             nax3Curve.preInfinityType = curve.preInfinityType;
             nax3Curve.postInfinityType = curve.postInfinityType;
             nax3Curve.curveType = curve.curveType;
+            nax3Curve.keyFormat = KeyFormat::Float;
+            nax3Curve.firstIntervalOffset = intervals.Size();
 
-            byteOrder.ConvertInPlace(nax3Curve.firstIntervalOffset);
-            byteOrder.ConvertInPlace(nax3Curve.numIntervals);
+            // curves with a single key have no intervals and stay inactive
+            if (curve.numKeys > 1)
+            {
+                ChooseKeyFormat(anim, curve, nax3Curve);
+                if (nax3Curve.keyFormat != KeyFormat::Constant)
+                    AppendCurveKeys(anim, curve, nax3Curve, intervals, keys, packedKeys);
+            }
+            nax3Curves.Append(nax3Curve);
+        }
 
-            // write to stream
-            stream->Write(&nax3Curve, sizeof(nax3Curve));            
+        Nax3Anim nax3;
+        nax3.numClips = byteOrder.Convert<ushort>(anim.GetNumClips());
+        nax3.numEvents = byteOrder.Convert<ushort>(anim.events.Size());
+        nax3.numCurves = byteOrder.Convert<ushort>(anim.curves.Size());
+        nax3.numKeys = byteOrder.Convert<uint>(keys.Size());
+        nax3.numIntervals = byteOrder.Convert<uint>(intervals.Size());
+        nax3.numPackedKeys = byteOrder.Convert<uint>(packedKeys.Size());
 
-            int stride = curve.curveType == CurveType::Rotation ? 4 : 3;
+        // write header
+        stream->Write(&nax3, sizeof(nax3));
 
-            // Create intervals for the keys
-            for (IndexT i = 0; i < nax3Curve.numIntervals; i++)
+        for (auto& nax3Curve : nax3Curves)
+        {
+            nax3Curve.firstIntervalOffset = byteOrder.Convert<uint>(nax3Curve.firstIntervalOffset);
+            nax3Curve.numIntervals = byteOrder.Convert<uint>(nax3Curve.numIntervals);
+            IndexT i;
+            for (i = 0; i < 4; i++)
             {
-                Timing::Tick start = anim.keyTimes[curve.firstTimeOffset + i];
-                Timing::Tick end = anim.keyTimes[curve.firstTimeOffset + i + 1];
-                Nax3Interval interval;
-
-                interval.start = byteOrder.Convert(start);
-                interval.end = byteOrder.Convert(end);
-                interval.key0 = byteOrder.Convert(curve.firstKeyOffset + i * stride);
-                interval.key1 = byteOrder.Convert(curve.firstKeyOffset + (i + 1) * stride);
-                interval.duration = 1 / float(interval.end - interval.start);
-
-                intervals.Append(interval);
+                nax3Curve.keyOffset[i] = byteOrder.Convert<float>(nax3Curve.keyOffset[i]);
+                nax3Curve.keyScale[i] = byteOrder.Convert<float>(nax3Curve.keyScale[i]);
             }
+
+            // write to stream
+            stream->Write(&nax3Curve, sizeof(nax3Curve));
         }
 
         for (const auto& animEvent : anim.events)
@@ -183,14 +361,26 @@ AnimBuilderSaver::WriteAnimations(const Ptr<IO::Stream>& stream, const Util::Arr
 
         for (const auto& interval : intervals)
         {
-            stream->Write(&interval, sizeof(Nax3Interval));
+            Nax3Interval value;
+            value.start = byteOrder.Convert(interval.start);
+            value.end = byteOrder.Convert(interval.end);
+            value.key0 = byteOrder.Convert(interval.key0);
+            value.key1 = byteOrder.Convert(interval.key1);
+            value.duration = byteOrder.Convert(interval.duration);
+            stream->Write(&value, sizeof(Nax3Interval));
         }
 
-        for (const float key : anim.keys)
+        for (const float key : keys)
         {
             float value = byteOrder.Convert(key);
             stream->Write(&value, sizeof(float));
         }
+
+        for (const ushort key : packedKeys)
+        {
+            ushort value = byteOrder.Convert(key);
+            stream->Write(&value, sizeof(ushort));
+        }
     }
 }
 
@@ -4,6 +4,13 @@
     @class ToolkitUtil::AnimBuilderSaver
     
     Save AnimBuilder object into NAX3 file.
+
+    Curves are compressed on the way out. Curves whose keys all lie within
+    the error bound are stored as a single constant key, the others are
+    quantized to 48 bits per key, see coreanimation/animkeycompression.h,
+    unless that exceeds the error bound, in which case they keep their
+    float keys. Runs of identical keys inside a curve are merged into one
+    interval.
     
     (C) 2009 Radon Labs GmbH
     (C) 2013-2016 Individual contributors, see AUTHORS file
@@ -175,6 +175,11 @@ ModelExporter::ExportFile(const IO::URI& file)
 
     }
 
+    // get occluders, they are written to the model rather than a mesh
+    Util::Array<SceneNode*> occluderNodes;
+    Util::Array<MeshBuilder*> occluderMeshes;
+    scene->OptimizeOccluders(occluderNodes, occluderMeshes);
+
     if (this->scene->animations.Size() > 0)
     {
         timer.Reset();
@@ -218,10 +223,15 @@ ModelExporter::ExportFile(const IO::URI& file)
         , mergedMeshNodes
         , physicsNodes
         , mergedCharacterNodes
+        , occluderNodes
+        , occluderMeshes
         , physicsMeshExportName
         , this->exportFlags
     );
 
+    for (auto mesh : occluderMeshes)
+        delete mesh;
+
     totalTime.Stop();
     this->logger->Unindent();
     this->logger->Print("%s %s\n\n", "Done"_text.Color(TextColor::Green).Style(FontMode::Bold).AsCharPtr(), Format("(%.2f ms)", totalTime.GetTime() * 1000).AsCharPtr());
@@ -57,7 +57,7 @@ Scene::OptimizeGraphics(Util::Array<SceneNode*>& outMeshNodes, Util::Array<Scene
     {
         if (node.type == SceneNode::NodeType::Mesh)
         {
-            if (node.mesh.material != "physics")
+            if (node.mesh.material != "physics" && node.mesh.material != "occluder")
                 nodesByComponents.Emplace(this->meshes[node.mesh.meshIndex].GetComponents()).Append(&node);
         }
         else if (node.type == SceneNode::NodeType::Joint && node.base.parent == nullptr)
@@ -269,6 +269,33 @@ Scene::OptimizePhysics(Util::Array<SceneNode*>& outNodes, MeshBuilder*& outMesh)
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+    Meshes with the 'occluder' material are never drawn, they are written
+    as their triangles for the occlusion culling. Like the graphics meshes
+    the node transform is integrated into the mesh.
+
+    Caller takes ownership of the output meshes and has to delete them
+*/
+void
+Scene::OptimizeOccluders(Util::Array<SceneNode*>& outNodes, Util::Array<MeshBuilder*>& outMeshes)
+{
+    for (SceneNode& node : this->nodes)
+    {
+        if (node.type == SceneNode::NodeType::Mesh && node.mesh.material == "occluder")
+        {
+            MeshBuilder* mesh = new MeshBuilder(this->meshes[node.mesh.meshIndex]);
+            mesh->Transform(node.base.globalTransform);
+            node.base.rotation = Math::quat();
+            node.base.scale = Math::vec3(1);
+            node.base.translation = Math::vec3(0);
+            node.base.boundingBox = mesh->ComputeBoundingBox();
+            outNodes.Append(&node);
+            outMeshes.Append(mesh);
+        }
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -42,6 +42,8 @@ public:
     void OptimizeGraphics(Util::Array<SceneNode*>& outMeshNodes, Util::Array<SceneNode*>& outCharacterNodes, Util::Array<MeshBuilderGroup>& outGroups, Util::Array<MeshBuilder*>& outMeshes);
     /// Merges physics nodes and meshes into a single mesh builder and a set of nodes
     void OptimizePhysics(Util::Array<SceneNode*>& outNodes, MeshBuilder*& outMesh);
+    /// Extracts the occluder nodes, and a mesh for each in model space
+    void OptimizeOccluders(Util::Array<SceneNode*>& outNodes, Util::Array<MeshBuilder*>& outMeshes);
 
     /// Get nodes
     const Util::Array<SceneNode>& GetNodes() const;
@@ -88,6 +88,9 @@ ModelBuilder::SaveN3(const IO::URI& uri, Platform::Code platform)
                 // write particles
                 this->WriteParticles(writer);
 
+                // write occluders
+                this->WriteOccluders(writer);
+
             writer->EndModelNode();
 
         // end name
@@ -471,6 +474,38 @@ ModelBuilder::WriteShapes(const Ptr<ModelWriter>& writer)
     }
 }
 
+//------------------------------------------------------------------------------
+/**
+    Occluders are plain transform nodes with their triangles attached,
+    they are never drawn.
+*/
+void
+ModelBuilder::WriteOccluders(const Ptr<ModelWriter>& writer)
+{
+    const Array<ModelConstants::OccluderNode>& occluders = this->constants->GetOccluderNodes();
+    IndexT i;
+    for (i = 0; i < occluders.Size(); i++)
+    {
+        const ModelConstants::OccluderNode& occluder = occluders[i];
+        writer->BeginModelNode("TransformNode", 'TRFN', occluder.name);
+
+            WriteTransform(writer, occluder.transform);
+
+            writer->BeginTag("Occluder", 'OCCL');
+            writer->WriteInt(occluder.vertices.Size());
+            for (const Math::vec3& vertex : occluder.vertices)
+            {
+                writer->WriteFloat(vertex.x);
+                writer->WriteFloat(vertex.y);
+                writer->WriteFloat(vertex.z);
+            }
+            writer->WriteIntArray(occluder.indices);
+            writer->EndTag();
+
+        writer->EndModelNode();
+    }
+}
+
 //------------------------------------------------------------------------------
 /**
 */
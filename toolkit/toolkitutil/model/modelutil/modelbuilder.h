@@ -55,6 +55,8 @@ private:
 
     /// writes particles
     void WriteParticles(const Ptr<ModelWriter>& writer);
+    /// writes occluders
+    void WriteOccluders(const Ptr<ModelWriter>& writer);
 
     Ptr<ModelConstants> constants;
     Ptr<ModelAttributes> attributes;
@@ -195,6 +195,24 @@ ModelConstants::DeletePhysicsNode(const Util::String& name)
     this->physicsNodes.Erase(name);
 }
 
+//------------------------------------------------------------------------------
+/**
+*/
+void
+ModelConstants::AddOccluderNode(const ModelConstants::OccluderNode& node)
+{
+    this->occluderNodes.Append(node);
+}
+
+//------------------------------------------------------------------------------
+/**
+*/
+const Util::Array<ModelConstants::OccluderNode>&
+ModelConstants::GetOccluderNodes() const
+{
+    return this->occluderNodes;
+}
+
 //------------------------------------------------------------------------------
 /**
 */
@@ -479,6 +497,48 @@ ModelConstants::Save(const Ptr<Stream>& stream)
             }
         }
 
+        if (this->occluderNodes.Size() > 0)
+        {
+            writer->BeginNode("OccluderNodes");
+            for (const auto& occluder : this->occluderNodes)
+            {
+                writer->BeginNode("OccluderNode");
+
+                WriteTransform(writer, &occluder);
+
+                // write vertex positions as content, three floats each
+                writer->BeginNode("Vertices");
+                IndexT l;
+                for (l = 0; l < occluder.vertices.Size(); l++)
+                {
+                    writer->WriteContent(String::Sprintf("%f, %f, %f", occluder.vertices[l].x, occluder.vertices[l].y, occluder.vertices[l].z));
+                    if (l < occluder.vertices.Size() - 1)
+                    {
+                        writer->WriteContent(", ");
+                    }
+                }
+                writer->EndNode();
+
+                // write triangle indices as content
+                writer->BeginNode("Indices");
+                for (l = 0; l < occluder.indices.Size(); l++)
+                {
+                    writer->WriteContent(String::FromInt(occluder.indices[l]));
+                    if (l < occluder.indices.Size() - 1)
+                    {
+                        writer->WriteContent(", ");
+                    }
+                }
+                writer->EndNode();
+
+                // end occluder
+                writer->EndNode();
+            }
+
+            // end occluders
+            writer->EndNode();
+        }
+
         // close model node
         writer->EndNode();
 
@@ -681,6 +741,43 @@ ModelConstants::Load(const Ptr<Stream>& stream)
             reader->SetToParent();
         }
 
+        // go through occluders
+        if (reader->SetToFirstChild("OccluderNodes"))
+        {
+            if (reader->SetToFirstChild("OccluderNode")) do
+            {
+                ModelConstants::OccluderNode node;
+                ReadTransform(reader, &node);
+
+                if (reader->SetToFirstChild("Vertices"))
+                {
+                    Util::Array<String> coords = reader->GetContent().Tokenize(", ");
+                    IndexT l;
+                    for (l = 0; l + 2 < coords.Size(); l += 3)
+                    {
+                        node.vertices.Append(Math::vec3(coords[l].AsFloat(), coords[l + 1].AsFloat(), coords[l + 2].AsFloat()));
+                    }
+                    reader->SetToParent();
+                }
+
+                if (reader->SetToFirstChild("Indices"))
+                {
+                    Util::Array<String> indices = reader->GetContent().Tokenize(", ");
+                    for (const auto& index : indices)
+                    {
+                        node.indices.Append(index.AsInt());
+                    }
+                    reader->SetToParent();
+                }
+
+                this->AddOccluderNode(node);
+            }
+            while (reader->SetToNextChild("OccluderNode"));
+
+            // jump back to parent
+            reader->SetToParent();
+        }
+
         // closes reader and file
         reader->Close();
         stream->Close();
@@ -698,6 +795,7 @@ ModelConstants::Clear()
     this->skinSetNodes.Clear();
     this->physicsNodes.Clear();
     this->particleNodes.Clear();
+    this->occluderNodes.Clear();
 }
 
 } // namespace ToolkitUtil
\ No newline at end of file
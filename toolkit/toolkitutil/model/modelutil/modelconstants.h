@@ -69,6 +69,13 @@ public:
     {
     };
 
+    /// low detail geometry which hides what is behind it, see Visibility::OcclusionSystem
+    struct OccluderNode : public TransformNode
+    {
+        Util::Array<Math::vec3> vertices;
+        Util::Array<IndexT> indices;
+    };
+
 
     /// constructor
     ModelConstants();
@@ -120,6 +127,11 @@ public:
     /// delete physics node
     void DeletePhysicsNode(const Util::String& name);
 
+    /// adds an occluder node
+    void AddOccluderNode(const ModelConstants::OccluderNode& node);
+    /// returns all occluder nodes
+    const Util::Array<ModelConstants::OccluderNode>& GetOccluderNodes() const;
+
     /// set global bounding box for root transform node
     void SetGlobalBoundingBox(const Math::bbox& bbox);
     /// gets the global bounding box for root transform node
@@ -146,6 +158,7 @@ private:
     Util::Dictionary<Util::String, ModelConstants::ParticleNode> particleNodes;
     Util::Dictionary<Util::String, ModelConstants::PhysicsNode> physicsNodes;
     Util::Array<SkinSetNode> skinSetNodes;
+    Util::Array<OccluderNode> occluderNodes;
 
     static const short Version = 4;
 }; 
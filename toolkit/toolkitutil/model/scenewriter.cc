@@ -9,6 +9,7 @@
 #include "model/modelutil/modeldatabase.h"
 #include "model/modelutil/modelconstants.h"
 #include "model/modelutil/modelbuilder.h"
+#include "model/meshutil/meshbuilder.h"
 #include "util/crc.h"
 
 namespace ToolkitUtil
@@ -28,6 +29,8 @@ SceneWriter::GenerateModels(
     , const Util::Array<SceneNode*>& graphicsNodes
     , const Util::Array<SceneNode*>& physicsNodes
     , const Util::Array<SceneNode*>& characterNodes
+    , const Util::Array<SceneNode*>& occluderNodes
+    , const Util::Array<MeshBuilder*>& occluderMeshes
     , const Util::String& physicsMeshResource
     , const ToolkitUtil::ExportFlags& flags
 )
@@ -86,6 +89,8 @@ SceneWriter::GenerateModels(
         , graphicsNodes
         , physicsNodes
         , characterNodes
+        , occluderNodes
+        , occluderMeshes
     );
 
     String constantsFile;
@@ -181,6 +186,8 @@ SceneWriter::CreateModel(
     , const Util::Array<SceneNode*>& graphicsNodes
     , const Util::Array<SceneNode*>& physicsNodes
     , const Util::Array<SceneNode*>& characterNodes
+    , const Util::Array<SceneNode*>& occluderNodes
+    , const Util::Array<MeshBuilder*>& occluderMeshes
 )
 {
     // format animation resource
@@ -308,6 +315,36 @@ SceneWriter::CreateModel(
         // add to constants
         constants->AddPhysicsNode(mesh->base.name, node);
     }
+
+    for (i = 0; i < occluderNodes.Size(); i++)
+    {
+        const SceneNode* occluder = occluderNodes[i];
+        const MeshBuilder* mesh = occluderMeshes[i];
+
+        // create occluder node, only the positions and triangles are kept
+        ModelConstants::OccluderNode node;
+        node.name = occluder->base.name;
+        node.path.Format("root/%s", occluder->base.name.AsCharPtr());
+        node.transform.position = occluder->base.translation;
+        node.transform.rotation = occluder->base.rotation;
+        node.transform.scale = occluder->base.scale;
+        node.boundingBox = occluder->base.boundingBox;
+
+        IndexT j;
+        for (j = 0; j < mesh->GetNumVertices(); j++)
+            node.vertices.Append(Math::xyz(mesh->VertexAt(j).base.position));
+        for (j = 0; j < mesh->GetNumTriangles(); j++)
+        {
+            IndexT i0, i1, i2;
+            mesh->TriangleAt(j).GetVertexIndices(i0, i1, i2);
+            node.indices.Append(i0);
+            node.indices.Append(i1);
+            node.indices.Append(i2);
+        }
+
+        // add to constants
+        constants->AddOccluderNode(node);
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -28,6 +28,8 @@ public:
         , const Util::Array<SceneNode*>& graphicsNodes
         , const Util::Array<SceneNode*>& physicsNodes
         , const Util::Array<SceneNode*>& characterNodes
+        , const Util::Array<SceneNode*>& occluderNodes
+        , const Util::Array<MeshBuilder*>& occluderMeshes
         , const Util::String& physicsMeshResource
         , const ToolkitUtil::ExportFlags& flags
     );
@@ -44,6 +46,8 @@ private:
         , const Util::Array<SceneNode*>& graphicsNodes
         , const Util::Array<SceneNode*>& physicsNodes
         , const Util::Array<SceneNode*>& characterNodes
+        , const Util::Array<SceneNode*>& occluderNodes
+        , const Util::Array<MeshBuilder*>& occluderMeshes
     );
 
     /// convenience function for writing constants-files